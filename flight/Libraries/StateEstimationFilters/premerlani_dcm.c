@@ -89,7 +89,9 @@ enum DRIFT_CORRECTION_ALGOS {
 };
 
 // Private functions
+#if defined (PIOS_INCLUDE_GPS)
 static void rollPitch_drift_GPS(float Rbe[3][3], float accels_e_int[3], float delT, float *errRollPitch_b);
+#endif
 static void gyro_drift(float gyro[3], float errYaw_b[3], float errRollPitch_b[3], float normOmegaScalar, float delT, float *omegaCorrP, float *omegaCorrI);
 static void rollPitch_drift_accel(float accels[3], float gyros[3], float Rbe[3][3], float airspeed_tas, float *errRollPitch_b);
 
@@ -278,6 +280,7 @@ static void gyro_drift(float gyro[3], float errYaw_b[3], float errRollPitch_b[3]
 	}
 }
 
+#if defined (PIOS_INCLUDE_GPS)
 /*
  * From Roll-Pitch Gyro Drift Compensation, Rev 3. William Premerlani, 2012.
  */
@@ -311,6 +314,7 @@ static void rollPitch_drift_GPS(float Rbe[3][3], float accels_e_int[3],
 	//Rotate earth drift error back into body frame;
 	rot_mult(Rbe, errRollPitch_e, errRollPitch_b, false);
 }
+#endif /* PIOS_INCLUDE_GPS */
 
 
 /**
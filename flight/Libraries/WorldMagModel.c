@@ -61,6 +61,40 @@ static WMMtype_Ellipsoid        Ellip;
 static WMMtype_MagneticModel    MagneticModel;
 static float                    decimal_date;
 
+// Main field coefficients advanced to decimal_date by WMM_DateToYear
+static float                    TimedCoeffG[NUMTERMS];
+static float                    TimedCoeffH[NUMTERMS];
+
+// Ratio between the Gauss and Schmidt quasi-normalized Legendre functions
+static float                    SchmidtQuasiNorm[NUMTERMS];
+static bool                     SchmidtQuasiNormValid;
+
+// Thresholds past which WMM_GetMagVectorCached does a full evaluation
+#define WMM_CACHE_DISTANCE_KM   10.0f
+#define WMM_CACHE_ALTITUDE_M    1000.0f
+// Finite difference steps of the linearization
+#define WMM_CACHE_STEP_DEG      0.05f
+#define WMM_CACHE_STEP_M        500.0f
+
+// Last full evaluation and the linearization of the field around it
+static struct {
+	bool  valid;
+	uint16_t Month;
+	uint16_t Day;
+	uint16_t Year;
+	float Lat;
+	float Lon;
+	float Alt;
+	float B[3];
+	float dB_dLat[3];	// per degree
+	float dB_dLon[3];	// per degree
+	float dB_dAlt[3];	// per meter
+} Cache;
+
+static int WMM_EvaluateField(float Lat, float Lon, float AltEllipsoid, float B[3]);
+static void WMM_UpdateTimedCoeffs(void);
+static void WMM_ComputeSchmidtQuasiNorm(void);
+
 /**************************************************************************************
 *   Example use - very simple - only two exposed functions
 *
@@ -70,6 +104,11 @@ static float                    decimal_date;
 *	e.g. Iceland in may of 2012 = WMM_GetMagVector(65.0, -20.0, 0.0, 5, 5, 2012, B);
 *	Alt is above the WGS-84 Ellipsoid
 *	B is the NED (XYZ) magnetic vector in nTesla
+*
+*	WMM_GetMagVectorCached() takes the same arguments but keeps the last full
+*	evaluation with a local linearization of the field. Positions within
+*	WMM_CACHE_DISTANCE_KM and WMM_CACHE_ALTITUDE_M of it on the same date are
+*	answered from that instead of the full spherical harmonic expansion.
 **************************************************************************************/
 
 int WMM_Initialize()
@@ -100,8 +139,6 @@ int WMM_GetMagVector(float Lat, float Lon, float AltEllipsoid, uint16_t Month, u
     // return '0' if all appears to be OK
     // return < 0 if error
 
-    int returned = 0;   // default to OK
-
     // ***********
     // range check supplied params
 
@@ -111,56 +148,136 @@ int WMM_GetMagVector(float Lat, float Lon, float AltEllipsoid, uint16_t Month, u
     if (Lon < -180) return -3;  // error
     if (Lon >  180) return -4;  // error
 
+    // ***********
 
-    WMMtype_CoordSpherical CoordSpherical;
-    WMMtype_CoordGeodetic CoordGeodetic;
-    WMMtype_GeoMagneticElements GeoMagneticElements;
+    if (WMM_Initialize() < 0)
+        return -6;  // error
 
+    if (WMM_DateToYear(Month, Day, Year) < 0)
+        return -8;  // error
 
-    // ***********
+    return WMM_EvaluateField(Lat, Lon, AltEllipsoid, B);
+}
 
-    if (returned >= 0)
+int WMM_GetMagVectorCached(float Lat, float Lon, float AltEllipsoid, uint16_t Month, uint16_t Day, uint16_t Year, float B[3])
+{
+    // Same return codes as WMM_GetMagVector
+
+    if (Lat <  -90) return -1;  // error
+    if (Lat >   90) return -2;  // error
+
+    if (Lon < -180) return -3;  // error
+    if (Lon >  180) return -4;  // error
+
+    // The linearization doesn't use the timed coefficients, so a hit on the
+    // cached date returns before they are advanced
+    if (Cache.valid && Cache.Month == Month && Cache.Day == Day && Cache.Year == Year)
     {
-        if (WMM_Initialize() < 0)
-            returned = -6;  // error
+        float dLat = Lat - Cache.Lat;
+        float dLon = Lon - Cache.Lon;
+        float dAlt = AltEllipsoid - Cache.Alt;
+
+        if (dLon > 180)
+            dLon -= 360;
+        else if (dLon < -180)
+            dLon += 360;
+
+        float north = dLat * DEG2RAD * WGS84_RADIUS_EARTH_KM;
+        float east = dLon * DEG2RAD * WGS84_RADIUS_EARTH_KM * cosf(Cache.Lat * DEG2RAD);
+
+        if (north * north + east * east < WMM_CACHE_DISTANCE_KM * WMM_CACHE_DISTANCE_KM &&
+            fabsf(dAlt) < WMM_CACHE_ALTITUDE_M)
+        {   // Close enough to answer from the linearization
+            for (uint8_t i = 0; i < 3; i++)
+                B[i] = Cache.B[i] + Cache.dB_dLat[i] * dLat + Cache.dB_dLon[i] * dLon + Cache.dB_dAlt[i] * dAlt;
+            return 0;   // OK
+        }
     }
 
-    if (returned >= 0)
-    {
-        CoordGeodetic.lambda = Lon;
-        CoordGeodetic.phi = Lat;
-        CoordGeodetic.HeightAboveEllipsoid = AltEllipsoid/1000.0f; // convert to km
+    if (WMM_Initialize() < 0)
+        return -6;  // error
 
-        // Convert from geodeitic to Spherical Equations: 17-18, WMM Technical report
-        if (WMM_GeodeticToSpherical(&CoordGeodetic, &CoordSpherical) < 0)
-            returned = -7;  // error
-    }
+    if (WMM_DateToYear(Month, Day, Year) < 0)
+        return -8;  // error
 
+    // Full evaluation, plus the partial derivatives around this point. The
+    // steps are taken towards the equator and down so they stay in range.
+    float B_lat[3], B_lon[3], B_alt[3];
+    const float lat_step = (Lat > 0) ? -WMM_CACHE_STEP_DEG : WMM_CACHE_STEP_DEG;
+    const float lon_step = (Lon > 0) ? -WMM_CACHE_STEP_DEG : WMM_CACHE_STEP_DEG;
+    const float alt_step = -WMM_CACHE_STEP_M;
 
-    if (returned >= 0)
-    {
-        if (WMM_DateToYear(Month, Day, Year) < 0)
-            returned = -8;  // error
-    }
+    Cache.valid = false;
 
+    int returned = WMM_EvaluateField(Lat, Lon, AltEllipsoid, Cache.B);
+    if (returned >= 0)
+        returned = WMM_EvaluateField(Lat + lat_step, Lon, AltEllipsoid, B_lat);
+    if (returned >= 0)
+        returned = WMM_EvaluateField(Lat, Lon + lon_step, AltEllipsoid, B_lon);
     if (returned >= 0)
+        returned = WMM_EvaluateField(Lat, Lon, AltEllipsoid + alt_step, B_alt);
+    if (returned < 0)
+        return returned;
+
+    for (uint8_t i = 0; i < 3; i++)
     {
-        // Compute the geoMagnetic field elements and their time change
-        if (WMM_Geomag(&CoordSpherical, &CoordGeodetic, &GeoMagneticElements) < 0)
-            returned = -9;  // error
-        else
-        {   // set the returned values
-            B[0] = GeoMagneticElements.X;
-            B[1] = GeoMagneticElements.Y;
-            B[2] = GeoMagneticElements.Z;
-        }
+        Cache.dB_dLat[i] = (B_lat[i] - Cache.B[i]) / lat_step;
+        Cache.dB_dLon[i] = (B_lon[i] - Cache.B[i]) / lon_step;
+        Cache.dB_dAlt[i] = (B_alt[i] - Cache.B[i]) / alt_step;
+        B[i] = Cache.B[i];
     }
 
-	B[0] = GeoMagneticElements.X * 1e-2f;
-	B[1] = GeoMagneticElements.Y * 1e-2f;
-	B[2] = GeoMagneticElements.Z * 1e-2f;
+    Cache.Lat = Lat;
+    Cache.Lon = Lon;
+    Cache.Alt = AltEllipsoid;
+    Cache.Month = Month;
+    Cache.Day = Day;
+    Cache.Year = Year;
+    Cache.valid = true;
 
-    return returned;
+    return 0;   // OK
+}
+
+static int WMM_EvaluateField(float Lat, float Lon, float AltEllipsoid, float B[3])
+   /*
+      Computes the field at a point for the current date. This is the part of WMM_Geomag
+      that WMM_GetMagVector needs, the secular variation is not summed as it is not returned.
+
+      OUTPUT : B  NED magnetic vector (same units as WMM_GetMagVector)
+    */
+{
+    WMMtype_CoordSpherical              CoordSpherical;
+    WMMtype_CoordGeodetic               CoordGeodetic;
+    WMMtype_MagneticResults             MagneticResultsSph;
+    WMMtype_MagneticResults             MagneticResultsGeo;
+    WMMtype_LegendreFunction            LegendreFunction;
+    WMMtype_SphericalHarmonicVariables  SphVariables;
+
+    CoordGeodetic.lambda = Lon;
+    CoordGeodetic.phi = Lat;
+    CoordGeodetic.HeightAboveEllipsoid = AltEllipsoid/1000.0f; // convert to km
+
+    // Convert from geodeitic to Spherical Equations: 17-18, WMM Technical report
+    if (WMM_GeodeticToSpherical(&CoordGeodetic, &CoordSpherical) < 0)
+        return -7;  // error
+
+    if (WMM_ComputeSphericalHarmonicVariables(&CoordSpherical, MagneticModel.nMax, &SphVariables) < 0)
+        return -9;  // error
+
+    if (WMM_AssociatedLegendreFunction(&CoordSpherical, MagneticModel.nMax, &LegendreFunction) < 0)
+        return -9;  // error
+
+    if (WMM_Summation(&LegendreFunction, &SphVariables, &CoordSpherical, &MagneticResultsSph) < 0)
+        return -9;  // error
+
+    if (WMM_RotateMagneticVector(&CoordSpherical, &CoordGeodetic, &MagneticResultsSph, &MagneticResultsGeo) < 0)
+        return -9;  // error
+
+    B[0] = MagneticResultsGeo.Bx * 1e-2f;
+    B[1] = MagneticResultsGeo.By * 1e-2f;
+    B[2] = MagneticResultsGeo.Bz * 1e-2f;
+
+    return 0;   // OK
 }
 
 int WMM_Geomag(WMMtype_CoordSpherical * CoordSpherical, WMMtype_CoordGeodetic * CoordGeodetic, WMMtype_GeoMagneticElements * GeoMagneticElements)
@@ -763,6 +880,33 @@ int WMM_PcupHigh(float *Pcup, float *dPcup, float x, uint16_t nMax)
 	return 0;   // OK
 }
 
+static void WMM_ComputeSchmidtQuasiNorm(void)
+{
+	uint16_t n, m, index, index1;
+
+/*Compute the ration between the Gauss-normalized associated Legendre
+  functions and the Schmidt quasi-normalized version. This is equivalent to
+  sqrt((m==0?1:2)*(n-m)!/(n+m!))*(2n-1)!!/(n-m)!  */
+	SchmidtQuasiNorm[0] = 1.0;
+	for (n = 1; n <= WMM_MAX_MODEL_DEGREES; n++)
+	{
+		index = (n * (n + 1) / 2);
+		index1 = (n - 1) * n / 2;
+		/* for m = 0 */
+		SchmidtQuasiNorm[index] = SchmidtQuasiNorm[index1] * (float)(2 * n - 1) / (float)n;
+
+		for (m = 1; m <= n; m++)
+		{
+			index = (n * (n + 1) / 2 + m);
+			index1 = (n * (n + 1) / 2 + m - 1);
+			SchmidtQuasiNorm[index] = SchmidtQuasiNorm[index1] * sqrtf((float)((n - m + 1) * (m == 1 ? 2 : 1)) / (float)(n + m));
+		}
+
+	}
+
+	SchmidtQuasiNormValid = true;
+}
+
 int WMM_PcupLow(float *Pcup, float *dPcup, float x, uint16_t nMax)
 
 /*   This function evaluates all of the Schmidt-semi normalized associated Legendre
@@ -791,13 +935,12 @@ int WMM_PcupLow(float *Pcup, float *dPcup, float x, uint16_t nMax)
 {
     uint16_t    n, m, index, index1, index2;
     float       k, z;
-    float schmidtQuasiNorm_s[NUMPCUP];
-    float       *schmidtQuasiNorm = schmidtQuasiNorm_s;
 
-    if (!schmidtQuasiNorm)
-    {
-        return -1;
-    }
+	if (nMax > WMM_MAX_MODEL_DEGREES)
+		return -1;  // error
+
+	if (!SchmidtQuasiNormValid)
+		WMM_ComputeSchmidtQuasiNorm();
 
 	Pcup[0] = 1.0;
 	dPcup[0] = 0.0;
@@ -844,38 +987,18 @@ int WMM_PcupLow(float *Pcup, float *dPcup, float x, uint16_t nMax)
 			}
 		}
 	}
-/*Compute the ration between the Gauss-normalized associated Legendre
-  functions and the Schmidt quasi-normalized version. This is equivalent to
-  sqrt((m==0?1:2)*(n-m)!/(n+m!))*(2n-1)!!/(n-m)!  */
-
-	schmidtQuasiNorm[0] = 1.0;
-	for (n = 1; n <= nMax; n++)
-	{
-		index = (n * (n + 1) / 2);
-		index1 = (n - 1) * n / 2;
-		/* for m = 0 */
-		schmidtQuasiNorm[index] = schmidtQuasiNorm[index1] * (float)(2 * n - 1) / (float)n;
-
-		for (m = 1; m <= n; m++)
-		{
-			index = (n * (n + 1) / 2 + m);
-			index1 = (n * (n + 1) / 2 + m - 1);
-			schmidtQuasiNorm[index] = schmidtQuasiNorm[index1] * sqrtf((float)((n - m + 1) * (m == 1 ? 2 : 1)) / (float)(n + m));
-		}
-
-	}
 
 /* Converts the  Gauss-normalized associated Legendre
 	  functions to the Schmidt quasi-normalized version using pre-computed
-	  relation stored in the variable schmidtQuasiNorm */
+	  relation stored in SchmidtQuasiNorm */
 
 	for (n = 1; n <= nMax; n++)
 	{
 		for (m = 0; m <= n; m++)
 		{
 			index = (n * (n + 1) / 2 + m);
-			Pcup[index] = Pcup[index] * schmidtQuasiNorm[index];
-			dPcup[index] = -dPcup[index] * schmidtQuasiNorm[index];
+			Pcup[index] = Pcup[index] * SchmidtQuasiNorm[index];
+			dPcup[index] = -dPcup[index] * SchmidtQuasiNorm[index];
 			/* The sign is changed since the new WMM routines use derivative with respect to latitude
 			   insted of co-latitude */
 		}
@@ -1011,66 +1134,46 @@ int WMM_SecVarSummationSpecial(WMMtype_SphericalHarmonicVariables *
 }
 
 /**
- * @brief Comput the MainFieldCoeffH accounting for the date
+ * @brief Advance the main field coefficients to decimal_date using the
+ * secular variation model
+ */
+static void WMM_UpdateTimedCoeffs(void)
+{
+	uint16_t a = MagneticModel.nMaxSecVar;
+	uint16_t last_sec_var = (a * (a + 1) / 2 + a);
+	uint16_t last_term = (MagneticModel.nMax * (MagneticModel.nMax + 1) / 2 + MagneticModel.nMax);
+	float dt = decimal_date - MagneticModel.epoch;
+
+	for (uint16_t index = 0; index < NUMTERMS; index++) {
+		TimedCoeffG[index] = CoeffFile[index][2];
+		TimedCoeffH[index] = CoeffFile[index][3];
+		if (index >= 1 && index <= last_term && index <= last_sec_var) {
+			TimedCoeffG[index] += dt * CoeffFile[index][4];
+			TimedCoeffH[index] += dt * CoeffFile[index][5];
+		}
+	}
+}
+
+/**
+ * @brief Get the MainFieldCoeffG accounting for the date
  */
 float WMM_get_main_field_coeff_g(uint16_t index) 
 {	
 	if (index >= NUMTERMS)
 		return 0;
 
-    uint16_t n, m, sum_index, a, b;
-
-    float coeff = CoeffFile[index][2];
-	
-	a = MagneticModel.nMaxSecVar;
-	b = (a * (a + 1) / 2 + a);
-	for (n = 1; n <= MagneticModel.nMax; n++)
-	{
-		for (m = 0; m <= n; m++)
-		{
-			
-			sum_index = (n * (n + 1) / 2 + m);
-			
-			/* Hacky for now, will solve for which conditions need summing analytically */
-			if (sum_index != index)
-				continue;
-			
-			if (index <= b) 
-				coeff += (decimal_date - MagneticModel.epoch) * WMM_get_secular_var_coeff_g(sum_index);
-			
-		}
-	}
-	
-	return coeff;
+	return TimedCoeffG[index];
 }
 
+/**
+ * @brief Get the MainFieldCoeffH accounting for the date
+ */
 float WMM_get_main_field_coeff_h(uint16_t index) 
 {	
 	if (index >= NUMTERMS)
 		return 0;
-	
-    uint16_t n, m, sum_index, a, b;
-	float coeff = CoeffFile[index][3];
-	
-	a = MagneticModel.nMaxSecVar;
-	b = (a * (a + 1) / 2 + a);
-	for (n = 1; n <= MagneticModel.nMax; n++)
-	{
-		for (m = 0; m <= n; m++)
-		{
-			
-			sum_index = (n * (n + 1) / 2 + m);
-			
-			/* Hacky for now, will solve for which conditions need summing analytically */
-			if (sum_index != index)
-				continue;
-			
-			if (index <= b) 
-				coeff += (decimal_date - MagneticModel.epoch) * WMM_get_secular_var_coeff_h(sum_index);
-		}
-	}
-	
-	return coeff;	
+
+	return TimedCoeffH[index];
 }
 
 float WMM_get_secular_var_coeff_g(uint16_t index) 
@@ -1116,6 +1219,8 @@ int WMM_DateToYear(uint16_t month, uint16_t day, uint16_t year)
 	
 	decimal_date = year + (temp - 1) / (365.0 + ExtraDay);
 
+	WMM_UpdateTimedCoeffs();
+
 	return 0;   // OK
 }
 
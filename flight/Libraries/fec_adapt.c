@@ -0,0 +1,277 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       fec_adapt.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @brief      Link adaptation of the error correction and packet size
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <string.h>
+#include "fec_adapt.h"
+
+// Private constants
+
+/*
+ * On a clean link little parity and long packets waste the least airtime.
+ * As errors pick up more parity is added, and on a bad link the packets
+ * are also shortened, so that a burst costs less data and fewer packets
+ * have more errors than can be corrected.
+ */
+static const struct {
+	uint8_t code;		//!< level byte sent in the packet
+	uint8_t nparity;	//!< parity bytes, corrects half as many
+	uint8_t len_percent;	//!< share of the longest packet used
+} levels[FEC_ADAPT_NUM_LEVELS] = {
+	{ 0x07, 2, 100 },
+	{ 0x39, 4, 100 },
+	{ 0xca, 8, 100 },
+	{ 0xf4, 12, 75 },
+};
+
+//! Time constants of the error filters in packets, as a power of two
+#define CORRECTED_FILTER_SHIFT 3
+#define FAILED_FILTER_SHIFT    5
+
+//! Packets to wait after a change before the level is lowered again
+#define LOWER_AFTER_PACKETS 32
+
+//! Packets to wait after a change before the level is raised again
+#define RAISE_AFTER_PACKETS 4
+
+//! Share of the correction capacity in use that raises the level, in 1/256
+#define RAISE_LOAD 128
+
+//! Share of the next lower level's capacity that must not be exceeded to lower it
+#define LOWER_LOAD 64
+
+//! Share of packets lost that raises the level, in 1/256
+#define RAISE_FAILED 16
+
+//! Share of packets lost that must not be exceeded to lower the level, in 1/256
+#define LOWER_FAILED 2
+
+//! Packets are not shortened below this many bytes
+#define MIN_SHORT_PACKET_LEN 24
+
+//! Payload a level leaves at least, or it isn't used
+#define MIN_PAYLOAD_LEN 8
+
+//! Link quality (0 to 128) below which the level is kept at least at 2 and 3
+#define MARGINAL_LINK_QUALITY 64
+#define BAD_LINK_QUALITY      32
+
+// Private functions
+
+static inline uint8_t popcount8(uint8_t x)
+{
+	x = x - ((x >> 1) & 0x55);
+	x = (x & 0x33) + ((x >> 2) & 0x33);
+	return (x + (x >> 4)) & 0x0f;
+}
+
+/**
+ * Find the level of a received level byte
+ * @return the level or -1 if more than two bits are wrong
+ */
+static int8_t level_from_code(uint8_t code)
+{
+	for (uint8_t i = 0; i < FEC_ADAPT_NUM_LEVELS; i++) {
+		if (popcount8(code ^ levels[i].code) <= 2)
+			return i;
+	}
+	return -1;
+}
+
+//! Bytes the current level can correct in a packet, in 1/256
+static inline uint16_t capacity(uint8_t level)
+{
+	return (levels[level].nparity / 2) << 8;
+}
+
+static void set_level(struct fec_adapt *fa, uint8_t level)
+{
+	if (level < fa->min_level)
+		level = fa->min_level;
+	if (level > fa->max_level)
+		level = fa->max_level;
+
+	if (level != fa->level) {
+		fa->level = level;
+		fa->steady = 0;
+	}
+}
+
+//! Payload of a packet at a level
+static uint8_t max_payload(uint8_t max_packet_len, uint8_t level)
+{
+	uint16_t len = (uint16_t) max_packet_len * levels[level].len_percent / 100;
+	if (len < MIN_SHORT_PACKET_LEN)
+		len = max_packet_len < MIN_SHORT_PACKET_LEN ? max_packet_len : MIN_SHORT_PACKET_LEN;
+
+	uint8_t overhead = FEC_ADAPT_HEADER_LEN + levels[level].nparity;
+	return len > overhead ? len - overhead : 0;
+}
+
+/**
+ * Account for a received packet and move the level if needed
+ * @param[in] corrected bytes corrected, or -1 if it was lost
+ */
+static void update_level(struct fec_adapt *fa, int corrected)
+{
+	int32_t corrected_sample = corrected > 0 ? corrected << 8 : 0;
+	int32_t failed_sample = corrected < 0 ? 256 : 0;
+
+	fa->corrected += (corrected_sample - fa->corrected) >> CORRECTED_FILTER_SHIFT;
+	fa->failed += (failed_sample - fa->failed) >> FAILED_FILTER_SHIFT;
+
+	if (fa->steady < UINT8_MAX)
+		fa->steady++;
+
+	uint8_t level = fa->level;
+
+	if (fa->steady >= RAISE_AFTER_PACKETS &&
+	    (fa->failed > RAISE_FAILED ||
+	     fa->corrected > ((uint32_t) capacity(level) * RAISE_LOAD >> 8))) {
+		set_level(fa, level + 1);
+	} else if (level > 0 && fa->steady >= LOWER_AFTER_PACKETS && fa->failed <= LOWER_FAILED &&
+		   fa->corrected < ((uint32_t) capacity(level - 1) * LOWER_LOAD >> 8)) {
+		set_level(fa, level - 1);
+	}
+}
+
+/**
+ * Initialize the link adaptation
+ * @param[out] fa the link adaptation state
+ * @param[in] max_packet_len the longest packet the link can send
+ * @return true if the packets are long enough to carry any payload
+ */
+bool fec_adapt_init(struct fec_adapt *fa, uint8_t max_packet_len)
+{
+	memset(fa, 0, sizeof(*fa));
+
+	for (uint8_t i = 0; i < FEC_ADAPT_NUM_LEVELS; i++) {
+		if (!rs_init(&fa->codec[i], levels[i].nparity))
+			return false;
+	}
+
+	fa->max_packet_len = max_packet_len;
+
+	// Short packets can't carry all the parity
+	while (fa->max_level < FEC_ADAPT_NUM_LEVELS - 1 &&
+	       max_payload(max_packet_len, fa->max_level + 1) >= MIN_PAYLOAD_LEN)
+		fa->max_level++;
+
+	fa->level = FEC_ADAPT_DEFAULT_LEVEL;
+	set_level(fa, fa->level);
+
+	return max_payload(max_packet_len, 0) > 0;
+}
+
+/**
+ * Get the most payload the next packet may carry
+ */
+uint8_t fec_adapt_max_payload(const struct fec_adapt *fa)
+{
+	return max_payload(fa->max_packet_len, fa->level);
+}
+
+/**
+ * Get the parity bytes of the next packet
+ */
+uint8_t fec_adapt_parity(const struct fec_adapt *fa)
+{
+	return levels[fa->level].nparity;
+}
+
+/**
+ * Add the level byte and parity to a packet
+ * @param[in] fa the link adaptation state
+ * @param[in,out] packet the payload is at FEC_ADAPT_HEADER_LEN, with room for the parity after it
+ * @param[in] payload_len the payload length, at most fec_adapt_max_payload
+ * @return the length of the packet
+ */
+uint8_t fec_adapt_encode(const struct fec_adapt *fa, uint8_t *packet, uint8_t payload_len)
+{
+	uint8_t len = FEC_ADAPT_HEADER_LEN + payload_len;
+
+	packet[0] = levels[fa->level].code;
+	rs_encode(&fa->codec[fa->level], packet, len, packet + len);
+
+	return len + levels[fa->level].nparity;
+}
+
+/**
+ * Correct a received packet and account for it
+ * @param[in,out] fa the link adaptation state
+ * @param[in,out] packet the packet, corrected in place
+ * @param[in] len the length received
+ * @param[out] payload_len the payload length, the payload is at FEC_ADAPT_HEADER_LEN
+ * @return the number of bytes corrected, or -1 if the packet is lost
+ */
+int fec_adapt_decode(struct fec_adapt *fa, uint8_t *packet, uint8_t len, uint8_t *payload_len)
+{
+	int8_t level = level_from_code(packet[0]);
+	int corrected = -1;
+
+	if (level >= 0 && len >= FEC_ADAPT_HEADER_LEN + levels[level].nparity) {
+		corrected = rs_decode(&fa->codec[level], packet, len);
+
+		// The level byte must be right once the whole packet is
+		if (corrected >= 0 && packet[0] != levels[level].code)
+			corrected = -1;
+	}
+
+	update_level(fa, corrected);
+
+	if (corrected < 0)
+		return -1;
+
+	*payload_len = len - FEC_ADAPT_HEADER_LEN - levels[level].nparity;
+	return corrected;
+}
+
+/**
+ * Account for a packet that was expected but not received
+ */
+void fec_adapt_lost(struct fec_adapt *fa)
+{
+	update_level(fa, -1);
+}
+
+/**
+ * Keep more protection while the link quality is low
+ * @param[in] link_quality from 0 (all packets lost) to 128 (all good)
+ */
+void fec_adapt_link_quality(struct fec_adapt *fa, uint8_t link_quality)
+{
+	if (link_quality < BAD_LINK_QUALITY)
+		fa->min_level = 3;
+	else if (link_quality < MARGINAL_LINK_QUALITY)
+		fa->min_level = 2;
+	else
+		fa->min_level = 0;
+
+	set_level(fa, fa->level);
+}
+
+/**
+ * @}
+ */
@@ -191,7 +191,7 @@ bool frsky_encode_t1(struct frsky_settings *frsky, uint32_t *value, bool test_pr
 		HomeLocationSetGet(&hl_set);
 
 	int32_t t1 = 0;
-	switch (frsky->gps_position.Status) {
+	switch (frsky->gps_position->Status) {
 	case GPSPOSITION_STATUS_NOGPS:
 		t1 = 100;
 		break;
@@ -209,8 +209,8 @@ bool frsky_encode_t1(struct frsky_settings *frsky, uint32_t *value, bool test_pr
 			t1 = 400;
 		break;
 	}
-	if (frsky->gps_position.Satellites > 0)
-		t1 += frsky->gps_position.Satellites;
+	if (frsky->gps_position->Satellites > 0)
+		t1 += frsky->gps_position->Satellites;
 
 	*value = (uint32_t)t1;
 
@@ -234,12 +234,12 @@ bool frsky_encode_t2(struct frsky_settings *frsky, uint32_t *value, bool test_pr
 	if (test_presence_only)
 		return true;
 
-	uint32_t hdop = (uint32_t)(frsky->gps_position.HDOP * 100.0f);
+	uint32_t hdop = (uint32_t)(frsky->gps_position->HDOP * 100.0f);
 
 	if (hdop > 255)
 		hdop = 255;
 			
-	uint32_t vdop = (uint32_t)(frsky->gps_position.VDOP * 100.0f);
+	uint32_t vdop = (uint32_t)(frsky->gps_position->VDOP * 100.0f);
 			
 	if (vdop > 255)
 		vdop = 255;
@@ -396,8 +396,8 @@ bool frsky_encode_gps_coord(struct frsky_settings *frsky, uint32_t *value, bool
 {
 	if (GPSPositionHandle() == NULL)
 		return false;
-	if (frsky->gps_position.Status == GPSPOSITION_STATUS_NOFIX
-			|| frsky->gps_position.Status == GPSPOSITION_STATUS_NOGPS)
+	if (frsky->gps_position->Status == GPSPOSITION_STATUS_NOFIX
+			|| frsky->gps_position->Status == GPSPOSITION_STATUS_NOGPS)
 		return false;
 	if (test_presence_only)
 		return true;
@@ -406,14 +406,14 @@ bool frsky_encode_gps_coord(struct frsky_settings *frsky, uint32_t *value, bool
 	int32_t coord = 0;
 	if (arg == 0) {
 		// lattitude
-		coord = frsky->gps_position.Latitude;
+		coord = frsky->gps_position->Latitude;
 		if (coord >= 0)
 			frsky_coord = 0;
 		else
 			frsky_coord = 1 << 30;
 	} else {
 		// longitude
-		coord = frsky->gps_position.Longitude;
+		coord = frsky->gps_position->Longitude;
 		if (coord >= 0)
 			frsky_coord = 2 << 30;
 		else
@@ -437,13 +437,13 @@ bool frsky_encode_gps_alt(struct frsky_settings *frsky, uint32_t *value, bool te
 {
 	if (GPSPositionHandle() == NULL)
 		return false;
-	if (frsky->gps_position.Status != GPSPOSITION_STATUS_FIX3D
-			&& frsky->gps_position.Status != GPSPOSITION_STATUS_DIFF3D)
+	if (frsky->gps_position->Status != GPSPOSITION_STATUS_FIX3D
+			&& frsky->gps_position->Status != GPSPOSITION_STATUS_DIFF3D)
 		return false;
 	if (test_presence_only)
 		return true;
 
-	int32_t frsky_gps_alt = (int32_t)(frsky->gps_position.Altitude * 100.0f);
+	int32_t frsky_gps_alt = (int32_t)(frsky->gps_position->Altitude * 100.0f);
 	*value = (uint32_t)frsky_gps_alt;
 
 	return true;
@@ -460,13 +460,13 @@ bool frsky_encode_gps_speed(struct frsky_settings *frsky, uint32_t *value, bool
 {
 	if (GPSPositionHandle() == NULL)
 		return false;
-	if (frsky->gps_position.Status != GPSPOSITION_STATUS_FIX3D
-			&& frsky->gps_position.Status != GPSPOSITION_STATUS_DIFF3D)
+	if (frsky->gps_position->Status != GPSPOSITION_STATUS_FIX3D
+			&& frsky->gps_position->Status != GPSPOSITION_STATUS_DIFF3D)
 		return false;
 	if (test_presence_only)
 		return true;
 
-	int32_t frsky_speed = (int32_t)((frsky->gps_position.Groundspeed / KNOTS2M_PER_SECOND) * 1000);
+	int32_t frsky_speed = (int32_t)((frsky->gps_position->Groundspeed / KNOTS2M_PER_SECOND) * 1000);
 	*value = frsky_speed;
 	return true;
 }
@@ -482,8 +482,8 @@ bool frsky_encode_gps_time(struct frsky_settings *frsky, uint32_t *value, bool t
 {
 	if (GPSPositionHandle() == NULL || GPSTimeHandle() == NULL)
 		return false;
-	if (frsky->gps_position.Status != GPSPOSITION_STATUS_FIX3D
-			&& frsky->gps_position.Status != GPSPOSITION_STATUS_DIFF3D)
+	if (frsky->gps_position->Status != GPSPOSITION_STATUS_FIX3D
+			&& frsky->gps_position->Status != GPSPOSITION_STATUS_DIFF3D)
 		return false;
 	if (test_presence_only)
 		return true;
@@ -587,10 +587,12 @@ uint8_t frsky_insert_byte(uint8_t *obuff, uint16_t *chk, uint8_t byte)
 
 /**
  * Send u32 value dataframe to FrSky SmartPort bus
+ * @param[in] bridge the bridge of the port
  * @param[in] id FrSky value ID
  * @param[in] value value
+ * @returns the number of bytes sent, 0 if the frame was dropped
  */
-int32_t frsky_send_frame(uintptr_t com, enum frsky_value_id id, uint32_t value)
+int32_t frsky_send_frame(struct telemetry_bridge *bridge, enum frsky_value_id id, uint32_t value)
 {
 	/* each call of frsky_insert_byte can add 2 bytes to the buffer at maximum
 	 * and therefore the worst-case is 15 bytes total (the first byte 0x10 won't be
@@ -607,7 +609,8 @@ int32_t frsky_send_frame(uintptr_t com, enum frsky_value_id id, uint32_t value)
 	cnt += frsky_insert_byte(&tx_data[cnt], &chk, (value >> 24) & 0xff);
 	cnt += frsky_insert_byte(&tx_data[cnt], &chk, 0xff - chk);
 
-	PIOS_COM_SendBuffer(com, tx_data, cnt);
+	if (!TelemetryBridgeSend(bridge, tx_data, cnt))
+		return 0;
 
 	return cnt;
 }
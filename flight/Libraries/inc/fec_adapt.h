@@ -0,0 +1,74 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       fec_adapt.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @brief      Link adaptation of the error correction and packet size
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef FEC_ADAPT_H
+#define FEC_ADAPT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ecc.h"
+
+//! Number of protection levels, from the least to the most parity
+#define FEC_ADAPT_NUM_LEVELS 4
+
+//! Level used until the link has been measured
+#define FEC_ADAPT_DEFAULT_LEVEL 1
+
+//! Bytes in front of the payload that tell the receiver the level
+#define FEC_ADAPT_HEADER_LEN 1
+
+/*
+ * A packet is the level byte, the payload and the Reed Solomon parity
+ * over both. The level byte is one of a set of codes at least five bits
+ * apart from each other, so the receiver knows how much parity to
+ * expect even when up to two of its bits are flipped.
+ *
+ * The sender picks the level from what it sees of the packets coming
+ * the other way, as both directions share the channel.
+ */
+struct fec_adapt {
+	struct rs_codec codec[FEC_ADAPT_NUM_LEVELS];
+	uint8_t max_packet_len;
+	uint8_t level;		//!< level of the next packet sent
+	uint8_t min_level;	//!< floor set from the link quality
+	uint8_t max_level;	//!< highest level that fits in a packet
+	uint8_t steady;		//!< packets received since the last level change
+	uint16_t corrected;	//!< filtered bytes corrected per packet, 1/256 units
+	uint16_t failed;	//!< filtered share of packets lost, 1/256 units
+};
+
+bool fec_adapt_init(struct fec_adapt *fa, uint8_t max_packet_len);
+uint8_t fec_adapt_max_payload(const struct fec_adapt *fa);
+uint8_t fec_adapt_parity(const struct fec_adapt *fa);
+uint8_t fec_adapt_encode(const struct fec_adapt *fa, uint8_t *packet, uint8_t payload_len);
+int fec_adapt_decode(struct fec_adapt *fa, uint8_t *packet, uint8_t len, uint8_t *payload_len);
+void fec_adapt_lost(struct fec_adapt *fa);
+void fec_adapt_link_quality(struct fec_adapt *fa, uint8_t link_quality);
+
+#endif /* FEC_ADAPT_H */
+
+/**
+ * @}
+ */
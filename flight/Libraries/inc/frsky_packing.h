@@ -34,6 +34,7 @@
 
 #include "pios.h"
 #include "openpilot.h"
+#include "telemetry_bridge.h"
 
 #include "flightbatterysettings.h"
 #include "gpsposition.h"
@@ -43,7 +44,7 @@ struct frsky_settings {
 	uint8_t batt_cell_count;
 	bool use_baro_sensor;
 	FlightBatterySettingsData battery_settings;
-	GPSPositionData gps_position;
+	const GPSPositionData *gps_position;
 };
 
 enum frsky_value_id {
@@ -97,7 +98,7 @@ bool frsky_encode_gps_time(struct frsky_settings *frsky, uint32_t *value, bool t
 bool frsky_encode_rpm(struct frsky_settings *frsky, uint32_t *value, bool test_presence_only, uint32_t arg);
 bool frsky_encode_airspeed(struct frsky_settings *frsky, uint32_t *value, bool test_presence_only, uint32_t arg);
 uint8_t frsky_insert_byte(uint8_t *obuff, uint16_t *chk, uint8_t byte);
-int32_t frsky_send_frame(uintptr_t com, enum frsky_value_id id, uint32_t value);
+int32_t frsky_send_frame(struct telemetry_bridge *bridge, enum frsky_value_id id, uint32_t value);
 
 #endif /* FRSKY_PACKING_H */
 
@@ -41,8 +41,35 @@ struct path_status {
 	float path_direction[2];
 };
 
+/**
+ * The geometry of a path, computed once from @ref PathDesired so that
+ * following it only takes the square root of the distance to the path.
+ */
+struct path_segment {
+	// The PathDesired fields it was compiled from
+	uint8_t mode;
+	float start[2];
+	float end[2];
+	float mode_parameter;
+
+	uint8_t shape;			//!< how the segment is evaluated
+	bool clockwise;
+	float direction[2];		//!< unit vector from start to end
+	float normal[2];		//!< direction rotated counter clockwise
+	float length;
+	float inv_length;		//!< 1 / length, 0 for a degenerate path
+	float inv_1plus_length;		//!< 1 / (1 + length), for endpoint progress
+	float center[2];		//!< center of an arc or orbit
+	float radius;
+	float curvature;		//!< signed 1 / radius, 0 for straight paths
+};
+
 void path_progress(const PathDesiredData *pathDesired, const float * cur_point, struct path_status * status);
 
+void path_compile(const PathDesiredData *pathDesired, struct path_segment *segment);
+bool path_segment_update(struct path_segment *segment, const PathDesiredData *pathDesired);
+void path_segment_progress(const struct path_segment *segment, const float *cur_point, struct path_status *status);
+
 #endif /* PATHS_H_ */
 
 /**
@@ -0,0 +1,65 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       profiler.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @brief      Timing probes around the hot paths of the control loop
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+//! The code paths that are timed, in the order of the ProfilerProbes fields
+enum profiler_probe {
+	PROFILER_PROBE_SENSORS,
+	PROFILER_PROBE_ATTITUDE,
+	PROFILER_PROBE_STABILIZATION,
+	PROFILER_PROBE_ACTUATOR,
+	PROFILER_PROBE_NUM
+};
+
+#if defined(DIAG_PROFILER)
+
+int32_t ProfilerInitialize(void);
+void ProfilerBegin(enum profiler_probe probe);
+void ProfilerEnd(enum profiler_probe probe);
+void ProfilerUpdateAll(void);
+
+/*
+ * A probe is started and stopped by the task that owns it. An end without
+ * a begin, e.g. when the loop bailed out on a timeout, is not counted.
+ */
+#define PROFILE_BEGIN(probe) ProfilerBegin(probe)
+#define PROFILE_END(probe)   ProfilerEnd(probe)
+
+#else
+
+#define PROFILE_BEGIN(probe) do { } while (0)
+#define PROFILE_END(probe)   do { } while (0)
+
+#endif /* defined(DIAG_PROFILER) */
+
+#endif // PROFILER_H
+
+/**
+ * @}
+ */
@@ -28,6 +28,9 @@
 #define TASKMONITOR_H
 
 #include "taskinfo.h"
+#if defined(DIAG_PROFILER)
+#include "taskprofile.h"
+#endif
 #include "pios_thread.h"
 
 int32_t TaskMonitorInitialize(void);
@@ -35,6 +38,7 @@ int32_t TaskMonitorAdd(TaskInfoRunningElem task, struct pios_thread *handlep);
 int32_t TaskMonitorRemove(TaskInfoRunningElem task);
 bool TaskMonitorQueryRunning(TaskInfoRunningElem task);
 void TaskMonitorUpdateAll(void);
+void TaskMonitorUpdateProfile(void);
 
 #endif // TASKMONITOR_H
 
@@ -0,0 +1,78 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       telemetry_bridge.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @brief      Shared runtime of the telemetry bridges to receivers and OSDs
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef TELEMETRY_BRIDGE_H
+#define TELEMETRY_BRIDGE_H
+
+#include "openpilot.h"
+#include "bridgestats.h"
+
+struct telemetry_bridge;
+
+/**
+ * Run a bridge: read its port, build and send the frames that are due
+ * @param[in] bridge the bridge
+ * @param[in] now the system time in ms
+ * @return ms until the bridge wants to run again
+ */
+typedef uint32_t (*telemetry_bridge_run)(struct telemetry_bridge *bridge, uint32_t now);
+
+/*
+ * All bridges run from one thread. Each is called when its time is due
+ * and reads its port without blocking. One bridge that answers requests
+ * can set wake_on_rx, the thread then sleeps on its port and runs it as
+ * soon as a byte arrives.
+ */
+struct telemetry_bridge {
+	uintptr_t com;
+	uint8_t stats_idx;		//!< element of the BridgeStats fields
+	bool wake_on_rx;
+	telemetry_bridge_run run;
+	void *ctx;
+
+	// Private to the runtime
+	struct telemetry_bridge *next;
+	uint32_t next_run;
+	uint32_t cpu_us;
+	uint32_t tx_bytes;
+	uint32_t rx_bytes;
+	uint32_t dropped_bytes;
+	uint8_t rx_byte;		//!< read while sleeping on the port
+	bool rx_held;
+};
+
+int32_t TelemetryBridgeRegister(struct telemetry_bridge *bridge);
+int32_t TelemetryBridgeStart(void);
+
+const void *TelemetryBridgeSnapshot(UAVObjHandle (*handle)(void), uint16_t size);
+const void *TelemetryBridgeSnapshotPolled(UAVObjHandle (*handle)(void), uint16_t size);
+bool TelemetryBridgeSend(struct telemetry_bridge *bridge, const uint8_t *buf, uint16_t len);
+uint16_t TelemetryBridgeReceive(struct telemetry_bridge *bridge, uint8_t *buf, uint16_t len);
+
+#endif /* TELEMETRY_BRIDGE_H */
+
+/**
+ * @}
+ */
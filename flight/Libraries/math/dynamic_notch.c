@@ -0,0 +1,310 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ * @addtogroup TauLabsMath Tau Labs math support libraries
+ * @{
+ *
+ * @file       dynamic_notch.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @brief      Notch filters that track the noise peaks in the gyro spectrum
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * Every DYN_NOTCH_HOP samples the last DYN_NOTCH_FFT_SIZE samples of each
+ * axis are windowed and transformed. The strongest peaks between min_hz and
+ * max_hz move the notches of that axis. So that the cost per sample stays
+ * small and constant, the work of each analysis is split into steps and one
+ * step is done for every sample filtered.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include "dynamic_notch.h"
+#include "physical_constants.h"
+
+//! Samples between two analyses of the same axis
+#define DYN_NOTCH_HOP (DYN_NOTCH_FFT_SIZE / 4)
+
+//! A peak must be this much stronger than the average bin in the search range
+#define DYN_NOTCH_PEAK_RATIO 4.0f
+
+//! Fraction of the distance to a new peak a notch moves each analysis
+#define DYN_NOTCH_SMOOTHING 0.5f
+
+enum dyn_notch_phase {
+	PHASE_WINDOW,
+	PHASE_FFT,
+	PHASE_PEAKS,
+	PHASE_NUM
+};
+
+#define STEP_IDLE 0
+#define STEP_LAST (DYN_NOTCH_AXES * PHASE_NUM)
+
+/**
+ * Set the coefficients of a notch from the RBJ audio EQ cookbook
+ * @param[in,out] filter the filter, whose state is kept so the notch can move while running
+ * @param[in] sample_rate the sample rate in Hz
+ * @param[in] center the frequency to reject in Hz
+ * @param[in] q the quality factor, center frequency over -3dB bandwidth
+ */
+void biquad_notch_design(struct biquad *filter, float sample_rate, float center, float q)
+{
+	float omega = 2 * PI * center / sample_rate;
+	float cs = cosf(omega);
+	float alpha = sinf(omega) / (2 * q);
+	float a0 = 1 + alpha;
+
+	filter->b0 = 1 / a0;
+	filter->b1 = -2 * cs / a0;
+	filter->b2 = 1 / a0;
+	filter->a1 = -2 * cs / a0;
+	filter->a2 = (1 - alpha) / a0;
+}
+
+/**
+ * Clear the state of a biquad
+ * @param[in,out] filter the filter
+ */
+void biquad_reset(struct biquad *filter)
+{
+	filter->z1 = 0;
+	filter->z2 = 0;
+}
+
+/**
+ * Filter one sample
+ * @param[in,out] filter the filter
+ * @param[in] x the input sample
+ * @return the output sample
+ */
+float biquad_apply(struct biquad *filter, float x)
+{
+	float y = filter->b0 * x + filter->z1;
+	filter->z1 = filter->b1 * x - filter->a1 * y + filter->z2;
+	filter->z2 = filter->b2 * x - filter->a2 * y;
+	return y;
+}
+
+/**
+ * Initialize the filter bank
+ * @param[out] dn the filter bank
+ * @param[in] cfg the configuration, which is copied
+ * @return true if the configuration is usable
+ */
+bool dyn_notch_init(struct dyn_notch *dn, const struct dyn_notch_config *cfg)
+{
+	memset(dn, 0, sizeof(*dn));
+
+	if (cfg->sample_rate <= 0 || cfg->q <= 0 || cfg->min_hz <= 0 ||
+	    cfg->max_hz <= cfg->min_hz || cfg->num_notches == 0 ||
+	    cfg->num_notches > DYN_NOTCH_MAX_NOTCHES)
+		return false;
+
+	dn->cfg = *cfg;
+
+	if (!rfft_init(&dn->plan, DYN_NOTCH_FFT_SIZE, dn->twiddle))
+		return false;
+
+	rfft_hann_window(dn->window, DYN_NOTCH_FFT_SIZE);
+
+	// Leave a bin on each side for the peak test and interpolation
+	float bin_width = cfg->sample_rate / DYN_NOTCH_FFT_SIZE;
+	float min_bin = floorf(cfg->min_hz / bin_width);
+	float max_bin = ceilf(cfg->max_hz / bin_width);
+
+	dn->min_bin = min_bin < 2 ? 2 : (uint16_t) min_bin;
+	dn->max_bin = max_bin > DYN_NOTCH_FFT_SIZE / 2 - 2 ? DYN_NOTCH_FFT_SIZE / 2 - 2 : (uint16_t) max_bin;
+	if (dn->min_bin >= dn->max_bin)
+		return false;
+
+	return true;
+}
+
+/**
+ * Find the strongest peaks in the power spectrum in dn->work and move
+ * the notches of an axis towards them
+ * @param[in,out] dn the filter bank
+ * @param[in] axis the axis the spectrum belongs to
+ */
+static void update_notches(struct dyn_notch *dn, uint8_t axis)
+{
+	const float *power = dn->work;
+	const uint8_t num_notches = dn->cfg.num_notches;
+	float peak_power[DYN_NOTCH_MAX_NOTCHES];
+	uint16_t peak_bin[DYN_NOTCH_MAX_NOTCHES];
+	uint8_t num_peaks = 0;
+
+	float mean = 0;
+	for (uint16_t k = dn->min_bin; k <= dn->max_bin; k++)
+		mean += power[k];
+	mean /= dn->max_bin - dn->min_bin + 1;
+
+	// Keep the strongest local maxima, sorted by decreasing power
+	for (uint16_t k = dn->min_bin; k <= dn->max_bin; k++) {
+		if (power[k] <= power[k - 1] || power[k] < power[k + 1])
+			continue;
+		if (power[k] < DYN_NOTCH_PEAK_RATIO * mean)
+			continue;
+
+		uint8_t i;
+		if (num_peaks < num_notches)
+			i = num_peaks++;
+		else if (power[k] > peak_power[num_notches - 1])
+			i = num_notches - 1;
+		else
+			continue;
+
+		for (; i > 0 && peak_power[i - 1] < power[k]; i--) {
+			peak_power[i] = peak_power[i - 1];
+			peak_bin[i] = peak_bin[i - 1];
+		}
+		peak_power[i] = power[k];
+		peak_bin[i] = k;
+	}
+
+	// Refine each peak with a parabola through the neighbouring bins
+	float bin_width = dn->cfg.sample_rate / DYN_NOTCH_FFT_SIZE;
+	float peak_hz[DYN_NOTCH_MAX_NOTCHES];
+	for (uint8_t i = 0; i < num_peaks; i++) {
+		uint16_t k = peak_bin[i];
+		float denom = power[k - 1] - 2 * power[k] + power[k + 1];
+		float delta = denom < 0 ? 0.5f * (power[k - 1] - power[k + 1]) / denom : 0;
+		if (delta > 0.5f)
+			delta = 0.5f;
+		else if (delta < -0.5f)
+			delta = -0.5f;
+		peak_hz[i] = (k + delta) * bin_width;
+	}
+
+	// Sort by frequency so the notches keep their order as the peaks move
+	for (uint8_t i = 1; i < num_peaks; i++) {
+		float f = peak_hz[i];
+		uint8_t j = i;
+		for (; j > 0 && peak_hz[j - 1] > f; j--)
+			peak_hz[j] = peak_hz[j - 1];
+		peak_hz[j] = f;
+	}
+
+	// Notches without a peak this time stay where they were
+	for (uint8_t i = 0; i < num_peaks; i++) {
+		float center = dn->center[axis][i];
+		if (dn->active[axis][i])
+			center += DYN_NOTCH_SMOOTHING * (peak_hz[i] - center);
+		else
+			center = peak_hz[i];
+
+		if (center < dn->cfg.min_hz)
+			center = dn->cfg.min_hz;
+		else if (center > dn->cfg.max_hz)
+			center = dn->cfg.max_hz;
+
+		dn->center[axis][i] = center;
+		biquad_notch_design(&dn->notch[axis][i], dn->cfg.sample_rate, center, dn->cfg.q);
+		if (!dn->active[axis][i]) {
+			biquad_reset(&dn->notch[axis][i]);
+			dn->active[axis][i] = true;
+		}
+	}
+}
+
+/**
+ * Do one step of the spectrum analysis
+ * @param[in,out] dn the filter bank
+ */
+static void analysis_step(struct dyn_notch *dn)
+{
+	if (dn->step == STEP_IDLE) {
+		if (dn->history_fill < DYN_NOTCH_FFT_SIZE || dn->new_samples < DYN_NOTCH_HOP)
+			return;
+		dn->new_samples = 0;
+	}
+
+	uint8_t axis = dn->step / PHASE_NUM;
+
+	switch (dn->step % PHASE_NUM) {
+	case PHASE_WINDOW:
+	{
+		// The oldest sample is at history_pos
+		const float *history = dn->history[axis];
+		uint16_t j = dn->history_pos;
+		for (uint16_t i = 0; i < DYN_NOTCH_FFT_SIZE; i++) {
+			dn->work[i] = history[j] * dn->window[i];
+			j = (j + 1) & (DYN_NOTCH_FFT_SIZE - 1);
+		}
+		break;
+	}
+	case PHASE_FFT:
+		rfft_forward(&dn->plan, dn->work);
+		rfft_power(&dn->plan, dn->work);
+		break;
+	case PHASE_PEAKS:
+		update_notches(dn, axis);
+		break;
+	}
+
+	dn->step++;
+	if (dn->step >= STEP_LAST)
+		dn->step = STEP_IDLE;
+}
+
+/**
+ * Filter one sample of each axis in place and advance the spectrum analysis
+ * @param[in,out] dn the filter bank
+ * @param[in,out] gyro the sample of each axis
+ */
+void dyn_notch_apply(struct dyn_notch *dn, float gyro[DYN_NOTCH_AXES])
+{
+	for (uint8_t axis = 0; axis < DYN_NOTCH_AXES; axis++) {
+		dn->history[axis][dn->history_pos] = gyro[axis];
+
+		for (uint8_t i = 0; i < dn->cfg.num_notches; i++) {
+			if (dn->active[axis][i])
+				gyro[axis] = biquad_apply(&dn->notch[axis][i], gyro[axis]);
+		}
+	}
+
+	dn->history_pos = (dn->history_pos + 1) & (DYN_NOTCH_FFT_SIZE - 1);
+	if (dn->history_fill < DYN_NOTCH_FFT_SIZE)
+		dn->history_fill++;
+	dn->new_samples++;
+
+	analysis_step(dn);
+}
+
+/**
+ * Get the center of each notch on an axis
+ * @param[in] dn the filter bank
+ * @param[in] axis the axis
+ * @param[out] centers the center of each notch in Hz, zero if it is not active
+ */
+void dyn_notch_get_centers(const struct dyn_notch *dn, uint8_t axis, float centers[DYN_NOTCH_MAX_NOTCHES])
+{
+	for (uint8_t i = 0; i < DYN_NOTCH_MAX_NOTCHES; i++)
+		centers[i] = (axis < DYN_NOTCH_AXES && dn->active[axis][i]) ? dn->center[axis][i] : 0;
+}
+
+/**
+ * @}
+ * @}
+ */
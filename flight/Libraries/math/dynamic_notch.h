@@ -0,0 +1,113 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ * @addtogroup TauLabsMath Tau Labs math support libraries
+ * @{
+ *
+ * @file       dynamic_notch.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @brief      Notch filters that track the noise peaks in the gyro spectrum
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef DYNAMIC_NOTCH_H
+#define DYNAMIC_NOTCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "rfft.h"
+
+#define DYN_NOTCH_FFT_SIZE    128
+#define DYN_NOTCH_MAX_NOTCHES 3
+#define DYN_NOTCH_AXES        3
+
+//! A second order section in transposed direct form II
+struct biquad {
+	float b0;
+	float b1;
+	float b2;
+	float a1;
+	float a2;
+	float z1;
+	float z2;
+};
+
+struct dyn_notch_config {
+	float sample_rate;	//!< Rate dyn_notch_apply is called at in Hz
+	float min_hz;		//!< Lowest frequency a notch is placed at
+	float max_hz;		//!< Highest frequency a notch is placed at
+	float q;		//!< Quality factor of each notch
+	uint8_t num_notches;	//!< Notches per axis, at most DYN_NOTCH_MAX_NOTCHES
+};
+
+/**
+ * State of the filter bank. This is about 3kB, so it is allocated by the
+ * caller rather than being part of every image.
+ */
+struct dyn_notch {
+	struct dyn_notch_config cfg;
+
+	struct rfft_plan plan;
+	float twiddle[DYN_NOTCH_FFT_SIZE];
+	float window[DYN_NOTCH_FFT_SIZE];
+	float work[DYN_NOTCH_FFT_SIZE];
+
+	//! Last DYN_NOTCH_FFT_SIZE unfiltered samples of each axis, written circularly
+	float history[DYN_NOTCH_AXES][DYN_NOTCH_FFT_SIZE];
+	uint16_t history_pos;
+	uint16_t history_fill;
+	uint16_t new_samples;
+
+	uint16_t min_bin;
+	uint16_t max_bin;
+
+	//! The analysis is spread over several samples, one step per sample
+	uint8_t step;
+
+	float center[DYN_NOTCH_AXES][DYN_NOTCH_MAX_NOTCHES];
+	bool active[DYN_NOTCH_AXES][DYN_NOTCH_MAX_NOTCHES];
+	struct biquad notch[DYN_NOTCH_AXES][DYN_NOTCH_MAX_NOTCHES];
+};
+
+//! Set the coefficients of a notch, keeping the filter state
+void biquad_notch_design(struct biquad *filter, float sample_rate, float center, float q);
+
+//! Clear the state of a biquad
+void biquad_reset(struct biquad *filter);
+
+//! Filter one sample
+float biquad_apply(struct biquad *filter, float x);
+
+//! Initialize the filter bank, which passes samples through until the first peaks are found
+bool dyn_notch_init(struct dyn_notch *dn, const struct dyn_notch_config *cfg);
+
+//! Filter one sample of each axis in place and advance the spectrum analysis
+void dyn_notch_apply(struct dyn_notch *dn, float gyro[DYN_NOTCH_AXES]);
+
+//! Get the center of each notch on an axis, zero if it is not active yet
+void dyn_notch_get_centers(const struct dyn_notch *dn, uint8_t axis, float centers[DYN_NOTCH_MAX_NOTCHES]);
+
+#endif /* DYNAMIC_NOTCH_H */
+
+/**
+ * @}
+ * @}
+ */
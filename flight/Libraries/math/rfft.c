@@ -0,0 +1,187 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ * @addtogroup TauLabsMath Tau Labs math support libraries
+ * @{
+ *
+ * @file       rfft.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @brief      Real valued FFT and spectral helpers
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#include <stddef.h>
+#include <math.h>
+#include "rfft.h"		/* API declarations */
+#include "physical_constants.h"
+
+/**
+ * Initialize a real FFT plan
+ * @param[out] plan the plan to initialize
+ * @param[in] n the transform length, a power of two of at least 4
+ * @param[in] twiddle storage for n floats, must remain valid as long as the plan
+ * @return true if the length is supported
+ */
+bool rfft_init(struct rfft_plan *plan, uint16_t n, float *twiddle)
+{
+	if (n < 4 || (n & (n - 1)) != 0 || twiddle == NULL)
+		return false;
+
+	plan->n = n;
+	plan->twiddle = twiddle;
+
+	for (uint16_t k = 0; k < n / 2; k++) {
+		twiddle[2 * k]     = cosf(2 * PI * k / n);
+		twiddle[2 * k + 1] = sinf(2 * PI * k / n);
+	}
+
+	return true;
+}
+
+/**
+ * In place radix-2 decimation in time complex FFT
+ * @param[in] plan the real plan, whose twiddles are a superset of those needed
+ * @param[in,out] z m interleaved complex values
+ * @param[in] m the complex length, n/2
+ */
+static void cfft_forward(const struct rfft_plan *plan, float *z, uint16_t m)
+{
+	const float *tw = plan->twiddle;
+
+	// Bit reversed reordering
+	for (uint16_t i = 1, j = 0; i < m; i++) {
+		uint16_t bit = m >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+
+		if (i < j) {
+			float tr = z[2 * i], ti = z[2 * i + 1];
+			z[2 * i] = z[2 * j];
+			z[2 * i + 1] = z[2 * j + 1];
+			z[2 * j] = tr;
+			z[2 * j + 1] = ti;
+		}
+	}
+
+	// Butterflies, W_len^j = W_n^(j * n / len)
+	for (uint16_t len = 2; len <= m; len <<= 1) {
+		const uint16_t half = len >> 1;
+		const uint16_t stride = plan->n / len;
+
+		for (uint16_t i = 0; i < m; i += len) {
+			for (uint16_t j = 0; j < half; j++) {
+				const float wr = tw[2 * j * stride];
+				const float wi = -tw[2 * j * stride + 1];
+
+				float *a = &z[2 * (i + j)];
+				float *b = &z[2 * (i + j + half)];
+
+				const float tr = b[0] * wr - b[1] * wi;
+				const float ti = b[0] * wi + b[1] * wr;
+
+				b[0] = a[0] - tr;
+				b[1] = a[1] - ti;
+				a[0] += tr;
+				a[1] += ti;
+			}
+		}
+	}
+}
+
+/**
+ * In place forward real FFT. The even and odd samples are transformed as
+ * one complex sequence of half the length and then separated.
+ * @param[in] plan an initialized plan
+ * @param[in,out] buf n real samples on input. On output buf[0] is the DC
+ * bin, buf[1] the Nyquist bin and buf[2k], buf[2k+1] the real and imaginary
+ * parts of bin k for 0 < k < n/2.
+ */
+void rfft_forward(const struct rfft_plan *plan, float *buf)
+{
+	const uint16_t m = plan->n / 2;
+	const float *tw = plan->twiddle;
+
+	cfft_forward(plan, buf, m);
+
+	const float z0r = buf[0], z0i = buf[1];
+	buf[0] = z0r + z0i;
+	buf[1] = z0r - z0i;
+
+	// Bins k and m - k are built from the same pair of complex outputs
+	for (uint16_t k = 1; k <= m / 2; k++) {
+		float *a = &buf[2 * k];
+		float *b = &buf[2 * (m - k)];
+
+		// Even and odd sample spectra
+		const float evr = 0.5f * (a[0] + b[0]);
+		const float evi = 0.5f * (a[1] - b[1]);
+		const float odr = 0.5f * (a[1] + b[1]);
+		const float odi = -0.5f * (a[0] - b[0]);
+
+		// Twiddle the odd part by W_n^k
+		const float c = tw[2 * k], s = tw[2 * k + 1];
+		const float tr = c * odr + s * odi;
+		const float ti = c * odi - s * odr;
+
+		a[0] = evr + tr;
+		a[1] = evi + ti;
+		b[0] = evr - tr;
+		b[1] = -(evi - ti);
+	}
+}
+
+/**
+ * Convert the output of @ref rfft_forward to the power of each bin
+ * @param[in] plan the plan used for the transform
+ * @param[in,out] buf transformed data on input, buf[k] = |X[k]|^2 for
+ * k < n/2 on output. The Nyquist bin is dropped.
+ */
+void rfft_power(const struct rfft_plan *plan, float *buf)
+{
+	buf[0] = buf[0] * buf[0];
+	for (uint16_t k = 1; k < plan->n / 2; k++)
+		buf[k] = buf[2 * k] * buf[2 * k] + buf[2 * k + 1] * buf[2 * k + 1];
+}
+
+/**
+ * Fill a periodic Hann window, which gives constant overlap-add at 50% overlap
+ * @param[out] window n coefficients
+ * @param[in] n the window length
+ * @return the sum of the squared coefficients, used to normalize power
+ */
+float rfft_hann_window(float *window, uint16_t n)
+{
+	float sum_sq = 0;
+
+	for (uint16_t i = 0; i < n; i++) {
+		window[i] = 0.5f - 0.5f * cosf(2 * PI * i / n);
+		sum_sq += window[i] * window[i];
+	}
+
+	return sum_sq;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,65 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ * @addtogroup TauLabsMath Tau Labs math support libraries
+ * @{
+ *
+ * @file       rfft.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @brief      Real valued FFT and spectral helpers
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#ifndef RFFT_H
+#define RFFT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * A real FFT of length n (power of two) computed with a complex FFT of
+ * length n/2. The twiddle table of n floats is provided by the caller so
+ * that the library does no allocation.
+ */
+struct rfft_plan {
+	uint16_t n;
+	float *twiddle;		//!< cos and sin of 2*pi*k/n for k < n/2, interleaved
+};
+
+//! Initialize a plan and fill its twiddle table
+bool rfft_init(struct rfft_plan *plan, uint16_t n, float *twiddle);
+
+//! In place forward transform of n real samples
+void rfft_forward(const struct rfft_plan *plan, float *buf);
+
+//! Convert the output of rfft_forward in place to n/2 bin powers |X[k]|^2
+void rfft_power(const struct rfft_plan *plan, float *buf);
+
+//! Fill a periodic Hann window and return the sum of its squares
+float rfft_hann_window(float *window, uint16_t n);
+
+#endif /* RFFT_H */
+
+/**
+ * @}
+ * @}
+ */
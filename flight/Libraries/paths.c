@@ -14,6 +14,11 @@
  * and the distance of that vector.  The distance along the path is also
  * returned in the path_status.
  *
+ * The geometry that only depends on the path (direction, length, the
+ * center and radius of arcs) is compiled into a @ref path_segment when
+ * the path changes, so the followers only pay for the distance to the
+ * path on every update.
+ *
  * @see        The GNU Public License (GPL) Version 3
  *
  *****************************************************************************/
@@ -39,242 +44,186 @@
 #include "uavobjectmanager.h"
 #include "pathdesired.h"
 
+//! How a compiled segment is evaluated
+enum path_shape {
+	PATH_SHAPE_NONE = 0,	//!< not compiled yet
+	PATH_SHAPE_ENDPOINT,
+	PATH_SHAPE_POINT,	//!< endpoint of a path too short to have a direction
+	PATH_SHAPE_VECTOR,
+	PATH_SHAPE_ARC,
+	PATH_SHAPE_ORBIT,
+};
+
 // private functions
-static void path_endpoint(const float * start_point, const float * end_point,
-                          const float * cur_point, struct path_status * status);
-static void path_vector(const float * start_point, const float * end_point,
-                        const float * cur_point, struct path_status * status);
-static void path_circle(const float * center_point, float radius,
-                        const float * cur_point, struct path_status * status,
-                        bool clockwise);
-static void path_curve(const float * start_point, const float * end_point,
-                       float radius, const float * cur_point,
-                       struct path_status * status, bool clockwise);
+static void compile_line(struct path_segment *segment);
+static void compile_arc(struct path_segment *segment);
+static void compile_orbit(struct path_segment *segment);
+static void path_endpoint(const struct path_segment *segment,
+                          const float *cur_point, struct path_status *status);
+static void path_vector(const struct path_segment *segment,
+                        const float *cur_point, struct path_status *status);
+static void path_circle(const struct path_segment *segment,
+                        const float *cur_point, struct path_status *status);
 
 /**
  * @brief Compute progress along path and deviation from it
- * @param[in] start_point Starting point
- * @param[in] end_point Ending point
+ *
+ * This compiles the path on every call, followers that evaluate the same
+ * path repeatedly should keep a @ref path_segment instead.
+ *
+ * @param[in] pathDesired The path to follow
  * @param[in] cur_point Current location
- * @param[in] mode Path following mode
  * @param[out] status Structure containing progress along path and deviation
  */
 void path_progress(const PathDesiredData *pathDesired,
                    const float *cur_point,
                    struct path_status *status)
 {
-	uint8_t mode = pathDesired->Mode;
-	float start_point[2] = {pathDesired->Start[0],pathDesired->Start[1]};
-	float end_point[2] = {pathDesired->End[0],pathDesired->End[1]};
+	struct path_segment segment;
+
+	path_compile(pathDesired, &segment);
+	path_segment_progress(&segment, cur_point, status);
+}
+
+/**
+ * @brief Compile the geometry of a path
+ * @param[in] pathDesired The path to follow
+ * @param[out] segment The compiled path
+ */
+void path_compile(const PathDesiredData *pathDesired, struct path_segment *segment)
+{
+	segment->mode = pathDesired->Mode;
+	segment->start[0] = pathDesired->Start[0];
+	segment->start[1] = pathDesired->Start[1];
+	segment->end[0] = pathDesired->End[0];
+	segment->end[1] = pathDesired->End[1];
+	segment->mode_parameter = pathDesired->ModeParameters;
+
+	compile_line(segment);
+
+	segment->center[0] = segment->center[1] = 0;
+	segment->radius = 0;
+	segment->curvature = 0;
 
-	switch(mode) {
+	switch(segment->mode) {
 		case PATHDESIRED_MODE_VECTOR:
-			return path_vector(start_point, end_point, cur_point, status);
+			// if the path is too short, we cannot determine vector direction.
+			// Fly towards the endpoint to prevent flying away,
+			// but assume progress=1 either way.
+			segment->shape = (segment->inv_length > 0) ? PATH_SHAPE_VECTOR : PATH_SHAPE_POINT;
+			segment->clockwise = false;
 			break;
 		case PATHDESIRED_MODE_CIRCLERIGHT:
-			return path_curve(start_point, end_point, pathDesired->ModeParameters, cur_point, status, 1);
-			break;
 		case PATHDESIRED_MODE_CIRCLELEFT:
-			return path_curve(start_point, end_point, pathDesired->ModeParameters, cur_point, status, 0);
+			segment->shape = PATH_SHAPE_ARC;
+			segment->clockwise = (segment->mode == PATHDESIRED_MODE_CIRCLERIGHT);
+			compile_arc(segment);
 			break;
 		case PATHDESIRED_MODE_CIRCLEPOSITIONLEFT:
-			return path_circle(end_point, pathDesired->ModeParameters, cur_point, status, 0);
-			break;
 		case PATHDESIRED_MODE_CIRCLEPOSITIONRIGHT:
-			return path_circle(end_point, pathDesired->ModeParameters, cur_point, status, 1);
+			segment->shape = PATH_SHAPE_ORBIT;
+			segment->clockwise = (segment->mode == PATHDESIRED_MODE_CIRCLEPOSITIONRIGHT);
+			compile_orbit(segment);
 			break;
 		case PATHDESIRED_MODE_ENDPOINT:
 		case PATHDESIRED_MODE_HOLDPOSITION:
 		default:
 			// use the endpoint as default failsafe if called in unknown modes
-			return path_endpoint(start_point, end_point, cur_point, status);
+			segment->shape = PATH_SHAPE_ENDPOINT;
+			segment->clockwise = false;
 			break;
 	}
 }
 
 /**
- * @brief Compute progress towards endpoint. Deviation equals distance
- * @param[in] start_point Starting point
- * @param[in] end_point Ending point
- * @param[in] cur_point Current location
- * @param[out] status Structure containing progress along path and deviation
+ * @brief Compile the path again if it changed
+ * @param[in,out] segment The compiled path
+ * @param[in] pathDesired The path to follow
+ * @return true if the path changed
  */
-static void path_endpoint(const float *start_point,
-                          const float *end_point,
-                          const float *cur_point,
-                          struct path_status *status)
+bool path_segment_update(struct path_segment *segment, const PathDesiredData *pathDesired)
 {
-	float path_north, path_east, diff_north, diff_east;
-	float dist_path, dist_diff;
-
-	// we do not correct in this mode
-	status->correction_direction[0] = status->correction_direction[1] = 0;
-
-	// Distance to go
-	path_north = end_point[0] - start_point[0];
-	path_east = end_point[1] - start_point[1];
-
-	// Current progress location relative to end
-	diff_north = end_point[0] - cur_point[0];
-	diff_east = end_point[1] - cur_point[1];
-
-	dist_diff = sqrtf( diff_north * diff_north + diff_east * diff_east );
-	dist_path = sqrtf( path_north * path_north + path_east * path_east );
-
-	if(dist_diff < 1e-6f ) {
-		status->fractional_progress = 1;
-		status->error = 0;
-		status->path_direction[0] = status->path_direction[1] = 0;
-		return;
-	}
-
-	status->fractional_progress = 1 - dist_diff / (1 + dist_path);
-	status->error = dist_diff;
-
-	// Compute direction to travel
-	status->path_direction[0] = diff_north / dist_diff;
-	status->path_direction[1] = diff_east / dist_diff;
+	if (segment->shape != PATH_SHAPE_NONE &&
+			segment->mode == pathDesired->Mode &&
+			segment->start[0] == pathDesired->Start[0] &&
+			segment->start[1] == pathDesired->Start[1] &&
+			segment->end[0] == pathDesired->End[0] &&
+			segment->end[1] == pathDesired->End[1] &&
+			segment->mode_parameter == pathDesired->ModeParameters)
+		return false;
+
+	path_compile(pathDesired, segment);
+	return true;
 }
 
 /**
- * @brief Compute progress along path and deviation from it
- * @param[in] start_point Starting point
- * @param[in] end_point Ending point
+ * @brief Compute progress along a compiled path and deviation from it
+ * @param[in] segment The compiled path
  * @param[in] cur_point Current location
  * @param[out] status Structure containing progress along path and deviation
  */
-static void path_vector(const float *start_point,
-                        const float *end_point,
-                        const float *cur_point,
-                        struct path_status *status)
+void path_segment_progress(const struct path_segment *segment,
+                           const float *cur_point,
+                           struct path_status *status)
 {
-	float path_north, path_east, diff_north, diff_east;
-	float dist_path;
-	float dot;
-	float normal[2];
-
-	// Distance to go
-	path_north = end_point[0] - start_point[0];
-	path_east = end_point[1] - start_point[1];
-
-	// Current progress location relative to start
-	diff_north = cur_point[0] - start_point[0];
-	diff_east = cur_point[1] - start_point[1];
-
-	dot = path_north * diff_north + path_east * diff_east;
-	dist_path = sqrtf( path_north * path_north + path_east * path_east );
-
-	if(dist_path < 1e-6f) {
-		// if the path is too short, we cannot determine vector direction.
-		// Fly towards the endpoint to prevent flying away,
-		// but assume progress=1 either way.
-		path_endpoint( start_point, end_point, cur_point, status );
-		status->fractional_progress = 1;
-		return;
+	switch(segment->shape) {
+		case PATH_SHAPE_VECTOR:
+			path_vector(segment, cur_point, status);
+			break;
+		case PATH_SHAPE_ARC:
+		case PATH_SHAPE_ORBIT:
+			path_circle(segment, cur_point, status);
+			break;
+		case PATH_SHAPE_POINT:
+			path_endpoint(segment, cur_point, status);
+			status->fractional_progress = 1;
+			break;
+		case PATH_SHAPE_ENDPOINT:
+		default:
+			path_endpoint(segment, cur_point, status);
+			break;
 	}
-
-	// Compute the normal to the path
-	normal[0] = -path_east / dist_path;
-	normal[1] = path_north / dist_path;
-
-	status->fractional_progress = dot / (dist_path * dist_path);
-	status->error = normal[0] * diff_north + normal[1] * diff_east;
-
-	// Compute direction to correct error
-	status->correction_direction[0] = (status->error > 0) ? -normal[0] : normal[0];
-	status->correction_direction[1] = (status->error > 0) ? -normal[1] : normal[1];
-	
-	// Now just want magnitude of error
-	status->error = fabs(status->error);
-
-	// Compute direction to travel
-	status->path_direction[0] = path_north / dist_path;
-	status->path_direction[1] = path_east / dist_path;
-
 }
 
 /**
- * @brief Circle location continuously
- * @param[in] start_point Starting point
- * @param[in] end_point Center point
- * @param[in] cur_point Current location
- * @param[out] status Structure containing progress along path and deviation
+ * @brief Compile the direction and length from start to end
  */
-static void path_circle(const float * center_point,
-                        float radius,
-                        const float * cur_point,
-                        struct path_status * status,
-                        bool clockwise)
+static void compile_line(struct path_segment *segment)
 {
-	float diff_north, diff_east;
-	float cradius;
-	float normal[2];
-
-	if (radius < 0.10f) {
-		radius = 0.10f;		// Never try a circle less than 10cm
-	}
+	float path_north = segment->end[0] - segment->start[0];
+	float path_east = segment->end[1] - segment->start[1];
 
-	// Current location relative to center
-	diff_north = cur_point[0] - center_point[0];
-	diff_east = cur_point[1] - center_point[1];
-
-	cradius = sqrtf(  diff_north * diff_north   +   diff_east * diff_east );
+	segment->length = sqrtf(path_north * path_north + path_east * path_east);
+	segment->inv_1plus_length = 1.0f / (1 + segment->length);
 
-	if (cradius < 1e-6f) {
-		// cradius is zero, just fly somewhere and make sure correction is still a normal
-		status->fractional_progress = 1;
-		status->error = radius;
-		status->correction_direction[0] = 0;
-		status->correction_direction[1] = 1;
-		status->path_direction[0] = 1;
-		status->path_direction[1] = 0;
+	if (segment->length < 1e-6f) {
+		segment->inv_length = 0;
+		segment->direction[0] = segment->direction[1] = 0;
+		segment->normal[0] = segment->normal[1] = 0;
 		return;
 	}
 
-	if (clockwise) {
-		// Compute the normal to the radius clockwise
-		normal[0] = -diff_east / cradius;
-		normal[1] = diff_north / cradius;
-	} else {
-		// Compute the normal to the radius counter clockwise
-		normal[0] = diff_east / cradius;
-		normal[1] = -diff_north / cradius;
-	}
-	
-	status->fractional_progress = 0;
-
-	// error is current radius minus wanted radius - positive if too close
-	status->error = radius - cradius;
-
-	// Compute direction to correct error
-	status->correction_direction[0] = (status->error>0?1:-1) * diff_north / cradius;
-	status->correction_direction[1] = (status->error>0?1:-1) * diff_east / cradius;
-
-	// Compute direction to travel
-	status->path_direction[0] = normal[0];
-	status->path_direction[1] = normal[1];
+	segment->inv_length = 1.0f / segment->length;
+	segment->direction[0] = path_north * segment->inv_length;
+	segment->direction[1] = path_east * segment->inv_length;
 
-	status->error = fabs(status->error);
+	// Counter clockwise normal to the path
+	segment->normal[0] = -segment->direction[1];
+	segment->normal[1] = segment->direction[0];
 }
 
 /**
- * @brief Compute progress along circular path and deviation from it
- * @param[in] start_point Starting point
- * @param[in] end_point Ending point
- * @param[in] radius Radius of the curve segment
- * @param[in] cur_point Current location
- * @param[out] status Structure containing progress along path and deviation
+ * @brief Compile the circle through start and end with the radius in the
+ * mode parameter. A negative radius takes the longer arc.
  */
-static void path_curve(const float * start_point,
-                       const float * end_point,
-                       float radius,
-                       const float * cur_point,
-                       struct path_status *status,
-                       bool clockwise)
+static void compile_arc(struct path_segment *segment)
 {
+	const float *start_point = segment->start;
+	const float *end_point = segment->end;
+	float radius = segment->mode_parameter;
+
 	// OK for up to 10km
-	float min_radius = sqrtf(powf(start_point[0] - end_point[0], 2) +
-		powf(start_point[1] - end_point[1], 2)) / 2.0f + 0.01f;
+	float min_radius = segment->length / 2.0f + 0.01f;
 
 	if (fabsf(radius) < min_radius) {
 		// This was possibly floating point confusion.
@@ -294,58 +243,154 @@ static void path_curve(const float * start_point,
 		}
 	}
 
-	float diff_north, diff_east;
-	float path_north, path_east;
-	float cradius;
-	float normal[2];
-
 	// Compute the center of the circle connecting the two points as the intersection of two circles
 	// around the two points from
 	// http://www.mathworks.com/matlabcentral/newsreader/view_thread/255121
-	float m_n, m_e, p_n, p_e, d, center[2];
+	float m_n, m_e, p_n, p_e, d;
 
 	// Center between start and end
 	m_n = (start_point[0] + end_point[0]) / 2;
 	m_e = (start_point[1] + end_point[1]) / 2;
 
 	// Normal vector the line between start and end.
-	if (clockwise) {
+	if (segment->clockwise) {
 		p_n = -(end_point[1] - start_point[1]);
 		p_e = (end_point[0] - start_point[0]);
 	} else {
 		p_n = (end_point[1] - start_point[1]);
-		p_e = -(end_point[0] - start_point[0]);		
+		p_e = -(end_point[0] - start_point[0]);
 	}
 
-	// Work out how far to go along the perpendicular bisector
-	d = sqrtf(radius * radius / (p_n * p_n + p_e * p_e) - 0.25f);
-
 	float radius_sign = (radius > 0) ? 1 : -1;
-	float m_radius = fabs(radius);
 
-	if (fabs(p_n) < 1e-3 && fabs(p_e) < 1e-3) {
-		center[0] = m_n;
-		center[1] = m_e;
+	if (fabsf(p_n) < 1e-3f && fabsf(p_e) < 1e-3f) {
+		segment->center[0] = m_n;
+		segment->center[1] = m_e;
 	} else {
-		center[0] = m_n + p_n * d * radius_sign;
-		center[1] = m_e + p_e * d * radius_sign;
+		// Work out how far to go along the perpendicular bisector
+		d = sqrtf(radius * radius / (p_n * p_n + p_e * p_e) - 0.25f);
+
+		segment->center[0] = m_n + p_n * d * radius_sign;
+		segment->center[1] = m_e + p_e * d * radius_sign;
 	}
 
+	segment->radius = fabsf(radius);
+	segment->curvature = (segment->clockwise ? 1 : -1) / segment->radius;
+}
+
+/**
+ * @brief Compile the circle around the end point
+ */
+static void compile_orbit(struct path_segment *segment)
+{
+	float radius = segment->mode_parameter;
+
+	if (radius < 0.10f) {
+		radius = 0.10f;		// Never try a circle less than 10cm
+	}
+
+	segment->center[0] = segment->end[0];
+	segment->center[1] = segment->end[1];
+	segment->radius = radius;
+	segment->curvature = (segment->clockwise ? 1 : -1) / radius;
+}
+
+/**
+ * @brief Compute progress towards endpoint. Deviation equals distance
+ * @param[in] segment The compiled path
+ * @param[in] cur_point Current location
+ * @param[out] status Structure containing progress along path and deviation
+ */
+static void path_endpoint(const struct path_segment *segment,
+                          const float *cur_point,
+                          struct path_status *status)
+{
+	float diff_north, diff_east;
+	float dist_diff;
+
+	// we do not correct in this mode
+	status->correction_direction[0] = status->correction_direction[1] = 0;
+
+	// Current progress location relative to end
+	diff_north = segment->end[0] - cur_point[0];
+	diff_east = segment->end[1] - cur_point[1];
+
+	dist_diff = sqrtf( diff_north * diff_north + diff_east * diff_east );
+
+	if(dist_diff < 1e-6f ) {
+		status->fractional_progress = 1;
+		status->error = 0;
+		status->path_direction[0] = status->path_direction[1] = 0;
+		return;
+	}
+
+	status->fractional_progress = 1 - dist_diff * segment->inv_1plus_length;
+	status->error = dist_diff;
+
+	// Compute direction to travel
+	status->path_direction[0] = diff_north / dist_diff;
+	status->path_direction[1] = diff_east / dist_diff;
+}
+
+/**
+ * @brief Compute progress along path and deviation from it
+ * @param[in] segment The compiled path
+ * @param[in] cur_point Current location
+ * @param[out] status Structure containing progress along path and deviation
+ */
+static void path_vector(const struct path_segment *segment,
+                        const float *cur_point,
+                        struct path_status *status)
+{
+	float diff_north, diff_east;
+
+	// Current progress location relative to start
+	diff_north = cur_point[0] - segment->start[0];
+	diff_east = cur_point[1] - segment->start[1];
+
+	status->fractional_progress = (segment->direction[0] * diff_north +
+		segment->direction[1] * diff_east) * segment->inv_length;
+	status->error = segment->normal[0] * diff_north + segment->normal[1] * diff_east;
+
+	// Compute direction to correct error
+	status->correction_direction[0] = (status->error > 0) ? -segment->normal[0] : segment->normal[0];
+	status->correction_direction[1] = (status->error > 0) ? -segment->normal[1] : segment->normal[1];
+
+	// Now just want magnitude of error
+	status->error = fabsf(status->error);
+
+	// Compute direction to travel
+	status->path_direction[0] = segment->direction[0];
+	status->path_direction[1] = segment->direction[1];
+}
+
+/**
+ * @brief Compute progress along a circle and deviation from it
+ *
+ * Arcs progress along the chord from start to end, orbits never complete.
+ *
+ * @param[in] segment The compiled path
+ * @param[in] cur_point Current location
+ * @param[out] status Structure containing progress along path and deviation
+ */
+static void path_circle(const struct path_segment *segment,
+                        const float *cur_point,
+                        struct path_status *status)
+{
+	float diff_north, diff_east;
+	float cradius, inv_cradius;
+
 	// Current location relative to center
-	diff_north = cur_point[0] - center[0];
-	diff_east = cur_point[1] - center[1];
+	diff_north = cur_point[0] - segment->center[0];
+	diff_east = cur_point[1] - segment->center[1];
 
 	// Compute current radius from the center
 	cradius = sqrtf(  diff_north * diff_north   +   diff_east * diff_east );
 
-	// Compute error in terms of meters from the curve (the distance projected
-	// normal onto the path i.e. cross-track distance)
-	status->error = m_radius - cradius;
-
 	if (cradius < 1e-6f) {
 		// cradius is zero, just fly somewhere and make sure correction is still a normal
 		status->fractional_progress = 1;
-		status->error = m_radius;
+		status->error = segment->radius;
 		status->correction_direction[0] = 0;
 		status->correction_direction[1] = 1;
 		status->path_direction[0] = 1;
@@ -353,34 +398,37 @@ static void path_curve(const float * start_point,
 		return;
 	}
 
-	if (clockwise) {
+	inv_cradius = 1.0f / cradius;
+
+	if (segment->clockwise) {
 		// Compute the normal to the radius clockwise
-		normal[0] = -diff_east / cradius;
-		normal[1] = diff_north / cradius;
+		status->path_direction[0] = -diff_east * inv_cradius;
+		status->path_direction[1] = diff_north * inv_cradius;
 	} else {
 		// Compute the normal to the radius counter clockwise
-		normal[0] = diff_east / cradius;
-		normal[1] = -diff_north / cradius;
+		status->path_direction[0] = diff_east * inv_cradius;
+		status->path_direction[1] = -diff_north * inv_cradius;
 	}
 
-	// Compute direction to correct error
-	status->correction_direction[0] = (status->error>0?1:-1) * diff_north / cradius;
-	status->correction_direction[1] = (status->error>0?1:-1) * diff_east / cradius;
+	// error is wanted radius minus current radius - positive if too close
+	// (the distance projected normal onto the path i.e. cross-track distance)
+	status->error = segment->radius - cradius;
 
-	// Compute direction to travel
-	status->path_direction[0] = normal[0];
-	status->path_direction[1] = normal[1];
-
-	path_north = end_point[0] - start_point[0];
-	path_east = end_point[1] - start_point[1];
-	diff_north = cur_point[0] - start_point[0];
-	diff_east = cur_point[1] - start_point[1];
-	float dist_path = sqrtf( path_north * path_north + path_east * path_east );
-	float dot = path_north * diff_north + path_east * diff_east;
+	// Compute direction to correct error
+	float sign = (status->error > 0) ? inv_cradius : -inv_cradius;
+	status->correction_direction[0] = sign * diff_north;
+	status->correction_direction[1] = sign * diff_east;
 
-	status->fractional_progress = dot / (dist_path * dist_path);
+	status->error = fabsf(status->error);
 
-	status->error = fabs(status->error);
+	if (segment->shape == PATH_SHAPE_ARC) {
+		status->fractional_progress = (segment->inv_length > 0) ?
+			(segment->direction[0] * (cur_point[0] - segment->start[0]) +
+			 segment->direction[1] * (cur_point[1] - segment->start[1])) * segment->inv_length :
+			1;
+	} else {
+		status->fractional_progress = 0;
+	}
 }
 
 /**
@@ -0,0 +1,181 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       profiler.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @brief      Timing probes around the hot paths of the control loop
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "openpilot.h"
+#include "profiler.h"
+#include "pios_thread.h"
+
+#if defined(DIAG_PROFILER)
+
+#include "profilerprobes.h"
+
+#if defined(SIM_POSIX)
+#include <time.h>
+#endif
+
+// Private constants
+
+/*
+ * On the flight controllers the probes count core cycles with the DWT
+ * counter behind PIOS_DELAY_GetRaw, which is read in a single instruction.
+ * The simulator has no such counter, so it uses the monotonic clock in ns.
+ */
+#if defined(SIM_POSIX)
+#define PROFILER_TICKS_PER_US 1000
+#else
+#define PROFILER_TICKS_PER_US (PIOS_SYSCLK / 1000000)
+#endif
+
+// Private types
+
+struct profiler_stats {
+	uint32_t count;
+	uint32_t total;		//!< ticks spent in the probe
+	uint32_t max;		//!< longest single pass in ticks
+	uint16_t histogram[PROFILERPROBES_SENSORSHISTOGRAM_NUMELEM];
+};
+
+struct profiler_probe_state {
+	uint32_t start;
+	bool running;
+	struct profiler_stats stats;
+};
+
+// Private variables
+static struct profiler_probe_state probes[PROFILER_PROBE_NUM];
+
+// Private functions
+
+static inline uint32_t profiler_now(void)
+{
+#if defined(SIM_POSIX)
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000u + ts.tv_nsec;
+#else
+	return PIOS_DELAY_GetRaw();
+#endif
+}
+
+/**
+ * Histogram bin of a duration. The first bin is below 16us, each bin
+ * after that doubles the width and the last one holds everything from
+ * 1024us up.
+ */
+static inline uint8_t profiler_bin(uint32_t us)
+{
+	uint32_t scaled = us >> 4;
+	if (scaled == 0)
+		return 0;
+
+	uint8_t bin = 32 - __builtin_clz(scaled);
+	if (bin >= PROFILERPROBES_SENSORSHISTOGRAM_NUMELEM)
+		bin = PROFILERPROBES_SENSORSHISTOGRAM_NUMELEM - 1;
+
+	return bin;
+}
+
+/**
+ * Initialize library
+ */
+int32_t ProfilerInitialize(void)
+{
+	memset(probes, 0, sizeof(probes));
+
+	return ProfilerProbesInitialize();
+}
+
+/**
+ * Start timing a pass through a code path
+ */
+void ProfilerBegin(enum profiler_probe probe)
+{
+	probes[probe].start = profiler_now();
+	probes[probe].running = true;
+}
+
+/**
+ * Stop timing a pass through a code path and account for it
+ */
+void ProfilerEnd(enum profiler_probe probe)
+{
+	struct profiler_probe_state *state = &probes[probe];
+
+	if (!state->running)
+		return;
+
+	uint32_t ticks = profiler_now() - state->start;
+	state->running = false;
+
+	state->stats.count++;
+	state->stats.total += ticks;
+	if (ticks > state->stats.max)
+		state->stats.max = ticks;
+
+	uint16_t *bin = &state->stats.histogram[profiler_bin(ticks / PROFILER_TICKS_PER_US)];
+	if (*bin < UINT16_MAX)
+		(*bin)++;
+}
+
+/**
+ * Publish the statistics gathered since the last call and start over
+ */
+void ProfilerUpdateAll(void)
+{
+	struct profiler_stats stats[PROFILER_PROBE_NUM];
+
+	// The probes are only written from tasks, so this makes the copy atomic
+	PIOS_Thread_Scheduler_Suspend();
+	for (uint8_t i = 0; i < PROFILER_PROBE_NUM; i++) {
+		stats[i] = probes[i].stats;
+		memset(&probes[i].stats, 0, sizeof(probes[i].stats));
+	}
+	PIOS_Thread_Scheduler_Resume();
+
+	ProfilerProbesData data;
+	uint16_t *histograms[PROFILER_PROBE_NUM] = {
+		[PROFILER_PROBE_SENSORS] = data.SensorsHistogram,
+		[PROFILER_PROBE_ATTITUDE] = data.AttitudeHistogram,
+		[PROFILER_PROBE_STABILIZATION] = data.StabilizationHistogram,
+		[PROFILER_PROBE_ACTUATOR] = data.ActuatorHistogram,
+	};
+
+	for (uint8_t i = 0; i < PROFILER_PROBE_NUM; i++) {
+		data.Count[i] = stats[i].count > UINT16_MAX ? UINT16_MAX : stats[i].count;
+		data.Average[i] = stats[i].count ?
+			(float) stats[i].total / stats[i].count / PROFILER_TICKS_PER_US : 0;
+		data.Max[i] = (float) stats[i].max / PROFILER_TICKS_PER_US;
+		memcpy(histograms[i], stats[i].histogram, sizeof(stats[i].histogram));
+	}
+
+	ProfilerProbesSet(&data);
+}
+
+#endif /* defined(DIAG_PROFILER) */
+
+/**
+ * @}
+ */
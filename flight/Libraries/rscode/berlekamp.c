@@ -35,290 +35,177 @@
  *
  */
 
-#include <stdio.h>
+#include <string.h>
 #include "ecc.h"
 
-/* The Error Locator Polynomial, also known as Lambda or Sigma. Lambda[0] == 1 */
-static int Lambda[MAXDEG];
+/* Polynomials are arrays of MAXDEG coefficients, lowest power first.
+ * The Error Locator Polynomial is also known as Lambda or Sigma,
+ * Lambda[0] == 1. The Error Evaluator Polynomial is Omega. */
 
-/* The Error Evaluator Polynomial */
-static int Omega[MAXDEG];
-
-/* local ANSI declarations */
-static int compute_discrepancy(int lambda[], int S[], int L, int n);
-static void init_gamma(int gamma[]);
-static void compute_modified_omega (void);
-static void mul_z_poly (int src[]);
-
-/* error locations found using Chien's search*/
-static int ErrorLocs[256];
-static int NErrors;
-
-/* erasure flags */
-static int ErasureLocs[256];
-static int NErasures;
-
-/* From  Cain, Clark, "Error-Correction Coding For Digital Communications", pp. 216. */
-void
-Modified_Berlekamp_Massey (void)
-{	
-  int n, L, L2, k, d, i;
-  int psi[MAXDEG], psi2[MAXDEG], D[MAXDEG];
-  int gamma[MAXDEG];
-	
-  /* initialize Gamma, the erasure locator polynomial */
-  init_gamma(gamma);
-
-  /* initialize to z */
-  copy_poly(D, gamma);
-  mul_z_poly(D);
-	
-  copy_poly(psi, gamma);	
-  k = -1; L = NErasures;
-	
-  for (n = NErasures; n < RS_ECC_NPARITY; n++) {
-	
-    d = compute_discrepancy(psi, synBytes, L, n);
-		
-    if (d != 0) {
-		
-      /* psi2 = psi - d*D */
-      for (i = 0; i < MAXDEG; i++) psi2[i] = psi[i] ^ gmult(d, D[i]);
-		
-		
-      if (L < (n-k)) {
-	L2 = n-k;
-	k = n-L;
-	/* D = scale_poly(ginv(d), psi); */
-	for (i = 0; i < MAXDEG; i++) D[i] = gmult(psi[i], ginv(d));
-	L = L2;
-      }
-			
-      /* psi = psi2 */
-      for (i = 0; i < MAXDEG; i++) psi[i] = psi2[i];
-    }
-		
-    mul_z_poly(D);
-  }
-	
-  for(i = 0; i < MAXDEG; i++) Lambda[i] = psi[i];
-  compute_modified_omega();
-
-	
-}
-
-/* given Psi (called Lambda in Modified_Berlekamp_Massey) and synBytes,
-   compute the combined erasure/error evaluator polynomial as 
-   Psi*S mod z^4
-  */
-void
-compute_modified_omega ()
+/* multiply by z, i.e., shift right by 1 */
+static void mul_z_poly (uint8_t src[])
 {
   int i;
-  int product[MAXDEG*2];
-	
-  mult_polys(product, Lambda, synBytes);	
-  zero_poly(Omega);
-  for(i = 0; i < RS_ECC_NPARITY; i++) Omega[i] = product[i];
-
-}
-
-/* polynomial multiplication */
-void
-mult_polys (int dst[], int p1[], int p2[])
-{
-  int i, j;
-  int tmp1[MAXDEG*2];
-	
-  for (i=0; i < (MAXDEG*2); i++) dst[i] = 0;
-	
-  for (i = 0; i < MAXDEG; i++) {
-    for(j=MAXDEG; j<(MAXDEG*2); j++) tmp1[j]=0;
-		
-    /* scale tmp1 by p1[i] */
-    for(j=0; j<MAXDEG; j++) tmp1[j]=gmult(p2[j], p1[i]);
-    /* and mult (shift) tmp1 right by i */
-    for (j = (MAXDEG*2)-1; j >= i; j--) tmp1[j] = tmp1[j-i];
-    for (j = 0; j < i; j++) tmp1[j] = 0;
-		
-    /* add into partial product */
-    for(j=0; j < (MAXDEG*2); j++) dst[j] ^= tmp1[j];
-  }
+  for (i = MAXDEG-1; i > 0; i--) src[i] = src[i-1];
+  src[0] = 0;
 }
 
-
-	
 /* gamma = product (1-z*a^Ij) for erasure locs Ij */
-void
-init_gamma (int gamma[])
+static void
+init_gamma (uint8_t gamma[], int nerasures, const int erasures[])
 {
-  int e, tmp[MAXDEG];
-	
-  zero_poly(gamma);
-  zero_poly(tmp);
+  int e, i;
+  uint8_t tmp[MAXDEG];
+
+  memset(gamma, 0, MAXDEG);
   gamma[0] = 1;
-	
-  for (e = 0; e < NErasures; e++) {
-    copy_poly(tmp, gamma);
-    scale_poly(gexp[ErasureLocs[e]], tmp);
+
+  for (e = 0; e < nerasures; e++) {
+    for (i = 0; i < MAXDEG; i++) tmp[i] = gexp[glog[gamma[i]] + erasures[e]];
     mul_z_poly(tmp);
-    add_polys(gamma, tmp);
-  }
-}
-	
-	
-	
-void 
-compute_next_omega (int d, int A[], int dst[], int src[])
-{
-  int i;
-  for ( i = 0; i < MAXDEG;  i++) {
-    dst[i] = src[i] ^ gmult(d, A[i]);
+    for (i = 0; i < MAXDEG; i++) gamma[i] ^= tmp[i];
   }
 }
-	
 
-
-int
-compute_discrepancy (int lambda[], int S[], int L, int n)
+static int
+compute_discrepancy (const uint8_t lambda[], const uint8_t S[], int L, int n)
 {
   int i, sum=0;
-	
+
   for (i = 0; i <= L; i++) 
-    sum ^= gmult(lambda[i], S[n-i]);
+    sum ^= gexp[glog[lambda[i]] + glog[S[n-i]]];
   return (sum);
 }
 
-/********** polynomial arithmetic *******************/
-
-void add_polys (int dst[], int src[]) 
-{
-  int i;
-  for (i = 0; i < MAXDEG; i++) dst[i] ^= src[i];
-}
-
-void copy_poly (int dst[], int src[]) 
+/* From  Cain, Clark, "Error-Correction Coding For Digital Communications", pp. 216. */
+static void
+Modified_Berlekamp_Massey (const uint8_t S[], int npar, int nerasures, const int erasures[],
+			   uint8_t Lambda[])
 {
-  int i;
-  for (i = 0; i < MAXDEG; i++) dst[i] = src[i];
-}
+  int n, L, L2, k, d, i;
+  uint8_t psi[MAXDEG], psi2[MAXDEG], D[MAXDEG];
+  uint8_t gamma[MAXDEG];
 
-void scale_poly (int k, int poly[]) 
-{	
-  int i;
-  for (i = 0; i < MAXDEG; i++) poly[i] = gmult(k, poly[i]);
-}
+  /* initialize Gamma, the erasure locator polynomial */
+  init_gamma(gamma, nerasures, erasures);
 
+  /* initialize to z */
+  memcpy(D, gamma, MAXDEG);
+  mul_z_poly(D);
 
-void zero_poly (int poly[]) 
-{
-  int i;
-  for (i = 0; i < MAXDEG; i++) poly[i] = 0;
-}
+  memcpy(psi, gamma, MAXDEG);
+  k = -1; L = nerasures;
 
+  for (n = nerasures; n < npar; n++) {
 
-/* multiply by z, i.e., shift right by 1 */
-static void mul_z_poly (int src[])
-{
-  int i;
-  for (i = MAXDEG-1; i > 0; i--) src[i] = src[i-1];
-  src[0] = 0;
-}
+    d = compute_discrepancy(psi, S, L, n);
 
+    if (d != 0) {
+      uint16_t dlog = glog[d];
 
-/* Finds all the roots of an error-locator polynomial with coefficients
- * Lambda[j] by evaluating Lambda at successive values of alpha. 
- * 
- * This can be tested with the decoder's equations case.
- */
+      /* psi2 = psi - d*D */
+      for (i = 0; i < MAXDEG; i++) psi2[i] = psi[i] ^ gexp[glog[D[i]] + dlog];
 
+      if (L < (n-k)) {
+	L2 = n-k;
+	k = n-L;
+	/* D = scale_poly(ginv(d), psi); */
+	for (i = 0; i < MAXDEG; i++) D[i] = gexp[glog[psi[i]] + 255 - dlog];
+	L = L2;
+      }
 
-void 
-Find_Roots (void)
-{
-  int sum, r, k;	
-  NErrors = 0;
-  
-  for (r = 1; r < 256; r++) {
-    sum = 0;
-    /* evaluate lambda at r */
-    for (k = 0; k < RS_ECC_NPARITY+1; k++) {
-      sum ^= gmult(gexp[(k*r)%255], Lambda[k]);
+      /* psi = psi2 */
+      memcpy(psi, psi2, MAXDEG);
     }
-    if (sum == 0) 
-      { 
-	ErrorLocs[NErrors] = (255-r); NErrors++; 
-	//if (DEBUG) fprintf(stderr, "Root found at r = %d, (255-r) = %d\n", r, (255-r));
-      }
+
+    mul_z_poly(D);
   }
+
+  memcpy(Lambda, psi, MAXDEG);
 }
 
 /* Combined Erasure And Error Magnitude Computation 
  * 
- * Pass in the codeword, its size in bytes, as well as
- * an array of any known erasure locations, along the number
- * of these erasures.
- * 
- * Evaluate Omega(actually Psi)/Lambda' at the roots
- * alpha^(-i) for error locs i. 
+ * Pass in the syndrome and the codeword, its size in bytes, as well as
+ * an array of any known erasure locations, along the number of these
+ * erasures. Erasure locations count from the end of the codeword.
+ *
+ * The roots of Lambda are found with Chien's search, by evaluating it
+ * at successive values of alpha. Only a^r for the locations 255-r
+ * inside the codeword are tried, and the codeword is rejected unless
+ * there are as many roots as the degree of Lambda.
  *
- * Returns 1 if everything ok, or 0 if an out-of-bounds error is found
+ * Omega(actually Psi)/Lambda' is then evaluated at the roots alpha^(-i)
+ * for error locs i. The codeword is only changed if all of it can be
+ * corrected.
  *
+ * Returns the number of bytes corrected, or -1 if the codeword
+ * can't be corrected.
  */
-
 int
-correct_errors_erasures (unsigned char codeword[], 
-			 int csize,
-			 int nerasures,
-			 int erasures[])
+rs_correct (const struct rs_codec *rs, const uint8_t synd[], uint8_t codeword[], uint16_t csize,
+	    int nerasures, const int erasures[])
 {
-  int r, i, j, err;
+  const int npar = rs->nparity;
+  uint8_t Lambda[MAXDEG], Omega[MAXDEG], term[MAXDEG];
+  uint8_t ErrorLocs[RS_ECC_MAX_NPARITY], ErrorVals[RS_ECC_MAX_NPARITY];
+  int NErrors = 0;
+  int deg, r, i, j, k;
+
+  if (csize > 255 || nerasures > npar) return (-1);
+
+  Modified_Berlekamp_Massey(synd, npar, nerasures, erasures, Lambda);
+
+  /* Omega = Lambda*S mod z^npar */
+  memset(Omega, 0, MAXDEG);
+  for (i = 0; i < npar; i++)
+    for (j = 0; j <= i; j++)
+      Omega[i] ^= gexp[glog[Lambda[j]] + glog[synd[i-j]]];
+
+  for (deg = MAXDEG-1; deg > 0 && Lambda[deg] == 0; deg--)
+    ;
+  if (deg == 0 || deg > npar) return (-1);
+
+  /* term[k] = Lambda[k] * a^(k*r), starting with the first location */
+  r = 256 - csize;
+  for (k = 0; k <= deg; k++)
+    term[k] = gexp[glog[Lambda[k]] + (k*r) % 255];
+
+  for (; r < 256; r++) {
+    int sum = 0;
+    for (k = 0; k <= deg; k++) {
+      sum ^= term[k];
+      term[k] = gexp[glog[term[k]] + k];
+    }
+    if (sum == 0) {
+      if (NErrors == deg) return (-1);
+      ErrorLocs[NErrors++] = 255 - r;
+    }
+  }
 
-  /* If you want to take advantage of erasure correction, be sure to
-     set NErasures and ErasureLocs[] with the locations of erasures. 
-     */
-  NErasures = nerasures;
-  for (i = 0; i < NErasures; i++) ErasureLocs[i] = erasures[i];
+  if (NErrors != deg) return (-1);
 
-  Modified_Berlekamp_Massey();
-  Find_Roots();
-  
+  for (r = 0; r < NErrors; r++) {
+    int num, denom;
+    i = ErrorLocs[r];
+    /* evaluate Omega at alpha^(-i) */
 
-  if ((NErrors <= RS_ECC_NPARITY) && NErrors > 0) { 
+    num = 0;
+    for (j = 0; j < npar; j++)
+      num ^= gexp[glog[Omega[j]] + ((255-i)*j) % 255];
 
-    /* first check for illegal error locs */
-    for (r = 0; r < NErrors; r++) {
-      if (ErrorLocs[r] >= csize) {
-				//if (DEBUG) fprintf(stderr, "Error loc i=%d outside of codeword length %d\n", i, csize);
-	return(0);
-      }
-    }
+    /* evaluate Lambda' (derivative) at alpha^(-i) ; all odd powers disappear */
+    denom = 0;
+    for (j = 1; j <= deg; j += 2)
+      denom ^= gexp[glog[Lambda[j]] + ((255-i)*(j-1)) % 255];
 
-    for (r = 0; r < NErrors; r++) {
-      int num, denom;
-      i = ErrorLocs[r];
-      /* evaluate Omega at alpha^(-i) */
-
-      num = 0;
-      for (j = 0; j < MAXDEG; j++) 
-	num ^= gmult(Omega[j], gexp[((255-i)*j)%255]);
-      
-      /* evaluate Lambda' (derivative) at alpha^(-i) ; all odd powers disappear */
-      denom = 0;
-      for (j = 1; j < MAXDEG; j += 2) {
-	denom ^= gmult(Lambda[j], gexp[((255-i)*(j-1)) % 255]);
-      }
-      
-      err = gmult(num, ginv(denom));
-      //if (DEBUG) fprintf(stderr, "Error magnitude %#x at loc %d\n", err, csize-i);
-      
-      codeword[csize-i-1] ^= err;
-    }
-    return(1);
-  }
-  else {
-    //if (DEBUG && NErrors) fprintf(stderr, "Uncorrectable codeword\n");
-    return(0);
+    if (denom == 0) return (-1);
+
+    ErrorVals[r] = gmult(num, ginv(denom));
   }
-}
 
+  for (r = 0; r < NErrors; r++)
+    codeword[csize-ErrorLocs[r]-1] ^= ErrorVals[r];
+
+  return (NErrors);
+}
@@ -46,6 +46,8 @@
 
 
 #include <openpilot.h>
+#include <stdint.h>
+#include <stdbool.h>
 
 #if !defined(TRUE) && !defined(FALSE)
 #define TRUE 1
@@ -57,20 +59,40 @@ typedef unsigned short BIT16;
 
 /* **************************************************************** */
 
+/* Largest number of parity bytes a codec can be set up with. Boards
+ * that only ever use RS_ECC_NPARITY don't need to define it. */
+#if !defined(RS_ECC_MAX_NPARITY)
+#define RS_ECC_MAX_NPARITY RS_ECC_NPARITY
+#endif
+
 /* Maximum degree of various polynomials. */
-#define MAXDEG (RS_ECC_NPARITY*2)
+#define MAXDEG (RS_ECC_MAX_NPARITY*2)
 
-/*************************************/
-/* Encoder parity bytes */
-extern int pBytes[MAXDEG];
+/* A Reed Solomon codec for a given number of parity bytes.
+ *
+ * It is only written by rs_init, so one codec can be shared by any
+ * number of tasks encoding and decoding at the same time. All the
+ * decoder state lives on the stack of the caller.
+ */
+struct rs_codec {
+  uint8_t nparity;
+  /* log of the generator polynomial coefficients below the leading 1 */
+  uint16_t genlog[RS_ECC_MAX_NPARITY];
+};
 
-/* Decoder syndrome bytes */
-extern int synBytes[MAXDEG];
+bool rs_init (struct rs_codec *rs, uint8_t nparity);
+void rs_encode (const struct rs_codec *rs, const uint8_t msg[], uint16_t nbytes, uint8_t parity[]);
+int rs_decode (const struct rs_codec *rs, uint8_t codeword[], uint16_t csize);
 
-/* print debugging info */
-extern int DEBUG;
+/* Decoder building blocks, shared between rs.c and berlekamp.c */
+bool rs_syndromes (const struct rs_codec *rs, const uint8_t codeword[], uint16_t csize, uint8_t synd[]);
+int rs_correct (const struct rs_codec *rs, const uint8_t synd[], uint8_t codeword[], uint16_t csize,
+		int nerasures, const int erasures[]);
 
-/* Reed Solomon encode/decode routines */
+/*************************************/
+/* Reed Solomon encode/decode routines with RS_ECC_NPARITY bytes of
+ * parity. They keep the syndrome of the last decode_data, so unlike
+ * the rs_ functions they may only be used from one task. */
 void initialize_ecc (void);
 int check_syndrome (void);
 void decode_data (unsigned char data[], int nbytes);
@@ -79,9 +101,15 @@ void encode_data (unsigned char msg[], int nbytes, unsigned char dst[]);
 /* CRC-CCITT checksum generator */
 BIT16 crc_ccitt(unsigned char *msg, int len);
 
-/* galois arithmetic tables */
-extern const int gexp[];
-extern const int glog[];
+/* galois arithmetic tables
+ *
+ * glog[0] is GF_LOG_ZERO and every entry of gexp from there on is zero,
+ * so a product is gexp[glog[a] + glog[b]] without testing for zero.
+ */
+#define GF_LOG_ZERO 510
+
+extern const uint8_t gexp[];
+extern const uint16_t glog[];
 
 void init_galois_tables (void);
 int ginv(int elt); 
@@ -90,11 +118,3 @@ int gmult(int a, int b);
 
 /* Error location routines */
 int correct_errors_erasures (unsigned char codeword[], int csize,int nerasures, int erasures[]);
-
-/* polynomial arithmetic */
-void add_polys(int dst[], int src[]) ;
-void scale_poly(int k, int poly[]);
-void mult_polys(int dst[], int p1[], int p2[]);
-
-void copy_poly(int dst[], int src[]);
-void zero_poly(int poly[]);
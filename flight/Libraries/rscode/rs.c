@@ -25,23 +25,12 @@
  * Source code is available at http://rscode.sourceforge.net
  */
 
-#include <stdio.h>
-#include <ctype.h>
+#include <string.h>
 #include "ecc.h"
 
-/* Encoder parity bytes */
-int pBytes[MAXDEG];
-
-/* Decoder syndrome bytes */
-int synBytes[MAXDEG];
-
-/* generator polynomial */
-int genPoly[MAXDEG*2];
-
-int DEBUG = FALSE;
-
-static void
-compute_genpoly (int nbytes, int genpoly[]);
+/* The codec and syndrome behind the single task API */
+static struct rs_codec legacy_codec;
+static uint8_t synBytes[RS_ECC_NPARITY];
 
 /* Initialize lookup tables, polynomials, etc. */
 void
@@ -51,157 +40,174 @@ initialize_ecc ()
     init_galois_tables();
 
     /* Compute the encoder generator polynomial */
-    compute_genpoly(RS_ECC_NPARITY, genPoly);
+    rs_init(&legacy_codec, RS_ECC_NPARITY);
 }
 
-void
-zero_fill_from (unsigned char buf[], int from, int to)
+/* Set up a codec for nparity bytes of parity.
+ *
+ * The generator polynomial is the product of (x + a^n) for n = 1 to
+ * nparity. Its coefficients are kept as logs, so that each tap of the
+ * encoder is a single table lookup.
+ *
+ * Returns false if the number of parity bytes isn't supported.
+ */
+bool
+rs_init (struct rs_codec *rs, uint8_t nparity)
 {
-  int i;
-  for (i = from; i < to; i++) buf[i] = 0;
-}
+  uint8_t genpoly[RS_ECC_MAX_NPARITY+1];
+  int i, j;
 
-/* debugging routines */
-void
-print_parity (void)
-{
-#ifdef NEVER
-  int i;
-  printf("Parity Bytes: ");
-  for (i = 0; i < RS_ECC_NPARITY; i++) 
-    printf("[%d]:%x, ",i,pBytes[i]);
-  printf("\n");
-#endif
-}
+  if (nparity == 0 || nparity > RS_ECC_MAX_NPARITY) return false;
 
+  memset(genpoly, 0, sizeof(genpoly));
+  genpoly[0] = 1;
 
-void
-print_syndrome (void)
-{
-#ifdef NEVER
-  int i;
-  printf("Syndrome Bytes: ");
-  for (i = 0; i < RS_ECC_NPARITY; i++) 
-    printf("[%d]:%x, ",i,synBytes[i]);
-  printf("\n");
-#endif
+  for (i = 1; i <= nparity; i++) {
+    for (j = i; j > 0; j--)
+      genpoly[j] = genpoly[j-1] ^ gmult(genpoly[j], gexp[i]);
+    genpoly[0] = gmult(genpoly[0], gexp[i]);
+  }
+
+  rs->nparity = nparity;
+  for (i = 0; i < nparity; i++)
+    rs->genlog[i] = glog[genpoly[i]];
+
+  return true;
 }
 
-/* Append the parity bytes onto the end of the message */
+/* Simulate a LFSR with the generator polynomial of the codec.
+ * Pass in a pointer to the data array, and amount of data.
+ *
+ * The parity bytes are written to parity[], which may directly
+ * follow the message to make a codeword in place.
+ */
 void
-build_codeword (unsigned char msg[], int nbytes, unsigned char dst[])
+rs_encode (const struct rs_codec *rs, const uint8_t msg[], uint16_t nbytes, uint8_t parity[])
 {
-  int i;
-	
-  for (i = 0; i < nbytes; i++) dst[i] = msg[i];
-	
-  for (i = 0; i < RS_ECC_NPARITY; i++) {
-    dst[i+nbytes] = pBytes[RS_ECC_NPARITY-1-i];
+  const uint8_t n = rs->nparity;
+  uint8_t LFSR[RS_ECC_MAX_NPARITY];
+  int i, j;
+
+  memset(LFSR, 0, n);
+
+  for (i = 0; i < nbytes; i++) {
+    uint16_t fb = glog[msg[i] ^ LFSR[n-1]];
+    for (j = n-1; j > 0; j--)
+      LFSR[j] = LFSR[j-1] ^ gexp[rs->genlog[j] + fb];
+    LFSR[0] = gexp[rs->genlog[0] + fb];
   }
+
+  for (i = 0; i < n; i++)
+    parity[i] = LFSR[n-1-i];
 }
-	
+
 /**********************************************************
  * Reed Solomon Decoder 
  *
- * Computes the syndrome of a codeword. Puts the results
- * into the synBytes[] array.
+ * Computes the syndrome of a codeword, S[j] = c(a^(j+1)), into synd[].
+ *
+ * The message part is divided by the generator with the encoder, and
+ * the remainder of the codeword is the difference to the parity that
+ * was received. It is zero for a clean codeword, which then costs no
+ * more than encoding it. Otherwise the syndromes of the codeword are
+ * those of the remainder, which only has nparity terms.
+ *
+ * Returns true if the codeword has errors.
  */
- 
-void
-decode_data(unsigned char data[], int nbytes)
+bool
+rs_syndromes (const struct rs_codec *rs, const uint8_t codeword[], uint16_t csize, uint8_t synd[])
 {
-  int i, j, sum;
-  for (j = 0; j < RS_ECC_NPARITY;  j++) {
-    sum	= 0;
-    for (i = 0; i < nbytes; i++) {
-      sum = data[i] ^ gmult(gexp[j+1], sum);
+  const uint8_t n = rs->nparity;
+  const uint8_t *rx = codeword;
+  uint8_t rem[RS_ECC_MAX_NPARITY];
+  uint16_t nrem = csize;
+  uint8_t dirty = 0;
+  int i, j;
+
+  if (csize >= n) {
+    rs_encode(rs, codeword, csize - n, rem);
+    for (i = 0; i < n; i++) {
+      rem[i] ^= codeword[csize - n + i];
+      dirty |= rem[i];
     }
-    synBytes[j]  = sum;
+
+    if (!dirty) {
+      memset(synd, 0, n);
+      return false;
+    }
+
+    rx = rem;
+    nrem = n;
   }
-}
 
+  /* Horner's rule, highest power first */
+  for (j = 0; j < n; j++) {
+    uint8_t sum = 0;
+    for (i = 0; i < nrem; i++)
+      sum = rx[i] ^ gexp[glog[sum] + j + 1];
+    synd[j] = sum;
+    dirty |= sum;
+  }
 
-/* Check if the syndrome is zero */
+  return dirty != 0;
+}
+
+/* Check a codeword and correct it in place.
+ *
+ * Returns the number of bytes corrected, zero if the codeword was
+ * clean, or -1 if it has more errors than can be corrected.
+ */
 int
-check_syndrome (void)
+rs_decode (const struct rs_codec *rs, uint8_t codeword[], uint16_t csize)
 {
- int i, nz = 0;
- for (i =0 ; i < RS_ECC_NPARITY; i++) {
-  if (synBytes[i] != 0) {
-      nz = 1;
-      break;
-  }
- }
- return nz;
-}
+  uint8_t synd[RS_ECC_MAX_NPARITY];
 
+  if (!rs_syndromes(rs, codeword, csize, synd))
+    return 0;
 
-void
-debug_check_syndrome (void)
-{	
-#ifdef NEVER
-  int i;
-	
-  for (i = 0; i < 3; i++) {
-    printf(" inv log S[%d]/S[%d] = %d\n", i, i+1, 
-	   glog[gmult(synBytes[i], ginv(synBytes[i+1]))]);
-  }
-#endif
+  return rs_correct(rs, synd, codeword, csize, 0, NULL);
 }
 
+/* Append the parity bytes onto the end of the message */
+void
+encode_data (unsigned char msg[], int nbytes, unsigned char dst[])
+{
+  if (dst != msg)
+    memmove(dst, msg, nbytes);
+
+  rs_encode(&legacy_codec, dst, nbytes, &dst[nbytes]);
+}
 
-/* Create a generator polynomial for an n byte RS code. 
- * The coefficients are returned in the genPoly arg.
- * Make sure that the genPoly array which is passed in is 
- * at least n+1 bytes long.
+/* Computes the syndrome of a codeword. Puts the results
+ * into the synBytes[] array.
  */
+void
+decode_data(unsigned char data[], int nbytes)
+{
+  rs_syndromes(&legacy_codec, data, nbytes, synBytes);
+}
 
-static void
-compute_genpoly (int nbytes, int genpoly[])
+/* Check if the syndrome is zero */
+int
+check_syndrome (void)
 {
-  int i, tp[MAXDEG], tp1[MAXDEG];
-	
-  /* multiply (x + a^n) for n = 1 to nbytes */
-
-  zero_poly(tp1);
-  tp1[0] = 1;
-
-  for (i = 1; i <= nbytes; i++) {
-    zero_poly(tp);
-    tp[0] = gexp[i];		/* set up x+a^n */
-    tp[1] = 1;
-	  
-    mult_polys(genpoly, tp, tp1);
-    copy_poly(tp1, genpoly);
+  int i;
+  for (i = 0; i < RS_ECC_NPARITY; i++) {
+    if (synBytes[i] != 0)
+      return 1;
   }
+  return 0;
 }
 
-/* Simulate a LFSR with generator polynomial for n byte RS code. 
- * Pass in a pointer to the data array, and amount of data. 
+/* Correct the codeword of the last decode_data, see rs_correct.
  *
- * The parity bytes are deposited into pBytes[], and the whole message
- * and parity are copied to dest to make a codeword.
- * 
+ * Returns 1 if everything ok, or 0 if it can't be corrected.
  */
-
-void
-encode_data (unsigned char msg[], int nbytes, unsigned char dst[])
+int
+correct_errors_erasures (unsigned char codeword[], 
+			 int csize,
+			 int nerasures,
+			 int erasures[])
 {
-  int i, LFSR[RS_ECC_NPARITY+1],dbyte, j;
-	
-  for(i=0; i < RS_ECC_NPARITY+1; i++) LFSR[i]=0;
-
-  for (i = 0; i < nbytes; i++) {
-    dbyte = msg[i] ^ LFSR[RS_ECC_NPARITY-1];
-    for (j = RS_ECC_NPARITY-1; j > 0; j--) {
-      LFSR[j] = LFSR[j-1] ^ gmult(genPoly[j], dbyte);
-    }
-    LFSR[0] = gmult(genPoly[0], dbyte);
-  }
-
-  for (i = 0; i < RS_ECC_NPARITY; i++) 
-    pBytes[i] = LFSR[i];
-	
-  build_codeword(msg, nbytes, dst);
+  return rs_correct(&legacy_codec, synBytes, codeword, csize, nerasures, erasures) > 0;
 }
-
@@ -162,6 +162,40 @@ void TaskMonitorUpdateAll(void)
 #endif
 }
 
+/**
+ * Update the scheduling statistics of all tasks
+ */
+void TaskMonitorUpdateProfile(void)
+{
+#if defined(DIAG_PROFILER)
+	TaskProfileData data;
+	struct pios_thread_stats stats;
+
+	PIOS_Mutex_Lock(lock, PIOS_MUTEX_TIMEOUT_MAX);
+
+	// TaskProfile mirrors the TaskInfo task list, never index past either
+	for (int n = 0; n < TASKINFO_RUNNING_NUMELEM && n < TASKPROFILE_WAKEUPLATENCY_NUMELEM; ++n)
+	{
+		if (handles[n] != 0 && PIOS_Thread_Get_Stats(handles[n], &stats))
+		{
+			data.WakeupLatency[n] = (stats.wakeup_latency_avg < UINT16_MAX) ? stats.wakeup_latency_avg : UINT16_MAX;
+			data.WakeupLatencyMax[n] = (stats.wakeup_latency_max < UINT16_MAX) ? stats.wakeup_latency_max : UINT16_MAX;
+			data.Preemptions[n] = (stats.preemptions < UINT16_MAX) ? stats.preemptions : UINT16_MAX;
+		}
+		else
+		{
+			data.WakeupLatency[n] = 0;
+			data.WakeupLatencyMax[n] = 0;
+			data.Preemptions[n] = 0;
+		}
+	}
+
+	TaskProfileSet(&data);
+
+	PIOS_Mutex_Unlock(lock);
+#endif
+}
+
 /**
  * @}
  */
@@ -0,0 +1,342 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       telemetry_bridge.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @brief      Shared runtime of the telemetry bridges to receivers and OSDs
+ *
+ * The bridges run from one thread instead of one task each. The objects
+ * they send are read from snapshots. Slow objects are only read again
+ * after they changed, fast ones are read when a bridge runs, so they don't
+ * post an event for each update. All output goes through a non-blocking
+ * send that drops a frame rather than stall the other bridges, and the
+ * thread sleeps on the port of a bridge that answers requests.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "telemetry_bridge.h"
+#include "pios_thread.h"
+#include "taskmonitor.h"
+
+// Private constants
+#if defined(PIOS_TELEMETRY_BRIDGE_STACK_SIZE)
+#define STACK_SIZE_BYTES PIOS_TELEMETRY_BRIDGE_STACK_SIZE
+#else
+#define STACK_SIZE_BYTES 800
+#endif
+#define TASK_PRIORITY PIOS_THREAD_PRIO_NORMAL
+
+//! Longest sleep, so that the stats are updated in time
+#define MAX_SLEEP_MS    100
+#define STATS_PERIOD_MS 1000
+
+// Private types
+
+//! The last data of an object, shared by all bridges that send it
+struct bridge_snapshot {
+	struct bridge_snapshot *next;
+	UAVObjHandle (*handle)(void);
+	UAVObjHandle obj;		//!< NULL until the object exists
+	bool polled;			//!< read at every refresh, without a change callback
+	volatile bool dirty;
+	uint16_t size;
+	uint8_t data[];
+};
+
+// Private variables
+static struct telemetry_bridge *bridges;
+static struct bridge_snapshot *snapshots;
+static struct telemetry_bridge *rx_bridge;
+static struct pios_thread *taskHandle;
+
+// Private functions
+static void telemetryBridgeTask(void *parameters);
+static struct bridge_snapshot *add_snapshot(UAVObjHandle (*handle)(void), uint16_t size);
+
+/**
+ * Mark the snapshot of an object as stale
+ */
+static void snapshot_changed(UAVObjEvent *ev)
+{
+	for (struct bridge_snapshot *s = snapshots; s != NULL; s = s->next) {
+		if (s->obj == ev->obj)
+			s->dirty = true;
+	}
+}
+
+/**
+ * Read the objects that changed since the last refresh
+ *
+ * Objects that a module creates after the bridges started are picked up
+ * here once they exist. Until then their snapshot stays zeroed.
+ */
+static void refresh_snapshots(void)
+{
+	for (struct bridge_snapshot *s = snapshots; s != NULL; s = s->next) {
+		if (s->obj == NULL) {
+			UAVObjHandle obj = s->handle();
+			if (obj == NULL || UAVObjGetNumBytes(obj) != s->size)
+				continue;
+
+			s->obj = obj;
+			s->dirty = true;
+			if (!s->polled)
+				UAVObjConnectCallback(obj, snapshot_changed, EV_UPDATED | EV_UNPACKED);
+		}
+
+		if (s->polled) {
+			UAVObjGetData(s->obj, s->data);
+		} else if (s->dirty) {
+			// Cleared first, a change while reading marks it again
+			s->dirty = false;
+			UAVObjGetData(s->obj, s->data);
+		}
+	}
+}
+
+static void update_stats(void)
+{
+	BridgeStatsData stats;
+	BridgeStatsGet(&stats);
+
+	for (struct telemetry_bridge *b = bridges; b != NULL; b = b->next) {
+		stats.CpuTime[b->stats_idx] = b->cpu_us * 1000 / STATS_PERIOD_MS;
+		stats.TxRate[b->stats_idx] = b->tx_bytes * 1000 / STATS_PERIOD_MS;
+		stats.RxRate[b->stats_idx] = b->rx_bytes * 1000 / STATS_PERIOD_MS;
+		stats.TxDropped[b->stats_idx] += b->dropped_bytes;
+
+		b->cpu_us = 0;
+		b->tx_bytes = 0;
+		b->rx_bytes = 0;
+		b->dropped_bytes = 0;
+	}
+
+	BridgeStatsSet(&stats);
+}
+
+/**
+ * Add a bridge to the runtime, before TelemetryBridgeStart
+ * \return -1 if the bridge is not valid
+ * \return 0 on success
+ */
+int32_t TelemetryBridgeRegister(struct telemetry_bridge *bridge)
+{
+	if (bridge == NULL || bridge->run == NULL || bridge->stats_idx >= BRIDGESTATS_CPUTIME_NUMELEM)
+		return -1;
+
+	// The thread can only sleep on one port
+	if (bridge->wake_on_rx && rx_bridge != NULL)
+		return -1;
+
+	if (bridges == NULL)
+		BridgeStatsInitialize();
+
+	bridge->next_run = 0;
+	bridge->cpu_us = 0;
+	bridge->tx_bytes = 0;
+	bridge->rx_bytes = 0;
+	bridge->dropped_bytes = 0;
+	bridge->rx_held = false;
+
+	if (bridge->wake_on_rx)
+		rx_bridge = bridge;
+
+	bridge->next = bridges;
+	bridges = bridge;
+
+	return 0;
+}
+
+/**
+ * Start the thread of the bridges, the first call does it
+ * \return -1 if no bridge is registered or the thread can't be created
+ * \return 0 on success
+ */
+int32_t TelemetryBridgeStart(void)
+{
+	if (taskHandle != NULL)
+		return 0;
+
+	if (bridges == NULL)
+		return -1;
+
+	taskHandle = PIOS_Thread_Create(telemetryBridgeTask, "TelemetryBridge",
+			STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
+	if (taskHandle == NULL)
+		return -1;
+
+	TaskMonitorAdd(TASKINFO_RUNNING_TELEMETRYBRIDGES, taskHandle);
+	return 0;
+}
+
+static struct bridge_snapshot *add_snapshot(UAVObjHandle (*handle)(void), uint16_t size)
+{
+	for (struct bridge_snapshot *s = snapshots; s != NULL; s = s->next) {
+		if (s->handle == handle)
+			return s;
+	}
+
+	struct bridge_snapshot *s = PIOS_malloc(sizeof(*s) + size);
+	if (s == NULL)
+		return NULL;
+
+	memset(s, 0, sizeof(*s) + size);
+	s->handle = handle;
+	s->size = size;
+
+	// Published last, the event callback walks the list
+	s->next = snapshots;
+	snapshots = s;
+
+	return s;
+}
+
+/**
+ * Get the snapshot of a slow object, one that changes less often than
+ * the bridges send it
+ *
+ * The snapshot is refreshed by the runtime before the bridges run, so it
+ * must only be read from a bridge. It is zeroed while the object doesn't
+ * exist.
+ *
+ * @param[in] handle the Handle() function of the object
+ * @param[in] size the size of the object data
+ * @return the snapshot data, or NULL if out of memory
+ */
+const void *TelemetryBridgeSnapshot(UAVObjHandle (*handle)(void), uint16_t size)
+{
+	struct bridge_snapshot *s = add_snapshot(handle, size);
+
+	return (s != NULL) ? s->data : NULL;
+}
+
+/**
+ * Get the snapshot of an object updated at the rate of the sensors or
+ * the control loop. It is read whenever a bridge runs instead of posting
+ * a change event for each of its updates.
+ *
+ * @param[in] handle the Handle() function of the object
+ * @param[in] size the size of the object data
+ * @return the snapshot data, or NULL if out of memory
+ */
+const void *TelemetryBridgeSnapshotPolled(UAVObjHandle (*handle)(void), uint16_t size)
+{
+	struct bridge_snapshot *s = add_snapshot(handle, size);
+	if (s == NULL)
+		return NULL;
+
+	// Snapshots are taken before the thread starts, so no callback gets connected
+	s->polled = true;
+
+	return s->data;
+}
+
+/**
+ * Send a frame, if the port has room for all of it
+ * @return true if the frame was queued, false if it was dropped
+ */
+bool TelemetryBridgeSend(struct telemetry_bridge *bridge, const uint8_t *buf, uint16_t len)
+{
+	if (PIOS_COM_SendBufferNonBlocking(bridge->com, buf, len) < 0) {
+		bridge->dropped_bytes += len;
+		return false;
+	}
+
+	bridge->tx_bytes += len;
+	return true;
+}
+
+/**
+ * Read what was received on the port, without waiting
+ * @return the number of bytes read
+ */
+uint16_t TelemetryBridgeReceive(struct telemetry_bridge *bridge, uint8_t *buf, uint16_t len)
+{
+	uint16_t received = 0;
+
+	// The byte that woke the thread comes first
+	if (bridge->rx_held && len > 0) {
+		buf[0] = bridge->rx_byte;
+		bridge->rx_held = false;
+		received = 1;
+	}
+
+	if (len > received)
+		received += PIOS_COM_ReceiveBuffer(bridge->com, buf + received, len - received, 0);
+
+	bridge->rx_bytes += received;
+	return received;
+}
+
+/**
+ * Thread of the bridges. It does not return.
+ */
+static void telemetryBridgeTask(void *parameters)
+{
+	uint32_t stats_due = PIOS_Thread_Systime() + STATS_PERIOD_MS;
+
+	while (1) {
+		uint32_t now = PIOS_Thread_Systime();
+		uint32_t next_wake = now + MAX_SLEEP_MS;
+		bool refreshed = false;
+
+		for (struct telemetry_bridge *b = bridges; b != NULL; b = b->next) {
+			if ((int32_t)(now - b->next_run) >= 0) {
+				if (!refreshed) {
+					refresh_snapshots();
+					refreshed = true;
+				}
+
+				uint32_t raw = PIOS_DELAY_GetRaw();
+				uint32_t delay = b->run(b, now);
+				b->cpu_us += PIOS_DELAY_DiffuS(raw);
+
+				b->next_run = now + (delay > 0 ? delay : 1);
+			}
+
+			if ((int32_t)(b->next_run - next_wake) < 0)
+				next_wake = b->next_run;
+		}
+
+		if ((int32_t)(now - stats_due) >= 0) {
+			update_stats();
+			stats_due += STATS_PERIOD_MS;
+		}
+
+		now = PIOS_Thread_Systime();
+		if ((int32_t)(next_wake - now) <= 0)
+			continue;
+
+		if (rx_bridge != NULL && !rx_bridge->rx_held) {
+			// Wait for the next request, or until a bridge is due
+			if (PIOS_COM_ReceiveBuffer(rx_bridge->com, &rx_bridge->rx_byte, 1, next_wake - now) == 1) {
+				rx_bridge->rx_held = true;
+				rx_bridge->next_run = PIOS_Thread_Systime();
+			}
+		} else {
+			PIOS_Thread_Sleep(next_wake - now);
+		}
+	}
+}
+
+/**
+ * @}
+ */
@@ -49,6 +49,7 @@
 #include "pios_thread.h"
 #include "pios_queue.h"
 #include "misc_math.h"
+#include "profiler.h"
 
 // Private constants
 #define MAX_QUEUE_SIZE 2
@@ -259,6 +260,8 @@ static void actuatorTask(void* parameters)
 			continue;
 		}
 
+		PROFILE_BEGIN(PROFILER_PROBE_ACTUATOR);
+
 		// Check how long since last update
 		thisSysTime = PIOS_Thread_Systime();
 		if(thisSysTime > lastSysTime) // reuse dt in case of wraparound
@@ -449,6 +452,7 @@ static void actuatorTask(void* parameters)
 			AlarmsSet(SYSTEMALARMS_ALARM_ACTUATOR, SYSTEMALARMS_ALARM_CRITICAL);
 		}
 
+		PROFILE_END(PROFILER_PROBE_ACTUATOR);
 	}
 }
 
@@ -54,6 +54,8 @@
 #include "physical_constants.h"
 #include "coordinate_conversions.h"
 #include "WorldMagModel.h"
+#include "complementary_filter.h"
+#include "profiler.h"
 
 // UAVOs
 #include "accels.h"
@@ -389,6 +391,8 @@ static void AttitudeTask(void *parameters)
 		if(ret_val == 0)
 			first_run = false;
 
+		PROFILE_END(PROFILER_PROBE_ATTITUDE);
+
 		PIOS_WDG_UpdateFlag(PIOS_WDG_ATTITUDE);
 	}
 }
@@ -429,6 +433,9 @@ static int32_t updateAttitudeComplementary(bool first_run, bool secondary, bool
 				return -1;
 			}
 		}
+
+		// The primary filter times the estimation from here, after the wait
+		PROFILE_BEGIN(PROFILER_PROBE_ATTITUDE);
 	}
 
 	AccelsGet(&accelsData);
@@ -585,37 +592,15 @@ static int32_t updateAttitudeComplementary(bool first_run, bool secondary, bool
 	// Apply smoothing to accel values, to reduce vibration noise before main calculations.
 	apply_accel_filter(&accelsData.x,accels_filtered);
 
-	// Rotate gravity to body frame and cross with accels
-	grot[0] = -(2 * (cf_q[1] * cf_q[3] - cf_q[0] * cf_q[2]));
-	grot[1] = -(2 * (cf_q[2] * cf_q[3] + cf_q[0] * cf_q[1]));
-	grot[2] = -(cf_q[0]*cf_q[0] - cf_q[1]*cf_q[1] - cf_q[2]*cf_q[2] + cf_q[3]*cf_q[3]);
-	CrossProduct((const float *) &accelsData.x, (const float *) grot, accel_err);
+	// Rotate gravity to body frame
+	cf_gravity_body(cf_q, grot);
 
 	// Apply same filtering to the rotated attitude to match delays
 	apply_accel_filter(grot,grot_filtered);
 
 	// Compute the error between the predicted direction of gravity and smoothed acceleration
-	CrossProduct((const float *) accels_filtered, (const float *) grot_filtered, accel_err);
-
-	float grot_mag;
-	if (complementary_filter_state.accel_filter_enabled)
-		grot_mag = sqrtf(grot_filtered[0]*grot_filtered[0] + grot_filtered[1]*grot_filtered[1] + grot_filtered[2]*grot_filtered[2]);
-	else
-		grot_mag = 1.0f;
-
-	// Account for accel magnitude
-	float accel_mag;
-	accel_mag = accels_filtered[0]*accels_filtered[0] + accels_filtered[1]*accels_filtered[1] + accels_filtered[2]*accels_filtered[2];
-	accel_mag = sqrtf(accel_mag);
-	if (grot_mag > 1.0e-3f && accel_mag > 1.0e-3f) {
-		accel_err[0] /= (accel_mag * grot_mag);
-		accel_err[1] /= (accel_mag * grot_mag);
-		accel_err[2] /= (accel_mag * grot_mag);
-	} else {
-		accel_err[0] = 0;
-		accel_err[1] = 0;
-		accel_err[2] = 0;
-	}
+	cf_accel_error(accels_filtered, grot_filtered,
+	               complementary_filter_state.accel_filter_enabled, accel_err);
 
 	float mag_err[3];
 	if (secondary || PIOS_Queue_Receive(magQueue, &ev, 0) == true)
@@ -623,42 +608,10 @@ static int32_t updateAttitudeComplementary(bool first_run, bool secondary, bool
 		MagnetometerData mag;
 		MagnetometerGet(&mag);
 
-		// Only use the magnetometer data if it is good, i.e. not NAN. A NAN would
-		// normally only arise due to a bad magnetometer calibration.
-		if  (!(IS_NOT_FINITE(mag.x) || IS_NOT_FINITE(mag.y) || IS_NOT_FINITE(mag.z))) {
-			float bmag = 1.0f;
-			float brot[3];
-			float Rbe[3][3];
-
-			// Get rotation to bring earth magnetic field into body frame		
-			Quaternion2R(cf_q, Rbe);
-
-			if (homeLocation.Set == HOMELOCATION_SET_TRUE) {
-				rot_mult(Rbe, homeLocation.Be, brot, false);
-				bmag = sqrtf(brot[0] * brot[0] + brot[1] * brot[1] + brot[2] * brot[2]);
-				brot[0] /= bmag;
-				brot[1] /= bmag;
-				brot[2] /= bmag;
-			} else {
-				const float Be[3] = {1.0f, 0.0f, 0.0f};
-				rot_mult(Rbe, Be, brot, false);
-			}
-
-			float mag_len = sqrtf(mag.x * mag.x + mag.y * mag.y + mag.z * mag.z);
-			mag.x /= mag_len;
-			mag.y /= mag_len;
-			mag.z /= mag_len;
-
-			// Only compute if neither vector is null
-			if (bmag < 1 || mag_len < 1)
-				mag_err[0] = mag_err[1] = mag_err[2] = 0;
-			else
-				CrossProduct((const float *) &mag.x, (const float *) brot, mag_err);
-
-			if (mag_err[2] != mag_err[2])
-				mag_err[2] = 0;
-		} else
-			mag_err[2] = 0;
+		if (homeLocation.Set == HOMELOCATION_SET_TRUE)
+			mag_err[2] = cf_mag_yaw_error(cf_q, &mag.x, homeLocation.Be);
+		else
+			mag_err[2] = cf_mag_yaw_error(cf_q, &mag.x, NULL);
 	} else {
 		mag_err[2] = 0;
 	}
@@ -676,43 +629,8 @@ static int32_t updateAttitudeComplementary(bool first_run, bool secondary, bool
 	gyrosData.y += accel_err[1] * attitudeSettings.AccelKp / dT;
 	gyrosData.z += accel_err[2] * attitudeSettings.AccelKp / dT + mag_err[2] * attitudeSettings.MagKp / dT;
 
-	// Work out time derivative from INSAlgo writeup
-	// Also accounts for the fact that gyros are in deg/s
-	float qdot[4];
-	qdot[0] = (-cf_q[1] * gyrosData.x - cf_q[2] * gyrosData.y - cf_q[3] * gyrosData.z) * dT * DEG2RAD / 2;
-	qdot[1] = (cf_q[0] * gyrosData.x - cf_q[3] * gyrosData.y + cf_q[2] * gyrosData.z) * dT * DEG2RAD / 2;
-	qdot[2] = (cf_q[3] * gyrosData.x + cf_q[0] * gyrosData.y - cf_q[1] * gyrosData.z) * dT * DEG2RAD / 2;
-	qdot[3] = (-cf_q[2] * gyrosData.x + cf_q[1] * gyrosData.y + cf_q[0] * gyrosData.z) * dT * DEG2RAD / 2;
-
 	// Take a time step
-	cf_q[0] = cf_q[0] + qdot[0];
-	cf_q[1] = cf_q[1] + qdot[1];
-	cf_q[2] = cf_q[2] + qdot[2];
-	cf_q[3] = cf_q[3] + qdot[3];
-
-	if(cf_q[0] < 0) {
-		cf_q[0] = -cf_q[0];
-		cf_q[1] = -cf_q[1];
-		cf_q[2] = -cf_q[2];
-		cf_q[3] = -cf_q[3];
-	}
-
-	// Renomalize
-	float qmag;
-	qmag = sqrtf(cf_q[0]*cf_q[0] + cf_q[1]*cf_q[1] + cf_q[2]*cf_q[2] + cf_q[3]*cf_q[3]);
-	cf_q[0] = cf_q[0] / qmag;
-	cf_q[1] = cf_q[1] / qmag;
-	cf_q[2] = cf_q[2] / qmag;
-	cf_q[3] = cf_q[3] / qmag;
-
-	// If quaternion has become inappropriately short or has become Nan reinit.
-	// THIS SHOULD NEVER ACTUALLY HAPPEN
-	if((fabsf(qmag) < 1.0e-3f) || IS_NOT_FINITE(qmag)) {
-		cf_q[0] = 1;
-		cf_q[1] = 0;
-		cf_q[2] = 0;
-		cf_q[3] = 0;
-	}
+	cf_integrate_attitude(cf_q, &gyrosData.x, dT);
 
 	if (!secondary) {
 
@@ -1025,6 +943,8 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 		return -1;
 	}
 
+	PROFILE_BEGIN(PROFILER_PROBE_ATTITUDE);
+
 	// Get most recent data
 	GyrosGet(&gyrosData);
 	AccelsGet(&accelsData);
@@ -1450,8 +1370,9 @@ static void check_home_location()
 		// Compute home ECEF coordinates and the rotation matrix into NED
 		double LLA[3] = { ((double)homeLocation.Latitude) / 10e6, ((double)homeLocation.Longitude) / 10e6, ((double)homeLocation.Altitude) };
 
-		// Compute magnetic flux direction at home location
-		if (WMM_GetMagVector(LLA[0], LLA[1], LLA[2], gpsTime.Month, gpsTime.Day, gpsTime.Year, &homeLocation.Be[0]) >= 0)
+		// Compute magnetic flux direction at home location. A home set again close
+		// to the last one is answered from the cached linearization of the model.
+		if (WMM_GetMagVectorCached(LLA[0], LLA[1], LLA[2], gpsTime.Month, gpsTime.Day, gpsTime.Year, &homeLocation.Be[0]) >= 0)
 		{   // calculations appeared to go OK
 
 			// Compute local acceleration due to gravity.  Vehicles that span a very large
@@ -0,0 +1,183 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup AttitudeModule Attitude and state estimation module
+ * @{
+ *
+ * @file       complementary_filter.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @brief      Math of the complementary attitude filter
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ ******************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <math.h>
+#include <stddef.h>
+#include "misc_math.h"
+#include "physical_constants.h"
+#include "coordinate_conversions.h"
+#include "complementary_filter.h"
+
+/**
+ * Rotate gravity into the body frame
+ * @param[in] q the current attitude
+ * @param[out] grot the predicted (unit) direction of the measured acceleration
+ */
+void cf_gravity_body(const float q[4], float grot[3])
+{
+	grot[0] = -(2 * (q[1] * q[3] - q[0] * q[2]));
+	grot[1] = -(2 * (q[2] * q[3] + q[0] * q[1]));
+	grot[2] = -(q[0]*q[0] - q[1]*q[1] - q[2]*q[2] + q[3]*q[3]);
+}
+
+/**
+ * Compute the error between the predicted direction of gravity and the
+ * measured acceleration, normalized by the magnitude of both.
+ * @param[in] accels the (optionally filtered) accelerometer
+ * @param[in] grot the (optionally filtered) predicted gravity
+ * @param[in] scale_grot account for the magnitude of grot, which is only
+ *            not unity when it has been filtered
+ * @param[out] accel_err the error in the body frame
+ */
+void cf_accel_error(const float accels[3], const float grot[3], bool scale_grot, float accel_err[3])
+{
+	CrossProduct(accels, grot, accel_err);
+
+	float grot_mag;
+	if (scale_grot)
+		grot_mag = sqrtf(grot[0]*grot[0] + grot[1]*grot[1] + grot[2]*grot[2]);
+	else
+		grot_mag = 1.0f;
+
+	// Account for accel magnitude
+	float accel_mag;
+	accel_mag = accels[0]*accels[0] + accels[1]*accels[1] + accels[2]*accels[2];
+	accel_mag = sqrtf(accel_mag);
+	if (grot_mag > 1.0e-3f && accel_mag > 1.0e-3f) {
+		accel_err[0] /= (accel_mag * grot_mag);
+		accel_err[1] /= (accel_mag * grot_mag);
+		accel_err[2] /= (accel_mag * grot_mag);
+	} else {
+		accel_err[0] = 0;
+		accel_err[1] = 0;
+		accel_err[2] = 0;
+	}
+}
+
+/**
+ * Compute the yaw error from the magnetometer
+ * @param[in] q the current attitude
+ * @param[in] mag the magnetometer measurement in the body frame
+ * @param[in] Be the earth magnetic field or NULL to assume pointing north
+ * @return the z component of the error, or zero if it cannot be computed
+ */
+float cf_mag_yaw_error(const float q[4], const float mag[3], const float Be[3])
+{
+	// Only use the magnetometer data if it is good, i.e. not NAN. A NAN would
+	// normally only arise due to a bad magnetometer calibration.
+	if (IS_NOT_FINITE(mag[0]) || IS_NOT_FINITE(mag[1]) || IS_NOT_FINITE(mag[2]))
+		return 0;
+
+	float bmag = 1.0f;
+	float brot[3];
+	float Rbe[3][3];
+	float q_copy[4] = {q[0], q[1], q[2], q[3]};
+
+	// Get rotation to bring earth magnetic field into body frame
+	Quaternion2R(q_copy, Rbe);
+
+	if (Be != NULL) {
+		rot_mult(Rbe, Be, brot, false);
+		bmag = sqrtf(brot[0] * brot[0] + brot[1] * brot[1] + brot[2] * brot[2]);
+		brot[0] /= bmag;
+		brot[1] /= bmag;
+		brot[2] /= bmag;
+	} else {
+		const float north[3] = {1.0f, 0.0f, 0.0f};
+		rot_mult(Rbe, north, brot, false);
+	}
+
+	float mag_len = sqrtf(mag[0] * mag[0] + mag[1] * mag[1] + mag[2] * mag[2]);
+	float mag_unit[3] = {mag[0] / mag_len, mag[1] / mag_len, mag[2] / mag_len};
+
+	// Only compute if neither vector is null
+	if (bmag < 1 || mag_len < 1)
+		return 0;
+
+	float mag_err[3];
+	CrossProduct(mag_unit, brot, mag_err);
+
+	if (mag_err[2] != mag_err[2])
+		return 0;
+
+	return mag_err[2];
+}
+
+/**
+ * Take a time step of the attitude quaternion
+ * @param[in,out] q the attitude, renormalized on exit
+ * @param[in] gyros the corrected rates in deg/s
+ * @param[in] dT the time step in seconds
+ */
+void cf_integrate_attitude(float q[4], const float gyros[3], float dT)
+{
+	// Work out time derivative from INSAlgo writeup
+	// Also accounts for the fact that gyros are in deg/s
+	float qdot[4];
+	qdot[0] = (-q[1] * gyros[0] - q[2] * gyros[1] - q[3] * gyros[2]) * dT * DEG2RAD / 2;
+	qdot[1] = (q[0] * gyros[0] - q[3] * gyros[1] + q[2] * gyros[2]) * dT * DEG2RAD / 2;
+	qdot[2] = (q[3] * gyros[0] + q[0] * gyros[1] - q[1] * gyros[2]) * dT * DEG2RAD / 2;
+	qdot[3] = (-q[2] * gyros[0] + q[1] * gyros[1] + q[0] * gyros[2]) * dT * DEG2RAD / 2;
+
+	// Take a time step
+	q[0] = q[0] + qdot[0];
+	q[1] = q[1] + qdot[1];
+	q[2] = q[2] + qdot[2];
+	q[3] = q[3] + qdot[3];
+
+	if(q[0] < 0) {
+		q[0] = -q[0];
+		q[1] = -q[1];
+		q[2] = -q[2];
+		q[3] = -q[3];
+	}
+
+	// Renomalize
+	float qmag;
+	qmag = sqrtf(q[0]*q[0] + q[1]*q[1] + q[2]*q[2] + q[3]*q[3]);
+	q[0] = q[0] / qmag;
+	q[1] = q[1] / qmag;
+	q[2] = q[2] / qmag;
+	q[3] = q[3] / qmag;
+
+	// If quaternion has become inappropriately short or has become Nan reinit.
+	// THIS SHOULD NEVER ACTUALLY HAPPEN
+	if((fabsf(qmag) < 1.0e-3f) || IS_NOT_FINITE(qmag)) {
+		q[0] = 1;
+		q[1] = 0;
+		q[2] = 0;
+		q[3] = 0;
+	}
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,55 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup AttitudeModule Attitude and state estimation module
+ * @{
+ *
+ * @file       complementary_filter.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @brief      Math of the complementary attitude filter
+ *
+ * These functions carry no state and touch no UAVObjects so the same code
+ * can be run by the attitude module and by the host side estimator replay.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef COMPLEMENTARY_FILTER_H
+#define COMPLEMENTARY_FILTER_H
+
+#include "stdbool.h"
+
+//! Direction of gravity in the body frame predicted from the attitude
+void cf_gravity_body(const float q[4], float grot[3]);
+
+//! Normalized error between the measured and predicted gravity
+void cf_accel_error(const float accels[3], const float grot[3], bool scale_grot, float accel_err[3]);
+
+//! Yaw error between the measured and predicted magnetic field
+float cf_mag_yaw_error(const float q[4], const float mag[3], const float Be[3]);
+
+//! Propagate the attitude by the corrected rates (deg/s) over dT
+void cf_integrate_attitude(float q[4], const float gyros[3], float dT);
+
+#endif /* COMPLEMENTARY_FILTER_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -82,6 +82,7 @@
 static bool module_enabled = false;
 static struct pios_thread *pathfollowerTaskHandle;
 static PathDesiredData pathDesired;
+static struct path_segment pathSegment;
 static PathStatusData pathStatus;
 static FixedWingPathFollowerSettingsData fixedwingpathfollowerSettings;
 static FixedWingAirspeedsData fixedWingAirspeeds;
@@ -337,7 +338,8 @@ static void updatePathVelocity()
 	float cur[3] = {positionActual.North, positionActual.East, positionActual.Down};
 	struct path_status progress;
 
-	path_progress(&pathDesired, cur, &progress);
+	path_segment_update(&pathSegment, &pathDesired);
+	path_segment_progress(&pathSegment, cur, &progress);
 	
 	float groundspeed = 0;
 	float altitudeSetpoint = 0;
@@ -62,11 +62,14 @@ static void updateSettings();
 #define GPS_TIMEOUT_MS                  750
 #define GPS_COM_TIMEOUT_MS              100
 
+//! Bytes taken from the port at once and parsed as a chunk
+#define GPS_READ_BUFFER_LENGTH          32
+
 
 #if defined(PIOS_GPS_MINIMAL)
-	#define STACK_SIZE_BYTES            500
+	#define STACK_SIZE_BYTES            532
 #else
-	#define STACK_SIZE_BYTES            850
+	#define STACK_SIZE_BYTES            882
 #endif // PIOS_GPS_MINIMAL
 
 #define TASK_PRIORITY                   PIOS_THREAD_PRIO_LOW
@@ -253,21 +256,22 @@ static void gpsTask(void *parameters)
 			continue;
 		}
 
-		uint8_t c;
+		uint8_t c[GPS_READ_BUFFER_LENGTH];
+		uint16_t received;
 
 		// This blocks the task until there is something on the buffer
-		while (PIOS_COM_ReceiveBuffer(gpsPort, &c, 1, xDelay) > 0)
+		while ((received = PIOS_COM_ReceiveBuffer(gpsPort, c, sizeof(c), xDelay)) > 0)
 		{
 			int res;
 			switch (gpsProtocol) {
 #if defined(PIOS_INCLUDE_GPS_NMEA_PARSER)
 				case MODULESETTINGS_GPSDATAPROTOCOL_NMEA:
-					res = parse_nmea_stream (c,gps_rx_buffer, &gpsposition, &gpsRxStats);
+					res = parse_nmea_stream (c, received, gps_rx_buffer, &gpsposition, &gpsRxStats);
 					break;
 #endif
 #if defined(PIOS_INCLUDE_GPS_UBX_PARSER)
 				case MODULESETTINGS_GPSDATAPROTOCOL_UBX:
-					res = parse_ubx_stream (c,gps_rx_buffer, &gpsposition, &gpsRxStats);
+					res = parse_ubx_stream (c, received, gps_rx_buffer, &gpsposition, &gpsRxStats);
 					break;
 #endif
 				default:
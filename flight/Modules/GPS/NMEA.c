@@ -107,12 +107,12 @@ const static struct nmea_parser nmea_parsers[] = {
 #endif //PIOS_GPS_MINIMAL
 };
 
-int parse_nmea_stream (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
-{
-	static uint8_t rx_count = 0;
-	static bool start_flag = false;
-	static bool found_cr = false;
+static uint8_t rx_count = 0;
+static bool start_flag = false;
+static bool found_cr = false;
 
+static int parse_nmea_char (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
+{
 	// detect start while acquiring stream
 	if (!start_flag && (c == '$')) // NMEA identifier found
 	{
@@ -189,6 +189,30 @@ int parse_nmea_stream (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData,
 	return PARSER_INCOMPLETE;
 }
 
+// parse a chunk of the incoming stream for NMEA sentences
+
+int parse_nmea_stream (const uint8_t *rx, uint16_t len, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
+{
+	int ret = PARSER_INCOMPLETE;
+	bool completed = false;
+
+	for (uint16_t i = 0; i < len; i++) {
+		if (!start_flag) {
+			// skip everything up to the next sentence at once
+			const uint8_t *start = memchr(&rx[i], '$', len - i);
+			if (start == NULL)
+				return completed ? PARSER_COMPLETE : PARSER_ERROR;
+			i = start - rx;
+		}
+
+		ret = parse_nmea_char(rx[i], gps_rx_buffer, GpsData, gpsRxStats);
+		if (ret == PARSER_COMPLETE)
+			completed = true;
+	}
+
+	return completed ? PARSER_COMPLETE : ret;
+}
+
 const static struct nmea_parser *NMEA_find_parser_by_prefix(const char *prefix)
 {
 	if (!prefix) {
@@ -267,7 +291,7 @@ static bool NMEA_parse_real(int32_t * whole, uint32_t * fract, uint8_t * fract_u
 
 	*whole = strtol(field_w, NULL, 10);
 
-	if (field_w) {
+	if (field_f) {
 		/* decimal was found so we may have a fractional part */
 		*fract = strtoul(field_f, NULL, 10);
 		*fract_units = strlen(field_f);
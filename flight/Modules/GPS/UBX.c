@@ -38,12 +38,17 @@
 
 static uint32_t parse_errors;
 
+#if !defined(PIOS_GPS_MINIMAL)
+// Once NAV-PVT is received the per-topic NAV messages are ignored
+static bool pvt_received;
+#endif
+
 static bool checksum_ubx_message(const struct UBXPacket *);
 static uint32_t parse_ubx_message(const struct UBXPacket *, GPSPositionData *);
 
-// parse incoming character stream for messages in UBX binary format
+// parse a chunk of the incoming stream for messages in UBX binary format
 
-int parse_ubx_stream (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
+int parse_ubx_stream (const uint8_t *rx, uint16_t len, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
 {
 	enum proto_states {
 		START,
@@ -55,80 +60,94 @@ int parse_ubx_stream (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData,
 		UBX_PAYLOAD,
 		UBX_CHK1,
 		UBX_CHK2,
-		FINISHED
 	};
 
 	static enum proto_states proto_state = START;
 	static uint16_t rx_count = 0;
 	struct UBXPacket *ubx = (struct UBXPacket *)gps_rx_buffer;
-
-	switch (proto_state) {
-		case START: // detect protocol
-			if (c ==  UBX_SYNC1) // first UBX sync char found
+	bool completed = false;
+
+	for (uint16_t i = 0; i < len; i++) {
+		uint8_t c = rx[i];
+
+		switch (proto_state) {
+			case START: // detect protocol
+			{
+				// skip everything up to the first UBX sync char at once
+				const uint8_t *sync = memchr(&rx[i], UBX_SYNC1, len - i);
+				if (sync == NULL) {
+					i = len;
+					break;
+				}
+				i = sync - rx;
 				proto_state = UBX_SY2;
-			break;
-		case UBX_SY2:
-			if (c == UBX_SYNC2) // second UBX sync char found
-				proto_state = UBX_CLASS;
-			else
-				proto_state = START; // reset state
-			break;
-		case UBX_CLASS:
-			ubx->header.class = c;
-			proto_state = UBX_ID;
-			break;
-		case UBX_ID:
-			ubx->header.id = c;
-			proto_state = UBX_LEN1;
-			break;
-		case UBX_LEN1:
-			ubx->header.len = c;
-			proto_state = UBX_LEN2;
-			break;
-		case UBX_LEN2:
-			ubx->header.len += (c << 8);
-			if (ubx->header.len > sizeof(UBXPayload)) {
-				gpsRxStats->gpsRxOverflow++;
-				proto_state = START;
-			} else {
-				rx_count = 0;
-				proto_state = UBX_PAYLOAD;
+				break;
 			}
-			break;
-		case UBX_PAYLOAD:
-			if (rx_count < ubx->header.len) {
-				ubx->payload.payload[rx_count] = c;
-				if (++rx_count == ubx->header.len)
+			case UBX_SY2:
+				if (c == UBX_SYNC2) // second UBX sync char found
+					proto_state = UBX_CLASS;
+				else
+					proto_state = START; // reset state
+				break;
+			case UBX_CLASS:
+				ubx->header.class = c;
+				proto_state = UBX_ID;
+				break;
+			case UBX_ID:
+				ubx->header.id = c;
+				proto_state = UBX_LEN1;
+				break;
+			case UBX_LEN1:
+				ubx->header.len = c;
+				proto_state = UBX_LEN2;
+				break;
+			case UBX_LEN2:
+				ubx->header.len += (c << 8);
+				if (ubx->header.len > sizeof(UBXPayload)) {
+					gpsRxStats->gpsRxOverflow++;
+					proto_state = START;
+				} else if (ubx->header.len == 0) {
 					proto_state = UBX_CHK1;
-			} else {
-				gpsRxStats->gpsRxOverflow++;
-				proto_state = START;
+				} else {
+					rx_count = 0;
+					proto_state = UBX_PAYLOAD;
+				}
+				break;
+			case UBX_PAYLOAD:
+			{
+				// copy as much of the payload as this chunk holds
+				uint16_t count = ubx->header.len - rx_count;
+				if (count > len - i)
+					count = len - i;
+				memcpy(&ubx->payload.payload[rx_count], &rx[i], count);
+				rx_count += count;
+				i += count - 1;
+				if (rx_count == ubx->header.len)
+					proto_state = UBX_CHK1;
+				break;
 			}
-			break;
-		case UBX_CHK1:
-			ubx->header.ck_a = c;
-			proto_state = UBX_CHK2;
-			break;
-		case UBX_CHK2:
-			ubx->header.ck_b = c;
-			if (checksum_ubx_message(ubx)) { // message complete and valid
-				parse_ubx_message(ubx, GpsData);
-				proto_state = FINISHED;
-			} else {
-				gpsRxStats->gpsRxChkSumError++;
+			case UBX_CHK1:
+				ubx->header.ck_a = c;
+				proto_state = UBX_CHK2;
+				break;
+			case UBX_CHK2:
+				ubx->header.ck_b = c;
+				if (checksum_ubx_message(ubx)) { // message complete and valid
+					parse_ubx_message(ubx, GpsData);
+					gpsRxStats->gpsRxReceived++;
+					completed = true;
+				} else {
+					gpsRxStats->gpsRxChkSumError++;
+				}
 				proto_state = START;
-			}
-			break;
-		default: break;
+				break;
+		}
 	}
 
-	if (proto_state == START)
-		return PARSER_ERROR;	// parser couldn't use this byte
-	else if (proto_state == FINISHED) {
-		gpsRxStats->gpsRxReceived++;
-		proto_state = START;
-		return PARSER_COMPLETE;	// message complete & processed
-	}
+	if (completed)
+		return PARSER_COMPLETE;	// at least one message complete & processed
+	else if (proto_state == START)
+		return PARSER_ERROR;	// parser couldn't use these bytes
 
 	return PARSER_INCOMPLETE; // message not (yet) complete
 }
@@ -260,6 +279,70 @@ static void parse_ubx_nav_velned (const struct UBX_NAV_VELNED *velned, GPSPositi
 	}
 }
 
+#if !defined(PIOS_GPS_MINIMAL)
+static void parse_ubx_nav_pvt (const struct UBX_NAV_PVT *pvt, uint16_t len, GPSPositionData *GpsPosition)
+{
+	if (len < UBX_NAV_PVT_MIN_LEN)
+		return;
+
+	pvt_received = true;
+
+	GpsPosition->Satellites = pvt->numSV;
+	GpsPosition->PDOP = (float)pvt->pDOP * 0.01f;
+
+	if (pvt->flags & PVT_FLAGS_GNSSFIX_OK) {
+		switch (pvt->fixType) {
+			case STATUS_GPSFIX_2DFIX:
+				GpsPosition->Status = GPSPOSITION_STATUS_FIX2D;
+				break;
+			case STATUS_GPSFIX_3DFIX:
+				GpsPosition->Status = (pvt->flags & PVT_FLAGS_DIFFSOLN) ?
+					GPSPOSITION_STATUS_DIFF3D : GPSPOSITION_STATUS_FIX3D;
+				break;
+			default: GpsPosition->Status = GPSPOSITION_STATUS_NOFIX;
+		}
+	}
+	else // fix is not valid so we make sure to treat is as NOFIX
+		GpsPosition->Status = GPSPOSITION_STATUS_NOFIX;
+
+	if (GpsPosition->Status != GPSPOSITION_STATUS_NOFIX) {
+		GPSVelocityData GpsVelocity;
+
+		GpsPosition->Altitude = (float)pvt->hMSL*0.001f;
+		GpsPosition->GeoidSeparation = (float)(pvt->height - pvt->hMSL)*0.001f;
+		GpsPosition->Latitude = pvt->lat;
+		GpsPosition->Longitude = pvt->lon;
+		GpsPosition->Groundspeed = (float)pvt->gSpeed * 0.001f;
+		GpsPosition->Heading = (float)pvt->headMot * 1.0e-5f;
+		// 3D accuracy like NAV-SOL reports it
+		GpsPosition->Accuracy = sqrtf((float)pvt->hAcc * pvt->hAcc + (float)pvt->vAcc * pvt->vAcc) * 0.001f;
+
+		GpsVelocity.North	= (float)pvt->velN * 0.001f;
+		GpsVelocity.East	= (float)pvt->velE * 0.001f;
+		GpsVelocity.Down	= (float)pvt->velD * 0.001f;
+		GpsVelocity.Accuracy	= (float)pvt->sAcc * 0.001f;
+		GPSVelocitySet(&GpsVelocity);
+	}
+
+	// Only update the time once a second, like NAV-TIMEUTC is enabled
+	static uint8_t last_sec = 0xff;
+	if ((pvt->valid & (PVT_VALID_DATE | PVT_VALID_TIME)) == (PVT_VALID_DATE | PVT_VALID_TIME) &&
+			pvt->sec != last_sec) {
+		GPSTimeData GpsTime;
+
+		GpsTime.Year = pvt->year;
+		GpsTime.Month = pvt->month;
+		GpsTime.Day = pvt->day;
+		GpsTime.Hour = pvt->hour;
+		GpsTime.Minute = pvt->min;
+		GpsTime.Second = pvt->sec;
+
+		GPSTimeSet(&GpsTime);
+		last_sec = pvt->sec;
+	}
+}
+#endif
+
 #if !defined(PIOS_GPS_MINIMAL)
 static void parse_ubx_nav_timeutc (const struct UBX_NAV_TIMEUTC *timeutc)
 {
@@ -361,23 +444,39 @@ static void parse_ubx_mon_ver (const struct UBX_MON_VER *version_info)
 static uint32_t parse_ubx_message (const struct UBXPacket *ubx, GPSPositionData *GpsPosition)
 {
 	uint32_t id = 0;
+	bool legacy = true;
+
+#if !defined(PIOS_GPS_MINIMAL)
+	legacy = !pvt_received;
+#endif
 
 	switch (ubx->header.class) {
 		case UBX_CLASS_NAV:
 			switch (ubx->header.id) {
 				case UBX_ID_POSLLH:
-					parse_ubx_nav_posllh (&ubx->payload.nav_posllh, GpsPosition);
+					if (legacy)
+						parse_ubx_nav_posllh (&ubx->payload.nav_posllh, GpsPosition);
 					break;
 				case UBX_ID_DOP:
 					parse_ubx_nav_dop (&ubx->payload.nav_dop, GpsPosition);
 					break;
 				case UBX_ID_SOL:
-					parse_ubx_nav_sol (&ubx->payload.nav_sol, GpsPosition);
+					if (legacy)
+						parse_ubx_nav_sol (&ubx->payload.nav_sol, GpsPosition);
 					break;
 				case UBX_ID_VELNED:
-					parse_ubx_nav_velned (&ubx->payload.nav_velned, GpsPosition);
+					if (legacy)
+						parse_ubx_nav_velned (&ubx->payload.nav_velned, GpsPosition);
 					break;
 #if !defined(PIOS_GPS_MINIMAL)
+				case UBX_ID_PVT:
+					// A single message carries the whole solution
+					parse_ubx_nav_pvt (&ubx->payload.nav_pvt, ubx->header.len, GpsPosition);
+					if (pvt_received) {
+						GPSPositionSet(GpsPosition);
+						id = GPSPOSITION_OBJID;
+					}
+					break;
 				case UBX_ID_TIMEUTC:
 					parse_ubx_nav_timeutc (&ubx->payload.nav_timeutc);
 					break;
@@ -397,7 +496,7 @@ static uint32_t parse_ubx_message (const struct UBXPacket *ubx, GPSPositionData
 			break;
 #endif
 	}
-	if (msgtracker.msg_received == ALL_RECEIVED) {
+	if (legacy && msgtracker.msg_received == ALL_RECEIVED) {
 		GPSPositionSet(GpsPosition);
 		msgtracker.msg_received = NONE_RECEIVED;
 		id = GPSPOSITION_OBJID;
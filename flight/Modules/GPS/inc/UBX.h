@@ -50,6 +50,7 @@
 #define UBX_ID_SOL		0x06
 #define	UBX_ID_VELNED	0x12
 #define UBX_ID_TIMEUTC	0x21
+#define UBX_ID_PVT		0x07
 #define UBX_ID_SVINFO	0x30
 
 #define UBX_CLASS_MON	0x0A
@@ -140,6 +141,52 @@ struct UBX_NAV_VELNED {
 	uint32_t	cAcc;     // 1e-5 *deg Course / Heading Accuracy Estimate
 };
 
+// Navigation position velocity time solution
+
+#define PVT_VALID_DATE		(1 << 0)
+#define PVT_VALID_TIME		(1 << 1)
+
+#define PVT_FLAGS_GNSSFIX_OK	(1 << 0)
+#define PVT_FLAGS_DIFFSOLN		(1 << 1)
+
+// u-blox 7 sends the message up to pDOP and the reserved bytes, u-blox 8 adds the vehicle heading
+#define UBX_NAV_PVT_MIN_LEN	84
+
+struct UBX_NAV_PVT {
+	uint32_t	iTOW;     // GPS Millisecond Time of Week (ms)
+	uint16_t	year;     // Year (UTC)
+	uint8_t		month;    // Month (UTC)
+	uint8_t		day;      // Day of month (UTC)
+	uint8_t		hour;     // Hour of day (UTC)
+	uint8_t		min;      // Minute of hour (UTC)
+	uint8_t		sec;      // Seconds of minute (UTC)
+	uint8_t		valid;    // Validity Flags
+	uint32_t	tAcc;     // Time accuracy estimate (ns)
+	int32_t		nano;     // Fraction of second (ns)
+	uint8_t		fixType;  // GNSS fix type
+	uint8_t		flags;    // Fix status flags
+	uint8_t		flags2;   // Additional flags
+	uint8_t		numSV;    // Number of SVs used in Nav Solution
+	int32_t		lon;      // Longitude (deg*1e-7)
+	int32_t		lat;      // Latitude (deg*1e-7)
+	int32_t		height;   // Height above Ellipsoid (mm)
+	int32_t		hMSL;     // Height above mean sea level (mm)
+	uint32_t	hAcc;     // Horizontal Accuracy Estimate (mm)
+	uint32_t	vAcc;     // Vertical Accuracy Estimate (mm)
+	int32_t		velN;     // mm/s NED north velocity
+	int32_t		velE;     // mm/s NED east velocity
+	int32_t		velD;     // mm/s NED down velocity
+	int32_t		gSpeed;   // mm/s Ground Speed (2-D)
+	int32_t		headMot;  // 1e-5 *deg Heading of motion 2-D
+	uint32_t	sAcc;     // mm/s Speed Accuracy Estimate
+	uint32_t	headAcc;  // 1e-5 *deg Heading Accuracy Estimate
+	uint16_t	pDOP;     // Position DOP
+	uint8_t		reserved1[6];
+	int32_t		headVeh;  // 1e-5 *deg Heading of vehicle (u-blox 8 only)
+	int16_t		magDec;   // 1e-2 *deg Magnetic declination (u-blox 8 only)
+	uint16_t	magAcc;   // 1e-2 *deg Magnetic declination accuracy (u-blox 8 only)
+};
+
 // UTC Time Solution
 
 #define TIMEUTC_VALIDTOW	(1 << 0)
@@ -210,6 +257,7 @@ typedef union {
 #if !defined(PIOS_GPS_MINIMAL)
 	struct UBX_NAV_TIMEUTC	nav_timeutc;
 	struct UBX_NAV_SVINFO	nav_svinfo;
+	struct UBX_NAV_PVT		nav_pvt;
 	struct UBX_MON_VER      mon_ver;
 #endif
 } UBXPayload;
@@ -227,7 +275,7 @@ struct UBXPacket {
 	UBXPayload	payload;
 };
 
-int  parse_ubx_stream(uint8_t, char *, GPSPositionData *, struct GPS_RX_STATS *);
+int  parse_ubx_stream(const uint8_t *, uint16_t, char *, GPSPositionData *, struct GPS_RX_STATS *);
 
 #endif /* UBX_H */
 
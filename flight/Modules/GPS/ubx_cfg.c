@@ -74,6 +74,7 @@
 #define UBLOX_NAV_STATUS    0x03
 #define UBLOX_NAV_DOP       0x04
 #define UBLOX_NAV_SOL       0x06
+#define UBLOX_NAV_PVT       0x07
 #define UBLOX_NAV_VELNED    0x12
 #define UBLOX_NAV_TIMEUTC   0x21
 #define UBLOX_NAV_SBAS      0x32
@@ -445,13 +446,13 @@ static void ubx_cfg_pause_parse(uintptr_t gps_port, uint32_t delay_ticks)
     struct GPS_RX_STATS gpsRxStats;
     GPSPositionData     gpsPosition;
 
-    uint8_t c;
+    uint8_t c[16];
     uint32_t enterTime = PIOS_Thread_Systime();
     while ((PIOS_Thread_Systime() - enterTime) < delay_ticks)
     {
-        int32_t received = PIOS_COM_ReceiveBuffer(gps_port, &c, 1, 1);
+        uint16_t received = PIOS_COM_ReceiveBuffer(gps_port, c, sizeof(c), 1);
         if (received > 0)
-            parse_ubx_stream (c, gps_rx_buffer, &gpsPosition, &gpsRxStats);
+            parse_ubx_stream (c, received, gps_rx_buffer, &gpsPosition, &gpsRxStats);
     }
 }
 
@@ -503,23 +504,31 @@ void ubx_cfg_send_configuration(uintptr_t gps_port, char *buffer,
         UBloxInfoGet(&ublox);
     } while (ublox.swVersion == 0 && i++ < 10);
 
-    ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_VELNED, 1);    // NAV-VELNED
-    ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_POSLLH, 1);    // NAV-POSLLH
-    ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_SOL, 1);       // NAV-SOL
-    ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_TIMEUTC, 5);   // NAV-TIMEUTC
-    ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_DOP, 1);       // NAV-DOP
+    // Hardcoded version. The poll version method should fetch the
+    // data but we need to link to that.
+    uint8_t ver = (ublox.hwVersion > 0) ? floorf(ublox.hwVersion) : 6;
+
+    if (ver >= 7) {
+        // NAV-PVT carries the whole solution in one message per epoch, so
+        // the per-topic messages are turned off in case they were saved
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_PVT, 1);       // NAV-PVT
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_VELNED, 0);    // NAV-VELNED
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_POSLLH, 0);    // NAV-POSLLH
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_SOL, 0);       // NAV-SOL
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_TIMEUTC, 0);   // NAV-TIMEUTC
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_DOP, 5);       // NAV-DOP, only for HDOP and VDOP
+    } else {
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_VELNED, 1);    // NAV-VELNED
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_POSLLH, 1);    // NAV-POSLLH
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_SOL, 1);       // NAV-SOL
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_TIMEUTC, 5);   // NAV-TIMEUTC
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_DOP, 1);       // NAV-DOP
+    }
     ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_SVINFO, 5);    // NAV-SVINFO
 
     ubx_cfg_set_mode(gps_port, dyn_mode);
 
-    // Hardcoded version. The poll version method should fetch the
-    // data but we need to link to that.
-    if (ublox.hwVersion > 0)
-        ubx_cfg_version_specific(gps_port, floorf(ublox.hwVersion),
-                constellation, sbas_const);
-    else
-        ubx_cfg_version_specific(gps_port, 6,
-                constellation, sbas_const);
+    ubx_cfg_version_specific(gps_port, ver, constellation, sbas_const);
 }
 
 //! Make sure the GPS is set to the same baud
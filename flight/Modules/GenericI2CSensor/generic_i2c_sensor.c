@@ -7,7 +7,7 @@
  *
  * @file       generic_i2c_sensor.c
  * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2012.
- * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2014
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2015
  * @brief      Runs the built-in or user defined program on the I2C Virtual Machine
  *****************************************************************************/
 /*
@@ -34,8 +34,7 @@
 #include "i2cvm.h"	   /* UAV Object (VM register file outputs) */
 #include "i2cvmuserprogram.h"	/* UAV Object (bytecode to run) */
 #include "pios_thread.h"
-
-extern bool i2c_vm_run (const uint32_t * code, uint8_t code_len, uintptr_t i2c_adapter);
+#include "i2c_vm.h"		/* i2c_vm_load, i2c_vm_exec */
 
 // Private constants
 #define STACK_SIZE_BYTES 370
@@ -48,8 +47,7 @@ static bool module_enabled = false;
 // Private functions
 static void GenericI2CSensorTask(void *parameters);
 
-static const uint32_t * i2cvm_program = NULL; /* bytecode to run in the VM */
-static uint16_t i2cvm_program_len = 0;	/* number of instructions in the program */
+static struct i2c_vm_prog i2cvm_program; /* checked and decoded program to run in the VM */
 
 /**
 * Start the module, called on startup
@@ -87,44 +85,46 @@ static int32_t GenericI2CSensorInitialize(void)
 		return -1;
 
 	/* Module is enabled, determine which program to run (if any) */
+	const uint32_t * program = NULL;
+	uint16_t program_len = 0;
+	uint32_t * user_program = NULL;
 	uint8_t selected_program;
 	ModuleSettingsI2CVMProgramSelectGet(&selected_program);
 
 	switch (selected_program) {
 	case MODULESETTINGS_I2CVMPROGRAMSELECT_USER:
 		I2CVMUserProgramInitialize();
-		uint32_t * user_program;
 		user_program = PIOS_malloc(sizeof(((I2CVMUserProgramData *)0)->Program));
 		if (!user_program) {
 			/* Failed to allocate sufficient memory for the user program */
 			return -1;
 		}
 		I2CVMUserProgramProgramGet(user_program);
-		i2cvm_program = user_program;
-		i2cvm_program_len = I2CVMUSERPROGRAM_PROGRAM_NUMELEM;
+		program = user_program;
+		program_len = I2CVMUSERPROGRAM_PROGRAM_NUMELEM;
 		break;
 	case MODULESETTINGS_I2CVMPROGRAMSELECT_OPBAROALTIMETER:
 		{
 		extern const uint32_t vmprog_op_mag_baro[];
 		extern const uint32_t vmprog_op_mag_baro_len;
-		i2cvm_program = vmprog_op_mag_baro;
-		i2cvm_program_len = vmprog_op_mag_baro_len;
+		program = vmprog_op_mag_baro;
+		program_len = vmprog_op_mag_baro_len;
 		}
 		break;
 	case MODULESETTINGS_I2CVMPROGRAMSELECT_ENDIANTEST:
 		{
 		extern const uint32_t vmprog_endiantest[];
 		extern const uint32_t vmprog_endiantest_len;
-		i2cvm_program = vmprog_endiantest;
-		i2cvm_program_len = vmprog_endiantest_len;
+		program = vmprog_endiantest;
+		program_len = vmprog_endiantest_len;
 		}
 		break;
 	case MODULESETTINGS_I2CVMPROGRAMSELECT_MATHTEST:
 		{
 		extern const uint32_t vmprog_mathtest[];
 		extern const uint32_t vmprog_mathtest_len;
-		i2cvm_program = vmprog_mathtest;
-		i2cvm_program_len = vmprog_mathtest_len;
+		program = vmprog_mathtest;
+		program_len = vmprog_mathtest_len;
 		}
 		break;
 	case MODULESETTINGS_I2CVMPROGRAMSELECT_NONE:
@@ -133,8 +133,13 @@ static int32_t GenericI2CSensorInitialize(void)
 		break;
 	}
 
-	/* Make sure we have something to run */
-	if ((i2cvm_program == NULL) || (i2cvm_program_len == 0)) {
+	/* Make sure we have something valid to run, the decoded form is all that is kept */
+	bool loaded = i2c_vm_load(&i2cvm_program, program, program_len);
+
+	if (user_program)
+		PIOS_free(user_program);
+
+	if (!loaded) {
 		module_enabled = false;
 		return -1;
 	}
@@ -152,7 +157,7 @@ static void GenericI2CSensorTask(void *parameters)
 	// Main task loop
 	while (1) {
 		/* Run the selected program */
-		if (i2c_vm_run(i2cvm_program, i2cvm_program_len, PIOS_I2C_MAIN_ADAPTER)) {
+		if (i2c_vm_exec(&i2cvm_program, PIOS_I2C_MAIN_ADAPTER)) {
 			/* Program ran to completion. This could be because the program is 
 			 * empty or does not infinitely loop.
 			 * Delay in order to prevent these programs from consuming all CPU.
@@ -7,7 +7,7 @@
  *
  * @file       i2c_vm.c
  * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2012.
- * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2014
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2015
  * @brief      The virtual machine for I2C sensors
  *****************************************************************************/
 /*
@@ -34,20 +34,11 @@
 #include "uavobjectmanager.h" /* UAVO types */
 #include "i2cvm.h"	      /* UAVO that holds VM state snapshots */
 #include "i2c_vm_asm.h"	      /* Minimal assembler for I2C VM */
+#include "i2c_vm.h"	      /* Decoded program format */
 #if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
 #include "pios_thread.h"
 #endif /* defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS) */
 
-struct i2c_vm_regs {
-	bool     halted;
-	bool     fault;
-
-	uintptr_t i2c_adapter;
-	uint8_t i2c_dev_addr;
-
-	I2CVMData uavo;
-};
-
 /******************************
  *
  * VM internal helper functions
@@ -56,757 +47,525 @@ struct i2c_vm_regs {
 
 #define SIMM_VAL(msb,lsb) ((int16_t)((((msb) & 0xFF) << 8) | ((lsb) & 0xFF)))
 
-/* Assign a 32-bit value into virtual machine registers
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] reg destination register where value will be stored
- * @param[in] val value to store in register
- */
-static bool i2c_vm_set_reg (struct i2c_vm_regs * vm_state, uint8_t reg, uint32_t val)
-{
-	switch (reg) {
-	case VM_R0:
-		vm_state->uavo.r0 = val;
-		break;
-	case VM_R1:
-		vm_state->uavo.r1 = val;
-		break;
-	case VM_R2:
-		vm_state->uavo.r2 = val;
-		break;
-	case VM_R3:
-		vm_state->uavo.r3 = val;
-		break;
-	case VM_R4:
-		vm_state->uavo.r4 = val;
-		break;
-	case VM_R5:
-		vm_state->uavo.r5 = val;
-		break;
-	case VM_R6:
-		vm_state->uavo.r6 = val;
-		break;
-	default:
-		return false;
-	}
-
-	return true;
-}
+/* Move on to the next instruction */
+#define NEXT(insn) ((insn) + 1)
 
-/* Read a 32-bit value from virtual machine registers
+/* Stop the virtual machine because of an error in the program
  *
- * @param[in,out] vm_state virtual machine state
- * @param[in] reg register where value will be read from
- * @param[out] val pointer to hold the value of the register
+ * @param[in,out] prog program and virtual machine state
  */
-static bool i2c_vm_get_reg (const struct i2c_vm_regs * vm_state, uint8_t reg, uint32_t * val)
-{
-	switch (reg) {
-	case VM_R0:
-		*val = vm_state->uavo.r0;
-		break;
-	case VM_R1:
-		*val = vm_state->uavo.r1;
-		break;
-	case VM_R2:
-		*val = vm_state->uavo.r2;
-		break;
-	case VM_R3:
-		*val = vm_state->uavo.r3;
-		break;
-	case VM_R4:
-		*val = vm_state->uavo.r4;
-		break;
-	case VM_R5:
-		*val = vm_state->uavo.r5;
-		break;
-	case VM_R6:
-		*val = vm_state->uavo.r6;
-		break;
-	default:
-		return false;
-	}
-
-	return true;
-}
-
-enum aluop {
-	ALUOP_ADD,
-	ALUOP_MUL,
-	ALUOP_DIV,
-	ALUOP_LSR,
-	ALUOP_ASR,
-	ALUOP_SL,
-	ALUOP_OR,
-	ALUOP_AND,
-};
-
-/* Perform an ALU operation and update the virtual machine state (rd = ra op rb)
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] operation ALU operation to be performed
- * @param[in] rd destination register for result
- * @param[in] ra first operand register
- * @param[in] rb second operand register
- */
-static bool i2c_vm_aluop_reg (struct i2c_vm_regs * vm_state, enum aluop operation, uint8_t rd, uint8_t ra, uint8_t rb)
+static const struct i2c_vm_insn * i2c_vm_fault (struct i2c_vm_prog * prog)
 {
-	uint32_t ra_val;
-	uint32_t rb_val;
-	uint32_t rd_val;
-
-	/* Load ra value */
-	if (!i2c_vm_get_reg(vm_state, ra, &ra_val))
-		return false;
-
-	/* Load rb value */
-	if (!i2c_vm_get_reg(vm_state, rb, &rb_val))
-		return false;
-
-	/* Compute result */
-	switch (operation) {
-	case ALUOP_ADD:
-		rd_val = (int32_t)ra_val + (int32_t)rb_val;
-		break;
-	case ALUOP_MUL:
-		rd_val = (int32_t)ra_val * (int32_t)rb_val;
-		break;
-	case ALUOP_DIV:
-		rd_val = (int32_t)ra_val / (int32_t)rb_val;
-		break;
-	case ALUOP_AND:
-		rd_val = ra_val & rb_val;
-		break;
-	default:
-		/* invalid operation, fault */
-		return false;
-	}
-
-	/* Write value into destination register */
-	if (!i2c_vm_set_reg(vm_state, rd, rd_val))
-		return false;
-
-	return true;
-}
-
-/* Perform an ALU operation and update the virtual machine state (rd = rd op simm)
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] operation ALU operation to be performed
- * @param[in] rd destination register for result
- * @param[in] simm_hi,simm_lo short immediate data
- */
-static bool i2c_vm_aluop_imm (struct i2c_vm_regs * vm_state, enum aluop operation, uint8_t rd, uint8_t simm_hi, uint8_t simm_lo)
-{
-	uint32_t rd_val;
-	int16_t  simm_val;
-
-	/* Load rd value */
-	if (!i2c_vm_get_reg(vm_state, rd, &rd_val))
-		return false;
-
-	/* Load short-immediate data */
-	simm_val = SIMM_VAL(simm_hi, simm_lo);
-
-	/* Compute result */
-	switch (operation) {
-	case ALUOP_ADD:
-		rd_val += simm_val;
-		break;
-	case ALUOP_MUL:
-		rd_val *= simm_val;
-		break;
-	case ALUOP_DIV:
-		rd_val /= simm_val;
-		break;
-	case ALUOP_OR:
-		rd_val |= (uint16_t)simm_val;
-		break;
-	case ALUOP_ASR:
-		{
-			/* NOTE this must be a signed integer to force the >> to be an arithmetic shift */
-			int32_t rd_signed;
-
-			rd_signed = rd_val;
-			rd_signed >>= (uint8_t)(simm_val & 0x1F);
-			rd_val = rd_signed;
-		}
-		break;
-	case ALUOP_LSR:
-		rd_val >>= (uint8_t)(simm_val & 0x1F);
-		break;
-	case ALUOP_SL:
-		rd_val <<= (uint8_t)(simm_val & 0x1F);
-		break;
-	default:
-		/* invalid operation, fault */
-		return false;
-	}
-
-	/* Write value into destination register */
-	if (!i2c_vm_set_reg(vm_state, rd, rd_val))
-		return false;
-
-	return true;
+	prog->fault = true;
+	return NULL;
 }
 
 /*********************
  *
  * VM opcode execution
  *
+ * The operands were checked when the program was loaded, so the handlers
+ * only check what depends on the data.
+ *
  ********************/
 
-/* Halt the virtual machine
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] op1,op2,op3 unused
- */
-static bool i2c_vm_halt (struct i2c_vm_regs * vm_state, uint8_t op1, uint8_t op2, uint8_t op3)
+/* Halt the virtual machine, also what runs past the end of the program */
+static const struct i2c_vm_insn * i2c_vm_halt (struct i2c_vm_prog * prog, const struct i2c_vm_insn * insn)
 {
-	vm_state->halted = true;
-	return true;
+	return NULL;
 }
 
-/* Virtual machine no operation instruction
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] op1,op2,op3 unused
- */
-static bool i2c_vm_nop (struct i2c_vm_regs * vm_state, uint8_t op1, uint8_t op2, uint8_t op3)
+/* Virtual machine no operation instruction */
+static const struct i2c_vm_insn * i2c_vm_nop (struct i2c_vm_prog * prog, const struct i2c_vm_insn * insn)
 {
-	vm_state->uavo.pc++;
-	return true;
+	return NEXT(insn);
 }
 
-/* Set virtual machine register
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] rd register be set
- * @param[in] imm_hi,imm_lo short immediate data
- */
-static bool i2c_vm_set_imm (struct i2c_vm_regs * vm_state, uint8_t rd, uint8_t imm_hi, uint8_t imm_lo)
+/* Set virtual machine register: a = k */
+static const struct i2c_vm_insn * i2c_vm_set_imm (struct i2c_vm_prog * prog, const struct i2c_vm_insn * insn)
 {
-	if (!i2c_vm_set_reg(vm_state, rd, (uint32_t)SIMM_VAL(imm_hi, imm_lo)))
-		return false;
-
-	vm_state->uavo.pc++;
-	return true;
+	prog->regs[insn->a] = insn->k;
+	return NEXT(insn);
 }
 
-/* Store virtual machine data in RAM
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] val value to be stored in RAM
- * @param[in] ram_addr address (in virtual RAM) where value will be stored
- * @param[in] op3 unused
- */
-static bool i2c_vm_store (struct i2c_vm_regs * vm_state, uint8_t val, uint8_t ram_addr, uint8_t op3)
+/* Store virtual machine data in RAM: ram[b] = a */
+static const struct i2c_vm_insn * i2c_vm_store (struct i2c_vm_prog * prog, const struct i2c_vm_insn * insn)
 {
-	if (ram_addr >= sizeof(vm_state->uavo.ram))
-		return false;
-
-	vm_state->uavo.ram[ram_addr] = val;
-	vm_state->uavo.pc++;
-	return true;
+	prog->ram[insn->b] = insn->a;
+	return NEXT(insn);
 }
 
-
-/* Load register information in Big Endian format
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] addr address (in virtual RAM) where value should be loaded from
- * @param[in] len number of bytes to load from RAM
- * @param[in] rd register to store the value into
- */
-static bool i2c_vm_load_be (struct i2c_vm_regs * vm_state, uint8_t addr, uint8_t len, uint8_t rd)
+/* Load register information in Big Endian format: k = ram[a .. a + b - 1] */
+static const struct i2c_vm_insn * i2c_vm_load_be (struct i2c_vm_prog * prog, const struct i2c_vm_insn * insn)
 {
-	if ((len < 1) || (len > 4))
-		return false;
-
-	if (addr >= sizeof(vm_state->uavo.ram))
-		return false;
-
+	const uint8_t * ram = &prog->ram[insn->a];
 	uint32_t val = 0;
-	memcpy ((void *)((uintptr_t)&val + (4 - len)), &(vm_state->uavo.ram[addr]), len);
-
-	/* Handle byte swapping */
-	val = (((val & 0xFF000000) >> 24) |
-		((val & 0x00FF0000) >> 8) |
-		((val & 0x0000FF00) << 8) |
-		((val & 0x000000FF) << 24));
 
-	if (!i2c_vm_set_reg (vm_state, rd, val))
-		return false;
+	for (uint8_t i = 0; i < insn->b; i++)
+		val = (val << 8) | ram[i];
 
-	vm_state->uavo.pc++;
-	return true;
+	prog->regs[insn->k] = val;
+	return NEXT(insn);
 }
 
-/* Load register information in Little Endian format
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] addr address (in virtual RAM) where value should be loaded from
- * @param[in] len number of bytes to load from RAM
- * @param[in] rd register to store the value into
- */
-static bool i2c_vm_load_le (struct i2c_vm_regs * vm_state, uint8_t addr, uint8_t len, uint8_t rd)
+/* Load register information in Little Endian format: k = ram[a .. a + b - 1] */
+static const struct i2c_vm_insn * i2c_vm_load_le (struct i2c_vm_prog * prog, const struct i2c_vm_insn * insn)
 {
-	if ((len < 1) || (len > 4))
-		return false;
-
-	if (addr >= sizeof(vm_state->uavo.ram))
-		return false;
-
+	const uint8_t * ram = &prog->ram[insn->a];
 	uint32_t val = 0;
-	memcpy (&val, &(vm_state->uavo.ram[addr]), len);
 
-	if (!i2c_vm_set_reg (vm_state, rd, val))
-		return false;
+	for (uint8_t i = insn->b; i > 0; i--)
+		val = (val << 8) | ram[i - 1];
 
-	vm_state->uavo.pc++;
-	return true;
+	prog->regs[insn->k] = val;
+	return NEXT(insn);
 }
 
-/* ADD: rd = ra + rb
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] rd destination register for result
- * @param[in] ra first operand register
- * @param[in] rb second operand register
- */
-static bool i2c_vm_add_reg (struct i2c_vm_regs * vm_state, uint8_t rd, uint8_t ra, uint8_t rb)
+/* ADD: a = b + k */
+static const struct i2c_vm_insn * i2c_vm_add_reg (struct i2c_vm_prog * prog, const struct i2c_vm_insn * insn)
 {
-	if (!i2c_vm_aluop_reg(vm_state, ALUOP_ADD, rd, ra, rb))
-		return false;
-
-	vm_state->uavo.pc++;
-	return true;
+	prog->regs[insn->a] = (uint32_t)prog->regs[insn->b] + (uint32_t)prog->regs[insn->k];
+	return NEXT(insn);
 }
 
-/* ADD: rd += simm
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] rd destination register for result
- * @param[in] imm_hi,imm_lo short immediate data
- */
-static bool i2c_vm_add_imm (struct i2c_vm_regs * vm_state, uint8_t rd, uint8_t imm_hi, uint8_t imm_lo)
+/* ADD: a += k */
+static const struct i2c_vm_insn * i2c_vm_add_imm (struct i2c_vm_prog * prog, const struct i2c_vm_insn * insn)
 {
-	if (!i2c_vm_aluop_imm(vm_state, ALUOP_ADD, rd, imm_hi, imm_lo))
-		return false;
-
-	vm_state->uavo.pc++;
-	return true;
+	prog->regs[insn->a] = (uint32_t)prog->regs[insn->a] + (uint32_t)insn->k;
+	return NEXT(insn);
 }
 
-/* Multiply: rd = ra * rb
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] rd destination register for result
- * @param[in] ra first operand register
- * @param[in] rb second operand register
- */
-static bool i2c_vm_mul_reg (struct i2c_vm_regs * vm_state, uint8_t op1, uint8_t op2, uint8_t op3)
+/* Multiply: a = b * k */
+static const struct i2c_vm_insn * i2c_vm_mul_reg (struct i2c_vm_prog * prog, const struct i2c_vm_insn * insn)
 {
-	if (!i2c_vm_aluop_reg(vm_state, ALUOP_MUL, op1, op2, op3))
-		return false;
-
-	vm_state->uavo.pc++;
-	return true;
+	prog->regs[insn->a] = (uint32_t)prog->regs[insn->b] * (uint32_t)prog->regs[insn->k];
+	return NEXT(insn);
 }
 
-/* Multiply: rd *= simm
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] rd destination register for result
- * @param[in] imm_hi,imm_lo short immediate data
- */
-static bool i2c_vm_mul_imm (struct i2c_vm_regs * vm_state, uint8_t rd, uint8_t imm_hi, uint8_t imm_lo)
+/* Multiply: a *= k */
+static const struct i2c_vm_insn * i2c_vm_mul_imm (struct i2c_vm_prog * prog, const struct i2c_vm_insn * insn)
 {
-	if (!i2c_vm_aluop_imm(vm_state, ALUOP_MUL, rd, imm_hi, imm_lo))
-		return false;
-
-	vm_state->uavo.pc++;
-	return true;
+	prog->regs[insn->a] = (uint32_t)prog->regs[insn->a] * (uint32_t)insn->k;
+	return NEXT(insn);
 }
 
-/* Divide: rd = ra / rb
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] rd destination register for result
- * @param[in] ra first operand register
- * @param[in] rb second operand register
- */
-static bool i2c_vm_div_reg (struct i2c_vm_regs * vm_state, uint8_t rd, uint8_t ra, uint8_t rb)
+/* Divide: a = b / k, faults on a zero divisor or an overflow */
+static const struct i2c_vm_insn * i2c_vm_div_reg (struct i2c_vm_prog * prog, const struct i2c_vm_insn * insn)
 {
-	if (!i2c_vm_aluop_reg(vm_state, ALUOP_DIV, rd, ra, rb))
-		return false;
+	int32_t dividend = prog->regs[insn->b];
+	int32_t divisor  = prog->regs[insn->k];
 
-	vm_state->uavo.pc++;
-	return true;
+	if (divisor == 0 || (divisor == -1 && dividend == INT32_MIN))
+		return i2c_vm_fault(prog);
+
+	prog->regs[insn->a] = dividend / divisor;
+	return NEXT(insn);
 }
 
-/* Divide: rd /= simm
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] rd destination register for result
- * @param[in] imm_hi,imm_lo short immediate data
- */
-static bool i2c_vm_div_imm (struct i2c_vm_regs * vm_state, uint8_t rd, uint8_t imm_hi, uint8_t imm_lo)
+/* Divide: a /= k, where k is not zero */
+static const struct i2c_vm_insn * i2c_vm_div_imm (struct i2c_vm_prog * prog, const struct i2c_vm_insn * insn)
 {
-	if (!i2c_vm_aluop_imm(vm_state, ALUOP_DIV, rd, imm_hi, imm_lo))
-		return false;
+	if (insn->k == -1 && prog->regs[insn->a] == INT32_MIN)
+		return i2c_vm_fault(prog);
 
-	vm_state->uavo.pc++;
-	return true;
+	prog->regs[insn->a] /= insn->k;
+	return NEXT(insn);
 }
 
-/* OR: rd |= (simm & 0xFFFF)
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] rd destination register for result
- * @param[in] imm_hi,imm_lo short immediate data
- */
-static bool i2c_vm_or_imm (struct i2c_vm_regs * vm_state, uint8_t rd, uint8_t imm_hi, uint8_t imm_lo)
+/* OR: a |= (k & 0xFFFF) */
+static const struct i2c_vm_insn * i2c_vm_or_imm (struct i2c_vm_prog * prog, const struct i2c_vm_insn * insn)
 {
-	if (!i2c_vm_aluop_imm(vm_state, ALUOP_OR, rd, imm_hi, imm_lo))
-		return false;
+	prog->regs[insn->a] |= (uint16_t)insn->k;
+	return NEXT(insn);
+}
 
-	vm_state->uavo.pc++;
-	return true;
+/* AND: a = b & k */
+static const struct i2c_vm_insn * i2c_vm_and_reg (struct i2c_vm_prog * prog, const struct i2c_vm_insn * insn)
+{
+	prog->regs[insn->a] = prog->regs[insn->b] & prog->regs[insn->k];
+	return NEXT(insn);
 }
 
-/* AND: rd = ra & rb
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] rd destination register for result
- * @param[in] ra first operand register
- * @param[in] rb second operand register
- */
-static bool i2c_vm_and_reg (struct i2c_vm_regs * vm_state, uint8_t rd, uint8_t ra, uint8_t rb)
+/* Arithmetic Shift Right (ASR): signed(a) >>= k, with k masked to 0 - 31 */
+static const struct i2c_vm_insn * i2c_vm_asr_imm (struct i2c_vm_prog * prog, const struct i2c_vm_insn * insn)
 {
-	if (!i2c_vm_aluop_reg(vm_state, ALUOP_AND, rd, ra, rb))
-		return false;
+	/* NOTE this must be a signed integer to force the >> to be an arithmetic shift */
+	prog->regs[insn->a] >>= insn->k;
+	return NEXT(insn);
+}
 
-	vm_state->uavo.pc++;
-	return true;
+/* Logical Shift Right (LSR): a >>= k, with k masked to 0 - 31 */
+static const struct i2c_vm_insn * i2c_vm_lsr_imm (struct i2c_vm_prog * prog, const struct i2c_vm_insn * insn)
+{
+	prog->regs[insn->a] = (uint32_t)prog->regs[insn->a] >> insn->k;
+	return NEXT(insn);
 }
 
-/* Arithmetic Shift Right (ASR): signed(rd) >>= (simm & 0x1F)
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] rd destination register for result
- * @param[in] imm_hi,imm_lo number of bits to shift (short immediate data)
- */
-static bool i2c_vm_asr_imm (struct i2c_vm_regs * vm_state, uint8_t rd, uint8_t imm_hi, uint8_t imm_lo)
+/* Logical Shift Left (SL): a <<= k, with k masked to 0 - 31 */
+static const struct i2c_vm_insn * i2c_vm_sl_imm (struct i2c_vm_prog * prog, const struct i2c_vm_insn * insn)
 {
-	if (!i2c_vm_aluop_imm(vm_state, ALUOP_ASR, rd, imm_hi, imm_lo))
-		return false;
+	prog->regs[insn->a] = (uint32_t)prog->regs[insn->a] << insn->k;
+	return NEXT(insn);
+}
 
-	vm_state->uavo.pc++;
-	return true;
+/* Jump to instruction k */
+static const struct i2c_vm_insn * i2c_vm_jump (struct i2c_vm_prog * prog, const struct i2c_vm_insn * insn)
+{
+	return &prog->insns[insn->k];
 }
 
-/* Logical Shift Right (LSR): rd >>= (simm & 0x1F)
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] rd destination register for result
- * @param[in] imm_hi,imm_lo number of bits to shift (short immediate data)
- */
-static bool i2c_vm_lsr_imm (struct i2c_vm_regs * vm_state, uint8_t rd, uint8_t imm_hi, uint8_t imm_lo)
+/* Branch If Not Zero: jump to instruction k IFF (a != 0) */
+static const struct i2c_vm_insn * i2c_vm_bnz (struct i2c_vm_prog * prog, const struct i2c_vm_insn * insn)
 {
-	if (!i2c_vm_aluop_imm(vm_state, ALUOP_LSR, rd, imm_hi, imm_lo))
-		return false;
+	if (prog->regs[insn->a])
+		return &prog->insns[insn->k];
 
-	vm_state->uavo.pc++;
-	return true;
+	return NEXT(insn);
 }
 
+/* Set I2C device address in virtual machine: a is the 7-bit address */
+static const struct i2c_vm_insn * i2c_vm_set_dev_addr (struct i2c_vm_prog * prog, const struct i2c_vm_insn * insn)
+{
+	prog->i2c_dev_addr = insn->a;
+	return NEXT(insn);
+}
 
-/* Logical Shift Left (SL): rd <<= (simm & 0x1F)
+/* Transfer I2C data between the bus and virtual machine RAM
  *
- * @param[in,out] vm_state virtual machine state
- * @param[in] rd destination register for result
- * @param[in] imm_hi,imm_lo number of bits to shift (short immediate data)
+ * @param[in,out] prog program and virtual machine state
+ * @param[in] rw PIOS_I2C_TXN_READ or PIOS_I2C_TXN_WRITE
+ * @param[in] ram_addr base address (in virtual RAM) of the data
+ * @param[in] len number of bytes to transfer
  */
-static bool i2c_vm_sl_imm (struct i2c_vm_regs * vm_state, uint8_t rd, uint8_t imm_hi, uint8_t imm_lo)
+static bool i2c_vm_transfer (struct i2c_vm_prog * prog, uint8_t rw, uint8_t ram_addr, uint8_t len)
 {
-	if (!i2c_vm_aluop_imm(vm_state, ALUOP_SL, rd, imm_hi, imm_lo))
-		return false;
+	const struct pios_i2c_txn txn_list[] = {
+		{
+			.info = __func__,
+			.addr = prog->i2c_dev_addr,
+			.rw   = rw,
+			.len  = len,
+			.buf  = prog->ram + ram_addr,
+		},
+	};
 
-	vm_state->uavo.pc++;
-	return true;
+	uint32_t start = PIOS_DELAY_GetRaw();
+	int32_t rc = PIOS_I2C_Transfer(prog->i2c_adapter, txn_list, NELEMENTS(txn_list));
+	prog->i2c_time += PIOS_DELAY_DiffuS(start);
+
+	return rc >= 0;
 }
 
-/* Jump: pc += simm
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] op1 unused
- * @param[in] imm_hi,imm_lo offset to apply to the program counter (short immediate data)
- */
-static bool i2c_vm_jump (struct i2c_vm_regs * vm_state, uint8_t op1, uint8_t imm_hi, uint8_t imm_lo)
+/* Read I2C data into virtual machine RAM: ram[a .. a + b - 1] */
+static const struct i2c_vm_insn * i2c_vm_read (struct i2c_vm_prog * prog, const struct i2c_vm_insn * insn)
 {
-	vm_state->uavo.pc += SIMM_VAL(imm_hi, imm_lo);
+	/* Fault the VM if the I2C transfer fails */
+	if (!i2c_vm_transfer(prog, PIOS_I2C_TXN_READ, insn->a, insn->b))
+		return i2c_vm_fault(prog);
 
-	return true;
+	return NEXT(insn);
 }
 
-/* Branch If Not Zero: pc += simm IFF (ra == 0)
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] ra register to compare
- * @param[in] imm_hi,imm_lo short immediate data
- */
-static bool i2c_vm_bnz (struct i2c_vm_regs * vm_state, uint8_t ra, uint8_t imm_hi, uint8_t imm_lo)
+/* Write I2C data from virtual machine RAM: ram[a .. a + b - 1] */
+static const struct i2c_vm_insn * i2c_vm_write (struct i2c_vm_prog * prog, const struct i2c_vm_insn * insn)
 {
-	uint32_t ra_val;
+	/* Fault the VM if the I2C transfer fails */
+	if (!i2c_vm_transfer(prog, PIOS_I2C_TXN_WRITE, insn->a, insn->b))
+		return i2c_vm_fault(prog);
 
-	/* Load ra value */
-	if (!i2c_vm_get_reg(vm_state, ra, &ra_val))
-		return false;
+	return NEXT(insn);
+}
 
-	if (ra_val) {
-		return (i2c_vm_jump(vm_state, 0, imm_hi, imm_lo));
-	} else {
-		vm_state->uavo.pc++;
-	}
+/* Send UAVObject from virtual machine registers */
+static const struct i2c_vm_insn * i2c_vm_send_uavo (struct i2c_vm_prog * prog, const struct i2c_vm_insn * insn)
+{
+	I2CVMData uavo;
 
-	return true;
+	memcpy(uavo.ram, prog->ram, sizeof(uavo.ram));
+	uavo.pc = insn - prog->insns;
+	uavo.r0 = prog->regs[VM_R0];
+	uavo.r1 = prog->regs[VM_R1];
+	uavo.r2 = prog->regs[VM_R2];
+	uavo.r3 = prog->regs[VM_R3];
+	uavo.r4 = prog->regs[VM_R4];
+	uavo.r5 = prog->regs[VM_R5];
+	uavo.r6 = prog->regs[VM_R6];
+	uavo.cycles = prog->cycles;
+	uavo.i2ctime = prog->i2c_time;
+
+	I2CVMSet(&uavo);
+
+	return NEXT(insn);
 }
 
-/* Set I2C device address in virtual machine
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] i2c_dev_addr 7-bit I2C device address to be used in future I2C transfers
- * @param[in] op2,op3 unused
- */
-static bool i2c_vm_set_dev_addr (struct i2c_vm_regs * vm_state, uint8_t i2c_dev_addr, uint8_t op2, uint8_t op3)
+/* Make virtual machine wait for k ms */
+static const struct i2c_vm_insn * i2c_vm_delay (struct i2c_vm_prog * prog, const struct i2c_vm_insn * insn)
 {
-	vm_state->i2c_dev_addr = i2c_dev_addr;
-	vm_state->uavo.pc++;
-	return true;
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+	PIOS_Thread_Sleep(insn->k);
+#endif /* defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS) */
+
+	return NEXT(insn);
 }
 
-/* Read I2C data into virtual machine RAM
+/*********************
  *
- * @param[in,out] vm_state virtual machine state
- * @param[in] ram_addr base address (in virtual RAM) where data will be stored
- * @param[in] len number of bytes to read from the i2c bus and store into virtual RAM
- * @param[in] op3 unused
- */
-static bool i2c_vm_read (struct i2c_vm_regs * vm_state, uint8_t ram_addr, uint8_t len, uint8_t op3)
-{
-	/* Make sure our read fits in our buffer */
-	if ((ram_addr + len) > sizeof(vm_state->uavo.ram)) {
-		return false;
-	}
+ * Program loading
+ *
+ ********************/
 
-	const struct pios_i2c_txn txn_list[] = {
-		{
-			.info = __func__,
-			.addr = vm_state->i2c_dev_addr,
-			.rw   = PIOS_I2C_TXN_READ,
-			.len  = len,
-			.buf  = vm_state->uavo.ram + ram_addr,
-		},
-	};
+/* Operands an opcode takes, which are checked and decoded at load time */
+enum i2c_vm_operands {
+	OPERANDS_NONE,     /* no operands */
+	OPERANDS_BYTE,     /* op1 is any value */
+	OPERANDS_REG_SIMM, /* op1 is a register, op2:op3 short immediate data */
+	OPERANDS_REG_SHIFT,/* op1 is a register, op2:op3 a shift count */
+	OPERANDS_REG_DIV,  /* op1 is a register, op2:op3 a non zero divisor */
+	OPERANDS_REGS,     /* op1, op2 and op3 are registers */
+	OPERANDS_SIMM,     /* op2:op3 is short immediate data */
+	OPERANDS_TARGET,   /* op2:op3 is a branch offset */
+	OPERANDS_REG_TARGET,/* op1 is a register, op2:op3 a branch offset */
+	OPERANDS_STORE,    /* op1 is any value, op2 a RAM address */
+	OPERANDS_LOAD,     /* op1 is a RAM address, op2 a length of 1 - 4 bytes, op3 a register */
+	OPERANDS_RAM,      /* op1 is a RAM address, op2 a length that fits in the RAM */
+};
 
-	int32_t rc = PIOS_I2C_Transfer(vm_state->i2c_adapter, txn_list, NELEMENTS(txn_list));
+static const struct {
+	i2c_vm_handler handler;
+	enum i2c_vm_operands operands;
+} i2c_vm_ops[] = {
+	/* Program flow operations */
+	[I2C_VM_OP_HALT]         = { i2c_vm_halt,         OPERANDS_NONE },       /* Halt */
+	[I2C_VM_OP_NOP]          = { i2c_vm_nop,          OPERANDS_NONE },       /* No operation */
+	[I2C_VM_OP_DELAY]        = { i2c_vm_delay,        OPERANDS_SIMM },       /* Wait (ms) */
+	[I2C_VM_OP_BNZ]          = { i2c_vm_bnz,          OPERANDS_REG_TARGET }, /* Branch if register is not zero */
+	[I2C_VM_OP_JUMP]         = { i2c_vm_jump,         OPERANDS_TARGET },     /* Jump relative */
 
-	/* Fault the VM if the I2C transfer fails */
-	if (rc < 0)
-		return false;
+	/* RAM operations */
+	[I2C_VM_OP_STORE]        = { i2c_vm_store,        OPERANDS_STORE },      /* Store value */
+	[I2C_VM_OP_LOAD_BE]      = { i2c_vm_load_be,      OPERANDS_LOAD },       /* Load big endian */
+	[I2C_VM_OP_LOAD_LE]      = { i2c_vm_load_le,      OPERANDS_LOAD },       /* Load little endian */
+
+	/* Arithmetic operations */
+	[I2C_VM_OP_SET_IMM]      = { i2c_vm_set_imm,      OPERANDS_REG_SIMM },   /* Set register to immediate data */
+	[I2C_VM_OP_ADD]          = { i2c_vm_add_reg,      OPERANDS_REGS },       /* Add two registers */
+	[I2C_VM_OP_ADD_IMM]      = { i2c_vm_add_imm,      OPERANDS_REG_SIMM },   /* Add immediate data to register */
+	[I2C_VM_OP_MUL]          = { i2c_vm_mul_reg,      OPERANDS_REGS },       /* Multiply two registers */
+	[I2C_VM_OP_MUL_IMM]      = { i2c_vm_mul_imm,      OPERANDS_REG_SIMM },   /* Multiply register by immediate data */
+	[I2C_VM_OP_DIV]          = { i2c_vm_div_reg,      OPERANDS_REGS },       /* Divide two registers */
+	[I2C_VM_OP_DIV_IMM]      = { i2c_vm_div_imm,      OPERANDS_REG_DIV },    /* Divide register by immediate data */
+
+	/* Logical operations */
+	[I2C_VM_OP_SL_IMM]       = { i2c_vm_sl_imm,       OPERANDS_REG_SHIFT },  /* Shift left */
+	[I2C_VM_OP_LSR_IMM]      = { i2c_vm_lsr_imm,      OPERANDS_REG_SHIFT },  /* Logical Shift Right */
+	[I2C_VM_OP_ASR_IMM]      = { i2c_vm_asr_imm,      OPERANDS_REG_SHIFT },  /* Arithmetic Shift Right */
+	[I2C_VM_OP_OR_IMM]       = { i2c_vm_or_imm,       OPERANDS_REG_SIMM },   /* Logical OR of register and immediate data */
+	[I2C_VM_OP_AND]          = { i2c_vm_and_reg,      OPERANDS_REGS },       /* Logical AND of two registers */
+
+	/* I2C operations */
+	[I2C_VM_OP_SET_DEV_ADDR] = { i2c_vm_set_dev_addr, OPERANDS_BYTE },       /* Set I2C device address */
+	[I2C_VM_OP_READ]         = { i2c_vm_read,         OPERANDS_RAM },        /* Read from I2C bus */
+	[I2C_VM_OP_WRITE]        = { i2c_vm_write,        OPERANDS_RAM },        /* Write to I2C bus */
 
-	vm_state->uavo.pc++;
+	/* UAVO operations */
+	[I2C_VM_OP_SEND_UAVO]    = { i2c_vm_send_uavo,    OPERANDS_NONE },       /* Send UAV Object */
+};
 
-	return (true);
+/* Check that a register operand names one of R0 - R6 */
+static inline bool i2c_vm_valid_reg (uint8_t reg)
+{
+	return reg >= VM_R0 && reg <= VM_R6;
 }
 
-/* Write I2C data from virtual machine RAM
+/* Check and decode one instruction
  *
- * @param[in,out] vm_state virtual machine state
- * @param[in] ram_addr base address (in virtual RAM) where data will be read from
- * @param[in] len number of bytes to read from virtual RAM and write to the the i2c bus
- * @param[in] op3 unused
+ * @param[out] insn decoded instruction
+ * @param[in] instruction the encoded instruction
+ * @param[in] pc index of the instruction in the program
+ * @param[in] code_len number of instructions in the program
+ * @return true if the instruction is valid
  */
-static bool i2c_vm_write (struct i2c_vm_regs * vm_state, uint8_t ram_addr, uint8_t len, uint8_t op3)
+static bool i2c_vm_decode (struct i2c_vm_insn * insn, uint32_t instruction, uint16_t pc, uint16_t code_len)
 {
-	if ((ram_addr + len) > sizeof(vm_state->uavo.ram)) {
-		return false;
+	uint8_t operator = (instruction & 0xFF000000) >> 24;
+	uint8_t op1      = (instruction & 0x00FF0000) >> 16;
+	uint8_t op2      = (instruction & 0x0000FF00) >>  8;
+	uint8_t op3      = (instruction & 0x000000FF);
+	int16_t simm     = SIMM_VAL(op2, op3);
+
+	if (operator >= NELEMENTS(i2c_vm_ops) || !i2c_vm_ops[operator].handler)
+		return false;
+
+	insn->handler = i2c_vm_ops[operator].handler;
+	insn->a = 0;
+	insn->b = 0;
+	insn->k = 0;
+
+	switch (i2c_vm_ops[operator].operands) {
+	case OPERANDS_NONE:
+		return true;
+	case OPERANDS_BYTE:
+		insn->a = op1;
+		return true;
+	case OPERANDS_REG_SIMM:
+		insn->a = op1;
+		insn->k = simm;
+		return i2c_vm_valid_reg(op1);
+	case OPERANDS_REG_SHIFT:
+		insn->a = op1;
+		insn->k = simm & 0x1F;
+		return i2c_vm_valid_reg(op1);
+	case OPERANDS_REG_DIV:
+		insn->a = op1;
+		insn->k = simm;
+		return i2c_vm_valid_reg(op1) && simm != 0;
+	case OPERANDS_REGS:
+		insn->a = op1;
+		insn->b = op2;
+		insn->k = op3;
+		return i2c_vm_valid_reg(op1) && i2c_vm_valid_reg(op2) && i2c_vm_valid_reg(op3);
+	case OPERANDS_SIMM:
+		insn->k = simm;
+		return true;
+	case OPERANDS_REG_TARGET:
+		if (!i2c_vm_valid_reg(op1))
+			return false;
+		insn->a = op1;
+		/* Fall through */
+	case OPERANDS_TARGET:
+		/* Branching to just past the end completes the program */
+		if (pc + simm < 0 || pc + simm > code_len)
+			return false;
+		insn->k = pc + simm;
+		return true;
+	case OPERANDS_STORE:
+		insn->a = op1;
+		insn->b = op2;
+		return op2 < I2C_VM_RAM_LEN;
+	case OPERANDS_LOAD:
+		insn->a = op1;
+		insn->b = op2;
+		insn->k = op3;
+		return op2 >= 1 && op2 <= 4 && op1 + op2 <= I2C_VM_RAM_LEN && i2c_vm_valid_reg(op3);
+	case OPERANDS_RAM:
+		insn->a = op1;
+		insn->b = op2;
+		return op1 + op2 <= I2C_VM_RAM_LEN;
 	}
 
-	const struct pios_i2c_txn txn_list[] = {
-		{
-			.info = __func__,
-			.addr = vm_state->i2c_dev_addr,
-			.rw   = PIOS_I2C_TXN_WRITE,
-			.len  = len,
-			.buf  = vm_state->uavo.ram + ram_addr,
-		},
-	};
+	return false;
+}
 
-	int32_t rc = PIOS_I2C_Transfer(vm_state->i2c_adapter, txn_list, NELEMENTS(txn_list));
+/* Check and decode a program so that it can be run
+ *
+ * @param[out] prog the loaded program
+ * @param[in] code pointer to the program
+ * @param[in] code_len number of 32-bit instructions contained in the program
+ * @return true if every instruction is valid, false otherwise or if out of memory
+ */
+bool i2c_vm_load (struct i2c_vm_prog * prog, const uint32_t * code, uint16_t code_len)
+{
+	memset(prog, 0, sizeof(*prog));
 
-	/* Fault the VM if the I2C transfer fails */
-	if (rc < 0)
+	/* Branch targets are held in 16 signed bits */
+	if (code == NULL || code_len == 0 || code_len > INT16_MAX)
 		return false;
 
-	vm_state->uavo.pc++;
+	prog->insns = PIOS_malloc(sizeof(*prog->insns) * (code_len + 1));
+	if (prog->insns == NULL)
+		return false;
 
-	return (true);
-}
+	for (uint16_t pc = 0; pc < code_len; pc++) {
+		if (!i2c_vm_decode(&prog->insns[pc], code[pc], pc, code_len)) {
+			i2c_vm_unload(prog);
+			return false;
+		}
+	}
 
-/* Send UAVObject from virtual machine registers
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] op1,op2,op3 unused
- */
-static bool i2c_vm_send_uavo (struct i2c_vm_regs * vm_state, uint8_t op1, uint8_t op2, uint8_t op3)
-{
-	/* Push our local copy of the UAVO */
-	I2CVMSet(&vm_state->uavo);
+	/* Running past the end of the program completes it */
+	prog->insns[code_len] = (struct i2c_vm_insn) { .handler = i2c_vm_halt };
+	prog->len = code_len;
 
-	vm_state->uavo.pc++;
 	return true;
 }
 
-/* Make virtual machine wait
+/* Release the memory of a loaded program
  *
- * @param[in,out] vm_state virtual machine state
- * @param[in] op1 unused
- * @param[in] imm_hi,imm_lo number of ms to wait (short immediate data)
+ * @param[in,out] prog the loaded program
  */
-static bool i2c_vm_delay (struct i2c_vm_regs * vm_state, uint8_t op1, uint8_t imm_hi, uint8_t imm_lo)
+void i2c_vm_unload (struct i2c_vm_prog * prog)
 {
-#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
-	PIOS_Thread_Sleep(SIMM_VAL(imm_hi, imm_lo));
-#endif /* defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS) */
+	if (prog->insns)
+		PIOS_free(prog->insns);
 
-	vm_state->uavo.pc++;
-	return true;
+	prog->insns = NULL;
+	prog->len = 0;
 }
 
 /* Reboot virtual machine
  *
- * @param[in,out] vm_state virtual machine state
- * @param[in] op1,op2,op3 unused
+ * @param[in,out] prog program and virtual machine state
+ * @param[in] i2c_adapter opaque I2C adapter handle to use for i2c transactions
  */
-static bool i2c_vm_reboot (struct i2c_vm_regs * vm_state, uintptr_t i2c_adapter)
+static void i2c_vm_reboot (struct i2c_vm_prog * prog, uintptr_t i2c_adapter)
 {
-	vm_state->halted  = false;
-	vm_state->fault   = false;
+	prog->fault = false;
 
 	/* Reset I2C configuration */
-	vm_state->i2c_dev_addr = 0;
-	vm_state->i2c_adapter  = i2c_adapter;
+	prog->i2c_dev_addr = 0;
+	prog->i2c_adapter  = i2c_adapter;
 
 	/* Reset register state */
-	vm_state->uavo.pc = 0;
-	vm_state->uavo.r0 = 0;
-	vm_state->uavo.r1 = 0;
-	vm_state->uavo.r2 = 0;
-	vm_state->uavo.r3 = 0;
-	vm_state->uavo.r4 = 0;
-	vm_state->uavo.r5 = 0;
-	vm_state->uavo.r6 = 0;
-	memset(vm_state->uavo.ram, 0, sizeof(vm_state->uavo.ram));
+	memset(prog->regs, 0, sizeof(prog->regs));
+	memset(prog->ram, 0, sizeof(prog->ram));
 
-	return true;
+	prog->cycles   = 0;
+	prog->i2c_time = 0;
 }
 
+/* Run a loaded program from its start until it halts or faults
+ *
+ * @param[in,out] prog the loaded program
+ * @param[in] i2c_adapter opaque I2C adapter handle to use for i2c transactions
+ * @return true if the program completed, false if it faulted
+ */
+bool i2c_vm_exec (struct i2c_vm_prog * prog, uintptr_t i2c_adapter)
+{
+	if (prog->insns == NULL)
+		return false;
 
-typedef bool (*i2c_vm_inst_handler) (struct i2c_vm_regs * vm_state, uint8_t op1, uint8_t op2, uint8_t op3);
-
-const i2c_vm_inst_handler i2c_vm_handlers[] = {
-	/* Program flow operations */
-	[I2C_VM_OP_HALT]         = i2c_vm_halt,         /* Halt */
-	[I2C_VM_OP_NOP]          = i2c_vm_nop,          /* No operation */
-	[I2C_VM_OP_DELAY]        = i2c_vm_delay,        /* Wait (ms) */
-	[I2C_VM_OP_BNZ]          = i2c_vm_bnz,          /* Branch if register is not zero */
-	[I2C_VM_OP_JUMP]         = i2c_vm_jump,         /* Jump relative */
-
-	/* RAM operations */
-	[I2C_VM_OP_STORE]        = i2c_vm_store,        /* Store value */
-	[I2C_VM_OP_LOAD_BE]      = i2c_vm_load_be,      /* Load big endian */
-	[I2C_VM_OP_LOAD_LE]      = i2c_vm_load_le,      /* Load little endian */
-
-	/* Arithmetic operations */
-	[I2C_VM_OP_SET_IMM]      = i2c_vm_set_imm,      /* Set register to immediate data */
-	[I2C_VM_OP_ADD]          = i2c_vm_add_reg,      /* Add two registers */
-	[I2C_VM_OP_ADD_IMM]      = i2c_vm_add_imm,      /* Add immediate data to register */
-	[I2C_VM_OP_MUL]          = i2c_vm_mul_reg,      /* Multiply two registers */
-	[I2C_VM_OP_MUL_IMM]      = i2c_vm_mul_imm,      /* Multiply register by immediate data */
-	[I2C_VM_OP_DIV]          = i2c_vm_div_reg,      /* Divide two registers */
-	[I2C_VM_OP_DIV_IMM]      = i2c_vm_div_imm,      /* Divide register by immediate data */
+	i2c_vm_reboot(prog, i2c_adapter);
 
-	/* Logical operations */
-	[I2C_VM_OP_SL_IMM]       = i2c_vm_sl_imm,       /* Shift left */
-	[I2C_VM_OP_LSR_IMM]      = i2c_vm_lsr_imm,      /* Logical Shift Right */
-	[I2C_VM_OP_ASR_IMM]      = i2c_vm_asr_imm,      /* Arithmetic Shift Right */
-	[I2C_VM_OP_OR_IMM]       = i2c_vm_or_imm,       /* Logical OR of register and immediate data */
-	[I2C_VM_OP_AND]          = i2c_vm_and_reg,      /* Logical AND of two registers */
+	const struct i2c_vm_insn * insn = prog->insns;
 
-	/* I2C operations */
-	[I2C_VM_OP_SET_DEV_ADDR] = i2c_vm_set_dev_addr, /* Set I2C device address */
-	[I2C_VM_OP_READ]         = i2c_vm_read,         /* Read from I2C bus */
-	[I2C_VM_OP_WRITE]        = i2c_vm_write,        /* Write to I2C bus */
+	/* Each handler returns the next instruction, there is nothing to fetch or decode */
+	while (insn) {
+		prog->cycles++;
+		insn = insn->handler(prog, insn);
+	}
 
-	/* UAVO operations */
-	[I2C_VM_OP_SEND_UAVO]    = i2c_vm_send_uavo,    /* Send UAV Object */
-};
+	return !prog->fault;
+}
 
-/* Run virtual machine. This is the code that loops through and interprets all the instructions
+/* Load and run a program once
  *
  * @param[in] code pointer to program to execute
  * @param[in] code_len number of 32-bit instructions contained in the program
  * @param[in] i2c_adapter opaque I2C adapter handle to use for i2c transactions
- *
+ * @return true if the program is valid and completed
  */
 bool i2c_vm_run (const uint32_t * code, uint8_t code_len, uintptr_t i2c_adapter)
 {
-	if (code == NULL || code_len == 0)
-		return false;
+	struct i2c_vm_prog prog;
 
-	static struct i2c_vm_regs vm;
+	if (!i2c_vm_load(&prog, code, code_len))
+		return false;
 
-	i2c_vm_reboot (&vm, i2c_adapter);
+	bool completed = i2c_vm_exec(&prog, i2c_adapter);
 
-	while (!vm.halted) {
-		if (vm.uavo.pc > code_len) {
-			/* PC is entirely out of range */
-			vm.fault  = true;
-			vm.halted = true;
-			continue;
-		}
-		if (vm.uavo.pc == code_len) {
-			/* PC is just past the end of the code, assume program is completed */
-			vm.halted = true;
-			continue;
-		}
-		/* Fetch */
-		uint32_t instruction = code[vm.uavo.pc];
-
-		/* Decode */
-		uint8_t operator = (instruction & 0xFF000000) >> 24;
-		uint8_t op1      = (instruction & 0x00FF0000) >> 16;
-		uint8_t op2      = (instruction & 0x0000FF00) >>  8;
-		uint8_t op3      = (instruction & 0x000000FF);
-
-		if (operator > NELEMENTS(i2c_vm_handlers)) {
-			vm.fault = true;
-			vm.halted = true;
-			continue;
-		}
-		i2c_vm_inst_handler f = i2c_vm_handlers[operator];
-
-		/* Execute + Writeback */
-		if (!f || !f(&vm, op1, op2, op3)) {
-			vm.fault  = true;
-			vm.halted = true;
-			continue;
-		}
-	}
+	i2c_vm_unload(&prog);
 
-	return (!vm.fault);
+	return completed;
 }
 
 #endif /* PIOS_INCLUDE_I2C */
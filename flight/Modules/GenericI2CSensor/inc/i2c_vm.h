@@ -0,0 +1,89 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup GenericI2CSensor Generic I2C sensor interface
+ * @{
+ *
+ * @file       i2c_vm.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @brief      The virtual machine for I2C sensors
+ *
+ * A program is checked and decoded once when it is loaded, into an array
+ * of handlers with their operands already extracted. Running it then
+ * needs no further checks of the operands and no decoding.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef I2C_VM_H
+#define I2C_VM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//! Bytes of virtual RAM, the same as the RAM in the I2CVM UAVO
+#define I2C_VM_RAM_LEN 8
+
+//! Registers including the unused slot for VM_PC, so they index by name
+#define I2C_VM_NUM_REGS 8
+
+struct i2c_vm_prog;
+struct i2c_vm_insn;
+
+/**
+ * Execute one decoded instruction
+ * @return the next instruction, or NULL when the program halts or faults
+ */
+typedef const struct i2c_vm_insn *(*i2c_vm_handler)(struct i2c_vm_prog *prog, const struct i2c_vm_insn *insn);
+
+//! A decoded instruction
+struct i2c_vm_insn {
+	i2c_vm_handler handler;
+	int16_t k;	//!< immediate data, branch target or third operand
+	uint8_t a;	//!< first operand
+	uint8_t b;	//!< second operand
+};
+
+//! A loaded program and its machine state
+struct i2c_vm_prog {
+	struct i2c_vm_insn *insns;	//!< one more than len, the last halts
+	uint16_t len;
+
+	bool fault;
+	uintptr_t i2c_adapter;
+	uint8_t i2c_dev_addr;
+
+	int32_t regs[I2C_VM_NUM_REGS];
+	uint8_t ram[I2C_VM_RAM_LEN];
+
+	uint32_t cycles;	//!< instructions executed since the program started
+	uint32_t i2c_time;	//!< us spent in I2C transfers since the program started
+};
+
+bool i2c_vm_load(struct i2c_vm_prog *prog, const uint32_t *code, uint16_t code_len);
+void i2c_vm_unload(struct i2c_vm_prog *prog);
+bool i2c_vm_exec(struct i2c_vm_prog *prog, uintptr_t i2c_adapter);
+bool i2c_vm_run(const uint32_t *code, uint8_t code_len, uintptr_t i2c_adapter);
+
+#endif /* I2C_VM_H */
+
+/**
+ * @}
+ * @}
+ */
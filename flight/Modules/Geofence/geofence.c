@@ -9,6 +9,12 @@
  * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2014
  * @brief      Check the UAV is within the geofence boundaries
  *
+ * The boundary is either a radius around home or a polygon loaded from the
+ * @ref GeoFenceVertices instances, plus an optional ceiling. The polygon is
+ * indexed when it changes, see @ref geofence_polygon.c, so that checking a
+ * position costs about the same for any number of vertices. The vertices
+ * are saved in the waypoint filesystem and loaded again at startup.
+ *
  * @see        The GNU Public License (GPL) Version 3
  *
  *****************************************************************************/
@@ -30,10 +36,13 @@
 
 
 #include "openpilot.h"
+#include "pios_flashfs.h"
 #include "misc_math.h"
 #include "physical_constants.h"
+#include "geofence_polygon.h"
 
 #include "geofencesettings.h"
+#include "geofencevertices.h"
 #include "positionactual.h"
 #include "modulesettings.h"
 
@@ -49,11 +58,24 @@
 
 // Private functions
 static void settingsUpdated(UAVObjEvent* ev);
+static void verticesUpdated(UAVObjEvent* ev);
 static void checkPosition(UAVObjEvent* ev);
+static void loadPolygon(void);
+static int32_t saveVertices(void);
+static int32_t loadVertices(void);
+
+extern uintptr_t pios_waypoints_settings_fs_id;
 
 // Private variables
 static bool module_enabled;
 static GeoFenceSettingsData *geofenceSettings;
+static float warning_radius2;
+static float error_radius2;
+static struct geofence_polygon *polygon;
+static uint16_t polygon_max_vertices;
+static bool polygon_valid;
+static struct geofence_cursor polygon_cursor;
+static volatile bool polygon_changed;
 
 /**
  * Initialise the module, called on startup
@@ -78,6 +100,8 @@ int32_t GeofenceInitialize(void)
 	if (module_enabled) {
 
 		GeoFenceSettingsInitialize();
+		GeoFenceVerticesInitialize();
+		loadVertices();
 
 		// allocate and initialize the static data storage only if module is enabled
 		geofenceSettings = (GeoFenceSettingsData *) PIOS_malloc(sizeof(GeoFenceSettingsData));
@@ -87,6 +111,7 @@ int32_t GeofenceInitialize(void)
 		}
 
 		GeoFenceSettingsConnectCallback(settingsUpdated);
+		GeoFenceVerticesConnectCallback(verticesUpdated);
 		settingsUpdated(NULL);
 
 		// Schedule periodic task to check position
@@ -117,23 +142,94 @@ MODULE_INITCALL(GeofenceInitialize, GeofenceStart);
  */
 static void checkPosition(UAVObjEvent* ev)
 {
+	if (polygon_changed) {
+		polygon_changed = false;
+		loadPolygon();
+	}
+
 	if (PositionActualHandle()) {
 		PositionActualData positionActual;
 		PositionActualGet(&positionActual);
 
-		const float distance2 = powf(positionActual.North, 2) + powf(positionActual.East, 2);
+		SystemAlarmsAlarmOptions severity = SYSTEMALARMS_ALARM_OK;
 
-		// ErrorRadius is squared when it is fetched, so this is correct
-		if (distance2 > geofenceSettings->ErrorRadius) {
-			AlarmsSet(SYSTEMALARMS_ALARM_GEOFENCE, SYSTEMALARMS_ALARM_ERROR);
-		} else if (distance2 > geofenceSettings->WarningRadius) {
-			AlarmsSet(SYSTEMALARMS_ALARM_GEOFENCE, SYSTEMALARMS_ALARM_WARNING);
+		if (polygon_valid) {
+			const float position[2] = { positionActual.North, positionActual.East };
+			float distance;
+
+			if (!geofence_polygon_check(polygon, &polygon_cursor, position, &distance)) {
+				severity = SYSTEMALARMS_ALARM_ERROR;
+			} else if (distance < geofenceSettings->WarningDistance) {
+				severity = SYSTEMALARMS_ALARM_WARNING;
+			}
+		} else if (geofenceSettings->Vertices >= 3) {
+			// A polygon was asked for but could not be built, the radius is not what was meant
+			severity = SYSTEMALARMS_ALARM_ERROR;
 		} else {
+			const float distance2 = powf(positionActual.North, 2) + powf(positionActual.East, 2);
+
+			if (distance2 > error_radius2) {
+				severity = SYSTEMALARMS_ALARM_ERROR;
+			} else if (distance2 > warning_radius2) {
+				severity = SYSTEMALARMS_ALARM_WARNING;
+			}
+		}
+
+		if (geofenceSettings->Ceiling > 0) {
+			const float altitude = -positionActual.Down;
+
+			if (altitude > geofenceSettings->Ceiling) {
+				severity = SYSTEMALARMS_ALARM_ERROR;
+			} else if (altitude > geofenceSettings->Ceiling - geofenceSettings->WarningDistance &&
+					severity == SYSTEMALARMS_ALARM_OK) {
+				severity = SYSTEMALARMS_ALARM_WARNING;
+			}
+		}
+
+		if (severity == SYSTEMALARMS_ALARM_OK) {
 			AlarmsClear(SYSTEMALARMS_ALARM_GEOFENCE);
+		} else {
+			AlarmsSet(SYSTEMALARMS_ALARM_GEOFENCE, severity);
 		}
 	}
 }
 
+/**
+ * Build the polygon from the vertex instances
+ *
+ * The polygon is sized for the fence that was uploaded, and only allocated
+ * again when a fence with more vertices is, as not every heap gives memory
+ * back. A fence that is too large or doesn't fit in memory is not built,
+ * which raises the alarm.
+ */
+static void loadPolygon(void)
+{
+	uint16_t num_vertices = geofenceSettings->Vertices;
+
+	polygon_valid = false;
+
+	if (num_vertices < 3 || num_vertices > GEOFENCE_MAX_VERTICES ||
+			num_vertices > GeoFenceVerticesGetNumInstances())
+		return;
+
+	if (num_vertices > polygon_max_vertices) {
+		geofence_polygon_destroy(polygon);
+		polygon = geofence_polygon_create(num_vertices);
+		polygon_max_vertices = (polygon != NULL) ? num_vertices : 0;
+		if (polygon == NULL)
+			return;
+	}
+
+	for (uint16_t i = 0; i < num_vertices; i++) {
+		GeoFenceVerticesData vertex;
+		GeoFenceVerticesInstGet(i, &vertex);
+		geofence_polygon_set_vertex(polygon, i, vertex.Position);
+	}
+
+	geofence_cursor_init(&polygon_cursor);
+	polygon_valid = (geofence_polygon_build(polygon, num_vertices) == 0);
+}
+
 /**
  * Update the settings
  */
@@ -142,8 +238,103 @@ static void settingsUpdated(UAVObjEvent* ev)
 	GeoFenceSettingsGet(geofenceSettings);
 
 	// Cache squared distances to save computations
-	geofenceSettings->WarningRadius = powf(geofenceSettings->WarningRadius, 2);
-	geofenceSettings->ErrorRadius = powf(geofenceSettings->ErrorRadius, 2);
+	warning_radius2 = powf(geofenceSettings->WarningRadius, 2);
+	error_radius2 = powf(geofenceSettings->ErrorRadius, 2);
+
+	polygon_changed = true;
+
+	// Only act on flash operations that are requested, not on one restored with the settings
+	if (ev == NULL)
+		return;
+
+	int32_t retval;
+	switch (geofenceSettings->FlashOperation) {
+	case GEOFENCESETTINGS_FLASHOPERATION_SAVE:
+		retval = saveVertices();
+		break;
+	case GEOFENCESETTINGS_FLASHOPERATION_LOAD:
+		retval = loadVertices();
+		break;
+	default:
+		return;
+	}
+
+	geofenceSettings->FlashOperation = (retval == 0) ?
+		GEOFENCESETTINGS_FLASHOPERATION_COMPLETED : GEOFENCESETTINGS_FLASHOPERATION_FAILED;
+	GeoFenceSettingsFlashOperationSet(&geofenceSettings->FlashOperation);
+}
+
+/**
+ * Vertices are uploaded one by one, the polygon is rebuilt at the next
+ * check rather than for each of them
+ */
+static void verticesUpdated(UAVObjEvent* ev)
+{
+	polygon_changed = true;
+}
+
+/**
+ * Save the vertices of the fence to the waypoint filesystem
+ *
+ * They are stored under the object id of GeoFenceVertices, which does not
+ * clash with the path ids used by the @ref PathPlanner.
+ * \return -30 if there are fewer vertex instances than the fence uses
+ * \return -32 if the fence has more than GEOFENCE_MAX_VERTICES
+ * \return other FlashFS error, 0 on success
+ */
+static int32_t saveVertices(void)
+{
+	GeoFenceVerticesData vertex;
+	uint16_t num_vertices = geofenceSettings->Vertices;
+	uint32_t vertex_size = GeoFenceVerticesGetNumBytes();
+	int32_t retval = 0;
+
+	if (num_vertices > GeoFenceVerticesGetNumInstances())
+		return -30; // leave room for flashfs error codes
+
+	if (num_vertices > GEOFENCE_MAX_VERTICES)
+		return -32;
+
+	for (uint16_t i = 0; i < num_vertices && retval == 0; i++) {
+		GeoFenceVerticesInstGet(i, &vertex);
+		retval = PIOS_FLASHFS_ObjSave(pios_waypoints_settings_fs_id, GEOFENCEVERTICES_OBJID, i,
+				(uint8_t *) &vertex, vertex_size);
+	}
+
+	// Erase what is left of a larger fence saved before
+	for (uint16_t i = num_vertices; retval == 0; i++) {
+		if (PIOS_FLASHFS_ObjLoad(pios_waypoints_settings_fs_id, GEOFENCEVERTICES_OBJID, i,
+				(uint8_t *) &vertex, vertex_size) != 0)
+			break;
+		PIOS_FLASHFS_ObjDelete(pios_waypoints_settings_fs_id, GEOFENCEVERTICES_OBJID, i);
+	}
+
+	return retval;
+}
+
+/**
+ * Load the vertices saved in the waypoint filesystem, creating instances
+ * as needed
+ * \return -31 if a vertex instance could not be created
+ * \return 0 on success, including when nothing was saved
+ */
+static int32_t loadVertices(void)
+{
+	GeoFenceVerticesData vertex;
+	uint32_t vertex_size = GeoFenceVerticesGetNumBytes();
+
+	for (uint16_t i = 0; ; i++) {
+		if (PIOS_FLASHFS_ObjLoad(pios_waypoints_settings_fs_id, GEOFENCEVERTICES_OBJID, i,
+				(uint8_t *) &vertex, vertex_size) != 0)
+			break;
+
+		if (i >= GeoFenceVerticesGetNumInstances() && GeoFenceVerticesCreateInstance() != i)
+			return -31;
+
+		GeoFenceVerticesInstSet(i, &vertex);
+	}
+
+	return 0;
 }
 
 /**
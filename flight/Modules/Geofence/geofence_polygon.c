@@ -0,0 +1,568 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup GeoFence GeoFence Module
+ * @{
+ *
+ * @file       geofence_polygon.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @brief      Polygon fence with a grid index over its edges
+ *
+ * The bounding box of the fence is split in a grid of about one cell per
+ * edge, and each cell lists the edges that cross it. Each cell also has a
+ * reference point whose side of the fence is worked out once, when the
+ * fence is built.
+ *
+ * A point is then inside if the reference point of its cell is, and the
+ * segment between them crosses an even number of edges. Those can only be
+ * edges of the cell, so a check costs a few edges whatever the size of the
+ * fence. The distance to the boundary searches the cells in rings around
+ * the point, and stops once the rings are further than the nearest edge
+ * found so far.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "pios.h"
+#include "geofence_polygon.h"
+
+// Private types
+
+struct geofence_edge {
+	float start[2];
+	float delta[2];		//!< end - start
+	float inv_len_sq;
+};
+
+struct geofence_polygon {
+	uint16_t max_vertices;
+	uint16_t max_cells;
+	uint16_t max_refs;
+	uint16_t num_edges;
+	uint8_t cells[2];		//!< along north and east
+	float origin[2];		//!< south west corner of the grid
+	float cell_size[2];
+	float inv_cell_size[2];
+	float min_cell_size;
+
+	// In the same allocation, after the edges
+	float (*cell_ref)[2];		//!< reference point of each cell
+	uint16_t *cell_start;		//!< first entry of each cell in cell_edges
+	uint16_t *cell_edges;
+	uint8_t *cell_inside;		//!< bitmap, reference point is inside
+
+	struct geofence_edge edges[];
+};
+
+// Private functions
+
+static float cross(const float *a, const float *b)
+{
+	return a[0] * b[1] - a[1] * b[0];
+}
+
+/**
+ * Squared distance from a point to an edge
+ */
+static float edge_distance_sq(const struct geofence_edge *edge, const float *point)
+{
+	float rel[2] = { point[0] - edge->start[0], point[1] - edge->start[1] };
+	float t = (rel[0] * edge->delta[0] + rel[1] * edge->delta[1]) * edge->inv_len_sq;
+
+	if (t < 0)
+		t = 0;
+	else if (t > 1)
+		t = 1;
+
+	rel[0] -= t * edge->delta[0];
+	rel[1] -= t * edge->delta[1];
+
+	return rel[0] * rel[0] + rel[1] * rel[1];
+}
+
+/**
+ * Whether the segment from ref to point crosses an edge
+ *
+ * Vertices on the segment count as being on one side of it, like in the
+ * usual ray crossing test, so that a vertex is never counted once for an
+ * edge and not for the next.
+ */
+static bool edge_crosses(const struct geofence_edge *edge, const float *ref, const float *point)
+{
+	const float seg[2] = { point[0] - ref[0], point[1] - ref[1] };
+	const float to_start[2] = { edge->start[0] - ref[0], edge->start[1] - ref[1] };
+	const float to_end[2] = { to_start[0] + edge->delta[0], to_start[1] + edge->delta[1] };
+
+	if ((cross(seg, to_start) >= 0) == (cross(seg, to_end) >= 0))
+		return false;
+
+	const float ref_rel[2] = { -to_start[0], -to_start[1] };
+	const float point_rel[2] = { point[0] - edge->start[0], point[1] - edge->start[1] };
+
+	return (cross(edge->delta, ref_rel) >= 0) != (cross(edge->delta, point_rel) >= 0);
+}
+
+/**
+ * Whether an edge passes through, or near, a rectangle
+ */
+static bool edge_touches_box(const struct geofence_edge *edge, const float *lo, const float *hi)
+{
+	const float margin = 1e-3f * (hi[0] - lo[0] + hi[1] - lo[1]);
+	const float corners[4][2] = {
+		{ lo[0], lo[1] }, { lo[0], hi[1] }, { hi[0], lo[1] }, { hi[0], hi[1] },
+	};
+	const float len = sqrtf(edge->delta[0] * edge->delta[0] + edge->delta[1] * edge->delta[1]);
+	bool above = false, below = false;
+
+	for (int i = 0; i < 4; i++) {
+		const float rel[2] = { corners[i][0] - edge->start[0], corners[i][1] - edge->start[1] };
+		const float side = cross(edge->delta, rel);
+
+		if (side >= -margin * len)
+			above = true;
+		if (side <= margin * len)
+			below = true;
+	}
+
+	return above && below;
+}
+
+/**
+ * Ray crossing test against all edges, only used to build the grid
+ */
+static bool inside_slow(const struct geofence_polygon *fence, const float *point)
+{
+	bool inside = false;
+
+	for (int i = 0; i < fence->num_edges; i++) {
+		const struct geofence_edge *edge = &fence->edges[i];
+		const float end_east = edge->start[1] + edge->delta[1];
+
+		if ((edge->start[1] > point[1]) != (end_east > point[1])) {
+			const float north = edge->start[0] +
+				(point[1] - edge->start[1]) * edge->delta[0] / edge->delta[1];
+			if (point[0] < north)
+				inside = !inside;
+		}
+	}
+
+	return inside;
+}
+
+/**
+ * Cell that holds a point, clamped to the grid
+ * @return the index of the cell
+ */
+static uint16_t cell_of(const struct geofence_polygon *fence, const float *point, int *row, int *col)
+{
+	int idx[2];
+
+	for (int i = 0; i < 2; i++) {
+		float pos = (point[i] - fence->origin[i]) * fence->inv_cell_size[i];
+
+		if (pos < 0)
+			idx[i] = 0;
+		else if (pos >= fence->cells[i])
+			idx[i] = fence->cells[i] - 1;
+		else
+			idx[i] = (int) pos;
+	}
+
+	*row = idx[0];
+	*col = idx[1];
+	return idx[0] * fence->cells[1] + idx[1];
+}
+
+/**
+ * Range of cells that a box touches, clamped to the grid
+ */
+static void cell_range(const struct geofence_polygon *fence, const float *lo, const float *hi,
+		int *first, int *last)
+{
+	for (int i = 0; i < 2; i++) {
+		const float margin = 1e-3f;
+		int a = (int) floorf((lo[i] - fence->origin[i]) * fence->inv_cell_size[i] - margin);
+		int b = (int) floorf((hi[i] - fence->origin[i]) * fence->inv_cell_size[i] + margin);
+
+		first[i] = (a < 0) ? 0 : a;
+		last[i] = (b >= fence->cells[i]) ? fence->cells[i] - 1 : b;
+	}
+}
+
+/**
+ * Visit the cells that an edge touches
+ * @param[in,out] fill the count, or the next free entry, of each cell
+ * @param[in] store whether to store the edge or only count it
+ */
+static void index_edge(struct geofence_polygon *fence, uint16_t edge_idx, uint16_t *fill, bool store)
+{
+	const struct geofence_edge *edge = &fence->edges[edge_idx];
+	float lo[2], hi[2];
+	int first[2], last[2];
+
+	for (int i = 0; i < 2; i++) {
+		lo[i] = edge->start[i] + (edge->delta[i] < 0 ? edge->delta[i] : 0);
+		hi[i] = edge->start[i] + (edge->delta[i] > 0 ? edge->delta[i] : 0);
+	}
+
+	cell_range(fence, lo, hi, first, last);
+
+	for (int r = first[0]; r <= last[0]; r++) {
+		for (int c = first[1]; c <= last[1]; c++) {
+			const float cell_lo[2] = {
+				fence->origin[0] + r * fence->cell_size[0],
+				fence->origin[1] + c * fence->cell_size[1],
+			};
+			const float cell_hi[2] = {
+				cell_lo[0] + fence->cell_size[0],
+				cell_lo[1] + fence->cell_size[1],
+			};
+
+			if (!edge_touches_box(edge, cell_lo, cell_hi))
+				continue;
+
+			uint16_t cell = r * fence->cells[1] + c;
+			if (store)
+				fence->cell_edges[fill[cell]] = edge_idx;
+			fill[cell]++;
+		}
+	}
+}
+
+/**
+ * Pick the reference point of a cell away from its edges and classify it
+ */
+static void place_reference(struct geofence_polygon *fence, uint16_t cell, int row, int col)
+{
+	// Tried in turn until one is clear of the edges
+	const float offsets[][2] = {
+		{ 0.5f, 0.5f }, { 0.31f, 0.67f }, { 0.73f, 0.29f }, { 0.19f, 0.23f }, { 0.83f, 0.79f },
+	};
+	const float clearance = 1e-2f * fence->min_cell_size;
+	float *ref = fence->cell_ref[cell];
+
+	for (uint32_t k = 0; k < NELEMENTS(offsets); k++) {
+		ref[0] = fence->origin[0] + (row + offsets[k][0]) * fence->cell_size[0];
+		ref[1] = fence->origin[1] + (col + offsets[k][1]) * fence->cell_size[1];
+
+		bool clear = true;
+		for (int i = fence->cell_start[cell]; i < fence->cell_start[cell + 1] && clear; i++) {
+			const struct geofence_edge *edge = &fence->edges[fence->cell_edges[i]];
+			clear = edge_distance_sq(edge, ref) > clearance * clearance;
+		}
+
+		if (clear)
+			break;
+	}
+
+	if (inside_slow(fence, ref))
+		fence->cell_inside[cell / 8] |= 1 << (cell % 8);
+}
+
+/**
+ * Search the cells at a ring around a cell for a nearer edge
+ * @return false if the ring is entirely outside the grid
+ */
+static bool search_ring(const struct geofence_polygon *fence, int row, int col, int ring,
+		const float *point, float *best_sq, uint16_t *best_edge)
+{
+	bool any = false;
+
+	for (int r = row - ring; r <= row + ring; r++) {
+		if (r < 0 || r >= fence->cells[0])
+			continue;
+
+		// Whole rows at the top and bottom, only the ends in between
+		const bool full = (r == row - ring) || (r == row + ring);
+		const int step = (full || ring == 0) ? 1 : 2 * ring;
+
+		for (int c = col - ring; c <= col + ring; c += step) {
+			if (c < 0 || c >= fence->cells[1])
+				continue;
+
+			uint16_t cell = r * fence->cells[1] + c;
+			any = true;
+
+			for (int i = fence->cell_start[cell]; i < fence->cell_start[cell + 1]; i++) {
+				uint16_t e = fence->cell_edges[i];
+				float d = edge_distance_sq(&fence->edges[e], point);
+				if (d < *best_sq) {
+					*best_sq = d;
+					*best_edge = e;
+				}
+			}
+		}
+	}
+
+	return any;
+}
+
+/**
+ * Allocate a fence, its vertices are set with @ref geofence_polygon_set_vertex
+ *
+ * The memory for the index is allocated here too, so that a fence can be
+ * built again without allocating.
+ *
+ * @param[in] max_vertices the most vertices the fence can have, from 3 to
+ * GEOFENCE_MAX_VERTICES
+ * @return the fence, or NULL if out of memory or max_vertices is out of range
+ */
+struct geofence_polygon *geofence_polygon_create(uint16_t max_vertices)
+{
+	if (max_vertices < 3 || max_vertices > GEOFENCE_MAX_VERTICES)
+		return NULL;
+
+	uint32_t max_cells = (max_vertices > GEOFENCE_GRID_MAX) ? max_vertices : GEOFENCE_GRID_MAX;
+	if (max_cells > GEOFENCE_GRID_MAX * GEOFENCE_GRID_MAX)
+		max_cells = GEOFENCE_GRID_MAX * GEOFENCE_GRID_MAX;
+
+	uint32_t max_refs = (uint32_t) max_vertices * GEOFENCE_CELLS_PER_EDGE;
+
+	size_t edges_size = max_vertices * sizeof(struct geofence_edge);
+	size_t size = sizeof(struct geofence_polygon) + edges_size +
+		max_cells * sizeof(float[2]) +
+		(max_cells + 1) * sizeof(uint16_t) +
+		max_refs * sizeof(uint16_t) +
+		(max_cells + 7) / 8;
+
+	struct geofence_polygon *fence = PIOS_malloc(size);
+	if (fence == NULL)
+		return NULL;
+
+	memset(fence, 0, size);
+	fence->max_vertices = max_vertices;
+	fence->max_cells = max_cells;
+	fence->max_refs = max_refs;
+
+	uint8_t *grid = (uint8_t *) fence->edges + edges_size;
+	fence->cell_ref = (float (*)[2]) grid;
+	fence->cell_start = (uint16_t *) (grid + max_cells * sizeof(float[2]));
+	fence->cell_edges = fence->cell_start + max_cells + 1;
+	fence->cell_inside = (uint8_t *) (fence->cell_edges + max_refs);
+
+	return fence;
+}
+
+/**
+ * Free a fence and its index
+ */
+void geofence_polygon_destroy(struct geofence_polygon *fence)
+{
+	if (fence != NULL)
+		PIOS_free(fence);
+}
+
+/**
+ * Set a vertex, the fence goes through them in order and closes back to
+ * the first
+ * @param[in] vertex the North and East position
+ */
+void geofence_polygon_set_vertex(struct geofence_polygon *fence, uint16_t idx, const float *vertex)
+{
+	PIOS_Assert(idx < fence->max_vertices);
+
+	fence->edges[idx].start[0] = vertex[0];
+	fence->edges[idx].start[1] = vertex[1];
+}
+
+/**
+ * Size the grid for a number of cells
+ */
+static void size_grid(struct geofence_polygon *fence, const float *lo, const float *extent, float num_cells)
+{
+	for (int i = 0; i < 2; i++) {
+		float cells = sqrtf(num_cells * extent[i] / extent[1 - i]);
+		if (cells < 1)
+			cells = 1;
+		else if (cells > GEOFENCE_GRID_MAX)
+			cells = GEOFENCE_GRID_MAX;
+
+		// Grown a little so the vertices are inside the grid
+		float margin = 1e-3f * extent[i];
+		fence->cells[i] = (uint8_t) cells;
+		fence->origin[i] = lo[i] - margin;
+		fence->cell_size[i] = (extent[i] + 2 * margin) / fence->cells[i];
+		fence->inv_cell_size[i] = 1.0f / fence->cell_size[i];
+	}
+
+	fence->min_cell_size = fence->cell_size[0] < fence->cell_size[1] ?
+		fence->cell_size[0] : fence->cell_size[1];
+}
+
+/**
+ * Build the edges and the grid index once the vertices are set
+ *
+ * The grid has about a cell per edge. It is made coarser for fences whose
+ * edges cross more cells than there is room for.
+ *
+ * @param[in] num_vertices the number of vertices that were set
+ * \return -1 if the fence has no area or too many vertices
+ * \return 0 on success
+ */
+int32_t geofence_polygon_build(struct geofence_polygon *fence, uint16_t num_vertices)
+{
+	if (num_vertices < 3 || num_vertices > fence->max_vertices)
+		return -1;
+
+	fence->num_edges = num_vertices;
+
+	float lo[2] = { fence->edges[0].start[0], fence->edges[0].start[1] };
+	float hi[2] = { lo[0], lo[1] };
+
+	for (int i = 0; i < fence->num_edges; i++) {
+		struct geofence_edge *edge = &fence->edges[i];
+		const struct geofence_edge *next = &fence->edges[(i + 1) % fence->num_edges];
+
+		edge->delta[0] = next->start[0] - edge->start[0];
+		edge->delta[1] = next->start[1] - edge->start[1];
+
+		float len_sq = edge->delta[0] * edge->delta[0] + edge->delta[1] * edge->delta[1];
+		edge->inv_len_sq = (len_sq > 0) ? 1.0f / len_sq : 0;
+
+		for (int j = 0; j < 2; j++) {
+			if (edge->start[j] < lo[j])
+				lo[j] = edge->start[j];
+			if (edge->start[j] > hi[j])
+				hi[j] = edge->start[j];
+		}
+	}
+
+	float extent[2] = { hi[0] - lo[0], hi[1] - lo[1] };
+	if (extent[0] < 0.1f || extent[1] < 0.1f)
+		return -1;
+
+	float num_cells = fence->num_edges;
+	uint16_t cells;
+
+	while (1) {
+		size_grid(fence, lo, extent, num_cells);
+		cells = fence->cells[0] * fence->cells[1];
+
+		if (cells <= fence->max_cells) {
+			// Count the edges of each cell after its start
+			memset(fence->cell_start, 0, (cells + 1) * sizeof(*fence->cell_start));
+			for (int i = 0; i < fence->num_edges; i++)
+				index_edge(fence, i, fence->cell_start + 1, false);
+
+			uint32_t num_refs = 0;
+			for (int i = 1; i <= cells; i++) {
+				num_refs += fence->cell_start[i];
+				fence->cell_start[i] = num_refs;
+			}
+
+			// A single cell holds each edge once, so it always fits
+			if (num_refs <= fence->max_refs || cells == 1)
+				break;
+		}
+
+		num_cells *= 0.5f;
+	}
+
+	// Filling moves the start of each cell to its end, the start of the next
+	for (int i = 0; i < fence->num_edges; i++)
+		index_edge(fence, i, fence->cell_start, true);
+
+	for (int i = cells; i > 0; i--)
+		fence->cell_start[i] = fence->cell_start[i - 1];
+	fence->cell_start[0] = 0;
+
+	memset(fence->cell_inside, 0, (cells + 7) / 8);
+	for (int r = 0; r < fence->cells[0]; r++) {
+		for (int c = 0; c < fence->cells[1]; c++)
+			place_reference(fence, r * fence->cells[1] + c, r, c);
+	}
+
+	return 0;
+}
+
+/**
+ * Start tracking a new point
+ */
+void geofence_cursor_init(struct geofence_cursor *cursor)
+{
+	cursor->nearest_edge = 0;
+}
+
+/**
+ * Check a point against a built fence
+ * @param[in,out] cursor what was learnt from the last check of this point
+ * @param[in] point the North and East position
+ * @param[out] distance the distance to the fence boundary, not computed if NULL
+ * @return true if the point is inside
+ */
+bool geofence_polygon_check(const struct geofence_polygon *fence, struct geofence_cursor *cursor,
+		const float *point, float *distance)
+{
+	int row, col;
+	uint16_t cell = cell_of(fence, point, &row, &col);
+
+	// How far the point is outside the grid, zero if it is within
+	float outside_sq = 0;
+	for (int i = 0; i < 2; i++) {
+		float below = fence->origin[i] - point[i];
+		float above = point[i] - (fence->origin[i] + fence->cells[i] * fence->cell_size[i]);
+
+		if (below > 0)
+			outside_sq += below * below;
+		else if (above > 0)
+			outside_sq += above * above;
+	}
+
+	bool inside = false;
+	if (outside_sq == 0) {
+		inside = (fence->cell_inside[cell / 8] >> (cell % 8)) & 1;
+
+		for (int i = fence->cell_start[cell]; i < fence->cell_start[cell + 1]; i++) {
+			if (edge_crosses(&fence->edges[fence->cell_edges[i]], fence->cell_ref[cell], point))
+				inside = !inside;
+		}
+	}
+
+	if (distance == NULL)
+		return inside;
+
+	// The last nearest edge is likely still close, it bounds the search
+	uint16_t best_edge = cursor->nearest_edge;
+	if (best_edge >= fence->num_edges)
+		best_edge = 0;
+	float best_sq = edge_distance_sq(&fence->edges[best_edge], point);
+
+	for (int ring = 0; ; ring++) {
+		if (ring > 0) {
+			// The cells of this ring are at least ring - 1 cells away
+			float gap = (ring - 1) * fence->min_cell_size;
+			if (outside_sq + gap * gap >= best_sq)
+				break;
+		}
+
+		if (!search_ring(fence, row, col, ring, point, &best_sq, &best_edge))
+			break;
+	}
+
+	cursor->nearest_edge = best_edge;
+	*distance = sqrtf(best_sq);
+
+	return inside;
+}
+
+/**
+ * @}
+ * @}
+ */
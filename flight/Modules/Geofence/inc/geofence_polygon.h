@@ -0,0 +1,70 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup GeoFence GeoFence Module
+ * @{
+ *
+ * @file       geofence_polygon.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @brief      Polygon fence with a grid index over its edges
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef GEOFENCE_POLYGON_H
+#define GEOFENCE_POLYGON_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//! Most cells along each side of the grid
+#define GEOFENCE_GRID_MAX 32
+
+//! Room in the index for the cells each edge crosses, on average
+#define GEOFENCE_CELLS_PER_EDGE 4
+
+//! Most vertices of a fence, the index of its edges is addressed with 16 bits
+#define GEOFENCE_MAX_VERTICES (UINT16_MAX / GEOFENCE_CELLS_PER_EDGE)
+
+struct geofence_polygon;
+
+/*
+ * What a caller remembers between checks of a moving point. The nearest
+ * edge of the last check bounds the search for the next one.
+ */
+struct geofence_cursor {
+	uint16_t nearest_edge;
+};
+
+struct geofence_polygon *geofence_polygon_create(uint16_t max_vertices);
+void geofence_polygon_destroy(struct geofence_polygon *fence);
+void geofence_polygon_set_vertex(struct geofence_polygon *fence, uint16_t idx, const float *vertex);
+int32_t geofence_polygon_build(struct geofence_polygon *fence, uint16_t num_vertices);
+
+void geofence_cursor_init(struct geofence_cursor *cursor);
+bool geofence_polygon_check(const struct geofence_polygon *fence, struct geofence_cursor *cursor,
+		const float *point, float *distance);
+
+#endif /* GEOFENCE_POLYGON_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -76,6 +76,7 @@
 // Private variables
 static struct pios_thread *pathfollowerTaskHandle;
 static PathDesiredData pathDesired;
+static struct path_segment pathSegment;
 static GroundPathFollowerSettingsData guidanceSettings;
 
 // Private functions
@@ -257,7 +258,8 @@ static void updatePathVelocity()
 	float cur[3] = {positionActual.North, positionActual.East, positionActual.Down};
 	struct path_status progress;
 
-	path_progress(&pathDesired, cur, &progress);
+	path_segment_update(&pathSegment, &pathDesired);
+	path_segment_progress(&pathSegment, cur, &progress);
 
 	// Update the path status UAVO
 	PathStatusData pathStatus;
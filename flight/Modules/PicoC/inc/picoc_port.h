@@ -55,6 +55,11 @@ size_t PlatformHeapSize();
 void PlatformDebug(const char *format, ...);
 int picoc(const char *source, size_t stack_size);
 
+/* precompiled scripts are read and written through this, returns 0 on success */
+typedef int32_t (*picoc_image_fn)(void *ctx, void *data, uint32_t len);
+int32_t picoc_compile(const char *source, size_t stack_size, picoc_image_fn write, void *ctx);
+bool picoc_run_compiled(const char *source, size_t stack_size, picoc_image_fn read, void *ctx, int *exit_value);
+
 /* get all picoc definitions */
 #include "picoc.h"
 
@@ -52,6 +52,7 @@ extern struct flashfs_logfs_cfg flashfs_waypoints_cfg;
 #define PICOC_STACKSIZE_MIN		(10*1024)
 #define PICOC_STACKSIZE_MAX		(128*1024)
 #define PICOC_SOURCE_FILE_TYPE	0X00704300		/* mark picoc sources with this ID */
+#define PICOC_IMAGE_FILE_TYPE	0X00704400		/* mark precompiled sources with this ID */
 #define PICOC_SECTOR_SIZE		48				/* size of filesystem object (less than slot_size - sizeof(slot_header) */
 #define SOH	0x01	/* (^A) start of heading */
 #define STX	0x02	/* (^B) start of text */
@@ -67,6 +68,15 @@ static char *sourcebuffer;
 static uint32_t sourcebuffer_size;
 static PicoCSettingsData picocsettings;
 static PicoCStatusData picocstatus;
+static int16_t image_file = -1;	/* the file the source buffer was loaded from or saved to */
+
+/* a precompiled source is streamed to and from flash through this */
+struct image_stream {
+	uint32_t file_id;
+	uint16_t sector_id;
+	uint8_t pos;
+	uint8_t sector[PICOC_SECTOR_SIZE];
+};
 
 // Private functions
 static void picocTask(void *parameters);
@@ -77,6 +87,9 @@ int32_t set_sector(uint16_t sector, char *buffer, uint32_t buffer_size);
 int32_t load_file(uint8_t file, char *buffer, uint32_t buffer_size);
 int32_t save_file(uint8_t file, char *buffer, uint32_t buffer_size);
 int32_t delete_file(uint8_t file);
+static int32_t image_write(void *ctx, void *data, uint32_t len);
+static int32_t image_read(void *ctx, void *data, uint32_t len);
+static int16_t run_file(const char *source);
 int32_t format_partition();
 
 /**
@@ -178,7 +191,7 @@ static void picocTask(void *parameters) {
 				// external start request
 				picocstatus.ExitValue = 0;
 				PicoCStatusExitValueSet(&picocstatus.ExitValue);
-				picocstatus.ExitValue = picoc(sourcebuffer, picocsettings.PicoCStackSize);
+				picocstatus.ExitValue = run_file(sourcebuffer);
 				PicoCStatusExitValueSet(&picocstatus.ExitValue);
 				picocstatus.CommandError = 0;
 				picocstatus.Command = PICOCSTATUS_COMMAND_IDLE;
@@ -269,7 +282,7 @@ static void picocTask(void *parameters) {
 				// terminate source for security.
 				sourcebuffer[sourcebuffer_size - 1] = 0;
 				// start picoc in file mode.
-				picocstatus.ExitValue = picoc(sourcebuffer, picocsettings.PicoCStackSize);
+				picocstatus.ExitValue = run_file(sourcebuffer);
 				started = true;
 				break;
 			default:
@@ -435,6 +448,7 @@ int32_t load_file(uint8_t file, char *buffer, uint32_t buffer_size)
 		buffer[i] = eof ? 0 : sector[i % PICOC_SECTOR_SIZE];
 		eof |= (buffer[i] == 0);
 	}
+	image_file = file;
 	return 0;
 }
 
@@ -461,6 +475,18 @@ int32_t save_file(uint8_t file, char *buffer, uint32_t buffer_size)
 			}
 		}
 	}
+	image_file = file;
+
+	if (retval == 0) {
+		// precompile the source, so it starts without lexing it
+		struct image_stream stream = { .file_id = PICOC_IMAGE_FILE_TYPE + file };
+		buffer[buffer_size - 1] = 0;
+		if ((picoc_compile(buffer, picocsettings.PicoCStackSize, image_write, &stream) != 0) ||
+			(image_write(&stream, NULL, 0) != 0)) {
+			// a partial image must not be found later
+			PIOS_FLASHFS_ObjDelete(pios_waypoints_settings_fs_id, stream.file_id, 0);
+		}
+	}
 	return retval;
 }
 
@@ -471,9 +497,84 @@ int32_t delete_file(uint8_t file)
 {
 	uint32_t file_id = PICOC_SOURCE_FILE_TYPE + file;
 	int32_t retval = PIOS_FLASHFS_ObjDelete(pios_waypoints_settings_fs_id, file_id, 0);
+	// the precompiled source starts with its header in the first sector
+	PIOS_FLASHFS_ObjDelete(pios_waypoints_settings_fs_id, PICOC_IMAGE_FILE_TYPE + file, 0);
 	return retval;
 }
 
+/**
+ * write to a precompiled source in flash
+ * a call without data saves the last partial sector
+ */
+static int32_t image_write(void *ctx, void *data, uint32_t len)
+{
+	struct image_stream *stream = ctx;
+
+	if (data == NULL) {
+		if (stream->pos == 0) {
+			return 0;
+		}
+		// pad it with zeros
+		len = PICOC_SECTOR_SIZE - stream->pos;
+	}
+
+	for (uint32_t i = 0; i < len; i++) {
+		stream->sector[stream->pos++] = data ? ((uint8_t *)data)[i] : 0;
+		if (stream->pos == PICOC_SECTOR_SIZE) {
+			if (PIOS_FLASHFS_ObjSave(pios_waypoints_settings_fs_id, stream->file_id, stream->sector_id++, stream->sector, PICOC_SECTOR_SIZE) != 0) {
+				return -1;
+			}
+			stream->pos = 0;
+		}
+	}
+	return 0;
+}
+
+/**
+ * read from a precompiled source in flash
+ */
+static int32_t image_read(void *ctx, void *data, uint32_t len)
+{
+	struct image_stream *stream = ctx;
+
+	for (uint32_t i = 0; i < len; i++) {
+		if (stream->pos == 0) {
+			if (PIOS_FLASHFS_ObjLoad(pios_waypoints_settings_fs_id, stream->file_id, stream->sector_id, stream->sector, PICOC_SECTOR_SIZE) != 0) {
+				return -1;
+			}
+		}
+		((uint8_t *)data)[i] = stream->sector[stream->pos++];
+		if (stream->pos == PICOC_SECTOR_SIZE) {
+			stream->sector_id++;
+			stream->pos = 0;
+		}
+	}
+	return 0;
+}
+
+/**
+ * run the source buffer
+ * the precompiled source of the file it came from is used if it matches
+ */
+static int16_t run_file(const char *source)
+{
+	uint32_t start_time = PIOS_Thread_Systime();
+	int exit_value = 0;
+	bool precompiled = false;
+
+	if (image_file >= 0) {
+		struct image_stream stream = { .file_id = PICOC_IMAGE_FILE_TYPE + image_file };
+		precompiled = picoc_run_compiled(source, picocsettings.PicoCStackSize, image_read, &stream, &exit_value);
+	}
+	if (!precompiled) {
+		exit_value = picoc(source, picocsettings.PicoCStackSize);
+	}
+
+	uint32_t run_time = PIOS_Thread_Systime() - start_time;
+	PicoCStatusRunTimeSet(&run_time);
+	return exit_value;
+}
+
 /**
  * format flash partition
  */
@@ -38,6 +38,7 @@
 #include "picocstatus.h"
 #include <setjmp.h>
 #include "pios_thread.h"
+#include "pios_crc.h"
 
 // Private variables
 static char *heap_memory;
@@ -62,6 +63,61 @@ jmp_buf PicocExitBuf;
 #include "inc/include.c"
 #include "inc/debug.c"
 
+/**
+ * precompiled scripts
+ * The token stream the lexer produces is what picoc runs. It is stored
+ * in flash next to the source, with the identifiers and string constants
+ * written out in full, as in memory they point into the string table of
+ * a particular run. Loading it back only registers these strings, which
+ * saves lexing the source and the large scratch buffer the lexer needs.
+ */
+#define PICOC_IMAGE_MAGIC	0x31494350	/* "PCI1" */
+#define PICOC_IMAGE_VERSION	1
+
+struct picoc_image_header {
+	uint32_t magic;
+	uint8_t version;
+	uint8_t pointer_size;	/* the token stream is only valid on the same platform */
+	uint8_t long_size;
+	uint8_t fp_size;
+	uint32_t source_len;	/* the source it was made from */
+	uint32_t source_crc;
+	uint32_t token_len;	/* bytes of the token stream in memory */
+	uint32_t image_len;	/* bytes following this header */
+};
+
+/**
+ * report how long it took to get the tokens of the script
+ */
+static void picoc_loaded(uint32_t start_time, bool precompiled)
+{
+	uint32_t load_time = PIOS_DELAY_DiffuS(start_time);
+	uint8_t image = precompiled ? PICOCSTATUS_PRECOMPILED_TRUE : PICOCSTATUS_PRECOMPILED_FALSE;
+
+	PicoCStatusLoadTimeSet(&load_time);
+	PicoCStatusPrecompiledSet(&image);
+}
+
+/**
+ * run a token stream and free it. this does the same as PicocParse()
+ */
+static void picoc_run_tokens(Picoc *pc, const char *source, void *tokens)
+{
+	struct ParseState Parser;
+	enum ParseResult Ok;
+
+	LexInitParser(&Parser, pc, source, tokens, TableStrRegister(pc, "nofile"), true, false);
+
+	do {
+		Ok = ParseStatement(&Parser, true);
+	} while (Ok == ParseResultOk);
+
+	if (Ok == ParseResultError)
+		ProgramFail(&Parser, "parse error");
+
+	HeapFreeMem(pc, tokens);
+}
+
 /**
  * picoc main program
  * parses source or switches to interactive mode
@@ -80,7 +136,10 @@ int picoc(const char * source, size_t stack_size)
 
 	if (source)
 	{	/* start with complete source file */
-		PicocParse(&pc, "nofile", source, strlen(source), true, true, false, false);
+		uint32_t start_time = PIOS_DELAY_GetRaw();
+		void *tokens = LexAnalyse(&pc, TableStrRegister(&pc, "nofile"), source, strlen(source), NULL);
+		picoc_loaded(start_time, false);
+		picoc_run_tokens(&pc, source, tokens);
 	}
 	else
 	{	/* start interactive */
@@ -91,6 +150,207 @@ int picoc(const char * source, size_t stack_size)
 	return pc.PicocExitValue;
 }
 
+/**
+ * fill in the header for a source and its tokens
+ */
+static void picoc_image_header(struct picoc_image_header *header, const char *source, uint32_t token_len)
+{
+	memset(header, 0, sizeof(*header));
+	header->magic = PICOC_IMAGE_MAGIC;
+	header->version = PICOC_IMAGE_VERSION;
+	header->pointer_size = sizeof(char *);
+	header->long_size = sizeof(long);
+	header->fp_size = sizeof(double);
+	header->source_len = strlen(source);
+	header->source_crc = PIOS_CRC32_updateCRC(0, (const uint8_t *)source, header->source_len);
+	header->token_len = token_len;
+}
+
+/**
+ * write a token stream out, or only count its size if write is NULL
+ * returns the size of the image body or -1 if writing failed
+ */
+static int32_t picoc_write_tokens(const uint8_t *tokens, uint32_t token_len, picoc_image_fn write, void *ctx)
+{
+	uint32_t image_len = 0;
+	uint32_t pos = 0;
+
+	while (pos < token_len) {
+		enum LexToken token = tokens[pos];
+		int value_size = LexTokenSize(token);
+
+		if (write && write(ctx, (void *)&tokens[pos], TOKEN_DATA_OFFSET))
+			return -1;
+		image_len += TOKEN_DATA_OFFSET;
+		pos += TOKEN_DATA_OFFSET;
+
+		if (token == TokenIdentifier || token == TokenStringConstant) {
+			/* the string itself instead of the pointer */
+			char *str;
+			memcpy(&str, &tokens[pos], sizeof(str));
+			uint16_t len = strlen(str);
+
+			if (write && (write(ctx, &len, sizeof(len)) || write(ctx, str, len)))
+				return -1;
+			image_len += sizeof(len) + len;
+		} else if (value_size > 0) {
+			if (write && write(ctx, (void *)&tokens[pos], value_size))
+				return -1;
+			image_len += value_size;
+		}
+		pos += value_size;
+	}
+
+	return image_len;
+}
+
+/**
+ * read a token stream back into the picoc heap
+ * returns the tokens or NULL if the image is damaged
+ */
+static void *picoc_read_tokens(Picoc *pc, const struct picoc_image_header *header, picoc_image_fn read, void *ctx)
+{
+	uint8_t *tokens = HeapAllocMem(pc, header->token_len);
+	uint32_t pos = 0;
+	enum LexToken token = TokenNone;
+
+	if (tokens == NULL)
+		return NULL;
+
+	while (token != TokenEOF) {
+		if (pos + TOKEN_DATA_OFFSET > header->token_len ||
+		    read(ctx, &tokens[pos], TOKEN_DATA_OFFSET))
+			goto fail;
+
+		token = tokens[pos];
+		int value_size = LexTokenSize(token);
+		pos += TOKEN_DATA_OFFSET;
+
+		if (pos + value_size > header->token_len)
+			goto fail;
+
+		if (token == TokenIdentifier || token == TokenStringConstant) {
+			uint16_t len;
+			if (read(ctx, &len, sizeof(len)))
+				goto fail;
+
+			char *buf = HeapAllocStack(pc, len);
+			if (buf == NULL)
+				goto fail;
+			bool read_ok = (read(ctx, buf, len) == 0);
+			char *str = TableStrRegister2(pc, buf, len);
+			HeapPopStack(pc, buf, len);
+			if (!read_ok)
+				goto fail;
+
+			if (token == TokenStringConstant && VariableStringLiteralGet(pc, str) == NULL) {
+				/* create and store this string literal, as the lexer does */
+				struct Value *array = VariableAllocValueAndData(pc, NULL, 0, false, NULL, true);
+				array->Typ = pc->CharArrayType;
+				array->Val = (union AnyValue *)str;
+				VariableStringLiteralDefine(pc, str, array);
+			}
+
+			memcpy(&tokens[pos], &str, sizeof(str));
+		} else if (value_size > 0) {
+			if (read(ctx, &tokens[pos], value_size))
+				goto fail;
+		}
+		pos += value_size;
+	}
+
+	if (pos == header->token_len)
+		return tokens;
+
+fail:
+	HeapFreeMem(pc, tokens);
+	return NULL;
+}
+
+/**
+ * precompile a source
+ * writes the header and the tokens through write()
+ * returns 0 on success or -1 if the source could not be lexed or written
+ */
+int32_t picoc_compile(const char *source, size_t stack_size, picoc_image_fn write, void *ctx)
+{
+	Picoc pc;
+	struct picoc_image_header header;
+	void *tokens;
+	int token_len;
+	int32_t retval = -1;
+
+	PicocInitialise(&pc, stack_size);
+
+	if (PicocPlatformSetExitPoint(&pc))
+	{	/* the lexer failed */
+		PicocCleanup(&pc);
+		return -1;
+	}
+
+	tokens = LexAnalyse(&pc, TableStrRegister(&pc, "nofile"), source, strlen(source), &token_len);
+
+	picoc_image_header(&header, source, token_len);
+	int32_t image_len = picoc_write_tokens(tokens, token_len, NULL, NULL);
+	if (image_len >= 0) {
+		header.image_len = image_len;
+		if ((write(ctx, &header, sizeof(header)) == 0) &&
+		    (picoc_write_tokens(tokens, token_len, write, ctx) == image_len)) {
+			retval = 0;
+		}
+	}
+
+	HeapFreeMem(&pc, tokens);
+	PicocCleanup(&pc);
+	return retval;
+}
+
+/**
+ * run a precompiled source
+ * the image is read through read(), and must have been made from source.
+ * returns true if it was run, with the exit() value in exit_value. if not
+ * the image does not match the source or is damaged.
+ */
+bool picoc_run_compiled(const char *source, size_t stack_size, picoc_image_fn read, void *ctx, int *exit_value)
+{
+	Picoc pc;
+	struct picoc_image_header header;
+	struct picoc_image_header expected;
+	volatile bool loaded = false;
+	uint32_t start_time = PIOS_DELAY_GetRaw();
+
+	if (read(ctx, &header, sizeof(header)))
+		return false;
+
+	picoc_image_header(&expected, source, header.token_len);
+	expected.image_len = header.image_len;
+	if (memcmp(&header, &expected, sizeof(header)) != 0)
+		return false;
+
+	PicocInitialise(&pc, stack_size);
+
+	if (PicocPlatformSetExitPoint(&pc))
+	{	/* we get here, if an error occures or 'exit();' was called. */
+		PicocCleanup(&pc);
+		*exit_value = pc.PicocExitValue;
+		return loaded;
+	}
+
+	void *tokens = picoc_read_tokens(&pc, &header, read, ctx);
+	if (tokens == NULL) {
+		PicocCleanup(&pc);
+		return false;
+	}
+	loaded = true;
+	picoc_loaded(start_time, true);
+
+	picoc_run_tokens(&pc, source, tokens);
+
+	PicocCleanup(&pc);
+	*exit_value = pc.PicocExitValue;
+	return true;
+}
+
 /**
  * PicoC platform depending system functions
  * normaly stored in platform_xxx.c
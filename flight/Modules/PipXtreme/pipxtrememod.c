@@ -105,6 +105,7 @@ static void systemTask(void *parameters)
 	uint32_t lastSysTime;
     uint16_t prev_tx_count = 0;
     uint16_t prev_rx_count = 0;
+    uint16_t prev_payload_count = 0;
     bool first_time = true;
 
     /* create all modules thread */
@@ -152,6 +153,7 @@ static void systemTask(void *parameters)
 			rfm22bStatus.Timeouts = radio_stats.timeouts;
 			rfm22bStatus.RSSI = radio_stats.rssi;
 			rfm22bStatus.LinkQuality = radio_stats.link_quality;
+			rfm22bStatus.TxParity = radio_stats.tx_parity;
 			if (first_time) {
 				first_time = false;
 			} else {
@@ -172,11 +174,17 @@ static void systemTask(void *parameters)
 				rfm22bStatus.TXRate =
 				    (uint16_t) ((float)(tx_bytes * 1000) /
 						SYSTEM_UPDATE_PERIOD_MS);
+				uint16_t payload_count = radio_stats.rx_payload_count;
+				uint16_t payload_bytes = payload_count - prev_payload_count;
 				rfm22bStatus.RXRate =
 				    (uint16_t) ((float)(rx_bytes * 1000) /
 						SYSTEM_UPDATE_PERIOD_MS);
+				rfm22bStatus.RxGoodput =
+				    (uint16_t) ((float)(payload_bytes * 1000) /
+						SYSTEM_UPDATE_PERIOD_MS);
 				prev_tx_count = tx_count;
 				prev_rx_count = rx_count;
+				prev_payload_count = payload_count;
 			}
 			rfm22bStatus.LinkState = radio_stats.link_state;
 		} else {
@@ -7,7 +7,7 @@
  *
  * @file       RadioComBridge.c
  * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2012.
- * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013-2014
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013-2015
  * @brief      Bridges from RFM22b comm channel to another PIOS_COM channel
  *             has the ability to hook and process UAVO packets for the radio
  *             board (e.g. TauLink)
@@ -65,10 +65,26 @@
 #define MAX_PORT_DELAY    200
 #define SERIAL_RX_BUF_LEN 100
 #define PPM_INPUT_TIMEOUT 100
+#define RELAY_CHUNK_LEN   32
+
+#define MetaObjectId(x) (x+1)
 
 // ****************
 // Private types
 
+//! Checks the framing of UAVTalk packets that are relayed without decoding them
+struct relay_framer {
+	uint8_t *buf;
+	uint16_t len;
+	uint16_t size;
+	uint8_t cs;
+
+	uint32_t packets;	//!< packets relayed unchanged
+	uint32_t bytes;		//!< bytes received
+	uint32_t syncErrors;
+	uint32_t crcErrors;
+};
+
 typedef struct {
 	// The task handles.
 	struct pios_thread *telemetryTxTaskHandle;
@@ -89,10 +105,19 @@ typedef struct {
 	// The raw serial Rx buffer
 	uint8_t serialRxBuf[SERIAL_RX_BUF_LEN];
 
+	// Framing of the relayed streams
+	struct relay_framer telemetryFramer;
+	struct relay_framer radioFramer;
+
 	// Error statistics.
 	uint32_t telemetryTxRetries;
 	uint32_t radioTxRetries;
 
+	// Throughput measurement
+	uint32_t lastStatsTime;
+	uint32_t lastTelemetryRxBytes;
+	uint32_t lastRadioRxBytes;
+
 	// Is this modem the coordinator
 	bool isCoordinator;
 
@@ -117,6 +142,13 @@ static void ProcessTelemetryStream(UAVTalkConnection inConnectionHandle,
 static void ProcessRadioStream(UAVTalkConnection inConnectionHandle,
 			       UAVTalkConnection outConnectionHandle,
 			       uint8_t rxbyte);
+static bool RelayFrameByte(struct relay_framer *framer, uint8_t rxbyte);
+static void RelayStream(struct relay_framer *framer,
+			UAVTalkConnection inConnectionHandle,
+			UAVTalkConnection outConnectionHandle,
+			const uint8_t *rxbuf, uint16_t rxlen,
+			const uint32_t *intercepted, uint8_t num_intercepted,
+			void (*process)(UAVTalkConnection, UAVTalkConnection, uint8_t));
 static void objectPersistenceUpdatedCb(UAVObjEvent * objEv);
 static void registerObject(UAVObjHandle obj);
 
@@ -125,6 +157,35 @@ static void registerObject(UAVObjHandle obj);
 
 static RadioComBridgeData *data;
 
+/*
+ * The objects the modem handles itself. Packets of all other objects are
+ * relayed unchanged once their framing and checksum are verified.
+ */
+static const uint32_t telemetryIntercepted[] = {
+	HWTAULINK_OBJID,
+	MetaObjectId(HWTAULINK_OBJID),
+	RFM22BRECEIVER_OBJID,
+	MetaObjectId(RFM22BRECEIVER_OBJID),
+	RFM22BSTATUS_OBJID,
+	MetaObjectId(RFM22BSTATUS_OBJID),
+	OBJECTPERSISTENCE_OBJID,
+	MetaObjectId(OBJECTPERSISTENCE_OBJID),
+};
+
+static const uint32_t radioIntercepted[] = {
+	HWTAULINK_OBJID,
+	MetaObjectId(HWTAULINK_OBJID),
+	RFM22BRECEIVER_OBJID,
+	MetaObjectId(RFM22BRECEIVER_OBJID),
+	RFM22BSTATUS_OBJID,
+	MetaObjectId(RFM22BSTATUS_OBJID),
+	FLIGHTBATTERYSTATE_OBJID,
+	FLIGHTSTATUS_OBJID,
+	POSITIONACTUAL_OBJID,
+	VELOCITYACTUAL_OBJID,
+	BAROALTITUDE_OBJID,
+};
+
 /**
  * @brief Start the module
  *
@@ -214,6 +275,15 @@ static int32_t RadioComBridgeInitialize(void)
 	data->telemUAVTalkCon = UAVTalkInitialize(&UAVTalkSendHandler);
 	data->radioUAVTalkCon = UAVTalkInitialize(&RadioSendHandler);
 
+	// Buffers for the packets that are relayed
+	memset(&data->telemetryFramer, 0, sizeof(data->telemetryFramer));
+	memset(&data->radioFramer, 0, sizeof(data->radioFramer));
+	data->telemetryFramer.buf = PIOS_malloc(UAVTALK_MAX_PACKET_LENGTH);
+	data->radioFramer.buf = PIOS_malloc(UAVTALK_MAX_PACKET_LENGTH);
+	if (!data->telemetryFramer.buf || !data->radioFramer.buf) {
+		return -1;
+	}
+
 	// Initialize the queues.
 	data->uavtalkEventQueue = PIOS_Queue_Create(EVENT_QUEUE_SIZE, sizeof(UAVObjEvent));
 	data->radioEventQueue = PIOS_Queue_Create(EVENT_QUEUE_SIZE, sizeof(UAVObjEvent));
@@ -221,6 +291,9 @@ static int32_t RadioComBridgeInitialize(void)
 	// Initialize the statistics.
 	data->telemetryTxRetries = 0;
 	data->radioTxRetries = 0;
+	data->lastStatsTime = PIOS_Thread_Systime();
+	data->lastTelemetryRxBytes = 0;
+	data->lastRadioRxBytes = 0;
 
 	data->parseUAVTalk = true;
 
@@ -272,22 +345,36 @@ static void updateRadioComBridgeStats()
 	radioComBridgeStats.TelemetryTxRetries = data->telemetryTxRetries;
 	radioComBridgeStats.RadioTxRetries = data->radioTxRetries;
 
-	// Update stats object
-	radioComBridgeStats.TelemetryTxBytes +=
-	    telemetryUAVTalkStats.txBytes;
-	radioComBridgeStats.TelemetryTxFailures +=
-	    telemetryUAVTalkStats.txErrors;
-
-	radioComBridgeStats.TelemetryRxBytes +=
-	    telemetryUAVTalkStats.rxBytes;
-	radioComBridgeStats.TelemetryRxFailures +=
-	    telemetryUAVTalkStats.rxErrors;
-
-	radioComBridgeStats.RadioTxBytes += radioUAVTalkStats.txBytes;
-	radioComBridgeStats.RadioTxFailures += radioUAVTalkStats.txErrors;
-
-	radioComBridgeStats.RadioRxBytes += radioUAVTalkStats.rxBytes;
-	radioComBridgeStats.RadioRxFailures += radioUAVTalkStats.rxErrors;
+	// Update stats object, the counters are totals since startup.
+	// Relayed packets only pass the UAVTalk parser if they are intercepted.
+	radioComBridgeStats.TelemetryTxBytes = telemetryUAVTalkStats.txBytes;
+	radioComBridgeStats.TelemetryTxFailures = telemetryUAVTalkStats.txErrors;
+
+	radioComBridgeStats.TelemetryRxBytes = data->telemetryFramer.bytes;
+	radioComBridgeStats.TelemetryRxFailures = telemetryUAVTalkStats.rxErrors;
+	radioComBridgeStats.TelemetryRxSyncErrors = data->telemetryFramer.syncErrors;
+	radioComBridgeStats.TelemetryRxCrcErrors = data->telemetryFramer.crcErrors;
+	radioComBridgeStats.TelemetryRelayedPackets = data->telemetryFramer.packets;
+
+	radioComBridgeStats.RadioTxBytes = radioUAVTalkStats.txBytes;
+	radioComBridgeStats.RadioTxFailures = radioUAVTalkStats.txErrors;
+
+	radioComBridgeStats.RadioRxBytes = data->radioFramer.bytes;
+	radioComBridgeStats.RadioRxFailures = radioUAVTalkStats.rxErrors;
+	radioComBridgeStats.RadioRxSyncErrors = data->radioFramer.syncErrors;
+	radioComBridgeStats.RadioRxCrcErrors = data->radioFramer.crcErrors;
+	radioComBridgeStats.RadioRelayedPackets = data->radioFramer.packets;
+
+	// Throughput since the last update
+	uint32_t now = PIOS_Thread_Systime();
+	uint32_t dT = now - data->lastStatsTime;
+	if (dT > 0) {
+		radioComBridgeStats.TelemetryRxRate = (data->telemetryFramer.bytes - data->lastTelemetryRxBytes) * 1000 / dT;
+		radioComBridgeStats.RadioRxRate = (data->radioFramer.bytes - data->lastRadioRxBytes) * 1000 / dT;
+	}
+	data->lastStatsTime = now;
+	data->lastTelemetryRxBytes = data->telemetryFramer.bytes;
+	data->lastRadioRxBytes = data->radioFramer.bytes;
 
 	// Update stats object data
 	RadioComBridgeStatsSet(&radioComBridgeStats);
@@ -385,7 +472,7 @@ static void radioRxTask( __attribute__ ((unused))
 		PIOS_WDG_UpdateFlag(PIOS_WDG_RADIORX);
 #endif
 		if (PIOS_COM_RFM22B) {
-			uint8_t serial_data[1];
+			uint8_t serial_data[RELAY_CHUNK_LEN];
 			uint16_t bytes_to_process =
 			    PIOS_COM_ReceiveBuffer(PIOS_COM_RFM22B,
 						   serial_data,
@@ -393,16 +480,13 @@ static void radioRxTask( __attribute__ ((unused))
 						   MAX_PORT_DELAY);
 			if (bytes_to_process > 0) {
 				if (data->parseUAVTalk) {
-					// Pass the data through the UAVTalk parser.
-					for (uint8_t i = 0;
-					     i < bytes_to_process; i++) {
-						ProcessRadioStream(data->
-								   radioUAVTalkCon,
-								   data->
-								   telemUAVTalkCon,
-								   serial_data
-								   [i]);
-					}
+					// Relay the packets, only the intercepted ones are parsed.
+					RelayStream(&data->radioFramer,
+						    data->radioUAVTalkCon,
+						    data->telemUAVTalkCon,
+						    serial_data, bytes_to_process,
+						    radioIntercepted, NELEMENTS(radioIntercepted),
+						    ProcessRadioStream);
 				} else if (PIOS_COM_TELEMETRY) {
 					// Send the data straight to the telemetry port.
 					// Following call can fail with -2 error code (buffer full) or -3 error code (could not acquire send mutex)
@@ -446,22 +530,19 @@ static void telemetryRxTask( __attribute__ ((unused))
 		}
 #endif /* PIOS_INCLUDE_USB */
 		if (inputPort) {
-			uint8_t serial_data[1];
+			uint8_t serial_data[RELAY_CHUNK_LEN];
 			uint16_t bytes_to_process =
 			    PIOS_COM_ReceiveBuffer(inputPort, serial_data,
 						   sizeof(serial_data),
 						   MAX_PORT_DELAY);
 			if (bytes_to_process > 0) {
 				PIOS_LED_Toggle(PIOS_LED_RX);
-				for (uint8_t i = 0; i < bytes_to_process;
-				     i++) {
-					ProcessTelemetryStream(data->
-							       telemUAVTalkCon,
-							       data->
-							       radioUAVTalkCon,
-							       serial_data
-							       [i]);
-				}
+				RelayStream(&data->telemetryFramer,
+					    data->telemUAVTalkCon,
+					    data->radioUAVTalkCon,
+					    serial_data, bytes_to_process,
+					    telemetryIntercepted, NELEMENTS(telemetryIntercepted),
+					    ProcessTelemetryStream);
 			}
 		} else {
 			PIOS_Thread_Sleep(5);
@@ -606,7 +687,105 @@ static int32_t RadioSendHandler(uint8_t * buf, int32_t length)
 	}
 }
 
-#define MetaObjectId(x) (x+1)
+/**
+ * @brief Check the framing of a relayed UAVTalk stream
+ *
+ * The packet is collected in the framer's buffer as it was received.
+ *
+ * @param[in] framer  The framing state of the stream
+ * @param[in] rxbyte  The received byte
+ * @return true when a packet with a valid checksum is complete
+ */
+static bool RelayFrameByte(struct relay_framer *framer, uint8_t rxbyte)
+{
+	framer->bytes++;
+
+	if (framer->len == 0) {
+		if (rxbyte != UAVTALK_SYNC_VAL) {
+			return false;
+		}
+		framer->cs = 0;
+		framer->size = 0;
+	}
+
+	framer->buf[framer->len++] = rxbyte;
+
+	// Everything up to the checksum is covered by it
+	if (framer->size == 0 || framer->len <= framer->size) {
+		framer->cs = PIOS_CRC_updateByte(framer->cs, rxbyte);
+	}
+
+	if (framer->len == 2 && (rxbyte & UAVTALK_TYPE_MASK) != UAVTALK_TYPE_VER) {
+		framer->syncErrors++;
+		framer->len = 0;
+	} else if (framer->len == 4) {
+		framer->size = framer->buf[2] | (framer->buf[3] << 8);
+		if (framer->size < UAVTALK_MIN_HEADER_LENGTH ||
+		    framer->size > UAVTALK_MAX_HEADER_LENGTH + UAVTALK_MAX_PAYLOAD_LENGTH) {
+			framer->syncErrors++;
+			framer->len = 0;
+		}
+	} else if (framer->size && framer->len == framer->size + UAVTALK_CHECKSUM_LENGTH) {
+		framer->len = 0;
+		if (rxbyte != framer->cs) {
+			framer->crcErrors++;
+			return false;
+		}
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * @brief Relay a received chunk of a UAVTalk stream
+ *
+ * Complete packets are sent on unchanged in one write, except for those of
+ * the intercepted objects, which go through the UAVTalk parser.
+ *
+ * @param[in] framer  The framing state of the input stream
+ * @param[in] inConnectionHandle  The UAVTalk connection the data was received on
+ * @param[in] outConnectionHandle  The UAVTalk connection to relay the packets to
+ * @param[in] rxbuf  The received data
+ * @param[in] rxlen  The number of bytes received
+ * @param[in] intercepted  The object IDs which are handled by the modem
+ * @param[in] num_intercepted  The number of intercepted object IDs
+ * @param[in] process  The parser for the intercepted packets
+ */
+static void RelayStream(struct relay_framer *framer,
+			UAVTalkConnection inConnectionHandle,
+			UAVTalkConnection outConnectionHandle,
+			const uint8_t *rxbuf, uint16_t rxlen,
+			const uint32_t *intercepted, uint8_t num_intercepted,
+			void (*process)(UAVTalkConnection, UAVTalkConnection, uint8_t))
+{
+	for (uint16_t i = 0; i < rxlen; i++) {
+		if (!RelayFrameByte(framer, rxbuf[i])) {
+			continue;
+		}
+
+		uint16_t packet_len = framer->size + UAVTALK_CHECKSUM_LENGTH;
+		uint32_t objId = framer->buf[4] | (framer->buf[5] << 8) |
+			(framer->buf[6] << 16) | ((uint32_t)framer->buf[7] << 24);
+
+		bool intercept = false;
+		for (uint8_t j = 0; j < num_intercepted; j++) {
+			if (intercepted[j] == objId) {
+				intercept = true;
+				break;
+			}
+		}
+
+		if (intercept) {
+			for (uint16_t j = 0; j < packet_len; j++) {
+				process(inConnectionHandle, outConnectionHandle, framer->buf[j]);
+			}
+		} else if (UAVTalkSendBuf(outConnectionHandle, framer->buf, packet_len) == 0) {
+			framer->packets++;
+		}
+	}
+}
+
 /**
  * @brief Process a byte of data received on the telemetry stream
  *
@@ -35,6 +35,7 @@
 #include "pios_thread.h"
 #include "pios_queue.h"
 #include "misc_math.h"
+#include "profiler.h"
 
 // UAVOs
 #include "accels.h"
@@ -199,6 +200,8 @@ static void SensorsTask(void *parameters)
 			continue;
 		}
 
+		PROFILE_BEGIN(PROFILER_PROBE_SENSORS);
+
 		queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_ACCEL);
 		if (queue == NULL || PIOS_Queue_Receive(queue, &accels, 0) == false) {
 			//If no new accels data is ready, reuse the latest sample
@@ -243,6 +246,8 @@ static void SensorsTask(void *parameters)
 			AlarmsClear(SYSTEMALARMS_ALARM_SENSORS);
 		else
 			good_runs++;
+
+		PROFILE_END(PROFILER_PROBE_SENSORS);
 		
 		PIOS_WDG_UpdateFlag(PIOS_WDG_SENSORS);
 
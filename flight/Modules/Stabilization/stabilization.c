@@ -60,10 +60,18 @@
 #include "coordinate_conversions.h"
 #include "pid.h"
 #include "misc_math.h"
+#include "profiler.h"
 
 // Includes for various stabilization algorithms
 #include "virtualflybar.h"
 
+// The gyro notches need a few kB of RAM, which the F1 targets do not have
+#if !defined(SMALLF1)
+#define STABILIZATION_DYNAMIC_NOTCH
+#include "dynamic_notch.h"
+#include "dynamicnotchstatus.h"
+#endif
+
 // Private constants
 #define MAX_QUEUE_SIZE 1
 
@@ -83,6 +91,9 @@
 // Please adapt changes here also to the init of the plots  in /ground/gcs/src/plugins/config/configstabilizationwidget.cpp
 #define HORIZON_MODE_MAX_BLEND               0.85f
 
+//! Period to publish the DynamicNotchStatus
+#define DYNAMIC_NOTCH_STATUS_PERIOD_MS 500
+
 enum {
 	PID_GROUP_RATE,   // Rate controller settings
 	PID_RATE_ROLL = PID_GROUP_RATE,
@@ -122,11 +133,20 @@ struct pid pids[PID_MAX];
 
 volatile bool gyro_filter_updated = false;
 
+#if defined(STABILIZATION_DYNAMIC_NOTCH)
+static struct dyn_notch *dyn_notch;
+static bool dyn_notch_enabled = false;
+#endif
+
 // Private functions
 static void stabilizationTask(void* parameters);
 static void zero_pids(void);
 static void calculate_pids(void);
 static void SettingsUpdatedCb(UAVObjEvent * ev);
+#if defined(STABILIZATION_DYNAMIC_NOTCH)
+static void dynamic_notch_configure(float dT);
+static void dynamic_notch_filter(float gyro[3]);
+#endif
 
 /**
  * Module initialization
@@ -167,6 +187,9 @@ int32_t StabilizationInitialize()
 #if defined(RATEDESIRED_DIAGNOSTICS)
 	RateDesiredInitialize();
 #endif
+#if defined(STABILIZATION_DYNAMIC_NOTCH)
+	DynamicNotchStatusInitialize();
+#endif
 
 	return 0;
 }
@@ -217,6 +240,8 @@ static void stabilizationTask(void* parameters)
 			AlarmsSet(SYSTEMALARMS_ALARM_STABILIZATION,SYSTEMALARMS_ALARM_WARNING);
 			continue;
 		}
+
+		PROFILE_BEGIN(PROFILER_PROBE_STABILIZATION);
 		
 		calculate_pids();
 
@@ -250,6 +275,10 @@ static void stabilizationTask(void* parameters)
 				vbar_decay = expf(-dT_filtered / settings.VbarTau);
 			}
 
+#if defined(STABILIZATION_DYNAMIC_NOTCH)
+			dynamic_notch_configure(dT_filtered);
+#endif
+
 			gyro_filter_updated = false;
 		}
 
@@ -326,6 +355,12 @@ static void stabilizationTask(void* parameters)
 		// Wrap yaw error to [-180,180]
 		local_attitude_error[2] = circular_modulus_deg(local_attitude_error[2]);
 
+#if defined(STABILIZATION_DYNAMIC_NOTCH)
+		// Remove the motor noise peaks before the low pass filter
+		if (dyn_notch_enabled)
+			dynamic_notch_filter(&gyrosData.x);
+#endif
+
 		static float gyro_filtered[3];
 		gyro_filtered[0] = gyro_filtered[0] * gyro_alpha + gyrosData.x * (1 - gyro_alpha);
 		gyro_filtered[1] = gyro_filtered[1] * gyro_alpha + gyrosData.y * (1 - gyro_alpha);
@@ -789,6 +824,8 @@ static void stabilizationTask(void* parameters)
 			AlarmsSet(SYSTEMALARMS_ALARM_STABILIZATION,SYSTEMALARMS_ALARM_ERROR);
 		else
 			AlarmsClear(SYSTEMALARMS_ALARM_STABILIZATION);
+
+		PROFILE_END(PROFILER_PROBE_STABILIZATION);
 	}
 }
 
@@ -1006,6 +1043,72 @@ static void SettingsUpdatedCb(UAVObjEvent * ev)
 	}
 }
 
+#if defined(STABILIZATION_DYNAMIC_NOTCH)
+/**
+ * Configure the gyro notch filters from the settings. The filter bank is
+ * only allocated the first time it is enabled.
+ * @param[in] dT the period of the stabilization loop
+ */
+static void dynamic_notch_configure(float dT)
+{
+	dyn_notch_enabled = false;
+
+	if (settings.DynamicNotch != STABILIZATIONSETTINGS_DYNAMICNOTCH_ENABLED || dT <= 0)
+		return;
+
+	if (dyn_notch == NULL) {
+		dyn_notch = (struct dyn_notch *) PIOS_malloc(sizeof(struct dyn_notch));
+		if (dyn_notch == NULL)
+			return;
+	}
+
+	struct dyn_notch_config cfg = {
+		.sample_rate = 1.0f / dT,
+		.min_hz = settings.DynamicNotchRange[STABILIZATIONSETTINGS_DYNAMICNOTCHRANGE_MIN],
+		.max_hz = settings.DynamicNotchRange[STABILIZATIONSETTINGS_DYNAMICNOTCHRANGE_MAX],
+		.q = settings.DynamicNotchQ,
+		.num_notches = settings.DynamicNotchCount,
+	};
+
+	dyn_notch_enabled = dyn_notch_init(dyn_notch, &cfg);
+}
+
+/**
+ * Apply the gyro notch filters, measure the time they take and
+ * periodically publish the notch centers
+ * @param[in,out] gyro the gyro rates, filtered in place
+ */
+static void dynamic_notch_filter(float gyro[3])
+{
+	static float filter_time_average;
+	static float filter_time_max;
+	static uint32_t last_status_time;
+
+	uint32_t timeval = PIOS_DELAY_GetRaw();
+	dyn_notch_apply(dyn_notch, gyro);
+	float filter_time = PIOS_DELAY_DiffuS(timeval);
+
+	filter_time_average = 0.99f * filter_time_average + 0.01f * filter_time;
+	if (filter_time > filter_time_max)
+		filter_time_max = filter_time;
+
+	uint32_t now = PIOS_Thread_Systime();
+	if (now - last_status_time >= DYNAMIC_NOTCH_STATUS_PERIOD_MS) {
+		DynamicNotchStatusData status;
+
+		dyn_notch_get_centers(dyn_notch, ROLL, status.Roll);
+		dyn_notch_get_centers(dyn_notch, PITCH, status.Pitch);
+		dyn_notch_get_centers(dyn_notch, YAW, status.Yaw);
+		status.FilterTime[DYNAMICNOTCHSTATUS_FILTERTIME_AVERAGE] = filter_time_average;
+		status.FilterTime[DYNAMICNOTCHSTATUS_FILTERTIME_MAX] = filter_time_max;
+		DynamicNotchStatusSet(&status);
+
+		filter_time_max = 0;
+		last_status_time = now;
+	}
+}
+#endif /* STABILIZATION_DYNAMIC_NOTCH */
+
 
 /**
  * @}
@@ -43,6 +43,7 @@
 #include "taskinfo.h"
 #include "watchdogstatus.h"
 #include "taskmonitor.h"
+#include "profiler.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
 
@@ -127,6 +128,10 @@ int32_t SystemModInitialize(void)
 #if defined(DIAG_TASKS)
 	TaskInfoInitialize();
 #endif
+#if defined(DIAG_PROFILER)
+	TaskProfileInitialize();
+	ProfilerInitialize();
+#endif
 #if defined(WDG_STATS_DIAGNOSTICS)
 	WatchdogStatusInitialize();
 #endif
@@ -207,6 +212,12 @@ static void systemTask(void *parameters)
 		TaskMonitorUpdateAll();
 #endif
 
+#if defined(DIAG_PROFILER)
+		// Update the scheduling and hot path timing objects
+		TaskMonitorUpdateProfile();
+		ProfilerUpdateAll();
+#endif
+
 		// Flash the heartbeat LED
 #if defined(PIOS_LED_HEARTBEAT)
 		PIOS_LED_Toggle(PIOS_LED_HEARTBEAT);
@@ -376,6 +387,7 @@ static void updateRfm22bStats() {
             static bool first_time = true;
             static uint16_t prev_tx_count = 0;
             static uint16_t prev_rx_count = 0;
+            static uint16_t prev_payload_count = 0;
             rfm22bStatus.HeapRemaining = PIOS_heap_get_free_size();
             rfm22bStatus.RxGood = radio_stats.rx_good;
             rfm22bStatus.RxCorrected   = radio_stats.rx_corrected;
@@ -387,6 +399,7 @@ static void updateRfm22bStats() {
             rfm22bStatus.Timeouts    = radio_stats.timeouts;
             rfm22bStatus.RSSI        = radio_stats.rssi;
             rfm22bStatus.LinkQuality = radio_stats.link_quality;
+            rfm22bStatus.TxParity = radio_stats.tx_parity;
             if (first_time) {
                 first_time = false;
             } else {
@@ -395,9 +408,13 @@ static void updateRfm22bStats() {
                 uint16_t tx_bytes = (tx_count < prev_tx_count) ? (0xffff - prev_tx_count + tx_count) : (tx_count - prev_tx_count);
                 uint16_t rx_bytes = (rx_count < prev_rx_count) ? (0xffff - prev_rx_count + rx_count) : (rx_count - prev_rx_count);
                 rfm22bStatus.TXRate = (uint16_t)((float)(tx_bytes * 1000) / SYSTEM_UPDATE_PERIOD_MS);
+                uint16_t payload_count = radio_stats.rx_payload_count;
+                uint16_t payload_bytes = payload_count - prev_payload_count;
                 rfm22bStatus.RXRate = (uint16_t)((float)(rx_bytes * 1000) / SYSTEM_UPDATE_PERIOD_MS);
+                rfm22bStatus.RxGoodput = (uint16_t)((float)(payload_bytes * 1000) / SYSTEM_UPDATE_PERIOD_MS);
                 prev_tx_count = tx_count;
                 prev_rx_count = rx_count;
+                prev_payload_count = payload_count;
             }
 
             rfm22bStatus.LinkState = radio_stats.link_state;
@@ -35,6 +35,7 @@
 #include "sessionmanaging.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
+#include "pios_crc.h"
 
 // Private constants
 #define MAX_QUEUE_SIZE   TELEM_QUEUE_SIZE
@@ -47,6 +48,10 @@
 #define STATS_UPDATE_PERIOD_MS 4000
 #define CONNECTION_TIMEOUT_MS 8000
 #define PAUSE_PERIODIC_UPDATE_TIMEOUT 6000
+#define SESSION_RESUME_UPDATES 0xFF
+#define SESSION_PAUSE_UPDATES 0xFE
+#define SESSION_SEND_MANIFEST 0xFD
+#define HASH_CHUNK_SIZE 32
 // Private types
 
 // Private variables
@@ -83,6 +88,8 @@ static void updateSettings();
 static uintptr_t getComPort();
 static void session_managing_updated(UAVObjEvent * ev);
 static void update_object_instances(uint32_t obj_id, uint32_t inst_id);
+static void send_session_manifest();
+static uint32_t object_hash(UAVObjHandle obj);
 static void check_pause_periodic_updates_timeout();
 
 /**
@@ -276,6 +283,8 @@ static void processObjEvent(UAVObjEvent * ev)
 		updateTelemetryStats();
 	} else if (ev->obj == GCSTelemetryStatsHandle()) {
 		gcsTelemetryStatsUpdated();
+	} else if (ev->obj == SessionManagingHandle() && ev->event == EV_NONE) {
+		send_session_manifest();
 	} else {
 		FlightTelemetryStatsGet(&flightStats);
 		// Get object metadata
@@ -627,11 +636,22 @@ static void session_managing_updated(UAVObjEvent * ev)
 			sessionManaging.ObjectOfInterestIndex = 0;
 			pausePeriodicUpdates = true;
 			pausePeriodicUpdatesTime = PIOS_Thread_Systime();
-		} else if (sessionManaging.ObjectOfInterestIndex == 0xFF) {
+		} else if (sessionManaging.ObjectOfInterestIndex == SESSION_RESUME_UPDATES) {
 			pausePeriodicUpdates = false;
-		} else if (sessionManaging.ObjectOfInterestIndex == 0xFE) {
+		} else if (sessionManaging.ObjectOfInterestIndex == SESSION_PAUSE_UPDATES) {
 			pausePeriodicUpdates = true;
 			pausePeriodicUpdatesTime = PIOS_Thread_Systime();
+		} else if (sessionManaging.ObjectOfInterestIndex == SESSION_SEND_MANIFEST) {
+			pausePeriodicUpdates = true;
+			pausePeriodicUpdatesTime = PIOS_Thread_Systime();
+			// The manifest is streamed by the telemetry task, not from the event callback
+			UAVObjEvent manifestEv = {
+				.obj    = SessionManagingHandle(),
+				.instId = 0,
+				.event  = EV_NONE,
+			};
+			PIOS_Queue_Send(priorityQueue, &manifestEv, 0);
+			return;
 		} else {
 			uint8_t index = sessionManaging.ObjectOfInterestIndex;
 			sessionManaging.ObjectID = UAVObjIDByIndex(index);
@@ -641,6 +661,71 @@ static void session_managing_updated(UAVObjEvent * ev)
 	}
 }
 
+/**
+ * Send the session manifest, one SessionManaging entry per registered object
+ * with its ID, number of instances and the hash of its metadata and data.
+ * The entries are streamed unacked in a single burst so that the GCS can
+ * bootstrap a session without a round trip per object. The GCS detects
+ * missing entries by their ObjectOfInterestIndex.
+ */
+static void send_session_manifest()
+{
+	SessionManagingData sessionManaging;
+	UAVObjHandle sessionHandle = SessionManagingHandle();
+	uint8_t count = UAVObjCount();
+
+	// Don't queue an update event for each entry, it would flood the queue
+	UAVObjDisconnectQueue(sessionHandle, priorityQueue);
+
+	SessionManagingGet(&sessionManaging);
+	sessionManaging.NumberOfObjects = count;
+	for (uint8_t index = 0; index < count; ++index) {
+		UAVObjHandle obj = UAVObjGetByID(UAVObjIDByIndex(index));
+		if (obj == NULL)
+			continue;
+		sessionManaging.ObjectID = UAVObjGetID(obj);
+		sessionManaging.ObjectInstances = UAVObjGetNumInstances(obj);
+		sessionManaging.ObjectOfInterestIndex = index;
+		sessionManaging.ObjectHash = object_hash(obj);
+		SessionManagingSet(&sessionManaging);
+		UAVTalkSendObject(uavTalkCon, sessionHandle, 0, false, 0);
+	}
+
+	updateObject(sessionHandle, EV_NONE);
+}
+
+/**
+ * Hash of the metadata and the data of all the instances of an object, in the
+ * same layout as they are sent over UAVTalk
+ * \param[in] obj The object to hash
+ * \return CRC32 of the object
+ */
+static uint32_t object_hash(UAVObjHandle obj)
+{
+	UAVObjMetadata metadata;
+	uint8_t chunk[HASH_CHUNK_SIZE];
+	uint32_t hash = 0;
+
+	UAVObjGetMetadata(obj, &metadata);
+	hash = PIOS_CRC32_updateCRC(hash, (const uint8_t *) &metadata, sizeof(metadata));
+
+	// Hashed in chunks to keep the telemetry stack small
+	uint32_t numBytes = UAVObjGetNumBytes(obj);
+	uint16_t numInstances = UAVObjGetNumInstances(obj);
+	for (uint16_t instId = 0; instId < numInstances; ++instId) {
+		for (uint32_t offset = 0; offset < numBytes; offset += sizeof(chunk)) {
+			uint32_t size = numBytes - offset;
+			if (size > sizeof(chunk))
+				size = sizeof(chunk);
+			if (UAVObjGetInstanceDataField(obj, instId, chunk, offset, size) != 0)
+				break;
+			hash = PIOS_CRC32_updateCRC(hash, chunk, size);
+		}
+	}
+
+	return hash;
+}
+
 /**
  * New UAVO object instance callback
  * This is called from the uavobjectmanager
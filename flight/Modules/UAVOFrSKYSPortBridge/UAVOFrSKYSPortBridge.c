@@ -34,7 +34,7 @@
  */
 
 #include "frsky_packing.h"
-#include "pios_thread.h"
+#include "telemetry_bridge.h"
 
 #include "baroaltitude.h"
 #include "flightbatterysettings.h"
@@ -86,7 +86,7 @@ struct frsky_sport_telemetry {
 	int32_t scheduled_item;
 	uint32_t last_poll_time;
 	uint8_t ignore_rx_chars;
-	uintptr_t com;
+	struct telemetry_bridge bridge;
 	struct frsky_settings frsky_settings;
 	uint32_t item_last_triggered[NELEMENTS(frsky_value_items)];
 };
@@ -95,17 +95,13 @@ static const uint8_t frsky_sensor_ids[] = {0x1b};
 
 #define FRSKY_SPORT_BAUDRATE                    57600
 
-#if defined(PIOS_FRSKY_SPORT_TELEMETRY_STACK_SIZE)
-#define STACK_SIZE_BYTES PIOS_FRSKY_SPORT_TELEMETRY_STACK_SIZE
-#else
-#define STACK_SIZE_BYTES 672
-#endif
-#define TASK_PRIORITY               PIOS_THREAD_PRIO_LOW
+//! The bridge runs when the receiver polls, every 12ms, so this only bounds an idle bus
+#define FRSKY_SPORT_RUN_PERIOD_MS               100
 
 static bool module_enabled;
 static struct frsky_sport_telemetry *frsky;
 static int32_t uavoFrSKYSPortBridgeInitialize(void);
-static void uavoFrSKYSPortBridgeTask(void *parameters);
+static uint32_t uavoFrSKYSPortBridgeRun(struct telemetry_bridge *bridge, uint32_t now);
 
 /**
  * Scan for value item with the longest expired time and schedule it to send in next poll turn
@@ -140,7 +136,7 @@ static bool frsky_send_scheduled_item(void)
 		uint32_t value = 0;
 		if (frsky_value_items[item].encode_value(&frsky->frsky_settings, &value, false,
 				frsky_value_items[item].fn_arg)) {
-			frsky->ignore_rx_chars += frsky_send_frame(frsky->com, (uint16_t)(frsky_value_items[item].id), value);
+			frsky->ignore_rx_chars += frsky_send_frame(&frsky->bridge, (uint16_t)(frsky_value_items[item].id), value);
 			return true;
 		}
 	}
@@ -177,10 +173,6 @@ static void frsky_receive_byte(uint8_t b)
 		frsky->state = FRSKY_STATE_WAIT_POLL_REQUEST;
 		for (i = 0; i < sizeof(frsky_sensor_ids); i++) {
 			if (frsky_sensor_ids[i] == b) {
-				// get GPSPositionData once here to be more efficient, since
-				// GPS position data are very often used by encode() handlers
-				if (GPSPositionHandle() != NULL)
-					GPSPositionGet(&frsky->frsky_settings.gps_position);
 				// send item previously scheduled
 				if (frsky_send_scheduled_item() && frsky->ignore_rx_chars)
 					frsky->state = FRSKY_STATE_WAIT_TX_DONE;
@@ -215,14 +207,7 @@ static int32_t uavoFrSKYSPortBridgeStart(void)
 			&& PIOS_SENSORS_GetQueue(PIOS_SENSOR_BARO) != NULL)
 		frsky->frsky_settings.use_baro_sensor = true;
 
-	struct pios_thread *task;
-	task = PIOS_Thread_Create(
-			uavoFrSKYSPortBridgeTask, "uavoFrSKYSPortBridge",
-			STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
-	TaskMonitorAdd(TASKINFO_RUNNING_UAVOFRSKYSPORTBRIDGE,
-			task);
-
-	return 0;
+	return TelemetryBridgeStart();
 }
 
 /**
@@ -249,14 +234,27 @@ static int32_t uavoFrSKYSPortBridgeInitialize(void)
 			frsky->last_poll_time = PIOS_DELAY_GetuS();
 			frsky->ignore_rx_chars = 0;
 			frsky->scheduled_item = -1;
-			frsky->com = sport_com;
+
+			// GPS position data are very often used by encode() handlers
+			frsky->frsky_settings.gps_position = TelemetryBridgeSnapshot(GPSPositionHandle,
+					sizeof(GPSPositionData));
+
+			frsky->bridge.com = sport_com;
+			frsky->bridge.stats_idx = BRIDGESTATS_CPUTIME_FRSKYSPORT;
+			frsky->bridge.run = uavoFrSKYSPortBridgeRun;
+			// The receiver waits only a few ms for the answer
+			frsky->bridge.wake_on_rx = true;
 
 			uint8_t i;
 			for (i = 0; i < NELEMENTS(frsky_value_items); i++)
 				frsky->item_last_triggered[i] = PIOS_DELAY_GetuS();
-			PIOS_COM_ChangeBaud(frsky->com, FRSKY_SPORT_BAUDRATE);
-			module_enabled = true;
-			return 0;
+			PIOS_COM_ChangeBaud(sport_com, FRSKY_SPORT_BAUDRATE);
+
+			if (frsky->frsky_settings.gps_position != NULL
+					&& TelemetryBridgeRegister(&frsky->bridge) == 0) {
+				module_enabled = true;
+				return 0;
+			}
 		}
 	}
 
@@ -267,17 +265,22 @@ static int32_t uavoFrSKYSPortBridgeInitialize(void)
 MODULE_INITCALL(uavoFrSKYSPortBridgeInitialize, uavoFrSKYSPortBridgeStart)
 
 /**
- * Main task routine
- * @param[in] parameters parameter given by PIOS_Thread_Create()
+ * Process the bytes received since the last run
+ * @param[in] bridge the bridge of the S.PORT
+ * @param[in] now the system time in ms
+ * @return ms until the next run
  */
-static void uavoFrSKYSPortBridgeTask(void *parameters)
+static uint32_t uavoFrSKYSPortBridgeRun(struct telemetry_bridge *bridge, uint32_t now)
 {
-	while (1) {
-		uint8_t b = 0;
-		uint16_t count = PIOS_COM_ReceiveBuffer(frsky->com, &b, 1, PIOS_QUEUE_TIMEOUT_MAX);
-		if (count)
-			frsky_receive_byte(b);
+	uint8_t rx_buf[16];
+	uint16_t count;
+
+	while ((count = TelemetryBridgeReceive(bridge, rx_buf, sizeof(rx_buf))) > 0) {
+		for (uint16_t i = 0; i < count; i++)
+			frsky_receive_byte(rx_buf[i]);
 	}
+
+	return FRSKY_SPORT_RUN_PERIOD_MS;
 }
 
 #endif //PIOS_INCLUDE_FRSKY_SPORT_TELEMETRY
@@ -43,13 +43,13 @@
 #include "nedaccel.h"
 #include "velocityactual.h"
 #include "attitudeactual.h"
-#include "pios_thread.h"
+#include "telemetry_bridge.h"
 
 #if defined(PIOS_INCLUDE_FRSKY_SENSOR_HUB)
 // ****************
 // Private functions
 
-static void uavoFrSKYSensorHubBridgeTask(void *parameters);
+static uint32_t uavoFrSKYSensorHubBridgeRun(struct telemetry_bridge *bridge, uint32_t now);
 
 static uint16_t frsky_pack_altitude(
 		float altitude,
@@ -113,13 +113,6 @@ static bool frame_trigger(uint8_t frame_num);
 // ****************
 // Private constants
 
-#if defined(PIOS_FRSKY_SENSOR_HUB_STACK_SIZE)
-#define STACK_SIZE_BYTES PIOS_FRSKY_SENSOR_HUB_STACK_SIZE
-#else
-#define STACK_SIZE_BYTES 672
-#endif
-
-#define TASK_PRIORITY               PIOS_THREAD_PRIO_LOW
 #define TASK_RATE_HZ 10
 
 #define FRSKY_MAX_PACKET_LEN 106
@@ -178,10 +171,21 @@ static const uint8_t frsky_rates[] = {
 // ****************
 // Private variables
 
-static struct pios_thread *uavoFrSKYSensorHubBridgeTaskHandle;
-
 static uint32_t frsky_port;
 
+static struct telemetry_bridge frsky_bridge;
+
+//! Snapshots of the objects sent
+static const GPSPositionData *gpsPosData;
+static const FlightBatteryStateData *batState;
+static const BaroAltitudeData *baroAltitude;
+static const FlightStatusData *flightStatus;
+
+static FlightBatterySettingsData batSettings;
+
+static uint8_t last_armed = FLIGHTSTATUS_ARMED_DISARMED;
+static float altitude_offset = 0.0f;
+
 static bool module_enabled;
 
 static uint8_t *frame_ticks;
@@ -196,13 +200,20 @@ static uint8_t *serial_buf;
 static int32_t uavoFrSKYSensorHubBridgeStart(void)
 {
 	if (module_enabled) {
-		// Start tasks
-		uavoFrSKYSensorHubBridgeTaskHandle = PIOS_Thread_Create(
-				uavoFrSKYSensorHubBridgeTask, "uavoFrSKYSensorHubBridge",
-				STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
-		TaskMonitorAdd(TASKINFO_RUNNING_UAVOFRSKYSBRIDGE,
-				uavoFrSKYSensorHubBridgeTaskHandle);
-		return 0;
+		if (FlightBatterySettingsHandle() != NULL )
+			FlightBatterySettingsGet(&batSettings);
+		else {
+			batSettings.Capacity = 0;
+			batSettings.SensorCalibrationFactor[FLIGHTBATTERYSETTINGS_SENSORCALIBRATIONFACTOR_CURRENT] = 0;
+			batSettings.SensorCalibrationFactor[FLIGHTBATTERYSETTINGS_SENSORCALIBRATIONFACTOR_VOLTAGE] = 0;
+			batSettings.VoltageThresholds[FLIGHTBATTERYSETTINGS_VOLTAGETHRESHOLDS_WARNING] = 0;
+			batSettings.VoltageThresholds[FLIGHTBATTERYSETTINGS_VOLTAGETHRESHOLDS_ALARM] = 0;
+			batSettings.NbCells = 0;
+			batSettings.VoltagePin = FLIGHTBATTERYSETTINGS_VOLTAGEPIN_NONE;
+			batSettings.CurrentPin = FLIGHTBATTERYSETTINGS_CURRENTPIN_NONE;
+		}
+
+		return TelemetryBridgeStart();
 	}
 	return -1;
 }
@@ -235,6 +246,20 @@ static int32_t uavoFrSKYSensorHubBridgeInitialize(void)
 			frame_ticks[x] = (TASK_RATE_HZ / frsky_rates[x]);
 		}
 
+		// Zeroed while the objects don't exist
+		gpsPosData = TelemetryBridgeSnapshot(GPSPositionHandle, sizeof(*gpsPosData));
+		batState = TelemetryBridgeSnapshot(FlightBatteryStateHandle, sizeof(*batState));
+		baroAltitude = TelemetryBridgeSnapshotPolled(BaroAltitudeHandle, sizeof(*baroAltitude));
+		flightStatus = TelemetryBridgeSnapshot(FlightStatusHandle, sizeof(*flightStatus));
+		if (!gpsPosData || !batState || !baroAltitude || !flightStatus)
+			return -1;
+
+		frsky_bridge.com = frsky_port;
+		frsky_bridge.stats_idx = BRIDGESTATS_CPUTIME_FRSKYSENSORHUB;
+		frsky_bridge.run = uavoFrSKYSensorHubBridgeRun;
+		if (TelemetryBridgeRegister(&frsky_bridge) != 0)
+			return -1;
+
 		module_enabled = true;
 
 		return 0;
@@ -247,285 +272,220 @@ static int32_t uavoFrSKYSensorHubBridgeInitialize(void)
 MODULE_INITCALL(uavoFrSKYSensorHubBridgeInitialize, uavoFrSKYSensorHubBridgeStart)
 
 /**
- * Main task. It does not return.
+ * Send the frames that are due, TASK_RATE_HZ times a second
+ * \return ms until the next run
  */
-static void uavoFrSKYSensorHubBridgeTask(void *parameters)
+static uint32_t uavoFrSKYSensorHubBridgeRun(struct telemetry_bridge *bridge, uint32_t now)
 {
-	FlightBatterySettingsData batSettings;
-	FlightBatteryStateData batState;
-	GPSPositionData gpsPosData;
-	BaroAltitudeData baroAltitude;
-	FlightStatusData flightStatus;
 	float accX = 0, accY = 0, accZ = 0;
-
-	if (FlightBatterySettingsHandle() != NULL )
-		FlightBatterySettingsGet(&batSettings);
-	else {
-		batSettings.Capacity = 0;
-		batSettings.SensorCalibrationFactor[FLIGHTBATTERYSETTINGS_SENSORCALIBRATIONFACTOR_CURRENT] = 0;
-		batSettings.SensorCalibrationFactor[FLIGHTBATTERYSETTINGS_SENSORCALIBRATIONFACTOR_VOLTAGE] = 0;
-		batSettings.VoltageThresholds[FLIGHTBATTERYSETTINGS_VOLTAGETHRESHOLDS_WARNING] = 0;
-		batSettings.VoltageThresholds[FLIGHTBATTERYSETTINGS_VOLTAGETHRESHOLDS_ALARM] = 0;
-		batSettings.NbCells = 0;
-		batSettings.VoltagePin = FLIGHTBATTERYSETTINGS_VOLTAGEPIN_NONE;
-		batSettings.CurrentPin = FLIGHTBATTERYSETTINGS_CURRENTPIN_NONE;
-	}
-
-	if (GPSPositionHandle() == NULL ) {
-		gpsPosData.Altitude = 0;
-		gpsPosData.GeoidSeparation = 0;
-		gpsPosData.Groundspeed = 0;
-		gpsPosData.HDOP = 0;
-		gpsPosData.Heading = 0;
-		gpsPosData.Latitude = 0;
-		gpsPosData.Longitude = 0;
-		gpsPosData.PDOP = 0;
-		gpsPosData.Satellites = 0;
-		gpsPosData.Status = 0;
-		gpsPosData.VDOP = 0;
-	}
-
-	if (FlightBatteryStateHandle() == NULL ) {
-		batState.AvgCurrent = 0;
-		batState.BoardSupplyVoltage = 0;
-		batState.ConsumedEnergy = 0;
-		batState.Current = 0;
-		batState.EstimatedFlightTime = 0;
-		batState.PeakCurrent = 0;
-		batState.Voltage = 0;
-	}
-
-	uint8_t last_armed = FLIGHTSTATUS_ARMED_DISARMED;
-	float altitude_offset = 0.0f;
-
 	uint16_t msg_length = 0;
-	uint32_t lastSysTime;
-
-	// Main task loop
-	lastSysTime = PIOS_Thread_Systime();
-
-	while (1) {
-		PIOS_Thread_Sleep_Until(&lastSysTime, 1000 / TASK_RATE_HZ);
-
-		if (frame_trigger(FRSKY_FRAME_VARIO)) {
-			msg_length = 0;
-
-			uint8_t accelDataSettings;
-			ModuleSettingsFrskyAccelDataGet(&accelDataSettings);
-			switch(accelDataSettings) {
-			case MODULESETTINGS_FRSKYACCELDATA_ACCELS: {
-				if (AccelsHandle() != NULL) {
-					AccelsxGet(&accX);
-					AccelsyGet(&accY);
-					AccelszGet(&accZ);
-				}
-				break;
+
+	if (frame_trigger(FRSKY_FRAME_VARIO)) {
+		msg_length = 0;
+
+		uint8_t accelDataSettings;
+		ModuleSettingsFrskyAccelDataGet(&accelDataSettings);
+		switch(accelDataSettings) {
+		case MODULESETTINGS_FRSKYACCELDATA_ACCELS: {
+			if (AccelsHandle() != NULL) {
+				AccelsxGet(&accX);
+				AccelsyGet(&accY);
+				AccelszGet(&accZ);
 			}
+			break;
+		}
 #ifndef SMALLF1
-			case MODULESETTINGS_FRSKYACCELDATA_NEDACCELS: {
-				if (NedAccelHandle() != NULL) {
-					NedAccelNorthGet(&accX);
-					NedAccelEastGet(&accY);
-					NedAccelDownGet(&accZ);
-				}
-				break;
+		case MODULESETTINGS_FRSKYACCELDATA_NEDACCELS: {
+			if (NedAccelHandle() != NULL) {
+				NedAccelNorthGet(&accX);
+				NedAccelEastGet(&accY);
+				NedAccelDownGet(&accZ);
 			}
-			case MODULESETTINGS_FRSKYACCELDATA_NEDVELOCITY: {
-				if (VelocityActualHandle() != NULL) {
-					VelocityActualNorthGet(&accX);
-					VelocityActualEastGet(&accY);
-					VelocityActualDownGet(&accZ);
-					accX *= GRAVITY / 10.0f;
-					accY *= GRAVITY / 10.0f;
-					accZ *= GRAVITY / 10.0f;
-				}
-				break;
+			break;
+		}
+		case MODULESETTINGS_FRSKYACCELDATA_NEDVELOCITY: {
+			if (VelocityActualHandle() != NULL) {
+				VelocityActualNorthGet(&accX);
+				VelocityActualEastGet(&accY);
+				VelocityActualDownGet(&accZ);
+				accX *= GRAVITY / 10.0f;
+				accY *= GRAVITY / 10.0f;
+				accZ *= GRAVITY / 10.0f;
 			}
+			break;
+		}
 #endif
-			case MODULESETTINGS_FRSKYACCELDATA_ATTITUDEANGLES: {
-				if (AttitudeActualHandle() != NULL) {
-					AttitudeActualRollGet(&accX);
-					AttitudeActualPitchGet(&accY);
-					AttitudeActualYawGet(&accZ);
-					accX *= GRAVITY / 10.0f;
-					accY *= GRAVITY / 10.0f;
-					accZ *= GRAVITY / 10.0f;
-				}
-				break;
+		case MODULESETTINGS_FRSKYACCELDATA_ATTITUDEANGLES: {
+			if (AttitudeActualHandle() != NULL) {
+				AttitudeActualRollGet(&accX);
+				AttitudeActualPitchGet(&accY);
+				AttitudeActualYawGet(&accZ);
+				accX *= GRAVITY / 10.0f;
+				accY *= GRAVITY / 10.0f;
+				accZ *= GRAVITY / 10.0f;
 			}
-			}
-
-			msg_length += frsky_pack_accel(
-					accX,
-					accY,
-					accZ,
-					serial_buf + msg_length);
-
-			if (BaroAltitudeHandle() != NULL)
-				BaroAltitudeGet(&baroAltitude);
-
-			FlightStatusGet(&flightStatus);
-
-			// set altitude offset when arming
-			if ((flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMING) ||
-					((last_armed != FLIGHTSTATUS_ARMED_ARMED) && (flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED))) {
-				altitude_offset = baroAltitude.Altitude;
-			}
-			last_armed = flightStatus.Armed;
-
-			float altitude = baroAltitude.Altitude - altitude_offset;
-			msg_length += frsky_pack_altitude(
-					altitude,
-					serial_buf + msg_length);
+			break;
+		}
+		}
 
-			msg_length += frsky_pack_stop(serial_buf + msg_length);
+		msg_length += frsky_pack_accel(
+				accX,
+				accY,
+				accZ,
+				serial_buf + msg_length);
 
-			PIOS_COM_SendBuffer(frsky_port, serial_buf, msg_length);
+		// set altitude offset when arming
+		if ((flightStatus->Armed == FLIGHTSTATUS_ARMED_ARMING) ||
+				((last_armed != FLIGHTSTATUS_ARMED_ARMED) && (flightStatus->Armed == FLIGHTSTATUS_ARMED_ARMED))) {
+			altitude_offset = baroAltitude->Altitude;
 		}
+		last_armed = flightStatus->Armed;
 
-		if (frame_trigger(FRSKY_FRAME_BATTERY)) {
-			msg_length = 0;
-
-			if (FlightBatteryStateHandle() != NULL)
-				FlightBatteryStateGet(&batState);
-
-			float voltage = 0.0f;
-			if (batSettings.VoltagePin != FLIGHTBATTERYSETTINGS_VOLTAGEPIN_NONE)
-				voltage = batState.Voltage;
-
-			float current = 0.0f;
-			if (batSettings.CurrentPin != FLIGHTBATTERYSETTINGS_CURRENTPIN_NONE)
-				current = batState.Current;
-
-			// As long as there is no voltage for each cell
-			// all cells will have the same voltage.
-			// Receiver will know number of cells.
-			if (batSettings.NbCells > 0) {
-				float cell_v = voltage / batSettings.NbCells;
-				for(uint8_t i = 0; i < batSettings.NbCells; ++i) {
-					msg_length += frsky_pack_cellvoltage(
-							i,
-							cell_v,
-							serial_buf + msg_length);
-				}
-			}
+		float altitude = baroAltitude->Altitude - altitude_offset;
+		msg_length += frsky_pack_altitude(
+				altitude,
+				serial_buf + msg_length);
 
-			msg_length += frsky_pack_fas(
-					voltage,
-					current,
-					serial_buf + msg_length);
+		msg_length += frsky_pack_stop(serial_buf + msg_length);
 
-			if (batSettings.Capacity > 0) {
-				float fuel = 1.0f - batState.ConsumedEnergy / batSettings.Capacity;
-				msg_length += frsky_pack_fuel(
-					fuel,
-					serial_buf + msg_length);
-			}
-
-			msg_length += frsky_pack_stop(serial_buf + msg_length);
+		TelemetryBridgeSend(bridge, serial_buf, msg_length);
+	}
 
-			PIOS_COM_SendBuffer(frsky_port, serial_buf, msg_length);
+	if (frame_trigger(FRSKY_FRAME_BATTERY)) {
+		msg_length = 0;
+
+		float voltage = 0.0f;
+		if (batSettings.VoltagePin != FLIGHTBATTERYSETTINGS_VOLTAGEPIN_NONE)
+			voltage = batState->Voltage;
+
+		float current = 0.0f;
+		if (batSettings.CurrentPin != FLIGHTBATTERYSETTINGS_CURRENTPIN_NONE)
+			current = batState->Current;
+
+		// As long as there is no voltage for each cell
+		// all cells will have the same voltage.
+		// Receiver will know number of cells.
+		if (batSettings.NbCells > 0) {
+			float cell_v = voltage / batSettings.NbCells;
+			for(uint8_t i = 0; i < batSettings.NbCells; ++i) {
+				msg_length += frsky_pack_cellvoltage(
+						i,
+						cell_v,
+						serial_buf + msg_length);
+			}
 		}
 
-		if (frame_trigger(FRSKY_FRAME_GPS)) {
-			msg_length = 0;
-
-			/**
-			 * Encodes ARM status and flight mode number as RPM value
-			 * Since there is no RPM information in any UAVO available,
-			 * we will intentionally misuse this item to encode other useful information.
-			 * It will encode flight status as three-digit number as follow:
-			 * most left digit encodes arm status (200=armed, 100=disarmed)
-			 * two most right digits encode flight mode number (see FlightStatus UAVO FlightMode enum)
-			 * To work properly on Taranis, you have to set Blades to "60" in telemetry setting
-			 */
-			FlightStatusData flight_status;
-			FlightStatusGet(&flight_status);
+		msg_length += frsky_pack_fas(
+				voltage,
+				current,
+				serial_buf + msg_length);
 
-			uint16_t status = 0;
-			float hdop, vdop;
-
-			status = (flight_status.Armed == FLIGHTSTATUS_ARMED_ARMED) ? 200 : 100;
-			status += flight_status.FlightMode;
+		if (batSettings.Capacity > 0) {
+			float fuel = 1.0f - batState->ConsumedEnergy / batSettings.Capacity;
+			msg_length += frsky_pack_fuel(
+				fuel,
+				serial_buf + msg_length);
+		}
 
-			msg_length += frsky_pack_rpm(status, serial_buf + msg_length);
+		msg_length += frsky_pack_stop(serial_buf + msg_length);
 
-			uint8_t hl_set = HOMELOCATION_SET_FALSE;
-			
-			if (GPSPositionHandle() != NULL)
-				GPSPositionGet(&gpsPosData);
+		TelemetryBridgeSend(bridge, serial_buf, msg_length);
+	}
 
-			if (HomeLocationHandle() != NULL)
-				HomeLocationSetGet(&hl_set);
+	if (frame_trigger(FRSKY_FRAME_GPS)) {
+		msg_length = 0;
+
+		/**
+		 * Encodes ARM status and flight mode number as RPM value
+		 * Since there is no RPM information in any UAVO available,
+		 * we will intentionally misuse this item to encode other useful information.
+		 * It will encode flight status as three-digit number as follow:
+		 * most left digit encodes arm status (200=armed, 100=disarmed)
+		 * two most right digits encode flight mode number (see FlightStatus UAVO FlightMode enum)
+		 * To work properly on Taranis, you have to set Blades to "60" in telemetry setting
+		 */
+		uint16_t status = 0;
+		float hdop, vdop;
+
+		status = (flightStatus->Armed == FLIGHTSTATUS_ARMED_ARMED) ? 200 : 100;
+		status += flightStatus->FlightMode;
+
+		msg_length += frsky_pack_rpm(status, serial_buf + msg_length);
+
+		uint8_t hl_set = HOMELOCATION_SET_FALSE;
+		
+		if (HomeLocationHandle() != NULL)
+			HomeLocationSetGet(&hl_set);
         
-			/**
-			 * Encode GPS status and visible satellites as T1 value
-			 * We will intentionally misuse this item to encode other useful information.
-			 * Right-most two digits encode visible satellite count, left-most digit has following meaning:
-			 * 1 - no GPS connected
-			 * 2 - no fix
-			 * 3 - 2D fix
-			 * 4 - 3D fix
-			 * 5 - 3D fix and HomeLocation is SET - should be safe for navigation
-			 */
-			switch (gpsPosData.Status) {
-			case GPSPOSITION_STATUS_NOGPS:
-			status = 100;
-				break;
-			case GPSPOSITION_STATUS_NOFIX:
-				status = 200;
-				break;
-			case GPSPOSITION_STATUS_FIX2D:
-				status = 300;
-				break;
-			case GPSPOSITION_STATUS_FIX3D:
-			case GPSPOSITION_STATUS_DIFF3D:
-				if (hl_set == HOMELOCATION_SET_TRUE)
-					status = 500;
-				else
-					status = 400;
-				break;
-			}
-	
-			if (gpsPosData.Satellites > 0)
-				status += gpsPosData.Satellites;
-
-			msg_length += frsky_pack_temperature_01((float)status, serial_buf + msg_length);
-			
-			/**
-			 * Encode GPS HDOP and VDOP as T2 value
-			 * We will intentionally misuse this item to encode other useful information.
-			 * VDOP in the upper 16 bits, max 256 (2.56 * 100)
-			 * HDOP in the lower 16 bits, max 256 (2.56 * 100)
-			 */
-			hdop = gpsPosData.HDOP * 100.0f;
-			
-			if (hdop > 255.0f)
-				hdop = 255.0f;
-			
-			vdop = gpsPosData.VDOP * 100.0f;
-			
-			if (vdop > 255.0f)
-				vdop = 255.0f;
-			
-			msg_length += frsky_pack_temperature_02((vdop * 256 + hdop), serial_buf + msg_length);
-
-			if (gpsPosData.Status == GPSPOSITION_STATUS_FIX2D ||
-			    gpsPosData.Status == GPSPOSITION_STATUS_FIX3D) {
-				msg_length += frsky_pack_gps(
-						gpsPosData.Heading,
-						gpsPosData.Latitude,
-						gpsPosData.Longitude,
-						gpsPosData.Altitude,
-						gpsPosData.Groundspeed,
-						serial_buf + msg_length);
-			}
-
-			msg_length += frsky_pack_stop(serial_buf + msg_length);
+		/**
+		 * Encode GPS status and visible satellites as T1 value
+		 * We will intentionally misuse this item to encode other useful information.
+		 * Right-most two digits encode visible satellite count, left-most digit has following meaning:
+		 * 1 - no GPS connected
+		 * 2 - no fix
+		 * 3 - 2D fix
+		 * 4 - 3D fix
+		 * 5 - 3D fix and HomeLocation is SET - should be safe for navigation
+		 */
+		switch (gpsPosData->Status) {
+		case GPSPOSITION_STATUS_NOGPS:
+		status = 100;
+			break;
+		case GPSPOSITION_STATUS_NOFIX:
+			status = 200;
+			break;
+		case GPSPOSITION_STATUS_FIX2D:
+			status = 300;
+			break;
+		case GPSPOSITION_STATUS_FIX3D:
+		case GPSPOSITION_STATUS_DIFF3D:
+			if (hl_set == HOMELOCATION_SET_TRUE)
+				status = 500;
+			else
+				status = 400;
+			break;
+		}
 
-			PIOS_COM_SendBuffer(frsky_port, serial_buf, msg_length);
+		if (gpsPosData->Satellites > 0)
+			status += gpsPosData->Satellites;
+
+		msg_length += frsky_pack_temperature_01((float)status, serial_buf + msg_length);
+		
+		/**
+		 * Encode GPS HDOP and VDOP as T2 value
+		 * We will intentionally misuse this item to encode other useful information.
+		 * VDOP in the upper 16 bits, max 256 (2.56 * 100)
+		 * HDOP in the lower 16 bits, max 256 (2.56 * 100)
+		 */
+		hdop = gpsPosData->HDOP * 100.0f;
+		
+		if (hdop > 255.0f)
+			hdop = 255.0f;
+		
+		vdop = gpsPosData->VDOP * 100.0f;
+		
+		if (vdop > 255.0f)
+			vdop = 255.0f;
+		
+		msg_length += frsky_pack_temperature_02((vdop * 256 + hdop), serial_buf + msg_length);
+
+		if (gpsPosData->Status == GPSPOSITION_STATUS_FIX2D ||
+		    gpsPosData->Status == GPSPOSITION_STATUS_FIX3D) {
+			msg_length += frsky_pack_gps(
+					gpsPosData->Heading,
+					gpsPosData->Latitude,
+					gpsPosData->Longitude,
+					gpsPosData->Altitude,
+					gpsPosData->Groundspeed,
+					serial_buf + msg_length);
 		}
+
+		msg_length += frsky_pack_stop(serial_buf + msg_length);
+
+		TelemetryBridgeSend(bridge, serial_buf, msg_length);
 	}
+
+	return 1000 / TASK_RATE_HZ;
 }
 
 static bool frame_trigger(uint8_t frame_num)
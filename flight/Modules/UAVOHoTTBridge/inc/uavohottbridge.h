@@ -183,18 +183,18 @@ typedef struct {
 
 // Private structures
 struct telemetrydata{
-	HoTTSettingsData Settings;
-	AttitudeActualData Attitude;
-	BaroAltitudeData Baro;
-	FlightBatteryStateData Battery;
-	FlightStatusData FlightStatus;
-	GPSPositionData GPS;
-	GPSTimeData GPStime;
-	GyrosData Gyro;
-	HomeLocationData Home;
-	PositionActualData Position;
-	SystemAlarmsData SysAlarms;
-	VelocityActualData Velocity;
+	const HoTTSettingsData *Settings;
+	const AttitudeActualData *Attitude;
+	const BaroAltitudeData *Baro;
+	const FlightBatteryStateData *Battery;
+	const FlightStatusData *FlightStatus;
+	const GPSPositionData *GPS;
+	const GPSTimeData *GPStime;
+	const GyrosData *Gyro;
+	const HomeLocationData *Home;
+	const PositionActualData *Position;
+	const SystemAlarmsData *SysAlarms;
+	const VelocityActualData *Velocity;
 	int16_t climbratebuffer[climbratesize];
 	uint8_t climbrate_pointer;
 	float altitude;
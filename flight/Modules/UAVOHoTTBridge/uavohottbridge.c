@@ -33,20 +33,34 @@
 #if defined(PIOS_INCLUDE_HOTT)
 
 #include "uavohottbridge.h"
-#include "pios_thread.h"
-
-// Private constants
-#define STACK_SIZE_BYTES 700
-#define TASK_PRIORITY				PIOS_THREAD_PRIO_NORMAL
+#include "telemetry_bridge.h"
+
+// Private types
+enum hott_link_state {
+	HOTT_STATE_WAIT_REQUEST,
+	HOTT_STATE_WAIT_IDLE,		// wait for an idle line before the answer
+	HOTT_STATE_SEND,		// send the answer a byte at a time
+	HOTT_STATE_FLUSH,		// clean up the loopback of the answer
+};
+
+struct hott_link {
+	struct telemetry_bridge bridge;
+	enum hott_link_state state;
+	uint8_t rx_buffer[2];
+	uint8_t tx_buffer[HOTT_MAX_MESSAGE_LENGTH];
+	uint16_t message_size;
+	uint16_t tx_index;
+};
 
 // Private variables
-static struct pios_thread *uavoHoTTBridgeTaskHandle;
 static uint32_t hott_port;
 static bool module_enabled;
 static struct telemetrydata *telestate;
+static struct hott_link *hott;
 
 // Private functions
-static void uavoHoTTBridgeTask(void *parameters);
+static uint32_t uavoHoTTBridgeRun(struct telemetry_bridge *bridge, uint32_t now);
+static uint16_t build_message(uint8_t request, uint8_t id, uint8_t *tx_buffer);
 static uint16_t build_VARIO_message(struct hott_vario_message *msg);
 static uint16_t build_GPS_message(struct hott_gps_message *msg);
 static uint16_t build_GAM_message(struct hott_gam_message *msg);
@@ -68,15 +82,9 @@ static uword_t scale_float2uword(float value, float scale, float offset);
  */
 static int32_t uavoHoTTBridgeStart(void)
 {
-	if (module_enabled) {
-		// Start task
-		uavoHoTTBridgeTaskHandle = PIOS_Thread_Create(
-				uavoHoTTBridgeTask, "uavoHoTTBridge",
-				STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
-		TaskMonitorAdd(TASKINFO_RUNNING_UAVOHOTTBRIDGE,
-				uavoHoTTBridgeTaskHandle);
-		return 0;
-	}
+	if (module_enabled)
+		return TelemetryBridgeStart();
+
 	return -1;
 }
 
@@ -100,12 +108,48 @@ static int32_t uavoHoTTBridgeInitialize(void)
 
 		// allocate memory for telemetry data
 		telestate = (struct telemetrydata *)PIOS_malloc(sizeof(*telestate));
+		hott = (struct hott_link *)PIOS_malloc(sizeof(*hott));
 
-		if (telestate == NULL) {
+		if (telestate == NULL || hott == NULL) {
 			// there is not enough free memory. the module could not run.
 			module_enabled = false;
 			return -1;
 		}
+
+		// clear all state values
+		memset(telestate, 0, sizeof(*telestate));
+		memset(hott, 0, sizeof(*hott));
+
+		// the objects are read from snapshots, zeroed while an object doesn't exist
+		telestate->Settings = TelemetryBridgeSnapshot(HoTTSettingsHandle, sizeof(HoTTSettingsData));
+		telestate->Attitude = TelemetryBridgeSnapshotPolled(AttitudeActualHandle, sizeof(AttitudeActualData));
+		telestate->Baro = TelemetryBridgeSnapshotPolled(BaroAltitudeHandle, sizeof(BaroAltitudeData));
+		telestate->Battery = TelemetryBridgeSnapshot(FlightBatteryStateHandle, sizeof(FlightBatteryStateData));
+		telestate->FlightStatus = TelemetryBridgeSnapshot(FlightStatusHandle, sizeof(FlightStatusData));
+		telestate->GPS = TelemetryBridgeSnapshot(GPSPositionHandle, sizeof(GPSPositionData));
+		telestate->GPStime = TelemetryBridgeSnapshot(GPSTimeHandle, sizeof(GPSTimeData));
+		telestate->Gyro = TelemetryBridgeSnapshotPolled(GyrosHandle, sizeof(GyrosData));
+		telestate->Home = TelemetryBridgeSnapshot(HomeLocationHandle, sizeof(HomeLocationData));
+		telestate->Position = TelemetryBridgeSnapshotPolled(PositionActualHandle, sizeof(PositionActualData));
+		telestate->SysAlarms = TelemetryBridgeSnapshot(SystemAlarmsHandle, sizeof(SystemAlarmsData));
+		telestate->Velocity = TelemetryBridgeSnapshotPolled(VelocityActualHandle, sizeof(VelocityActualData));
+
+		if (!telestate->Settings || !telestate->Attitude || !telestate->Baro ||
+				!telestate->Battery || !telestate->FlightStatus || !telestate->GPS ||
+				!telestate->GPStime || !telestate->Gyro || !telestate->Home ||
+				!telestate->Position || !telestate->SysAlarms || !telestate->Velocity) {
+			module_enabled = false;
+			return -1;
+		}
+
+		hott->state = HOTT_STATE_WAIT_REQUEST;
+		hott->bridge.com = hott_port;
+		hott->bridge.stats_idx = BRIDGESTATS_CPUTIME_HOTT;
+		hott->bridge.run = uavoHoTTBridgeRun;
+		if (TelemetryBridgeRegister(&hott->bridge) != 0) {
+			module_enabled = false;
+			return -1;
+		}
 	} else {
 		module_enabled = false;
 	}
@@ -114,99 +158,104 @@ static int32_t uavoHoTTBridgeInitialize(void)
 MODULE_INITCALL( uavoHoTTBridgeInitialize, uavoHoTTBridgeStart)
 
 /**
- * Main task. It does not return.
+ * Answer the telemetry requests of the receiver
+ *
+ * A request is answered after an idle line of IDLE_TIME, a byte every
+ * DATA_TIME. The receiver line is looped back, so the bytes sent are
+ * read back and thrown away.
+ * \return ms until the next run
  */
-static void uavoHoTTBridgeTask(void *parameters) {
-	uint8_t rx_buffer[2];
-	uint8_t tx_buffer[HOTT_MAX_MESSAGE_LENGTH];
-	uint16_t message_size;
-
-	// clear all state values
-	memset(telestate, 0, sizeof(*telestate));
-
-	// initialize timer variables
-	uint32_t lastSysTime = PIOS_Thread_Systime();
-	// idle delay between telemetry request and answer
-	uint32_t idledelay = IDLE_TIME;
-	// data delay between transmitted bytes
-	uint32_t datadelay = DATA_TIME;
-
-	// work on hott telemetry. endless loop.
-	while (1) {
-		// clear message size on every loop before processing
-		message_size = 0;
-
-		// shift receiver buffer. make room for one byte.
-		rx_buffer[1]= rx_buffer[0];
-
-		// wait for a byte of telemetry request in data delay interval
-		while (PIOS_COM_ReceiveBuffer(hott_port, rx_buffer, 1, 0) == 0) {
-			PIOS_Thread_Sleep_Until(&lastSysTime, datadelay);
-		}
-		// set start trigger point
-		lastSysTime = PIOS_Thread_Systime();
-
-		// examine received data stream
-		if (rx_buffer[1] == HOTT_BINARY_ID) {
-			// first received byte looks like a binary request. check second received byte for a sensor id.
-			switch (rx_buffer[0]) {
-				case HOTT_VARIO_ID:
-					message_size = build_VARIO_message((struct hott_vario_message *)tx_buffer);
-					break;
-				case HOTT_GPS_ID:
-					message_size = build_GPS_message((struct hott_gps_message *)tx_buffer);
-					break;
-				case HOTT_GAM_ID:
-					message_size = build_GAM_message((struct hott_gam_message *)tx_buffer);
-					break;
-				case HOTT_EAM_ID:
-					message_size = build_EAM_message((struct hott_eam_message *)tx_buffer);
-					break;
-				case HOTT_ESC_ID:
-					message_size = build_ESC_message((struct hott_esc_message *)tx_buffer);
-					break;
-				default:
-					message_size = 0;
-			}
-		}
-		else if (rx_buffer[1] == HOTT_TEXT_ID) {
-			// first received byte looks like a text request. check second received byte for a valid button.
-			switch (rx_buffer[0]) {
-				case HOTT_BUTTON_DEC:
-				case HOTT_BUTTON_INC:
-				case HOTT_BUTTON_SET:
-				case HOTT_BUTTON_NIL:
-				case HOTT_BUTTON_NEXT:
-				case HOTT_BUTTON_PREV:
-					message_size = build_TEXT_message((struct hott_text_message *)tx_buffer);
-					break;
-				default:
-					message_size = 0;
+static uint32_t uavoHoTTBridgeRun(struct telemetry_bridge *bridge, uint32_t now)
+{
+	uint8_t rx_byte[2];
+
+	switch (hott->state) {
+	case HOTT_STATE_WAIT_REQUEST:
+		while (TelemetryBridgeReceive(bridge, rx_byte, 1) > 0) {
+			// shift receiver buffer. make room for one byte.
+			hott->rx_buffer[1] = hott->rx_buffer[0];
+			hott->rx_buffer[0] = rx_byte[0];
+
+			hott->message_size = build_message(hott->rx_buffer[1], hott->rx_buffer[0], hott->tx_buffer);
+			if (hott->message_size > 0) {
+				// check idle line before transmit
+				hott->state = HOTT_STATE_WAIT_IDLE;
+				return IDLE_TIME;
 			}
 		}
+		return DATA_TIME;
 
-		// check if a message is in the transmit buffer.
-		if (message_size > 0) {
-			// check idle line before transmit. pause, then check receiver buffer
-			PIOS_Thread_Sleep_Until(&lastSysTime, idledelay);
-
-			if (PIOS_COM_ReceiveBuffer(hott_port, rx_buffer, 1, 0) == 0) {
-				// nothing received means idle line. ready to transmit the requested message
-				for (int i = 0; i < message_size; i++) {
-					// send message content with pause between each byte
-					PIOS_COM_SendCharNonBlocking(hott_port, tx_buffer[i]);
-					// grab possible incoming loopback data and throw it away
-					PIOS_COM_ReceiveBuffer(hott_port, rx_buffer, sizeof(rx_buffer), 0);
-					PIOS_Thread_Sleep_Until(&lastSysTime, datadelay);
-				}
-
-				// after transmitting the message, any loopback data needs to be cleaned up.
-				PIOS_Thread_Sleep_Until(&lastSysTime, idledelay);
-				PIOS_COM_ReceiveBuffer(hott_port, tx_buffer, message_size, 0);
-			}
+	case HOTT_STATE_WAIT_IDLE:
+		if (TelemetryBridgeReceive(bridge, hott->rx_buffer, 1) > 0) {
+			// the line is busy, drop the answer
+			hott->state = HOTT_STATE_WAIT_REQUEST;
+			return DATA_TIME;
 		}
+		hott->tx_index = 0;
+		hott->state = HOTT_STATE_SEND;
+		// fall through
+
+	case HOTT_STATE_SEND:
+		TelemetryBridgeSend(bridge, &hott->tx_buffer[hott->tx_index++], 1);
+		// grab possible incoming loopback data and throw it away
+		TelemetryBridgeReceive(bridge, rx_byte, sizeof(rx_byte));
+
+		if (hott->tx_index < hott->message_size)
+			return DATA_TIME;
+
+		hott->state = HOTT_STATE_FLUSH;
+		return IDLE_TIME;
+
+	case HOTT_STATE_FLUSH:
+		// after transmitting the message, any loopback data needs to be cleaned up.
+		TelemetryBridgeReceive(bridge, hott->tx_buffer, hott->message_size);
+		hott->state = HOTT_STATE_WAIT_REQUEST;
+		return DATA_TIME;
+	}
 
+	return DATA_TIME;
+}
+
+/**
+ * Build the answer to a request
+ * \return value sets message size, 0 if there is no answer
+ */
+static uint16_t build_message(uint8_t request, uint8_t id, uint8_t *tx_buffer)
+{
+	// examine received data stream
+	if (request == HOTT_BINARY_ID) {
+		// first received byte looks like a binary request. check second received byte for a sensor id.
+		switch (id) {
+			case HOTT_VARIO_ID:
+				return build_VARIO_message((struct hott_vario_message *)tx_buffer);
+			case HOTT_GPS_ID:
+				return build_GPS_message((struct hott_gps_message *)tx_buffer);
+			case HOTT_GAM_ID:
+				return build_GAM_message((struct hott_gam_message *)tx_buffer);
+			case HOTT_EAM_ID:
+				return build_EAM_message((struct hott_eam_message *)tx_buffer);
+			case HOTT_ESC_ID:
+				return build_ESC_message((struct hott_esc_message *)tx_buffer);
+			default:
+				return 0;
+		}
+	}
+	else if (request == HOTT_TEXT_ID) {
+		// first received byte looks like a text request. check second received byte for a valid button.
+		switch (id) {
+			case HOTT_BUTTON_DEC:
+			case HOTT_BUTTON_INC:
+			case HOTT_BUTTON_SET:
+			case HOTT_BUTTON_NIL:
+			case HOTT_BUTTON_NEXT:
+			case HOTT_BUTTON_PREV:
+				return build_TEXT_message((struct hott_text_message *)tx_buffer);
+			default:
+				return 0;
+		}
 	}
+
+	return 0;
 }
 
 /**
@@ -216,7 +265,7 @@ static void uavoHoTTBridgeTask(void *parameters) {
 uint16_t build_VARIO_message(struct hott_vario_message *msg) {
 	update_telemetrydata();
 
-	if (telestate->Settings.Sensor[HOTTSETTINGS_SENSOR_VARIO] == HOTTSETTINGS_SENSOR_DISABLED)
+	if (telestate->Settings->Sensor[HOTTSETTINGS_SENSOR_VARIO] == HOTTSETTINGS_SENSOR_DISABLED)
 		return 0;
 
 	// clear message buffer
@@ -230,16 +279,16 @@ uint16_t build_VARIO_message(struct hott_vario_message *msg) {
 	msg->sensor_text_id = HOTT_VARIO_TEXT_ID;
 
 	// alarm inverse bits. invert display areas on limits
-	msg->alarm_inverse |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MINHEIGHT] > telestate->altitude) ? VARIO_INVERT_ALT : 0;
-	msg->alarm_inverse |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MAXHEIGHT] < telestate->altitude) ? VARIO_INVERT_ALT : 0;
-	msg->alarm_inverse |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MAXHEIGHT] < telestate->altitude) ? VARIO_INVERT_MAX : 0;
-	msg->alarm_inverse |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MINHEIGHT] > telestate->altitude) ? VARIO_INVERT_MIN : 0;
-	msg->alarm_inverse |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_NEGDIFFERENCE1] > telestate->climbrate1s) ? VARIO_INVERT_CR1S : 0;
-	msg->alarm_inverse |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_POSDIFFERENCE1] < telestate->climbrate1s) ? VARIO_INVERT_CR1S : 0;
-	msg->alarm_inverse |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_NEGDIFFERENCE2] > telestate->climbrate3s) ? VARIO_INVERT_CR3S : 0;
-	msg->alarm_inverse |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_POSDIFFERENCE2] < telestate->climbrate3s) ? VARIO_INVERT_CR3S : 0;
-	msg->alarm_inverse |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_NEGDIFFERENCE2] > telestate->climbrate10s) ? VARIO_INVERT_CR10S : 0;
-	msg->alarm_inverse |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_POSDIFFERENCE2] < telestate->climbrate10s) ? VARIO_INVERT_CR10S : 0;
+	msg->alarm_inverse |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MINHEIGHT] > telestate->altitude) ? VARIO_INVERT_ALT : 0;
+	msg->alarm_inverse |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MAXHEIGHT] < telestate->altitude) ? VARIO_INVERT_ALT : 0;
+	msg->alarm_inverse |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MAXHEIGHT] < telestate->altitude) ? VARIO_INVERT_MAX : 0;
+	msg->alarm_inverse |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MINHEIGHT] > telestate->altitude) ? VARIO_INVERT_MIN : 0;
+	msg->alarm_inverse |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_NEGDIFFERENCE1] > telestate->climbrate1s) ? VARIO_INVERT_CR1S : 0;
+	msg->alarm_inverse |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_POSDIFFERENCE1] < telestate->climbrate1s) ? VARIO_INVERT_CR1S : 0;
+	msg->alarm_inverse |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_NEGDIFFERENCE2] > telestate->climbrate3s) ? VARIO_INVERT_CR3S : 0;
+	msg->alarm_inverse |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_POSDIFFERENCE2] < telestate->climbrate3s) ? VARIO_INVERT_CR3S : 0;
+	msg->alarm_inverse |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_NEGDIFFERENCE2] > telestate->climbrate10s) ? VARIO_INVERT_CR10S : 0;
+	msg->alarm_inverse |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_POSDIFFERENCE2] < telestate->climbrate10s) ? VARIO_INVERT_CR10S : 0;
 
 	// altitude relative to ground
 	msg->altitude = scale_float2uword(telestate->altitude, 1, OFFSET_ALTITUDE);
@@ -252,7 +301,7 @@ uint16_t build_VARIO_message(struct hott_vario_message *msg) {
 	msg->climbrate10s = scale_float2uword(telestate->climbrate10s, M_TO_CM, OFFSET_CLIMBRATE);
 
 	// compass
-	msg->compass = scale_float2int8(telestate->Attitude.Yaw, DEG_TO_UINT, 0);
+	msg->compass = scale_float2int8(telestate->Attitude->Yaw, DEG_TO_UINT, 0);
 
 	// statusline
 	memcpy(msg->ascii, telestate->statusline, sizeof(msg->ascii));
@@ -269,7 +318,7 @@ uint16_t build_VARIO_message(struct hott_vario_message *msg) {
 uint16_t build_GPS_message(struct hott_gps_message *msg) {
 	update_telemetrydata();
 
-	if (telestate->Settings.Sensor[HOTTSETTINGS_SENSOR_GPS] == HOTTSETTINGS_SENSOR_DISABLED)
+	if (telestate->Settings->Sensor[HOTTSETTINGS_SENSOR_GPS] == HOTTSETTINGS_SENSOR_DISABLED)
 		return 0;
 
 	// clear message buffer
@@ -283,27 +332,27 @@ uint16_t build_GPS_message(struct hott_gps_message *msg) {
 	msg->sensor_text_id = HOTT_GPS_TEXT_ID;
 
 	// alarm inverse bits. invert display areas on limits
-	msg->alarm_inverse1 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MAXDISTANCE] < telestate->homedistance) ? GPS_INVERT_HDIST : 0;
-	msg->alarm_inverse1 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MINSPEED] > telestate->GPS.Groundspeed) ? GPS_INVERT_SPEED : 0;
-	msg->alarm_inverse1 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MAXSPEED] < telestate->GPS.Groundspeed) ? GPS_INVERT_SPEED : 0;
-	msg->alarm_inverse1 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MINHEIGHT] > telestate->altitude) ? GPS_INVERT_ALT : 0;
-	msg->alarm_inverse1 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MAXHEIGHT] < telestate->altitude) ? GPS_INVERT_ALT : 0;
-	msg->alarm_inverse1 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_NEGDIFFERENCE1] > telestate->climbrate1s) ? GPS_INVERT_CR1S : 0;
-	msg->alarm_inverse1 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_POSDIFFERENCE1] < telestate->climbrate1s) ? GPS_INVERT_CR1S : 0;
-	msg->alarm_inverse1 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_NEGDIFFERENCE2] > telestate->climbrate3s) ? GPS_INVERT_CR3S : 0;
-	msg->alarm_inverse1 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_POSDIFFERENCE2] < telestate->climbrate3s) ? GPS_INVERT_CR3S : 0;
-	msg->alarm_inverse2 |= (telestate->SysAlarms.Alarm[SYSTEMALARMS_ALARM_GPS] != SYSTEMALARMS_ALARM_OK) ? GPS_INVERT2_POS : 0;
+	msg->alarm_inverse1 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MAXDISTANCE] < telestate->homedistance) ? GPS_INVERT_HDIST : 0;
+	msg->alarm_inverse1 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MINSPEED] > telestate->GPS->Groundspeed) ? GPS_INVERT_SPEED : 0;
+	msg->alarm_inverse1 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MAXSPEED] < telestate->GPS->Groundspeed) ? GPS_INVERT_SPEED : 0;
+	msg->alarm_inverse1 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MINHEIGHT] > telestate->altitude) ? GPS_INVERT_ALT : 0;
+	msg->alarm_inverse1 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MAXHEIGHT] < telestate->altitude) ? GPS_INVERT_ALT : 0;
+	msg->alarm_inverse1 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_NEGDIFFERENCE1] > telestate->climbrate1s) ? GPS_INVERT_CR1S : 0;
+	msg->alarm_inverse1 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_POSDIFFERENCE1] < telestate->climbrate1s) ? GPS_INVERT_CR1S : 0;
+	msg->alarm_inverse1 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_NEGDIFFERENCE2] > telestate->climbrate3s) ? GPS_INVERT_CR3S : 0;
+	msg->alarm_inverse1 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_POSDIFFERENCE2] < telestate->climbrate3s) ? GPS_INVERT_CR3S : 0;
+	msg->alarm_inverse2 |= (telestate->SysAlarms->Alarm[SYSTEMALARMS_ALARM_GPS] != SYSTEMALARMS_ALARM_OK) ? GPS_INVERT2_POS : 0;
 
 	// gps direction, groundspeed and postition
-	msg->flight_direction = scale_float2uint8(telestate->GPS.Heading, DEG_TO_UINT, 0);
-	msg->gps_speed = scale_float2uword(telestate->GPS.Groundspeed, MS_TO_KMH, 0);
-	convert_long2gps(telestate->GPS.Latitude, &msg->latitude_ns, &msg->latitude_min, &msg->latitude_sec);
-	convert_long2gps(telestate->GPS.Longitude, &msg->longitude_ew, &msg->longitude_min, &msg->longitude_sec);
+	msg->flight_direction = scale_float2uint8(telestate->GPS->Heading, DEG_TO_UINT, 0);
+	msg->gps_speed = scale_float2uword(telestate->GPS->Groundspeed, MS_TO_KMH, 0);
+	convert_long2gps(telestate->GPS->Latitude, &msg->latitude_ns, &msg->latitude_min, &msg->latitude_sec);
+	convert_long2gps(telestate->GPS->Longitude, &msg->longitude_ew, &msg->longitude_min, &msg->longitude_sec);
 
 	// homelocation distance, course and state
 	msg->distance = scale_float2uword(telestate->homedistance, 1, 0);
 	msg->home_direction = scale_float2uint8(telestate->homecourse, DEG_TO_UINT, 0);
-	msg->ascii5 = (telestate->Home.Set ? 'H' : '-');
+	msg->ascii5 = (telestate->Home->Set ? 'H' : '-');
 
 	// altitude relative to ground and climb rate
 	msg->altitude = scale_float2uword(telestate->altitude, 1, OFFSET_ALTITUDE);
@@ -311,8 +360,8 @@ uint16_t build_GPS_message(struct hott_gps_message *msg) {
 	msg->climbrate3s = scale_float2uint8(telestate->climbrate3s, 1, OFFSET_CLIMBRATE3S);
 
 	// number of satellites,gps fix and state
-	msg->gps_num_sat = telestate->GPS.Satellites;
-	switch (telestate->GPS.Status) {
+	msg->gps_num_sat = telestate->GPS->Satellites;
+	switch (telestate->GPS->Status) {
 		case GPSPOSITION_STATUS_FIX2D:
 			msg->gps_fix_char = '2';
 			break;
@@ -323,11 +372,11 @@ uint16_t build_GPS_message(struct hott_gps_message *msg) {
 		default:
 			msg->gps_fix_char = 0;
 	}
-	switch (telestate->SysAlarms.Alarm[SYSTEMALARMS_ALARM_GPS]) {
+	switch (telestate->SysAlarms->Alarm[SYSTEMALARMS_ALARM_GPS]) {
 		case SYSTEMALARMS_ALARM_UNINITIALISED:
 			msg->ascii6 = 0;
 			// if there is no gps, show compass flight direction
-			msg->flight_direction = scale_float2int8((telestate->Attitude.Yaw > 0) ? telestate->Attitude.Yaw : 360 + telestate->Attitude.Yaw , DEG_TO_UINT, 0);
+			msg->flight_direction = scale_float2int8((telestate->Attitude->Yaw > 0) ? telestate->Attitude->Yaw : 360 + telestate->Attitude->Yaw , DEG_TO_UINT, 0);
 			break;
 		case SYSTEMALARMS_ALARM_OK:
 			msg->ascii6 = '.';
@@ -344,18 +393,18 @@ uint16_t build_GPS_message(struct hott_gps_message *msg) {
 	}
 
 	// model angles
-	msg->angle_roll = scale_float2int8(telestate->Attitude.Roll, DEG_TO_UINT, 0);
-	msg->angle_nick = scale_float2int8(telestate->Attitude.Pitch, DEG_TO_UINT, 0);
-	msg->angle_compass = scale_float2int8(telestate->Attitude.Yaw, DEG_TO_UINT, 0);
+	msg->angle_roll = scale_float2int8(telestate->Attitude->Roll, DEG_TO_UINT, 0);
+	msg->angle_nick = scale_float2int8(telestate->Attitude->Pitch, DEG_TO_UINT, 0);
+	msg->angle_compass = scale_float2int8(telestate->Attitude->Yaw, DEG_TO_UINT, 0);
 
 	// gps time
-	msg->gps_hour = telestate->GPStime.Hour;
-	msg->gps_min = telestate->GPStime.Minute;
-	msg->gps_sec = telestate->GPStime.Second;
+	msg->gps_hour = telestate->GPStime->Hour;
+	msg->gps_min = telestate->GPStime->Minute;
+	msg->gps_sec = telestate->GPStime->Second;
 	msg->gps_msec = 0;
 
 	// gps MSL (NN) altitude MSL
-	msg->msl = scale_float2uword(telestate->GPS.Altitude, 1, 0);
+	msg->msl = scale_float2uword(telestate->GPS->Altitude, 1, 0);
 
 	// free display chararacter
 	msg->ascii4 = 0;
@@ -367,7 +416,7 @@ uint16_t build_GPS_message(struct hott_gps_message *msg) {
 uint16_t build_GAM_message(struct hott_gam_message *msg) {
 	update_telemetrydata();
 
-	if (telestate->Settings.Sensor[HOTTSETTINGS_SENSOR_GAM] == HOTTSETTINGS_SENSOR_DISABLED)
+	if (telestate->Settings->Sensor[HOTTSETTINGS_SENSOR_GAM] == HOTTSETTINGS_SENSOR_DISABLED)
 		return 0;
 
 	// clear message buffer
@@ -381,19 +430,19 @@ uint16_t build_GAM_message(struct hott_gam_message *msg) {
 	msg->sensor_text_id = HOTT_GAM_TEXT_ID;
 
 	// alarm inverse bits. invert display areas on limits
-	msg->alarm_inverse2 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MAXCURRENT] < telestate->Battery.Current) ? GAM_INVERT2_CURRENT : 0;
-	msg->alarm_inverse2 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MINPOWERVOLTAGE] > telestate->Battery.Voltage) ? GAM_INVERT2_VOLTAGE : 0;
-	msg->alarm_inverse2 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MAXPOWERVOLTAGE] < telestate->Battery.Voltage) ? GAM_INVERT2_VOLTAGE : 0;
-	msg->alarm_inverse2 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MINHEIGHT] > telestate->altitude) ? GAM_INVERT2_ALT : 0;
-	msg->alarm_inverse2 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MAXHEIGHT] < telestate->altitude) ? GAM_INVERT2_ALT : 0;
-	msg->alarm_inverse2 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_NEGDIFFERENCE1] > telestate->climbrate1s) ? GAM_INVERT2_CR1S : 0;
-	msg->alarm_inverse2 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_POSDIFFERENCE1] < telestate->climbrate1s) ? GAM_INVERT2_CR1S : 0;
-	msg->alarm_inverse2 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_NEGDIFFERENCE2] > telestate->climbrate3s) ? GAM_INVERT2_CR3S : 0;
-	msg->alarm_inverse2 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_POSDIFFERENCE2] < telestate->climbrate3s) ? GAM_INVERT2_CR3S : 0;
+	msg->alarm_inverse2 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MAXCURRENT] < telestate->Battery->Current) ? GAM_INVERT2_CURRENT : 0;
+	msg->alarm_inverse2 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MINPOWERVOLTAGE] > telestate->Battery->Voltage) ? GAM_INVERT2_VOLTAGE : 0;
+	msg->alarm_inverse2 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MAXPOWERVOLTAGE] < telestate->Battery->Voltage) ? GAM_INVERT2_VOLTAGE : 0;
+	msg->alarm_inverse2 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MINHEIGHT] > telestate->altitude) ? GAM_INVERT2_ALT : 0;
+	msg->alarm_inverse2 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MAXHEIGHT] < telestate->altitude) ? GAM_INVERT2_ALT : 0;
+	msg->alarm_inverse2 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_NEGDIFFERENCE1] > telestate->climbrate1s) ? GAM_INVERT2_CR1S : 0;
+	msg->alarm_inverse2 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_POSDIFFERENCE1] < telestate->climbrate1s) ? GAM_INVERT2_CR1S : 0;
+	msg->alarm_inverse2 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_NEGDIFFERENCE2] > telestate->climbrate3s) ? GAM_INVERT2_CR3S : 0;
+	msg->alarm_inverse2 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_POSDIFFERENCE2] < telestate->climbrate3s) ? GAM_INVERT2_CR3S : 0;
 
 	// temperatures
-	msg->temperature1 = scale_float2uint8(telestate->Gyro.temperature, 1, OFFSET_TEMPERATURE);
-	msg->temperature2 = scale_float2uint8(telestate->Baro.Temperature, 1, OFFSET_TEMPERATURE);
+	msg->temperature1 = scale_float2uint8(telestate->Gyro->temperature, 1, OFFSET_TEMPERATURE);
+	msg->temperature2 = scale_float2uint8(telestate->Baro->Temperature, 1, OFFSET_TEMPERATURE);
 
 	// altitude
 	msg->altitude = scale_float2uword(telestate->altitude, 1, OFFSET_ALTITUDE);
@@ -403,15 +452,15 @@ uint16_t build_GAM_message(struct hott_gam_message *msg) {
 	msg->climbrate3s = scale_float2uint8(telestate->climbrate3s, 1, OFFSET_CLIMBRATE3S);
 
 	// main battery
-	float voltage = (telestate->Battery.Voltage > 0) ? telestate->Battery.Voltage : 0;
-	float current = (telestate->Battery.Current > 0) ? telestate->Battery.Current : 0;
-	float energy = (telestate->Battery.ConsumedEnergy > 0) ? telestate->Battery.ConsumedEnergy : 0;
+	float voltage = (telestate->Battery->Voltage > 0) ? telestate->Battery->Voltage : 0;
+	float current = (telestate->Battery->Current > 0) ? telestate->Battery->Current : 0;
+	float energy = (telestate->Battery->ConsumedEnergy > 0) ? telestate->Battery->ConsumedEnergy : 0;
 	msg->voltage = scale_float2uword(voltage, 10, 0);
 	msg->current = scale_float2uword(current, 10, 0);
 	msg->capacity = scale_float2uword(energy, 0.1, 0);
 
 	// pressure kPa to 0.1Bar
-	msg->pressure = scale_float2uint8(telestate->Baro.Pressure, 0.1, 0);
+	msg->pressure = scale_float2uint8(telestate->Baro->Pressure, 0.1, 0);
 
 	msg->checksum = calc_checksum((uint8_t *)msg, sizeof(*msg));
 	return sizeof(*msg);
@@ -420,7 +469,7 @@ uint16_t build_GAM_message(struct hott_gam_message *msg) {
 uint16_t build_EAM_message(struct hott_eam_message *msg) {
 	update_telemetrydata();
 
-	if (telestate->Settings.Sensor[HOTTSETTINGS_SENSOR_EAM] == HOTTSETTINGS_SENSOR_DISABLED)
+	if (telestate->Settings->Sensor[HOTTSETTINGS_SENSOR_EAM] == HOTTSETTINGS_SENSOR_DISABLED)
 		return 0;
 
 	// clear message buffer
@@ -434,28 +483,28 @@ uint16_t build_EAM_message(struct hott_eam_message *msg) {
 	msg->sensor_text_id = HOTT_EAM_TEXT_ID;
 
 	// alarm inverse bits. invert display areas on limits
-	msg->alarm_inverse1 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MAXUSEDCAPACITY] < telestate->Battery.ConsumedEnergy) ? EAM_INVERT_CAPACITY : 0;
-	msg->alarm_inverse1 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MAXCURRENT] < telestate->Battery.Current) ? EAM_INVERT_CURRENT : 0;
-	msg->alarm_inverse1 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MINPOWERVOLTAGE] > telestate->Battery.Voltage) ? EAM_INVERT_VOLTAGE : 0;
-	msg->alarm_inverse1 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MAXPOWERVOLTAGE] < telestate->Battery.Voltage) ? EAM_INVERT_VOLTAGE : 0;
-	msg->alarm_inverse2 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MINHEIGHT] > telestate->altitude) ? EAM_INVERT2_ALT : 0;
-	msg->alarm_inverse2 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MAXHEIGHT] < telestate->altitude) ? EAM_INVERT2_ALT : 0;
-	msg->alarm_inverse2 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_NEGDIFFERENCE1] > telestate->climbrate1s) ? EAM_INVERT2_CR1S : 0;
-	msg->alarm_inverse2 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_POSDIFFERENCE1] < telestate->climbrate1s) ? EAM_INVERT2_CR1S : 0;
-	msg->alarm_inverse2 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_NEGDIFFERENCE2] > telestate->climbrate3s) ? EAM_INVERT2_CR3S : 0;
-	msg->alarm_inverse2 |= (telestate->Settings.Limit[HOTTSETTINGS_LIMIT_POSDIFFERENCE2] < telestate->climbrate3s) ? EAM_INVERT2_CR3S : 0;
+	msg->alarm_inverse1 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MAXUSEDCAPACITY] < telestate->Battery->ConsumedEnergy) ? EAM_INVERT_CAPACITY : 0;
+	msg->alarm_inverse1 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MAXCURRENT] < telestate->Battery->Current) ? EAM_INVERT_CURRENT : 0;
+	msg->alarm_inverse1 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MINPOWERVOLTAGE] > telestate->Battery->Voltage) ? EAM_INVERT_VOLTAGE : 0;
+	msg->alarm_inverse1 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MAXPOWERVOLTAGE] < telestate->Battery->Voltage) ? EAM_INVERT_VOLTAGE : 0;
+	msg->alarm_inverse2 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MINHEIGHT] > telestate->altitude) ? EAM_INVERT2_ALT : 0;
+	msg->alarm_inverse2 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MAXHEIGHT] < telestate->altitude) ? EAM_INVERT2_ALT : 0;
+	msg->alarm_inverse2 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_NEGDIFFERENCE1] > telestate->climbrate1s) ? EAM_INVERT2_CR1S : 0;
+	msg->alarm_inverse2 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_POSDIFFERENCE1] < telestate->climbrate1s) ? EAM_INVERT2_CR1S : 0;
+	msg->alarm_inverse2 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_NEGDIFFERENCE2] > telestate->climbrate3s) ? EAM_INVERT2_CR3S : 0;
+	msg->alarm_inverse2 |= (telestate->Settings->Limit[HOTTSETTINGS_LIMIT_POSDIFFERENCE2] < telestate->climbrate3s) ? EAM_INVERT2_CR3S : 0;
 
 	// main battery
-	float voltage = (telestate->Battery.Voltage > 0) ? telestate->Battery.Voltage : 0;
-	float current = (telestate->Battery.Current > 0) ? telestate->Battery.Current : 0;
-	float energy = (telestate->Battery.ConsumedEnergy > 0) ? telestate->Battery.ConsumedEnergy : 0;
+	float voltage = (telestate->Battery->Voltage > 0) ? telestate->Battery->Voltage : 0;
+	float current = (telestate->Battery->Current > 0) ? telestate->Battery->Current : 0;
+	float energy = (telestate->Battery->ConsumedEnergy > 0) ? telestate->Battery->ConsumedEnergy : 0;
 	msg->voltage = scale_float2uword(voltage, 10, 0);
 	msg->current = scale_float2uword(current, 10, 0);
 	msg->capacity = scale_float2uword(energy, 0.1, 0);
 
 	// temperatures
-	msg->temperature1 = scale_float2uint8(telestate->Gyro.temperature, 1, OFFSET_TEMPERATURE);
-	msg->temperature2 = scale_float2uint8(telestate->Baro.Temperature, 1, OFFSET_TEMPERATURE);
+	msg->temperature1 = scale_float2uint8(telestate->Gyro->temperature, 1, OFFSET_TEMPERATURE);
+	msg->temperature2 = scale_float2uint8(telestate->Baro->Temperature, 1, OFFSET_TEMPERATURE);
 
 	// altitude
 	msg->altitude = scale_float2uword(telestate->altitude, 1, OFFSET_ALTITUDE);
@@ -465,7 +514,7 @@ uint16_t build_EAM_message(struct hott_eam_message *msg) {
 	msg->climbrate3s = scale_float2uint8(telestate->climbrate3s, 1, OFFSET_CLIMBRATE3S);
 
 	// flight time
-	float flighttime = (telestate->Battery.EstimatedFlightTime <= 5999) ? telestate->Battery.EstimatedFlightTime : 5999;
+	float flighttime = (telestate->Battery->EstimatedFlightTime <= 5999) ? telestate->Battery->EstimatedFlightTime : 5999;
 	msg->electric_min = flighttime / 60;
 	msg->electric_sec = flighttime - 60 * msg->electric_min;
 
@@ -476,7 +525,7 @@ uint16_t build_EAM_message(struct hott_eam_message *msg) {
 uint16_t build_ESC_message(struct hott_esc_message *msg) {
 	update_telemetrydata();
 
-	if (telestate->Settings.Sensor[HOTTSETTINGS_SENSOR_ESC] == HOTTSETTINGS_SENSOR_DISABLED)
+	if (telestate->Settings->Sensor[HOTTSETTINGS_SENSOR_ESC] == HOTTSETTINGS_SENSOR_DISABLED)
 		return 0;
 
 	// clear message buffer
@@ -490,19 +539,19 @@ uint16_t build_ESC_message(struct hott_esc_message *msg) {
 	msg->sensor_text_id = HOTT_ESC_TEXT_ID;
 
 	// main batterie
-	float voltage = (telestate->Battery.Voltage > 0) ? telestate->Battery.Voltage : 0;
-	float current = (telestate->Battery.Current > 0) ? telestate->Battery.Current : 0;
-	float max_current = (telestate->Battery.PeakCurrent > 0) ? telestate->Battery.PeakCurrent : 0;
-	float energy = (telestate->Battery.ConsumedEnergy > 0) ? telestate->Battery.ConsumedEnergy : 0;
+	float voltage = (telestate->Battery->Voltage > 0) ? telestate->Battery->Voltage : 0;
+	float current = (telestate->Battery->Current > 0) ? telestate->Battery->Current : 0;
+	float max_current = (telestate->Battery->PeakCurrent > 0) ? telestate->Battery->PeakCurrent : 0;
+	float energy = (telestate->Battery->ConsumedEnergy > 0) ? telestate->Battery->ConsumedEnergy : 0;
 	msg->batt_voltage = scale_float2uword(voltage, 10, 0);
 	msg->current = scale_float2uword(current, 10, 0);
 	msg->max_current = scale_float2uword(max_current, 10, 0);
 	msg->batt_capacity = scale_float2uword(energy, 0.1, 0);
 
 	// temperatures
-	msg->temperatureESC = scale_float2uint8(telestate->Gyro.temperature, 1, OFFSET_TEMPERATURE);
+	msg->temperatureESC = scale_float2uint8(telestate->Gyro->temperature, 1, OFFSET_TEMPERATURE);
 	msg->max_temperatureESC = scale_float2uint8(0, 1, OFFSET_TEMPERATURE);
-	msg->temperatureMOT = scale_float2uint8(telestate->Baro.Temperature, 1, OFFSET_TEMPERATURE);
+	msg->temperatureMOT = scale_float2uint8(telestate->Baro->Temperature, 1, OFFSET_TEMPERATURE);
 	msg->max_temperatureMOT = scale_float2uint8(0, 1, OFFSET_TEMPERATURE);
 
 	msg->checksum = calc_checksum((uint8_t *)msg, sizeof(*msg));
@@ -531,35 +580,11 @@ uint16_t build_TEXT_message(struct hott_text_message *msg) {
  * 200ms telemetry request is used as time base for timed calculations (5Hz interval)
 */
 void update_telemetrydata () {
-	// update all available data
-	if (HoTTSettingsHandle() != NULL)
-		HoTTSettingsGet(&telestate->Settings);
-	if (AttitudeActualHandle() != NULL)
-		AttitudeActualGet(&telestate->Attitude);
-	if (BaroAltitudeHandle() != NULL)
-		BaroAltitudeGet(&telestate->Baro);
-	if (FlightBatteryStateHandle() != NULL)
-		FlightBatteryStateGet(&telestate->Battery);
-	if (FlightStatusHandle() != NULL)
-		FlightStatusGet(&telestate->FlightStatus);
-	if (GPSPositionHandle() != NULL)
-		GPSPositionGet(&telestate->GPS);
-	if (GPSTimeHandle() != NULL)
-		GPSTimeGet(&telestate->GPStime);
-	if (GyrosHandle() != NULL)
-		GyrosGet(&telestate->Gyro);
-	if (HomeLocationHandle() != NULL)
-		HomeLocationGet(&telestate->Home);
-	if (PositionActualHandle() != NULL)
-		PositionActualGet(&telestate->Position);
-	if (SystemAlarmsHandle() != NULL)
-		SystemAlarmsGet(&telestate->SysAlarms);
-	if (VelocityActualHandle() != NULL)
-		VelocityActualGet(&telestate->Velocity);
+	// the objects are refreshed by the bridge runtime when they change
 
 	// send actual climbrate value to ring buffer as mm per 0.2s values
 	uint8_t n = telestate->climbrate_pointer;
-	telestate->climbratebuffer[telestate->climbrate_pointer++] = -telestate->Velocity.Down * 200;
+	telestate->climbratebuffer[telestate->climbrate_pointer++] = -telestate->Velocity->Down * 200;
 	telestate->climbrate_pointer %= climbratesize;
 
 	// calculate avarage climbrates in meters per 1, 3 and 10 second(s) based on 200ms interval
@@ -578,17 +603,17 @@ void update_telemetrydata () {
 	telestate->climbrate10s = telestate->climbrate10s / 1000;
 
 	// set altitude offset and clear min/max values when arming
-	if ((telestate->FlightStatus.Armed == FLIGHTSTATUS_ARMED_ARMING) || ((telestate->last_armed != FLIGHTSTATUS_ARMED_ARMED) && (telestate->FlightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED))) {
+	if ((telestate->FlightStatus->Armed == FLIGHTSTATUS_ARMED_ARMING) || ((telestate->last_armed != FLIGHTSTATUS_ARMED_ARMED) && (telestate->FlightStatus->Armed == FLIGHTSTATUS_ARMED_ARMED))) {
 		telestate->min_altitude = 0;
 		telestate->max_altitude = 0;
 	}
-	telestate->last_armed = telestate->FlightStatus.Armed;
+	telestate->last_armed = telestate->FlightStatus->Armed;
 
 	// calculate altitude relative to start position
-	telestate->altitude = -telestate->Position.Down;
+	telestate->altitude = -telestate->Position->Down;
 
 	// check and set min/max values when armed.
-	if (telestate->FlightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED) {
+	if (telestate->FlightStatus->Armed == FLIGHTSTATUS_ARMED_ARMED) {
 		if (telestate->min_altitude > telestate->altitude)
 			telestate->min_altitude = telestate->altitude;
 		if (telestate->max_altitude < telestate->altitude)
@@ -596,9 +621,9 @@ void update_telemetrydata () {
 	}
 
 	// gps home position and course
-	telestate->homedistance = sqrtf(telestate->Position.North * telestate->Position.North + telestate->Position.East * telestate->Position.East);
-	telestate->homecourse = acosf(- telestate->Position.North / telestate->homedistance) / 3.14159265f * 180;
-	if (telestate->Position.East > 0)
+	telestate->homedistance = sqrtf(telestate->Position->North * telestate->Position->North + telestate->Position->East * telestate->Position->East);
+	telestate->homecourse = acosf(- telestate->Position->North / telestate->homedistance) / 3.14159265f * 180;
+	if (telestate->Position->East > 0)
 		telestate->homecourse = 360 - telestate->homecourse;
 
 	// statusline
@@ -621,7 +646,7 @@ void update_telemetrydata () {
 	const char *txt_armed = "Armed";
 
 	const char *txt_flightmode;
-	switch (telestate->FlightStatus.FlightMode) {
+	switch (telestate->FlightStatus->FlightMode) {
 		case FLIGHTSTATUS_FLIGHTMODE_MANUAL:
 			txt_flightmode = txt_manual;
 			break;
@@ -666,7 +691,7 @@ void update_telemetrydata () {
 	}
 
 	const char *txt_armstate;
-	switch (telestate->FlightStatus.Armed) {
+	switch (telestate->FlightStatus->Armed) {
 		case FLIGHTSTATUS_ARMED_DISARMED:
 			txt_armstate = txt_disarmed;
 			break;
@@ -688,76 +713,76 @@ void update_telemetrydata () {
 */
 uint8_t generate_warning() {
 	// set warning tone with hardcoded priority
-	if ((telestate->Settings.Warning[HOTTSETTINGS_WARNING_MINSPEED] == HOTTSETTINGS_WARNING_ENABLED) &&
-		(telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MINSPEED] > telestate->GPS.Groundspeed * MS_TO_KMH))
+	if ((telestate->Settings->Warning[HOTTSETTINGS_WARNING_MINSPEED] == HOTTSETTINGS_WARNING_ENABLED) &&
+		(telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MINSPEED] > telestate->GPS->Groundspeed * MS_TO_KMH))
 		return HOTT_TONE_A; // maximum speed
 
-	if ((telestate->Settings.Warning[HOTTSETTINGS_WARNING_NEGDIFFERENCE2] == HOTTSETTINGS_WARNING_ENABLED) &&
-		(telestate->Settings.Limit[HOTTSETTINGS_LIMIT_NEGDIFFERENCE2] > telestate->climbrate3s))
+	if ((telestate->Settings->Warning[HOTTSETTINGS_WARNING_NEGDIFFERENCE2] == HOTTSETTINGS_WARNING_ENABLED) &&
+		(telestate->Settings->Limit[HOTTSETTINGS_LIMIT_NEGDIFFERENCE2] > telestate->climbrate3s))
 		return HOTT_TONE_B; // sink rate 3s
 
-	if ((telestate->Settings.Warning[HOTTSETTINGS_WARNING_NEGDIFFERENCE1] == HOTTSETTINGS_WARNING_ENABLED) &&
-		(telestate->Settings.Limit[HOTTSETTINGS_LIMIT_NEGDIFFERENCE2] > telestate->climbrate1s))
+	if ((telestate->Settings->Warning[HOTTSETTINGS_WARNING_NEGDIFFERENCE1] == HOTTSETTINGS_WARNING_ENABLED) &&
+		(telestate->Settings->Limit[HOTTSETTINGS_LIMIT_NEGDIFFERENCE2] > telestate->climbrate1s))
 		return HOTT_TONE_C; // sink rate 1s
 
-	if ((telestate->Settings.Warning[HOTTSETTINGS_WARNING_MAXDISTANCE] == HOTTSETTINGS_WARNING_ENABLED) &&
-		(telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MAXDISTANCE] < telestate->homedistance))
+	if ((telestate->Settings->Warning[HOTTSETTINGS_WARNING_MAXDISTANCE] == HOTTSETTINGS_WARNING_ENABLED) &&
+		(telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MAXDISTANCE] < telestate->homedistance))
 		return HOTT_TONE_D; // maximum distance
 
-	if ((telestate->Settings.Warning[HOTTSETTINGS_WARNING_MINSENSOR1TEMP] == HOTTSETTINGS_WARNING_ENABLED) &&
-		(telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MINSENSOR1TEMP] > telestate->Gyro.temperature))
+	if ((telestate->Settings->Warning[HOTTSETTINGS_WARNING_MINSENSOR1TEMP] == HOTTSETTINGS_WARNING_ENABLED) &&
+		(telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MINSENSOR1TEMP] > telestate->Gyro->temperature))
 		return HOTT_TONE_F; // minimum temperature sensor 1
 
-	if ((telestate->Settings.Warning[HOTTSETTINGS_WARNING_MINSENSOR2TEMP] == HOTTSETTINGS_WARNING_ENABLED) &&
-		(telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MINSENSOR2TEMP] > telestate->Baro.Temperature))
+	if ((telestate->Settings->Warning[HOTTSETTINGS_WARNING_MINSENSOR2TEMP] == HOTTSETTINGS_WARNING_ENABLED) &&
+		(telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MINSENSOR2TEMP] > telestate->Baro->Temperature))
 		return HOTT_TONE_G; // minimum temperature sensor 2
 
-	if ((telestate->Settings.Warning[HOTTSETTINGS_WARNING_MAXSENSOR1TEMP] == HOTTSETTINGS_WARNING_ENABLED) &&
-		(telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MAXSENSOR1TEMP] < telestate->Gyro.temperature))
+	if ((telestate->Settings->Warning[HOTTSETTINGS_WARNING_MAXSENSOR1TEMP] == HOTTSETTINGS_WARNING_ENABLED) &&
+		(telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MAXSENSOR1TEMP] < telestate->Gyro->temperature))
 		return HOTT_TONE_H; // maximum temperature sensor 1
 
-	if ((telestate->Settings.Warning[HOTTSETTINGS_WARNING_MAXSENSOR2TEMP] == HOTTSETTINGS_WARNING_ENABLED) &&
-		(telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MAXSENSOR2TEMP] < telestate->Baro.Temperature))
+	if ((telestate->Settings->Warning[HOTTSETTINGS_WARNING_MAXSENSOR2TEMP] == HOTTSETTINGS_WARNING_ENABLED) &&
+		(telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MAXSENSOR2TEMP] < telestate->Baro->Temperature))
 		return HOTT_TONE_I; // maximum temperature sensor 2
 
-	if ((telestate->Settings.Warning[HOTTSETTINGS_WARNING_MAXSPEED] == HOTTSETTINGS_WARNING_ENABLED) &&
-		(telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MAXSPEED] < telestate->GPS.Groundspeed * MS_TO_KMH))
+	if ((telestate->Settings->Warning[HOTTSETTINGS_WARNING_MAXSPEED] == HOTTSETTINGS_WARNING_ENABLED) &&
+		(telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MAXSPEED] < telestate->GPS->Groundspeed * MS_TO_KMH))
 		return HOTT_TONE_L; // maximum speed
 
-	if ((telestate->Settings.Warning[HOTTSETTINGS_WARNING_POSDIFFERENCE2] == HOTTSETTINGS_WARNING_ENABLED) &&
-		(telestate->Settings.Limit[HOTTSETTINGS_LIMIT_POSDIFFERENCE2] > telestate->climbrate3s))
+	if ((telestate->Settings->Warning[HOTTSETTINGS_WARNING_POSDIFFERENCE2] == HOTTSETTINGS_WARNING_ENABLED) &&
+		(telestate->Settings->Limit[HOTTSETTINGS_LIMIT_POSDIFFERENCE2] > telestate->climbrate3s))
 		return HOTT_TONE_M; // climb rate 3s
 
-	if ((telestate->Settings.Warning[HOTTSETTINGS_WARNING_POSDIFFERENCE1] == HOTTSETTINGS_WARNING_ENABLED) &&
-		(telestate->Settings.Limit[HOTTSETTINGS_LIMIT_POSDIFFERENCE1] > telestate->climbrate1s))
+	if ((telestate->Settings->Warning[HOTTSETTINGS_WARNING_POSDIFFERENCE1] == HOTTSETTINGS_WARNING_ENABLED) &&
+		(telestate->Settings->Limit[HOTTSETTINGS_LIMIT_POSDIFFERENCE1] > telestate->climbrate1s))
 		return HOTT_TONE_N; // climb rate 1s
 
-	if ((telestate->Settings.Warning[HOTTSETTINGS_WARNING_MINHEIGHT] == HOTTSETTINGS_WARNING_ENABLED) &&
-		(telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MINHEIGHT] > telestate->altitude))
+	if ((telestate->Settings->Warning[HOTTSETTINGS_WARNING_MINHEIGHT] == HOTTSETTINGS_WARNING_ENABLED) &&
+		(telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MINHEIGHT] > telestate->altitude))
 		return HOTT_TONE_O; // minimum height
 
-	if ((telestate->Settings.Warning[HOTTSETTINGS_WARNING_MINPOWERVOLTAGE] == HOTTSETTINGS_WARNING_ENABLED) &&
-		(telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MINPOWERVOLTAGE] > telestate->Battery.Voltage))
+	if ((telestate->Settings->Warning[HOTTSETTINGS_WARNING_MINPOWERVOLTAGE] == HOTTSETTINGS_WARNING_ENABLED) &&
+		(telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MINPOWERVOLTAGE] > telestate->Battery->Voltage))
 		return HOTT_TONE_P; // minimum input voltage
 
-	if ((telestate->Settings.Warning[HOTTSETTINGS_WARNING_MAXUSEDCAPACITY] == HOTTSETTINGS_WARNING_ENABLED) &&
-		(telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MAXUSEDCAPACITY] < telestate->Battery.ConsumedEnergy))
+	if ((telestate->Settings->Warning[HOTTSETTINGS_WARNING_MAXUSEDCAPACITY] == HOTTSETTINGS_WARNING_ENABLED) &&
+		(telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MAXUSEDCAPACITY] < telestate->Battery->ConsumedEnergy))
 		return HOTT_TONE_V; // capacity
 
-	if ((telestate->Settings.Warning[HOTTSETTINGS_WARNING_MAXCURRENT] == HOTTSETTINGS_WARNING_ENABLED) &&
-		(telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MAXCURRENT] < telestate->Battery.Current))
+	if ((telestate->Settings->Warning[HOTTSETTINGS_WARNING_MAXCURRENT] == HOTTSETTINGS_WARNING_ENABLED) &&
+		(telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MAXCURRENT] < telestate->Battery->Current))
 		return HOTT_TONE_W; // maximum current
 
-	if ((telestate->Settings.Warning[HOTTSETTINGS_WARNING_MAXPOWERVOLTAGE] == HOTTSETTINGS_WARNING_ENABLED) &&
-		(telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MAXPOWERVOLTAGE] < telestate->Battery.Voltage))
+	if ((telestate->Settings->Warning[HOTTSETTINGS_WARNING_MAXPOWERVOLTAGE] == HOTTSETTINGS_WARNING_ENABLED) &&
+		(telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MAXPOWERVOLTAGE] < telestate->Battery->Voltage))
 		return HOTT_TONE_X; // maximum input voltage
 
-	if ((telestate->Settings.Warning[HOTTSETTINGS_WARNING_MAXHEIGHT] == HOTTSETTINGS_WARNING_ENABLED) &&
-		(telestate->Settings.Limit[HOTTSETTINGS_LIMIT_MAXHEIGHT] < telestate->altitude))
+	if ((telestate->Settings->Warning[HOTTSETTINGS_WARNING_MAXHEIGHT] == HOTTSETTINGS_WARNING_ENABLED) &&
+		(telestate->Settings->Limit[HOTTSETTINGS_LIMIT_MAXHEIGHT] < telestate->altitude))
 		return HOTT_TONE_Z; // maximum height
 
 	// altitude beeps when crossing altitude limits at 20,40,60,80,100,200,400,600,800 and 1000 meters
-	if (telestate->Settings.Warning[HOTTSETTINGS_WARNING_ALTITUDEBEEP] == HOTTSETTINGS_WARNING_ENABLED) {
+	if (telestate->Settings->Warning[HOTTSETTINGS_WARNING_ALTITUDEBEEP] == HOTTSETTINGS_WARNING_ENABLED) {
 		// update altitude when checked for beeps
 		float last = telestate->altitude_last;
 		float actual = telestate->altitude;
@@ -54,12 +54,10 @@
 #include "accels.h"
 #include "manualcontrolcommand.h"
 #include "flightstatus.h"
-#include "pios_thread.h"
+#include "telemetry_bridge.h"
 
 #if defined(PIOS_INCLUDE_LIGHTTELEMETRY)
 // Private constants
-#define STACK_SIZE_BYTES 512
-#define TASK_PRIORITY PIOS_THREAD_PRIO_LOW
 #define UPDATE_PERIOD 100
 
 #define LTM_GFRAME_SIZE 18
@@ -68,15 +66,27 @@
 
 // Private types
 
+//! Snapshots of the objects sent
+struct ltm_objects {
+	const GPSPositionData *gps;
+	const BaroAltitudeData *baro;
+	const AttitudeActualData *attitude;
+	const FlightBatteryStateData *battery;
+	const ManualControlCommandData *manual;
+	const AirspeedActualData *airspeed;
+	const FlightStatusData *status;
+};
+
 // Private variables
 static bool module_enabled;
-static struct pios_thread *taskHandle;
 static uint32_t lighttelemetryPort;
 static uint8_t ltm_scheduler;
 static uint8_t ltm_slowrate;
+static struct telemetry_bridge ltm_bridge;
+static struct ltm_objects ltm;
 
 // Private functions
-static void uavoLighttelemetryBridgeTask(void *parameters);
+static uint32_t uavoLighttelemetryBridgeRun(struct telemetry_bridge *bridge, uint32_t now);
 static void updateSettings();
 
 static void send_LTM_Packet(uint8_t *LTPacket, uint8_t LTPacket_size);
@@ -111,7 +121,27 @@ int32_t uavoLighttelemetryBridgeInitialize()
 				ltm_slowrate = 1;
 			else 
 				ltm_slowrate = 0;
-	
+
+			GPSPositionInitialize();
+			BaroAltitudeInitialize();
+
+			ltm.gps = TelemetryBridgeSnapshot(GPSPositionHandle, sizeof(*ltm.gps));
+			ltm.baro = TelemetryBridgeSnapshotPolled(BaroAltitudeHandle, sizeof(*ltm.baro));
+			ltm.attitude = TelemetryBridgeSnapshotPolled(AttitudeActualHandle, sizeof(*ltm.attitude));
+			ltm.battery = TelemetryBridgeSnapshot(FlightBatteryStateHandle, sizeof(*ltm.battery));
+			ltm.manual = TelemetryBridgeSnapshotPolled(ManualControlCommandHandle, sizeof(*ltm.manual));
+			ltm.airspeed = TelemetryBridgeSnapshot(AirspeedActualHandle, sizeof(*ltm.airspeed));
+			ltm.status = TelemetryBridgeSnapshot(FlightStatusHandle, sizeof(*ltm.status));
+			if (!ltm.gps || !ltm.baro || !ltm.attitude || !ltm.battery ||
+					!ltm.manual || !ltm.airspeed || !ltm.status)
+				return -1;
+
+			ltm_bridge.com = lighttelemetryPort;
+			ltm_bridge.stats_idx = BRIDGESTATS_CPUTIME_LIGHTTELEMETRY;
+			ltm_bridge.run = uavoLighttelemetryBridgeRun;
+			if (TelemetryBridgeRegister(&ltm_bridge) != 0)
+				return -1;
+
 			module_enabled = true; 
 			return 0;
 		}
@@ -128,9 +158,7 @@ int32_t uavoLighttelemetryBridgeStart()
 {
 	if ( module_enabled )
 	{
-		taskHandle = PIOS_Thread_Create(uavoLighttelemetryBridgeTask, "uavoLighttelemetryBridge", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
-		TaskMonitorAdd(TASKINFO_RUNNING_UAVOLIGHTTELEMETRYBRIDGE, taskHandle);
-		return 0;
+		return TelemetryBridgeStart();
 	}
 	
 	return -1;
@@ -140,38 +168,30 @@ MODULE_INITCALL(uavoLighttelemetryBridgeInitialize, uavoLighttelemetryBridgeStar
 
 
 /*#######################################################################
- * Module thread, should not return.
+ * Run by the telemetry bridge thread every UPDATE_PERIOD
  *#######################################################################
 */
 
-static void uavoLighttelemetryBridgeTask(void *parameters)
+static uint32_t uavoLighttelemetryBridgeRun(struct telemetry_bridge *bridge, uint32_t now)
 {
-	uint32_t lastSysTime;
-
-	// Main task loop
-	lastSysTime = PIOS_Thread_Systime();
-	while (1)
+	if (ltm_scheduler & 1) {	// is odd
+		send_LTM_Aframe();
+	}
+	else						// is even
 	{
-
-		if (ltm_scheduler & 1) {	// is odd
+		if (ltm_slowrate == 0)
 			send_LTM_Aframe();
-		}
-		else						// is even
-		{
-			if (ltm_slowrate == 0)
-				send_LTM_Aframe();
-				
-			if (ltm_scheduler % 4 == 0)
-				send_LTM_Sframe();
-			else 
-				send_LTM_Gframe();
-		}
-		ltm_scheduler++;
-		if (ltm_scheduler > 10)
-			ltm_scheduler = 1;
-		// Delay until it is time to read the next sample
-		PIOS_Thread_Sleep_Until(&lastSysTime, UPDATE_PERIOD);
+			
+		if (ltm_scheduler % 4 == 0)
+			send_LTM_Sframe();
+		else 
+			send_LTM_Gframe();
 	}
+	ltm_scheduler++;
+	if (ltm_scheduler > 10)
+		ltm_scheduler = 1;
+
+	return UPDATE_PERIOD;
 }
 
 /*#######################################################################
@@ -181,26 +201,20 @@ static void uavoLighttelemetryBridgeTask(void *parameters)
 //GPS packet
 static void send_LTM_Gframe() 
 {
-	GPSPositionData pdata;
-	BaroAltitudeData bdata;
-	GPSPositionInitialize();
-	BaroAltitudeInitialize();
+	const GPSPositionData *pdata = ltm.gps;
 	 //prepare data
-	GPSPositionGet(&pdata);
-
-	int32_t lt_latitude = pdata.Latitude;
-	int32_t lt_longitude = pdata.Longitude;
-	uint8_t lt_groundspeed = (uint8_t)roundf(pdata.Groundspeed); //rounded m/s .
+	int32_t lt_latitude = pdata->Latitude;
+	int32_t lt_longitude = pdata->Longitude;
+	uint8_t lt_groundspeed = (uint8_t)roundf(pdata->Groundspeed); //rounded m/s .
 	int32_t lt_altitude = 0;
 	if (BaroAltitudeHandle() != NULL) {
-		BaroAltitudeGet(&bdata);
-		lt_altitude = (int32_t)roundf(bdata.Altitude * 100.0f); //Baro alt in cm.
+		lt_altitude = (int32_t)roundf(ltm.baro->Altitude * 100.0f); //Baro alt in cm.
 	}
 	else if (GPSPositionHandle() != NULL)
-		lt_altitude = (int32_t)roundf(pdata.Altitude * 100.0f); //GPS alt in cm.
+		lt_altitude = (int32_t)roundf(pdata->Altitude * 100.0f); //GPS alt in cm.
 	
 	uint8_t lt_gpsfix;
-	switch (pdata.Status) {
+	switch (pdata->Status) {
 	case GPSPOSITION_STATUS_NOGPS:
 		lt_gpsfix = 0;
 		break;
@@ -218,7 +232,7 @@ static void send_LTM_Gframe()
 		break;
 	}
 	
-	uint8_t lt_gpssats = (int8_t)pdata.Satellites;
+	uint8_t lt_gpssats = (int8_t)pdata->Satellites;
 	//pack G frame	
 	uint8_t LTBuff[LTM_GFRAME_SIZE];
 	//G Frame: $T(2 bytes)G(1byte)LAT(cm,4 bytes)LON(cm,4bytes)SPEED(m/s,1bytes)ALT(cm,4bytes)SATS(6bits)FIX(2bits)CRC(xor,1byte)
@@ -250,11 +264,10 @@ static void send_LTM_Gframe()
 static void send_LTM_Aframe() 
 {
 	//prepare data
-	AttitudeActualData adata;
-	AttitudeActualGet(&adata);
-	int16_t lt_pitch   = (int16_t)(roundf(adata.Pitch));	//-180/180°
-	int16_t lt_roll	   = (int16_t)(roundf(adata.Roll));		//-180/180°
-	int16_t lt_heading = (int16_t)(roundf(adata.Yaw));		//-180/180°
+	const AttitudeActualData *adata = ltm.attitude;
+	int16_t lt_pitch   = (int16_t)(roundf(adata->Pitch));	//-180/180°
+	int16_t lt_roll	   = (int16_t)(roundf(adata->Roll));		//-180/180°
+	int16_t lt_heading = (int16_t)(roundf(adata->Yaw));		//-180/180°
 	//pack A frame	
 	uint8_t LTBuff[LTM_AFRAME_SIZE];
 	
@@ -288,29 +301,22 @@ static void send_LTM_Sframe()
 	
 	
 	if (FlightBatteryStateHandle() != NULL) {
-		FlightBatteryStateData sdata;
-		FlightBatteryStateGet(&sdata);
-		lt_vbat = (uint16_t)roundf(sdata.Voltage*1000);	  //Battery voltage in mv
-		lt_amp = (uint16_t)roundf(sdata.ConsumedEnergy);	  //mA consumed
+		lt_vbat = (uint16_t)roundf(ltm.battery->Voltage*1000);	  //Battery voltage in mv
+		lt_amp = (uint16_t)roundf(ltm.battery->ConsumedEnergy);	  //mA consumed
 	}
 	if (ManualControlCommandHandle() != NULL) {
-		ManualControlCommandData mdata;
-		ManualControlCommandGet(&mdata);
-		lt_rssi = (uint8_t)mdata.Rssi;					  //RSSI in %
+		lt_rssi = (uint8_t)ltm.manual->Rssi;					  //RSSI in %
 	}
 	if (AirspeedActualHandle() != NULL) {
-		AirspeedActualData adata;
-		AirspeedActualGet (&adata);
-		lt_airspeed = (uint8_t)roundf(adata.TrueAirspeed);	  //Airspeed in m/s
+		lt_airspeed = (uint8_t)roundf(ltm.airspeed->TrueAirspeed);	  //Airspeed in m/s
 	}
-	FlightStatusData fdata;
-	FlightStatusGet(&fdata);
-	lt_arm = fdata.Armed;									  //Armed status
+	const FlightStatusData *fdata = ltm.status;
+	lt_arm = fdata->Armed;									  //Armed status
 	if (lt_arm == 1)		//arming , we don't use this one
 		lt_arm = 0;		
 	else if (lt_arm == 2)  // armed
 		lt_arm = 1;
-	if (fdata.ControlSource == FLIGHTSTATUS_CONTROLSOURCE_FAILSAFE)
+	if (fdata->ControlSource == FLIGHTSTATUS_CONTROLSOURCE_FAILSAFE)
 		lt_failsafe = 1;
 	else
 		lt_failsafe = 0;
@@ -319,7 +325,7 @@ static void send_LTM_Sframe()
 	// 8: Altitude Hold, 9: Loiter/GPS Hold, 10: Auto/Waypoints, 11: Heading Hold / headFree, 
 	// 12: Circle, 13: RTH, 14: FollowMe, 15: LAND, 16:FlybyWireA, 17: FlybywireB, 18: Cruise, 19: Unknown
 
-	switch (fdata.FlightMode) {
+	switch (fdata->FlightMode) {
 	case FLIGHTSTATUS_FLIGHTMODE_MANUAL:
 		lt_flightmode = 0; break;
 	case FLIGHTSTATUS_FLIGHTMODE_STABILIZED1:
@@ -368,7 +374,7 @@ static void send_LTM_Packet(uint8_t *LTPacket, uint8_t LTPacket_size)
 	}
 	LTPacket[LTPacket_size-1] = LTCrc;
 	if (lighttelemetryPort) {
-		PIOS_COM_SendBuffer(lighttelemetryPort, LTPacket, LTPacket_size);
+		TelemetryBridgeSend(&ltm_bridge, LTPacket, LTPacket_size);
 	}
 }
 
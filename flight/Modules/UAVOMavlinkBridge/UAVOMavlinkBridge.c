@@ -6,7 +6,7 @@
  * @{ 
  *
  * @file       UAVOMavlinkBridge.c
- * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013-2014
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013-2015
  * @brief      Bridges selected UAVObjects to Mavlink
  * @see        The GNU Public License (GPL) Version 3
  *
@@ -30,6 +30,7 @@
 // ****************
 #include "openpilot.h"
 #include "physical_constants.h"
+#include "misc_math.h"
 #include "modulesettings.h"
 #include "flightbatterysettings.h"
 #include "flightbatterystate.h"
@@ -42,6 +43,7 @@
 #include "systemstats.h"
 #include "homelocation.h"
 #include "baroaltitude.h"
+#include "mavlinkbridgestats.h"
 #include "mavlink.h"
 #include "pios_thread.h"
 
@@ -51,7 +53,11 @@
 // Private functions
 
 static void uavoMavlinkBridgeTask(void *parameters);
-static bool stream_trigger(enum MAV_DATA_STREAM stream_num);
+static void send_extended_status(void);
+static void send_rc_channels(void);
+static void send_position(void);
+static void send_extra1(void);
+static void send_extra2(void);
 
 // ****************
 // Private constants
@@ -63,17 +69,53 @@ static bool stream_trigger(enum MAV_DATA_STREAM stream_num);
 #endif
 
 #define TASK_PRIORITY               PIOS_THREAD_PRIO_LOW
-#define TASK_RATE_HZ				10
 
-static const uint8_t mav_rates[] =
-	 { [MAV_DATA_STREAM_RAW_SENSORS]=0x02, //2Hz
-	   [MAV_DATA_STREAM_EXTENDED_STATUS]=0x02, //2Hz
-	   [MAV_DATA_STREAM_RC_CHANNELS]=0x05, //5Hz
-	   [MAV_DATA_STREAM_POSITION]=0x02, //2Hz
-	   [MAV_DATA_STREAM_EXTRA1]=0x0A, //10Hz
-	   [MAV_DATA_STREAM_EXTRA2]=0x02 }; //2Hz
-
-#define MAXSTREAMS sizeof(mav_rates)
+//! Streams are sent at least this often, even if their data did not change
+#define STREAM_KEEPALIVE_MS         1000
+
+//! Interval of the throughput measurement and rate adaptation
+#define STATS_PERIOD_MS             1000
+
+//! Share of the port speed the streams may use, in percent
+#define PORT_LOAD_MAX               80
+
+//! Limits and steps of the rate scaling, in percent of the nominal rates
+#define RATE_SCALE_MIN              25
+#define RATE_SCALE_MAX              100
+#define RATE_SCALE_STEP_UP          10
+
+#define STREAM_BIT(stream) (1 << (stream))
+
+struct mav_stream {
+	enum MAV_DATA_STREAM stream;
+	uint8_t rate;                  //!< nominal rate in Hz
+	void (*send)(void);
+	bool polled;                   //!< sent every period, its objects change faster than that
+	volatile bool changed;         //!< set by source_updated, cleared by the task
+	uint32_t next_due;             //!< system time the stream is sent next
+	uint32_t last_sent;
+};
+
+static struct mav_stream streams[] = {
+	{ MAV_DATA_STREAM_EXTENDED_STATUS, 2, send_extended_status, false },
+	{ MAV_DATA_STREAM_RC_CHANNELS, 5, send_rc_channels, true },
+	{ MAV_DATA_STREAM_POSITION, 2, send_position, false },
+	{ MAV_DATA_STREAM_EXTRA1, 10, send_extra1, true },
+	{ MAV_DATA_STREAM_EXTRA2, 2, send_extra2, true },
+};
+
+#define NUM_STREAMS NELEMENTS(streams)
+
+//! The streams each slow source object goes into, the polled streams don't need theirs
+static const struct {
+	UAVObjHandle (*handle)(void);
+	uint16_t streams;
+} stream_sources[] = {
+	{ FlightBatteryStateHandle, STREAM_BIT(MAV_DATA_STREAM_EXTENDED_STATUS) },
+	{ SystemStatsHandle, STREAM_BIT(MAV_DATA_STREAM_EXTENDED_STATUS) },
+	{ GPSPositionHandle, STREAM_BIT(MAV_DATA_STREAM_POSITION) },
+	{ HomeLocationHandle, STREAM_BIT(MAV_DATA_STREAM_POSITION) },
+};
 
 // ****************
 // Private variables
@@ -84,13 +126,30 @@ static uint32_t mavlink_port;
 
 static bool module_enabled = false;
 
-static uint8_t * stream_ticks;
-
 static mavlink_message_t mavMsg;
 
 static uint8_t * serial_buf;
+static uint16_t serial_buf_len;
+static uint8_t serial_buf_msgs;
+
+static FlightBatterySettingsData batSettings;
+
+//! Bytes per second the port can take, 0 if it is not limited by a baud rate
+static uint32_t port_bytes_per_s;
+
+//! Current rate of the streams, in percent of their nominal rates
+static uint8_t rate_scale = RATE_SCALE_MAX;
+
+static MavlinkBridgeStatsData stats;
+static uint32_t window_bytes;
+static uint32_t window_wanted;
+static uint32_t window_dropped;
 
 static void updateSettings();
+static void source_updated(UAVObjEvent *ev);
+static uint32_t stream_period(const struct mav_stream *stream);
+static void flush_messages(void);
+static void update_stats(void);
 
 /**
  * Initialise the module
@@ -126,10 +185,7 @@ static int32_t uavoMavlinkBridgeInitialize(void) {
 		updateSettings();
 
 		serial_buf = PIOS_malloc(MAVLINK_MAX_PACKET_LEN);
-		stream_ticks = PIOS_malloc(MAXSTREAMS);
-		for (int x = 0; x < MAXSTREAMS; ++x) {
-			stream_ticks[x] = (TASK_RATE_HZ / mav_rates[x]);
-		}
+		MavlinkBridgeStatsInitialize();
 	} else {
 		module_enabled = false;
 	}
@@ -139,342 +195,466 @@ MODULE_INITCALL( uavoMavlinkBridgeInitialize, uavoMavlinkBridgeStart)
 
 /**
  * Main task. It does not return.
+ *
+ * Each wakeup packs the streams that are due into one buffer and sends it
+ * with a single write, then sleeps until the next stream is due. Streams
+ * of attitude and control data read their objects at the stream rate.
+ * The others are skipped while their data did not change, up to
+ * STREAM_KEEPALIVE_MS.
  */
 
 static void uavoMavlinkBridgeTask(void *parameters) {
-	uint16_t msg_length;
-	uint32_t lastSysTime;
-	// Main task loop
-	lastSysTime = PIOS_Thread_Systime();
-
-	FlightBatterySettingsData batSettings = {};
+	uint32_t now = PIOS_Thread_Systime();
+	uint32_t stats_due = now + STATS_PERIOD_MS;
 
 	if (FlightBatterySettingsHandle() != NULL )
 		FlightBatterySettingsGet(&batSettings);
 
-	SystemStatsData systemStats;
+	// Only the streams with new data need to be packed
+	for (int i = 0; i < NELEMENTS(stream_sources); i++) {
+		UAVObjHandle obj = stream_sources[i].handle();
+		if (obj != NULL)
+			UAVObjConnectCallback(obj, source_updated, EV_UPDATED | EV_UNPACKED);
+	}
+
+	for (int i = 0; i < NUM_STREAMS; i++) {
+		streams[i].changed = true;
+		streams[i].next_due = now;
+		streams[i].last_sent = now;
+	}
 
 	while (1) {
-		PIOS_Thread_Sleep_Until(&lastSysTime, 1000 / TASK_RATE_HZ);
+		now = PIOS_Thread_Systime();
 
-		if (stream_trigger(MAV_DATA_STREAM_EXTENDED_STATUS)) {
-			FlightBatteryStateData batState = {};
+		for (int i = 0; i < NUM_STREAMS; i++) {
+			struct mav_stream *stream = &streams[i];
 
-			if (FlightBatteryStateHandle() != NULL )
-				FlightBatteryStateGet(&batState);
+			if ((int32_t)(now - stream->next_due) < 0)
+				continue;
 
-			SystemStatsGet(&systemStats);
+			// catch up without sending a burst after a stall
+			stream->next_due += stream_period(stream);
+			if ((int32_t)(now - stream->next_due) >= 0)
+				stream->next_due = now + stream_period(stream);
 
-			int8_t battery_remaining = 0;
-			if (batSettings.Capacity != 0) {
-				if (batState.ConsumedEnergy < batSettings.Capacity) {
-					battery_remaining = 100 - lroundf(batState.ConsumedEnergy / batSettings.Capacity * 100);
-				}
+			if (!stream->polled && !stream->changed &&
+					(now - stream->last_sent) < STREAM_KEEPALIVE_MS) {
+				stats.SkippedMessages++;
+				continue;
 			}
 
-			uint16_t voltage = 0;
-			if (batSettings.VoltagePin != FLIGHTBATTERYSETTINGS_VOLTAGEPIN_NONE)
-				voltage = lroundf(batState.Voltage * 1000);
-
-			uint16_t current = 0;
-			if (batSettings.CurrentPin != FLIGHTBATTERYSETTINGS_CURRENTPIN_NONE)
-				current = lroundf(batState.Current * 100);
-
-			mavlink_msg_sys_status_pack(0, 200, &mavMsg,
-					// onboard_control_sensors_present Bitmask showing which onboard controllers and sensors are present. Value of 0: not present. Value of 1: present. Indices: 0: 3D gyro, 1: 3D acc, 2: 3D mag, 3: absolute pressure, 4: differential pressure, 5: GPS, 6: optical flow, 7: computer vision position, 8: laser based position, 9: external ground-truth (Vicon or Leica). Controllers: 10: 3D angular rate control 11: attitude stabilization, 12: yaw position, 13: z/altitude control, 14: x/y position control, 15: motor outputs / control
-					0,
-					// onboard_control_sensors_enabled Bitmask showing which onboard controllers and sensors are enabled:  Value of 0: not enabled. Value of 1: enabled. Indices: 0: 3D gyro, 1: 3D acc, 2: 3D mag, 3: absolute pressure, 4: differential pressure, 5: GPS, 6: optical flow, 7: computer vision position, 8: laser based position, 9: external ground-truth (Vicon or Leica). Controllers: 10: 3D angular rate control 11: attitude stabilization, 12: yaw position, 13: z/altitude control, 14: x/y position control, 15: motor outputs / control
-					0,
-					// onboard_control_sensors_health Bitmask showing which onboard controllers and sensors are operational or have an error:  Value of 0: not enabled. Value of 1: enabled. Indices: 0: 3D gyro, 1: 3D acc, 2: 3D mag, 3: absolute pressure, 4: differential pressure, 5: GPS, 6: optical flow, 7: computer vision position, 8: laser based position, 9: external ground-truth (Vicon or Leica). Controllers: 10: 3D angular rate control 11: attitude stabilization, 12: yaw position, 13: z/altitude control, 14: x/y position control, 15: motor outputs / control
-					0,
-					// load Maximum usage in percent of the mainloop time, (0%: 0, 100%: 1000) should be always below 1000
-					(uint16_t)systemStats.CPULoad * 10,
-					// voltage_battery Battery voltage, in millivolts (1 = 1 millivolt)
-					voltage,
-					// current_battery Battery current, in 10*milliamperes (1 = 10 milliampere), -1: autopilot does not measure the current
-					current,
-					// battery_remaining Remaining battery energy: (0%: 0, 100%: 100), -1: autopilot estimate the remaining battery
-					battery_remaining,
-					// drop_rate_comm Communication drops in percent, (0%: 0, 100%: 10'000), (UART, I2C, SPI, CAN), dropped packets on all links (packets that were corrupted on reception on the MAV)
-					0,
-					// errors_comm Communication errors (UART, I2C, SPI, CAN), dropped packets on all links (packets that were corrupted on reception on the MAV)
-					0,
-					// errors_count1 Autopilot-specific errors
-					0,
-					// errors_count2 Autopilot-specific errors
-					0,
-					// errors_count3 Autopilot-specific errors
-					0,
-					// errors_count4 Autopilot-specific errors
-					0);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
-		}
-
-		if (stream_trigger(MAV_DATA_STREAM_RC_CHANNELS)) {
-			ManualControlCommandData manualState;
-			FlightStatusData flightStatus;
-
-			ManualControlCommandGet(&manualState);
-			FlightStatusGet(&flightStatus);
-			SystemStatsGet(&systemStats);
-
-			//TODO connect with RSSI object and pass in last argument
-			mavlink_msg_rc_channels_raw_pack(0, 200, &mavMsg,
-					// time_boot_ms Timestamp (milliseconds since system boot)
-					systemStats.FlightTime,
-					// port Servo output port (set of 8 outputs = 1 port). Most MAVs will just use one, but this allows to encode more than 8 servos.
-					0,
-					// chan1_raw RC channel 1 value, in microseconds
-					manualState.Channel[0],
-					// chan2_raw RC channel 2 value, in microseconds
-					manualState.Channel[1],
-					// chan3_raw RC channel 3 value, in microseconds
-					manualState.Channel[2],
-					// chan4_raw RC channel 4 value, in microseconds
-					manualState.Channel[3],
-					// chan5_raw RC channel 5 value, in microseconds
-					manualState.Channel[4],
-					// chan6_raw RC channel 6 value, in microseconds
-					manualState.Channel[5],
-					// chan7_raw RC channel 7 value, in microseconds
-					manualState.Channel[6],
-					// chan8_raw RC channel 8 value, in microseconds
-					manualState.Channel[7],
-					// rssi Receive signal strength indicator, 0: 0%, 255: 100%
-					manualState.Rssi);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
+			// Cleared before the objects are read, a change while sending marks it again
+			stream->changed = false;
+			stream->last_sent = now;
+			stream->send();
 		}
 
-		if (stream_trigger(MAV_DATA_STREAM_POSITION)) {
-			GPSPositionData gpsPosData = {};
-			HomeLocationData homeLocation = {};
-			SystemStatsGet(&systemStats);
-
-			if (GPSPositionHandle() != NULL )
-				GPSPositionGet(&gpsPosData);
-			if (HomeLocationHandle() != NULL )
-				HomeLocationGet(&homeLocation);
-			SystemStatsGet(&systemStats);
-
-			uint8_t gps_fix_type;
-			switch (gpsPosData.Status)
-			{
-			case GPSPOSITION_STATUS_NOGPS:
-				gps_fix_type = 0;
-				break;
-			case GPSPOSITION_STATUS_NOFIX:
-				gps_fix_type = 1;
-				break;
-			case GPSPOSITION_STATUS_FIX2D:
-				gps_fix_type = 2;
-				break;
-			case GPSPOSITION_STATUS_FIX3D:
-			case GPSPOSITION_STATUS_DIFF3D:
-				gps_fix_type = 3;
-				break;
-			default:
-				gps_fix_type = 0;
-				break;
-			}
+		flush_messages();
 
-			mavlink_msg_gps_raw_int_pack(0, 200, &mavMsg,
-					// time_usec Timestamp (microseconds since UNIX epoch or microseconds since system boot)
-					(uint64_t)systemStats.FlightTime * 1000,
-					// fix_type 0-1: no fix, 2: 2D fix, 3: 3D fix. Some applications will not use the value of this field unless it is at least two, so always correctly fill in the fix.
-					gps_fix_type,
-					// lat Latitude in 1E7 degrees
-					gpsPosData.Latitude,
-					// lon Longitude in 1E7 degrees
-					gpsPosData.Longitude,
-					// alt Altitude in 1E3 meters (millimeters) above MSL
-					gpsPosData.Altitude * 1000,
-					// eph GPS HDOP horizontal dilution of position in cm (m*100). If unknown, set to: 65535
-					gpsPosData.HDOP * 100,
-					// epv GPS VDOP horizontal dilution of position in cm (m*100). If unknown, set to: 65535
-					gpsPosData.VDOP * 100,
-					// vel GPS ground speed (m/s * 100). If unknown, set to: 65535
-					gpsPosData.Groundspeed * 100,
-					// cog Course over ground (NOT heading, but direction of movement) in degrees * 100, 0.0..359.99 degrees. If unknown, set to: 65535
-					gpsPosData.Heading * 100,
-					// satellites_visible Number of satellites visible. If unknown, set to 255
-					gpsPosData.Satellites);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
-
-			mavlink_msg_gps_global_origin_pack(0, 200, &mavMsg,
-					// latitude Latitude (WGS84), expressed as * 1E7
-					homeLocation.Latitude,
-					// longitude Longitude (WGS84), expressed as * 1E7
-					homeLocation.Longitude,
-					// altitude Altitude(WGS84), expressed as * 1000
-					homeLocation.Altitude * 1000);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
-
-			//TODO add waypoint nav stuff
-			//wp_target_bearing
-			//wp_dist = mavlink_msg_nav_controller_output_get_wp_dist(&msg);
-			//alt_error = mavlink_msg_nav_controller_output_get_alt_error(&msg);
-			//aspd_error = mavlink_msg_nav_controller_output_get_aspd_error(&msg);
-			//xtrack_error = mavlink_msg_nav_controller_output_get_xtrack_error(&msg);
-			//mavlink_msg_nav_controller_output_pack
-			//wp_number
-			//mavlink_msg_mission_current_pack
+		if ((int32_t)(now - stats_due) >= 0) {
+			stats_due += STATS_PERIOD_MS;
+			update_stats();
 		}
 
-		if (stream_trigger(MAV_DATA_STREAM_EXTRA1)) {
-			AttitudeActualData attActual;
-			SystemStatsData systemStats;
-
-			AttitudeActualGet(&attActual);
-			SystemStatsGet(&systemStats);
-
-			mavlink_msg_attitude_pack(0, 200, &mavMsg,
-					// time_boot_ms Timestamp (milliseconds since system boot)
-					systemStats.FlightTime,
-					// roll Roll angle (rad)
-					attActual.Roll * DEG2RAD,
-					// pitch Pitch angle (rad)
-					attActual.Pitch * DEG2RAD,
-					// yaw Yaw angle (rad)
-					attActual.Yaw * DEG2RAD,
-					// rollspeed Roll angular speed (rad/s)
-					0,
-					// pitchspeed Pitch angular speed (rad/s)
-					0,
-					// yawspeed Yaw angular speed (rad/s)
-					0);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
+		// sleep until the next stream is due
+		uint32_t next_due = stats_due;
+		for (int i = 0; i < NUM_STREAMS; i++) {
+			if ((int32_t)(streams[i].next_due - next_due) < 0)
+				next_due = streams[i].next_due;
 		}
 
-		if (stream_trigger(MAV_DATA_STREAM_EXTRA2)) {
-			ActuatorDesiredData actDesired;
-			AttitudeActualData attActual;
-			AirspeedActualData airspeedActual = {};
-			GPSPositionData gpsPosData = {};
-			BaroAltitudeData baroAltitude = {};
-			FlightStatusData flightStatus;
-
-			if (AirspeedActualHandle() != NULL )
-				AirspeedActualGet(&airspeedActual);
-			if (GPSPositionHandle() != NULL )
-				GPSPositionGet(&gpsPosData);
-			if (BaroAltitudeHandle() != NULL )
-				BaroAltitudeGet(&baroAltitude);
-			ActuatorDesiredGet(&actDesired);
-			AttitudeActualGet(&attActual);
-			FlightStatusGet(&flightStatus);
-
-			float altitude = 0;
-			if (BaroAltitudeHandle() != NULL)
-				altitude = baroAltitude.Altitude;
-			else if (GPSPositionHandle() != NULL)
-				altitude = gpsPosData.Altitude;
-
-			// round attActual.Yaw to nearest int and transfer from (-180 ... 180) to (0 ... 360)
-			int16_t heading = lroundf(attActual.Yaw);
-			if (heading < 0)
-				heading += 360;
-
-			mavlink_msg_vfr_hud_pack(0, 200, &mavMsg,
-					// airspeed Current airspeed in m/s
-					airspeedActual.TrueAirspeed,
-					// groundspeed Current ground speed in m/s
-					gpsPosData.Groundspeed,
-					// heading Current heading in degrees, in compass units (0..360, 0=north)
-					heading,
-					// throttle Current throttle setting in integer percent, 0 to 100
-					actDesired.Throttle * 100,
-					// alt Current altitude (MSL), in meters
-					altitude,
-					// climb Current climb rate in meters/second
-					0);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
-
-			uint8_t armed_mode = 0;
-			if (flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED)
-				armed_mode |= MAV_MODE_FLAG_SAFETY_ARMED;
-
-			uint8_t custom_mode = CUSTOM_MODE_STAB;
-
-			switch (flightStatus.FlightMode) {
-				case FLIGHTSTATUS_FLIGHTMODE_MANUAL:
-				case FLIGHTSTATUS_FLIGHTMODE_MWRATE:
-				case FLIGHTSTATUS_FLIGHTMODE_VIRTUALBAR:
-				case FLIGHTSTATUS_FLIGHTMODE_HORIZON:
-					/* Kinda a catch all */
-					custom_mode = CUSTOM_MODE_SPORT;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_ACRO:
-				case FLIGHTSTATUS_FLIGHTMODE_AXISLOCK:
-					custom_mode = CUSTOM_MODE_ACRO;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_STABILIZED1:
-				case FLIGHTSTATUS_FLIGHTMODE_STABILIZED2:
-				case FLIGHTSTATUS_FLIGHTMODE_STABILIZED3:
-					/* May want these three to try and
-					 * infer based on roll axis */
-				case FLIGHTSTATUS_FLIGHTMODE_LEVELING:
-					custom_mode = CUSTOM_MODE_STAB;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_AUTOTUNE:
-					custom_mode = CUSTOM_MODE_DRIFT;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_ALTITUDEHOLD:
-					custom_mode = CUSTOM_MODE_ALTH;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_RETURNTOHOME:
-					custom_mode = CUSTOM_MODE_RTL;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_TABLETCONTROL:
-				case FLIGHTSTATUS_FLIGHTMODE_POSITIONHOLD:
-					custom_mode = CUSTOM_MODE_POSH;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_PATHPLANNER:
-					custom_mode = CUSTOM_MODE_AUTO;
-					break;
-			}
+		now = PIOS_Thread_Systime();
+		if ((int32_t)(next_due - now) > 0)
+			PIOS_Thread_Sleep(next_due - now);
+	}
+}
+
+/**
+ * Mark the streams of an updated object as changed. Each stream has its own
+ * flag, so this never races with the task clearing another stream.
+ */
+static void source_updated(UAVObjEvent *ev)
+{
+	for (int i = 0; i < NELEMENTS(stream_sources); i++) {
+		if (stream_sources[i].handle() != ev->obj)
+			continue;
 
-			mavlink_msg_heartbeat_pack(0, 200, &mavMsg,
-					// type Type of the MAV (quadrotor, helicopter, etc., up to 15 types, defined in MAV_TYPE ENUM)
-					MAV_TYPE_GENERIC,
-					// autopilot Autopilot type / class. defined in MAV_AUTOPILOT ENUM
-					MAV_AUTOPILOT_GENERIC,
-					// base_mode System mode bitfield, see MAV_MODE_FLAGS ENUM in mavlink/include/mavlink_types.h
-					armed_mode,
-					// custom_mode A bitfield for use for autopilot-specific flags.
-					custom_mode,
-					// system_status System status flag, see MAV_STATE ENUM
-					0);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
+		for (int j = 0; j < NUM_STREAMS; j++) {
+			if (stream_sources[i].streams & STREAM_BIT(streams[j].stream))
+				streams[j].changed = true;
 		}
 	}
 }
 
-static bool stream_trigger(enum MAV_DATA_STREAM stream_num) {
-	uint8_t rate = (uint8_t) mav_rates[stream_num];
+/**
+ * Get the interval of a stream at the current rate scaling
+ */
+static uint32_t stream_period(const struct mav_stream *stream)
+{
+	return (1000 * 100) / ((uint32_t) stream->rate * rate_scale);
+}
+
+/**
+ * Append a message to the send buffer
+ */
+static void queue_message(mavlink_message_t *msg)
+{
+	if (serial_buf_len + MAVLINK_NUM_NON_PAYLOAD_BYTES + msg->len > MAVLINK_MAX_PACKET_LEN)
+		flush_messages();
+
+	serial_buf_len += mavlink_msg_to_send_buffer(&serial_buf[serial_buf_len], msg);
+	serial_buf_msgs++;
+}
+
+/**
+ * Send the buffered messages
+ * If the port can't take them all they are dropped rather than waited for,
+ * the streams are slowed down instead.
+ */
+static void flush_messages(void)
+{
+	if (serial_buf_len == 0)
+		return;
+
+	window_wanted += serial_buf_len;
+
+	if (PIOS_COM_SendBufferNonBlocking(mavlink_port, serial_buf, serial_buf_len) >= 0) {
+		window_bytes += serial_buf_len;
+	} else {
+		window_dropped += serial_buf_msgs;
+		stats.DroppedMessages += serial_buf_msgs;
+	}
+
+	serial_buf_len = 0;
+	serial_buf_msgs = 0;
+}
+
+/**
+ * Publish the throughput and adapt the stream rates to the port
+ */
+static void update_stats(void)
+{
+	bool overloaded = window_dropped > 0;
+	bool idle = true;
+
+	if (port_bytes_per_s) {
+		uint32_t budget = port_bytes_per_s * PORT_LOAD_MAX / 100 * STATS_PERIOD_MS / 1000;
+		overloaded |= window_wanted > budget;
+		// only speed up if the nominal rates would fit as well
+		idle = (uint64_t) window_wanted * RATE_SCALE_MAX < (uint64_t) budget * rate_scale;
+	}
 
-	if (rate == 0) {
-		return false;
+	if (overloaded) {
+		rate_scale = MAX(rate_scale * 3 / 4, RATE_SCALE_MIN);
+	} else if (idle && rate_scale < RATE_SCALE_MAX) {
+		rate_scale = MIN(rate_scale + RATE_SCALE_STEP_UP, RATE_SCALE_MAX);
 	}
 
-	if (stream_ticks[stream_num] == 0) {
-		// we're triggering now, setup the next trigger point
-		if (rate > TASK_RATE_HZ) {
-			rate = TASK_RATE_HZ;
+	stats.BytesPerSecond = window_bytes * 1000 / STATS_PERIOD_MS;
+	stats.RateScale = rate_scale;
+	MavlinkBridgeStatsSet(&stats);
+
+	window_bytes = 0;
+	window_wanted = 0;
+	window_dropped = 0;
+}
+
+static void send_extended_status(void)
+{
+	SystemStatsData systemStats;
+	FlightBatteryStateData batState = {};
+
+	if (FlightBatteryStateHandle() != NULL )
+		FlightBatteryStateGet(&batState);
+
+	SystemStatsGet(&systemStats);
+
+	int8_t battery_remaining = 0;
+	if (batSettings.Capacity != 0) {
+		if (batState.ConsumedEnergy < batSettings.Capacity) {
+			battery_remaining = 100 - lroundf(batState.ConsumedEnergy / batSettings.Capacity * 100);
 		}
-		stream_ticks[stream_num] = (TASK_RATE_HZ / rate);
-		return true;
 	}
 
-	// count down at 50Hz
-	stream_ticks[stream_num]--;
-	return false;
+	uint16_t voltage = 0;
+	if (batSettings.VoltagePin != FLIGHTBATTERYSETTINGS_VOLTAGEPIN_NONE)
+		voltage = lroundf(batState.Voltage * 1000);
+
+	uint16_t current = 0;
+	if (batSettings.CurrentPin != FLIGHTBATTERYSETTINGS_CURRENTPIN_NONE)
+		current = lroundf(batState.Current * 100);
+
+	mavlink_msg_sys_status_pack(0, 200, &mavMsg,
+			// onboard_control_sensors_present Bitmask showing which onboard controllers and sensors are present. Value of 0: not present. Value of 1: present. Indices: 0: 3D gyro, 1: 3D acc, 2: 3D mag, 3: absolute pressure, 4: differential pressure, 5: GPS, 6: optical flow, 7: computer vision position, 8: laser based position, 9: external ground-truth (Vicon or Leica). Controllers: 10: 3D angular rate control 11: attitude stabilization, 12: yaw position, 13: z/altitude control, 14: x/y position control, 15: motor outputs / control
+			0,
+			// onboard_control_sensors_enabled Bitmask showing which onboard controllers and sensors are enabled:  Value of 0: not enabled. Value of 1: enabled. Indices: 0: 3D gyro, 1: 3D acc, 2: 3D mag, 3: absolute pressure, 4: differential pressure, 5: GPS, 6: optical flow, 7: computer vision position, 8: laser based position, 9: external ground-truth (Vicon or Leica). Controllers: 10: 3D angular rate control 11: attitude stabilization, 12: yaw position, 13: z/altitude control, 14: x/y position control, 15: motor outputs / control
+			0,
+			// onboard_control_sensors_health Bitmask showing which onboard controllers and sensors are operational or have an error:  Value of 0: not enabled. Value of 1: enabled. Indices: 0: 3D gyro, 1: 3D acc, 2: 3D mag, 3: absolute pressure, 4: differential pressure, 5: GPS, 6: optical flow, 7: computer vision position, 8: laser based position, 9: external ground-truth (Vicon or Leica). Controllers: 10: 3D angular rate control 11: attitude stabilization, 12: yaw position, 13: z/altitude control, 14: x/y position control, 15: motor outputs / control
+			0,
+			// load Maximum usage in percent of the mainloop time, (0%: 0, 100%: 1000) should be always below 1000
+			(uint16_t)systemStats.CPULoad * 10,
+			// voltage_battery Battery voltage, in millivolts (1 = 1 millivolt)
+			voltage,
+			// current_battery Battery current, in 10*milliamperes (1 = 10 milliampere), -1: autopilot does not measure the current
+			current,
+			// battery_remaining Remaining battery energy: (0%: 0, 100%: 100), -1: autopilot estimate the remaining battery
+			battery_remaining,
+			// drop_rate_comm Communication drops in percent, (0%: 0, 100%: 10'000), (UART, I2C, SPI, CAN), dropped packets on all links (packets that were corrupted on reception on the MAV)
+			0,
+			// errors_comm Communication errors (UART, I2C, SPI, CAN), dropped packets on all links (packets that were corrupted on reception on the MAV)
+			0,
+			// errors_count1 Autopilot-specific errors
+			0,
+			// errors_count2 Autopilot-specific errors
+			0,
+			// errors_count3 Autopilot-specific errors
+			0,
+			// errors_count4 Autopilot-specific errors
+			0);
+	queue_message(&mavMsg);
+}
+
+static void send_rc_channels(void)
+{
+	SystemStatsData systemStats;
+	ManualControlCommandData manualState;
+	FlightStatusData flightStatus;
+
+	ManualControlCommandGet(&manualState);
+	FlightStatusGet(&flightStatus);
+	SystemStatsGet(&systemStats);
+
+	//TODO connect with RSSI object and pass in last argument
+	mavlink_msg_rc_channels_raw_pack(0, 200, &mavMsg,
+			// time_boot_ms Timestamp (milliseconds since system boot)
+			systemStats.FlightTime,
+			// port Servo output port (set of 8 outputs = 1 port). Most MAVs will just use one, but this allows to encode more than 8 servos.
+			0,
+			// chan1_raw RC channel 1 value, in microseconds
+			manualState.Channel[0],
+			// chan2_raw RC channel 2 value, in microseconds
+			manualState.Channel[1],
+			// chan3_raw RC channel 3 value, in microseconds
+			manualState.Channel[2],
+			// chan4_raw RC channel 4 value, in microseconds
+			manualState.Channel[3],
+			// chan5_raw RC channel 5 value, in microseconds
+			manualState.Channel[4],
+			// chan6_raw RC channel 6 value, in microseconds
+			manualState.Channel[5],
+			// chan7_raw RC channel 7 value, in microseconds
+			manualState.Channel[6],
+			// chan8_raw RC channel 8 value, in microseconds
+			manualState.Channel[7],
+			// rssi Receive signal strength indicator, 0: 0%, 255: 100%
+			manualState.Rssi);
+	queue_message(&mavMsg);
+}
+
+static void send_position(void)
+{
+	SystemStatsData systemStats;
+	GPSPositionData gpsPosData = {};
+	HomeLocationData homeLocation = {};
+	SystemStatsGet(&systemStats);
+
+	if (GPSPositionHandle() != NULL )
+		GPSPositionGet(&gpsPosData);
+	if (HomeLocationHandle() != NULL )
+		HomeLocationGet(&homeLocation);
+	SystemStatsGet(&systemStats);
+
+	uint8_t gps_fix_type;
+	switch (gpsPosData.Status)
+	{
+	case GPSPOSITION_STATUS_NOGPS:
+		gps_fix_type = 0;
+		break;
+	case GPSPOSITION_STATUS_NOFIX:
+		gps_fix_type = 1;
+		break;
+	case GPSPOSITION_STATUS_FIX2D:
+		gps_fix_type = 2;
+		break;
+	case GPSPOSITION_STATUS_FIX3D:
+	case GPSPOSITION_STATUS_DIFF3D:
+		gps_fix_type = 3;
+		break;
+	default:
+		gps_fix_type = 0;
+		break;
+	}
+
+	mavlink_msg_gps_raw_int_pack(0, 200, &mavMsg,
+			// time_usec Timestamp (microseconds since UNIX epoch or microseconds since system boot)
+			(uint64_t)systemStats.FlightTime * 1000,
+			// fix_type 0-1: no fix, 2: 2D fix, 3: 3D fix. Some applications will not use the value of this field unless it is at least two, so always correctly fill in the fix.
+			gps_fix_type,
+			// lat Latitude in 1E7 degrees
+			gpsPosData.Latitude,
+			// lon Longitude in 1E7 degrees
+			gpsPosData.Longitude,
+			// alt Altitude in 1E3 meters (millimeters) above MSL
+			gpsPosData.Altitude * 1000,
+			// eph GPS HDOP horizontal dilution of position in cm (m*100). If unknown, set to: 65535
+			gpsPosData.HDOP * 100,
+			// epv GPS VDOP horizontal dilution of position in cm (m*100). If unknown, set to: 65535
+			gpsPosData.VDOP * 100,
+			// vel GPS ground speed (m/s * 100). If unknown, set to: 65535
+			gpsPosData.Groundspeed * 100,
+			// cog Course over ground (NOT heading, but direction of movement) in degrees * 100, 0.0..359.99 degrees. If unknown, set to: 65535
+			gpsPosData.Heading * 100,
+			// satellites_visible Number of satellites visible. If unknown, set to 255
+			gpsPosData.Satellites);
+	queue_message(&mavMsg);
+
+	mavlink_msg_gps_global_origin_pack(0, 200, &mavMsg,
+			// latitude Latitude (WGS84), expressed as * 1E7
+			homeLocation.Latitude,
+			// longitude Longitude (WGS84), expressed as * 1E7
+			homeLocation.Longitude,
+			// altitude Altitude(WGS84), expressed as * 1000
+			homeLocation.Altitude * 1000);
+	queue_message(&mavMsg);
+
+	//TODO add waypoint nav stuff
+	//wp_target_bearing
+	//wp_dist = mavlink_msg_nav_controller_output_get_wp_dist(&msg);
+	//alt_error = mavlink_msg_nav_controller_output_get_alt_error(&msg);
+	//aspd_error = mavlink_msg_nav_controller_output_get_aspd_error(&msg);
+	//xtrack_error = mavlink_msg_nav_controller_output_get_xtrack_error(&msg);
+	//mavlink_msg_nav_controller_output_pack
+	//wp_number
+	//mavlink_msg_mission_current_pack
+}
+
+static void send_extra1(void)
+{
+	AttitudeActualData attActual;
+	SystemStatsData systemStats;
+
+	AttitudeActualGet(&attActual);
+	SystemStatsGet(&systemStats);
+
+	mavlink_msg_attitude_pack(0, 200, &mavMsg,
+			// time_boot_ms Timestamp (milliseconds since system boot)
+			systemStats.FlightTime,
+			// roll Roll angle (rad)
+			attActual.Roll * DEG2RAD,
+			// pitch Pitch angle (rad)
+			attActual.Pitch * DEG2RAD,
+			// yaw Yaw angle (rad)
+			attActual.Yaw * DEG2RAD,
+			// rollspeed Roll angular speed (rad/s)
+			0,
+			// pitchspeed Pitch angular speed (rad/s)
+			0,
+			// yawspeed Yaw angular speed (rad/s)
+			0);
+	queue_message(&mavMsg);
+}
+
+static void send_extra2(void)
+{
+	ActuatorDesiredData actDesired;
+	AttitudeActualData attActual;
+	AirspeedActualData airspeedActual = {};
+	GPSPositionData gpsPosData = {};
+	BaroAltitudeData baroAltitude = {};
+	FlightStatusData flightStatus;
+
+	if (AirspeedActualHandle() != NULL )
+		AirspeedActualGet(&airspeedActual);
+	if (GPSPositionHandle() != NULL )
+		GPSPositionGet(&gpsPosData);
+	if (BaroAltitudeHandle() != NULL )
+		BaroAltitudeGet(&baroAltitude);
+	ActuatorDesiredGet(&actDesired);
+	AttitudeActualGet(&attActual);
+	FlightStatusGet(&flightStatus);
+
+	float altitude = 0;
+	if (BaroAltitudeHandle() != NULL)
+		altitude = baroAltitude.Altitude;
+	else if (GPSPositionHandle() != NULL)
+		altitude = gpsPosData.Altitude;
+
+	// round attActual.Yaw to nearest int and transfer from (-180 ... 180) to (0 ... 360)
+	int16_t heading = lroundf(attActual.Yaw);
+	if (heading < 0)
+		heading += 360;
+
+	mavlink_msg_vfr_hud_pack(0, 200, &mavMsg,
+			// airspeed Current airspeed in m/s
+			airspeedActual.TrueAirspeed,
+			// groundspeed Current ground speed in m/s
+			gpsPosData.Groundspeed,
+			// heading Current heading in degrees, in compass units (0..360, 0=north)
+			heading,
+			// throttle Current throttle setting in integer percent, 0 to 100
+			actDesired.Throttle * 100,
+			// alt Current altitude (MSL), in meters
+			altitude,
+			// climb Current climb rate in meters/second
+			0);
+	queue_message(&mavMsg);
+
+	uint8_t armed_mode = 0;
+	if (flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED)
+		armed_mode |= MAV_MODE_FLAG_SAFETY_ARMED;
+
+	uint8_t custom_mode = CUSTOM_MODE_STAB;
+
+	switch (flightStatus.FlightMode) {
+		case FLIGHTSTATUS_FLIGHTMODE_MANUAL:
+		case FLIGHTSTATUS_FLIGHTMODE_MWRATE:
+		case FLIGHTSTATUS_FLIGHTMODE_VIRTUALBAR:
+		case FLIGHTSTATUS_FLIGHTMODE_HORIZON:
+			/* Kinda a catch all */
+			custom_mode = CUSTOM_MODE_SPORT;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_ACRO:
+		case FLIGHTSTATUS_FLIGHTMODE_AXISLOCK:
+			custom_mode = CUSTOM_MODE_ACRO;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_STABILIZED1:
+		case FLIGHTSTATUS_FLIGHTMODE_STABILIZED2:
+		case FLIGHTSTATUS_FLIGHTMODE_STABILIZED3:
+			/* May want these three to try and
+			 * infer based on roll axis */
+		case FLIGHTSTATUS_FLIGHTMODE_LEVELING:
+			custom_mode = CUSTOM_MODE_STAB;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_AUTOTUNE:
+			custom_mode = CUSTOM_MODE_DRIFT;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_ALTITUDEHOLD:
+			custom_mode = CUSTOM_MODE_ALTH;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_RETURNTOHOME:
+			custom_mode = CUSTOM_MODE_RTL;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_TABLETCONTROL:
+		case FLIGHTSTATUS_FLIGHTMODE_POSITIONHOLD:
+			custom_mode = CUSTOM_MODE_POSH;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_PATHPLANNER:
+			custom_mode = CUSTOM_MODE_AUTO;
+			break;
+	}
+
+	mavlink_msg_heartbeat_pack(0, 200, &mavMsg,
+			// type Type of the MAV (quadrotor, helicopter, etc., up to 15 types, defined in MAV_TYPE ENUM)
+			MAV_TYPE_GENERIC,
+			// autopilot Autopilot type / class. defined in MAV_AUTOPILOT ENUM
+			MAV_AUTOPILOT_GENERIC,
+			// base_mode System mode bitfield, see MAV_MODE_FLAGS ENUM in mavlink/include/mavlink_types.h
+			armed_mode,
+			// custom_mode A bitfield for use for autopilot-specific flags.
+			custom_mode,
+			// system_status System status flag, see MAV_STATE ENUM
+			0);
+	queue_message(&mavMsg);
 }
 
 static void updateSettings()
@@ -485,30 +665,39 @@ static void updateSettings()
 		uint8_t speed;
 		ModuleSettingsMavlinkSpeedGet(&speed);
 
+		uint32_t baud = 0;
+
 		// Set port speed
 		switch (speed) {
 		case MODULESETTINGS_MAVLINKSPEED_2400:
-			PIOS_COM_ChangeBaud(mavlink_port, 2400);
+			baud = 2400;
 			break;
 		case MODULESETTINGS_MAVLINKSPEED_4800:
-			PIOS_COM_ChangeBaud(mavlink_port, 4800);
+			baud = 4800;
 			break;
 		case MODULESETTINGS_MAVLINKSPEED_9600:
-			PIOS_COM_ChangeBaud(mavlink_port, 9600);
+			baud = 9600;
 			break;
 		case MODULESETTINGS_MAVLINKSPEED_19200:
-			PIOS_COM_ChangeBaud(mavlink_port, 19200);
+			baud = 19200;
 			break;
 		case MODULESETTINGS_MAVLINKSPEED_38400:
-			PIOS_COM_ChangeBaud(mavlink_port, 38400);
+			baud = 38400;
 			break;
 		case MODULESETTINGS_MAVLINKSPEED_57600:
-			PIOS_COM_ChangeBaud(mavlink_port, 57600);
+			baud = 57600;
 			break;
 		case MODULESETTINGS_MAVLINKSPEED_115200:
-			PIOS_COM_ChangeBaud(mavlink_port, 115200);
+			baud = 115200;
 			break;
 		}
+
+		if (baud) {
+			PIOS_COM_ChangeBaud(mavlink_port, baud);
+		}
+
+		// 8N1 framing takes ten bits per byte
+		port_bytes_per_s = baud / 10;
 	}
 }
 /**
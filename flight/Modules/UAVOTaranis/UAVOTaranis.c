@@ -39,7 +39,7 @@
  */
 
 #include "frsky_packing.h"
-#include "pios_thread.h"
+#include "telemetry_bridge.h"
 
 #include "openpilot.h"
 #include "physical_constants.h"
@@ -57,7 +57,7 @@
 
 #if defined(PIOS_INCLUDE_TARANIS_SPORT)
 
-static void uavoTaranisTask(void *parameters);
+static uint32_t uavoTaranisRun(struct telemetry_bridge *bridge, uint32_t now);
 
 static bool frsky_encode_rssi(struct frsky_settings *frsky, uint32_t *value, bool test_presence_only, uint32_t arg);
 static bool frsky_encode_swr(struct frsky_settings *frsky, uint32_t *value, bool test_presence_only, uint32_t arg);
@@ -96,21 +96,16 @@ struct frsky_sport_telemetry {
 	int32_t scheduled_item;
 	uint32_t last_poll_time;
 	uint8_t ignore_rx_chars;
-	uintptr_t com;
+	struct telemetry_bridge bridge;
 	struct frsky_settings frsky_settings;
 	uint32_t item_last_triggered[NELEMENTS(frsky_value_items)];
 };
 
 #define FRSKY_SPORT_BAUDRATE                    57600
 
-#if defined(PIOS_FRSKY_SPORT_TELEMETRY_STACK_SIZE)
-#define STACK_SIZE_BYTES PIOS_FRSKY_SPORT_TELEMETRY_STACK_SIZE
-#else
-#define STACK_SIZE_BYTES 672
-#endif
-#define TASK_PRIORITY               PIOS_THREAD_PRIO_LOW
+//! Time between two items sent
+#define TARANIS_ITEM_PERIOD_MS                  5
 
-static struct pios_thread *uavoTaranisTaskHandle;
 static bool module_enabled;
 static struct frsky_sport_telemetry *frsky;
 
@@ -165,28 +160,7 @@ static bool frsky_encode_battery(struct frsky_settings *frsky, uint32_t *value,
 
 
 /**
- * Scan for value item with the longest expired time and schedule it to send in next poll turn
- *
- */
-static void frsky_schedule_next_item(void)
-{
-	uint32_t i = 0;
-	int32_t max_exp_time = INT32_MIN;
-	int32_t most_exp_item = -1;
-	for (i = 0; i < NELEMENTS(frsky_value_items); i++) {
-		if (frsky_value_items[i].encode_value(&frsky->frsky_settings, 0, true, frsky_value_items[i].fn_arg)) {
-			int32_t exp_time = PIOS_DELAY_GetuSSince(frsky->item_last_triggered[i]) -
-					(frsky_value_items[i].period_ms * 1000);
-			if (exp_time > max_exp_time) {
-				max_exp_time = exp_time;
-				most_exp_item = i;
-			}
-		}
-	}
-	frsky->scheduled_item = most_exp_item;
-}
-/**
- * Send value item previously scheduled by frsky_schedule_next_itme()
+ * Send value item previously scheduled
  * @returns true when item value was sended
  */
 static bool frsky_send_scheduled_item(void)
@@ -197,7 +171,7 @@ static bool frsky_send_scheduled_item(void)
 		uint32_t value = 0;
 		if (frsky_value_items[item].encode_value(&frsky->frsky_settings, &value, false,
 				frsky_value_items[item].fn_arg)) {
-			frsky_send_frame(frsky->com, (uint16_t)(frsky_value_items[item].id), value);
+			frsky_send_frame(&frsky->bridge, (uint16_t)(frsky_value_items[item].id), value);
 			return true;
 		}
 	}
@@ -212,15 +186,9 @@ static bool frsky_send_scheduled_item(void)
  */
 static int32_t uavoTaranisStart(void)
 {
-	if (module_enabled) {
-		// Start tasks
-		uavoTaranisTaskHandle = PIOS_Thread_Create(
-				uavoTaranisTask, "uavoFrSKYSensorHubBridge",
-				STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
-		TaskMonitorAdd(TASKINFO_RUNNING_UAVOFRSKYSBRIDGE,
-				uavoTaranisTaskHandle);
-		return 0;
-	}
+	if (module_enabled)
+		return TelemetryBridgeStart();
+
 	return -1;
 }
 
@@ -254,19 +222,19 @@ static int32_t uavoTaranisInitialize(void)
 			frsky->last_poll_time = PIOS_DELAY_GetuS();
 			frsky->ignore_rx_chars = 0;
 			frsky->scheduled_item = -1;
-			frsky->com = sport_com;
+			frsky->bridge.com = sport_com;
+			frsky->bridge.stats_idx = BRIDGESTATS_CPUTIME_TARANIS;
+			frsky->bridge.run = uavoTaranisRun;
 
 			uint8_t i;
 			for (i = 0; i < NELEMENTS(frsky_value_items); i++)
 				frsky->item_last_triggered[i] = PIOS_DELAY_GetuS();
-			PIOS_COM_ChangeBaud(frsky->com, FRSKY_SPORT_BAUDRATE);
-			module_enabled = true;
-			return 0;
+			PIOS_COM_ChangeBaud(sport_com, FRSKY_SPORT_BAUDRATE);
+			if (TelemetryBridgeRegister(&frsky->bridge) == 0) {
+				module_enabled = true;
+				return 0;
+			}
 		}
-
-		module_enabled = true;
-
-		return 0;
 	}
 
 	module_enabled = false;
@@ -276,33 +244,18 @@ static int32_t uavoTaranisInitialize(void)
 MODULE_INITCALL(uavoTaranisInitialize, uavoTaranisStart)
 
 /**
- * Main task. It does not return.
+ * Send the next item
+ *
+ * The items are sent in turn. When they were scheduled by their age
+ * only the first four were ever sent.
+ * @return ms until the next item
  */
-static void uavoTaranisTask(void *parameters)
+static uint32_t uavoTaranisRun(struct telemetry_bridge *bridge, uint32_t now)
 {
-	while(1) {
-
-		if (true) {
+	frsky->scheduled_item = (frsky->scheduled_item + 1) % NELEMENTS(frsky_value_items);
+	frsky_send_scheduled_item();
 
-			// for some reason, only first four messages are sent.
-			for (uint32_t i = 0; i < sizeof(frsky_value_items) / sizeof(frsky_value_items[0]); i++) {
-				frsky->scheduled_item = i;
-				frsky_send_scheduled_item();
-				PIOS_Thread_Sleep(5);
-			}
-
-		}
-
-		if (false) { 
-
-			// fancier schedlued message sending. doesn't appear to work
-			// currently.
-			PIOS_Thread_Sleep(1);
-			frsky_schedule_next_item();
-			frsky_send_scheduled_item();
-		}
-
-	}
+	return TARANIS_ITEM_PERIOD_MS;
 }
 
 #endif /* PIOS_INCLUDE_TARANIS_SPORT */
@@ -0,0 +1,70 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup VibrationAnalysisModule Vibration analysis module
+ * @{
+ *
+ * @file       vibration_overruns.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @brief      Count the accel samples lost to a full event queue
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef VIBRATION_OVERRUNS_H
+#define VIBRATION_OVERRUNS_H
+
+#include <stdint.h>
+
+/**
+ * Get the event queue errors since the last check
+ *
+ * The System module clears the object manager statistics every second.
+ * A count lower than the last one means it was cleared in between, and
+ * all of the errors counted since are new.
+ *
+ * @param[in] errors the eventQueueErrors now
+ * @param[in,out] last_errors the eventQueueErrors at the last check
+ * @return the number of new errors
+ */
+static inline uint32_t vibration_new_queue_errors(uint32_t errors, uint32_t *last_errors)
+{
+	uint32_t new_errors = (errors >= *last_errors) ? errors - *last_errors : errors;
+
+	*last_errors = errors;
+	return new_errors;
+}
+
+/**
+ * Add lost samples to the overrun count, which saturates
+ */
+static inline uint16_t vibration_add_overruns(uint16_t overruns, uint32_t lost)
+{
+	uint32_t sum = (uint32_t) overruns + lost;
+
+	return (sum < lost || sum > UINT16_MAX) ? UINT16_MAX : sum;
+}
+
+#endif /* VIBRATION_OVERRUNS_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -6,7 +6,7 @@
  * @{
  *
  * @file       vibrationanalysis.c
- * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013-2014
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013-2015
  * @brief      Performs an FFT on the accels to estimation vibration
  *
  * @see        The GNU Public License (GPL) Version 3
@@ -30,40 +30,44 @@
 
 /**
  * Input objects: @ref Accels, @ref VibrationAnalysisSettings
- * Output object: @ref VibrationAnalysisOutput
+ * Output object: @ref VibrationAnalysisSpectrum
  *
- * This module executes on a timer trigger. When the module is
- * triggered it will update the data of VibrationAnalysiOutput, based on
- * the output of an FFT running on the accelerometer samples. 
+ * While the analysis is on, the task listens to every Accels update on its
+ * own queue, so it sees the full IMU rate. Each time half a window of new
+ * samples is available it computes a Hann windowed real FFT of the last
+ * window on each axis (Welch's method with 50% overlap). The band powers of
+ * several transforms are averaged and published as one packed spectrum.
  */
 
 #include "openpilot.h"
 #include "physical_constants.h"
-#include "arm_math.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
+#include "rfft.h"
+#include "vibration_overruns.h"
 
 #include "accels.h"
 #include "modulesettings.h"
-#include "vibrationanalysisoutput.h"
+#include "vibrationanalysisspectrum.h"
 #include "vibrationanalysissettings.h"
 
 
 // Private constants
 
-#define MAX_QUEUE_SIZE 2
-#define STACK_SIZE_BYTES (200 + 484 + (13*fft_window_size)*0) // The fft memory requirement grows linearly 
-																				  // with window size. The constant is multiplied
-																				  // by 0 in order to reflect the fact that the
-																				  // malloc'ed memory is not taken from the module 
-																				  // but instead from the heap. Nonetheless, we 
-																				  // can know a priori how much RAM this module 
-																				  // will take.
+#define STACK_SIZE_BYTES 800 // The buffers are allocated from the heap when the module starts
 #define TASK_PRIORITY PIOS_THREAD_PRIO_LOW
 #define SETTINGS_THROTTLING_MS 100
 
-#define MAX_ACCEL_RANGE 16                          // Maximum accelerometer resolution in [g]
-#define FLOAT_TO_Q15 (32768/(MAX_ACCEL_RANGE*GRAVITY)) // This is the scaling constant that scales all input floats to +-
+#define MAX_QUEUE_SIZE 32 // Accels updates that can arrive while a window is transformed
+#define NUM_BANDS VIBRATIONANALYSISSPECTRUM_X_NUMELEM
+
+// Private types
+
+struct accel_sample {
+	float x;
+	float y;
+	float z;
+};
 
 // Private variables
 static struct pios_thread *taskHandle;
@@ -71,59 +75,66 @@ static struct pios_queue *queue;
 static bool module_enabled = false;
 
 static struct VibrationAnalysis_data {
-	uint16_t accels_sum_count;
 	uint16_t fft_window_size;
-	uint8_t num_upscale_bits;
-
-	float accels_data_sum_x;
-	float accels_data_sum_y;
-	float accels_data_sum_z;
-	
-	float accels_static_bias_x; // In all likelyhood, the initial values will be close to 
-	float accels_static_bias_y; // (0,0,-g). In the case where they are not, this will still  
-	float accels_static_bias_z; // converge to the true bias in a few thousand measurements.	
-	
-	int16_t *accel_buffer_complex_x_q15;
-	int16_t *accel_buffer_complex_y_q15;
-	int16_t *accel_buffer_complex_z_q15;
-	
-	int16_t *fft_output;
+	uint16_t num_bands;
+	uint16_t bins_per_band;
+	float power_scale;		// Turns |X[k]|^2 into one sided power in (m/s^2)^2
+
+	struct rfft_plan plan;
+	float *window;
+	float *work;
+
+	// Last fft_window_size samples of each axis, written circularly
+	float *history[3];
+	uint16_t history_pos;
+	uint16_t history_fill;
+	uint16_t new_samples;
+
+	// Averaged band powers
+	float band_power[3][NUM_BANDS];
+	uint8_t num_averaged;
+	uint32_t samples_averaged;
+	uint32_t average_start_time;
+
+	uint16_t overruns;
+	uint32_t queue_errors;		// Event queue errors counted by the object manager at the last check
+	bool running;
 } *vtd;
 
 
 // Private functions
 static void VibrationAnalysisTask(void *parameters);
+static void reset_analysis(void);
+static void count_overruns(void);
+static void add_sample(const struct accel_sample *sample);
+static void transform_window(void);
+static void publish_spectrum(void);
 
 /**
  * Start the module, called on startup
  */
 static int32_t VibrationAnalysisStart(void)
 {
-	
+
 	if (!module_enabled)
 		return -1;
 
 	//Get the FFT window size
 	uint16_t fft_window_size; // Make a local copy in order to check settings before allocating memory
-	uint8_t num_upscale_bits;
 	VibrationAnalysisSettingsFFTWindowSizeOptions fft_window_size_enum;
 	VibrationAnalysisSettingsFFTWindowSizeGet(&fft_window_size_enum);
 	switch (fft_window_size_enum) {
 		case VIBRATIONANALYSISSETTINGS_FFTWINDOWSIZE_16:
 			fft_window_size = 16;
-			num_upscale_bits = 4;
 			break;
 		case VIBRATIONANALYSISSETTINGS_FFTWINDOWSIZE_64:
 			fft_window_size = 64;
-			num_upscale_bits = 6;
 			break;
 		case VIBRATIONANALYSISSETTINGS_FFTWINDOWSIZE_256:
 			fft_window_size = 256;
-			num_upscale_bits = 8;
 			break;
 		case VIBRATIONANALYSISSETTINGS_FFTWINDOWSIZE_1024:
 			fft_window_size = 1024;
-			num_upscale_bits = 10;
 			break;
 		default:
 			//This represents a serious configuration error. Do not start module.
@@ -131,68 +142,49 @@ static int32_t VibrationAnalysisStart(void)
 			return -1;
 			break;
 	}
-	
-
-	// Create instances for vibration analysis. Start from i=1 because the first instance is generated
-	// by VibrationAnalysisOutputInitialize(). Generate three times the length because there are three
-	// vectors. Generate half the length because the FFT output is symmetric about the mid-frequency, 
-	// so there's no point in using memory additional memory.
-	for (int i=1; i < (fft_window_size>>1); i++) {
-		uint16_t ret = VibrationAnalysisOutputCreateInstance();
-		if (ret == 0) {
-			// This fails when it's a metaobject. Not a very helpful test.
-			module_enabled = false;
-			return -1;
-		}
-	}
-	
-	if (VibrationAnalysisOutputGetNumInstances() != (fft_window_size>>1)){
-		// This is a more useful test for failure.
-		module_enabled = false;
-		return -1;
-	}
-	
-	
+
 	// Allocate and initialize the static data storage only if module is enabled
 	vtd = (struct VibrationAnalysis_data *) PIOS_malloc(sizeof(struct VibrationAnalysis_data));
 	if (vtd == NULL) {
 		module_enabled = false;
 		return -1;
 	}
-	
-	// make sure that all struct values are zeroed...
+
+	// make sure that all struct values are zeroed
 	memset(vtd, 0, sizeof(struct VibrationAnalysis_data));
-	//... except for Z axis static bias
-	vtd->accels_static_bias_z=-GRAVITY; // [See note in definition of VibrationAnalysis_data structure]
 
-	// Now place the fft window size and number of upscale bits variables into the buffer
 	vtd->fft_window_size = fft_window_size;
-	vtd->num_upscale_bits = num_upscale_bits;
-	
-	// Allocate ouput vector
-	vtd->fft_output = (int16_t *) PIOS_malloc(fft_window_size*2*sizeof(typeof(*(vtd->fft_output))));
-	if (vtd->fft_output == NULL) {
-		module_enabled = false; //Check if allocation succeeded
-		return -1;
-	}
-	
-	//Create the buffers. They are in Q15 format.
-	vtd->accel_buffer_complex_x_q15 = (int16_t *) PIOS_malloc(fft_window_size*2*sizeof(typeof(*vtd->accel_buffer_complex_x_q15)));
-	if (vtd->accel_buffer_complex_x_q15 == NULL) {
-		module_enabled = false; //Check if allocation succeeded
-		return -1;
-	}
-	vtd->accel_buffer_complex_y_q15 = (int16_t *) PIOS_malloc(fft_window_size*2*sizeof(typeof(*vtd->accel_buffer_complex_y_q15)));
-	if (vtd->accel_buffer_complex_y_q15 == NULL) {
+
+	// The n/2 bins are grouped into at most NUM_BANDS bands
+	vtd->num_bands = (fft_window_size >> 1) < NUM_BANDS ? (fft_window_size >> 1) : NUM_BANDS;
+	vtd->bins_per_band = (fft_window_size >> 1) / vtd->num_bands;
+
+	// Allocate the twiddles, the window, the work buffer and the history of each
+	// axis in one block. At 1024 points this is 24kB.
+	float *buffers = (float *) PIOS_malloc(6 * fft_window_size * sizeof(float));
+	if (buffers == NULL) {
+		PIOS_free(vtd);
+		vtd = NULL;
 		module_enabled = false; //Check if allocation succeeded
 		return -1;
 	}
-	vtd->accel_buffer_complex_z_q15 = (int16_t *) PIOS_malloc(fft_window_size*2*sizeof(typeof(*vtd->accel_buffer_complex_z_q15)));
-	if (vtd->accel_buffer_complex_z_q15 == NULL) {
-		module_enabled = false; //Check if allocation succeeded
+
+	vtd->window = &buffers[fft_window_size];
+	vtd->work = &buffers[2 * fft_window_size];
+	for (int i = 0; i < 3; i++)
+		vtd->history[i] = &buffers[(3 + i) * fft_window_size];
+
+	if (!rfft_init(&vtd->plan, fft_window_size, buffers)) {
+		PIOS_free(buffers);
+		PIOS_free(vtd);
+		vtd = NULL;
+		module_enabled = false;
 		return -1;
 	}
-	
+
+	float window_sum_sq = rfft_hann_window(vtd->window, fft_window_size);
+	vtd->power_scale = 2.0f / (fft_window_size * window_sum_sq);
+
 	// Start main task
 	taskHandle = PIOS_Thread_Create(VibrationAnalysisTask, "VibrationAnalysis", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
 	TaskMonitorAdd(TASKINFO_RUNNING_VIBRATIONANALYSIS, taskHandle);
@@ -206,7 +198,7 @@ static int32_t VibrationAnalysisStart(void)
 static int32_t VibrationAnalysisInitialize(void)
 {
 	ModuleSettingsInitialize();
-	
+
 #ifdef MODULE_VibrationAnalysis_BUILTIN
 	module_enabled = true;
 #else
@@ -218,61 +210,36 @@ static int32_t VibrationAnalysisInitialize(void)
 		module_enabled = false;
 	}
 #endif
-	
+
 	if (!module_enabled) //If module not enabled...
 		return -1;
 
 	// Initialize UAVOs
 	VibrationAnalysisSettingsInitialize();
-	VibrationAnalysisOutputInitialize();
-		
-	// Create object queue
+	VibrationAnalysisSpectrumInitialize();
+
+	// Create object queue, it is only connected to Accels while the analysis is on
 	queue = PIOS_Queue_Create(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
-		
+	if (queue == NULL) {
+		module_enabled = false;
+		return -1;
+	}
+
 	return 0;
-	
+
 }
 MODULE_INITCALL(VibrationAnalysisInitialize, VibrationAnalysisStart)
 
 
 static void VibrationAnalysisTask(void *parameters)
 {
-#define MAX_BLOCKSIZE   2048
-	
-	uint32_t lastSysTime;
 	uint32_t lastSettingsUpdateTime;
 	uint8_t runAnalysisFlag = VIBRATIONANALYSISSETTINGS_TESTINGSTATUS_OFF; // By default, turn analysis off
-	uint16_t sampleRate_ms = 100; // Default sample rate of 100ms
-	uint8_t sample_count;
+	uint8_t averages = 1;
 	UAVObjEvent ev;
-	
-	// Listen for updates.
-	AccelsConnectQueue(queue);
-	
-	// Declare FFT structure and status variable
-	arm_cfft_radix4_instance_q15 cfft_instance;
-	arm_status status;
-	
-	// Initialize the CFFT/CIFFT module
-	status = ARM_MATH_SUCCESS;
-	bool ifftFlag = false;
-	bool doBitReverse = 1;
-	status = arm_cfft_radix4_init_q15(&cfft_instance, vtd->fft_window_size, ifftFlag, doBitReverse);
-	
-	
-/** These values are useful for insight into the Fourier transform performed by this module.
-	float freq_sample = 1.0f/sampleRate_ms;
-	float freq_nyquist = f_s/2.0f;
-	uint16_t num_samples = vtd->fft_window_size;
- */
 
-	// Main task loop
-	VibrationAnalysisOutputData vibrationAnalysisOutputData;
-	sample_count = 0;
-	lastSysTime = PIOS_Thread_Systime();
 	lastSettingsUpdateTime = PIOS_Thread_Systime() - SETTINGS_THROTTLING_MS;
 
-	
 	// Main module task, never exit from while loop
 	while(1)
 	{
@@ -280,146 +247,195 @@ static void VibrationAnalysisTask(void *parameters)
 		if(PIOS_Thread_Systime() - lastSettingsUpdateTime > SETTINGS_THROTTLING_MS) {
 			//First check if the analysis is active
 			VibrationAnalysisSettingsTestingStatusGet(&runAnalysisFlag);
-			
-			// Get sample rate
-			VibrationAnalysisSettingsSampleRateGet(&sampleRate_ms);
-			sampleRate_ms = sampleRate_ms > 0 ? sampleRate_ms : 1; //Ensure sampleRate never is 0.
-			
+
+			// Get the number of transforms in each average
+			VibrationAnalysisSettingsAveragesGet(&averages);
+			averages = averages > 0 ? averages : 1; // Ensure there is at least one
+
 			lastSettingsUpdateTime = PIOS_Thread_Systime();
 		}
-		
-		// If analysis is turned off, delay and then loop.
+
+		// If analysis is turned off, stop listening to Accels, delay and then loop.
 		if (runAnalysisFlag == VIBRATIONANALYSISSETTINGS_TESTINGSTATUS_OFF) {
+			if (vtd->running) {
+				vtd->running = false;
+				UAVObjDisconnectQueue(AccelsHandle(), queue);
+				while (PIOS_Queue_Receive(queue, &ev, 0) == true)
+					;
+			}
 			PIOS_Thread_Sleep(200);
 			continue;
 		}
-		
-		// Wait until the Accels object is updated, and never time out
-		if (PIOS_Queue_Receive(queue, &ev, PIOS_QUEUE_TIMEOUT_MAX) == true)
-		{
-			/**
-			 * Accumulate accelerometer data. This would be a great place to add a 
-			 * high-pass filter, in order to eliminate the DC bias from gravity.
-			 * Until then, a DC bias subtraction has been added in the main loop.
-			 */
-			
-			AccelsData accels_data;
-			AccelsGet(&accels_data);
-			
-			vtd->accels_data_sum_x += accels_data.x;
-			vtd->accels_data_sum_y += accels_data.y;
-			vtd->accels_data_sum_z += accels_data.z;
-			
-			vtd->accels_sum_count++;
+
+		if (!vtd->running) {
+			reset_analysis();
+			AccelsConnectQueue(queue);
+			vtd->running = true;
 		}
-		
-		// If not enough time has passed, keep accumulating data
-		if(PIOS_Thread_Systime() - lastSysTime < sampleRate_ms) {
+
+		// Wait until the Accels object is updated, time out to check the settings
+		if (PIOS_Queue_Receive(queue, &ev, SETTINGS_THROTTLING_MS) != true)
 			continue;
+
+		AccelsData accels;
+		AccelsGet(&accels);
+
+		struct accel_sample sample = {
+			.x = accels.x,
+			.y = accels.y,
+			.z = accels.z,
+		};
+		add_sample(&sample);
+
+		// Half overlapping windows, so transform every half window
+		if (vtd->history_fill >= vtd->fft_window_size &&
+		    vtd->new_samples >= (vtd->fft_window_size >> 1)) {
+			transform_window();
+			count_overruns();
+
+			if (vtd->num_averaged >= averages)
+				publish_spectrum();
 		}
-		
-		lastSysTime += sampleRate_ms;
-		
-		
-		//Calculate averaged values
-		float accels_avg_x = vtd->accels_data_sum_x / vtd->accels_sum_count;
-		float accels_avg_y = vtd->accels_data_sum_y / vtd->accels_sum_count;
-		float accels_avg_z = vtd->accels_data_sum_z / vtd->accels_sum_count;
-		
-		//Calculate DC bias
-		float alpha=.005; //Hard-coded to drift very slowly
-		vtd->accels_static_bias_x = alpha*accels_avg_x + (1-alpha)*vtd->accels_static_bias_x;
-		vtd->accels_static_bias_y = alpha*accels_avg_y + (1-alpha)*vtd->accels_static_bias_y;
-		vtd->accels_static_bias_z = alpha*accels_avg_z + (1-alpha)*vtd->accels_static_bias_z;
-		
-		// Add averaged values to the buffer, and remove DC bias. Only add real component, the
-		// complex component was already set to zero by a memset operation
-		vtd->accel_buffer_complex_x_q15[sample_count*2] = (accels_avg_x - vtd->accels_static_bias_x)*FLOAT_TO_Q15 + 0.5f; // Extra +0.5 rounds value when casting to int
-		vtd->accel_buffer_complex_y_q15[sample_count*2] = (accels_avg_y - vtd->accels_static_bias_y)*FLOAT_TO_Q15 + 0.5f; // Extra +0.5 rounds value when casting to int
-		vtd->accel_buffer_complex_z_q15[sample_count*2] = (accels_avg_z - vtd->accels_static_bias_z)*FLOAT_TO_Q15 + 0.5f; // Extra +0.5 rounds value when casting to int
-		
-		//Reset the accumulators
-		vtd->accels_data_sum_x = 0;
-		vtd->accels_data_sum_y = 0;
-		vtd->accels_data_sum_z = 0;
-		vtd->accels_sum_count = 0;
-
-		// Advance sample and reset when at buffer end
-		sample_count++;
-		
-		// Only process once the buffers are filled. This could be done continuously, 
-		// but this way is probably easier on the processor
-		if (sample_count >= vtd->fft_window_size) {
-			//Reset sample count
-			sample_count = 0;
-			
-			// Perform the DFT on each of the three axes
-			for (int i=0; i < 3; i++) {
-				if (status == ARM_MATH_SUCCESS) {
-					
-					//Create pointer and assign buffer vectors to it
-					int16_t *ptr_cmplx_vec;
-					
-					switch (i) {
-						case 0:
-							ptr_cmplx_vec = vtd->accel_buffer_complex_x_q15;
-							break;
-						case 1:
-							ptr_cmplx_vec = vtd->accel_buffer_complex_y_q15;
-							break;
-						case 2:
-							ptr_cmplx_vec = vtd->accel_buffer_complex_z_q15;
-							break;
-						default:
-							//Whoops, this is a major error, leave before we overwrite memory
-							continue;
-					}
-					
-					// Process the data through the CFFT/CIFFT module. This is an in-place
-					// operation, so the FFT output is saved onto the accelerometer input buffer. 
-					// Moving forward from this point, ptr_cmplx_vec contains the DFT of the
-					// acceleration signal. 
-					// While the input is Q15, the output is not (see next comment)
-					arm_cfft_radix4_q15(&cfft_instance, ptr_cmplx_vec);
-					
-					// Upscale ptr_cmplx_vec back into Q15 format. The number of bits necessary is defined in 
-					// ARM's arm_cfft_radix4_q15 documentation, figure CFFTQ15.gif
-					arm_shift_q15(ptr_cmplx_vec, vtd->num_upscale_bits, ptr_cmplx_vec, vtd->fft_window_size);
-					
-					// Process the data through the Complex Magnitude Module. This calculates
-					// the magnitude of each complex number, so that the output is a scalar
-					// magnitude without complex phase. Only the first half of the values are
-					// calculated because in a Fourier transform the second half is symmetric.
-					arm_cmplx_mag_q15(ptr_cmplx_vec, vtd->fft_output, vtd->fft_window_size>>1);
-					
-					// Upscale fft_output back into Q15 format
-					arm_shift_q15(vtd->fft_output, 1, vtd->fft_output, vtd->fft_window_size>>1);
-					
-					// Save RAM by copying back onto original input vector.
-					memcpy(ptr_cmplx_vec, vtd->fft_output, (vtd->fft_window_size>>1) * sizeof(typeof(*vtd->accel_buffer_complex_x_q15)));
-				}
-			}
-			
-			//Write output to UAVO
-			for (int j=0; j < (vtd->fft_window_size>>1); j++) 
-			{
-				//Assertion check that we are not trying to write to instances that don't exist
-				if (j >= VibrationAnalysisOutputGetNumInstances())
-					continue;
-				
-				vibrationAnalysisOutputData.x = vtd->accel_buffer_complex_x_q15[j]/FLOAT_TO_Q15;
-				vibrationAnalysisOutputData.y = vtd->accel_buffer_complex_y_q15[j]/FLOAT_TO_Q15;
-				vibrationAnalysisOutputData.z = vtd->accel_buffer_complex_z_q15[j]/FLOAT_TO_Q15;
-				VibrationAnalysisOutputInstSet(j, &vibrationAnalysisOutputData);
-			}
-			
-			
-			// Erase buffer, which has the effect of setting the complex part to 0.
-			memset(vtd->accel_buffer_complex_x_q15, 0, vtd->fft_window_size*2*sizeof(typeof(*(vtd->accel_buffer_complex_x_q15))));
-			memset(vtd->accel_buffer_complex_y_q15, 0, vtd->fft_window_size*2*sizeof(typeof(*(vtd->accel_buffer_complex_y_q15))));
-			memset(vtd->accel_buffer_complex_z_q15, 0, vtd->fft_window_size*2*sizeof(typeof(*(vtd->accel_buffer_complex_z_q15))));
+	}
+}
+
+/**
+ * Count the Accels updates lost because the queue was full. The object
+ * manager only keeps a total for all queues, so errors are attributed to
+ * this queue when Accels was the last object that failed.
+ */
+static void count_overruns(void)
+{
+	UAVObjStats stats;
+	UAVObjGetStats(&stats);
+
+	uint32_t errors = vibration_new_queue_errors(stats.eventQueueErrors, &vtd->queue_errors);
+
+	if (errors > 0 && stats.lastQueueErrorID == ACCELS_OBJID)
+		vtd->overruns = vibration_add_overruns(vtd->overruns, errors);
+}
+
+/**
+ * Drop the partial average
+ */
+static void reset_analysis(void)
+{
+	UAVObjStats stats;
+	UAVObjGetStats(&stats);
+	vtd->queue_errors = stats.eventQueueErrors;
+
+	vtd->history_pos = 0;
+	vtd->history_fill = 0;
+	vtd->new_samples = 0;
+	vtd->num_averaged = 0;
+	vtd->samples_averaged = 0;
+	vtd->overruns = 0;
+	vtd->average_start_time = PIOS_DELAY_GetRaw();
+	memset(vtd->band_power, 0, sizeof(vtd->band_power));
+}
+
+/**
+ * Append a sample to the history of each axis
+ */
+static void add_sample(const struct accel_sample *sample)
+{
+	vtd->history[0][vtd->history_pos] = sample->x;
+	vtd->history[1][vtd->history_pos] = sample->y;
+	vtd->history[2][vtd->history_pos] = sample->z;
+
+	vtd->history_pos++;
+	if (vtd->history_pos >= vtd->fft_window_size)
+		vtd->history_pos = 0;
+
+	if (vtd->history_fill < vtd->fft_window_size)
+		vtd->history_fill++;
+
+	vtd->new_samples++;
+	vtd->samples_averaged++;
+}
+
+/**
+ * Transform the last window of each axis and add its band powers to the average
+ */
+static void transform_window(void)
+{
+	const uint16_t n = vtd->fft_window_size;
+
+	for (int axis = 0; axis < 3; axis++) {
+		const float *history = vtd->history[axis];
+		float *work = vtd->work;
+
+		// The oldest sample is at history_pos. Remove the mean, which is
+		// mostly gravity, before windowing.
+		float mean = 0;
+		for (uint16_t i = 0; i < n; i++)
+			mean += history[i];
+		mean /= n;
+
+		uint16_t j = vtd->history_pos;
+		for (uint16_t i = 0; i < n; i++) {
+			work[i] = (history[j] - mean) * vtd->window[i];
+			if (++j >= n)
+				j = 0;
+		}
+
+		rfft_forward(&vtd->plan, work);
+		rfft_power(&vtd->plan, work);
+
+		// Group the bins into bands, skipping DC
+		uint16_t bin = 1;
+		for (uint16_t band = 0; band < vtd->num_bands; band++) {
+			float sum = 0;
+			for (; bin < (band + 1) * vtd->bins_per_band; bin++)
+				sum += work[bin];
+			vtd->band_power[axis][band] += sum * vtd->power_scale;
+		}
+	}
+
+	vtd->new_samples = 0;
+	vtd->num_averaged++;
+}
+
+/**
+ * Pack the averaged spectrum into @ref VibrationAnalysisSpectrum and start a new average
+ */
+static void publish_spectrum(void)
+{
+	VibrationAnalysisSpectrumData spectrum;
+	uint8_t *packed[3] = {spectrum.X, spectrum.Y, spectrum.Z};
+
+	memset(&spectrum, 0, sizeof(spectrum));
+
+	float elapsed = PIOS_DELAY_DiffuS(vtd->average_start_time) * 1e-6f;
+	spectrum.SampleRate = elapsed > 0 ? vtd->samples_averaged / elapsed : 0;
+	spectrum.BandWidth = spectrum.SampleRate / vtd->fft_window_size * vtd->bins_per_band;
+	spectrum.Bands = vtd->num_bands;
+	spectrum.Averages = vtd->num_averaged;
+	spectrum.Overruns = vtd->overruns;
+
+	for (int axis = 0; axis < 3; axis++) {
+		// Average power to RMS acceleration in each band
+		float peak = 0;
+		for (uint16_t band = 0; band < vtd->num_bands; band++) {
+			float rms = sqrtf(vtd->band_power[axis][band] / vtd->num_averaged);
+			vtd->band_power[axis][band] = rms;
+			if (rms > peak)
+				peak = rms;
 		}
+
+		// Scale each axis so its largest band uses the full range
+		float scale = peak / 255.0f;
+		spectrum.Scale[axis] = scale;
+		for (uint16_t band = 0; band < vtd->num_bands; band++)
+			packed[axis][band] = scale > 0 ? (uint8_t) (vtd->band_power[axis][band] / scale + 0.5f) : 0;
 	}
+
+	VibrationAnalysisSpectrumSet(&spectrum);
+
+	vtd->num_averaged = 0;
+	vtd->samples_averaged = 0;
+	vtd->average_start_time = PIOS_DELAY_GetRaw();
+	memset(vtd->band_power, 0, sizeof(vtd->band_power));
 }
 
 /**
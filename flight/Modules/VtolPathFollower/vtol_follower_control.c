@@ -55,6 +55,7 @@
 // Private variables
 static VtolPathFollowerSettingsData guidanceSettings;
 static AltitudeHoldSettingsData altitudeHoldSettings;
+static struct path_segment pathSegment;
 struct pid vtol_pids[VTOL_PID_NUM];
 
 // Constants used in deadband calculation
@@ -94,7 +95,8 @@ int32_t vtol_follower_control_path(const float dT, const PathDesiredData *pathDe
 		    velocityActual.East * guidanceSettings.PositionFeedforward,
 		positionActual.Down };
 
-	path_progress(pathDesired, cur_pos_ned, progress);
+	path_segment_update(&pathSegment, pathDesired);
+	path_segment_progress(&pathSegment, cur_pos_ned, progress);
 
 	// Check if we have already completed this leg
 	bool current_leg_completed = 
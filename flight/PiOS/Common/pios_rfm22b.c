@@ -94,7 +94,7 @@
 #include <pios_spi_priv.h>
 #include <pios_rfm22b_priv.h>
 #include <pios_rfm22b_rcvr_priv.h>
-#include <ecc.h>
+#include <fec_adapt.h>
 
 /* Local Defines */
 #define STACK_SIZE_BYTES                 800
@@ -131,9 +131,6 @@
 // preamble byte (preceeds SYNC_BYTE's)
 #define PREAMBLE_BYTE                    0x55
 
-// empty packet key
-#define EMPTY_PACKET                     0x86
-
 // RF sync bytes (32-bit in all)
 #define SYNC_BYTE_1                      0x2D
 #define SYNC_BYTE_2                      0xD4
@@ -469,9 +466,6 @@ int32_t PIOS_RFM22B_Init(uint32_t * rfm22b_id, uint32_t spi_id,
 	PIOS_WDG_RegisterFlag(PIOS_WDG_RFM22B);
 #endif /* PIOS_WDG_RFM22B */
 
-	// Initialize the ECC library.
-	initialize_ecc();
-
 	// Set the state to initializing.
 	rfm22b_dev->state = RADIO_STATE_UNINITIALIZED;
 
@@ -684,6 +678,9 @@ void PIOS_RFM22B_Config(uint32_t rfm22b_id,
 	if (rfm22b_dev->max_packet_len > RFM22B_MAX_PACKET_LEN) {
 		rfm22b_dev->max_packet_len = RFM22B_MAX_PACKET_LEN;
 	}
+
+	// The packet size and parity adapt to the link within that length.
+	fec_adapt_init(&rfm22b_dev->fec, rfm22b_dev->max_packet_len);
 }
 
 /**
@@ -720,6 +717,8 @@ void PIOS_RFM22B_GetStats(uint32_t rfm22b_id, struct rfm22b_stats *stats)
 	// Calculate the current link quality
 	rfm22_calculateLinkQuality(rfm22b_dev);
 
+	rfm22b_dev->stats.tx_parity = rfm22b_dev->ppm_only_mode ? 0 : fec_adapt_parity(&rfm22b_dev->fec);
+
 	// Return the stats.
 	memcpy(stats, &rfm22b_dev->stats, sizeof(rfm22b_dev->stats));
 }
@@ -1789,9 +1788,16 @@ static enum pios_radio_event radio_txStart(struct pios_rfm22b_dev
 {
 	uint8_t *p = radio_dev->tx_packet;
 	uint8_t len = 0;
-	uint8_t max_data_len =
-	    radio_dev->max_packet_len -
-	    (radio_dev->ppm_only_mode ? 0 : RS_ECC_NPARITY);
+	uint8_t max_data_len;
+
+	// Coded packets start with the error correction level.
+	if (radio_dev->ppm_only_mode) {
+		max_data_len = radio_dev->max_packet_len;
+	} else {
+		fec_adapt_link_quality(&radio_dev->fec, radio_dev->stats.link_quality);
+		max_data_len = fec_adapt_max_payload(&radio_dev->fec);
+		p += FEC_ADAPT_HEADER_LEN;
+	}
 
 	// Don't send if it's not our turn, or if we're receiving a packet.
 	if (!rfm22_timeToSend(radio_dev) || !rfm22_InRxWait(radio_dev)) {
@@ -1851,15 +1857,10 @@ static enum pios_radio_event radio_txStart(struct pios_rfm22b_dev
 		return RADIO_EVENT_RX_MODE;
 	}
 
-	// Add the error correcting code.
+	// Add the error correcting code, empty packets get one too.
+	p = radio_dev->tx_packet;
 	if (!radio_dev->ppm_only_mode) {
-		if (len != 0) {
-			encode_data((unsigned char *)p, len, (unsigned char *)p);
-		} else {
-			for (uint32_t i = 0; i < RS_ECC_NPARITY; i++)
-				p[i] = EMPTY_PACKET + i;
-		}
-		len += RS_ECC_NPARITY;
+		len = fec_adapt_encode(&radio_dev->fec, p, len);
 	}
 	// Transmit the packet.
 	PIOS_RFM22B_TransmitPacket((uint32_t) radio_dev, p, len);
@@ -1936,29 +1937,24 @@ static enum pios_radio_event radio_receivePacket(struct pios_rfm22b_dev
 	uint8_t data_len = rx_len;
 
 	if (!radio_dev->ppm_only_mode) {
-		data_len -= RS_ECC_NPARITY;
-
-		// Attempt to correct any errors in the packet.
-		if (data_len > 0) {
-			decode_data((unsigned char *)p, rx_len);
-			good_packet = check_syndrome() == 0;
-
-			// We have an error.  Try to correct it.
-			if (!good_packet &&
-			    (correct_errors_erasures((unsigned char *)p, rx_len, 0, 0) != 0)) {
-				// We corrected it
-				corrected_packet = true;
-			}
+		// Correct any errors in the packet, the level byte in front of
+		// the payload tells how much parity it carries.
+		int corrected = fec_adapt_decode(&radio_dev->fec, p, rx_len, &data_len);
+		if (corrected >= 0) {
+			p += FEC_ADAPT_HEADER_LEN;
+
+			// Empty packets only keep the link alive
+			empty_packet = data_len == 0;
+			good_packet = !empty_packet && corrected == 0;
+			corrected_packet = !empty_packet && corrected > 0;
 		} else {
-			// Empty packets have specific code for ECC
-			empty_packet = true;
-			for (uint32_t i = 0; i < RS_ECC_NPARITY; i++)
-				empty_packet &= (p[i] == EMPTY_PACKET + i);
+			data_len = 0;
 		}
 	} else {
 		// We don't rsencode ppm only packets.
 		good_packet = true;
 	}
+	uint8_t payload_len = data_len;
 
 	uint8_t ppm_len = RFM22B_PPM_NUM_CHANNELS + (radio_dev->ppm_only_mode ? 2 : 1);
 
@@ -2023,6 +2019,8 @@ static enum pios_radio_event radio_receivePacket(struct pios_rfm22b_dev
 	}
 
 	if (good_packet || corrected_packet) {
+		radio_dev->stats.rx_payload_count += payload_len;
+
 		// Send the data to the com port
 		bool rx_need_yield;
 		if (radio_dev->rx_in_cb && (data_len > 0) && !radio_dev->ppm_only_mode) {
@@ -2300,6 +2298,7 @@ static uint8_t rfm22_calcChannel(struct pios_rfm22b_dev *rfm22b_dev,
 			} else {
 				// track that a sync packet was misssed (error)
 				rfm22b_add_rx_status(rfm22b_dev, RADIO_ERROR_RX_SYNC_MISSED);
+				fec_adapt_lost(&rfm22b_dev->fec);
 				rfm22b_dev->sync_pulses_missed++;
 			}
 		}
@@ -181,6 +181,21 @@ uint32_t PIOS_Thread_Get_Runtime(struct pios_thread *threadp)
 #endif /* (INCLUDE_uxTaskGetRunTime == 1) */
 }
 
+/**
+ *
+ * @brief   Returns scheduling statistics of a thread.
+ *
+ * @param[in] threadp      pointer to instance of @p struct pios_thread
+ * @param[out] stats       the statistics since the last call
+ *
+ * @return false, the FreeRTOS hooks do not record them
+ *
+ */
+bool PIOS_Thread_Get_Stats(struct pios_thread *threadp, struct pios_thread_stats *stats)
+{
+	return false;
+}
+
 /**
  *
  * @brief   Suspends execution of all threads.
@@ -406,6 +421,93 @@ uint32_t PIOS_Thread_Get_Stack_Usage(struct pios_thread *threadp)
 	return result;
 }
 
+/**
+ * Convert system free running counter ticks to microseconds
+ */
+static uint32_t counter_to_us(halrtcnt_t ticks)
+{
+	return (uint64_t) ticks * 1000000 / halGetCounterFrequency();
+}
+
+/**
+ *
+ * @brief   Returns scheduling statistics of a thread.
+ *
+ * @param[in] threadp      pointer to instance of @p struct pios_thread
+ * @param[out] stats       the statistics since the last call, which are reset
+ *
+ * @return true
+ *
+ */
+bool PIOS_Thread_Get_Stats(struct pios_thread *threadp, struct pios_thread_stats *stats)
+{
+	Thread *tp = threadp->threadp;
+
+	chSysLock();
+
+	halrtcnt_t latency_total = tp->wakeup_latency_total;
+	halrtcnt_t latency_max = tp->wakeup_latency_max;
+	stats->wakeups = tp->wakeups;
+	stats->preemptions = tp->preemptions;
+
+	tp->wakeup_latency_total = 0;
+	tp->wakeup_latency_max = 0;
+	tp->wakeups = 0;
+	tp->preemptions = 0;
+
+	chSysUnlock();
+
+	stats->wakeup_latency_avg = stats->wakeups ? counter_to_us(latency_total) / stats->wakeups : 0;
+	stats->wakeup_latency_max = counter_to_us(latency_max);
+
+	return true;
+}
+
+#if defined(DIAG_PROFILER) && defined(PORT_OPTIMIZED_READYI)
+/**
+ *
+ * @brief   Inserts a thread in the ready list.
+ *
+ * @details This is the kernel implementation with the addition of stamping
+ *          the time a sleeping thread is woken up, which the context switch
+ *          hook in chconf.h turns into the wakeup latency. A running thread
+ *          that is being preempted is not stamped. Only built with the
+ *          profiler.
+ *
+ * @param[in] tp           the thread to be made ready
+ *
+ * @return the thread
+ *
+ */
+Thread *chSchReadyI(Thread *tp)
+{
+	Thread *cp;
+
+	chDbgCheckClassI();
+
+	/* Integrity checks.*/
+	chDbgAssert((tp->p_state != THD_STATE_READY) &&
+	            (tp->p_state != THD_STATE_FINAL),
+	            "chSchReadyI(), #1",
+	            "invalid state");
+
+	if (tp->p_state != THD_STATE_CURRENT)
+		tp->ticks_ready = halGetCounterValue();
+
+	tp->p_state = THD_STATE_READY;
+	cp = (Thread *)&rlist.r_queue;
+	do {
+		cp = cp->p_next;
+	} while (cp->p_prio >= tp->p_prio);
+	/* Insertion on p_prev.*/
+	tp->p_next = cp;
+	tp->p_prev = cp->p_prev;
+	tp->p_prev->p_next = cp->p_prev = tp;
+
+	return tp;
+}
+#endif /* defined(DIAG_PROFILER) && defined(PORT_OPTIMIZED_READYI) */
+
 /**
  *
  * @brief   Suspends execution of all threads.
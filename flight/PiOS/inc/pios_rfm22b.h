@@ -69,6 +69,7 @@ typedef enum {
 struct rfm22b_stats {
 	uint16_t tx_byte_count;
 	uint16_t rx_byte_count;
+	uint16_t rx_payload_count;
 	uint8_t rx_good;
 	uint8_t rx_corrected;
 	uint8_t rx_error;
@@ -81,6 +82,7 @@ struct rfm22b_stats {
 	int8_t rssi;
 	int8_t afc_correction;
 	uint8_t link_state;
+	uint8_t tx_parity;
 };
 
 /* Public Functions */
@@ -40,6 +40,7 @@
 #include "pios_rfm22b_regs.h"
 #include "pios_semaphore.h"
 #include "pios_thread.h"
+#include <fec_adapt.h>
 
 // External type definitions
 
@@ -226,6 +227,9 @@ struct pios_rfm22b_dev {
 	// Stats
 	uint16_t errors;
 
+	// The error correction and packet size adaptation
+	struct fec_adapt fec;
+
 	// RSSI in dBm
 	int8_t rssi_dBm;
 
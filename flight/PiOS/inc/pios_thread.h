@@ -72,6 +72,15 @@ struct pios_thread
 
 #endif /* defined(PIOS_INCLUDE_CHIBIOS) */
 
+//! Scheduling statistics of a thread
+struct pios_thread_stats
+{
+	uint32_t wakeups;		//!< times the thread was woken up
+	uint32_t wakeup_latency_avg;	//!< average time from being woken up to running in us
+	uint32_t wakeup_latency_max;	//!< longest time from being woken up to running in us
+	uint32_t preemptions;		//!< times the thread was preempted while running
+};
+
 /*
  * The following functions implement the concept of a thread usable
  * with PIOS_INCLUDE_FREERTOS.
@@ -86,6 +95,7 @@ void PIOS_Thread_Sleep(uint32_t time_ms);
 void PIOS_Thread_Sleep_Until(uint32_t *previous_ms, uint32_t increment_ms);
 uint32_t PIOS_Thread_Get_Stack_Usage(struct pios_thread *threadp);
 uint32_t PIOS_Thread_Get_Runtime(struct pios_thread *threadp);
+bool PIOS_Thread_Get_Stats(struct pios_thread *threadp, struct pios_thread_stats *stats);
 void PIOS_Thread_Scheduler_Suspend(void);
 void PIOS_Thread_Scheduler_Resume(void);
 
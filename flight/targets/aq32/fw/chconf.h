@@ -486,6 +486,11 @@ typedef uint32_t halrtcnt_t;
 #define THREAD_EXT_FIELDS                                                   \
   halrtcnt_t ticks_switched_in;                                             \
   halrtcnt_t ticks_total;                                                   \
+  halrtcnt_t ticks_ready;                                                   \
+  halrtcnt_t wakeup_latency_total;                                          \
+  halrtcnt_t wakeup_latency_max;                                            \
+  uint32_t wakeups;                                                         \
+  uint32_t preemptions;                                                     \
   /* Add threads custom fields here.*/
 #endif
 
@@ -498,7 +503,12 @@ typedef uint32_t halrtcnt_t;
  */
 #if !defined(THREAD_EXT_INIT_HOOK) || defined(__DOXYGEN__)
 #define THREAD_EXT_INIT_HOOK(tp) {                                          \
-  /* Add threads initialization code here.*/                                \
+  tp->ticks_total = 0;                                                      \
+  tp->ticks_ready = 0;                                                      \
+  tp->wakeup_latency_total = 0;                                             \
+  tp->wakeup_latency_max = 0;                                               \
+  tp->wakeups = 0;                                                          \
+  tp->preemptions = 0;                                                      \
 }
 #endif
 
@@ -524,10 +534,31 @@ typedef uint32_t halrtcnt_t;
 #define THREAD_CONTEXT_SWITCH_HOOK(ntp, otp) {                              \
   ntp->ticks_switched_in = halGetCounterValue();                            \
   otp->ticks_total += ntp->ticks_switched_in - otp->ticks_switched_in;      \
-  /* System halt code here.*/                                               \
+  if (otp->p_state == THD_STATE_READY)                                      \
+    otp->preemptions++;                                                     \
+  if (ntp->ticks_ready != 0) {                                              \
+    halrtcnt_t latency = ntp->ticks_switched_in - ntp->ticks_ready;         \
+    ntp->wakeup_latency_total += latency;                                   \
+    if (latency > ntp->wakeup_latency_max)                                  \
+      ntp->wakeup_latency_max = latency;                                    \
+    ntp->wakeups++;                                                         \
+    ntp->ticks_ready = 0;                                                   \
+  }                                                                         \
 }
 #endif
 
+/**
+ * @brief   Ready list insertion.
+ * @details Provided by pios_thread.c instead of the kernel when the profiler
+ *          is built, so that the time each thread is woken up is recorded
+ *          for the wakeup latency.
+ */
+#if defined(DIAG_PROFILER)
+#define PORT_OPTIMIZED_READYI
+struct Thread;
+struct Thread *chSchReadyI(struct Thread *tp);
+#endif
+
 /**
  * @brief   Idle Loop hook.
  * @details This hook is continuously invoked by the idle thread loop.
@@ -298,6 +298,7 @@ extern uint32_t pios_packet_handler;
 //-------------------------
 
 #define RS_ECC_NPARITY 4
+#define RS_ECC_MAX_NPARITY 12
 
 //-------------------------
 // Flash EEPROM Emulation
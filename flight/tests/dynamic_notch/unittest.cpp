@@ -0,0 +1,308 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test and benchmark of the dynamic gyro notch filters
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
+
+extern "C" {
+
+#include "dynamic_notch.h"
+
+}
+
+#include <math.h>		/* fabs() */
+
+static double cpu_time(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Small reproducible noise source, uniform in [-1, 1] */
+static float noise(uint32_t *state)
+{
+  *state = *state * 1664525u + 1013904223u;
+  return (float) (*state >> 8) / (1 << 23) - 1.0f;
+}
+
+/*
+ * Synthetic gyro: slow maneuvering on each axis, motor noise made of a
+ * fundamental that moves linearly from f_start to f_end and its second
+ * harmonic, and broadband sensor noise.
+ */
+struct synthetic_gyro {
+  float sample_rate;
+  float f_start;
+  float f_end;
+  float duration;
+  float motor_amplitude;
+  float harmonic_amplitude;
+  float sensor_noise;
+};
+
+struct filter_result {
+  float motor_rms;	/* rms of the motor noise over the last 0.5 s */
+  float residual_rms;	/* rms of the filtered output minus the maneuvers */
+};
+
+static struct filter_result run_synthetic(struct dyn_notch *dn, const struct synthetic_gyro *sim)
+{
+  const int samples = (int) (sim->duration * sim->sample_rate);
+  const int measure_from = samples - (int) (0.5f * sim->sample_rate);
+  double phase = 0, motor_sq = 0, residual_sq = 0;
+  uint32_t seed = 12345;
+  int measured = 0;
+
+  for (int i = 0; i < samples; i++) {
+    double t = i / sim->sample_rate;
+    double f = sim->f_start + (sim->f_end - sim->f_start) * t / sim->duration;
+    phase += 2 * M_PI * f / sim->sample_rate;
+
+    float gyro[3], maneuver[3];
+    for (int axis = 0; axis < 3; axis++) {
+      maneuver[axis] = 50.0f * sinf(2 * M_PI * (1.0 + axis) * t);
+      float motor = sim->motor_amplitude * sin(phase + axis) +
+                    sim->harmonic_amplitude * sin(2 * phase + axis);
+      gyro[axis] = maneuver[axis] + motor + sim->sensor_noise * noise(&seed);
+
+      if (i >= measure_from)
+        motor_sq += motor * motor;
+    }
+
+    dyn_notch_apply(dn, gyro);
+
+    if (i >= measure_from) {
+      for (int axis = 0; axis < 3; axis++) {
+        float residual = gyro[axis] - maneuver[axis];
+        residual_sq += residual * residual;
+      }
+      measured += 3;
+    }
+  }
+
+  struct filter_result result;
+  result.motor_rms = sqrt(motor_sq / measured);
+  result.residual_rms = sqrt(residual_sq / measured);
+  return result;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class DynamicNotch : public testing::Test {
+protected:
+  virtual void SetUp() {
+    cfg.sample_rate = 1000;
+    cfg.min_hz = 80;
+    cfg.max_hz = 450;
+    cfg.q = 3;
+    cfg.num_notches = 1;
+
+    sim.sample_rate = cfg.sample_rate;
+    sim.f_start = 180;
+    sim.f_end = 180;
+    sim.duration = 2;
+    sim.motor_amplitude = 20;
+    sim.harmonic_amplitude = 0;
+    sim.sensor_noise = 1;
+  }
+
+  virtual void TearDown() {
+  }
+
+  struct dyn_notch dn;
+  struct dyn_notch_config cfg;
+  struct synthetic_gyro sim;
+};
+
+TEST_F(DynamicNotch, RejectsBadConfigs) {
+  struct dyn_notch_config bad;
+
+  bad = cfg; bad.sample_rate = 0;
+  EXPECT_FALSE(dyn_notch_init(&dn, &bad));
+  bad = cfg; bad.max_hz = bad.min_hz;
+  EXPECT_FALSE(dyn_notch_init(&dn, &bad));
+  bad = cfg; bad.num_notches = 0;
+  EXPECT_FALSE(dyn_notch_init(&dn, &bad));
+  bad = cfg; bad.num_notches = DYN_NOTCH_MAX_NOTCHES + 1;
+  EXPECT_FALSE(dyn_notch_init(&dn, &bad));
+  bad = cfg; bad.q = 0;
+  EXPECT_FALSE(dyn_notch_init(&dn, &bad));
+
+  EXPECT_TRUE(dyn_notch_init(&dn, &cfg));
+};
+
+TEST_F(DynamicNotch, NotchResponse) {
+  struct biquad notch;
+  const float center = 200;
+
+  biquad_notch_design(&notch, cfg.sample_rate, center, cfg.q);
+
+  /* Gain of a steady tone after the transient has died away */
+  const float freqs[] = {0, 10, center, 400};
+  const float expected[] = {1, 1, 0, 1};
+  for (unsigned j = 0; j < sizeof(freqs) / sizeof(freqs[0]); j++) {
+    biquad_reset(&notch);
+    float peak = 0;
+    for (int i = 0; i < 2000; i++) {
+      float y = biquad_apply(&notch, cosf(2 * M_PI * freqs[j] * i / cfg.sample_rate));
+      if (i >= 1000 && fabsf(y) > peak)
+        peak = fabsf(y);
+    }
+    EXPECT_NEAR(expected[j], peak, 0.05f) << freqs[j] << " Hz";
+  }
+};
+
+TEST_F(DynamicNotch, PassesThroughWithoutPeaks) {
+  ASSERT_TRUE(dyn_notch_init(&dn, &cfg));
+
+  sim.motor_amplitude = 0;
+  sim.sensor_noise = 0;
+  struct filter_result result = run_synthetic(&dn, &sim);
+
+  float centers[DYN_NOTCH_MAX_NOTCHES];
+  for (uint8_t axis = 0; axis < DYN_NOTCH_AXES; axis++) {
+    dyn_notch_get_centers(&dn, axis, centers);
+    EXPECT_EQ(0, centers[0]);
+  }
+  EXPECT_LT(result.residual_rms, 1e-4);
+};
+
+TEST_F(DynamicNotch, TracksSteadyTone) {
+  ASSERT_TRUE(dyn_notch_init(&dn, &cfg));
+
+  struct filter_result result = run_synthetic(&dn, &sim);
+
+  float centers[DYN_NOTCH_MAX_NOTCHES];
+  for (uint8_t axis = 0; axis < DYN_NOTCH_AXES; axis++) {
+    dyn_notch_get_centers(&dn, axis, centers);
+    EXPECT_NEAR(sim.f_start, centers[0], 3);
+  }
+
+  printf("steady tone: motor rms %.2f residual rms %.2f\n", result.motor_rms, result.residual_rms);
+  EXPECT_LT(result.residual_rms, 0.15f * result.motor_rms);
+};
+
+TEST_F(DynamicNotch, TracksSweep) {
+  ASSERT_TRUE(dyn_notch_init(&dn, &cfg));
+
+  /* Throttle up over a few seconds */
+  sim.f_start = 120;
+  sim.f_end = 300;
+  sim.duration = 4;
+  struct filter_result result = run_synthetic(&dn, &sim);
+
+  float centers[DYN_NOTCH_MAX_NOTCHES];
+  for (uint8_t axis = 0; axis < DYN_NOTCH_AXES; axis++) {
+    dyn_notch_get_centers(&dn, axis, centers);
+    EXPECT_NEAR(sim.f_end, centers[0], 8);
+  }
+
+  printf("sweep: motor rms %.2f residual rms %.2f\n", result.motor_rms, result.residual_rms);
+  EXPECT_LT(result.residual_rms, 0.3f * result.motor_rms);
+};
+
+TEST_F(DynamicNotch, TracksHarmonic) {
+  cfg.num_notches = 2;
+  ASSERT_TRUE(dyn_notch_init(&dn, &cfg));
+
+  sim.f_start = 140;
+  sim.f_end = 140;
+  sim.harmonic_amplitude = 10;
+  struct filter_result result = run_synthetic(&dn, &sim);
+
+  float centers[DYN_NOTCH_MAX_NOTCHES];
+  for (uint8_t axis = 0; axis < DYN_NOTCH_AXES; axis++) {
+    dyn_notch_get_centers(&dn, axis, centers);
+    EXPECT_NEAR(sim.f_start, centers[0], 3);
+    EXPECT_NEAR(2 * sim.f_start, centers[1], 4);
+  }
+
+  printf("harmonic: motor rms %.2f residual rms %.2f\n", result.motor_rms, result.residual_rms);
+  EXPECT_LT(result.residual_rms, 0.2f * result.motor_rms);
+};
+
+TEST_F(DynamicNotch, LowPhaseDelay) {
+  ASSERT_TRUE(dyn_notch_init(&dn, &cfg));
+
+  /* Place the notch with the steady tone, then check the delay at 10 Hz */
+  run_synthetic(&dn, &sim);
+
+  struct biquad notch = dn.notch[0][0];
+  biquad_reset(&notch);
+
+  const float f = 10;
+  double sum_sin = 0, sum_cos = 0;
+  for (int i = 0; i < 2000; i++) {
+    double t = i / cfg.sample_rate;
+    float y = biquad_apply(&notch, sinf(2 * M_PI * f * t));
+    if (i >= 1000) {
+      sum_sin += y * sin(2 * M_PI * f * t);
+      sum_cos += y * cos(2 * M_PI * f * t);
+    }
+  }
+  double delay = -atan2(sum_cos, sum_sin) / (2 * M_PI * f);
+
+  /* A first order low pass with the same attenuation at the tone has ~5 ms */
+  printf("delay at %.0f Hz: %.3f ms\n", f, delay * 1e3);
+  EXPECT_LT(fabs(delay), 0.5e-3);
+};
+
+TEST_F(DynamicNotch, Benchmark) {
+  cfg.num_notches = DYN_NOTCH_MAX_NOTCHES;
+  ASSERT_TRUE(dyn_notch_init(&dn, &cfg));
+
+  const int iterations = 200000;
+  float gyro[3];
+  uint32_t seed = 1;
+
+  double start = cpu_time();
+  for (int i = 0; i < iterations; i++) {
+    gyro[0] = 20 * sinf(2 * M_PI * 150 * i / cfg.sample_rate) + noise(&seed);
+    gyro[1] = 20 * sinf(2 * M_PI * 210 * i / cfg.sample_rate) + noise(&seed);
+    gyro[2] = 20 * sinf(2 * M_PI * 330 * i / cfg.sample_rate) + noise(&seed);
+    dyn_notch_apply(&dn, gyro);
+  }
+  double elapsed = cpu_time() - start;
+
+  printf("%d notches per axis: %.3f us per sample\n", cfg.num_notches, elapsed / iterations * 1e6);
+};
+
+/**
+ * @}
+ * @}
+ */
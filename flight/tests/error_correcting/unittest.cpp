@@ -1,12 +1,12 @@
 /**
  ******************************************************************************
  * @file       unittest.cpp
- * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013-2015
  * @addtogroup UnitTests
  * @{
  * @addtogroup UnitTests
  * @{
- * @brief Unit test
+ * @brief Unit test and benchmark of the Reed Solomon codec
  *****************************************************************************/
 /*
  * This program is free software; you can redistribute it and/or modify
@@ -37,6 +37,7 @@
 #include <stdlib.h>		/* abort */
 #include <string.h>		/* memset */
 #include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
 
 extern "C" {
 
@@ -46,7 +47,33 @@ extern "C" {
 
 #include <math.h>   /* fabs() */
 
+static double cpu_time(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
 
+/* Small reproducible random source */
+static uint32_t rand_next(uint32_t *state)
+{
+  *state = *state * 1664525u + 1013904223u;
+  return *state >> 8;
+}
+
+/* Flip distinct bytes of a codeword to random other values */
+static void add_errors(uint8_t *codeword, int csize, int nerrors, uint32_t *seed)
+{
+  bool hit[256] = {};
+  for (int e = 0; e < nerrors; e++) {
+    int loc;
+    do {
+      loc = rand_next(seed) % csize;
+    } while (hit[loc]);
+    hit[loc] = true;
+    codeword[loc] ^= 1 + rand_next(seed) % 255;
+  }
+}
 
 // To use a test fixture, derive a class from testing::Test.
 class EncodeDecode : public testing::Test {
@@ -104,3 +131,168 @@ TEST_F(EncodeDecode, Recover) {
     EXPECT_EQ(p[i], p2[i]);
 
 };
+
+TEST_F(EncodeDecode, Erasures) {
+  unsigned char msg[] = "Nervously I loaded the twin ducks aboard the revolving platform.";
+  const int ml = sizeof(msg) + RS_ECC_NPARITY;
+  unsigned char codeword[256];
+  encode_data(msg, sizeof(msg), codeword);
+
+  // One error and two erasures, which are located from the end
+  codeword[2] ^= 0x35;
+  codeword[16] ^= 0x23;
+  codeword[18] ^= 0x34;
+  int erasures[] = {ml - 17, ml - 19};
+
+  decode_data(codeword, ml);
+  EXPECT_EQ(1, check_syndrome());
+  EXPECT_EQ(1, correct_errors_erasures(codeword, ml, 2, erasures));
+  EXPECT_EQ(0, memcmp(msg, codeword, sizeof(msg)));
+};
+
+class Codec : public testing::Test {
+protected:
+  virtual void SetUp() {
+    seed = 1;
+  }
+
+  virtual void TearDown() {
+  }
+
+  struct rs_codec rs;
+  uint32_t seed;
+};
+
+TEST_F(Codec, RejectsBadParity) {
+  EXPECT_FALSE(rs_init(&rs, 0));
+  EXPECT_FALSE(rs_init(&rs, RS_ECC_MAX_NPARITY + 1));
+  EXPECT_TRUE(rs_init(&rs, RS_ECC_MAX_NPARITY));
+};
+
+TEST_F(Codec, MatchesLegacyEncoder) {
+  uint8_t p[10] = {'a', 'b', 'c', 'd', 'e', 'f'};
+  ASSERT_TRUE(rs_init(&rs, 4));
+  rs_encode(&rs, p, 6, p + 6);
+  EXPECT_EQ(0x1f, p[6]);
+  EXPECT_EQ(0xa3, p[7]);
+  EXPECT_EQ(0x9a, p[8]);
+  EXPECT_EQ(0x3b, p[9]);
+
+  EXPECT_EQ(0, rs_decode(&rs, p, 10));
+};
+
+TEST_F(Codec, CorrectsHalfTheParity) {
+  const uint8_t nparities[] = {2, 4, 8, RS_ECC_MAX_NPARITY};
+
+  for (unsigned j = 0; j < sizeof(nparities); j++) {
+    uint8_t n = nparities[j];
+    ASSERT_TRUE(rs_init(&rs, n));
+
+    for (int trial = 0; trial < 500; trial++) {
+      int len = 1 + rand_next(&seed) % (255 - n);
+      uint8_t sent[255], received[255];
+      for (int i = 0; i < len; i++)
+        sent[i] = rand_next(&seed);
+      rs_encode(&rs, sent, len, sent + len);
+
+      int nerrors = rand_next(&seed) % (n / 2 + 1);
+      memcpy(received, sent, len + n);
+      add_errors(received, len + n, nerrors, &seed);
+
+      ASSERT_EQ(nerrors, rs_decode(&rs, received, len + n)) << "parity " << (int) n << " length " << len;
+      ASSERT_EQ(0, memcmp(sent, received, len + n));
+    }
+  }
+};
+
+TEST_F(Codec, RejectsTooManyErrors) {
+  const uint8_t n = 8;
+  const int len = 48;
+  int rejected = 0, miscorrected = 0;
+  const int trials = 2000;
+  ASSERT_TRUE(rs_init(&rs, n));
+
+  for (int trial = 0; trial < trials; trial++) {
+    uint8_t cw[len + n], synd[n];
+    for (int i = 0; i < len; i++)
+      cw[i] = rand_next(&seed);
+    rs_encode(&rs, cw, len, cw + len);
+
+    add_errors(cw, len + n, n / 2 + 1 + rand_next(&seed) % 4, &seed);
+
+    // Either the decoder gives up or it lands on some valid codeword
+    uint8_t before[len + n];
+    memcpy(before, cw, sizeof(cw));
+    int ret = rs_decode(&rs, cw, len + n);
+    if (ret < 0) {
+      rejected++;
+      EXPECT_EQ(0, memcmp(before, cw, sizeof(cw)));
+    } else {
+      miscorrected++;
+      EXPECT_FALSE(rs_syndromes(&rs, cw, len + n, synd));
+    }
+  }
+
+  printf("%d of %d rejected, %d decoded to another codeword\n", rejected, trials, miscorrected);
+  EXPECT_GT(rejected, trials * 0.99);
+};
+
+TEST_F(Codec, IndependentCodecs) {
+  // Codecs share nothing, so packets of different parity can be interleaved
+  struct rs_codec small, large;
+  ASSERT_TRUE(rs_init(&small, 2));
+  ASSERT_TRUE(rs_init(&large, RS_ECC_MAX_NPARITY));
+
+  uint8_t a[38 + 2], b[38 + RS_ECC_MAX_NPARITY], a_sent[sizeof(a)], b_sent[sizeof(b)];
+  for (int i = 0; i < 38; i++)
+    a[i] = b[i] = rand_next(&seed);
+  rs_encode(&small, a, 38, a + 38);
+  rs_encode(&large, b, 38, b + 38);
+  memcpy(a_sent, a, sizeof(a));
+  memcpy(b_sent, b, sizeof(b));
+
+  a[3] ^= 0x55;
+  b[3] ^= 0x55;
+  b[20] ^= 0x01;
+  EXPECT_EQ(2, rs_decode(&large, b, sizeof(b)));
+  EXPECT_EQ(1, rs_decode(&small, a, sizeof(a)));
+  EXPECT_EQ(0, memcmp(a_sent, a, sizeof(a)));
+  EXPECT_EQ(0, memcmp(b_sent, b, sizeof(b)));
+};
+
+TEST_F(Codec, Benchmark) {
+  // Packets as the RFM22B sends them
+  const int len = 60;
+  const uint8_t n = RS_ECC_NPARITY;
+  const int packets = 200000;
+  uint8_t cw[len + n], sent[len + n];
+  ASSERT_TRUE(rs_init(&rs, n));
+
+  for (int i = 0; i < len; i++)
+    sent[i] = rand_next(&seed);
+  rs_encode(&rs, sent, len, sent + len);
+
+  double start = cpu_time();
+  for (int i = 0; i < packets; i++) {
+    sent[0] = i;
+    rs_encode(&rs, sent, len, cw + len);
+  }
+  double encode = cpu_time() - start;
+  rs_encode(&rs, sent, len, sent + len);
+
+  for (int nerrors = 0; nerrors <= n / 2; nerrors++) {
+    start = cpu_time();
+    for (int i = 0; i < packets; i++) {
+      memcpy(cw, sent, sizeof(cw));
+      for (int e = 0; e < nerrors; e++)
+        cw[(i + 17 * e) % sizeof(cw)] ^= 0x5a;
+      ASSERT_EQ(nerrors, rs_decode(&rs, cw, sizeof(cw)));
+    }
+    double elapsed = cpu_time() - start;
+    printf("decode with %d errors: %.3f us per packet, %.1f MB/s\n", nerrors,
+           elapsed / packets * 1e6, packets * sizeof(cw) / elapsed * 1e-6);
+  }
+
+  printf("encode: %.3f us per packet, %.1f MB/s\n", encode / packets * 1e6,
+         packets * len / encode * 1e-6);
+};
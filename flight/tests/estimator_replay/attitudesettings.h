@@ -0,0 +1,8 @@
+/* Only the type is referenced by the estimators */
+typedef struct {
+	float AccelKp;
+	float AccelKi;
+	float MagKp;
+	float MagKi;
+	float YawBiasRate;
+} AttitudeSettingsData;
@@ -0,0 +1,9 @@
+/* The replay does not enable GPS drift compensation so this is never called */
+typedef struct {
+	float North;
+	float East;
+	float Down;
+	float Accuracy;
+} GPSVelocityData;
+
+static inline int32_t GPSVelocityGet(GPSVelocityData *data) { memset(data, 0, sizeof(*data)); return 0; }
@@ -0,0 +1,6 @@
+/* Only the type is referenced by the estimators */
+typedef struct {
+	float x;
+	float y;
+	float z;
+} GyrosBiasData;
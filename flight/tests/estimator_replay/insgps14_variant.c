@@ -0,0 +1,37 @@
+/**
+ ******************************************************************************
+ * @file       insgps14_variant.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup EstimatorReplay Off-target replay of the state estimators
+ * @{
+ * @brief The 14 state INSGPS with its symbols prefixed
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#define INSGPS_PREFIX insgps14_
+#include "insgps_variant.h"
+
+#include "insgps14state.c"
+
+INSGPS_DEFINE_OPS(insgps14_ops);
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,132 @@
+/**
+ ******************************************************************************
+ * @file       insgps_variant.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup EstimatorReplay Off-target replay of the state estimators
+ * @{
+ * @brief Build several INSGPS implementations into one program
+ *
+ * Every insgps*state.c exports the same symbols (the API from insgps.h and,
+ * for some of them, the state matrices). To link them side by side each one
+ * is compiled from a small wrapper which defines INSGPS_PREFIX and includes
+ * this file before the filter source, so all its external symbols get the
+ * prefix. The wrapper then exposes the filter through a struct insgps_ops.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef INSGPS_VARIANT_H
+#define INSGPS_VARIANT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+struct insgps_ops {
+	void (*init)(void);
+	void (*state_prediction)(const float gyro_data[3], const float accel_data[3], float dT);
+	void (*covariance_prediction)(float dT);
+	void (*correction)(const float mag_data[3], const float Pos[3], const float Vel[3], float BaroAlt, uint16_t SensorsUsed);
+	void (*get_state)(float *pos, float *vel, float *attitude, float *gyro_bias, float *accel_bias);
+	void (*set_state)(const float pos[3], const float vel[3], const float q[4], const float gyro_bias[3], const float accel_bias[3]);
+	void (*set_pos_vel_var)(float PosVar, float VelVar, float VertPosVar);
+	void (*set_gyro_bias)(const float gyro_bias[3]);
+	void (*set_accel_bias)(const float accel_bias[3]);
+	void (*set_accel_var)(const float accel_var[3]);
+	void (*set_gyro_var)(const float gyro_var[3]);
+	void (*set_mag_north)(const float B[3]);
+	void (*set_mag_var)(const float scaled_mag_var[3]);
+	void (*set_baro_var)(float baro_var);
+};
+
+extern const struct insgps_ops insgps13_ops;
+extern const struct insgps_ops insgps14_ops;
+extern const struct insgps_ops insgps16_ops;
+
+#endif /* INSGPS_VARIANT_H */
+
+#if defined(INSGPS_PREFIX)
+
+#include <math.h>
+
+#define INSGPS_CAT2(a, b) a ## b
+#define INSGPS_CAT(a, b) INSGPS_CAT2(a, b)
+
+/* API from insgps.h */
+#define INSGPSInit              INSGPS_CAT(INSGPS_PREFIX, INSGPSInit)
+#define INSStatePrediction      INSGPS_CAT(INSGPS_PREFIX, INSStatePrediction)
+#define INSCovariancePrediction INSGPS_CAT(INSGPS_PREFIX, INSCovariancePrediction)
+#define INSCorrection           INSGPS_CAT(INSGPS_PREFIX, INSCorrection)
+#define INSGetState             INSGPS_CAT(INSGPS_PREFIX, INSGetState)
+#define INSSetArmed             INSGPS_CAT(INSGPS_PREFIX, INSSetArmed)
+#define INSResetP               INSGPS_CAT(INSGPS_PREFIX, INSResetP)
+#define INSSetState             INSGPS_CAT(INSGPS_PREFIX, INSSetState)
+#define INSSetPosVelVar         INSGPS_CAT(INSGPS_PREFIX, INSSetPosVelVar)
+#define INSSetGyroBias          INSGPS_CAT(INSGPS_PREFIX, INSSetGyroBias)
+#define INSSetAccelBias         INSGPS_CAT(INSGPS_PREFIX, INSSetAccelBias)
+#define INSSetAccelVar          INSGPS_CAT(INSGPS_PREFIX, INSSetAccelVar)
+#define INSSetGyroVar           INSGPS_CAT(INSGPS_PREFIX, INSSetGyroVar)
+#define INSSetMagNorth          INSGPS_CAT(INSGPS_PREFIX, INSSetMagNorth)
+#define INSSetMagVar            INSGPS_CAT(INSGPS_PREFIX, INSSetMagVar)
+#define INSSetBaroVar           INSGPS_CAT(INSGPS_PREFIX, INSSetBaroVar)
+#define INSPosVelReset          INSGPS_CAT(INSGPS_PREFIX, INSPosVelReset)
+#define INSGetVariance          INSGPS_CAT(INSGPS_PREFIX, INSGetVariance)
+#define INSLimitBias            INSGPS_CAT(INSGPS_PREFIX, INSLimitBias)
+#define ins_get_num_states      INSGPS_CAT(INSGPS_PREFIX, ins_get_num_states)
+
+/* Helpers and state that are not static in some of the implementations */
+#define CovariancePrediction    INSGPS_CAT(INSGPS_PREFIX, CovariancePrediction)
+#define SerialUpdate            INSGPS_CAT(INSGPS_PREFIX, SerialUpdate)
+#define RungeKutta              INSGPS_CAT(INSGPS_PREFIX, RungeKutta)
+#define StateEq                 INSGPS_CAT(INSGPS_PREFIX, StateEq)
+#define LinearizeFG             INSGPS_CAT(INSGPS_PREFIX, LinearizeFG)
+#define MeasurementEq           INSGPS_CAT(INSGPS_PREFIX, MeasurementEq)
+#define LinearizeH              INSGPS_CAT(INSGPS_PREFIX, LinearizeH)
+#define F                       INSGPS_CAT(INSGPS_PREFIX, F)
+#define G                       INSGPS_CAT(INSGPS_PREFIX, G)
+#define H                       INSGPS_CAT(INSGPS_PREFIX, H)
+#define Be                      INSGPS_CAT(INSGPS_PREFIX, Be)
+#define P                       INSGPS_CAT(INSGPS_PREFIX, P)
+#define X                       INSGPS_CAT(INSGPS_PREFIX, X)
+#define Q                       INSGPS_CAT(INSGPS_PREFIX, Q)
+#define R                       INSGPS_CAT(INSGPS_PREFIX, R)
+#define K                       INSGPS_CAT(INSGPS_PREFIX, K)
+
+#define INSGPS_DEFINE_OPS(ops)                          \
+	const struct insgps_ops ops = {                 \
+		.init = INSGPSInit,                     \
+		.state_prediction = INSStatePrediction, \
+		.covariance_prediction = INSCovariancePrediction, \
+		.correction = INSCorrection,            \
+		.get_state = INSGetState,               \
+		.set_state = INSSetState,               \
+		.set_pos_vel_var = INSSetPosVelVar,     \
+		.set_gyro_bias = INSSetGyroBias,        \
+		.set_accel_bias = INSSetAccelBias,      \
+		.set_accel_var = INSSetAccelVar,        \
+		.set_gyro_var = INSSetGyroVar,          \
+		.set_mag_north = INSSetMagNorth,        \
+		.set_mag_var = INSSetMagVar,            \
+		.set_baro_var = INSSetBaroVar,          \
+	}
+
+#endif /* defined(INSGPS_PREFIX) */
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1 @@
+/* Not needed by the estimators, only included by them */
@@ -0,0 +1,142 @@
+/**
+ ******************************************************************************
+ * @file       replay.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup EstimatorReplay Off-target replay of the state estimators
+ * @{
+ * @brief Feeds recorded or synthetic sensor data through the attitude filters
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+enum replay_sensor {
+	REPLAY_GYRO,		/* vec: deg/s */
+	REPLAY_ACCEL,		/* vec: m/s^2 */
+	REPLAY_MAG,		/* vec: mGa */
+	REPLAY_BARO,		/* vec[0]: altitude in m */
+	REPLAY_GPS,		/* vec: NED position in m, vec2: NED velocity in m/s */
+	REPLAY_REFERENCE,	/* q: attitude the filters are compared against */
+};
+
+struct replay_sample {
+	enum replay_sensor type;
+	double time;		/* seconds from the start of the data */
+	float vec[3];
+	float vec2[3];
+	float q[4];
+};
+
+/**
+ * A source of sensor samples in time order. next() returns false at the
+ * end of the data.
+ */
+struct replay_source {
+	bool (*next)(struct replay_source *src, struct replay_sample *sample);
+	void (*close)(struct replay_source *src);
+	void *priv;
+};
+
+//! Open a GCS log (.tll) and decode the sensor objects from it
+bool replay_log_open(struct replay_source *src, const char *filename);
+
+//! Parameters of the synthetic flight
+struct replay_sim_config {
+	double duration;	/* s */
+	double gyro_rate;	/* Hz, the accels are sampled at the same rate */
+	double mag_rate;	/* Hz */
+	double baro_rate;	/* Hz */
+	double gps_rate;	/* Hz */
+	float gyro_bias[3];	/* deg/s */
+	float gyro_noise;	/* deg/s, standard deviation */
+	float accel_noise;	/* m/s^2, standard deviation */
+	float mag_noise;	/* mGa, standard deviation */
+	float baro_noise;	/* m, standard deviation */
+	float Be[3];		/* mGa, earth magnetic field */
+	uint32_t seed;
+};
+
+//! Fill in a moderately aggressive default flight
+void replay_sim_default_config(struct replay_sim_config *cfg);
+
+//! Generate the sensors from a known trajectory, the truth is emitted as the reference
+bool replay_sim_open(struct replay_source *src, const struct replay_sim_config *cfg);
+
+/**
+ * Common interface to every estimator. The filter is stepped on each gyro
+ * sample and receives the other sensors as they arrive.
+ */
+struct replay_filter {
+	const char *name;
+	void (*reset)(void);
+	void (*set_mag_north)(const float Be[3]);
+	void (*update)(const struct replay_sample *sample);
+	void (*step)(const float gyros[3], const float accels[3], float dT);
+	void (*get_attitude)(float q[4]);
+};
+
+extern const struct replay_filter replay_filter_complementary;
+extern const struct replay_filter replay_filter_premerlani_dcm;
+extern const struct replay_filter replay_filter_insgps13;
+extern const struct replay_filter replay_filter_insgps14;
+extern const struct replay_filter replay_filter_insgps16;
+
+//! All the filters the harness knows about, NULL terminated
+extern const struct replay_filter * const replay_filters[];
+
+struct replay_stats {
+	uint32_t steps;
+	double cpu_time;	/* s, time spent inside the filter */
+	double max_step_time;	/* s, slowest single step */
+	uint32_t compared;	/* number of comparisons against the reference */
+	double rms_error;	/* deg, after the settle time */
+	double max_error;	/* deg, after the settle time */
+	double final_error;	/* deg */
+	double rms_tilt_error;	/* deg, roll and pitch only, after the settle time */
+	double max_tilt_error;	/* deg, roll and pitch only, after the settle time */
+	bool finite;		/* the estimate never became NaN or infinite */
+};
+
+struct replay_options {
+	double settle_time;	/* s, errors before this are not accumulated */
+	const float *Be;	/* earth magnetic field or NULL for the default */
+	FILE *trace;		/* if not NULL, a CSV trace of the run */
+};
+
+//! Drive a filter from a source until the end of the data
+void replay_run(const struct replay_filter *filter, struct replay_source *src,
+		const struct replay_options *opts, struct replay_stats *stats);
+
+//! Angle in degrees of the rotation between two attitudes
+double replay_attitude_error(const float q1[4], const float q2[4]);
+
+//! Angle in degrees between the down axes of two attitudes, i.e. ignoring yaw
+double replay_tilt_error(const float q1[4], const float q2[4]);
+
+#endif /* REPLAY_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,485 @@
+/**
+ ******************************************************************************
+ * @file       replay_filters.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup EstimatorReplay Off-target replay of the state estimators
+ * @{
+ * @brief Adapt each estimator to the common replay interface
+ *
+ * The adapters follow what the attitude module does with the filter on
+ * target (initialization, gain schedule, sensor gating) with the default
+ * values of @ref AttitudeSettings and @ref INSSettings, so the numbers here
+ * are representative of flight.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "physical_constants.h"
+#include "coordinate_conversions.h"
+#include "complementary_filter.h"
+#include "premerlani_dcm.h"
+#include "insgps.h"
+#include "insgps_variant.h"
+#include "replay.h"
+
+/* Defaults from attitudesettings.xml */
+#define ATT_MAG_KP    0.05f
+#define ATT_MAG_KI    0.0001f
+#define ATT_ACCEL_KP  0.05f
+#define ATT_ACCEL_KI  0.0001f
+#define ATT_ACCEL_TAU 0.1f
+
+/* Defaults from inssettings.xml */
+static const float ins_accel_var[3] = {0.003f, 0.003f, 0.003f};
+static const float ins_gyro_var[3] = {0.00001f, 0.00001f, 0.0001f};
+static const float ins_mag_var[3] = {10, 10, 100};
+static const float ins_gps_var[3] = {0.001f, 0.01f, 0.5f};
+static const float ins_baro_var = 0.01f;
+
+static const float zeros[3] = {0.0f, 0.0f, 0.0f};
+static const float default_Be[3] = {100.0f, 0.0f, 500.0f};
+
+//! Initial attitude from the accels and mag, as done by the attitude module
+static void initial_attitude(const float accels[3], const float mag[3], float q[4])
+{
+	float RPY[3];
+	float theta = atan2f(accels[0], -accels[2]);
+	RPY[1] = theta * RAD2DEG;
+	RPY[0] = atan2f(-accels[1], -accels[2] / cosf(theta)) * RAD2DEG;
+
+	float RPY_R[3] = {RPY[0] * DEG2RAD, RPY[1] * DEG2RAD, 0};
+	float Rbe[3][3];
+	float mag_earth_frame[3];
+	Euler2R(RPY_R, Rbe);
+	rot_mult(Rbe, mag, mag_earth_frame, true);
+	RPY[2] = atan2f(-mag_earth_frame[1], mag_earth_frame[0]) * RAD2DEG;
+
+	RPY2Quaternion(RPY, q);
+}
+
+/************************ Complementary filter *************************/
+
+static struct {
+	bool initialized;
+	float q[4];
+	float gyro_bias[3];
+	float accels_filtered[3];
+	float grot_filtered[3];
+	float accel_alpha;
+	float mag[3];
+	bool mag_valid;
+	bool mag_updated;
+	float Be[3];
+	bool have_Be;
+	float time;
+} cf;
+
+static void cf_reset(void)
+{
+	memset(&cf, 0, sizeof(cf));
+	cf.q[0] = 1;
+	cf.accel_alpha = expf(-0.0025f / ATT_ACCEL_TAU);
+}
+
+static void cf_set_mag_north(const float Be[3])
+{
+	memcpy(cf.Be, Be, sizeof(cf.Be));
+	cf.have_Be = true;
+}
+
+static void cf_update(const struct replay_sample *sample)
+{
+	if (sample->type == REPLAY_MAG) {
+		memcpy(cf.mag, sample->vec, sizeof(cf.mag));
+		cf.mag_valid = true;
+		cf.mag_updated = true;
+	}
+}
+
+static void cf_step(const float gyros_in[3], const float accels[3], float dT)
+{
+	if (!cf.initialized) {
+		const float no_mag[3] = {100, 0, 0};
+		initial_attitude(accels, cf.mag_valid ? cf.mag : no_mag, cf.q);
+		cf.initialized = true;
+		return;
+	}
+
+	cf.time += dT;
+
+	/* Gain schedule used while the filter converges after power on */
+	float accel_kp = ATT_ACCEL_KP, accel_ki = ATT_ACCEL_KI, mag_kp = ATT_MAG_KP;
+	if (cf.time > 1.0f && cf.time < 7.0f) {
+		accel_kp = 0.1f + 0.1f * (cf.time < 4.0f);
+		accel_ki = 0.1f;
+		mag_kp = 0.1f;
+	}
+
+	/* The sensors module removes the bias before the filter sees the data */
+	float gyros[3] = {
+		gyros_in[0] - cf.gyro_bias[0],
+		gyros_in[1] - cf.gyro_bias[1],
+		gyros_in[2] - cf.gyro_bias[2],
+	};
+
+	float grot[3], accel_err[3];
+	const float alpha = cf.accel_alpha;
+	for (int i = 0; i < 3; i++)
+		cf.accels_filtered[i] = cf.accels_filtered[i] * alpha + accels[i] * (1 - alpha);
+
+	cf_gravity_body(cf.q, grot);
+	for (int i = 0; i < 3; i++)
+		cf.grot_filtered[i] = cf.grot_filtered[i] * alpha + grot[i] * (1 - alpha);
+
+	cf_accel_error(cf.accels_filtered, cf.grot_filtered, true, accel_err);
+
+	float mag_err = 0;
+	if (cf.mag_updated) {
+		mag_err = cf_mag_yaw_error(cf.q, cf.mag, cf.have_Be ? cf.Be : NULL);
+		cf.mag_updated = false;
+	}
+
+	cf.gyro_bias[0] -= accel_err[0] * accel_ki;
+	cf.gyro_bias[1] -= accel_err[1] * accel_ki;
+	cf.gyro_bias[2] -= mag_err * ATT_MAG_KI;
+
+	gyros[0] += accel_err[0] * accel_kp / dT;
+	gyros[1] += accel_err[1] * accel_kp / dT;
+	gyros[2] += accel_err[2] * accel_kp / dT + mag_err * mag_kp / dT;
+
+	cf_integrate_attitude(cf.q, gyros, dT);
+}
+
+static void cf_get_attitude(float q[4])
+{
+	memcpy(q, cf.q, sizeof(cf.q));
+}
+
+const struct replay_filter replay_filter_complementary = {
+	.name = "complementary",
+	.reset = cf_reset,
+	.set_mag_north = cf_set_mag_north,
+	.update = cf_update,
+	.step = cf_step,
+	.get_attitude = cf_get_attitude,
+};
+
+/************************* Premerlani DCM ******************************/
+
+/* State the DCM library expects the attitude module to provide */
+struct GlobalDcmDriftVariables {
+	float GPSV_old[3];
+	float accels_e_integrator[3];
+	float omegaCorrI[3];
+	bool gpsPresent_flag;
+	volatile uint8_t gpsVelocityDataConsumption_flag;
+	bool magNewData_flag;
+	float accelsKp;
+	float rollPitchKp;
+	float rollPitchKi;
+	float yawKp;
+	float yawKi;
+	float gyroCalibTau;
+	float delT_between_GPS;
+};
+
+static struct GlobalDcmDriftVariables dcm_drift;
+struct GlobalDcmDriftVariables *drft = &dcm_drift;
+AttitudeSettingsData attitudeSettings;
+SensorSettingsData sensorSettings;
+GyrosBiasData gyrosBias;
+
+static struct {
+	bool initialized;
+	float q[4];
+	float mag[3];
+	bool mag_valid;
+	GlobalAttitudeVariables glbl;
+} dcm;
+
+static void dcm_reset(void)
+{
+	memset(&dcm, 0, sizeof(dcm));
+	memset(&dcm_drift, 0, sizeof(dcm_drift));
+	dcm.q[0] = 1;
+
+	dcm_drift.accelsKp = 1.0f;
+	dcm_drift.rollPitchKp = 10.0f;
+	dcm_drift.rollPitchKi = 0.5f;
+	dcm_drift.yawKp = 0;
+	dcm_drift.yawKi = 0;
+
+	dcm.glbl.yawBiasRate = 0.000001f;
+}
+
+static void dcm_set_mag_north(const float Be[3])
+{
+	(void) Be;
+}
+
+static void dcm_update(const struct replay_sample *sample)
+{
+	if (sample->type == REPLAY_MAG) {
+		memcpy(dcm.mag, sample->vec, sizeof(dcm.mag));
+		dcm.mag_valid = true;
+	}
+}
+
+static void dcm_step(const float gyros_in[3], const float accels_in[3], float dT)
+{
+	if (!dcm.initialized) {
+		const float no_mag[3] = {100, 0, 0};
+		initial_attitude(accels_in, dcm.mag_valid ? dcm.mag : no_mag, dcm.q);
+		dcm.initialized = true;
+		return;
+	}
+
+	float gyros[3] = {
+		gyros_in[0] + dcm.glbl.gyro_correct_int[0],
+		gyros_in[1] + dcm.glbl.gyro_correct_int[1],
+		gyros_in[2] + dcm.glbl.gyro_correct_int[2],
+	};
+	float accels[3] = {accels_in[0], accels_in[1], accels_in[2]};
+	float Rbe[3][3];
+	float omegaCorrP[3];
+
+	Quaternion2R(dcm.q, Rbe);
+	Premerlani_DCM(accels, gyros, Rbe, dT, false, &dcm.glbl, omegaCorrP);
+	cf_integrate_attitude(dcm.q, gyros, dT);
+}
+
+static void dcm_get_attitude(float q[4])
+{
+	memcpy(q, dcm.q, sizeof(dcm.q));
+}
+
+const struct replay_filter replay_filter_premerlani_dcm = {
+	.name = "premerlani_dcm",
+	.reset = dcm_reset,
+	.set_mag_north = dcm_set_mag_north,
+	.update = dcm_update,
+	.step = dcm_step,
+	.get_attitude = dcm_get_attitude,
+};
+
+/****************************** INSGPS *********************************/
+
+static struct {
+	const struct insgps_ops *ops;
+	enum {INS_INIT, INS_WARMUP, INS_RUNNING} state;
+	float time;
+	float init_time;
+	float indoor_pos_time;
+
+	float mag[3];
+	bool mag_updated;
+	float baro;
+	float baro_offset;
+	bool baro_updated;
+	float gps_pos[3];
+	float gps_vel[3];
+	bool gps_updated;
+	bool outdoor;
+
+	float Be[3];
+	bool have_Be;
+} ins;
+
+static void ins_reset(const struct insgps_ops *ops)
+{
+	memset(&ins, 0, sizeof(ins));
+	ins.ops = ops;
+	ins.state = INS_INIT;
+}
+
+static void ins13_reset(void) { ins_reset(&insgps13_ops); }
+static void ins14_reset(void) { ins_reset(&insgps14_ops); }
+static void ins16_reset(void) { ins_reset(&insgps16_ops); }
+
+static void ins_set_mag_north(const float Be[3])
+{
+	memcpy(ins.Be, Be, sizeof(ins.Be));
+	ins.have_Be = true;
+}
+
+static void ins_update(const struct replay_sample *sample)
+{
+	switch (sample->type) {
+	case REPLAY_MAG:
+		memcpy(ins.mag, sample->vec, sizeof(ins.mag));
+		ins.mag_updated = !(isnan(ins.mag[0]) || isnan(ins.mag[1]) || isnan(ins.mag[2]));
+		break;
+	case REPLAY_BARO:
+		ins.baro = sample->vec[0];
+		ins.baro_updated = true;
+		break;
+	case REPLAY_GPS:
+		memcpy(ins.gps_pos, sample->vec, sizeof(ins.gps_pos));
+		memcpy(ins.gps_vel, sample->vec2, sizeof(ins.gps_vel));
+		ins.gps_updated = true;
+		ins.outdoor = true;
+		break;
+	default:
+		break;
+	}
+}
+
+static void ins_step(const float gyros_in[3], const float accels_in[3], float dT)
+{
+	const struct insgps_ops *ops = ins.ops;
+
+	if (ins.state == INS_INIT) {
+		if (!ins.mag_updated || !ins.baro_updated || (ins.outdoor && !ins.gps_updated))
+			return;
+
+		ops->init();
+		ops->set_mag_var(ins_mag_var);
+		ops->set_accel_var(ins_accel_var);
+		ops->set_gyro_var(ins_gyro_var);
+		ops->set_baro_var(ins_baro_var);
+		ops->set_pos_vel_var(ins_gps_var[0], ins_gps_var[1], ins_gps_var[2]);
+		ops->set_gyro_bias(zeros);
+		ops->set_accel_bias(zeros);
+		ops->set_mag_north(ins.have_Be ? ins.Be : default_Be);
+
+		float RPY[3], q[4];
+		RPY[0] = atan2f(-accels_in[1], -accels_in[2]) * RAD2DEG;
+		RPY[1] = atan2f(accels_in[0], -accels_in[2]) * RAD2DEG;
+		RPY[2] = atan2f(-ins.mag[1], ins.mag[0]) * RAD2DEG;
+		RPY2Quaternion(RPY, q);
+
+		ins.baro_offset = -ins.baro;
+		float pos[3] = {0.0f, 0.0f, 0.0f};
+		if (ins.outdoor)
+			memcpy(pos, ins.gps_pos, sizeof(pos));
+		else
+			pos[2] = -(ins.baro + ins.baro_offset);
+		ops->set_state(pos, zeros, q, zeros, zeros);
+
+		ins.state = INS_WARMUP;
+		ins.init_time = ins.time;
+		ins.mag_updated = ins.baro_updated = ins.gps_updated = false;
+		return;
+	}
+
+	ins.time += dT;
+
+	// Keep in warmup for first 10 seconds. This zeros biases.
+	if (ins.state == INS_WARMUP && ins.time - ins.init_time > 10.0f)
+		ins.state = INS_RUNNING;
+
+	if (dT > 0.01f)
+		dT = 0.01f;
+	else if (dT <= 0.001f)
+		dT = 0.001f;
+
+	if (ins.state == INS_WARMUP) {
+		ops->set_gyro_bias(zeros);
+		ops->set_accel_bias(zeros);
+	}
+
+	float gyros[3] = {gyros_in[0] * DEG2RAD, gyros_in[1] * DEG2RAD, gyros_in[2] * DEG2RAD};
+	ops->state_prediction(gyros, accels_in, dT);
+	ops->covariance_prediction(dT);
+
+	uint16_t sensors = 0;
+	float NED[3] = {0.0f, 0.0f, 0.0f};
+	float vel[3] = {0.0f, 0.0f, 0.0f};
+
+	if (ins.mag_updated) {
+		sensors |= MAG_SENSORS;
+		ins.mag_updated = false;
+	}
+
+	if (ins.baro_updated) {
+		sensors |= BARO_SENSOR;
+		ins.baro_updated = false;
+	}
+
+	if (ins.gps_updated) {
+		sensors |= HORIZ_POS_SENSORS | HORIZ_VEL_SENSORS | VERT_VEL_SENSORS;
+		memcpy(NED, ins.gps_pos, sizeof(NED));
+		memcpy(vel, ins.gps_vel, sizeof(vel));
+		ins.gps_updated = false;
+	}
+
+	// Update fake position at 10 hz
+	if (!ins.outdoor && ins.time - ins.indoor_pos_time > 0.1f) {
+		sensors |= HORIZ_VEL_SENSORS | HORIZ_POS_SENSORS;
+		ins.indoor_pos_time = ins.time;
+		NED[2] = -(ins.baro + ins.baro_offset);
+	}
+
+	if (sensors)
+		ops->correction(ins.mag, NED, vel, ins.baro + ins.baro_offset, sensors);
+}
+
+static void ins_get_attitude(float q[4])
+{
+	if (ins.state == INS_INIT) {
+		q[0] = 1;
+		q[1] = q[2] = q[3] = 0;
+		return;
+	}
+	ins.ops->get_state(NULL, NULL, q, NULL, NULL);
+}
+
+const struct replay_filter replay_filter_insgps13 = {
+	.name = "insgps13state",
+	.reset = ins13_reset,
+	.set_mag_north = ins_set_mag_north,
+	.update = ins_update,
+	.step = ins_step,
+	.get_attitude = ins_get_attitude,
+};
+
+const struct replay_filter replay_filter_insgps14 = {
+	.name = "insgps14state",
+	.reset = ins14_reset,
+	.set_mag_north = ins_set_mag_north,
+	.update = ins_update,
+	.step = ins_step,
+	.get_attitude = ins_get_attitude,
+};
+
+const struct replay_filter replay_filter_insgps16 = {
+	.name = "insgps16state",
+	.reset = ins16_reset,
+	.set_mag_north = ins_set_mag_north,
+	.update = ins_update,
+	.step = ins_step,
+	.get_attitude = ins_get_attitude,
+};
+
+const struct replay_filter * const replay_filters[] = {
+	&replay_filter_complementary,
+	&replay_filter_premerlani_dcm,
+	&replay_filter_insgps13,
+	&replay_filter_insgps14,
+	&replay_filter_insgps16,
+	NULL
+};
+
+/**
+ * @}
+ * @}
+ */
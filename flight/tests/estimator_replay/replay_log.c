@@ -0,0 +1,349 @@
+/**
+ ******************************************************************************
+ * @file       replay_log.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup EstimatorReplay Off-target replay of the state estimators
+ * @{
+ * @brief Decode the sensor objects from a GCS log
+ *
+ * The GCS writes each received UAVTalk packet as
+ * [uint32 timestamp ms][int64 size][packet]. Only the handful of objects
+ * the estimators consume are decoded, everything else is skipped by length.
+ *
+ * The firmware headers with the object IDs are generated at build time and
+ * pull in most of the flight code, so the IDs are instead computed here from
+ * a description of the fields, the same way uavobjgenerator and
+ * python/taulabs/uavo.py do it. The fields must be listed in packed order,
+ * i.e. sorted by decreasing size as the generator does.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "replay.h"
+#include "pios_crc.h"
+
+#define UAVTALK_SYNC_VAL        0x3C
+#define UAVTALK_TYPE_MASK       0x78
+#define UAVTALK_TYPE_VER        0x20
+#define UAVTALK_TIMESTAMPED     0x80
+#define UAVTALK_TYPE_OBJ        (UAVTALK_TYPE_VER | 0x00)
+#define UAVTALK_TYPE_OBJ_ACK    (UAVTALK_TYPE_VER | 0x02)
+#define UAVTALK_MIN_HEADER_LENGTH 8
+#define UAVTALK_MAX_PACKET_LENGTH 256
+
+#define LOG_HEADER_LENGTH       12
+
+enum uavo_field_type {
+	FIELD_INT8, FIELD_INT16, FIELD_INT32, FIELD_UINT8,
+	FIELD_UINT16, FIELD_UINT32, FIELD_FLOAT, FIELD_ENUM,
+};
+
+struct uavo_field_desc {
+	const char *name;
+	enum uavo_field_type type;
+	const char *options;	/* comma separated enum options */
+};
+
+struct uavo_desc {
+	const char *name;
+	enum replay_sensor sensor;
+	uint16_t num_bytes;
+	uint8_t num_fields;
+	struct uavo_field_desc fields[12];
+	uint32_t id;		/* filled in by uavo_calculate_id() */
+};
+
+static const char gps_status_options[] = "NoGPS,NoFix,Fix2D,Fix3D,Diff3D";
+#define GPS_STATUS_FIX3D 3
+
+/* GPSVelocity is not a sensor of its own, it is merged into the GPS sample */
+#define REPLAY_GPS_VELOCITY ((enum replay_sensor) 100)
+
+static struct uavo_desc uavo_descs[] = {
+	{ "Gyros", REPLAY_GYRO, 16, 4, {
+		{ "x", FIELD_FLOAT }, { "y", FIELD_FLOAT }, { "z", FIELD_FLOAT },
+		{ "temperature", FIELD_FLOAT } } },
+	{ "Accels", REPLAY_ACCEL, 16, 4, {
+		{ "x", FIELD_FLOAT }, { "y", FIELD_FLOAT }, { "z", FIELD_FLOAT },
+		{ "temperature", FIELD_FLOAT } } },
+	{ "Magnetometer", REPLAY_MAG, 12, 3, {
+		{ "x", FIELD_FLOAT }, { "y", FIELD_FLOAT }, { "z", FIELD_FLOAT } } },
+	{ "BaroAltitude", REPLAY_BARO, 12, 3, {
+		{ "Altitude", FIELD_FLOAT }, { "Temperature", FIELD_FLOAT },
+		{ "Pressure", FIELD_FLOAT } } },
+	{ "GPSPosition", REPLAY_GPS, 42, 12, {
+		{ "Latitude", FIELD_INT32 }, { "Longitude", FIELD_INT32 },
+		{ "Altitude", FIELD_FLOAT }, { "GeoidSeparation", FIELD_FLOAT },
+		{ "Heading", FIELD_FLOAT }, { "Groundspeed", FIELD_FLOAT },
+		{ "Accuracy", FIELD_FLOAT }, { "PDOP", FIELD_FLOAT },
+		{ "HDOP", FIELD_FLOAT }, { "VDOP", FIELD_FLOAT },
+		{ "Status", FIELD_ENUM, gps_status_options },
+		{ "Satellites", FIELD_UINT8 } } },
+	{ "GPSVelocity", REPLAY_GPS_VELOCITY, 16, 4, {
+		{ "North", FIELD_FLOAT }, { "East", FIELD_FLOAT },
+		{ "Down", FIELD_FLOAT }, { "Accuracy", FIELD_FLOAT } } },
+	{ "AttitudeActual", REPLAY_REFERENCE, 28, 7, {
+		{ "q1", FIELD_FLOAT }, { "q2", FIELD_FLOAT }, { "q3", FIELD_FLOAT },
+		{ "q4", FIELD_FLOAT }, { "Roll", FIELD_FLOAT },
+		{ "Pitch", FIELD_FLOAT }, { "Yaw", FIELD_FLOAT } } },
+};
+
+struct replay_log {
+	FILE *fp;
+	uint8_t packet[UAVTALK_MAX_PACKET_LENGTH + 1];
+
+	uint32_t first_timestamp;
+	bool have_timestamp;
+
+	/* GPS is converted to NED around the first 3D fix */
+	bool have_home;
+	double home_lat, home_lon;
+	float home_alt;
+	float gps_vel[3];
+};
+
+static uint32_t uavo_update_hash(uint32_t value, uint32_t hash)
+{
+	return hash ^ ((hash << 5) + (hash >> 2) + value);
+}
+
+static uint32_t uavo_update_hash_string(const char *str, size_t len, uint32_t hash)
+{
+	for (size_t i = 0; i < len; i++)
+		hash = uavo_update_hash((uint8_t) str[i], hash);
+	return hash;
+}
+
+static void uavo_calculate_id(struct uavo_desc *desc)
+{
+	uint32_t hash = uavo_update_hash_string(desc->name, strlen(desc->name), 0);
+	hash = uavo_update_hash(0, hash);	/* not settings */
+	hash = uavo_update_hash(1, hash);	/* single instance */
+
+	for (int i = 0; i < desc->num_fields; i++) {
+		const struct uavo_field_desc *field = &desc->fields[i];
+		hash = uavo_update_hash_string(field->name, strlen(field->name), hash);
+		hash = uavo_update_hash(1, hash);	/* elements */
+		hash = uavo_update_hash(field->type, hash);
+
+		if (field->type == FIELD_ENUM) {
+			const char *option = field->options;
+			while (*option) {
+				size_t len = strcspn(option, ",");
+				hash = uavo_update_hash_string(option, len, hash);
+				option += len;
+				if (*option == ',')
+					option++;
+			}
+		}
+	}
+
+	desc->id = hash & 0xFFFFFFFE;
+}
+
+static const struct uavo_desc *uavo_find(uint32_t id)
+{
+	for (unsigned int i = 0; i < sizeof(uavo_descs) / sizeof(uavo_descs[0]); i++) {
+		if (uavo_descs[i].id == id)
+			return &uavo_descs[i];
+	}
+	return NULL;
+}
+
+static float unpack_float(const uint8_t *p)
+{
+	float f;
+	memcpy(&f, p, sizeof(f));
+	return f;
+}
+
+static int32_t unpack_int32(const uint8_t *p)
+{
+	return (int32_t) (p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24));
+}
+
+/**
+ * Convert a GPS fix to a sample in NED relative to the first 3D fix
+ * @return true if the fix is usable
+ */
+static bool decode_gps(struct replay_log *log, const uint8_t *data, struct replay_sample *sample)
+{
+	const double deg2rad = M_PI / 180.0;
+	const double earth_radius = 6378137.0;
+
+	if (data[40] < GPS_STATUS_FIX3D)
+		return false;
+
+	double lat = unpack_int32(&data[0]) * 1e-7;
+	double lon = unpack_int32(&data[4]) * 1e-7;
+	float alt = unpack_float(&data[8]) + unpack_float(&data[12]);
+
+	if (!log->have_home) {
+		log->home_lat = lat;
+		log->home_lon = lon;
+		log->home_alt = alt;
+		log->have_home = true;
+	}
+
+	sample->vec[0] = (lat - log->home_lat) * deg2rad * earth_radius;
+	sample->vec[1] = (lon - log->home_lon) * deg2rad * earth_radius * cos(log->home_lat * deg2rad);
+	sample->vec[2] = -(alt - log->home_alt);
+	memcpy(sample->vec2, log->gps_vel, sizeof(sample->vec2));
+
+	return true;
+}
+
+/**
+ * Decode a packet if it is one of the objects of interest
+ * @return true if a sample was produced
+ */
+static bool decode_packet(struct replay_log *log, const uint8_t *packet, uint16_t length,
+			  uint32_t timestamp, struct replay_sample *sample)
+{
+	uint8_t type = packet[1];
+	if ((type & ~UAVTALK_TIMESTAMPED) != UAVTALK_TYPE_OBJ &&
+	    (type & ~UAVTALK_TIMESTAMPED) != UAVTALK_TYPE_OBJ_ACK)
+		return false;
+
+	uint32_t id = (uint32_t) unpack_int32(&packet[4]);
+	const struct uavo_desc *desc = uavo_find(id);
+	if (desc == NULL)
+		return false;
+
+	uint16_t offset = UAVTALK_MIN_HEADER_LENGTH;
+	if (type & UAVTALK_TIMESTAMPED)
+		offset += 2;
+
+	if (length != offset + desc->num_bytes)
+		return false;
+
+	const uint8_t *data = &packet[offset];
+
+	if (!log->have_timestamp) {
+		log->first_timestamp = timestamp;
+		log->have_timestamp = true;
+	}
+
+	memset(sample, 0, sizeof(*sample));
+	sample->type = desc->sensor;
+	sample->time = (timestamp - log->first_timestamp) / 1000.0;
+
+	switch (desc->sensor) {
+	case REPLAY_GYRO:
+	case REPLAY_ACCEL:
+	case REPLAY_MAG:
+		for (int i = 0; i < 3; i++)
+			sample->vec[i] = unpack_float(&data[4 * i]);
+		return true;
+	case REPLAY_BARO:
+		sample->vec[0] = unpack_float(&data[0]);
+		return true;
+	case REPLAY_GPS:
+		return decode_gps(log, data, sample);
+	case REPLAY_REFERENCE:
+		for (int i = 0; i < 4; i++)
+			sample->q[i] = unpack_float(&data[4 * i]);
+		return true;
+	default:
+		if (desc->sensor == REPLAY_GPS_VELOCITY) {
+			for (int i = 0; i < 3; i++)
+				log->gps_vel[i] = unpack_float(&data[4 * i]);
+		}
+		return false;
+	}
+}
+
+static bool replay_log_next(struct replay_source *src, struct replay_sample *sample)
+{
+	struct replay_log *log = (struct replay_log *) src->priv;
+	uint8_t header[LOG_HEADER_LENGTH];
+
+	while (fread(header, sizeof(header), 1, log->fp) == 1) {
+		uint32_t timestamp = (uint32_t) unpack_int32(&header[0]);
+		int64_t size = (int64_t) ((uint32_t) unpack_int32(&header[4]) |
+				((uint64_t) (uint32_t) unpack_int32(&header[8]) << 32));
+
+		if (size <= 0 || size > (int64_t) sizeof(log->packet)) {
+			/* Not something we can decode, skip it */
+			if (size < 0 || fseek(log->fp, size, SEEK_CUR) != 0)
+				return false;
+			continue;
+		}
+
+		if (fread(log->packet, size, 1, log->fp) != 1)
+			return false;
+
+		const uint8_t *packet = log->packet;
+		if (size < UAVTALK_MIN_HEADER_LENGTH + 1 || packet[0] != UAVTALK_SYNC_VAL ||
+		    (packet[1] & UAVTALK_TYPE_MASK) != UAVTALK_TYPE_VER)
+			continue;
+
+		uint16_t length = packet[2] | (packet[3] << 8);
+		if (length + 1 > size)
+			continue;
+
+		if (PIOS_CRC_updateCRC(0, packet, length) != packet[length])
+			continue;
+
+		if (decode_packet(log, packet, length, timestamp, sample))
+			return true;
+	}
+
+	return false;
+}
+
+static void replay_log_close(struct replay_source *src)
+{
+	struct replay_log *log = (struct replay_log *) src->priv;
+
+	fclose(log->fp);
+	free(log);
+	src->priv = NULL;
+}
+
+bool replay_log_open(struct replay_source *src, const char *filename)
+{
+	FILE *fp = fopen(filename, "rb");
+	if (fp == NULL)
+		return false;
+
+	struct replay_log *log = (struct replay_log *) calloc(1, sizeof(*log));
+	if (log == NULL) {
+		fclose(fp);
+		return false;
+	}
+	log->fp = fp;
+
+	for (unsigned int i = 0; i < sizeof(uavo_descs) / sizeof(uavo_descs[0]); i++)
+		uavo_calculate_id(&uavo_descs[i]);
+
+	src->next = replay_log_next;
+	src->close = replay_log_close;
+	src->priv = log;
+
+	return true;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,174 @@
+/**
+ ******************************************************************************
+ * @file       replay_run.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup EstimatorReplay Off-target replay of the state estimators
+ * @{
+ * @brief Drive an estimator from a source and score it
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "replay.h"
+
+static double cpu_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+double replay_attitude_error(const float q1[4], const float q2[4])
+{
+	double dot = (double) q1[0] * q2[0] + (double) q1[1] * q2[1] +
+		     (double) q1[2] * q2[2] + (double) q1[3] * q2[3];
+	double n1 = sqrt((double) q1[0] * q1[0] + (double) q1[1] * q1[1] +
+			 (double) q1[2] * q1[2] + (double) q1[3] * q1[3]);
+	double n2 = sqrt((double) q2[0] * q2[0] + (double) q2[1] * q2[1] +
+			 (double) q2[2] * q2[2] + (double) q2[3] * q2[3]);
+
+	dot = fabs(dot / (n1 * n2));
+	if (dot > 1)
+		dot = 1;
+
+	return 2 * acos(dot) * 180.0 / M_PI;
+}
+
+static void down_in_body(const float q[4], double down[3])
+{
+	down[0] = 2.0 * (q[1] * q[3] - q[0] * q[2]);
+	down[1] = 2.0 * (q[2] * q[3] + q[0] * q[1]);
+	down[2] = (double) q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3];
+}
+
+double replay_tilt_error(const float q1[4], const float q2[4])
+{
+	double d1[3], d2[3];
+	down_in_body(q1, d1);
+	down_in_body(q2, d2);
+
+	double dot = d1[0] * d2[0] + d1[1] * d2[1] + d1[2] * d2[2];
+	double n1 = sqrt(d1[0] * d1[0] + d1[1] * d1[1] + d1[2] * d1[2]);
+	double n2 = sqrt(d2[0] * d2[0] + d2[1] * d2[1] + d2[2] * d2[2]);
+
+	dot /= n1 * n2;
+	if (dot > 1)
+		dot = 1;
+	else if (dot < -1)
+		dot = -1;
+
+	return acos(dot) * 180.0 / M_PI;
+}
+
+void replay_run(const struct replay_filter *filter, struct replay_source *src,
+		const struct replay_options *opts, struct replay_stats *stats)
+{
+	struct replay_sample sample;
+	float accels[3] = {0, 0, 0};
+	bool have_accels = false;
+	double last_gyro_time = 0;
+	bool have_gyro = false;
+	double sum_sq = 0, sum_sq_tilt = 0;
+
+	memset(stats, 0, sizeof(*stats));
+	stats->finite = true;
+
+	filter->reset();
+	if (opts->Be)
+		filter->set_mag_north(opts->Be);
+
+	if (opts->trace)
+		fprintf(opts->trace, "time,q1,q2,q3,q4,ref_q1,ref_q2,ref_q3,ref_q4,error\n");
+
+	while (src->next(src, &sample)) {
+		switch (sample.type) {
+		case REPLAY_ACCEL:
+			memcpy(accels, sample.vec, sizeof(accels));
+			have_accels = true;
+			break;
+		case REPLAY_GYRO:
+		{
+			if (!have_accels)
+				break;
+
+			float dT = have_gyro ? (float) (sample.time - last_gyro_time) : 0.002f;
+			last_gyro_time = sample.time;
+			have_gyro = true;
+
+			/* Logs can contain gaps and duplicate timestamps */
+			if (dT <= 0)
+				break;
+
+			double start = cpu_time();
+			filter->step(sample.vec, accels, dT);
+			double elapsed = cpu_time() - start;
+
+			stats->steps++;
+			stats->cpu_time += elapsed;
+			if (elapsed > stats->max_step_time)
+				stats->max_step_time = elapsed;
+			break;
+		}
+		case REPLAY_REFERENCE:
+		{
+			float q[4];
+			filter->get_attitude(q);
+
+			if (!(isfinite(q[0]) && isfinite(q[1]) && isfinite(q[2]) && isfinite(q[3])))
+				stats->finite = false;
+
+			double error = replay_attitude_error(q, sample.q);
+			double tilt_error = replay_tilt_error(q, sample.q);
+			stats->final_error = error;
+
+			if (sample.time >= opts->settle_time) {
+				stats->compared++;
+				sum_sq += error * error;
+				sum_sq_tilt += tilt_error * tilt_error;
+				if (error > stats->max_error)
+					stats->max_error = error;
+				if (tilt_error > stats->max_tilt_error)
+					stats->max_tilt_error = tilt_error;
+			}
+
+			if (opts->trace)
+				fprintf(opts->trace, "%f,%f,%f,%f,%f,%f,%f,%f,%f,%f\n", sample.time,
+					q[0], q[1], q[2], q[3],
+					sample.q[0], sample.q[1], sample.q[2], sample.q[3], error);
+			break;
+		}
+		default:
+			filter->update(&sample);
+			break;
+		}
+	}
+
+	if (stats->compared) {
+		stats->rms_error = sqrt(sum_sq / stats->compared);
+		stats->rms_tilt_error = sqrt(sum_sq_tilt / stats->compared);
+	}
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,250 @@
+/**
+ ******************************************************************************
+ * @file       replay_sim.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup EstimatorReplay Off-target replay of the state estimators
+ * @{
+ * @brief Synthetic sensor data from a known trajectory
+ *
+ * The vehicle hovers in place while rotating with smooth sinusoidal body
+ * rates. The truth is propagated in double precision with sub-steps and
+ * emitted as the reference, so the estimators can be scored without a log.
+ * The noise is generated from a seeded PRNG so runs are reproducible.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "physical_constants.h"
+#include "replay.h"
+
+#define SIM_SUBSTEPS 8
+
+struct replay_sim {
+	struct replay_sim_config cfg;
+
+	double q[4];		/* true attitude */
+	double time;		/* time of the last gyro sample */
+	uint32_t gyro_count;
+	uint32_t mag_count, baro_count, gps_count;
+
+	/* Samples generated together are queued and handed out in order */
+	struct replay_sample pending[6];
+	int num_pending, next_pending;
+
+	uint32_t rng;
+};
+
+static double sim_uniform(struct replay_sim *sim)
+{
+	/* xorshift32 */
+	sim->rng ^= sim->rng << 13;
+	sim->rng ^= sim->rng >> 17;
+	sim->rng ^= sim->rng << 5;
+	return (sim->rng + 1.0) / 4294967297.0;
+}
+
+static float sim_gauss(struct replay_sim *sim, float sigma)
+{
+	double u1 = sim_uniform(sim);
+	double u2 = sim_uniform(sim);
+	return sigma * sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+}
+
+//! True body rates in deg/s
+static void sim_rates(double t, double w[3])
+{
+	w[0] = 60.0 * sin(2 * M_PI * 0.30 * t);
+	w[1] = 40.0 * sin(2 * M_PI * 0.20 * t + 1.0);
+	w[2] = 20.0 * sin(2 * M_PI * 0.05 * t) + 5.0;
+}
+
+static void sim_propagate(struct replay_sim *sim, double t0, double dT)
+{
+	double h = dT / SIM_SUBSTEPS;
+	double *q = sim->q;
+
+	for (int i = 0; i < SIM_SUBSTEPS; i++) {
+		double w[3];
+		sim_rates(t0 + (i + 0.5) * h, w);
+
+		double wx = w[0] * DEG2RAD, wy = w[1] * DEG2RAD, wz = w[2] * DEG2RAD;
+		double mag = sqrt(wx * wx + wy * wy + wz * wz);
+		double c = cos(mag * h / 2);
+		double s = (mag > 1e-12) ? sin(mag * h / 2) / mag : h / 2;
+
+		/* q = q * [c, s*w] */
+		double dq[4] = { c, s * wx, s * wy, s * wz };
+		double qn[4];
+		qn[0] = q[0] * dq[0] - q[1] * dq[1] - q[2] * dq[2] - q[3] * dq[3];
+		qn[1] = q[0] * dq[1] + q[1] * dq[0] + q[2] * dq[3] - q[3] * dq[2];
+		qn[2] = q[0] * dq[2] - q[1] * dq[3] + q[2] * dq[0] + q[3] * dq[1];
+		qn[3] = q[0] * dq[3] + q[1] * dq[2] - q[2] * dq[1] + q[3] * dq[0];
+
+		double norm = sqrt(qn[0] * qn[0] + qn[1] * qn[1] + qn[2] * qn[2] + qn[3] * qn[3]);
+		for (int j = 0; j < 4; j++)
+			q[j] = qn[j] / norm;
+	}
+}
+
+//! Rotate a vector from the earth frame into the body frame
+static void sim_earth_to_body(const double q[4], const float e[3], float b[3])
+{
+	double q0s = q[0] * q[0], q1s = q[1] * q[1], q2s = q[2] * q[2], q3s = q[3] * q[3];
+	double R[3][3] = {
+		{ q0s + q1s - q2s - q3s, 2 * (q[1] * q[2] + q[0] * q[3]), 2 * (q[1] * q[3] - q[0] * q[2]) },
+		{ 2 * (q[1] * q[2] - q[0] * q[3]), q0s - q1s + q2s - q3s, 2 * (q[2] * q[3] + q[0] * q[1]) },
+		{ 2 * (q[1] * q[3] + q[0] * q[2]), 2 * (q[2] * q[3] - q[0] * q[1]), q0s - q1s - q2s + q3s },
+	};
+
+	for (int i = 0; i < 3; i++)
+		b[i] = R[i][0] * e[0] + R[i][1] * e[1] + R[i][2] * e[2];
+}
+
+static struct replay_sample *sim_push(struct replay_sim *sim, enum replay_sensor type)
+{
+	struct replay_sample *sample = &sim->pending[sim->num_pending++];
+	memset(sample, 0, sizeof(*sample));
+	sample->type = type;
+	sample->time = sim->time;
+	return sample;
+}
+
+static void sim_generate(struct replay_sim *sim)
+{
+	const struct replay_sim_config *cfg = &sim->cfg;
+	double dT = 1.0 / cfg->gyro_rate;
+
+	sim->num_pending = 0;
+	sim->next_pending = 0;
+
+	if (sim->gyro_count > 0)
+		sim_propagate(sim, sim->time, dT);
+	sim->time = sim->gyro_count * dT;
+
+	struct replay_sample *sample;
+	double w[3];
+	sim_rates(sim->time, w);
+
+	/* Accels first so the filter steps on the gyro with a fresh accel */
+	const float gravity[3] = { 0, 0, -GRAVITY };
+	sample = sim_push(sim, REPLAY_ACCEL);
+	sim_earth_to_body(sim->q, gravity, sample->vec);
+	for (int i = 0; i < 3; i++)
+		sample->vec[i] += sim_gauss(sim, cfg->accel_noise);
+
+	if (sim->time * cfg->mag_rate >= sim->mag_count) {
+		sample = sim_push(sim, REPLAY_MAG);
+		sim_earth_to_body(sim->q, cfg->Be, sample->vec);
+		for (int i = 0; i < 3; i++)
+			sample->vec[i] += sim_gauss(sim, cfg->mag_noise);
+		sim->mag_count++;
+	}
+
+	if (sim->time * cfg->baro_rate >= sim->baro_count) {
+		sample = sim_push(sim, REPLAY_BARO);
+		sample->vec[0] = sim_gauss(sim, cfg->baro_noise);
+		sim->baro_count++;
+	}
+
+	if (cfg->gps_rate > 0 && sim->time * cfg->gps_rate >= sim->gps_count) {
+		sample = sim_push(sim, REPLAY_GPS);
+		sim->gps_count++;
+	}
+
+	sample = sim_push(sim, REPLAY_GYRO);
+	for (int i = 0; i < 3; i++)
+		sample->vec[i] = w[i] + cfg->gyro_bias[i] + sim_gauss(sim, cfg->gyro_noise);
+
+	sample = sim_push(sim, REPLAY_REFERENCE);
+	for (int i = 0; i < 4; i++)
+		sample->q[i] = sim->q[i];
+
+	sim->gyro_count++;
+}
+
+static bool replay_sim_next(struct replay_source *src, struct replay_sample *sample)
+{
+	struct replay_sim *sim = (struct replay_sim *) src->priv;
+
+	if (sim->next_pending >= sim->num_pending) {
+		if (sim->gyro_count >= sim->cfg.duration * sim->cfg.gyro_rate)
+			return false;
+		sim_generate(sim);
+	}
+
+	*sample = sim->pending[sim->next_pending++];
+	return true;
+}
+
+static void replay_sim_close(struct replay_source *src)
+{
+	free(src->priv);
+	src->priv = NULL;
+}
+
+void replay_sim_default_config(struct replay_sim_config *cfg)
+{
+	memset(cfg, 0, sizeof(*cfg));
+
+	cfg->duration = 60;
+	cfg->gyro_rate = 500;
+	cfg->mag_rate = 75;
+	cfg->baro_rate = 40;
+	cfg->gps_rate = 0;
+
+	cfg->gyro_bias[0] = 0.5f;
+	cfg->gyro_bias[1] = -0.3f;
+	cfg->gyro_bias[2] = 0.2f;
+
+	cfg->gyro_noise = 0.1f;
+	cfg->accel_noise = 0.05f;
+	cfg->mag_noise = 2.0f;
+	cfg->baro_noise = 0.1f;
+
+	cfg->Be[0] = 200.0f;
+	cfg->Be[1] = 20.0f;
+	cfg->Be[2] = 450.0f;
+
+	cfg->seed = 0x5eed1e55;
+}
+
+bool replay_sim_open(struct replay_source *src, const struct replay_sim_config *cfg)
+{
+	struct replay_sim *sim = (struct replay_sim *) calloc(1, sizeof(*sim));
+	if (sim == NULL)
+		return false;
+
+	sim->cfg = *cfg;
+	sim->q[0] = 1;
+	sim->rng = cfg->seed ? cfg->seed : 1;
+
+	src->next = replay_sim_next;
+	src->close = replay_sim_close;
+	src->priv = sim;
+
+	return true;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,5 @@
+/* Only the type is referenced by the estimators */
+typedef struct {
+	float AccelBias[3];
+	float AccelScale[3];
+} SensorSettingsData;
@@ -0,0 +1,206 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Replay sensor data through the state estimators
+ *
+ * By default every estimator is run against a synthetic flight with a
+ * known truth. To replay a flight log instead set ESTIMATOR_REPLAY_LOG to
+ * the path of a GCS .tll log; the filters are then compared against the
+ * AttitudeActual recorded in the log. When ESTIMATOR_REPLAY_TRACE_DIR is
+ * set a CSV trace of each run is written there.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* getenv */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <math.h>		/* sqrt */
+#include <string>
+
+extern "C" {
+
+#include "replay.h"
+
+}
+
+static FILE *open_trace(const char *source, const struct replay_filter *filter)
+{
+	const char *dir = getenv("ESTIMATOR_REPLAY_TRACE_DIR");
+	if (dir == NULL)
+		return NULL;
+
+	std::string path = std::string(dir) + "/" + source + "_" + filter->name + ".csv";
+	return fopen(path.c_str(), "w");
+}
+
+static void print_stats(const char *source, const struct replay_filter *filter,
+			const struct replay_stats *stats)
+{
+	printf("%-8s %-16s %8u steps %8.3f us/step (max %8.3f us) "
+	       "error rms %7.3f max %7.3f final %7.3f tilt rms %7.3f max %7.3f deg\n",
+	       source, filter->name, stats->steps,
+	       stats->steps ? stats->cpu_time / stats->steps * 1e6 : 0.0,
+	       stats->max_step_time * 1e6,
+	       stats->rms_error, stats->max_error, stats->final_error,
+	       stats->rms_tilt_error, stats->max_tilt_error);
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class EstimatorReplay : public testing::Test {
+protected:
+  virtual void SetUp() {
+    replay_sim_default_config(&cfg);
+    memset(&opts, 0, sizeof(opts));
+    opts.settle_time = 20;
+    opts.Be = cfg.Be;
+  }
+
+  virtual void TearDown() {
+  }
+
+  void run_sim(const struct replay_filter *filter, struct replay_stats *stats) {
+    struct replay_source src;
+    ASSERT_TRUE(replay_sim_open(&src, &cfg));
+    opts.trace = open_trace("sim", filter);
+    replay_run(filter, &src, &opts, stats);
+    if (opts.trace)
+      fclose(opts.trace);
+    src.close(&src);
+    print_stats("sim", filter, stats);
+  }
+
+  struct replay_sim_config cfg;
+  struct replay_options opts;
+};
+
+TEST_F(EstimatorReplay, ErrorMetrics) {
+  const float identity[4] = {1, 0, 0, 0};
+  /* 90 deg of yaw */
+  const float yawed[4] = {(float) sqrt(0.5), 0, 0, (float) sqrt(0.5)};
+  /* 90 deg of roll */
+  const float rolled[4] = {(float) sqrt(0.5), (float) sqrt(0.5), 0, 0};
+
+  EXPECT_NEAR(0, replay_attitude_error(identity, identity), 1e-3);
+  EXPECT_NEAR(90, replay_attitude_error(identity, yawed), 1e-3);
+  EXPECT_NEAR(0, replay_tilt_error(identity, yawed), 1e-3);
+  EXPECT_NEAR(90, replay_tilt_error(identity, rolled), 1e-3);
+};
+
+TEST_F(EstimatorReplay, SimIsReproducible) {
+  struct replay_stats first, second;
+
+  cfg.duration = 5;
+  run_sim(&replay_filter_insgps14, &first);
+  run_sim(&replay_filter_insgps14, &second);
+
+  EXPECT_EQ(first.steps, second.steps);
+  EXPECT_EQ(first.compared, second.compared);
+  EXPECT_EQ(first.final_error, second.final_error);
+};
+
+TEST_F(EstimatorReplay, Complementary) {
+  struct replay_stats stats;
+  run_sim(&replay_filter_complementary, &stats);
+
+  EXPECT_TRUE(stats.finite);
+  EXPECT_EQ(cfg.duration * cfg.gyro_rate, stats.steps);
+  EXPECT_LT(stats.rms_tilt_error, 5);
+  EXPECT_LT(stats.rms_error, 10);
+};
+
+TEST_F(EstimatorReplay, PremerlaniDCM) {
+  struct replay_stats stats;
+  run_sim(&replay_filter_premerlani_dcm, &stats);
+
+  /* Yaw is not corrected without the magnetometer support, so only check tilt */
+  EXPECT_TRUE(stats.finite);
+  EXPECT_LT(stats.rms_tilt_error, 10);
+};
+
+TEST_F(EstimatorReplay, INSGPS13) {
+  struct replay_stats stats;
+  run_sim(&replay_filter_insgps13, &stats);
+
+  EXPECT_TRUE(stats.finite);
+  EXPECT_LT(stats.rms_tilt_error, 5);
+  EXPECT_LT(stats.rms_error, 10);
+};
+
+TEST_F(EstimatorReplay, INSGPS14) {
+  struct replay_stats stats;
+  run_sim(&replay_filter_insgps14, &stats);
+
+  EXPECT_TRUE(stats.finite);
+  EXPECT_LT(stats.rms_tilt_error, 5);
+  EXPECT_LT(stats.rms_error, 10);
+};
+
+TEST_F(EstimatorReplay, INSGPS16) {
+  struct replay_stats stats;
+  run_sim(&replay_filter_insgps16, &stats);
+
+  EXPECT_TRUE(stats.finite);
+  EXPECT_LT(stats.rms_tilt_error, 5);
+  EXPECT_LT(stats.rms_error, 10);
+};
+
+TEST_F(EstimatorReplay, FlightLog) {
+  const char *filename = getenv("ESTIMATOR_REPLAY_LOG");
+  if (filename == NULL) {
+    printf("ESTIMATOR_REPLAY_LOG not set, skipping\n");
+    return;
+  }
+
+  /* The field at the flying site is not known from the log */
+  opts.Be = NULL;
+  opts.settle_time = 0;
+
+  for (int i = 0; replay_filters[i] != NULL; i++) {
+    struct replay_source src;
+    struct replay_stats stats;
+
+    ASSERT_TRUE(replay_log_open(&src, filename));
+    opts.trace = open_trace("log", replay_filters[i]);
+    replay_run(replay_filters[i], &src, &opts, &stats);
+    if (opts.trace)
+      fclose(opts.trace);
+    src.close(&src);
+
+    print_stats("log", replay_filters[i], &stats);
+    EXPECT_GT(stats.steps, 0u);
+  }
+};
+
+/**
+ * @}
+ * @}
+ */
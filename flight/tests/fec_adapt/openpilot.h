@@ -0,0 +1,2 @@
+#define RS_ECC_NPARITY 4
+#define RS_ECC_MAX_NPARITY 12
@@ -0,0 +1,332 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test of the RFM22B link adaptation over a simulated channel
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+
+#include "fec_adapt.h"
+
+}
+
+/* Longest packet of the RFM22B and the preamble, sync, header and length around it */
+#define MAX_PACKET_LEN 64
+#define AIR_OVERHEAD 15
+
+/* Small reproducible random source */
+static uint32_t rand_next(uint32_t *state)
+{
+  *state = *state * 1664525u + 1013904223u;
+  return *state >> 8;
+}
+
+/* Probability p in [0, 1] */
+static bool rand_chance(uint32_t *state, double p)
+{
+  return rand_next(state) < p * (1 << 24);
+}
+
+/*
+ * Channel that corrupts each byte with a given probability. Every so
+ * often it fades for a while, and then the probability is much higher.
+ */
+struct channel {
+  double byte_error;
+  double fade_byte_error;
+  double fade_chance;	/* per packet */
+  int fade_packets;
+  int fading;
+  uint32_t seed;
+};
+
+static void channel_send(struct channel *ch, uint8_t *packet, uint8_t len)
+{
+  if (ch->fading > 0)
+    ch->fading--;
+  else if (rand_chance(&ch->seed, ch->fade_chance))
+    ch->fading = ch->fade_packets;
+
+  double p = ch->fading ? ch->fade_byte_error : ch->byte_error;
+  for (uint8_t i = 0; i < len; i++) {
+    if (rand_chance(&ch->seed, p))
+      packet[i] ^= 1 + rand_next(&ch->seed) % 255;
+  }
+}
+
+struct link_result {
+  double goodput;	/* payload delivered per byte of airtime */
+  double lost;		/* share of the packets lost */
+  double mean_parity;
+  double miscorrected;	/* share of the packets decoded to the wrong data */
+};
+
+/*
+ * Two modems take turns sending full packets over the same channel. Each
+ * picks its level from the packets it receives, unless fixed_level is
+ * set, which is how the link worked before it adapted.
+ */
+static struct link_result run_link(struct channel *ch, int packets, int fixed_level)
+{
+  struct fec_adapt ends[2];
+  uint32_t payload_seed = 7;
+  long airtime = 0, delivered = 0, lost = 0, parity = 0, miscorrected = 0;
+
+  EXPECT_TRUE(fec_adapt_init(&ends[0], MAX_PACKET_LEN));
+  EXPECT_TRUE(fec_adapt_init(&ends[1], MAX_PACKET_LEN));
+
+  for (int i = 0; i < packets; i++) {
+    struct fec_adapt *tx = &ends[i & 1], *rx = &ends[!(i & 1)];
+    if (fixed_level >= 0)
+      tx->level = fixed_level;
+
+    uint8_t sent[MAX_PACKET_LEN], packet[MAX_PACKET_LEN];
+    uint8_t payload_len = fec_adapt_max_payload(tx);
+    for (int j = 0; j < payload_len; j++)
+      sent[FEC_ADAPT_HEADER_LEN + j] = rand_next(&payload_seed);
+    uint8_t len = fec_adapt_encode(tx, sent, payload_len);
+    parity += fec_adapt_parity(tx);
+
+    memcpy(packet, sent, len);
+    channel_send(ch, packet, len);
+    airtime += len + AIR_OVERHEAD;
+
+    /*
+     * Too many errors are sometimes corrected to another codeword. The
+     * CRC of the packet handler drops those, so they count as lost.
+     */
+    uint8_t rx_len;
+    if (fec_adapt_decode(rx, packet, len, &rx_len) < 0) {
+      lost++;
+    } else if (rx_len != payload_len || memcmp(sent, packet, len) != 0) {
+      miscorrected++;
+      lost++;
+    } else {
+      delivered += rx_len;
+    }
+  }
+
+  struct link_result result;
+  result.goodput = (double) delivered / airtime;
+  result.lost = (double) lost / packets;
+  result.mean_parity = (double) parity / packets;
+  result.miscorrected = (double) miscorrected / packets;
+  return result;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class FecAdapt : public testing::Test {
+protected:
+  virtual void SetUp() {
+    seed = 1;
+    memset(&ch, 0, sizeof(ch));
+    ch.seed = 42;
+    ASSERT_TRUE(fec_adapt_init(&fa, MAX_PACKET_LEN));
+  }
+
+  virtual void TearDown() {
+  }
+
+  /* Receive a packet of the current level with a number of bytes corrupted */
+  int receive_with_errors(int nerrors) {
+    uint8_t packet[MAX_PACKET_LEN];
+    uint8_t payload_len = fec_adapt_max_payload(&fa);
+    memset(packet, 0xa5, sizeof(packet));
+    uint8_t len = fec_adapt_encode(&fa, packet, payload_len);
+    for (int e = 0; e < nerrors; e++)
+      packet[1 + (e * 7) % (len - 1)] ^= 0x3c;
+    uint8_t rx_len;
+    return fec_adapt_decode(&fa, packet, len, &rx_len);
+  }
+
+  struct fec_adapt fa;
+  struct channel ch;
+  uint32_t seed;
+};
+
+TEST_F(FecAdapt, RoundTripEveryLevel) {
+  EXPECT_EQ(FEC_ADAPT_DEFAULT_LEVEL, fa.level);
+  EXPECT_EQ(FEC_ADAPT_NUM_LEVELS - 1, fa.max_level);
+
+  uint8_t last_payload = MAX_PACKET_LEN;
+  for (uint8_t level = 0; level < FEC_ADAPT_NUM_LEVELS; level++) {
+    fa.level = level;
+    uint8_t payload_len = fec_adapt_max_payload(&fa);
+    EXPECT_LE(payload_len, last_payload);
+    last_payload = payload_len;
+
+    uint8_t sent[MAX_PACKET_LEN], packet[MAX_PACKET_LEN];
+    for (int j = 0; j < payload_len; j++)
+      sent[FEC_ADAPT_HEADER_LEN + j] = rand_next(&seed);
+    uint8_t len = fec_adapt_encode(&fa, sent, payload_len);
+    EXPECT_LE(len, MAX_PACKET_LEN);
+    EXPECT_EQ(FEC_ADAPT_HEADER_LEN + payload_len + fec_adapt_parity(&fa), len);
+
+    // Up to half the parity in errors, anywhere including the level byte
+    int nerrors = fec_adapt_parity(&fa) / 2;
+    memcpy(packet, sent, len);
+    packet[0] ^= 0x81;
+    for (int e = 1; e < nerrors; e++)
+      packet[(e * 11) % len] ^= 0x5a;
+
+    // The receiver doesn't need to be at the same level
+    struct fec_adapt receiver;
+    fec_adapt_init(&receiver, MAX_PACKET_LEN);
+    uint8_t rx_len = 0;
+    EXPECT_EQ(nerrors, fec_adapt_decode(&receiver, packet, len, &rx_len)) << "level " << (int) level;
+    EXPECT_EQ(payload_len, rx_len);
+    EXPECT_EQ(0, memcmp(sent, packet, len));
+  }
+};
+
+TEST_F(FecAdapt, RejectsUnknownLevel) {
+  uint8_t packet[MAX_PACKET_LEN] = {};
+  uint8_t len = fec_adapt_encode(&fa, packet, 10);
+  uint8_t rx_len;
+
+  // Three bits off is too far from any level
+  packet[0] ^= 0x0b;
+  EXPECT_EQ(-1, fec_adapt_decode(&fa, packet, len, &rx_len));
+
+  // Too short for the parity of its level
+  packet[0] ^= 0x0b;
+  EXPECT_EQ(-1, fec_adapt_decode(&fa, packet, 3, &rx_len));
+};
+
+TEST_F(FecAdapt, ShortPacketsLimitTheLevel) {
+  ASSERT_TRUE(fec_adapt_init(&fa, 20));
+  EXPECT_LT(fa.max_level, FEC_ADAPT_NUM_LEVELS - 1);
+
+  fec_adapt_link_quality(&fa, 0);
+  EXPECT_EQ(fa.max_level, fa.level);
+  EXPECT_GE(fec_adapt_max_payload(&fa), 7);
+
+  EXPECT_FALSE(fec_adapt_init(&fa, 3));
+};
+
+TEST_F(FecAdapt, FollowsTheErrors) {
+  // Errors above half the capacity raise the level
+  for (int i = 0; i < 20; i++)
+    EXPECT_LE(0, receive_with_errors(fec_adapt_parity(&fa) / 2));
+  EXPECT_EQ(FEC_ADAPT_NUM_LEVELS - 1, fa.level);
+
+  // and it comes down one level at a time once the link is clean
+  int packets = 0;
+  while (fa.level > 0 && packets < 1000) {
+    uint8_t level = fa.level;
+    EXPECT_EQ(0, receive_with_errors(0));
+    packets++;
+    EXPECT_GE(fa.level + 1, level);
+  }
+  EXPECT_EQ(0, fa.level);
+  EXPECT_LE(packets, 200);
+
+  // Lost packets raise it too
+  for (int i = 0; i < 8; i++)
+    fec_adapt_lost(&fa);
+  EXPECT_GT(fa.level, 0);
+};
+
+TEST_F(FecAdapt, LinkQualityFloor) {
+  fec_adapt_link_quality(&fa, 20);
+  EXPECT_EQ(3, fa.level);
+
+  // Clean packets can't take it below the floor
+  for (int i = 0; i < 200; i++)
+    receive_with_errors(0);
+  EXPECT_EQ(3, fa.level);
+
+  fec_adapt_link_quality(&fa, 50);
+  for (int i = 0; i < 200; i++)
+    receive_with_errors(0);
+  EXPECT_EQ(2, fa.level);
+
+  fec_adapt_link_quality(&fa, 128);
+  for (int i = 0; i < 200; i++)
+    receive_with_errors(0);
+  EXPECT_EQ(0, fa.level);
+};
+
+TEST_F(FecAdapt, SimulatedChannel) {
+  const double byte_errors[] = {0, 0.001, 0.005, 0.01, 0.02, 0.03, 0.05};
+  const int packets = 20000;
+
+  printf("byte error   fixed goodput/lost     adaptive goodput/lost/parity\n");
+  for (unsigned j = 0; j < sizeof(byte_errors) / sizeof(byte_errors[0]); j++) {
+    ch.byte_error = byte_errors[j];
+    ch.seed = 42;
+    struct link_result fixed = run_link(&ch, packets, FEC_ADAPT_DEFAULT_LEVEL);
+    ch.seed = 42;
+    struct link_result adaptive = run_link(&ch, packets, -1);
+
+    printf("  %.3f      %.3f / %5.1f%%         %.3f / %5.1f%% / %.1f\n", byte_errors[j],
+           fixed.goodput, fixed.lost * 100, adaptive.goodput, adaptive.lost * 100, adaptive.mean_parity);
+
+    // Never much worse than the fixed scheme, and better at both ends
+    EXPECT_GT(adaptive.goodput, 0.97 * fixed.goodput) << byte_errors[j];
+    EXPECT_LT(adaptive.miscorrected, 0.01) << byte_errors[j];
+    if (byte_errors[j] == 0) {
+      EXPECT_GT(adaptive.goodput, fixed.goodput);
+    }
+    if (byte_errors[j] >= 0.03) {
+      EXPECT_GT(adaptive.goodput, 1.15 * fixed.goodput) << byte_errors[j];
+    }
+  }
+};
+
+TEST_F(FecAdapt, SimulatedFades) {
+  // A clean link that fades for a few packets now and then
+  ch.byte_error = 0.0005;
+  ch.fade_byte_error = 0.04;
+  ch.fade_chance = 0.01;
+  ch.fade_packets = 60;
+
+  ch.seed = 42;
+  struct link_result fixed = run_link(&ch, 20000, FEC_ADAPT_DEFAULT_LEVEL);
+  ch.seed = 42;
+  struct link_result adaptive = run_link(&ch, 20000, -1);
+
+  printf("fades: fixed %.3f / %.1f%% lost, adaptive %.3f / %.1f%% lost\n",
+         fixed.goodput, fixed.lost * 100, adaptive.goodput, adaptive.lost * 100);
+  EXPECT_GT(adaptive.goodput, fixed.goodput);
+  EXPECT_LT(adaptive.lost, fixed.lost);
+};
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,14 @@
+/* C Lib Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PIOS_Assert(x) if (!(x)) { while (1) ; }
+
+#define NELEMENTS(x) (sizeof(x) / sizeof(*(x)))
+
+#include <pios_heap.h>
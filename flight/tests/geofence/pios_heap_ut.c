@@ -0,0 +1,11 @@
+#include "pios.h"
+
+void * PIOS_malloc(size_t size)
+{
+	return malloc(size);
+}
+
+void PIOS_free(void * buf)
+{
+	free(buf);
+}
@@ -0,0 +1,319 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Check the polygon geofence against a brute force reference
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* rand */
+#include <math.h>		/* sqrtf */
+#include <time.h>		/* clock_gettime */
+#include <vector>
+
+extern "C" {
+
+#include "geofence_polygon.h"
+
+}
+
+static double cpu_time(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+struct vertex {
+  float ne[2];
+};
+
+/* The plain point in polygon test the index must agree with */
+static bool naive_inside(const std::vector<vertex> &poly, const float *p)
+{
+  bool inside = false;
+  for (size_t i = 0, j = poly.size() - 1; i < poly.size(); j = i++) {
+    const float *a = poly[i].ne, *b = poly[j].ne;
+    if ((a[1] > p[1]) != (b[1] > p[1]) &&
+        p[0] < a[0] + (p[1] - a[1]) * (b[0] - a[0]) / (b[1] - a[1]))
+      inside = !inside;
+  }
+  return inside;
+}
+
+static float naive_distance(const std::vector<vertex> &poly, const float *p)
+{
+  float best = INFINITY;
+  for (size_t i = 0, j = poly.size() - 1; i < poly.size(); j = i++) {
+    const float *a = poly[j].ne, *b = poly[i].ne;
+    float d[2] = { b[0] - a[0], b[1] - a[1] };
+    float r[2] = { p[0] - a[0], p[1] - a[1] };
+    float len_sq = d[0] * d[0] + d[1] * d[1];
+    float t = len_sq > 0 ? (r[0] * d[0] + r[1] * d[1]) / len_sq : 0;
+    t = t < 0 ? 0 : (t > 1 ? 1 : t);
+    r[0] -= t * d[0];
+    r[1] -= t * d[1];
+    float dist = sqrtf(r[0] * r[0] + r[1] * r[1]);
+    if (dist < best)
+      best = dist;
+  }
+  return best;
+}
+
+/* A jagged star, like a fence drawn around the fields of a site */
+static std::vector<vertex> star(int n, float radius, float jag)
+{
+  std::vector<vertex> poly(n);
+  for (int i = 0; i < n; i++) {
+    float r = radius * (1 - jag * (rand() / (float) RAND_MAX));
+    float a = 2 * (float) M_PI * i / n;
+    poly[i].ne[0] = r * cosf(a) + 100;
+    poly[i].ne[1] = r * sinf(a) - 300;
+  }
+  return poly;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class GeofenceTest : public testing::Test {
+protected:
+  virtual void SetUp() {
+    srand(1);
+    fence = NULL;
+    geofence_cursor_init(&cursor);
+  }
+
+  virtual void TearDown() {
+    geofence_polygon_destroy(fence);
+  }
+
+  void build(const std::vector<vertex> &poly) {
+    fence = geofence_polygon_create(poly.size());
+    ASSERT_TRUE(fence != NULL);
+    for (size_t i = 0; i < poly.size(); i++)
+      geofence_polygon_set_vertex(fence, i, poly[i].ne);
+    ASSERT_EQ(0, geofence_polygon_build(fence, poly.size()));
+  }
+
+  /* Compares with the reference at random points around the fence */
+  void compare(const std::vector<vertex> &poly, float span, int points) {
+    for (int i = 0; i < points; i++) {
+      float p[2] = {
+        100 + span * (rand() / (float) RAND_MAX - 0.5f),
+        -300 + span * (rand() / (float) RAND_MAX - 0.5f),
+      };
+      float distance;
+      bool inside = geofence_polygon_check(fence, &cursor, p, &distance);
+      float expected = naive_distance(poly, p);
+
+      EXPECT_NEAR(expected, distance, 1e-3f + 1e-5f * expected);
+      // Too close to the boundary to tell with floats
+      if (expected > 1e-2f) {
+        EXPECT_EQ(naive_inside(poly, p), inside) << p[0] << " " << p[1];
+      }
+    }
+  }
+
+  struct geofence_polygon *fence;
+  struct geofence_cursor cursor;
+};
+
+TEST_F(GeofenceTest, Square) {
+  std::vector<vertex> poly = { {{0, 0}}, {{100, 0}}, {{100, 100}}, {{0, 100}} };
+  build(poly);
+
+  float distance;
+  const float center[2] = { 50, 50 };
+  EXPECT_TRUE(geofence_polygon_check(fence, &cursor, center, &distance));
+  EXPECT_FLOAT_EQ(50, distance);
+
+  const float near_edge[2] = { 90, 30 };
+  EXPECT_TRUE(geofence_polygon_check(fence, &cursor, near_edge, &distance));
+  EXPECT_FLOAT_EQ(10, distance);
+
+  const float outside[2] = { 130, 140 };
+  EXPECT_FALSE(geofence_polygon_check(fence, &cursor, outside, &distance));
+  EXPECT_FLOAT_EQ(50, distance);
+
+  const float behind[2] = { -20, 50 };
+  EXPECT_FALSE(geofence_polygon_check(fence, &cursor, behind, NULL));
+}
+
+TEST_F(GeofenceTest, Concave) {
+  // A U shape, the gap between the arms is outside
+  std::vector<vertex> poly = {
+    {{0, 0}}, {{100, 0}}, {{100, 40}}, {{20, 40}}, {{20, 60}},
+    {{100, 60}}, {{100, 100}}, {{0, 100}},
+  };
+  build(poly);
+
+  const float gap[2] = { 60, 50 };
+  const float arm[2] = { 60, 20 };
+  const float base[2] = { 10, 50 };
+  float distance;
+
+  EXPECT_FALSE(geofence_polygon_check(fence, &cursor, gap, &distance));
+  EXPECT_FLOAT_EQ(10, distance);
+  EXPECT_TRUE(geofence_polygon_check(fence, &cursor, arm, &distance));
+  EXPECT_FLOAT_EQ(20, distance);
+  EXPECT_TRUE(geofence_polygon_check(fence, &cursor, base, &distance));
+  EXPECT_FLOAT_EQ(10, distance);
+
+  compare(poly, 160, 20000);
+}
+
+TEST_F(GeofenceTest, GridAlignedComb) {
+  // Vertices on the cell boundaries and queries in line with them
+  std::vector<vertex> poly;
+  const int teeth = 20;
+  poly.push_back({{0, 0}});
+  for (int i = 0; i < teeth; i++) {
+    poly.push_back({{10.0f * i, 50}});
+    poly.push_back({{10.0f * i + 5, 50}});
+    poly.push_back({{10.0f * i + 5, 10}});
+    poly.push_back({{10.0f * i + 10, 10}});
+  }
+  poly.push_back({{10.0f * teeth, 0}});
+  build(poly);
+
+  for (int n = -5; n <= 10 * teeth + 5; n++) {
+    for (int e = -5; e <= 55; e++) {
+      const float p[2] = { n + 0.5f, (float) e };
+      float distance;
+      bool inside = geofence_polygon_check(fence, &cursor, p, &distance);
+      EXPECT_NEAR(naive_distance(poly, p), distance, 1e-3f);
+      if (distance > 1e-2f) {
+        EXPECT_EQ(naive_inside(poly, p), inside) << p[0] << " " << p[1];
+      }
+    }
+  }
+}
+
+TEST_F(GeofenceTest, LargeFence) {
+  std::vector<vertex> poly = star(2000, 1500, 0.3f);
+  build(poly);
+
+  compare(poly, 4000, 50000);
+}
+
+TEST_F(GeofenceTest, RepeatedVertex) {
+  std::vector<vertex> poly = { {{0, 0}}, {{100, 0}}, {{100, 0}}, {{100, 100}}, {{0, 100}} };
+  build(poly);
+
+  compare(poly, 300, 5000);
+}
+
+TEST_F(GeofenceTest, LongEdgesCoarsenTheGrid) {
+  // Every edge of the saw crosses the whole fence
+  std::vector<vertex> poly;
+  const int teeth = 100;
+  for (int i = 0; i < teeth; i++) {
+    poly.push_back({{0, 20.0f * i}});
+    poly.push_back({{1000, 20.0f * i + 10}});
+  }
+  poly.push_back({{-50, 20.0f * teeth}});
+  poly.push_back({{-50, 0}});
+  build(poly);
+
+  compare(poly, 2400, 20000);
+}
+
+TEST_F(GeofenceTest, Rebuild) {
+  std::vector<vertex> poly = star(300, 500, 0.3f);
+  build(poly);
+  compare(poly, 1200, 5000);
+
+  // A smaller fence in the same memory
+  std::vector<vertex> smaller = star(40, 300, 0.5f);
+  for (size_t i = 0; i < smaller.size(); i++)
+    geofence_polygon_set_vertex(fence, i, smaller[i].ne);
+  ASSERT_EQ(0, geofence_polygon_build(fence, smaller.size()));
+  geofence_cursor_init(&cursor);
+  compare(smaller, 800, 5000);
+
+  EXPECT_EQ(-1, geofence_polygon_build(fence, 301));
+}
+
+TEST_F(GeofenceTest, Invalid) {
+  EXPECT_TRUE(geofence_polygon_create(2) == NULL);
+  EXPECT_TRUE(geofence_polygon_create(GEOFENCE_MAX_VERTICES + 1) == NULL);
+
+  // All vertices on a line
+  fence = geofence_polygon_create(3);
+  ASSERT_TRUE(fence != NULL);
+  const float line[3][2] = { { 0, 0 }, { 10, 0 }, { 20, 0 } };
+  for (int i = 0; i < 3; i++)
+    geofence_polygon_set_vertex(fence, i, line[i]);
+  EXPECT_EQ(-1, geofence_polygon_build(fence, 3));
+  EXPECT_EQ(-1, geofence_polygon_build(fence, 4));
+}
+
+TEST_F(GeofenceTest, Benchmark) {
+  const int sizes[] = { 16, 128, 1024, 4096 };
+
+  for (unsigned int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    std::vector<vertex> poly = star(sizes[s], 1500, 0.3f);
+
+    double start = cpu_time();
+    build(poly);
+    double build_time = cpu_time() - start;
+
+    // A flight path crossing the fence back and forth
+    const int steps = 20000;
+    std::vector<vertex> path(steps);
+    for (int i = 0; i < steps; i++) {
+      float t = i / (float) steps;
+      path[i].ne[0] = 100 + 1800 * sinf(2 * (float) M_PI * 3 * t);
+      path[i].ne[1] = -300 + 1800 * sinf(2 * (float) M_PI * 2 * t);
+    }
+
+    int naive_count = 0, fence_count = 0;
+    start = cpu_time();
+    for (int i = 0; i < steps; i++) {
+      naive_count += naive_inside(poly, path[i].ne);
+      naive_distance(poly, path[i].ne);
+    }
+    double naive_time = cpu_time() - start;
+
+    start = cpu_time();
+    for (int i = 0; i < steps; i++) {
+      float distance;
+      fence_count += geofence_polygon_check(fence, &cursor, path[i].ne, &distance);
+    }
+    double fence_time = cpu_time() - start;
+
+    EXPECT_NEAR(naive_count, fence_count, steps / 1000);
+    printf("%5d vertices: build %.2f ms, naive %.2f us, indexed %.3f us per check\n",
+        sizes[s], build_time * 1e3, naive_time / steps * 1e6, fence_time / steps * 1e6);
+
+    geofence_polygon_destroy(fence);
+    fence = NULL;
+  }
+}
@@ -0,0 +1,35 @@
+#ifndef GPSPOSITION_H
+#define GPSPOSITION_H
+
+/* Every update is kept so the tests can check what the parsers published */
+#define GPSPOSITION_OBJID 0x628B5F6E
+
+typedef enum {
+	GPSPOSITION_STATUS_NOGPS = 0,
+	GPSPOSITION_STATUS_NOFIX = 1,
+	GPSPOSITION_STATUS_FIX2D = 2,
+	GPSPOSITION_STATUS_FIX3D = 3,
+	GPSPOSITION_STATUS_DIFF3D = 4
+} GPSPositionStatusOptions;
+
+typedef struct {
+	int32_t Latitude;
+	int32_t Longitude;
+	float Altitude;
+	float GeoidSeparation;
+	float Heading;
+	float Groundspeed;
+	float Accuracy;
+	float PDOP;
+	float HDOP;
+	float VDOP;
+	uint8_t Status;
+	uint8_t Satellites;
+} GPSPositionData;
+
+extern GPSPositionData gpsposition_last;
+extern uint32_t gpsposition_updates;
+
+int32_t GPSPositionSet(const GPSPositionData *data);
+
+#endif /* GPSPOSITION_H */
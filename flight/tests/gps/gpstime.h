@@ -0,0 +1,19 @@
+#ifndef GPSTIME_H
+#define GPSTIME_H
+
+typedef struct {
+	int16_t Year;
+	int8_t Month;
+	int8_t Day;
+	int8_t Hour;
+	int8_t Minute;
+	int8_t Second;
+} GPSTimeData;
+
+extern GPSTimeData gpstime_last;
+extern uint32_t gpstime_updates;
+
+int32_t GPSTimeGet(GPSTimeData *data);
+int32_t GPSTimeSet(const GPSTimeData *data);
+
+#endif /* GPSTIME_H */
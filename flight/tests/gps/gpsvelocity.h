@@ -0,0 +1,16 @@
+#ifndef GPSVELOCITY_H
+#define GPSVELOCITY_H
+
+typedef struct {
+	float North;
+	float East;
+	float Down;
+	float Accuracy;
+} GPSVelocityData;
+
+extern GPSVelocityData gpsvelocity_last;
+extern uint32_t gpsvelocity_updates;
+
+int32_t GPSVelocitySet(const GPSVelocityData *data);
+
+#endif /* GPSVELOCITY_H */
@@ -0,0 +1,70 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "gpsposition.h"
+#include "gpsvelocity.h"
+#include "gpstime.h"
+#include "gpssatellites.h"
+#include "ubloxinfo.h"
+
+GPSPositionData gpsposition_last;
+uint32_t gpsposition_updates;
+
+GPSVelocityData gpsvelocity_last;
+uint32_t gpsvelocity_updates;
+
+GPSTimeData gpstime_last;
+uint32_t gpstime_updates;
+
+static UBloxInfoData ubloxinfo;
+
+int32_t GPSPositionSet(const GPSPositionData *data)
+{
+	gpsposition_last = *data;
+	gpsposition_updates++;
+	return 0;
+}
+
+int32_t GPSVelocitySet(const GPSVelocityData *data)
+{
+	gpsvelocity_last = *data;
+	gpsvelocity_updates++;
+	return 0;
+}
+
+int32_t GPSTimeGet(GPSTimeData *data)
+{
+	*data = gpstime_last;
+	return 0;
+}
+
+int32_t GPSTimeSet(const GPSTimeData *data)
+{
+	gpstime_last = *data;
+	gpstime_updates++;
+	return 0;
+}
+
+int32_t GPSSatellitesSet(const GPSSatellitesData *data)
+{
+	(void) data;
+	return 0;
+}
+
+int32_t UBloxInfoGet(UBloxInfoData *data)
+{
+	*data = ubloxinfo;
+	return 0;
+}
+
+int32_t UBloxInfoSet(const UBloxInfoData *data)
+{
+	ubloxinfo = *data;
+	return 0;
+}
+
+int32_t UBloxInfoParseErrorsSet(const uint32_t *value)
+{
+	ubloxinfo.ParseErrors = *value;
+	return 0;
+}
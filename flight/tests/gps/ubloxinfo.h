@@ -0,0 +1,14 @@
+#ifndef UBLOXINFO_H
+#define UBLOXINFO_H
+
+typedef struct {
+	uint32_t swVersion;
+	uint32_t ParseErrors;
+	uint16_t hwVersion;
+} UBloxInfoData;
+
+int32_t UBloxInfoGet(UBloxInfoData *data);
+int32_t UBloxInfoSet(const UBloxInfoData *data);
+int32_t UBloxInfoParseErrorsSet(const uint32_t *value);
+
+#endif /* UBLOXINFO_H */
@@ -0,0 +1,424 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Replay UBX and NMEA streams through the GPS parsers
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
+#include <vector>
+
+extern "C" {
+
+#include "NMEA.h"
+
+/* UBX.h can't be included from C++, its header struct has a field named class */
+int parse_ubx_stream(const uint8_t *, uint16_t, char *, GPSPositionData *, struct GPS_RX_STATS *);
+
+}
+
+static double cpu_time(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * Builders for the UBX messages a receiver sends, written field by field
+ * at the offsets of the u-blox protocol specification.
+ */
+class UBXMessage {
+public:
+  UBXMessage(uint8_t cls, uint8_t id, uint16_t len) : cls(cls), id(id), payload(len, 0) { }
+
+  void u8(uint16_t offset, uint8_t value) { payload[offset] = value; }
+  void u16(uint16_t offset, uint16_t value) { u8(offset, value); u8(offset + 1, value >> 8); }
+  void u32(uint16_t offset, uint32_t value) { u16(offset, value); u16(offset + 2, value >> 16); }
+
+  void append_to(std::vector<uint8_t> &stream) const {
+    std::vector<uint8_t> frame;
+    frame.push_back(cls);
+    frame.push_back(id);
+    frame.push_back(payload.size() & 0xff);
+    frame.push_back(payload.size() >> 8);
+    frame.insert(frame.end(), payload.begin(), payload.end());
+
+    uint8_t ck_a = 0, ck_b = 0;
+    for (size_t i = 0; i < frame.size(); i++) {
+      ck_a += frame[i];
+      ck_b += ck_a;
+    }
+
+    stream.push_back(0xb5);
+    stream.push_back(0x62);
+    stream.insert(stream.end(), frame.begin(), frame.end());
+    stream.push_back(ck_a);
+    stream.push_back(ck_b);
+  }
+
+private:
+  uint8_t cls;
+  uint8_t id;
+  std::vector<uint8_t> payload;
+};
+
+/* A solution somewhere over Zurich, moving north east and climbing */
+struct solution {
+  uint32_t itow;
+  int32_t lat;		/* deg * 1e7 */
+  int32_t lon;		/* deg * 1e7 */
+  int32_t hmsl;		/* mm */
+  int32_t vel_n;	/* mm/s */
+  int32_t vel_e;	/* mm/s */
+  int32_t vel_d;	/* mm/s */
+  uint8_t num_sv;
+};
+
+static struct solution solution_at(int epoch)
+{
+  struct solution sol;
+  sol.itow = 345600000 + epoch * 100;
+  sol.lat = 473763000 + epoch * 9;
+  sol.lon = 85418000 + epoch * 13;
+  sol.hmsl = 450000 + epoch * 20;
+  sol.vel_n = 1000;
+  sol.vel_e = 1500;
+  sol.vel_d = -200;
+  sol.num_sv = 12;
+  return sol;
+}
+
+static void append_pvt(std::vector<uint8_t> &stream, const struct solution &sol, uint16_t len = 92)
+{
+  UBXMessage msg(0x01, 0x07, len);
+  msg.u32(0, sol.itow);
+  msg.u16(4, 2015);	/* year */
+  msg.u8(6, 7);		/* month */
+  msg.u8(7, 14);	/* day */
+  msg.u8(8, 12);	/* hour */
+  msg.u8(9, 30);	/* min */
+  msg.u8(10, (sol.itow / 1000) % 60);	/* sec */
+  msg.u8(11, 0x07);	/* valid date, time and fully resolved */
+  msg.u8(20, 3);	/* 3D fix */
+  msg.u8(21, 0x01);	/* gnssFixOK */
+  msg.u8(23, sol.num_sv);
+  msg.u32(24, sol.lon);
+  msg.u32(28, sol.lat);
+  msg.u32(32, sol.hmsl + 48000);	/* height above ellipsoid */
+  msg.u32(36, sol.hmsl);
+  msg.u32(40, 1200);	/* hAcc */
+  msg.u32(44, 1600);	/* vAcc */
+  msg.u32(48, sol.vel_n);
+  msg.u32(52, sol.vel_e);
+  msg.u32(56, sol.vel_d);
+  msg.u32(60, 1803);	/* gSpeed */
+  msg.u32(64, 5630993);	/* headMot */
+  msg.u32(68, 300);	/* sAcc */
+  msg.u16(76, 145);	/* pDOP */
+  msg.append_to(stream);
+}
+
+static void append_dop(std::vector<uint8_t> &stream, const struct solution &sol);
+
+static void append_legacy(std::vector<uint8_t> &stream, const struct solution &sol)
+{
+  UBXMessage posllh(0x01, 0x02, 28);
+  posllh.u32(0, sol.itow);
+  posllh.u32(4, sol.lon);
+  posllh.u32(8, sol.lat);
+  posllh.u32(12, sol.hmsl + 48000);
+  posllh.u32(16, sol.hmsl);
+  posllh.append_to(stream);
+
+  UBXMessage velned(0x01, 0x12, 36);
+  velned.u32(0, sol.itow);
+  velned.u32(4, sol.vel_n / 10);
+  velned.u32(8, sol.vel_e / 10);
+  velned.u32(12, sol.vel_d / 10);
+  velned.u32(20, 180);		/* gSpeed */
+  velned.u32(24, 5630993);	/* heading */
+  velned.u32(28, 30);		/* sAcc */
+  velned.append_to(stream);
+
+  UBXMessage nav_sol(0x01, 0x06, 52);
+  nav_sol.u32(0, sol.itow);
+  nav_sol.u8(10, 3);		/* 3D fix */
+  nav_sol.u8(11, 0x01);		/* fix ok */
+  nav_sol.u32(24, 200);		/* pAcc */
+  nav_sol.u8(47, sol.num_sv);
+  nav_sol.append_to(stream);
+
+  append_dop(stream, sol);
+}
+
+static void append_dop(std::vector<uint8_t> &stream, const struct solution &sol)
+{
+  UBXMessage dop(0x01, 0x04, 18);
+  dop.u32(0, sol.itow);
+  dop.u16(6, 145);	/* pDOP */
+  dop.u16(10, 120);	/* vDOP */
+  dop.u16(12, 80);	/* hDOP */
+  dop.append_to(stream);
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class GPSParser : public testing::Test {
+protected:
+  virtual void SetUp() {
+    memset(&position, 0, sizeof(position));
+    memset(&stats, 0, sizeof(stats));
+    memset(&gpsposition_last, 0, sizeof(gpsposition_last));
+    memset(&gpsvelocity_last, 0, sizeof(gpsvelocity_last));
+    gpsposition_updates = 0;
+    gpsvelocity_updates = 0;
+    gpstime_updates = 0;
+  }
+
+  virtual void TearDown() {
+  }
+
+  /* Feed a stream to the parser in chunks of the given size */
+  int replay_ubx(const std::vector<uint8_t> &stream, size_t chunk) {
+    int completed = 0;
+    for (size_t i = 0; i < stream.size(); i += chunk) {
+      size_t len = stream.size() - i < chunk ? stream.size() - i : chunk;
+      if (parse_ubx_stream(&stream[i], len, ubx_buffer, &position, &stats) == PARSER_COMPLETE)
+        completed++;
+    }
+    return completed;
+  }
+
+  int replay_nmea(const std::vector<uint8_t> &stream, size_t chunk) {
+    int completed = 0;
+    for (size_t i = 0; i < stream.size(); i += chunk) {
+      size_t len = stream.size() - i < chunk ? stream.size() - i : chunk;
+      if (parse_nmea_stream(&stream[i], len, nmea_buffer, &position, &stats) == PARSER_COMPLETE)
+        completed++;
+    }
+    return completed;
+  }
+
+  void expect_solution(const struct solution &sol) {
+    EXPECT_EQ(sol.lat, gpsposition_last.Latitude);
+    EXPECT_EQ(sol.lon, gpsposition_last.Longitude);
+    EXPECT_NEAR(sol.hmsl * 1e-3, gpsposition_last.Altitude, 1e-3);
+    EXPECT_NEAR(48, gpsposition_last.GeoidSeparation, 1e-3);
+    EXPECT_EQ(GPSPOSITION_STATUS_FIX3D, gpsposition_last.Status);
+    EXPECT_EQ(sol.num_sv, gpsposition_last.Satellites);
+    EXPECT_NEAR(1.45, gpsposition_last.PDOP, 1e-3);
+    EXPECT_NEAR(1.8, gpsposition_last.Groundspeed, 0.01);
+    EXPECT_NEAR(56.31, gpsposition_last.Heading, 0.01);
+
+    EXPECT_NEAR(sol.vel_n * 1e-3, gpsvelocity_last.North, 1e-3);
+    EXPECT_NEAR(sol.vel_e * 1e-3, gpsvelocity_last.East, 1e-3);
+    EXPECT_NEAR(sol.vel_d * 1e-3, gpsvelocity_last.Down, 1e-3);
+  }
+
+  GPSPositionData position;
+  struct GPS_RX_STATS stats;
+  /* Large enough for any UBX packet, aligned like the malloc'ed firmware buffer */
+  char ubx_buffer[512] __attribute__((aligned(8)));
+  char nmea_buffer[NMEA_MAX_PACKET_LENGTH];
+};
+
+/*
+ * The parser remembers that a NAV-PVT has been seen and then ignores the
+ * per-topic messages, so this test has to run before any NAV-PVT.
+ */
+TEST_F(GPSParser, UBXLegacyMessageSet) {
+  std::vector<uint8_t> stream;
+  struct solution sol = solution_at(0);
+  append_legacy(stream, sol);
+
+  EXPECT_EQ(4, replay_ubx(stream, 1));
+  EXPECT_EQ(4, stats.gpsRxReceived);
+
+  /* One position update once the whole set has arrived */
+  EXPECT_EQ(1u, gpsposition_updates);
+  EXPECT_EQ(1u, gpsvelocity_updates);
+  EXPECT_EQ(sol.lat, gpsposition_last.Latitude);
+  EXPECT_NEAR(0.8, gpsposition_last.HDOP, 1e-3);
+  EXPECT_NEAR(2, gpsposition_last.Accuracy, 1e-3);
+};
+
+TEST_F(GPSParser, UBXPvtSingleMessage) {
+  std::vector<uint8_t> stream;
+  struct solution sol = solution_at(1);
+  append_pvt(stream, sol);
+
+  EXPECT_EQ(1, replay_ubx(stream, stream.size()));
+  EXPECT_EQ(1, stats.gpsRxReceived);
+
+  EXPECT_EQ(1u, gpsposition_updates);
+  EXPECT_EQ(1u, gpsvelocity_updates);
+  expect_solution(sol);
+  EXPECT_NEAR(2, gpsposition_last.Accuracy, 1e-3);
+  EXPECT_NEAR(0.3, gpsvelocity_last.Accuracy, 1e-3);
+
+  EXPECT_EQ(1u, gpstime_updates);
+  EXPECT_EQ(2015, gpstime_last.Year);
+  EXPECT_EQ(7, gpstime_last.Month);
+  EXPECT_EQ(14, gpstime_last.Day);
+};
+
+TEST_F(GPSParser, UBXPvtUblox7Length) {
+  /* The u-blox 7 message stops before the vehicle heading */
+  std::vector<uint8_t> stream;
+  struct solution sol = solution_at(2);
+  append_pvt(stream, sol, 84);
+
+  EXPECT_EQ(1, replay_ubx(stream, stream.size()));
+  EXPECT_EQ(1u, gpsposition_updates);
+  expect_solution(sol);
+};
+
+TEST_F(GPSParser, UBXPvtAnyChunking) {
+  const int epochs = 50;
+  std::vector<uint8_t> stream;
+  for (int i = 0; i < epochs; i++)
+    append_pvt(stream, solution_at(i));
+
+  const size_t chunks[] = {1, 2, 7, 31, 32, 100, 4096};
+  for (unsigned j = 0; j < sizeof(chunks) / sizeof(chunks[0]); j++) {
+    SetUp();
+    replay_ubx(stream, chunks[j]);
+
+    EXPECT_EQ(epochs, stats.gpsRxReceived) << "chunk " << chunks[j];
+    EXPECT_EQ(0, stats.gpsRxChkSumError) << "chunk " << chunks[j];
+    EXPECT_EQ((uint32_t) epochs, gpsposition_updates) << "chunk " << chunks[j];
+    expect_solution(solution_at(epochs - 1));
+  }
+};
+
+TEST_F(GPSParser, UBXPvtIgnoresLegacy) {
+  std::vector<uint8_t> stream;
+  append_pvt(stream, solution_at(10));
+  append_legacy(stream, solution_at(11));
+  append_pvt(stream, solution_at(12));
+
+  replay_ubx(stream, 32);
+
+  /* Only the two NAV-PVT publish, the NAV-DOP still fills in HDOP */
+  EXPECT_EQ(6, stats.gpsRxReceived);
+  EXPECT_EQ(2u, gpsposition_updates);
+  EXPECT_EQ(2u, gpsvelocity_updates);
+  expect_solution(solution_at(12));
+  EXPECT_NEAR(0.8, gpsposition_last.HDOP, 1e-3);
+  EXPECT_NEAR(1.2, gpsposition_last.VDOP, 1e-3);
+};
+
+TEST_F(GPSParser, UBXNoiseAndCorruption) {
+  std::vector<uint8_t> stream;
+  const uint8_t noise[] = {0x00, 0xb5, 0x00, 0x62, 0x24, 0xb5, 0xb5};
+  stream.insert(stream.end(), noise, noise + sizeof(noise));
+
+  /* A message with a flipped bit, then an empty poll reply, then a good one */
+  std::vector<uint8_t> bad;
+  append_pvt(bad, solution_at(20));
+  bad[40] ^= 0x10;
+  stream.insert(stream.end(), bad.begin(), bad.end());
+
+  UBXMessage empty(0x0a, 0x04, 0);
+  empty.append_to(stream);
+
+  append_pvt(stream, solution_at(21));
+
+  replay_ubx(stream, 16);
+
+  EXPECT_EQ(1, stats.gpsRxChkSumError);
+  EXPECT_EQ(2, stats.gpsRxReceived);
+  EXPECT_EQ(1u, gpsposition_updates);
+  expect_solution(solution_at(21));
+};
+
+TEST_F(GPSParser, NMEACapture) {
+  FILE *fid = fopen("nmea_capture.txt", "rb");
+  ASSERT_TRUE(fid != NULL);
+
+  std::vector<uint8_t> stream;
+  int c;
+  while ((c = fgetc(fid)) != EOF)
+    stream.push_back(c);
+  fclose(fid);
+
+  const size_t chunks[] = {1, 5, 32, 4096};
+  for (unsigned j = 0; j < sizeof(chunks) / sizeof(chunks[0]); j++) {
+    SetUp();
+    replay_nmea(stream, chunks[j]);
+
+    /* 20 epochs of GGA, GSA, RMC and VTG and a GGA with a bad checksum */
+    EXPECT_EQ(80, stats.gpsRxReceived) << "chunk " << chunks[j];
+    EXPECT_EQ(1, stats.gpsRxChkSumError) << "chunk " << chunks[j];
+    EXPECT_EQ(0, stats.gpsRxParserError) << "chunk " << chunks[j];
+
+    /* Only GGA publishes the position */
+    EXPECT_EQ(20u, gpsposition_updates) << "chunk " << chunks[j];
+    EXPECT_NEAR(472852523, gpsposition_last.Latitude, 2);
+    EXPECT_NEAR(85652608, gpsposition_last.Longitude, 2);
+    EXPECT_NEAR(499.6, gpsposition_last.Altitude, 1e-3);
+    EXPECT_EQ(8, gpsposition_last.Satellites);
+    EXPECT_EQ(GPSPOSITION_STATUS_FIX3D, gpsposition_last.Status);
+    EXPECT_NEAR(5.144, gpsposition_last.Groundspeed, 1e-3);
+  }
+};
+
+TEST_F(GPSParser, UBXBenchmark) {
+  /* Ten minutes at 10 Hz with NAV-DOP every fifth epoch */
+  const int epochs = 6000;
+  std::vector<uint8_t> stream;
+  for (int i = 0; i < epochs; i++) {
+    append_pvt(stream, solution_at(i));
+    if (i % 5 == 0)
+      append_dop(stream, solution_at(i));
+  }
+
+  const size_t chunks[] = {1, 32};
+  for (unsigned j = 0; j < sizeof(chunks) / sizeof(chunks[0]); j++) {
+    SetUp();
+    double start = cpu_time();
+    replay_ubx(stream, chunks[j]);
+    double elapsed = cpu_time() - start;
+
+    EXPECT_EQ((uint32_t) epochs, gpsposition_updates);
+    printf("chunks of %3zu bytes: %.3f us per epoch, %.1f ns per byte\n", chunks[j],
+           elapsed / epochs * 1e6, elapsed / stream.size() * 1e9);
+  }
+};
+
+/**
+ * @}
+ * @}
+ */
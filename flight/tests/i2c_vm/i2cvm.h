@@ -14,6 +14,9 @@ typedef struct {
 	int32_t r4;
 	int32_t r5;
 	int32_t r6;
+
+	uint32_t cycles;
+	uint32_t i2ctime;
 } I2CVMData;
 
 extern void I2CVMSet(I2CVMData * data);
@@ -12,6 +12,9 @@
 
 #define NELEMENTS(x) (sizeof(x) / sizeof(*(x)))
 
+#include <pios_heap.h>
+#include <pios_delay.h>
+
 #if defined(PIOS_INCLUDE_I2C)
 #include <pios_i2c.h>
 #endif
@@ -0,0 +1,14 @@
+#include "pios.h"
+
+/* Simulated time, moved on by the I2C transfers */
+uint32_t fake_time_us;
+
+uint32_t PIOS_DELAY_GetRaw()
+{
+	return fake_time_us;
+}
+
+uint32_t PIOS_DELAY_DiffuS(uint32_t raw)
+{
+	return fake_time_us - raw;
+}
@@ -1,6 +1,12 @@
 #include "pios.h"
 
+/* Time each simulated transfer takes */
+#define I2C_TRANSFER_US 120
+
+extern uint32_t fake_time_us;
+
 int32_t PIOS_I2C_Transfer(uint32_t i2c_id, const struct pios_i2c_txn txn_list[], uint32_t num_txns)
 {
+	fake_time_us += I2C_TRANSFER_US;
 	return 0;
 }
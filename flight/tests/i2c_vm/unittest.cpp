@@ -1,7 +1,7 @@
 /**
  ******************************************************************************
  * @file       unittest.cpp
- * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013-2015
  * @addtogroup UnitTests
  * @{
  * @addtogroup UnitTests
@@ -37,11 +37,12 @@
 #include <stdlib.h>		/* abort */
 #include <string.h>		/* memset */
 #include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
 
 extern "C" {
 
 #include "i2c_vm_asm.h"
-extern bool i2c_vm_run (const uint32_t * code, uint8_t code_len, uintptr_t i2c_adapter);
+#include "i2c_vm.h"
 
 #include "i2cvm.h"		// uavo_data
 
@@ -49,6 +50,13 @@ extern bool i2c_vm_run (const uint32_t * code, uint8_t code_len, uintptr_t i2c_a
 
 #define NELEMENTS(x) (sizeof(x) / sizeof(*x))
 
+static double cpu_time(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
 // To use a test fixture, derive a class from testing::Test.
 class I2CVMTest : public testing::Test {
 protected:
@@ -656,6 +664,31 @@ TEST_F(I2CVMTest, DivImm) {
   EXPECT_EQ(465, uavo_data.r0);
 }
 
+TEST_F(I2CVMTest, DivImmNegative) {
+  const uint32_t program[] = {
+    I2C_VM_ASM_SET_IMM(VM_R0, -10233),
+    I2C_VM_ASM_DIV_IMM(VM_R0,     22),
+    I2C_VM_ASM_SET_IMM(VM_R1,  10233),
+    I2C_VM_ASM_DIV_IMM(VM_R1,    -22),
+    I2C_VM_ASM_SEND_UAVO(),
+  };
+
+  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+
+  EXPECT_EQ(-465, uavo_data.r0);
+  EXPECT_EQ(-465, uavo_data.r1);
+}
+
+TEST_F(I2CVMTest, DivByZeroFaults) {
+  const uint32_t program[] = {
+    I2C_VM_ASM_SET_IMM(VM_R0, 10233),
+    I2C_VM_ASM_DIV(VM_R0, VM_R0, VM_R1),
+    I2C_VM_ASM_SEND_UAVO(),
+  };
+
+  EXPECT_FALSE(i2c_vm_run (program, NELEMENTS(program), 0));
+}
+
 TEST_F(I2CVMTest, JumpForward) {
   const uint32_t program[] = {
     I2C_VM_ASM_SET_IMM(VM_R0, 1),
@@ -800,3 +833,176 @@ TEST_F(I2CVMTest, CleanReboot) {
 
   EXPECT_EQ(0, memcmp(ram2, uavo_data.ram, sizeof(ram)));
 }
+
+/* Sensor style processing of a sample, run in a loop */
+#define BENCH_LOOPS 1000
+static const uint32_t bench_program[] = {
+  I2C_VM_ASM_SET_DEV_ADDR(0x1E),
+  I2C_VM_ASM_SET_IMM(VM_R6, BENCH_LOOPS),
+
+  /* Read a sample */
+  I2C_VM_ASM_STORE(0x03, 0),
+  I2C_VM_ASM_WRITE_I2C(0, 1),
+  I2C_VM_ASM_READ_I2C(0, 6),
+  I2C_VM_ASM_STORE(0x81, 0),
+  I2C_VM_ASM_STORE(0x42, 3),
+
+  /* Sign extend and scale it */
+  I2C_VM_ASM_LOAD_BE(0, 2, VM_R0),
+  I2C_VM_ASM_SL_IMM(VM_R0, 16),
+  I2C_VM_ASM_ASR_IMM(VM_R0, 16),
+  I2C_VM_ASM_MUL_IMM(VM_R0, 1000),
+  I2C_VM_ASM_DIV_IMM(VM_R0, 1090),
+
+  I2C_VM_ASM_LOAD_LE(2, 2, VM_R1),
+  I2C_VM_ASM_SL_IMM(VM_R1, 16),
+  I2C_VM_ASM_ASR_IMM(VM_R1, 16),
+  I2C_VM_ASM_MUL_IMM(VM_R1, 1000),
+  I2C_VM_ASM_DIV_IMM(VM_R1, 1090),
+
+  I2C_VM_ASM_LOAD_BE(3, 3, VM_R2),
+  I2C_VM_ASM_LSR_IMM(VM_R2, 5),
+  I2C_VM_ASM_OR_IMM(VM_R2, 0x100),
+  I2C_VM_ASM_SET_IMM(VM_R3, 0x7F0),
+  I2C_VM_ASM_AND(VM_R2, VM_R2, VM_R3),
+  I2C_VM_ASM_ADD(VM_R4, VM_R0, VM_R1),
+  I2C_VM_ASM_MUL(VM_R4, VM_R4, VM_R2),
+  I2C_VM_ASM_DIV(VM_R5, VM_R4, VM_R3),
+  I2C_VM_ASM_NOP(),
+
+  I2C_VM_ASM_ADD_IMM(VM_R6, -1),
+  I2C_VM_ASM_BNZ(VM_R6, -25),
+
+  I2C_VM_ASM_SEND_UAVO(),
+};
+
+TEST_F(I2CVMTest, Benchmark) {
+  const int runs = 200;
+  const uint32_t insns = 2 + 26 * BENCH_LOOPS + 1;
+  struct i2c_vm_prog prog;
+
+  /* Checking and decoding the program is only done once */
+  double start = cpu_time();
+  for (int i = 0; i < runs; i++) {
+    ASSERT_TRUE(i2c_vm_load (&prog, bench_program, NELEMENTS(bench_program)));
+    i2c_vm_unload (&prog);
+  }
+  double load = cpu_time() - start;
+
+  ASSERT_TRUE(i2c_vm_load (&prog, bench_program, NELEMENTS(bench_program)));
+
+  start = cpu_time();
+  for (int i = 0; i < runs; i++)
+    ASSERT_TRUE(i2c_vm_exec (&prog, 0));
+  double elapsed = cpu_time() - start;
+
+  i2c_vm_unload (&prog);
+
+  EXPECT_EQ(0, uavo_data.r6);
+  EXPECT_EQ(NELEMENTS(bench_program) - 1, uavo_data.pc);
+  EXPECT_EQ(insns, uavo_data.cycles);
+  EXPECT_EQ(2u * 120 * BENCH_LOOPS, uavo_data.i2ctime);
+
+  printf("load: %.2f us per program of %u instructions\n",
+         load / runs * 1e6, (unsigned)NELEMENTS(bench_program));
+  printf("run:  %.1f ns per instruction, %.1f us per program\n",
+         elapsed / ((double)runs * insns) * 1e9, elapsed / runs * 1e6);
+}
+
+TEST_F(I2CVMTest, VerifierRejectsBadOperands) {
+  const uint32_t bad_instructions[] = {
+    I2C_VM_ASM_SET_IMM(VM_PC, 1),            /* PC isn't a general register */
+    I2C_VM_ASM_ADD_IMM(VM_R6 + 1, 1),        /* no such register */
+    I2C_VM_ASM_ADD(VM_R0, VM_R1, 0x80),
+    I2C_VM_ASM_DIV_IMM(VM_R0, 0),            /* division by zero */
+    I2C_VM_ASM_LOAD_BE(6, 4, VM_R0),         /* runs off the end of RAM */
+    I2C_VM_ASM_LOAD_LE(0, 0, VM_R0),
+    I2C_VM_ASM_READ_I2C(4, 5),
+    I2C_VM_ASM_WRITE_I2C(0xFF, 2),
+    I2C_VM_ASM_JUMP(2),                      /* out of the program */
+    I2C_VM_ASM_BNZ(VM_R0, -2),
+  };
+
+  for (uint8_t i = 0; i < NELEMENTS(bad_instructions); i++) {
+    struct i2c_vm_prog prog;
+
+    /* Where the bad instruction is never reached */
+    const uint32_t program[] = {
+      I2C_VM_ASM_HALT(),
+      bad_instructions[i],
+    };
+
+    EXPECT_FALSE(i2c_vm_load (&prog, program, NELEMENTS(program))) << "instruction " << (int)i;
+    EXPECT_TRUE(prog.insns == NULL);
+  }
+}
+
+TEST_F(I2CVMTest, BranchToEndCompletes) {
+  const uint32_t program[] = {
+    I2C_VM_ASM_SET_IMM(VM_R0, 1),
+    I2C_VM_ASM_BNZ(VM_R0, 3),
+    I2C_VM_ASM_HALT(),
+    I2C_VM_ASM_HALT(),
+  };
+
+  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+}
+
+TEST_F(I2CVMTest, ReloadedProgramRestarts) {
+  const uint32_t program[] = {
+    I2C_VM_ASM_ADD_IMM(VM_R0, 5),
+    I2C_VM_ASM_STORE(0x11, 7),
+    I2C_VM_ASM_SEND_UAVO(),
+  };
+  struct i2c_vm_prog prog;
+
+  ASSERT_TRUE(i2c_vm_load (&prog, program, NELEMENTS(program)));
+
+  for (int i = 0; i < 3; i++) {
+    EXPECT_TRUE(i2c_vm_exec (&prog, 0));
+    EXPECT_EQ(5, uavo_data.r0);
+    EXPECT_EQ(0x11, uavo_data.ram[7]);
+    EXPECT_EQ(2, uavo_data.pc);
+  }
+
+  i2c_vm_unload (&prog);
+  EXPECT_FALSE(i2c_vm_exec (&prog, 0));
+}
+
+TEST_F(I2CVMTest, CycleAndI2CAccounting) {
+  const uint32_t program[] = {
+    I2C_VM_ASM_SET_IMM(VM_R0, 3),
+
+    I2C_VM_ASM_WRITE_I2C(0, 1),
+    I2C_VM_ASM_READ_I2C(0, 2),
+    I2C_VM_ASM_ADD_IMM(VM_R0, -1),
+    I2C_VM_ASM_BNZ(VM_R0, -3),
+
+    I2C_VM_ASM_SEND_UAVO(),
+  };
+
+  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+
+  /* The send itself is counted */
+  EXPECT_EQ(1u + 3 * 4 + 1, uavo_data.cycles);
+
+  /* Six transfers of 120us on the simulated bus */
+  EXPECT_EQ(6u * 120, uavo_data.i2ctime);
+
+  /* Counters start over with the program */
+  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  EXPECT_EQ(1u + 3 * 4 + 1, uavo_data.cycles);
+  EXPECT_EQ(6u * 120, uavo_data.i2ctime);
+}
+
+TEST_F(I2CVMTest, DefaultUserProgram) {
+  /* The default of the I2CVMUserProgram UAVO */
+  const uint32_t program[] = {
+    134676490, 84541440, 84607232, 84673024, 84738816, 117441025, 117441282, 117441539,
+    100663812, 100664069, 100664326, 385875968, 168296447, 33554452, 50855927, 0, 0, 0, 0, 0,
+  };
+  struct i2c_vm_prog prog;
+
+  EXPECT_TRUE(i2c_vm_load (&prog, program, NELEMENTS(program)));
+  i2c_vm_unload (&prog);
+}
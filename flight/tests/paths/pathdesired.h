@@ -0,0 +1,25 @@
+#ifndef PATHDESIRED_H
+#define PATHDESIRED_H
+
+typedef enum {
+	PATHDESIRED_MODE_ENDPOINT = 0,
+	PATHDESIRED_MODE_VECTOR = 1,
+	PATHDESIRED_MODE_CIRCLERIGHT = 2,
+	PATHDESIRED_MODE_CIRCLELEFT = 3,
+	PATHDESIRED_MODE_HOLDPOSITION = 4,
+	PATHDESIRED_MODE_CIRCLEPOSITIONLEFT = 5,
+	PATHDESIRED_MODE_CIRCLEPOSITIONRIGHT = 6,
+	PATHDESIRED_MODE_LAND = 7
+} PathDesiredModeOptions;
+
+typedef struct {
+	float Start[3];
+	float End[3];
+	float StartingVelocity;
+	float EndingVelocity;
+	float ModeParameters;
+	int16_t Waypoint;
+	uint8_t Mode;
+} PathDesiredData;
+
+#endif /* PATHDESIRED_H */
@@ -0,0 +1,5 @@
+#include "paths.h"
+#include "pathdesired.h"
+
+/* The path library before paths were compiled, in paths_reference.c */
+void path_progress_reference(const PathDesiredData *pathDesired, const float *cur_point, struct path_status *status);
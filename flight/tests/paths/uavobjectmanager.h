@@ -0,0 +1,6 @@
+#ifndef UAVOBJECTMANAGER_H
+#define UAVOBJECTMANAGER_H
+
+/* The path library only uses the data of its objects */
+
+#endif /* UAVOBJECTMANAGER_H */
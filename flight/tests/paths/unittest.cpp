@@ -0,0 +1,291 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Geometry of the paths followed by the path followers
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <string.h>		/* memset */
+#include <math.h>		/* sqrtf */
+#include <time.h>		/* clock_gettime */
+
+extern "C" {
+
+#include "paths.h"
+#include "paths_reference.h"
+
+}
+
+static double cpu_time(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class PathTest : public testing::Test {
+protected:
+  virtual void SetUp() {
+    memset(&pathDesired, 0, sizeof(pathDesired));
+    memset(&segment, 0, sizeof(segment));
+  }
+
+  void setPath(uint8_t mode, float start_n, float start_e, float end_n, float end_e, float param) {
+    pathDesired.Mode = mode;
+    pathDesired.Start[0] = start_n;
+    pathDesired.Start[1] = start_e;
+    pathDesired.End[0] = end_n;
+    pathDesired.End[1] = end_e;
+    pathDesired.ModeParameters = param;
+  }
+
+  /* Evaluates the compiled segment, which must agree with the uncompiled reference */
+  struct path_status progress(float north, float east) {
+    const float cur[3] = {north, east, 0};
+    struct path_status compiled, reference;
+
+    path_segment_update(&segment, &pathDesired);
+    path_segment_progress(&segment, cur, &compiled);
+    path_progress_reference(&pathDesired, cur, &reference);
+
+    EXPECT_NEAR(reference.fractional_progress, compiled.fractional_progress, 1e-5f);
+    EXPECT_NEAR(reference.error, compiled.error, 1e-4f);
+    for (int i = 0; i < 2; i++) {
+      EXPECT_NEAR(reference.correction_direction[i], compiled.correction_direction[i], 1e-5f);
+      EXPECT_NEAR(reference.path_direction[i], compiled.path_direction[i], 1e-5f);
+    }
+    return compiled;
+  }
+
+  PathDesiredData pathDesired;
+  struct path_segment segment;
+};
+
+TEST_F(PathTest, Endpoint) {
+  setPath(PATHDESIRED_MODE_ENDPOINT, 0, 0, 10, 0, 0);
+
+  struct path_status status = progress(0, 0);
+  EXPECT_FLOAT_EQ(1 - 10.0f / 11.0f, status.fractional_progress);
+  EXPECT_FLOAT_EQ(10, status.error);
+  EXPECT_FLOAT_EQ(1, status.path_direction[0]);
+  EXPECT_FLOAT_EQ(0, status.path_direction[1]);
+  EXPECT_FLOAT_EQ(0, status.correction_direction[0]);
+  EXPECT_FLOAT_EQ(0, status.correction_direction[1]);
+
+  status = progress(10, 0);
+  EXPECT_FLOAT_EQ(1, status.fractional_progress);
+  EXPECT_FLOAT_EQ(0, status.error);
+}
+
+TEST_F(PathTest, Vector) {
+  setPath(PATHDESIRED_MODE_VECTOR, 0, 0, 10, 0, 0);
+
+  struct path_status status = progress(5, 2);
+  EXPECT_FLOAT_EQ(0.5f, status.fractional_progress);
+  EXPECT_FLOAT_EQ(2, status.error);
+  EXPECT_FLOAT_EQ(1, status.path_direction[0]);
+  EXPECT_FLOAT_EQ(0, status.path_direction[1]);
+  EXPECT_FLOAT_EQ(0, status.correction_direction[0]);
+  EXPECT_FLOAT_EQ(-1, status.correction_direction[1]);
+
+  status = progress(15, -3);
+  EXPECT_FLOAT_EQ(1.5f, status.fractional_progress);
+  EXPECT_FLOAT_EQ(3, status.error);
+  EXPECT_FLOAT_EQ(1, status.correction_direction[1]);
+}
+
+TEST_F(PathTest, VectorTooShort) {
+  // Flies to the end but is always complete
+  setPath(PATHDESIRED_MODE_VECTOR, 3, 4, 3, 4, 0);
+
+  struct path_status status = progress(0, 0);
+  EXPECT_FLOAT_EQ(1, status.fractional_progress);
+  EXPECT_FLOAT_EQ(5, status.error);
+  EXPECT_FLOAT_EQ(0.6f, status.path_direction[0]);
+  EXPECT_FLOAT_EQ(0.8f, status.path_direction[1]);
+}
+
+TEST_F(PathTest, CirclePosition) {
+  setPath(PATHDESIRED_MODE_CIRCLEPOSITIONRIGHT, 0, 0, 0, 0, 10);
+
+  // Too close, correct outwards and fly clockwise
+  struct path_status status = progress(5, 0);
+  EXPECT_FLOAT_EQ(0, status.fractional_progress);
+  EXPECT_FLOAT_EQ(5, status.error);
+  EXPECT_FLOAT_EQ(1, status.correction_direction[0]);
+  EXPECT_FLOAT_EQ(0, status.correction_direction[1]);
+  EXPECT_FLOAT_EQ(0, status.path_direction[0]);
+  EXPECT_FLOAT_EQ(1, status.path_direction[1]);
+  EXPECT_FLOAT_EQ(0.1f, segment.curvature);
+
+  setPath(PATHDESIRED_MODE_CIRCLEPOSITIONLEFT, 0, 0, 0, 0, 10);
+
+  status = progress(0, 20);
+  EXPECT_FLOAT_EQ(10, status.error);
+  EXPECT_FLOAT_EQ(0, status.correction_direction[0]);
+  EXPECT_FLOAT_EQ(-1, status.correction_direction[1]);
+  EXPECT_FLOAT_EQ(1, status.path_direction[0]);
+  EXPECT_FLOAT_EQ(0, status.path_direction[1]);
+
+  // On the center there is no direction
+  status = progress(0, 0);
+  EXPECT_FLOAT_EQ(1, status.fractional_progress);
+  EXPECT_FLOAT_EQ(10, status.error);
+}
+
+TEST_F(PathTest, CirclePositionMinimumRadius) {
+  setPath(PATHDESIRED_MODE_CIRCLEPOSITIONRIGHT, 0, 0, 0, 0, 0);
+
+  struct path_status status = progress(1, 0);
+  EXPECT_FLOAT_EQ(0.9f, status.error);
+  EXPECT_FLOAT_EQ(0.1f, segment.radius);
+}
+
+TEST_F(PathTest, Curve) {
+  // Turning left from heading east, the center is north of the chord
+  setPath(PATHDESIRED_MODE_CIRCLELEFT, 0, 0, 0, 20, 20);
+
+  struct path_status status = progress(0, 0);
+  EXPECT_NEAR(sqrtf(300), segment.center[0], 1e-3f);
+  EXPECT_NEAR(10, segment.center[1], 1e-3f);
+  EXPECT_FLOAT_EQ(-1.0f / 20, segment.curvature);
+  EXPECT_NEAR(0, status.error, 1e-4f);
+  EXPECT_FLOAT_EQ(0, status.fractional_progress);
+  EXPECT_NEAR(-0.5f, status.path_direction[0], 1e-4f);
+  EXPECT_NEAR(sqrtf(0.75f), status.path_direction[1], 1e-4f);
+
+  status = progress(0, 20);
+  EXPECT_NEAR(0, status.error, 1e-4f);
+  EXPECT_FLOAT_EQ(1, status.fractional_progress);
+
+  // Half way, too far out of the circle
+  status = progress(-5, 10);
+  EXPECT_FLOAT_EQ(0.5f, status.fractional_progress);
+  EXPECT_NEAR(sqrtf(300) + 5 - 20, status.error, 1e-3f);
+  EXPECT_FLOAT_EQ(1, status.correction_direction[0]);
+  EXPECT_FLOAT_EQ(0, status.correction_direction[1]);
+  EXPECT_FLOAT_EQ(0, status.path_direction[0]);
+  EXPECT_FLOAT_EQ(1, status.path_direction[1]);
+
+  // Turning right mirrors it, a negative radius takes the long way round
+  setPath(PATHDESIRED_MODE_CIRCLERIGHT, 0, 0, 0, 20, 20);
+  progress(0, 0);
+  EXPECT_NEAR(-sqrtf(300), segment.center[0], 1e-3f);
+  EXPECT_FLOAT_EQ(1.0f / 20, segment.curvature);
+
+  setPath(PATHDESIRED_MODE_CIRCLERIGHT, 0, 0, 0, 20, -20);
+  progress(0, 0);
+  EXPECT_NEAR(sqrtf(300), segment.center[0], 1e-3f);
+  EXPECT_FLOAT_EQ(20, segment.radius);
+}
+
+TEST_F(PathTest, CurveRadiusTooSmall) {
+  // The radius is grown a little to absorb rounding
+  setPath(PATHDESIRED_MODE_CIRCLERIGHT, 0, 0, 0, 20, 9.99f);
+  progress(0, 0);
+  EXPECT_FLOAT_EQ((9.99f + 0.05f) * 1.005f, segment.radius);
+
+  // and a radius that can't connect the points becomes a near straight line
+  setPath(PATHDESIRED_MODE_CIRCLERIGHT, 0, 0, 0, 20, 5);
+  progress(0, 0);
+  EXPECT_FLOAT_EQ(10.01f * 1000, segment.radius);
+}
+
+TEST_F(PathTest, UpdateOnlyWhenThePathChanges) {
+  setPath(PATHDESIRED_MODE_VECTOR, 0, 0, 10, 0, 0);
+
+  EXPECT_TRUE(path_segment_update(&segment, &pathDesired));
+  EXPECT_FALSE(path_segment_update(&segment, &pathDesired));
+
+  // Fields that don't change the geometry
+  pathDesired.Start[2] = -10;
+  pathDesired.EndingVelocity = 5;
+  pathDesired.Waypoint = 3;
+  EXPECT_FALSE(path_segment_update(&segment, &pathDesired));
+
+  pathDesired.End[1] = 1;
+  EXPECT_TRUE(path_segment_update(&segment, &pathDesired));
+  EXPECT_FALSE(path_segment_update(&segment, &pathDesired));
+
+  pathDesired.Mode = PATHDESIRED_MODE_CIRCLERIGHT;
+  EXPECT_TRUE(path_segment_update(&segment, &pathDesired));
+
+  pathDesired.ModeParameters = 50;
+  EXPECT_TRUE(path_segment_update(&segment, &pathDesired));
+}
+
+TEST_F(PathTest, UpdateCompilesANewSegment) {
+  // A zeroed segment is compiled even if the path is all zeroes
+  EXPECT_TRUE(path_segment_update(&segment, &pathDesired));
+}
+
+TEST_F(PathTest, Benchmark) {
+  const uint8_t modes[] = {
+    PATHDESIRED_MODE_ENDPOINT,
+    PATHDESIRED_MODE_VECTOR,
+    PATHDESIRED_MODE_CIRCLERIGHT,
+    PATHDESIRED_MODE_CIRCLEPOSITIONLEFT,
+  };
+  const int iterations = 1000000;
+
+  for (unsigned int m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+    setPath(modes[m], 12.5f, -40.0f, 130.0f, 85.0f, 90.0f);
+    path_compile(&pathDesired, &segment);
+
+    struct path_status status;
+    float cur[3] = {0, 0, 0};
+    float sum = 0;
+
+    double start = cpu_time();
+    for (int i = 0; i < iterations; i++) {
+      cur[0] = (i & 255) * 0.5f;
+      cur[1] = ((i >> 8) & 255) * 0.5f;
+      path_progress_reference(&pathDesired, cur, &status);
+      sum += status.error;
+    }
+    double reference = cpu_time() - start;
+
+    start = cpu_time();
+    for (int i = 0; i < iterations; i++) {
+      cur[0] = (i & 255) * 0.5f;
+      cur[1] = ((i >> 8) & 255) * 0.5f;
+      path_segment_progress(&segment, cur, &status);
+      sum -= status.error;
+    }
+    double compiled = cpu_time() - start;
+
+    EXPECT_NEAR(0, sum, 1e-3f * iterations);
+    printf("mode %d: %.1f ns per call before compiling, %.1f ns compiled\n", modes[m],
+        reference / iterations * 1e9, compiled / iterations * 1e9);
+  }
+}
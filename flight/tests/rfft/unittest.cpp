@@ -0,0 +1,194 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test and benchmark of the real FFT
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
+
+#include <vector>
+
+extern "C" {
+
+#include "rfft.h"
+
+}
+
+#include <math.h>		/* fabs() */
+
+static double cpu_time(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Reference transform in double precision */
+static void naive_dft(const std::vector<float> &x, std::vector<double> &re, std::vector<double> &im)
+{
+  size_t n = x.size();
+  re.assign(n / 2 + 1, 0);
+  im.assign(n / 2 + 1, 0);
+  for (size_t k = 0; k <= n / 2; k++) {
+    for (size_t i = 0; i < n; i++) {
+      re[k] += x[i] * cos(2 * M_PI * k * i / n);
+      im[k] -= x[i] * sin(2 * M_PI * k * i / n);
+    }
+  }
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class RealFFT : public testing::Test {
+protected:
+  virtual void SetUp() {
+    srand(1234);
+  }
+
+  virtual void TearDown() {
+  }
+};
+
+TEST_F(RealFFT, RejectsBadLengths) {
+  struct rfft_plan plan;
+  float twiddle[64];
+
+  EXPECT_FALSE(rfft_init(&plan, 0, twiddle));
+  EXPECT_FALSE(rfft_init(&plan, 2, twiddle));
+  EXPECT_FALSE(rfft_init(&plan, 48, twiddle));
+  EXPECT_FALSE(rfft_init(&plan, 64, NULL));
+  EXPECT_TRUE(rfft_init(&plan, 64, twiddle));
+}
+
+TEST_F(RealFFT, MatchesDFT) {
+  const uint16_t sizes[] = {4, 8, 16, 64, 256, 1024};
+
+  for (unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    const uint16_t n = sizes[s];
+    struct rfft_plan plan;
+    std::vector<float> twiddle(n), x(n), buf(n);
+    std::vector<double> re, im;
+
+    ASSERT_TRUE(rfft_init(&plan, n, &twiddle[0]));
+
+    for (uint16_t i = 0; i < n; i++)
+      x[i] = (float) rand() / RAND_MAX - 0.5f;
+
+    naive_dft(x, re, im);
+    buf = x;
+    rfft_forward(&plan, &buf[0]);
+
+    const double eps = 1e-5 * n;
+    EXPECT_NEAR(re[0], buf[0], eps) << "n = " << n;
+    EXPECT_NEAR(re[n / 2], buf[1], eps) << "n = " << n;
+    for (uint16_t k = 1; k < n / 2; k++) {
+      EXPECT_NEAR(re[k], buf[2 * k], eps) << "n = " << n << " k = " << k;
+      EXPECT_NEAR(im[k], buf[2 * k + 1], eps) << "n = " << n << " k = " << k;
+    }
+
+    rfft_power(&plan, &buf[0]);
+    for (uint16_t k = 0; k < n / 2; k++)
+      EXPECT_NEAR(re[k] * re[k] + im[k] * im[k], buf[k], eps * n) << "n = " << n << " k = " << k;
+  }
+}
+
+TEST_F(RealFFT, ToneInWindow) {
+  const uint16_t n = 256;
+  struct rfft_plan plan;
+  std::vector<float> twiddle(n), window(n), buf(n);
+
+  ASSERT_TRUE(rfft_init(&plan, n, &twiddle[0]));
+  float sum_sq = rfft_hann_window(&window[0], n);
+  EXPECT_NEAR(3.0f * n / 8, sum_sq, 1e-3f);
+
+  /* Amplitude 2 tone centered on bin 20 */
+  for (uint16_t i = 0; i < n; i++)
+    buf[i] = 2.0f * sinf(2 * M_PI * 20 * i / n) * window[i];
+
+  rfft_forward(&plan, &buf[0]);
+  rfft_power(&plan, &buf[0]);
+
+  /* One sided power summed over the bins gives back the tone power A^2 / 2 */
+  double total = 0;
+  for (uint16_t k = 1; k < n / 2; k++)
+    total += 2 * buf[k] / (n * sum_sq);
+  EXPECT_NEAR(2.0, total, 1e-3);
+
+  /* The Hann window leaks into the neighbouring bins only */
+  for (uint16_t k = 0; k < n / 2; k++) {
+    if (k < 19 || k > 21) {
+      EXPECT_LT(buf[k], 1e-6f * buf[20]) << "k = " << k;
+    }
+  }
+}
+
+TEST_F(RealFFT, Benchmark) {
+  const uint16_t sizes[] = {16, 64, 256, 1024};
+
+  for (unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    const uint16_t n = sizes[s];
+    const int iterations = 200000 / n;
+    struct rfft_plan plan;
+    std::vector<float> twiddle(n), window(n), x(n), buf(n);
+
+    ASSERT_TRUE(rfft_init(&plan, n, &twiddle[0]));
+    rfft_hann_window(&window[0], n);
+    for (uint16_t i = 0; i < n; i++)
+      x[i] = (float) rand() / RAND_MAX - 0.5f;
+
+    /* What the vibration analysis does for each axis at every hop */
+    double start = cpu_time();
+    for (int it = 0; it < iterations; it++) {
+      for (uint16_t i = 0; i < n; i++)
+        buf[i] = x[i] * window[i];
+      rfft_forward(&plan, &buf[0]);
+      rfft_power(&plan, &buf[0]);
+    }
+    double elapsed = cpu_time() - start;
+
+    std::vector<double> re, im;
+    start = cpu_time();
+    naive_dft(x, re, im);
+    double dft = cpu_time() - start;
+
+    printf("n = %4u: window + rfft + power %8.3f us, naive DFT %10.3f us\n",
+           n, elapsed / iterations * 1e6, dft * 1e6);
+  }
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,102 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test of the vibration analysis overrun counting
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+
+#include "vibration_overruns.h"
+
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class VibrationOverruns : public testing::Test {
+protected:
+  virtual void SetUp() {
+    last_errors = 0;
+    overruns = 0;
+  }
+
+  virtual void TearDown() {
+  }
+
+  /* One check of count_overruns() against the eventQueueErrors now */
+  void check(uint32_t errors) {
+    overruns = vibration_add_overruns(overruns, vibration_new_queue_errors(errors, &last_errors));
+  }
+
+  uint32_t last_errors;
+  uint16_t overruns;
+};
+
+TEST_F(VibrationOverruns, CountsNewErrors) {
+  check(0);
+  EXPECT_EQ(0, overruns);
+  check(3);
+  EXPECT_EQ(3, overruns);
+  check(3);
+  EXPECT_EQ(3, overruns);
+  check(10);
+  EXPECT_EQ(10, overruns);
+};
+
+TEST_F(VibrationOverruns, StatsClearedBetweenChecks) {
+  check(50);
+  EXPECT_EQ(50, overruns);
+
+  /* The System module cleared the stats, then 4 more errors happened */
+  check(4);
+  EXPECT_EQ(54, overruns);
+
+  /* Cleared with no new errors */
+  check(0);
+  EXPECT_EQ(54, overruns);
+  check(2);
+  EXPECT_EQ(56, overruns);
+};
+
+TEST_F(VibrationOverruns, Saturates) {
+  check(UINT16_MAX - 1);
+  EXPECT_EQ(UINT16_MAX - 1, overruns);
+  check(UINT16_MAX + 100);
+  EXPECT_EQ(UINT16_MAX, overruns);
+  check(UINT32_MAX);
+  EXPECT_EQ(UINT16_MAX, overruns);
+};
+
+/**
+ * @}
+ * @}
+ */
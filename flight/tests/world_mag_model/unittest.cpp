@@ -0,0 +1,233 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test and benchmark of the World Magnetic Model
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
+
+extern "C" {
+
+#include "openpilot.h"
+#include "WorldMagModel.h"
+#include "WMMInternal.h"
+
+}
+
+#include <math.h>		/* fabs() */
+
+static double cpu_time(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* The full model including the secular variation, as WMM_GetMagVector used to evaluate it */
+static int geomag_full(float Lat, float Lon, float Alt, uint16_t Month, uint16_t Day, uint16_t Year, float B[3])
+{
+  WMMtype_CoordSpherical CoordSpherical;
+  WMMtype_CoordGeodetic CoordGeodetic;
+  WMMtype_GeoMagneticElements GeoMagneticElements;
+
+  if (WMM_Initialize() < 0)
+    return -6;
+
+  CoordGeodetic.lambda = Lon;
+  CoordGeodetic.phi = Lat;
+  CoordGeodetic.HeightAboveEllipsoid = Alt / 1000.0f;
+  if (WMM_GeodeticToSpherical(&CoordGeodetic, &CoordSpherical) < 0)
+    return -7;
+
+  if (WMM_DateToYear(Month, Day, Year) < 0)
+    return -8;
+
+  if (WMM_Geomag(&CoordSpherical, &CoordGeodetic, &GeoMagneticElements) < 0)
+    return -9;
+
+  B[0] = GeoMagneticElements.X * 1e-2f;
+  B[1] = GeoMagneticElements.Y * 1e-2f;
+  B[2] = GeoMagneticElements.Z * 1e-2f;
+
+  return 0;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class WorldMagModel : public testing::Test {
+protected:
+  virtual void SetUp() {
+  }
+
+  virtual void TearDown() {
+  }
+};
+
+TEST_F(WorldMagModel, ReferenceValues) {
+  /* Test values published with WMM2015 for 2015.0 at sea level, in nT */
+  const struct {
+    float lat, lon;
+    float X, Y, Z;
+  } ref[] = {
+    {  80,   0,  6627.1f,  -445.9f,  54432.3f },
+    {   0, 120, 39518.2f,   392.9f, -11252.4f },
+    { -80, 240,  5797.3f, 15761.1f, -52919.1f },
+  };
+
+  for (unsigned i = 0; i < sizeof(ref) / sizeof(ref[0]); i++) {
+    float B[3];
+    float lon = ref[i].lon > 180 ? ref[i].lon - 360 : ref[i].lon;
+    ASSERT_EQ(0, WMM_GetMagVector(ref[i].lat, lon, 0, 1, 1, 2015, B));
+
+    /* Single precision evaluation, so allow 10 nT */
+    EXPECT_NEAR(ref[i].X * 1e-2f, B[0], 0.1f);
+    EXPECT_NEAR(ref[i].Y * 1e-2f, B[1], 0.1f);
+    EXPECT_NEAR(ref[i].Z * 1e-2f, B[2], 0.1f);
+  }
+}
+
+TEST_F(WorldMagModel, MatchesFullModel) {
+  for (float lat = -85; lat <= 85; lat += 17) {
+    for (float lon = -180; lon <= 180; lon += 30) {
+      float B[3], B_full[3];
+      ASSERT_EQ(0, WMM_GetMagVector(lat, lon, 1500, 6, 15, 2017, B));
+      ASSERT_EQ(0, geomag_full(lat, lon, 1500, 6, 15, 2017, B_full));
+
+      EXPECT_EQ(B_full[0], B[0]);
+      EXPECT_EQ(B_full[1], B[1]);
+      EXPECT_EQ(B_full[2], B[2]);
+    }
+  }
+}
+
+TEST_F(WorldMagModel, RangeChecks) {
+  float B[3];
+  EXPECT_EQ(-1, WMM_GetMagVector(-91, 0, 0, 1, 1, 2015, B));
+  EXPECT_EQ(-4, WMM_GetMagVector(0, 181, 0, 1, 1, 2015, B));
+  EXPECT_EQ(-8, WMM_GetMagVector(0, 0, 0, 2, 30, 2015, B));
+  EXPECT_EQ(-8, WMM_GetMagVectorCached(0, 0, 0, 13, 1, 2015, B));
+}
+
+TEST_F(WorldMagModel, CachedNearby) {
+  const float lat = 37.4f, lon = -122.1f, alt = 100;
+  float B[3], B_full[3];
+
+  /* The first call is a full evaluation */
+  ASSERT_EQ(0, WMM_GetMagVectorCached(lat, lon, alt, 3, 1, 2016, B));
+  ASSERT_EQ(0, WMM_GetMagVector(lat, lon, alt, 3, 1, 2016, B_full));
+  EXPECT_EQ(B_full[0], B[0]);
+  EXPECT_EQ(B_full[1], B[1]);
+  EXPECT_EQ(B_full[2], B[2]);
+
+  /* Within the threshold the linearization is answered to within 5 nT */
+  const float offsets[][3] = {
+    { 0.05f, 0, 0 }, { 0, 0.08f, 0 }, { -0.06f, -0.05f, 500 }, { 0, 0, -900 },
+  };
+  for (unsigned i = 0; i < sizeof(offsets) / sizeof(offsets[0]); i++) {
+    ASSERT_EQ(0, WMM_GetMagVectorCached(lat + offsets[i][0], lon + offsets[i][1], alt + offsets[i][2], 3, 1, 2016, B));
+    ASSERT_EQ(0, WMM_GetMagVector(lat + offsets[i][0], lon + offsets[i][1], alt + offsets[i][2], 3, 1, 2016, B_full));
+    EXPECT_NEAR(B_full[0], B[0], 0.05f);
+    EXPECT_NEAR(B_full[1], B[1], 0.05f);
+    EXPECT_NEAR(B_full[2], B[2], 0.05f);
+  }
+}
+
+TEST_F(WorldMagModel, CachedRecomputes) {
+  float B[3], B_full[3];
+
+  ASSERT_EQ(0, WMM_GetMagVectorCached(47.0f, 8.0f, 400, 7, 1, 2016, B));
+
+  /* Far away */
+  ASSERT_EQ(0, WMM_GetMagVectorCached(48.0f, 8.0f, 400, 7, 1, 2016, B));
+  ASSERT_EQ(0, WMM_GetMagVector(48.0f, 8.0f, 400, 7, 1, 2016, B_full));
+  EXPECT_EQ(B_full[0], B[0]);
+  EXPECT_EQ(B_full[1], B[1]);
+  EXPECT_EQ(B_full[2], B[2]);
+
+  /* Far away on the cached date, after an uncached call advanced the coefficients to another date */
+  ASSERT_EQ(0, WMM_GetMagVector(48.0f, 8.0f, 400, 7, 1, 2019, B_full));
+  ASSERT_EQ(0, WMM_GetMagVectorCached(49.0f, 8.0f, 400, 7, 1, 2016, B));
+  ASSERT_EQ(0, WMM_GetMagVector(49.0f, 8.0f, 400, 7, 1, 2016, B_full));
+  EXPECT_EQ(B_full[0], B[0]);
+  EXPECT_EQ(B_full[1], B[1]);
+  EXPECT_EQ(B_full[2], B[2]);
+
+  /* Another date at the same place */
+  ASSERT_EQ(0, WMM_GetMagVectorCached(48.0f, 8.0f, 400, 7, 1, 2019, B));
+  ASSERT_EQ(0, WMM_GetMagVector(48.0f, 8.0f, 400, 7, 1, 2019, B_full));
+  EXPECT_EQ(B_full[0], B[0]);
+  EXPECT_EQ(B_full[1], B[1]);
+  EXPECT_EQ(B_full[2], B[2]);
+
+  /* Much higher */
+  ASSERT_EQ(0, WMM_GetMagVectorCached(48.0f, 8.0f, 5000, 7, 1, 2019, B));
+  ASSERT_EQ(0, WMM_GetMagVector(48.0f, 8.0f, 5000, 7, 1, 2019, B_full));
+  EXPECT_EQ(B_full[0], B[0]);
+  EXPECT_EQ(B_full[1], B[1]);
+  EXPECT_EQ(B_full[2], B[2]);
+}
+
+TEST_F(WorldMagModel, Benchmark) {
+  /* A 100 km flight sampled every 10 m */
+  const int N = 10000;
+  const float lat0 = 46.5f, lon0 = 6.6f;
+  float B[3];
+  double start, full, direct, cached;
+
+  start = cpu_time();
+  for (int i = 0; i < N; i++)
+    geomag_full(lat0 + i * 9e-5f, lon0, 500, 5, 1, 2016, B);
+  full = cpu_time() - start;
+
+  start = cpu_time();
+  for (int i = 0; i < N; i++)
+    WMM_GetMagVector(lat0 + i * 9e-5f, lon0, 500, 5, 1, 2016, B);
+  direct = cpu_time() - start;
+
+  start = cpu_time();
+  for (int i = 0; i < N; i++)
+    WMM_GetMagVectorCached(lat0 + i * 9e-5f, lon0, 500, 5, 1, 2016, B);
+  cached = cpu_time() - start;
+
+  printf("full model %8.3f us, WMM_GetMagVector %8.3f us, WMM_GetMagVectorCached %8.3f us per call\n",
+         full / N * 1e6, direct / N * 1e6, cached / N * 1e6);
+
+  EXPECT_LT(cached, direct);
+}
+
+/**
+ * @}
+ * @}
+ */
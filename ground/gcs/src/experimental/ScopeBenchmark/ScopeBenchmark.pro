@@ -0,0 +1,23 @@
+#-------------------------------------------------
+#
+# Benchmark of the scope curve storage and decimation
+#
+#-------------------------------------------------
+
+QT       += core
+QT       -= gui
+
+TARGET = ScopeBenchmark
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+INCLUDEPATH += ../../plugins/scope \
+               ../../libs
+
+HEADERS += ../../plugins/scope/scopes2d/seriesbuffer.h
+SOURCES += ../../plugins/scope/scopes2d/seriesbuffer.cpp \
+           ../../libs/qwt/src/qwt_series_data.cpp
+
+SOURCES += main.cpp
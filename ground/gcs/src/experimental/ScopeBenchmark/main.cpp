@@ -0,0 +1,114 @@
+/**
+ ******************************************************************************
+ *
+ * @file       main.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @brief      Times the scope curve storage on a 1 hour, 100 Hz capture
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "scopes2d/seriesbuffer.h"
+
+#include <QElapsedTimer>
+#include <math.h>
+#include <stdio.h>
+
+#define RATE_HZ       100
+#define DURATION_S    3600
+#define CANVAS_WIDTH  1000
+#define REPEATS       20
+
+/**
+ * Reads all samples of a curve the way QwtPlotCurve does when it draws it
+ */
+static double drawCurve(const QwtSeriesData<QPointF> &data, size_t *points)
+{
+    double sum = 0;
+    *points = data.size();
+    for (size_t i = 0; i < *points; i++) {
+        QPointF p = data.sample(i);
+        sum += p.x() + p.y();
+    }
+    return sum;
+}
+
+/**
+ * Times drawing a view of the capture
+ * @param cached draw again without changing the data or the view
+ */
+static void timeView(const char *name, SeriesBuffer &buffer, double from, double to, bool cached)
+{
+    SeriesBufferData data(&buffer);
+    data.setColumns(CANVAS_WIDTH);
+
+    QElapsedTimer timer;
+    size_t points = 0;
+    double sink = 0;
+
+    timer.start();
+    for (int i = 0; i < REPEATS; i++) {
+        if (!cached) {
+            // A new sample invalidates the view, as in a live plot
+            buffer.append(buffer.x(buffer.size() - 1) + 1.0 / RATE_HZ, 0);
+        }
+        data.setRectOfInterest(QRectF(from, 0, to - from, 1));
+        sink += drawCurve(data, &points);
+    }
+    qint64 ns = timer.nsecsElapsed();
+
+    printf("%-28s %8zu points %10.3f ms per frame%s\n", name, points,
+           ns / 1e6 / REPEATS, sink == 0.12345 ? " " : "");
+}
+
+int main(int argc, char *argv[])
+{
+    Q_UNUSED(argc);
+    Q_UNUSED(argv);
+
+    const int samples = RATE_HZ * DURATION_S;
+    SeriesBuffer buffer;
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < samples; i++) {
+        double t = (double)i / RATE_HZ;
+        buffer.append(t, sin(t * 0.5) + 0.1 * sin(t * 37.0) + ((i % 9973) == 0 ? 3 : 0));
+    }
+    printf("append %d samples            %10.3f ns per sample\n", samples,
+           timer.nsecsElapsed() / (double)samples);
+
+    // Every sample, as the curve was drawn before decimation
+    QVector<QPointF> all;
+    for (int i = 0; i < buffer.size(); i++)
+        all.append(QPointF(buffer.x(i), buffer.y(i)));
+    QwtPointSeriesData allData(all);
+    size_t points = 0;
+    double sink = 0;
+    timer.start();
+    for (int i = 0; i < REPEATS; i++)
+        sink += drawCurve(allData, &points);
+    printf("%-28s %8zu points %10.3f ms per frame%s\n", "all samples", points,
+           timer.nsecsElapsed() / 1e6 / REPEATS, sink == 0.12345 ? " " : "");
+
+    double end = buffer.x(buffer.size() - 1);
+    timeView("full hour, live", buffer, 0, end, false);
+    timeView("full hour, cached", buffer, 0, end, true);
+    timeView("last 10 minutes, live", buffer, end - 600, end, false);
+    timeView("last minute, live", buffer, end - 60, end, false);
+
+    return 0;
+}
@@ -0,0 +1,27 @@
+#-------------------------------------------------
+#
+# Benchmark of the map tile database and memory cache
+#
+#-------------------------------------------------
+
+QT       += core gui sql
+
+TARGET = TileCacheBenchmark
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+DEFINES += TLMAPWIDGET_LIBRARY
+
+INCLUDEPATH += ../../libs/tlmapcontrol
+
+HEADERS += ../../libs/tlmapcontrol/core/maptype.h
+SOURCES += ../../libs/tlmapcontrol/core/pureimagecache.cpp \
+           ../../libs/tlmapcontrol/core/cacheitemqueue.cpp \
+           ../../libs/tlmapcontrol/core/kibertilecache.cpp \
+           ../../libs/tlmapcontrol/core/rawtile.cpp \
+           ../../libs/tlmapcontrol/core/point.cpp \
+           ../../libs/tlmapcontrol/core/size.cpp
+
+SOURCES += main.cpp
@@ -0,0 +1,161 @@
+/**
+ ******************************************************************************
+ *
+ * @file       main.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @brief      Times caching a map region at several zoom levels
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "core/pureimagecache.h"
+#include "core/kibertilecache.h"
+#include "core/rawtile.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <stdio.h>
+
+#define FIRST_ZOOM  12
+#define LAST_ZOOM   16
+#define TILE_BYTES  12000
+#define BATCH_SIZE  64
+#define MEMORY_MB   22
+
+using namespace core;
+
+/**
+ * The tiles of the same region at every zoom level, 2x2 tiles at FIRST_ZOOM
+ */
+static QList<CacheItemQueue> regionTiles()
+{
+    QList<CacheItemQueue> tiles;
+    quint32 seed = 1;
+    for (int zoom = FIRST_ZOOM; zoom <= LAST_ZOOM; zoom++) {
+        int side = 2 << (zoom - FIRST_ZOOM);
+        int first = 1200 << (zoom - FIRST_ZOOM);
+        for (int x = first; x < first + side; x++) {
+            for (int y = first; y < first + side; y++) {
+                // Noise, the images are already compressed
+                QByteArray img(TILE_BYTES, 0);
+                for (int i = 0; i < TILE_BYTES; i++) {
+                    seed = seed * 1664525 + 1013904223;
+                    img[i] = (char)(seed >> 24);
+                }
+                tiles.append(CacheItemQueue(MapType::GoogleSatellite, Point(x, y), img, zoom));
+            }
+        }
+    }
+    return tiles;
+}
+
+/**
+ * Times writing the tiles to a new database
+ * @param batchSize tiles written in each transaction
+ * @param reconnect open a connection for each transaction, as the cache did before
+ */
+static void timeWrites(const char *name, const QString &dir, QList<CacheItemQueue> &tiles, int batchSize, bool reconnect)
+{
+    PureImageCache cache;
+    cache.setGtileCache(dir);
+
+    QElapsedTimer timer;
+    QList<CacheItemQueue*> batch;
+    timer.start();
+    for (int i = 0; i < tiles.size(); i++) {
+        batch.append(&tiles[i]);
+        if (batch.size() == batchSize || i == tiles.size() - 1) {
+            cache.PutImagesToCache(batch);
+            batch.clear();
+            if (reconnect)
+                cache.CloseWriter();
+        }
+    }
+    cache.CloseWriter();
+    qint64 ns = timer.nsecsElapsed();
+
+    printf("%-32s %6d tiles %10.3f ms per tile\n", name, tiles.size(), ns / 1e6 / tiles.size());
+}
+
+/**
+ * Times reading back the tiles
+ */
+static void timeReads(const QString &dir, QList<CacheItemQueue> &tiles)
+{
+    PureImageCache cache;
+    cache.setGtileCache(dir);
+
+    QElapsedTimer timer;
+    int found = 0;
+    timer.start();
+    for (int i = 0; i < tiles.size(); i++) {
+        CacheItemQueue &tile = tiles[i];
+        if (cache.GetImageFromCache(tile.GetMapType(), tile.GetPosition(), tile.GetZoom()) == tile.GetImg())
+            found++;
+    }
+    qint64 ns = timer.nsecsElapsed();
+
+    printf("%-32s %6d tiles %10.3f ms per tile\n", "read back", found, ns / 1e6 / tiles.size());
+}
+
+/**
+ * Times the memory cache while zooming in on the region and back out
+ */
+static void timeMemory(QList<CacheItemQueue> &tiles)
+{
+    KiberTileCache cache;
+    cache.setMemoryCacheCapacity(MEMORY_MB);
+
+    QElapsedTimer timer;
+    int hits = 0;
+    timer.start();
+    for (int i = 0; i < tiles.size(); i++) {
+        CacheItemQueue &tile = tiles[i];
+        cache.AddTile(RawTile(tile.GetMapType(), tile.GetPosition(), tile.GetZoom()), tile.GetImg());
+    }
+    for (int i = tiles.size() - 1; i >= 0; i--) {
+        CacheItemQueue &tile = tiles[i];
+        if (!cache.GetTile(RawTile(tile.GetMapType(), tile.GetPosition(), tile.GetZoom())).isEmpty())
+            hits++;
+    }
+    qint64 ns = timer.nsecsElapsed();
+
+    printf("%-32s %6d hits  %10.3f us per tile, %.1f MB used\n", "memory cache", hits,
+           ns / 1e3 / (2 * tiles.size()), cache.MemoryCacheSize());
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        fprintf(stderr, "Could not create a temporary directory\n");
+        return 1;
+    }
+
+    QList<CacheItemQueue> tiles = regionTiles();
+    printf("zoom %d to %d, %d tiles of %d bytes\n", FIRST_ZOOM, LAST_ZOOM, tiles.size(), TILE_BYTES);
+
+    timeWrites("connection per tile", dir.path() + "/reconnect/", tiles, 1, true);
+    timeWrites("transaction per tile", dir.path() + "/single/", tiles, 1, false);
+    timeWrites("batches of 64", dir.path() + "/batched/", tiles, BATCH_SIZE, false);
+    timeReads(dir.path() + "/batched/", tiles);
+    timeMemory(tiles);
+
+    return 0;
+}
@@ -26,45 +26,67 @@
 * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 */
 #include "kibertilecache.h"
-
-//TODO add readwrite lock
+#include <limits.h>
 
 namespace core {
+    /**
+     * Cost of a capacity in MB, clamped to what QCache can count
+     */
+    static int capacityToCost(int capacity)
+    {
+        return qBound(0, capacity, INT_MAX/1048576)*1048576;
+    }
+
     KiberTileCache::KiberTileCache()
     {
-        memoryCacheSize = 0;
         _MemoryCacheCapacity = 22;
+        cachequeue.setMaxCost(capacityToCost(_MemoryCacheCapacity));
     }
 
     void KiberTileCache::setMemoryCacheCapacity(const int &value)
     {
-        kiberCacheLock.lockForWrite();
+        QMutexLocker locker(&kiberCacheMutex);
         _MemoryCacheCapacity=value;
-        kiberCacheLock.unlock();
+        cachequeue.setMaxCost(capacityToCost(_MemoryCacheCapacity));
     }
     int KiberTileCache::MemoryCacheCapacity()
     {
-        kiberCacheLock.lockForRead();
+        QMutexLocker locker(&kiberCacheMutex);
         return _MemoryCacheCapacity;
-        kiberCacheLock.unlock();
+    }
+    double KiberTileCache::MemoryCacheSize()
+    {
+        QMutexLocker locker(&kiberCacheMutex);
+        return cachequeue.totalCost()/1048576.0;
+    }
+
+    /**
+     * Get a tile and make it the most recently used one, returns an empty array if not cached
+     */
+    QByteArray KiberTileCache::GetTile(const RawTile &tile)
+    {
+        QMutexLocker locker(&kiberCacheMutex);
+        QByteArray *pic=cachequeue.object(tile);
+        return pic ? *pic : QByteArray();
+    }
+    /**
+     * Add a tile, the least recently used tiles are evicted to stay within the capacity
+     */
+    void KiberTileCache::AddTile(const RawTile &tile, const QByteArray &pic)
+    {
+        if(pic.isEmpty())
+            return;
+        QMutexLocker locker(&kiberCacheMutex);
+        cachequeue.insert(tile,new QByteArray(pic),pic.size());
     }
 
     void KiberTileCache::RemoveMemoryOverload()
     {
-        while(MemoryCacheSize()>MemoryCacheCapacity())
-        {
-            if(cachequeue.count()>0 && list.count()>0)
-            {
-#ifdef DEBUG_MEMORY_CACHE
-                qDebug()<<"Cleaning Memory cache="<<" started with "<<cachequeue.count()<<" tile "<<"ocupying "<<memoryCacheSize<<" bytes";
-#endif
-                RawTile first=list.dequeue();
-                memoryCacheSize-=cachequeue.value(first).size();
-                cachequeue.remove(first);
-            }
-        }
+        // The tiles are evicted as they are added, this only reapplies the capacity
+        QMutexLocker locker(&kiberCacheMutex);
+        cachequeue.setMaxCost(capacityToCost(_MemoryCacheCapacity));
 #ifdef DEBUG_MEMORY_CACHE
-        qDebug()<<"Cleaning Memory cache="<<" ended with "<<cachequeue.count()<<" tile "<<"ocupying "<<memoryCacheSize<<" bytes";
+        qDebug()<<"Cleaning Memory cache="<<" ended with "<<cachequeue.count()<<" tile "<<"ocupying "<<cachequeue.totalCost()<<" bytes";
 #endif
     }
 }
@@ -30,8 +30,7 @@
 
 #include "rawtile.h"
 #include <QMutex>
-#include <QReadWriteLock>
-#include <QQueue>
+#include <QCache>
 #include <QDebug>
 #include "debugheader.h"
 namespace core {
@@ -42,13 +41,14 @@ namespace core {
 
         void setMemoryCacheCapacity(const int &value);
         int MemoryCacheCapacity();
-        double MemoryCacheSize(){return memoryCacheSize/1048576.0;}
+        double MemoryCacheSize();
         void RemoveMemoryOverload();
-        QReadWriteLock kiberCacheLock;
-        QHash <RawTile,QByteArray> cachequeue;
-        QQueue <RawTile> list;
-        long memoryCacheSize;
+        QByteArray GetTile(const RawTile &tile);
+        void AddTile(const RawTile &tile, const QByteArray &pic);
     private:
+        // Least recently used first out, the cost of a tile is its size in bytes
+        QCache <RawTile,QByteArray> cachequeue;
+        QMutex kiberCacheMutex;
         int _MemoryCacheCapacity;
 
     };
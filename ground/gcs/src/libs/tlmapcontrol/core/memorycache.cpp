@@ -26,7 +26,6 @@
 * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 */
 #include "memorycache.h"
-//TODO add readwrite lock
 
 namespace core {
     MemoryCache::MemoryCache()
@@ -37,25 +36,14 @@ namespace core {
 
     QByteArray MemoryCache::GetTileFromMemoryCache(const RawTile &tile)
     {
-        kiberCacheLock.lockForRead();
-        QByteArray pic;
-        pic=TilesInMemory.cachequeue.value(tile);
-        // TilesInMemory.find(key,&pic);
-        kiberCacheLock.unlock();
-        return pic;
+        return TilesInMemory.GetTile(tile);
     }
     void MemoryCache::AddTileToMemoryCache(const RawTile &tile, const QByteArray &pic)
     {
-        kiberCacheLock.lockForWrite();
-        // QPixmapCache::Key key=TilesInMemory.insert(pic);
-        TilesInMemory.memoryCacheSize +=pic.size();
+        TilesInMemory.AddTile(tile,pic);
 #ifdef DEBUG_MEMORY_CACHE
-        qDebug()<<"Current memory="<<TilesInMemory.memoryCacheSize<<" in "<<TilesInMemory.cachequeue.count()<<" tiles";
+        qDebug()<<"Current memory="<<TilesInMemory.MemoryCacheSize()<<" MB";
 #endif
-        TilesInMemory.cachequeue.insert(tile,pic);
-        TilesInMemory.list.enqueue(tile);
-
-        kiberCacheLock.unlock();
     }
 
 }
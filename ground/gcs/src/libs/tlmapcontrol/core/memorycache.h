@@ -30,7 +30,6 @@
 
 #include "rawtile.h"
 #include <QMutex>
-#include <QReadWriteLock>
 #include <QQueue>
 #include "kibertilecache.h"
 #include <QDebug>
@@ -44,7 +43,6 @@ namespace core {
         KiberTileCache TilesInMemory;
         QByteArray GetTileFromMemoryCache(const RawTile &tile);
         void AddTileToMemoryCache(const RawTile &tile, const QByteArray &pic);
-        QReadWriteLock kiberCacheLock;
     };
 
 
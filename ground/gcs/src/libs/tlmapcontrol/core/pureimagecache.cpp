@@ -32,7 +32,7 @@
 namespace core {
     qlonglong PureImageCache::ConnCounter=0;
 
-    PureImageCache::PureImageCache()
+    PureImageCache::PureImageCache():insertTile(0),insertTileData(0)
     {
 
     }
@@ -172,55 +172,109 @@ namespace core {
         QSqlDatabase::removeDatabase(QLatin1String("CreateConn"));
         return true;
     }
-    bool PureImageCache::PutImageToCache(const QByteArray &tile, const MapType::Types &type,const Point &pos,const int &zoom)
+    /**
+     * Open the writer connection on the current cache database, if it isn't open yet.
+     * The connection is kept open between the batches and the statements are prepared once.
+     */
+    bool PureImageCache::OpenWriter()
     {
-        if(gtilecache.isEmpty()|gtilecache.isNull())
-            return false;
-        lock.lockForRead();
-#ifdef DEBUG_PUREIMAGECACHE
-        qDebug()<<"PutImageToCache Start:";//<<pos;
-#endif //DEBUG_PUREIMAGECACHE
-        Mcounter.lock();
-        qlonglong id=++ConnCounter;
-        Mcounter.unlock();
+        QString db=gtilecache+"Data.qmdb";
+        if(writerDatabase==db)
+            return true;
+        CloseWriter();
+        bool opened;
         {
-            QSqlDatabase cn;
-            cn = QSqlDatabase::addDatabase("QSQLITE",QString::number(id));
-            QString db=gtilecache+"Data.qmdb";
+            QSqlDatabase cn = QSqlDatabase::addDatabase("QSQLITE",QLatin1String("WriterConn"));
             cn.setDatabaseName(db);
-            cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-            if(cn.open())
+            opened=cn.open();
+            if(opened)
             {
                 {
+                    // Readers don't wait for the writer, and a commit doesn't wait for a full sync
                     QSqlQuery query(cn);
-                    query.prepare("INSERT INTO Tiles(X, Y, Zoom, Type,Date) VALUES(?, ?, ?, ?,?)");
-                    query.addBindValue(pos.X());
-                    query.addBindValue(pos.Y());
-                    query.addBindValue(zoom);
-
-                    query.addBindValue((int)type);
-                    query.addBindValue(QDateTime::currentDateTime().toString());
-                    query.exec();
+                    query.exec("PRAGMA journal_mode=WAL");
+                    query.exec("PRAGMA synchronous=NORMAL");
                 }
-                {
-                    QSqlQuery query(cn);
-                    query.prepare("INSERT INTO TilesData(id, Tile) VALUES((SELECT last_insert_rowid()), ?)");
-                    query.addBindValue(tile);
-                    query.exec();
-                }
-                cn.close();
+                insertTile=new QSqlQuery(cn);
+                insertTile->prepare("INSERT INTO Tiles(X, Y, Zoom, Type,Date) VALUES(?, ?, ?, ?,?)");
+                insertTileData=new QSqlQuery(cn);
+                insertTileData->prepare("INSERT INTO TilesData(id, Tile) VALUES(?, ?)");
+                writerDatabase=db;
             }
+#ifdef DEBUG_PUREIMAGECACHE
+            else
+                qDebug()<<"OpenWriter: "<<cn.lastError().driverText();
+#endif //DEBUG_PUREIMAGECACHE
         }
-        QSqlDatabase::removeDatabase(QString::number(id));
+        if(!opened)
+            QSqlDatabase::removeDatabase(QLatin1String("WriterConn"));
+        return opened;
+    }
+    /**
+     * Close the writer connection, must be called from the thread which wrote the tiles
+     */
+    void PureImageCache::CloseWriter()
+    {
+        if(writerDatabase.isEmpty())
+            return;
+        delete insertTile;
+        insertTile=0;
+        delete insertTileData;
+        insertTileData=0;
+        QSqlDatabase::database(QLatin1String("WriterConn"),false).close();
+        QSqlDatabase::removeDatabase(QLatin1String("WriterConn"));
+        writerDatabase.clear();
+    }
+    /**
+     * Write a batch of tiles in a single transaction
+     */
+    bool PureImageCache::PutImagesToCache(const QList<CacheItemQueue*> &tiles)
+    {
+        lock.lockForRead();
+        if(gtilecache.isEmpty() || !OpenWriter())
+        {
+            lock.unlock();
+            return false;
+        }
+#ifdef DEBUG_PUREIMAGECACHE
+        qDebug()<<"PutImagesToCache Start:"<<tiles.count();
+#endif //DEBUG_PUREIMAGECACHE
+        QSqlDatabase cn=QSqlDatabase::database(QLatin1String("WriterConn"),false);
+        QString date=QDateTime::currentDateTime().toString();
+        bool transaction=cn.transaction();
+        foreach(CacheItemQueue *tile,tiles)
+        {
+            insertTile->addBindValue(tile->GetPosition().X());
+            insertTile->addBindValue(tile->GetPosition().Y());
+            insertTile->addBindValue(tile->GetZoom());
+            insertTile->addBindValue((int)tile->GetMapType());
+            insertTile->addBindValue(date);
+            if(!insertTile->exec())
+            {
+#ifdef DEBUG_PUREIMAGECACHE
+                qDebug()<<"PutImagesToCache: "<<insertTile->lastError().driverText();
+#endif //DEBUG_PUREIMAGECACHE
+                continue;
+            }
+            insertTileData->addBindValue(insertTile->lastInsertId());
+            insertTileData->addBindValue(tile->GetImg());
+            insertTileData->exec();
+        }
+        bool ret=!transaction || cn.commit();
+        if(!ret)
+            cn.rollback();
         lock.unlock();
-        return true;
+        return ret;
     }
     QByteArray PureImageCache::GetImageFromCache(MapType::Types type, Point pos, int zoom)
     {
-        lock.lockForRead();
         QByteArray ar;
+        lock.lockForRead();
         if(gtilecache.isEmpty()|gtilecache.isNull())
+        {
+            lock.unlock();
             return ar;
+        }
         QString dir=gtilecache;
         Mcounter.lock();
         qlonglong id=++ConnCounter;
@@ -40,6 +40,7 @@
 #include "point.h"
 #include <QVariant>
 #include "pureimage.h"
+#include "cacheitemqueue.h"
 #include <QList>
 #include <QMutex>
 #include <QReadWriteLock>
@@ -50,17 +51,23 @@ namespace core {
     public:
         PureImageCache();
         static bool CreateEmptyDB(const QString &file);
-        bool PutImageToCache(const QByteArray &tile,const MapType::Types &type,const core::Point &pos, const int &zoom);
+        bool PutImagesToCache(const QList<CacheItemQueue*> &tiles);
+        void CloseWriter();
         QByteArray GetImageFromCache(MapType::Types type, core::Point pos, int zoom);
         QString GtileCache();
         void setGtileCache(const QString &value);
         static bool ExportMapDataToDB(QString sourceFile, QString destFile);
         void deleteOlderTiles(int const& days);
     private:
+        bool OpenWriter();
         QString gtilecache;
         QMutex Mcounter;
         QReadWriteLock lock;
         static qlonglong ConnCounter;
+        // Writer connection, only used by the thread which writes the tiles
+        QString writerDatabase;
+        QSqlQuery *insertTile;
+        QSqlQuery *insertTileData;
 
     };
 
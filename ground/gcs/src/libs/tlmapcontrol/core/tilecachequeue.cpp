@@ -31,7 +31,7 @@
 //#define DEBUG_TILECACHEQUEUE
  
 namespace core {
-TileCacheQueue::TileCacheQueue()
+TileCacheQueue::TileCacheQueue():running(false)
 {
 
 }
@@ -43,87 +43,73 @@ TileCacheQueue::~TileCacheQueue()
 void TileCacheQueue::EnqueueCacheTask(CacheItemQueue *task)
 {
 #ifdef DEBUG_TILECACHEQUEUE
-    qDebug()<<"DB Do I EnqueueCacheTask"<<task->GetPosition().X()<<","<<task->GetPosition().Y();
+    qDebug()<<"EnqueueCacheTask"<<task->GetPosition().X()<<","<<task->GetPosition().Y();
 #endif //DEBUG_TILECACHEQUEUE
-    if(!tileCacheQueue.contains(task))
+    QMutexLocker locker(&mutex);
+    tileCacheQueue.enqueue(task);
+    if(running)
     {
 #ifdef DEBUG_TILECACHEQUEUE
-        qDebug()<<"EnqueueCacheTask"<<task->GetPosition().X()<<","<<task->GetPosition().Y();
+        qDebug()<<"Wake Thread";
 #endif //DEBUG_TILECACHEQUEUE
-        mutex.lock();
-        tileCacheQueue.enqueue(task);
-        mutex.unlock();
-        if(this->isRunning())
-        {
-#ifdef DEBUG_TILECACHEQUEUE
-            qDebug()<<"Wake Thread";
-#endif //DEBUG_TILECACHEQUEUE
-            //this->start(QThread::NormalPriority);
-            //waitmutex.lock();
-            waitc.wakeAll();
-            //waitmutex.unlock();
-        }
-        else
-        {
+        waitc.wakeAll();
+    }
+    else
+    {
 #ifdef DEBUG_TILECACHEQUEUE
-            qDebug()<<"Start Thread";
+        qDebug()<<"Start Thread";
 #endif //DEBUG_TILECACHEQUEUE
-            this->start(QThread::NormalPriority);
-        }
+        running=true;
+        // The thread may still be returning from run() after it stopped
+        wait();
+        this->start(QThread::NormalPriority);
     }
-
 }
+/**
+ * Write the queued tiles to the database, taking up to MAX_BATCH_SIZE tiles at a time
+ * so that they are written in a single transaction. The thread stops when nothing was
+ * queued for IDLE_TIMEOUT_MS.
+ */
 void TileCacheQueue::run()
 {
 #ifdef DEBUG_TILECACHEQUEUE
     qDebug()<<"Cache Engine Start";
 #endif //DEBUG_TILECACHEQUEUE
+    QList<CacheItemQueue*> batch;
     while(true)
     {
-        CacheItemQueue *task;
-#ifdef DEBUG_TILECACHEQUEUE
-        qDebug()<<"Cache";
-#endif //DEBUG_TILECACHEQUEUE
-        if(tileCacheQueue.count()>0)
-        {
-            mutex.lock();
-            task=tileCacheQueue.dequeue();
-            mutex.unlock();
-#ifdef DEBUG_TILECACHEQUEUE
-            qDebug()<<"Cache engine Put:"<<task->GetPosition().X()<<","<<task->GetPosition().Y();
-#endif //DEBUG_TILECACHEQUEUE
-            Cache::Instance()->ImageCache.PutImageToCache(task->GetImg(),task->GetMapType(),task->GetPosition(),task->GetZoom());
-            usleep(44);
-            delete task;
-        }
-
-        else
+        mutex.lock();
+        if(tileCacheQueue.isEmpty())
         {
 #ifdef DEBUG_TILECACHEQUEUE
             qDebug()<<"Cache engine BEGIN WAIT";
 #endif //DEBUG_TILECACHEQUEUE
-            waitmutex.lock();
-            int tout=4000;
-            if(!waitc.wait(&waitmutex,tout))
+            if(!waitc.wait(&mutex,IDLE_TIMEOUT_MS) && tileCacheQueue.isEmpty())
             {
-                waitmutex.unlock();
 #ifdef DEBUG_TILECACHEQUEUE
                 qDebug()<<"Cache Engine TimeOut";
 #endif //DEBUG_TILECACHEQUEUE
-                mutex.lock();
-                if(tileCacheQueue.count()==0)
-                {
-                    mutex.unlock();
-                    break;
-                }
+                running=false;
                 mutex.unlock();
+                break;
             }
+        }
+        while(!tileCacheQueue.isEmpty() && batch.count()<MAX_BATCH_SIZE)
+            batch.append(tileCacheQueue.dequeue());
+        mutex.unlock();
+
+        if(!batch.isEmpty())
+        {
 #ifdef DEBUG_TILECACHEQUEUE
-            qDebug()<<"Cache Engine DID NOT TimeOut";
+            qDebug()<<"Cache engine Put:"<<batch.count()<<"tiles";
 #endif //DEBUG_TILECACHEQUEUE
-            waitmutex.unlock();
+            Cache::Instance()->ImageCache.PutImagesToCache(batch);
+            qDeleteAll(batch);
+            batch.clear();
         }
     }
+    // The connection belongs to this thread, it is opened again by the next run
+    Cache::Instance()->ImageCache.CloseWriter();
 #ifdef DEBUG_TILECACHEQUEUE
     qDebug()<<"Cache Engine Stopped";
 #endif //DEBUG_TILECACHEQUEUE
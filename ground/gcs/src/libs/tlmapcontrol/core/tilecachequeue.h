@@ -51,10 +51,12 @@ namespace core {
     protected:
         QQueue<CacheItemQueue*> tileCacheQueue;
     private:
+        static const int MAX_BATCH_SIZE = 64;
+        static const int IDLE_TIMEOUT_MS = 4000;
         void run();
         QMutex mutex;
-        QMutex waitmutex;
         QWaitCondition waitc;
+        bool running;
     };
 }
 #endif // TILECACHEQUEUE_H
@@ -191,9 +191,7 @@ namespace internals {
                     // last buddy cleans stuff ;}
                     if(last)
                     {
-                        TLMaps::Instance()->kiberCacheLock.lockForWrite();
                         TLMaps::Instance()->TilesInMemory.RemoveMemoryOverload();
-                        TLMaps::Instance()->kiberCacheLock.unlock();
 
                         MtileDrawingList.lock();
                         {
@@ -38,7 +38,13 @@
 
 LogFile::LogFile(QObject *parent) :
     QIODevice(parent),
-    timestampBufferIdx(0)
+    lastPlayTime(0),
+    lastPlayTimeOffset(0),
+    playbackSpeed(1),
+    replayBufferOffset(0),
+    replayBufferSize(0),
+    replayIdx(0),
+    firstTimestamp(0)
 {
     connect(&timer, SIGNAL(timeout()), this, SLOT(timerFired()));
 }
@@ -52,7 +58,7 @@ bool LogFile::open(OpenMode mode) {
 
     // start a timer for playback
     myTime.restart();
-    if (file.isOpen()) {
+    if (file.isOpen() || reader.isOpen()) {
         // We end up here when doing a replay, because the connection
         // manager will also try to open the QIODevice, even though we just
         // opened it after selecting the file, which happens before the
@@ -60,8 +66,10 @@ bool LogFile::open(OpenMode mode) {
         return true;
     }
 
-    //Open file as either WriteOnly, or ReadOnly, depending on `mode` parameter
-    if(file.open(mode) == false)
+    //Open file as either WriteOnly, or ReadOnly, depending on `mode` parameter.
+    //Replayed files are memory mapped by the reader.
+    bool opened = (mode == QIODevice::ReadOnly) ? reader.open(file.fileName()) : file.open(mode);
+    if(opened == false)
     {
         qDebug() << "Unable to open " << file.fileName() << " for logging";
         return false;
@@ -87,9 +95,8 @@ bool LogFile::open(OpenMode mode) {
     }
     else if(mode == QIODevice::ReadOnly)
     {
-        file.readLine(); //Read first line of log file. This assumes that the logfile is of the new format.
-        QString logGitHashString=file.readLine().trimmed(); //Read second line of log file. This assumes that the logfile is of the new format.
-        QString logUAVOHashString=file.readLine().trimmed(); //Read third line of log file. This assumes that the logfile is of the new format.
+        QString logGitHashString = reader.getGitHash(); //This assumes that the logfile is of the new format.
+        QString logUAVOHashString = reader.getUAVOHash();
         QString gitHash = QString::fromLatin1(Core::Constants::GCS_REVISION_STR);
         QString uavoHash = QString::fromLatin1(Core::Constants::UAVOSHA1_STR).replace("\"{ ", "").replace(" }\"", "").replace(",", "").replace("0x", ""); // See comment above for necessity for string replacements
 
@@ -106,22 +113,12 @@ bool LogFile::open(OpenMode mode) {
             msgBox.exec();
         }
 
-        QString tmpLine=file.readLine(); //Look for the header/body separation string.
-        int cnt=0;
-        while (tmpLine!="##\n" && cnt < 10 && !file.atEnd()){
-            tmpLine=file.readLine().trimmed();
-            cnt++;
-        }
-
-        //Check if we reached the end of the file before finding the separation string
-        if (cnt >=10 || file.atEnd()){
+        //Check if the header/body separation string was found. If not, the reader plays the file from the beginning.
+        if (!reader.hasHeader()){
             QMessageBox msgBox;
             msgBox.setText("Corrupted file.");
             msgBox.setInformativeText("GCS cannot find the separation byte. GCS will attempt to play the file."); //<--TODO: add hyperlink to webpage with better description.
             msgBox.exec();
-
-            //Since we could not find the file separator, we need to return to the beginning of the file
-            file.seek(0);
         }
 
     }
@@ -144,6 +141,15 @@ void LogFile::close()
 
     if (timer.isActive())
         timer.stop();
+
+    // The queued packets point into the mapped file
+    mutex.lock();
+    replayBuffer.clear();
+    replayBufferOffset = 0;
+    replayBufferSize = 0;
+    mutex.unlock();
+
+    reader.close();
     file.close();
     QIODevice::close();
 }
@@ -166,124 +172,67 @@ qint64 LogFile::writeData(const char * data, qint64 dataSize) {
 
 qint64 LogFile::readData(char * data, qint64 maxSize) {
     QMutexLocker locker(&mutex);
-    qint64 toRead = qMin(maxSize,(qint64)dataBuffer.size());
-    memcpy(data,dataBuffer.data(),toRead);
-    dataBuffer.remove(0,toRead);
-    return toRead;
+
+    // Copy the due packets straight from the mapped file
+    qint64 read = 0;
+    while (read < maxSize && !replayBuffer.isEmpty()) {
+        const QByteArray &packet = replayBuffer.head();
+        qint64 toRead = qMin(maxSize - read, (qint64) (packet.size() - replayBufferOffset));
+        memcpy(data + read, packet.constData() + replayBufferOffset, toRead);
+        read += toRead;
+        replayBufferOffset += toRead;
+
+        if (replayBufferOffset == packet.size()) {
+            replayBuffer.dequeue();
+            replayBufferOffset = 0;
+        }
+    }
+
+    replayBufferSize -= read;
+    return read;
 }
 
 qint64 LogFile::bytesAvailable() const
 {
-    return dataBuffer.size();
+    return replayBufferSize;
 }
 
 void LogFile::timerFired()
 {
-    qint64 dataSize;
+    int time = myTime.elapsed();
+    lastPlayTime += (time - lastPlayTimeOffset) * playbackSpeed;
+    lastPlayTimeOffset = time;
+
+    //Queue the packets that are due
+    bool queued = false;
+    mutex.lock();
+    while (replayIdx < reader.getPacketCount() && (qint64) reader.getTimestamp(replayIdx) - firstTimestamp <= lastPlayTime) {
+        QByteArray packet = reader.getPacket(replayIdx++);
+        if (packet.isEmpty())
+            continue;
 
-    if(file.bytesAvailable() > 4)
-    {
+        replayBuffer.enqueue(packet);
+        replayBufferSize += packet.size();
+        queued = true;
+    }
+    mutex.unlock();
 
-        int time;
-        time = myTime.elapsed();
-
-        //Read packets
-        while ((lastPlayTime + ((time - lastPlayTimeOffset)* playbackSpeed) > (lastTimeStamp-firstTimestamp)))
-        {
-            lastPlayTime += ((time - lastPlayTimeOffset)* playbackSpeed);
-            if(file.bytesAvailable() < 4) {
-                stopReplay();
-                return;
-            }
-
-            file.seek(lastTimeStampPos+sizeof(lastTimeStamp));
-
-            file.read((char *) &dataSize, sizeof(dataSize));
-
-            if (dataSize<1 || dataSize>(1024*1024)) {
-                qDebug() << "Error: Logfile corrupted! Unlikely packet size: " << dataSize << "\n";
-                stopReplay();
-                return;
-            }
-            if(file.bytesAvailable() < dataSize) {
-                stopReplay();
-                return;
-            }
-
-            mutex.lock();
-            dataBuffer.append(file.read(dataSize));
-            mutex.unlock();
-            emit readyRead();
-
-            if(file.bytesAvailable() < 4) {
-                stopReplay();
-                return;
-            }
-
-            lastTimeStampPos = timestampPos[timestampBufferIdx];
-            lastTimeStamp = timestampBuffer[timestampBufferIdx];
-            timestampBufferIdx++;
-
-            lastPlayTimeOffset = time;
-            time = myTime.elapsed();
+    if (queued)
+        emit readyRead();
 
-        }
-    } else {
+    if (replayIdx >= reader.getPacketCount())
         stopReplay();
-    }
-
 }
 
 bool LogFile::startReplay() {
-    dataBuffer.clear();
     myTime.restart();
     lastPlayTimeOffset = 0;
     lastPlayTime = 0;
     playbackSpeed = 1;
-
-    //Read all log timestamps into array
-    timestampBuffer.clear(); //Save beginning of log for later use
-    timestampPos.clear();
-    quint64 logFileStartIdx = file.pos();
-    timestampBufferIdx = 0;
-    lastTimeStamp = 0;
-
-    while (!file.atEnd()){
-        qint64 dataSize;
-
-        //Get time stamp position
-        timestampPos.append(file.pos());
-
-        //Read timestamp and logfile packet size
-        file.read((char *) &lastTimeStamp, sizeof(lastTimeStamp));
-        file.read((char *) &dataSize, sizeof(dataSize));
-
-        //Check if dataSize sync bytes are correct.
-        //TODO: LIKELY AS NOT, THIS WILL FAIL TO RESYNC BECAUSE THERE IS TOO LITTLE INFORMATION IN THE STRING OF SIX 0x00
-        if ((dataSize & 0xFFFFFFFFFFFF0000)!=0){
-            qDebug() << "Wrong sync byte. At file location 0x"  << QString("%1").arg(file.pos(),0,16) << "Got 0x" << QString("%1").arg(dataSize & 0xFFFFFFFFFFFF0000,0,16) << ", but expected 0x""00"".";
-            file.seek(timestampPos.last()+1);
-            timestampPos.pop_back();
-            continue;
-        }
-
-        //Check if timestamps are sequential.
-        if (!timestampBuffer.isEmpty() && lastTimeStamp < timestampBuffer.last()){
-            QMessageBox msgBox;
-            msgBox.setText("Corrupted file.");
-            msgBox.setInformativeText("Timestamps are not sequential. Playback may have unexpected behavior"); //<--TODO: add hyperlink to webpage with better description.
-            msgBox.exec();
-
-            qDebug() << "Timestamp: " << timestampBuffer.last() << " " << lastTimeStamp;
-        }
-
-        timestampBuffer.append(lastTimeStamp);
-
-        file.seek(timestampPos.last()+sizeof(lastTimeStamp)+sizeof(dataSize)+dataSize);
-    }
+    replayIdx = 0;
 
     //Check if any timestamps were successfully read
-    if (timestampBuffer.size() == 0){
+    if (reader.getPacketCount() == 0){
         QMessageBox msgBox;
         msgBox.setText("Empty logfile.");
         msgBox.setInformativeText("No log data can be found.");
@@ -293,12 +242,15 @@ bool LogFile::startReplay() {
         return false;
     }
 
-    //Reset to log beginning.
-    file.seek(logFileStartIdx+sizeof(lastTimeStamp));
-    lastTimeStampPos = timestampPos[0];
-    lastTimeStamp = timestampBuffer[0];
-    firstTimestamp = timestampBuffer[0];
-    timestampBufferIdx = 1;
+    //Check if timestamps are sequential.
+    if (!reader.isSequential()){
+        QMessageBox msgBox;
+        msgBox.setText("Corrupted file.");
+        msgBox.setInformativeText("Timestamps are not sequential. Playback may have unexpected behavior"); //<--TODO: add hyperlink to webpage with better description.
+        msgBox.exec();
+    }
+
+    firstTimestamp = reader.getTimestamp(0);
 
     timer.setInterval(10);
     timer.start();
@@ -325,21 +277,19 @@ void LogFile::resumeReplay()
 
 /**
  * @brief LogFile::setReplayTime, sets the playback time
- * @param val, the time in
+ * @param val, the time in s since the start of the log
  */
 void LogFile::setReplayTime(double val)
 {
-    quint32 tmpIdx=0;
-    while(timestampBuffer[tmpIdx++] <= val*1000 && tmpIdx <= timestampBufferIdx){
-    }
+    if (!reader.isOpen() || reader.getPacketCount() == 0)
+        return;
 
-    lastTimeStampPos=timestampPos[tmpIdx];
-    lastTimeStamp=timestampBuffer[tmpIdx];
-    timestampBufferIdx=tmpIdx;
+    //The packets are indexed by time, seeking is a binary search
+    QMutexLocker locker(&mutex);
+    replayIdx = reader.findPacket(firstTimestamp + qMax(val, 0.0) * 1000);
 
     lastPlayTimeOffset = myTime.elapsed();
-    lastPlayTime=lastTimeStamp;
+    lastPlayTime = val * 1000;
 
-    qDebug() << "Replaying at: " << lastTimeStamp << ", but requestion at" << val*1000;
+    qDebug() << "Replaying at: " << (replayIdx < reader.getPacketCount() ? reader.getTimestamp(replayIdx) - firstTimestamp : 0) << ", but requestion at" << val*1000;
 }
-
@@ -34,7 +34,9 @@
 #include <QMutexLocker>
 #include <QDebug>
 #include <QBuffer>
+#include <QQueue>
 #include "uavobjectmanager.h"
+#include "logreader.h"
 #include <math.h>
 
 class LogFile : public QIODevice
@@ -68,12 +70,11 @@ signals:
     void replayFinished();
 
 protected:
-    QByteArray dataBuffer;
     QTimer timer;
     QTime myTime;
     QFile file;
-    quint32 lastTimeStamp;
-    quint32 lastPlayTime;
+    LogReader reader;
+    double lastPlayTime;
     QMutex mutex;
 
 
@@ -81,10 +82,10 @@ protected:
     double playbackSpeed;
 
 private:
-    QList<quint32> timestampBuffer;
-    QList<quint32> timestampPos;
-    quint32 timestampBufferIdx;
-    quint32 lastTimeStampPos;
+    QQueue<QByteArray> replayBuffer;    //Views of the packets that are due, in the mapped file
+    int replayBufferOffset;             //Bytes of the first packet that were read
+    qint64 replayBufferSize;
+    int replayIdx;                      //Next packet that is due
     quint32 firstTimestamp;
 };
 
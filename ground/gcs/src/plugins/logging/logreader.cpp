@@ -0,0 +1,291 @@
+/**
+ ******************************************************************************
+ *
+ * @file       logreader.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @brief      Memory mapped reader of GCS log files
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "logreader.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QDateTime>
+#include <algorithm>
+#include <string.h>
+
+//! Timestamp and packet size in front of each packet
+#define RECORD_HEADER_SIZE (sizeof(quint32) + sizeof(qint64))
+
+//! Lines of the header that are searched for the "##" line
+#define MAX_HEADER_LINES 14
+
+#define INDEX_MAGIC "TLLOGIDX"
+#define INDEX_VERSION 1
+
+/**
+ * Header of the index file. The timestamps follow it, then the offsets.
+ */
+struct IndexHeader {
+    char magic[8];
+    quint32 version;
+    quint32 count;
+    qint64 logSize;
+    qint64 logModified;     //ms since epoch
+    qint64 bodyStart;
+    quint32 sequential;
+    quint32 reserved;
+};
+
+LogReader::LogReader() :
+    data(NULL),
+    size(0),
+    headerFound(false),
+    bodyStart(0),
+    sequential(true)
+{
+}
+
+LogReader::~LogReader()
+{
+    close();
+}
+
+/**
+ * @brief LogReader::open Maps a log file and indexes its packets
+ * @param fileName The log file
+ * @return false if the file can't be read
+ */
+bool LogReader::open(const QString &fileName)
+{
+    close();
+
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Unable to open " << fileName << " for replay";
+        return false;
+    }
+
+    size = file.size();
+    data = size > 0 ? file.map(0, size) : NULL;
+    if (data == NULL) {
+        // Not every file can be mapped, fall back to reading all of it
+        contents = file.readAll();
+        data = (const uchar *) contents.constData();
+        size = contents.size();
+    }
+
+    parseHeader();
+
+    if (!loadIndex()) {
+        buildIndex();
+        saveIndex();
+    }
+
+    return true;
+}
+
+/**
+ * @brief LogReader::close Unmaps the file. The packets handed out become invalid.
+ */
+void LogReader::close()
+{
+    // Closing the file also unmaps it
+    file.close();
+    contents.clear();
+    data = NULL;
+    size = 0;
+
+    gitHash.clear();
+    uavoHash.clear();
+    headerFound = false;
+    bodyStart = 0;
+    timestamps.clear();
+    offsets.clear();
+    sequential = true;
+}
+
+/**
+ * @brief LogReader::getPacket Returns a packet without copying it
+ * @param idx Index of the packet
+ * @return a view of the packet in the file, valid until the reader is closed
+ */
+QByteArray LogReader::getPacket(int idx) const
+{
+    qint64 offset = offsets.at(idx);
+    qint64 packetSize;
+    memcpy(&packetSize, data + offset + sizeof(quint32), sizeof(packetSize));
+
+    if (packetSize < 0 || offset + (qint64) RECORD_HEADER_SIZE + packetSize > size)
+        return QByteArray();
+
+    return QByteArray::fromRawData((const char *) data + offset + RECORD_HEADER_SIZE, packetSize);
+}
+
+/**
+ * @brief LogReader::findPacket Binary search for the packet recorded at a time
+ * @param timestamp Time in ms since the start of the recording
+ * @return the first packet recorded at or after timestamp, getPacketCount() if none
+ */
+int LogReader::findPacket(quint32 timestamp) const
+{
+    return std::lower_bound(timestamps.constBegin(), timestamps.constEnd(), timestamp) - timestamps.constBegin();
+}
+
+/**
+ * @brief LogReader::indexFileName Returns the name of the index cached for a log file
+ */
+QString LogReader::indexFileName(const QString &fileName)
+{
+    return fileName + ".idx";
+}
+
+/**
+ * @brief LogReader::parseHeader Reads the hashes in the header and finds the first record.
+ * Logs without the "##" line are read from the beginning.
+ */
+void LogReader::parseHeader()
+{
+    qint64 pos = 0;
+    for (int line = 0; line < MAX_HEADER_LINES && pos < size; line++) {
+        const uchar *end = (const uchar *) memchr(data + pos, '\n', size - pos);
+        if (end == NULL)
+            break;
+
+        QByteArray text = QByteArray((const char *) data + pos, end - (data + pos)).trimmed();
+        pos = end - data + 1;
+
+        // The first line is a title, followed by the git hash and the UAVO hash
+        if (line == 1) {
+            gitHash = QString::fromLatin1(text);
+        } else if (line == 2) {
+            uavoHash = QString::fromLatin1(text);
+        } else if (line > 2 && text == "##") {
+            headerFound = true;
+            bodyStart = pos;
+            return;
+        }
+    }
+
+    bodyStart = 0;
+}
+
+/**
+ * @brief LogReader::buildIndex Indexes the records in one pass over the file
+ */
+void LogReader::buildIndex()
+{
+    timestamps.clear();
+    offsets.clear();
+    sequential = true;
+
+    int skipped = 0;
+    qint64 pos = bodyStart;
+    while (pos + (qint64) RECORD_HEADER_SIZE <= size) {
+        quint32 timestamp;
+        qint64 packetSize;
+        memcpy(&timestamp, data + pos, sizeof(timestamp));
+        memcpy(&packetSize, data + pos + sizeof(timestamp), sizeof(packetSize));
+
+        // The upper bytes of the size are always 0. If they aren't, the record
+        // is corrupted, try to sync again on the next byte.
+        if ((packetSize & 0xFFFFFFFFFFFF0000) != 0) {
+            pos++;
+            skipped++;
+            continue;
+        }
+
+        // A truncated last record
+        if (pos + (qint64) RECORD_HEADER_SIZE + packetSize > size)
+            break;
+
+        if (!timestamps.isEmpty() && timestamp < timestamps.last())
+            sequential = false;
+
+        timestamps.append(timestamp);
+        offsets.append(pos);
+        pos += RECORD_HEADER_SIZE + packetSize;
+    }
+
+    if (skipped > 0)
+        qDebug() << "Skipped" << skipped << "bytes with a wrong sync byte in" << file.fileName();
+}
+
+/**
+ * @brief LogReader::loadIndex Loads the cached index, if it was made for this file
+ * @return false if there is no valid index
+ */
+bool LogReader::loadIndex()
+{
+    QFile indexFile(indexFileName(file.fileName()));
+    if (!indexFile.open(QIODevice::ReadOnly))
+        return false;
+
+    IndexHeader header;
+    if (indexFile.read((char *) &header, sizeof(header)) != sizeof(header))
+        return false;
+
+    if (memcmp(header.magic, INDEX_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != INDEX_VERSION ||
+            header.logSize != size ||
+            header.logModified != QFileInfo(file).lastModified().toMSecsSinceEpoch() ||
+            header.bodyStart != bodyStart ||
+            indexFile.size() != (qint64) (sizeof(header) + header.count * (sizeof(quint32) + sizeof(qint64))))
+        return false;
+
+    timestamps.resize(header.count);
+    offsets.resize(header.count);
+    qint64 timestampBytes = header.count * sizeof(quint32);
+    qint64 offsetBytes = header.count * sizeof(qint64);
+    if (indexFile.read((char *) timestamps.data(), timestampBytes) != timestampBytes ||
+            indexFile.read((char *) offsets.data(), offsetBytes) != offsetBytes) {
+        timestamps.clear();
+        offsets.clear();
+        return false;
+    }
+
+    sequential = header.sequential != 0;
+    return true;
+}
+
+/**
+ * @brief LogReader::saveIndex Caches the index next to the log file. Logs in
+ * read only locations are indexed each time they are opened.
+ */
+void LogReader::saveIndex() const
+{
+    QFile indexFile(indexFileName(file.fileName()));
+    if (!indexFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return;
+
+    IndexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+    header.version = INDEX_VERSION;
+    header.count = timestamps.size();
+    header.logSize = size;
+    header.logModified = QFileInfo(file).lastModified().toMSecsSinceEpoch();
+    header.bodyStart = bodyStart;
+    header.sequential = sequential;
+
+    indexFile.write((const char *) &header, sizeof(header));
+    indexFile.write((const char *) timestamps.constData(), timestamps.size() * sizeof(quint32));
+    indexFile.write((const char *) offsets.constData(), offsets.size() * sizeof(qint64));
+}
@@ -0,0 +1,92 @@
+/**
+ ******************************************************************************
+ *
+ * @file       logreader.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @brief      Memory mapped reader of GCS log files
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LOGREADER_H
+#define LOGREADER_H
+
+#include <QFile>
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+
+/**
+ * @brief The LogReader class Reads the packets of a GCS log file. The file is
+ * mapped into memory and packets are handed out as views of the mapping, without
+ * a copy. They stay valid until the reader is closed.
+ *
+ * A log file is a text header ending with a "##" line, followed by records of a
+ * quint32 timestamp in ms, a qint64 packet size and the packet. The timestamp
+ * and offset of each record are indexed in one pass, and the index is cached
+ * next to the log file so that opening the log again doesn't scan it.
+ */
+class LogReader
+{
+public:
+    LogReader();
+    ~LogReader();
+
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const { return data != NULL; }
+
+    //! Git hash of the GCS that recorded the log
+    QString getGitHash() const { return gitHash; }
+    //! Hash of the UAVO definitions the log was recorded with
+    QString getUAVOHash() const { return uavoHash; }
+    //! False if the "##" line that ends the header wasn't found
+    bool hasHeader() const { return headerFound; }
+    //! False if a timestamp is earlier than the one before
+    bool isSequential() const { return sequential; }
+
+    int getPacketCount() const { return timestamps.size(); }
+    quint32 getTimestamp(int idx) const { return timestamps.at(idx); }
+    QByteArray getPacket(int idx) const;
+    int findPacket(quint32 timestamp) const;
+
+    static QString indexFileName(const QString &fileName);
+
+private:
+    void parseHeader();
+    void buildIndex();
+    bool loadIndex();
+    void saveIndex() const;
+
+    QFile file;
+    QByteArray contents;    //The file, if it can't be mapped
+    const uchar *data;
+    qint64 size;
+
+    QString gitHash;
+    QString uavoHash;
+    bool headerFound;
+    qint64 bodyStart;       //Offset of the first record
+
+    QVector<quint32> timestamps;
+    QVector<qint64> offsets;   //Offset of each record
+    bool sequential;
+};
+
+#endif // LOGREADER_H
@@ -41,7 +41,6 @@
  * @param p_uavFieldName The plotted UAVO field name
  */
 Plot2dData::Plot2dData(QString p_uavObject, QString p_uavFieldName):
-    yDataHistory(0),
     dataUpdated(false)
 {
     uavObjectName = p_uavObject;
@@ -61,17 +60,18 @@ Plot2dData::Plot2dData(QString p_uavObject, QString p_uavFieldName):
 
     xData = new QVector<double>();
     yData = new QVector<double>();
-    yDataHistory = new QVector<double>();
 
-    scalePower = 0;
+    setScalePower(0);
     meanSamples = 1;
-    meanSum = 0.0f;
-    correctionSum = 0.0f;
-    correctionCount = 0;
+    mathFunctionType = MATH_NONE;
     yMinimum = 0;
     yMaximum = 120;
 
     m_xWindowSize = 0;
+
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+    resolveFieldRef(objManager->getObject(uavObjectName));
 }
 
 
@@ -104,17 +104,19 @@ Plot3dData::Plot3dData(QString p_uavObject, QString p_uavFieldName):
     zDataHistory = new QVector<double>();
     timeDataHistory = new QVector<double>();
 
-    scalePower = 0;
+    setScalePower(0);
     meanSamples = 1;
-    meanSum = 0.0f;
-    correctionSum = 0.0f;
-    correctionCount = 0;
+    mathFunctionType = MATH_NONE;
     xMinimum = 0;
     xMaximum = 16;
     yMinimum = 0;
     yMaximum = 60;
     zMinimum = 0;
     zMaximum = 100;
+
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+    resolveFieldRef(objManager->getObject(uavObjectName));
 }
 
 
@@ -124,8 +126,6 @@ Plot2dData::~Plot2dData()
         delete xData;
     if (yData != NULL)
         delete yData;
-    if (yDataHistory != NULL)
-        delete yDataHistory;
 }
 
 
@@ -145,23 +145,54 @@ Plot3dData::~Plot3dData()
 
 
 /**
- * @brief valueAsDouble Fetch the value from the UAVO and return it as a double
- * @param obj UAVO
- * @param field UAVO field
- * @param haveSubField TRUE if UAVO has subfield. FALSE if not.
- * @param uavSubFieldName UAVO subfield, if it exists
- * @return
+ * @brief PlotData::setMathFunction Sets the math function, parsed here so that
+ * appending data doesn't compare strings
+ * @param val Name of the math function
+ */
+void PlotData::setMathFunction(QString val)
+{
+    mathFunction = val;
+
+    if (val == "Boxcar average")
+        mathFunctionType = MATH_BOXCAR_AVERAGE;
+    else if (val == "Standard deviation")
+        mathFunctionType = MATH_STANDARD_DEVIATION;
+    else
+        mathFunctionType = MATH_NONE;
+}
+
+
+/**
+ * @brief PlotData::resolveFieldRef Resolves the plotted element of a UAVO
+ * @param obj UAVO, or NULL if it doesn't exist yet
  */
-double PlotData::valueAsDouble(UAVObject* obj, UAVObjectField* field, bool haveSubField, QString uavSubFieldName)
+void PlotData::resolveFieldRef(UAVObject *obj)
 {
-    Q_UNUSED(obj);
-    QVariant value;
+    UAVObjectField *field = (obj != NULL) ? obj->getField(uavFieldName) : NULL;
+    int index = 0;
 
-    if(haveSubField){
-        int indexOfSubField = field->getElementNames().indexOf(QRegExp(uavSubFieldName, Qt::CaseSensitive, QRegExp::FixedString));
-        value = field->getValue(indexOfSubField);
-    }else
-        value = field->getValue();
+    if (field != NULL && haveSubField)
+        index = field->getElementNames().indexOf(uavSubFieldName);
+
+    fieldRef = (index >= 0) ? UAVObjectFieldRef(field, index) : UAVObjectFieldRef();
+}
+
+
+/**
+ * @brief PlotData::isDataSource Checks if a UAVO update carries the plotted element
+ * @param obj UAVO with new data
+ * @return TRUE if fieldRef can be read for this update
+ */
+bool PlotData::isDataSource(UAVObject *obj)
+{
+    if (fieldRef.refersTo(obj))
+        return true;
+
+    // The object may not have existed when the plot was created
+    if (!fieldRef.isValid() && uavObjectName == obj->getName()) {
+        resolveFieldRef(obj);
+        return fieldRef.isValid();
+    }
 
-    return value.toDouble();
+    return false;
 }
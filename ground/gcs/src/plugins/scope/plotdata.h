@@ -33,6 +33,7 @@ class ScopeGadgetWidget;
 class ScopeConfig;
 
 #include "uavobject.h"
+#include "uavobjectfieldref.h"
 
 #include "qwt/src/qwt_color_map.h"
 #include "qwt/src/qwt_scale_widget.h"
@@ -40,23 +41,28 @@ class ScopeConfig;
 #include <QTimer>
 #include <QTime>
 #include <QVector>
+#include <math.h>
 
 
 class PlotData : public QObject
 {
     Q_OBJECT
 public:
-    double valueAsDouble(UAVObject* obj, UAVObjectField* field, bool haveSubField, QString uavSubFieldName);
+    enum MathFunction {
+        MATH_NONE,
+        MATH_BOXCAR_AVERAGE,
+        MATH_STANDARD_DEVIATION
+    };
 
     //Setter functions
     void setXMinimum(double val){xMinimum=val;}
     virtual void setXMaximum(double val){xMaximum=val;}
     void setYMinimum(double val){yMinimum = val;}
     void setYMaximum(double val){yMaximum = val;}
-    void setXWindowSize(double val){m_xWindowSize=val;}
-    void setScalePower(int val){scalePower = val;}
+    virtual void setXWindowSize(double val){m_xWindowSize=val;}
+    void setScalePower(int val){scalePower = val; scaleFactor = pow(10, val);}
     void setMeanSamples(int val){meanSamples = val;}
-    void setMathFunction(QString val){mathFunction = val;}
+    void setMathFunction(QString val);
 
     //Getter functions
     double getXMinimum(){return xMinimum;}
@@ -90,6 +96,9 @@ protected:
     QVector<double>* xData;    //Data vector for plots
     QVector<double>* yData;    //Used vector for plots
 
+    bool isDataSource(UAVObject *obj);
+    void resolveFieldRef(UAVObject *obj);
+
     double m_xWindowSize;
     double xMinimum;
     double xMaximum;
@@ -100,14 +109,13 @@ protected:
     QString uavFieldName;
     QString uavSubFieldName;
     bool haveSubField;
+    UAVObjectFieldRef fieldRef; //Plotted element, resolved once from the names above
 
     int scalePower; //This is the power to which each value must be raised
+    double scaleFactor; //10^scalePower
     unsigned int meanSamples;
     QString mathFunction;
-    double meanSum;
-
-    double correctionSum;
-    int correctionCount;
+    MathFunction mathFunctionType;
 
 private:
 
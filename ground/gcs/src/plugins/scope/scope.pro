@@ -11,6 +11,7 @@ HEADERS += scopeplugin.h \
     scopes2d/histogramscopeconfig.h \
     scopes2d/scatterplotdata.h \
     scopes2d/scatterplotscopeconfig.h \
+    scopes2d/seriesbuffer.h \
     scopes3d/spectrogramplotdata.h \
     scopes3d/spectrogramscopeconfig.h \
     scopes2d/plotdata2d.h \
@@ -30,6 +31,7 @@ SOURCES += scopeplugin.cpp \
     scopes2d/histogramscopeconfig.cpp \
     scopes2d/scatterplotdata.cpp \
     scopes2d/scatterplotscopeconfig.cpp \
+    scopes2d/seriesbuffer.cpp \
     scopes3d/spectrogramplotdata.cpp \
     scopes3d/spectrogramscopeconfig.cpp \
     plotdata.cpp
@@ -33,7 +33,7 @@
 #include "uavdataobject.h"
 
 #include "vibrationanalysissettings.h"
-#include "vibrationanalysisoutput.h"
+#include "vibrationanalysisspectrum.h"
 
 #include "scopes2d/histogramscopeconfig.h"
 #include "scopes2d/scatterplotscopeconfig.h"
@@ -248,12 +248,12 @@ void ScopeGadgetOptionsPage::on_cmbSpectrogramSource_currentIndexChanged(QString
         // Load UAVO
         ExtensionSystem::PluginManager* pm = ExtensionSystem::PluginManager::instance();
         UAVObjectManager* objManager = pm->getObject<UAVObjectManager>();
-        VibrationAnalysisOutput* vibrationAnalysisOutput = VibrationAnalysisOutput::GetInstance(objManager);
+        VibrationAnalysisSpectrum* vibrationAnalysisSpectrum = VibrationAnalysisSpectrum::GetInstance(objManager);
         VibrationAnalysisSettings* vibrationAnalysisSettings = VibrationAnalysisSettings::GetInstance(objManager);
         VibrationAnalysisSettings::DataFields vibrationAnalysisSettingsData = vibrationAnalysisSettings->getData();
 
         // Set combobox field to UAVO name
-        options_page->cmbUAVObjectsSpectrogram->setCurrentIndex(options_page->cmbUAVObjectsSpectrogram->findText(vibrationAnalysisOutput->getName()));
+        options_page->cmbUAVObjectsSpectrogram->setCurrentIndex(options_page->cmbUAVObjectsSpectrogram->findText(vibrationAnalysisSpectrum->getName()));
         // Get the window size
         int fftWindowSize;
         switch(vibrationAnalysisSettingsData.FFTWindowSize)
@@ -273,12 +273,17 @@ void ScopeGadgetOptionsPage::on_cmbSpectrogramSource_currentIndexChanged(QString
             break;
         }
 
+        // The spectrum is grouped into at most as many bands as the UAVO holds
+        int numBands = qMin(fftWindowSize / 2, (int) VibrationAnalysisSpectrum::X_NUMELEM);
+
         // Set spinbox range before setting value
-        options_page->sbSpectrogramWidth->setRange(0, fftWindowSize / 2);
+        options_page->sbSpectrogramWidth->setRange(0, numBands);
 
-        // Set values to UAVO
-        options_page->sbSpectrogramWidth->setValue(fftWindowSize / 2);
-        options_page->sbSpectrogramFrequency->setValue(1000.0f/vibrationAnalysisSettingsData.SampleRate); // Sample rate is in ms
+        // Set values to UAVO. The sample rate is only known once a spectrum has been received.
+        options_page->sbSpectrogramWidth->setValue(numBands);
+        float sampleRate = vibrationAnalysisSpectrum->getData().SampleRate;
+        if (sampleRate > 0)
+            options_page->sbSpectrogramFrequency->setValue(sampleRate);
 
         options_page->sbSpectrogramFrequency->setEnabled(false);
         options_page->sbSpectrogramWidth->setEnabled(false);
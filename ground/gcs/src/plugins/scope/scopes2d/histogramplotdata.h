@@ -67,6 +67,8 @@ private:
 
     double binWidth;
     uint numberOfBins;
+    int plottedColumns; //Canvas width the bins were merged for
+
 
 private slots:
 
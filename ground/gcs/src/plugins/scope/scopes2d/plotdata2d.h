@@ -46,8 +46,6 @@ public:
     Plot2dData(QString uavObject, QString uavField);
     ~Plot2dData();
 
-    QVector<double>* yDataHistory; //Used for scatterplots
-
     virtual void setUpdatedFlagToTrue(){dataUpdated = true;}
     virtual bool readAndResetUpdatedFlag(){bool tmp = dataUpdated; dataUpdated = false; return tmp;}
 
@@ -47,11 +47,11 @@ void TimeSeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeCon
 {
     Q_UNUSED(plot2dData);
     Q_UNUSED(scopeConfig);
-    Q_UNUSED(scopeGadgetWidget);
 
-    //Plot new data
-    if (readAndResetUpdatedFlag() == true)
-        curve->setSamples(*xData, *yData);
+    //The curve reads the new samples when it is drawn
+    readAndResetUpdatedFlag();
+    if (curveData != NULL)
+        curveData->setColumns(scopeGadgetWidget->canvas()->width());
 
     QDateTime NOW = QDateTime::currentDateTime();
     double toTime = NOW.toTime_t();
@@ -69,11 +69,46 @@ void SeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeConfig,
 {
     Q_UNUSED(plot2dData);
     Q_UNUSED(scopeConfig);
-    Q_UNUSED(scopeGadgetWidget);
 
-    //Plot new data
-    if (readAndResetUpdatedFlag() == true)
-        curve->setSamples(*xData, *yData);
+    //The curve reads the new samples when it is drawn
+    readAndResetUpdatedFlag();
+    if (curveData != NULL)
+        curveData->setColumns(scopeGadgetWidget->canvas()->width());
+}
+
+
+
+/**
+ * @brief ScatterplotData::setCurve Sets the curve that draws the data. The curve
+ * reads the samples from the buffer.
+ * @param val Curve
+ */
+void ScatterplotData::setCurve(QwtPlotCurve *val)
+{
+    curve = val;
+    curveData = new SeriesBufferData(&buffer, indexAsX);
+    curve->setSamples(curveData);
+}
+
+
+/**
+ * @brief ScatterplotData::applyMathFunction Performs the scope math on a new value
+ * @param value New value
+ * @return the value to plot
+ */
+double ScatterplotData::applyMathFunction(double value)
+{
+    if (mathFunctionType == MATH_NONE)
+        return value;
+
+    if (stats.getWindow() != (int)meanSamples)
+        stats.setWindow(meanSamples);
+    stats.add(value);
+
+    if (mathFunctionType == MATH_STANDARD_DEVIATION)
+        return stats.standardDeviation();
+
+    return stats.mean();
 }
 
 
@@ -84,67 +119,30 @@ void SeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeConfig,
  */
 bool SeriesPlotData::append(UAVObject* obj)
 {
-    if (uavObjectName == obj->getName()) {
-
-        //Get the field of interest
-        UAVObjectField* field =  obj->getField(uavFieldName);
-
-        if (field) {
-
-            double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
-
-            //Perform scope math, if necessary
-            if (mathFunction  == "Boxcar average" || mathFunction  == "Standard deviation"){
-                //Put the new value at the front
-                yDataHistory->append( currentValue );
-
-                // calculate average value
-                meanSum += currentValue;
-                if(yDataHistory->size() > (int)meanSamples) {
-                    meanSum -= yDataHistory->first();
-                    yDataHistory->pop_front();
-                }
-
-                // make sure to correct the sum every meanSamples steps to prevent it
-                // from running away due to floating point rounding errors
-                correctionSum+=currentValue;
-                if (++correctionCount >= (int)meanSamples) {
-                    meanSum = correctionSum;
-                    correctionSum = 0.0f;
-                    correctionCount = 0;
-                }
-
-                double boxcarAvg=meanSum/yDataHistory->size();
-
-                if ( mathFunction  == "Standard deviation" ){
-                    //Calculate square of sample standard deviation, with Bessel's correction
-                    double stdSum=0;
-                    for (int i=0; i < yDataHistory->size(); i++){
-                        stdSum+= pow(yDataHistory->at(i)- boxcarAvg,2)/(meanSamples-1);
-                    }
-                    yData->append(sqrt(stdSum));
-                }
-                else  {
-                    yData->append(boxcarAvg);
-                }
-            }
-            else{
-                yData->append( currentValue );
-            }
-
-            if (yData->size() > getXWindowSize()) { //If new data overflows the window, remove old data...
-                yData->pop_front();
-            } else //...otherwise, add a new y point at position xData
-                xData->insert(xData->size(), xData->size());
-
-            return true;
-        }
+    if (isDataSource(obj)) {
+        double currentValue = applyMathFunction(fieldRef.toDouble() * scaleFactor);
+
+        //The buffer holds one window, new data overwrites the oldest
+        buffer.append(0, currentValue);
+
+        return true;
     }
 
     return false;
 }
 
 
+/**
+ * @brief SeriesPlotData::setXWindowSize Sets the number of samples shown
+ * @param val Number of samples
+ */
+void SeriesPlotData::setXWindowSize(double val)
+{
+    ScatterplotData::setXWindowSize(val);
+    buffer.setCapacityLimit((int)val);
+}
+
+
 /**
  * @brief TimeSeriesPlotData::append Appends data to time series data
  * @param obj UAVO with new data
@@ -152,60 +150,17 @@ bool SeriesPlotData::append(UAVObject* obj)
  */
 bool TimeSeriesPlotData::append(UAVObject* obj)
 {
-    if (uavObjectName == obj->getName()) {
-        //Get the field of interest
-        UAVObjectField* field =  obj->getField(uavFieldName);
-
-        if (field) {
-            QDateTime NOW = QDateTime::currentDateTime(); //THINK ABOUT REIMPLEMENTING THIS TO SHOW UAVO TIME, NOT SYSTEM TIME
-            double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
-
-            //Perform scope math, if necessary
-            if (mathFunction  == "Boxcar average" || mathFunction  == "Standard deviation"){
-                //Put the new value at the back
-                yDataHistory->append( currentValue );
-
-                // calculate average value
-                meanSum += currentValue;
-                if(yDataHistory->size() > (int)meanSamples) {
-                    meanSum -= yDataHistory->first();
-                    yDataHistory->pop_front();
-                }
-                // make sure to correct the sum every meanSamples steps to prevent it
-                // from running away due to floating point rounding errors
-                correctionSum+=currentValue;
-                if (++correctionCount >= (int)meanSamples) {
-                    meanSum = correctionSum;
-                    correctionSum = 0.0f;
-                    correctionCount = 0;
-                }
-
-                double boxcarAvg=meanSum/yDataHistory->size();
-
-                if ( mathFunction  == "Standard deviation" ){
-                    //Calculate square of sample standard deviation, with Bessel's correction
-                    double stdSum=0;
-                    for (int i=0; i < yDataHistory->size(); i++){
-                        stdSum+= pow(yDataHistory->at(i)- boxcarAvg,2)/(meanSamples-1);
-                    }
-                    yData->append(sqrt(stdSum));
-                }
-                else  {
-                    yData->append(boxcarAvg);
-                }
-            }
-            else{
-                yData->append( currentValue );
-            }
-
-            double valueX = NOW.toTime_t() + NOW.time().msec() / 1000.0;
-            xData->append(valueX);
-
-            //Remove stale data
-            removeStaleData();
-
-            return true;
-        }
+    if (isDataSource(obj)) {
+        QDateTime NOW = QDateTime::currentDateTime(); //THINK ABOUT REIMPLEMENTING THIS TO SHOW UAVO TIME, NOT SYSTEM TIME
+        double currentValue = applyMathFunction(fieldRef.toDouble() * scaleFactor);
+
+        double valueX = NOW.toTime_t() + NOW.time().msec() / 1000.0;
+        buffer.append(valueX, currentValue);
+
+        //Remove stale data
+        removeStaleData();
+
+        return true;
     }
 
     return false;
@@ -217,22 +172,8 @@ bool TimeSeriesPlotData::append(UAVObject* obj)
  */
 void TimeSeriesPlotData::removeStaleData()
 {
-    double newestValue;
-    double oldestValue;
-
-    while (1) {
-        if (xData->size() == 0)
-            break;
-
-        newestValue = xData->last();
-        oldestValue = xData->first();
-
-        if (newestValue - oldestValue > getXWindowSize()) {
-            yData->pop_front();
-            xData->pop_front();
-        } else
-            break;
-    }
+    if (buffer.size() > 0)
+        buffer.expireBefore(buffer.x(buffer.size() - 1) - getXWindowSize());
 }
 
 
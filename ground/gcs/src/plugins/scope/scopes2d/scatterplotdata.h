@@ -29,6 +29,7 @@
 #define SCATTERPLOTDATA_H
 
 #include "scopes2d/plotdata2d.h"
+#include "scopes2d/seriesbuffer.h"
 #include "uavobject.h"
 #include "qwt/src/qwt_plot_curve.h"
 
@@ -44,16 +45,23 @@ class ScatterplotData : public Plot2dData
 {
     Q_OBJECT
 public:
-    ScatterplotData(QString uavObject, QString uavField):
-        Plot2dData(uavObject, uavField){curve = 0;}
+    ScatterplotData(QString uavObject, QString uavField, bool plotIndexAsX = false):
+        Plot2dData(uavObject, uavField), indexAsX(plotIndexAsX){curve = 0; curveData = 0;}
     ~ScatterplotData(){}
 
     virtual void clearPlots(PlotData *);
 
-    void setCurve(QwtPlotCurve *val){curve = val;}
+    void setCurve(QwtPlotCurve *val);
 
 protected:
+    double applyMathFunction(double value);
+
     QwtPlotCurve* curve;
+    SeriesBufferData* curveData; //Owned by the curve
+
+    SeriesBuffer buffer; //Samples of the curve
+    SlidingStats stats;  //Statistics of the last meanSamples values
+    bool indexAsX;       //Plot the samples by their position in the buffer
 };
 
 
@@ -67,7 +75,7 @@ class SeriesPlotData : public ScatterplotData
     Q_OBJECT
 public:
     SeriesPlotData(QString uavObject, QString uavField)
-            : ScatterplotData(uavObject, uavField) {}
+            : ScatterplotData(uavObject, uavField, true) {}
     ~SeriesPlotData() {}
 
     /*!
@@ -75,6 +83,11 @@ public:
       */
     bool append(UAVObject* obj);
 
+    /*!
+      \brief The window is a number of samples, the buffer keeps that many
+      */
+    virtual void setXWindowSize(double val);
+
 
     /*!
       \brief Removes the old data from the buffer
@@ -94,7 +107,7 @@ class TimeSeriesPlotData : public ScatterplotData
 public:
     TimeSeriesPlotData(QString uavObject, QString uavField)
             : ScatterplotData(uavObject, uavField) {
-        scalePower = 1;
+        setScalePower(1);
     }
     ~TimeSeriesPlotData() {
     }
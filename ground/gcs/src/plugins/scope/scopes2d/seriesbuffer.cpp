@@ -0,0 +1,524 @@
+/**
+ ******************************************************************************
+ *
+ * @file       seriesbuffer.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Ring buffer that stores the samples of a scope curve
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "scopes2d/seriesbuffer.h"
+
+#include <limits.h>
+#include <math.h>
+
+//! Storage allocated by the first sample
+#define INITIAL_STORAGE 64
+
+
+SeriesBuffer::SeriesBuffer(int capacityLimit) :
+    m_head(0),
+    m_size(0),
+    m_mask(-1),
+    m_capacityLimit(capacityLimit > 0 ? capacityLimit : 1),
+    m_revision(0),
+    m_appended(0)
+{
+}
+
+
+/**
+ * @brief SeriesBuffer::append Appends a sample, overwriting the oldest one if the
+ * buffer is at its limit
+ */
+void SeriesBuffer::append(double x, double y)
+{
+    if (m_size == m_x.size() && m_size < m_capacityLimit)
+        grow();
+
+    int slot = (m_head + m_size) & m_mask;
+    m_x[slot] = x;
+    m_y[slot] = y;
+
+    if (m_size < m_capacityLimit)
+        m_size++;
+    else
+        m_head = (m_head + 1) & m_mask; // Full, the oldest sample is dropped
+
+    m_revision++;
+    m_appended++;
+}
+
+
+/**
+ * @brief SeriesBuffer::expireBefore Removes the samples older than x. The samples
+ * must have been appended in increasing x.
+ */
+void SeriesBuffer::expireBefore(double x)
+{
+    while (m_size > 0 && m_x.at(m_head) < x) {
+        m_head = (m_head + 1) & m_mask;
+        m_size--;
+        m_revision++;
+    }
+}
+
+
+void SeriesBuffer::clear()
+{
+    m_head = 0;
+    m_size = 0;
+    m_revision++;
+}
+
+
+/**
+ * @brief SeriesBuffer::setCapacityLimit Sets how many samples are kept. The oldest
+ * samples are dropped if there are more.
+ */
+void SeriesBuffer::setCapacityLimit(int limit)
+{
+    if (limit < 1)
+        limit = 1;
+
+    if (m_size > limit) {
+        m_head = (m_head + m_size - limit) & m_mask;
+        m_size = limit;
+        m_revision++;
+    }
+    m_capacityLimit = limit;
+}
+
+
+/**
+ * @brief SeriesBuffer::grow Doubles the storage, the samples are moved so that the
+ * oldest one is at the start
+ */
+void SeriesBuffer::grow()
+{
+    int storage = m_x.isEmpty() ? INITIAL_STORAGE : m_x.size() * 2;
+
+    QVector<double> x(storage);
+    QVector<double> y(storage);
+    for (int i = 0; i < m_size; i++) {
+        x[i] = this->x(i);
+        y[i] = this->y(i);
+    }
+
+    m_x.swap(x);
+    m_y.swap(y);
+    m_head = 0;
+    m_mask = storage - 1;
+}
+
+
+/**
+ * @brief SeriesBuffer::lowerBound Finds the first sample at or after x. The samples
+ * must have been appended in increasing x.
+ * @return the index of the sample, or size() if all samples are before x
+ */
+int SeriesBuffer::lowerBound(double x) const
+{
+    int low = 0;
+    int high = m_size;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (this->x(mid) < x)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+
+/**
+ * @brief SeriesBuffer::boundingRect Bounds of all samples
+ * @return the bounds, or an invalid rectangle if the buffer is empty
+ */
+QRectF SeriesBuffer::boundingRect() const
+{
+    if (m_size == 0)
+        return QRectF(0.0, 0.0, -1.0, -1.0);
+
+    double minX = x(0), maxX = minX;
+    double minY = y(0), maxY = minY;
+    for (int i = 1; i < m_size; i++) {
+        double xi = x(i);
+        double yi = y(i);
+        if (xi < minX) minX = xi;
+        if (xi > maxX) maxX = xi;
+        if (yi < minY) minY = yi;
+        if (yi > maxY) maxY = yi;
+    }
+
+    return QRectF(minX, minY, maxX - minX, maxY - minY);
+}
+
+
+/**
+ * @brief SeriesBuffer::decimate Reduces a range of samples to the minimum and the
+ * maximum of each pixel column, in the order they occurred, so that peaks stay
+ * visible. Samples left and right of the columns are reduced the same way.
+ * @param first Index of the first sample
+ * @param count Number of samples
+ * @param xFrom x at the left edge of the first column
+ * @param xTo x at the right edge of the last column
+ * @param columns Number of columns
+ * @param indexAsX Use the index of a sample as its x
+ * @param out Receives at most two points per column
+ */
+void SeriesBuffer::decimate(int first, int count, double xFrom, double xTo, int columns,
+                            bool indexAsX, QVector<QPointF> &out) const
+{
+    out.clear();
+    if (count <= 0 || columns <= 0 || !(xTo > xFrom))
+        return;
+
+    double scale = columns / (xTo - xFrom);
+    int column = INT_MIN;
+    int minIdx = first, maxIdx = first;
+
+    for (int i = first; i <= first + count; i++) {
+        int c = INT_MAX;
+        if (i < first + count) {
+            double pos = ((indexAsX ? i : x(i)) - xFrom) * scale;
+            c = pos < 0 ? -1 : (pos >= columns ? columns : (int)pos);
+
+            if (c == column) {
+                double yi = y(i);
+                if (yi < y(minIdx))
+                    minIdx = i;
+                else if (yi > y(maxIdx))
+                    maxIdx = i;
+                continue;
+            }
+        }
+
+        // A new column starts, output the previous one
+        if (column != INT_MIN) {
+            int a = qMin(minIdx, maxIdx);
+            int b = qMax(minIdx, maxIdx);
+            out.append(QPointF(indexAsX ? a : x(a), y(a)));
+            if (b != a)
+                out.append(QPointF(indexAsX ? b : x(b), y(b)));
+        }
+
+        column = c;
+        minIdx = maxIdx = i;
+    }
+}
+
+
+SlidingStats::SlidingStats() :
+    m_window(1)
+{
+    clear();
+}
+
+
+/**
+ * @brief SlidingStats::setWindow Sets the number of samples averaged, which
+ * restarts the statistics
+ */
+void SlidingStats::setWindow(int window)
+{
+    m_window = window > 0 ? window : 1;
+    m_values.resize(m_window);
+    clear();
+}
+
+
+void SlidingStats::clear()
+{
+    m_count = 0;
+    m_next = 0;
+    m_sinceExact = 0;
+    m_mean = 0;
+    m_m2 = 0;
+}
+
+
+/**
+ * @brief SlidingStats::add Adds a sample, replacing the oldest one once the
+ * window is full
+ */
+void SlidingStats::add(double value)
+{
+    if (m_values.size() != m_window)
+        m_values.resize(m_window);
+
+    if (m_count < m_window) {
+        m_values[m_next] = value;
+        m_count++;
+
+        double delta = value - m_mean;
+        m_mean += delta / m_count;
+        m_m2 += delta * (value - m_mean);
+    } else {
+        double old = m_values.at(m_next);
+        m_values[m_next] = value;
+
+        double newMean = m_mean + (value - old) / m_window;
+        m_m2 += (value - old) * (value - newMean + old - m_mean);
+        m_mean = newMean;
+
+        // Recompute the sums once per window, so that rounding errors can't build up
+        if (++m_sinceExact >= m_window)
+            recompute();
+    }
+
+    if (++m_next >= m_window)
+        m_next = 0;
+}
+
+
+/**
+ * @brief SlidingStats::standardDeviation Sample standard deviation, with Bessel's
+ * correction
+ */
+double SlidingStats::standardDeviation() const
+{
+    if (m_count < 2 || m_m2 <= 0)
+        return 0;
+    return sqrt(m_m2 / (m_count - 1));
+}
+
+
+void SlidingStats::recompute()
+{
+    double sum = 0;
+    for (int i = 0; i < m_count; i++)
+        sum += m_values.at(i);
+    m_mean = sum / m_count;
+
+    m_m2 = 0;
+    for (int i = 0; i < m_count; i++) {
+        double delta = m_values.at(i) - m_mean;
+        m_m2 += delta * delta;
+    }
+
+    m_sinceExact = 0;
+}
+
+
+SeriesBufferData::SeriesBufferData(const SeriesBuffer *buffer, bool indexAsX) :
+    m_buffer(buffer),
+    m_indexAsX(indexAsX),
+    m_columns(DEFAULT_COLUMNS),
+    m_xFrom(0),
+    m_xTo(0),
+    m_valid(false),
+    m_revision(0),
+    m_decimated(false),
+    m_first(0),
+    m_count(0),
+    m_boundsValid(false),
+    m_boundsRevision(0),
+    m_columnWidth(0),
+    m_cacheFirstKey(0),
+    m_nextSample(0)
+{
+}
+
+
+/**
+ * @brief SeriesBufferData::setColumns Sets the number of pixel columns the curve
+ * is drawn in, usually the width of the canvas
+ */
+void SeriesBufferData::setColumns(int columns)
+{
+    if (columns > 0 && columns != m_columns) {
+        m_columns = columns;
+        m_valid = false;
+    }
+}
+
+
+/**
+ * @brief SeriesBufferData::setRectOfInterest Called by the curve with the visible
+ * area of the plot, before it is drawn
+ */
+void SeriesBufferData::setRectOfInterest(const QRectF &rect)
+{
+    if (rect.left() != m_xFrom || rect.right() != m_xTo) {
+        m_xFrom = rect.left();
+        m_xTo = rect.right();
+        m_valid = false;
+    }
+}
+
+
+/**
+ * @brief SeriesBufferData::refresh Finds the visible samples and decimates them if
+ * there are too many, unless the buffer and the view didn't change since last time
+ */
+void SeriesBufferData::refresh() const
+{
+    if (m_valid && m_revision == m_buffer->getRevision())
+        return;
+
+    m_valid = true;
+    m_revision = m_buffer->getRevision();
+
+    int size = m_buffer->size();
+    int first = 0;
+    int last = size - 1;
+    double xFrom = m_xFrom;
+    double xTo = m_xTo;
+
+    if (size > 0 && xFrom < xTo) {
+        // Keep one sample past each edge, so that the curve reaches them
+        if (m_indexAsX) {
+            first = (int)floor(xFrom) - 1;
+            last = (int)ceil(xTo) + 1;
+        } else {
+            first = m_buffer->lowerBound(xFrom) - 1;
+            last = m_buffer->lowerBound(xTo);
+        }
+        first = qMax(first, 0);
+        last = qMin(last, size - 1);
+    } else if (size > 0) {
+        xFrom = m_indexAsX ? 0 : m_buffer->x(0);
+        xTo = m_indexAsX ? size - 1 : m_buffer->x(size - 1);
+    }
+
+    m_first = first;
+    m_count = qMax(last - first + 1, 0);
+    m_decimated = m_count > 2 * m_columns && xFrom < xTo;
+
+    if (!m_decimated) {
+        m_points.clear();
+        m_columnWidth = 0;
+    } else if (m_indexAsX) {
+        // The position of every sample changes when one is appended, nothing to cache
+        m_buffer->decimate(m_first, m_count, xFrom, xTo, m_columns, m_indexAsX, m_points);
+    } else {
+        updateColumns(first, last, xFrom, xTo);
+    }
+}
+
+
+/**
+ * @brief SeriesBufferData::updateColumns Brings the cached columns up to date with
+ * the buffer and outputs the visible ones
+ * @param first Index of the first visible sample
+ * @param last Index of the last visible sample
+ */
+void SeriesBufferData::updateColumns(int first, int last, double xFrom, double xTo) const
+{
+    // The zoom level, the column width rounded to a quarter power of two so that
+    // it doesn't change while the view scrolls
+    double width = pow(2.0, floor(log2((xTo - xFrom) / m_columns) * 4) / 4);
+    qint64 firstKey = (qint64)floor(xFrom / width) - 1;
+    qint64 lastKey = (qint64)floor(xTo / width) + 1;
+    qint64 oldest = m_buffer->getAppended() - m_buffer->size();
+
+    // Start over at a new zoom level, when the view moved back, or if samples
+    // were dropped before they were added
+    if (width != m_columnWidth || firstKey < m_cacheFirstKey || m_nextSample < oldest + first) {
+        m_cache.clear();
+        m_columnWidth = width;
+        m_cacheFirstKey = firstKey;
+        m_nextSample = oldest + first;
+    }
+
+    // Drop the columns that scrolled out of view
+    int stale = 0;
+    while (stale < m_cache.size() && m_cache.at(stale).key < firstKey)
+        stale++;
+    if (stale > 0)
+        m_cache.remove(0, stale);
+    m_cacheFirstKey = firstKey;
+
+    // Add the new samples, into the last column or new ones
+    for (int i = (int)(m_nextSample - oldest); i <= last; i++) {
+        QPointF p(m_buffer->x(i), m_buffer->y(i));
+        qint64 key = (qint64)floor(p.x() / width);
+
+        if (!m_cache.isEmpty() && m_cache.last().key == key) {
+            Column &c = m_cache.last();
+            if (p.y() < c.min.y())
+                c.min = p;
+            else if (p.y() > c.max.y())
+                c.max = p;
+        } else if (m_cache.isEmpty() || m_cache.last().key < key) {
+            Column c = {key, p, p};
+            m_cache.append(c);
+        } else {
+            // The samples went back in time, the columns are rebuilt next time
+            m_columnWidth = 0;
+        }
+    }
+    m_nextSample = qMax(m_nextSample, oldest + last + 1);
+
+    m_points.clear();
+    foreach (const Column &c, m_cache) {
+        if (c.key > lastKey)
+            break;
+
+        bool minFirst = c.min.x() <= c.max.x();
+        m_points.append(minFirst ? c.min : c.max);
+        if (c.min != c.max)
+            m_points.append(minFirst ? c.max : c.min);
+    }
+}
+
+
+size_t SeriesBufferData::size() const
+{
+    refresh();
+
+    if (m_decimated)
+        return m_points.size();
+    return m_count;
+}
+
+
+QPointF SeriesBufferData::sample(size_t i) const
+{
+    refresh();
+
+    if (m_decimated)
+        return m_points.at(i);
+
+    int idx = m_first + (int)i;
+    return QPointF(m_indexAsX ? idx : m_buffer->x(idx), m_buffer->y(idx));
+}
+
+
+/**
+ * @brief SeriesBufferData::boundingRect Bounds of all samples, also the ones that
+ * are not visible, as the axes are scaled to them
+ */
+QRectF SeriesBufferData::boundingRect() const
+{
+    if (!m_boundsValid || m_boundsRevision != m_buffer->getRevision()) {
+        m_boundsValid = true;
+        m_boundsRevision = m_buffer->getRevision();
+
+        d_boundingRect = m_buffer->boundingRect();
+        if (m_indexAsX && m_buffer->size() > 0)
+            d_boundingRect.setRect(0, d_boundingRect.y(), m_buffer->size() - 1, d_boundingRect.height());
+    }
+
+    return d_boundingRect;
+}
@@ -0,0 +1,176 @@
+/**
+ ******************************************************************************
+ *
+ * @file       seriesbuffer.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Ring buffer that stores the samples of a scope curve
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef SERIESBUFFER_H
+#define SERIESBUFFER_H
+
+#include "qwt/src/qwt_series_data.h"
+
+#include <QVector>
+#include <QPointF>
+#include <QRectF>
+
+
+/**
+ * @brief The SeriesBuffer class Ring buffer of (x, y) samples, oldest first.
+ * Appending and expiring samples is O(1). The storage grows by doubling up to
+ * a capacity limit, after which the oldest sample is overwritten.
+ */
+class SeriesBuffer
+{
+public:
+    //! Limit of a buffer, 16 MB of samples
+    static const int DEFAULT_CAPACITY_LIMIT = 1 << 20;
+
+    SeriesBuffer(int capacityLimit = DEFAULT_CAPACITY_LIMIT);
+
+    void append(double x, double y);
+    void expireBefore(double x);
+    void clear();
+
+    void setCapacityLimit(int limit);
+    int getCapacityLimit() const {return m_capacityLimit;}
+
+    int size() const {return m_size;}
+    double x(int i) const {return m_x.at((m_head + i) & m_mask);}
+    double y(int i) const {return m_y.at((m_head + i) & m_mask);}
+
+    //! Changes each time samples are added or removed
+    quint32 getRevision() const {return m_revision;}
+    //! Number of samples ever appended, the newest sample is number getAppended() - 1
+    qint64 getAppended() const {return m_appended;}
+
+    int lowerBound(double x) const;
+    QRectF boundingRect() const;
+    void decimate(int first, int count, double xFrom, double xTo, int columns,
+                  bool indexAsX, QVector<QPointF> &out) const;
+
+private:
+    void grow();
+
+    QVector<double> m_x;
+    QVector<double> m_y;
+    int m_head;     //Index of the oldest sample
+    int m_size;
+    int m_mask;     //Storage size - 1, the storage is a power of two
+    int m_capacityLimit;
+    quint32 m_revision;
+    qint64 m_appended;
+};
+
+
+/**
+ * @brief The SlidingStats class Mean and standard deviation of the last samples
+ * of a curve, updated in O(1) per sample with Welford's method.
+ */
+class SlidingStats
+{
+public:
+    SlidingStats();
+
+    void setWindow(int window);
+    int getWindow() const {return m_window;}
+    void clear();
+
+    void add(double value);
+    double mean() const {return m_mean;}
+    double standardDeviation() const;
+
+private:
+    void recompute();
+
+    QVector<double> m_values;
+    int m_window;
+    int m_count;
+    int m_next;         //Slot of the next value, the oldest once the window is full
+    int m_sinceExact;   //Updates since the sums were recomputed from the values
+    double m_mean;
+    double m_m2;        //Sum of squared differences from the mean
+};
+
+
+/**
+ * @brief The SeriesBufferData class Presents a SeriesBuffer to a QwtPlotCurve.
+ * Only the samples in the visible x range are drawn. While they are fewer than
+ * two per pixel column they are read from the buffer without a copy, otherwise
+ * the curve draws the min/max of each column.
+ *
+ * The columns of a time series are laid on a grid of the column width, so that
+ * they don't move when the view scrolls. They are cached for one zoom level:
+ * new samples only update the last columns, and the view is rebuilt from the
+ * columns instead of the samples.
+ */
+class SeriesBufferData : public QwtSeriesData<QPointF>
+{
+public:
+    //! Columns assumed until the width of the canvas is known
+    static const int DEFAULT_COLUMNS = 2048;
+
+    SeriesBufferData(const SeriesBuffer *buffer, bool indexAsX = false);
+
+    void setColumns(int columns);
+    virtual void setRectOfInterest(const QRectF &rect);
+
+    virtual size_t size() const;
+    virtual QPointF sample(size_t i) const;
+    virtual QRectF boundingRect() const;
+
+private:
+    //! Min/max of the samples in one pixel column
+    struct Column {
+        qint64 key;     //Position of the column on the grid
+        QPointF min;
+        QPointF max;
+    };
+
+    void refresh() const;
+    void updateColumns(int first, int last, double xFrom, double xTo) const;
+
+    const SeriesBuffer *m_buffer;
+    bool m_indexAsX;        //Plot the position in the buffer instead of x
+    int m_columns;
+    double m_xFrom;         //Visible range, everything while m_xFrom >= m_xTo
+    double m_xTo;
+
+    // Cached view of the buffer
+    mutable bool m_valid;
+    mutable quint32 m_revision;
+    mutable bool m_decimated;
+    mutable int m_first;    //First visible sample, while not decimated
+    mutable int m_count;
+    mutable QVector<QPointF> m_points; //Min/max of each column, while decimated
+    mutable bool m_boundsValid;
+    mutable quint32 m_boundsRevision;
+
+    // Columns of a time series at one zoom level
+    mutable double m_columnWidth;   //0 while there are no columns
+    mutable qint64 m_cacheFirstKey; //Columns before this one were dropped
+    mutable qint64 m_nextSample;    //Number of the first sample not in the columns
+    mutable QVector<Column> m_cache;
+};
+
+#endif // SERIESBUFFER_H
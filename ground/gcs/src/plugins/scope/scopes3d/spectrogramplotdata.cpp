@@ -109,10 +109,15 @@ void SpectrogramData::plotNewData(PlotData *plot3dData, ScopeConfig *scopeConfig
     removeStaleData();
 
     // Check for new data
-    if (readAndResetUpdatedFlag() == true){
+    bool updated = readAndResetUpdatedFlag();
+    QSize canvasSize = scopeGadgetWidget->canvas()->size();
+    if (updated || canvasSize != plottedSize) {
         // Plot new data
-        rasterData->setValueMatrix(*zDataHistory, windowWidth);
+        plotLevelOfDetail(canvasSize);
+        plottedSize = canvasSize;
+    }
 
+    if (updated) {
         // Check autoscale. (For some reason, QwtSpectrogram doesn't support autoscale)
         if (zMaximum == 0){
             double newVal = readAndResetAutoscaleValue();
@@ -125,6 +130,43 @@ void SpectrogramData::plotNewData(PlotData *plot3dData, ScopeConfig *scopeConfig
 }
 
 
+/**
+ * @brief SpectrogramData::plotLevelOfDetail Hands the history to the raster data.
+ * When it has more rows or columns than the canvas has pixels, each pixel gets the
+ * maximum of the cells it covers, so that peaks stay visible and the spectrogram
+ * doesn't resample the whole history at every replot.
+ * @param canvasSize Size of the canvas in pixels
+ */
+void SpectrogramData::plotLevelOfDetail(const QSize &canvasSize)
+{
+    int columns = windowWidth;
+    int rows = columns > 0 ? zDataHistory->size() / columns : 0;
+    int columnStep = qMax(1, (columns + canvasSize.width() - 1) / qMax(1, canvasSize.width()));
+    int rowStep = qMax(1, (rows + canvasSize.height() - 1) / qMax(1, canvasSize.height()));
+
+    if (columnStep == 1 && rowStep == 1) {
+        rasterData->setValueMatrix(*zDataHistory, windowWidth);
+        return;
+    }
+
+    int lodColumns = (columns + columnStep - 1) / columnStep;
+    int lodRows = (rows + rowStep - 1) / rowStep;
+    QVector<double> lod(lodColumns * lodRows, -HUGE_VAL);
+
+    const double *z = zDataHistory->constData();
+    for (int row = 0; row < rows; row++) {
+        double *lodRow = lod.data() + (row / rowStep) * lodColumns;
+        for (int column = 0; column < columns; column++) {
+            double &cell = lodRow[column / columnStep];
+            cell = qMax(cell, z[row * columns + column]);
+        }
+    }
+
+    rasterData->setValueMatrix(lod, lodColumns);
+}
+
+
+
 /**
  * @brief SpectrogramData::append Appends data to spectrogram
  * @param obj UAVO with new data
@@ -134,12 +176,13 @@ bool SpectrogramData::append(UAVObject* multiObj)
 {
     QDateTime NOW = QDateTime::currentDateTime(); //TODO: Upgrade this to show UAVO time and not system time
 
-    // Check to make sure it's the correct UAVO
-    if (uavObjectName == multiObj->getName()) {
+    // Check to make sure it's the correct UAVO. The reference is to instance 0, but an
+    // update of any instance of a multiple instance UAVO completes a row
+    if (isDataSource(multiObj) || (fieldRef.isValid() && fieldRef.getObjID() == multiObj->getObjID())) {
 
-        // Only run on UAVOs that have multiple instances
+        // Single instance UAVOs carry a whole row in one array field
         if (multiObj->isSingleInstance())
-            return false;
+            return appendPacked(multiObj, NOW);
 
         //Instantiate object manager
         UAVObjectManager *objManager;
@@ -164,55 +207,116 @@ bool SpectrogramData::append(UAVObject* multiObj)
             return false;
         }
 
+        // Resolve the plotted element of each instance, the first time a full row is seen
+        if (rowRefs.size() != list.size()) {
+            rowRefs.clear();
+            foreach (UAVObject *obj, list)
+                rowRefs.append(UAVObjectFieldRef(obj->getField(uavFieldName), fieldRef.getIndex()));
+        }
+
         //Initialize vector where we will read out an entire row of multiple instance UAVO
         QVector<double> values;
 
         timeDataHistory->append(NOW.toTime_t() + NOW.time().msec() / 1000.0);
-        UAVObjectField* multiField =  multiObj->getField(uavFieldName);
-        Q_ASSERT(multiField);
-        if (multiField ) {
-
-            // Get the field of interest
-            foreach (UAVObject *obj, list) {
-                UAVObjectField* field =  obj->getField(uavFieldName);
-
-                double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
-
-                double vecVal = currentValue;
-                //Normally some math would go here, modifying vecVal before appending it to values
-                // .
-                // .
-                // .
-
-
-                // Second to last step, see if autoscale is turned on and if the value exceeds the maximum for the scope.
-                if ( zMaximum == 0 &&  vecVal > rasterData->interval(Qt::ZAxis).maxValue()){
-                    // Change scope maximum and color depth
-                    rasterData->setInterval(Qt::ZAxis, QwtInterval(0, vecVal) );
-                    autoscaleValueUpdated = vecVal;
-                }
-                // Last step, assign value to vector
-                values += vecVal;
-            }
 
-            while (timeDataHistory->back() - timeDataHistory->front() > timeHorizon){
-                timeDataHistory->pop_front();
-                zDataHistory->remove(0, fminl(spectrogramWidth, zDataHistory->size()));
-            }
+        // Get the field of interest
+        foreach (const UAVObjectFieldRef &ref, rowRefs) {
+            double currentValue = ref.toDouble() * scaleFactor;
 
-            // Doublecheck that there are the right number of samples. This can occur if the "field" assert fails
-            if(values.size() == (int) windowWidth){
-                *zDataHistory << values;
+            double vecVal = currentValue;
+            //Normally some math would go here, modifying vecVal before appending it to values
+            // .
+            // .
+            // .
+
+
+            // Second to last step, see if autoscale is turned on and if the value exceeds the maximum for the scope.
+            if ( zMaximum == 0 &&  vecVal > rasterData->interval(Qt::ZAxis).maxValue()){
+                // Change scope maximum and color depth
+                rasterData->setInterval(Qt::ZAxis, QwtInterval(0, vecVal) );
+                autoscaleValueUpdated = vecVal;
             }
+            // Last step, assign value to vector
+            values += vecVal;
+        }
 
-            return true;
+        while (timeDataHistory->back() - timeDataHistory->front() > timeHorizon){
+            timeDataHistory->pop_front();
+            zDataHistory->remove(0, fminl(spectrogramWidth, zDataHistory->size()));
         }
+
+        // Doublecheck that there are the right number of samples. This can occur if the "field" assert fails
+        if(values.size() == (int) windowWidth){
+            *zDataHistory << values;
+        }
+
+        return true;
     }
 
     return false;
 }
 
 
+/**
+ * @brief SpectrogramData::appendPacked Appends a row stored in an array field, such as
+ * VibrationAnalysisSpectrum. If the UAVO has a Scale field with an element named after the
+ * plotted field, the packed values are multiplied by it.
+ * @param obj UAVO with new data
+ * @param timestamp time of the row
+ * @return
+ */
+bool SpectrogramData::appendPacked(UAVObject* obj, const QDateTime &timestamp)
+{
+    UAVObjectField* field = fieldRef.getField();
+    if (field == NULL)
+        return false;
+
+    if (field->getNumElements() < windowWidth){
+        qDebug() << "Incomplete data set in" << obj->getName() << "." << uavFieldName <<  "spectrogram: " << field->getNumElements() << " samples provided, but expected " << windowWidth;
+        return false;
+    }
+
+    // Resolve the elements of the row once
+    if (rowRefs.size() != (int) windowWidth){
+        rowRefs.clear();
+        for (unsigned int i = 0; i < windowWidth; i++)
+            rowRefs.append(UAVObjectFieldRef(field, i));
+
+        UAVObjectField* scaleField = obj->getField("Scale");
+        int scaleIdx = (scaleField != NULL) ? scaleField->getElementNames().indexOf(uavFieldName) : -1;
+        if (scaleIdx >= 0)
+            scaleRef = UAVObjectFieldRef(scaleField, scaleIdx);
+    }
+
+    double scale = scaleFactor;
+    if (scaleRef.isValid())
+        scale *= scaleRef.toDouble();
+
+    QVector<double> values;
+    for (unsigned int i = 0; i < windowWidth; i++){
+        double vecVal = rowRefs.at(i).toDouble() * scale;
+
+        // See if autoscale is turned on and if the value exceeds the maximum for the scope.
+        if ( zMaximum == 0 &&  vecVal > rasterData->interval(Qt::ZAxis).maxValue()){
+            // Change scope maximum and color depth
+            rasterData->setInterval(Qt::ZAxis, QwtInterval(0, vecVal) );
+            autoscaleValueUpdated = vecVal;
+        }
+        values += vecVal;
+    }
+
+    timeDataHistory->append(timestamp.toTime_t() + timestamp.time().msec() / 1000.0);
+    while (timeDataHistory->back() - timeDataHistory->front() > timeHorizon){
+        timeDataHistory->pop_front();
+        zDataHistory->remove(0, fminl(windowWidth, zDataHistory->size()));
+    }
+
+    *zDataHistory << values;
+
+    return true;
+}
+
+
 /**
  * @brief SpectrogramScopeConfig::clearPlots Clear all plot data
  */
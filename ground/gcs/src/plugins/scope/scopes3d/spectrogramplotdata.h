@@ -35,7 +35,9 @@
 
 #include <QTimer>
 #include <QTime>
+#include <QDateTime>
 #include <QVector>
+#include <QSize>
 
 
 /**
@@ -76,6 +78,11 @@ public:
 
 private:
     void resetAxisRanges();
+    void plotLevelOfDetail(const QSize &canvasSize);
+    bool appendPacked(UAVObject* obj, const QDateTime &timestamp);
+
+    QVector<UAVObjectFieldRef> rowRefs; //One element of the row each, resolved on the first row
+    UAVObjectFieldRef scaleRef;
 
     QwtPlotSpectrogram *spectrogram;
     QwtMatrixRasterData *rasterData;
@@ -84,6 +91,8 @@ private:
     double timeHorizon;
     unsigned int windowWidth;
     double autoscaleValueUpdated;
+    QSize plottedSize;  //Canvas size the raster data was made for
+
 };
 
 #endif // SPECTROGRAMDATA_H
@@ -86,6 +86,29 @@ void SystemHealthGadgetWidget::onAutopilotDisconnect()
 void SystemHealthGadgetWidget::updateAlarms(UAVObject* systemAlarm)
 {
     static QList<QString> warningClean;
+
+    // Resolve the alarm elements once, then read them directly on each update
+    if (alarmRefs.isEmpty()) {
+        UAVObjectField *field = systemAlarm->getField("Alarm");
+        Q_ASSERT(field);
+        if (field == NULL)
+            return;
+
+        alarmElements = field->getElementNames();
+        alarmOptions = field->getOptions();
+        for (uint i = 0; i < field->getNumElements(); ++i)
+            alarmRefs.append(UAVObjectFieldRef(field, i));
+    }
+
+    QVector<int> alarms(alarmRefs.size());
+    for (int i = 0; i < alarmRefs.size(); ++i)
+        alarms[i] = alarmRefs[i].toOptionIndex();
+
+    // Most updates don't change any alarm, the scene is only rebuilt when one did
+    if (alarms == shownAlarms)
+        return;
+    shownAlarms = alarms;
+
     // This code does not know anything about alarms beforehand, and
     // I found no efficient way to locate items inside the scene by
     // name, so it's just as simple to reset the scene:
@@ -96,14 +119,9 @@ void SystemHealthGadgetWidget::updateAlarms(UAVObject* systemAlarm)
         delete item; // removeItem does _not_ delete the item.
     }
 
-    UAVObjectField *field = systemAlarm->getField("Alarm");
-    Q_ASSERT(field);
-    if (field == NULL)
-        return;
-
-    for (uint i = 0; i < field->getNumElements(); ++i) {
-        QString element = field->getElementNames()[i];
-        QString value = field->getValue(i).toString();
+    for (int i = 0; i < alarms.size(); ++i) {
+        const QString &element = alarmElements.at(i);
+        QString value = (alarms[i] >= 0) ? alarmOptions.at(alarms[i]) : QString("Bad Value");
         if (m_renderer->elementExists(element)) {
             QMatrix blockMatrix = m_renderer->matrixForElement(element);
             qreal startX = blockMatrix.mapRect(m_renderer->boundsOnElement(element)).x();
@@ -144,6 +162,7 @@ void SystemHealthGadgetWidget::setSystemFile(QString dfn)
        m_renderer->load(dfn);
        if(m_renderer->isValid()) {
            fgenabled = false;
+           shownAlarms.clear(); // Draw the alarms again with the new file
            background->setSharedRenderer(m_renderer);
            background->setElementId("background");
 
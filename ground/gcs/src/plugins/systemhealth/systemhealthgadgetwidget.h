@@ -30,12 +30,14 @@
 
 #include "systemhealthgadgetconfiguration.h"
 #include "uavobject.h"
+#include "uavobjectfieldref.h"
 #include "uavtalk/telemetrymanager.h"
 #include <QGraphicsView>
 #include <QtSvg/QSvgRenderer>
 #include <QtSvg/QGraphicsSvgItem>
 #include <QMouseEvent>
 #include <QMap>
+#include <QVector>
 #include <QFile>
 #include <QTimer>
 
@@ -69,6 +71,11 @@ private:
                    // Simple flag to skip rendering if the
    bool fgenabled; // layer does not exist.
 
+   QVector<UAVObjectFieldRef> alarmRefs; // Elements of SystemAlarms.Alarm
+   QStringList alarmElements;
+   QStringList alarmOptions;
+   QVector<int> shownAlarms; // Option index of each alarm drawn in the scene
+
    void showAlarmDescriptionForItemId(const QString itemId, const QPoint& location);
    void showAllAlarmDescriptions(const QPoint &location);
    QString getAlarmDescriptionFileName(const QString itemId);
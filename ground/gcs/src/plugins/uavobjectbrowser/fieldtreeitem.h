@@ -29,6 +29,7 @@
 #define FIELDTREEITEM_H
 
 #include "treeitem.h"
+#include "uavobjectfieldref.h"
 #include <QtCore/QStringList>
 #include <QWidget>
 #include <QSpinBox>
@@ -71,15 +72,12 @@ Q_OBJECT
 public:
     EnumFieldTreeItem(UAVObjectField *field, int index, const QList<QVariant> &data,
                       TreeItem *parent = 0) :
-    FieldTreeItem(index, data, parent), m_enumOptions(field->getOptions()), m_field(field) { }
+    FieldTreeItem(index, data, parent), m_enumOptions(field->getOptions()), m_field(field), m_ref(field, index) { }
     EnumFieldTreeItem(UAVObjectField *field, int index, const QVariant &data,
                       TreeItem *parent = 0) :
-    FieldTreeItem(index, data, parent), m_enumOptions(field->getOptions()), m_field(field) { }
+    FieldTreeItem(index, data, parent), m_enumOptions(field->getOptions()), m_field(field), m_ref(field, index) { }
     void setData(QVariant value, int column) {
-        QStringList options = m_field->getOptions();
-        QVariant tmpValue = m_field->getValue(m_index);
-        int tmpValIndex = options.indexOf(tmpValue.toString());
-        setChanged(tmpValIndex != value);
+        setChanged(m_ref.toOptionIndex() != value);
         TreeItem::setData(value, column);
     }
     QString enumOptions(int index) {
@@ -100,9 +98,7 @@ public:
         setChanged(false);
     }
     void update() {
-        QStringList options = m_field->getOptions();
-        QVariant value = m_field->getValue(m_index);
-        int valIndex = options.indexOf(value.toString());
+        int valIndex = m_ref.toOptionIndex();
         if (data() != valIndex || changed()) {
             TreeItem::setData(valIndex);
             setHighlight(true);
@@ -128,6 +124,7 @@ public:
 private:
     QStringList m_enumOptions;
     UAVObjectField *m_field;
+    UAVObjectFieldRef m_ref;
 };
 
 class IntFieldTreeItem : public FieldTreeItem
@@ -135,11 +132,11 @@ class IntFieldTreeItem : public FieldTreeItem
 Q_OBJECT
 public:
     IntFieldTreeItem(UAVObjectField *field, int index, const QList<QVariant> &data, TreeItem *parent = 0) :
-            FieldTreeItem(index, data, parent), m_field(field) {
+            FieldTreeItem(index, data, parent), m_field(field), m_ref(field, index) {
         setMinMaxValues();
     }
     IntFieldTreeItem(UAVObjectField *field, int index, const QVariant &data, TreeItem *parent = 0) :
-            FieldTreeItem(index, data, parent), m_field(field) {
+            FieldTreeItem(index, data, parent), m_field(field), m_ref(field, index) {
         setMinMaxValues();
     }
 
@@ -229,30 +226,31 @@ public:
         setChanged(false);
     }
     void update() {
-
-        QVariant value = m_field->getValue(m_index);
+        QVariant value;
+        switch (m_field->getType()) {
+        case UAVObjectField::INT8:
+        case UAVObjectField::INT16:
+        case UAVObjectField::INT32:
+            value = (int)m_ref.toDouble();
+            break;
+        case UAVObjectField::UINT8:
+        case UAVObjectField::UINT16:
+        case UAVObjectField::UINT32:
+            value = (uint)m_ref.toDouble();
+            break;
+        default:
+            Q_ASSERT(false);
+            break;
+        }
         if (data() != value || changed()) {
-            switch (m_field->getType()) {
-            case UAVObjectField::INT8:
-            case UAVObjectField::INT16:
-            case UAVObjectField::INT32:
-                TreeItem::setData(value.toInt());
-                break;
-            case UAVObjectField::UINT8:
-            case UAVObjectField::UINT16:
-            case UAVObjectField::UINT32:
-                TreeItem::setData(value.toUInt());
-                break;
-            default:
-                Q_ASSERT(false);
-                break;
-            }
+            TreeItem::setData(value);
             setHighlight(true);
         }
     }
 
 private:
     UAVObjectField *m_field;
+    UAVObjectFieldRef m_ref;
     int m_minValue;
     int m_maxValue;
 };
@@ -262,9 +260,9 @@ class FloatFieldTreeItem : public FieldTreeItem
 Q_OBJECT
 public:
     FloatFieldTreeItem(UAVObjectField *field, int index, const QList<QVariant> &data, bool scientific = false, TreeItem *parent = 0) :
-        FieldTreeItem(index, data, parent), m_field(field), m_useScientificNotation(scientific){}
+        FieldTreeItem(index, data, parent), m_field(field), m_ref(field, index), m_useScientificNotation(scientific){}
     FloatFieldTreeItem(UAVObjectField *field, int index, const QVariant &data, bool scientific = false, TreeItem *parent = 0) :
-            FieldTreeItem(index, data, parent), m_field(field), m_useScientificNotation(scientific) { }
+            FieldTreeItem(index, data, parent), m_field(field), m_ref(field, index), m_useScientificNotation(scientific) { }
     void setData(QVariant value, int column) {
         setChanged(m_field->getValue(m_index) != value);
         TreeItem::setData(value, column);
@@ -274,7 +272,7 @@ public:
         setChanged(false);
     }
     void update() {
-        double value = m_field->getValue(m_index).toDouble();
+        double value = m_ref.toDouble();
         if (data() != value || changed()) {
             TreeItem::setData(value);
             setHighlight(true);
@@ -321,6 +319,7 @@ public:
     }
 private:
     UAVObjectField *m_field;
+    UAVObjectFieldRef m_ref;
     bool m_useScientificNotation;
 
 };
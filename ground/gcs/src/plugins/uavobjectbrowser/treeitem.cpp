@@ -56,7 +56,7 @@ bool HighLightManager::add(TreeItem *itemToAdd)
     // Check so that the item isn't already in the list
     if(!m_itemsList.contains(itemToAdd))
     {
-        m_itemsList.append(itemToAdd);
+        m_itemsList.insert(itemToAdd);
         return true;
     }
     return false;
@@ -72,7 +72,7 @@ bool HighLightManager::remove(TreeItem *itemToRemove)
     QMutexLocker locker(&m_listMutex);
 
     // Remove item and return result
-    return m_itemsList.removeOne(itemToRemove);
+    return m_itemsList.remove(itemToRemove);
 }
 
 /*
@@ -87,7 +87,7 @@ void HighLightManager::checkItemsExpired()
     QMutexLocker locker(&m_listMutex);
 
     // Get a mutable iterator for the list
-    QMutableLinkedListIterator<TreeItem*> iter(m_itemsList);
+    QMutableSetIterator<TreeItem*> iter(m_itemsList);
 
     // Loop over all items, check if they expired.
     while(iter.hasNext())
@@ -114,7 +114,8 @@ TreeItem::TreeItem(const QList<QVariant> &data, TreeItem *parent) :
         m_parent(parent),
         m_highlight(false),
         m_changed(false),
-        m_updated(false)
+        m_updated(false),
+        m_expanded(false)
 {
 }
 
@@ -124,7 +125,8 @@ TreeItem::TreeItem(const QVariant &data, TreeItem *parent) :
         m_parent(parent),
         m_highlight(false),
         m_changed(false),
-        m_updated(false)
+        m_updated(false),
+        m_expanded(false)
 {
     m_data << data << "" << "";
 }
@@ -208,12 +210,11 @@ void TreeItem::setHighlight(bool highlight) {
         else
             m_highlightExpires = QTime::currentTime().addMSecs(m_highlightTimeMs);
 
-        // Add to highlightmanager
-        if(m_highlightManager->add(this))
-        {
-            // Only emit signal if it was added
-            emit updateHighlight(this);
-        }
+        // Add to highlightmanager. The value may have changed while the item
+        // was highlighted, the model collects these signals and redraws the
+        // changed rows once per frame.
+        m_highlightManager->add(this);
+        emit updateHighlight(this);
     }
     else if(m_highlightManager->remove(this))
     {
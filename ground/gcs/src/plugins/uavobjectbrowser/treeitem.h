@@ -34,8 +34,8 @@
 #include "uavmetaobject.h"
 #include "uavobjectfield.h"
 #include <QtCore/QList>
-#include <QtCore/QLinkedList>
 #include <QtCore/QMap>
+#include <QtCore/QSet>
 #include <QtCore/QVariant>
 #include <QtCore/QTime>
 #include <QtCore/QTimer>
@@ -48,7 +48,7 @@ class TreeItem;
 * Small utility class that handles the higlighting of
 * tree grid items.
 * Basicly it maintains all items due to be restored to
-* non highlighted state in a linked list.
+* non highlighted state in a set.
 * A timer traverses this list periodically to find out
 * if any of the items should be restored. All items are
 * updated withan expiration timestamp when they expires.
@@ -81,8 +81,8 @@ private:
     // The timer checking highlight expiration.
     QTimer m_expirationTimer;
 
-    // The list holding all items due to be updated.
-    QLinkedList<TreeItem*> m_itemsList;
+    // The set holding all items due to be updated.
+    QSet<TreeItem*> m_itemsList;
 
     //Mutex to lock when accessing list.
     QMutex m_listMutex;
@@ -131,6 +131,10 @@ public:
     void setHighlight(bool highlight);
     static void setHighlightTime(int time) { m_highlightTimeMs = time; }
 
+    // Set by the model when the view expands or collapses the item
+    inline bool expanded() { return m_expanded; }
+    inline void setExpanded(bool expanded) { m_expanded = expanded; }
+
     inline bool changed() { return m_changed; }
     inline bool updatedOnly() { return m_updated; }
     inline virtual bool getIsPresentOnHardware() const { return isPresentOnHardware; }
@@ -183,6 +187,7 @@ private:
     bool m_highlight;
     bool m_changed;
     bool m_updated;
+    bool m_expanded;
     QTime m_highlightExpires;
     HighLightManager* m_highlightManager;
     static int m_highlightTimeMs;
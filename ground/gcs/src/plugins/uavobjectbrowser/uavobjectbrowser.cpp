@@ -33,7 +33,7 @@ UAVObjectBrowser::UAVObjectBrowser(QString classId, UAVObjectBrowserWidget *widg
         m_widget(widget),
         m_config(NULL)
 {
-    connect(m_widget,SIGNAL(viewOptionsChanged(bool,bool,bool,bool)),this,SLOT(viewOptionsChangedSlot(bool,bool,bool,bool)));
+    connect(m_widget,SIGNAL(viewOptionsChanged(bool,bool,bool,bool,bool)),this,SLOT(viewOptionsChangedSlot(bool,bool,bool,bool,bool)));
 }
 
 UAVObjectBrowser::~UAVObjectBrowser()
@@ -49,12 +49,12 @@ void UAVObjectBrowser::loadConfiguration(IUAVGadgetConfiguration* config)
     m_widget->setManuallyChangedColor(m->manuallyChangedColor());
     m_widget->setRecentlyUpdatedTimeout(m->recentlyUpdatedTimeout());
     m_widget->setOnlyHighlightChangedValues(m->onlyHighlightChangedValues());
-    m_widget->setViewOptions(m->categorizedView(),m->scientificView(),m->showMetaData(),m->hideNotPresentOnHw());
+    m_widget->setViewOptions(m->categorizedView(),m->scientificView(),m->showMetaData(),m->hideNotPresentOnHw(),m->onlyUpdateExpanded());
     m_widget->setNotPresentOnHwColor(m->notPresentOnHwColor());
     m_widget->initialize();
 }
 
-void UAVObjectBrowser::viewOptionsChangedSlot(bool categorized, bool scientific, bool metadata, bool hideNotPresent)
+void UAVObjectBrowser::viewOptionsChangedSlot(bool categorized, bool scientific, bool metadata, bool hideNotPresent, bool onlyExpanded)
 {
     if(m_config)
     {
@@ -62,6 +62,7 @@ void UAVObjectBrowser::viewOptionsChangedSlot(bool categorized, bool scientific,
         m_config->setScientificView(scientific);
         m_config->setShowMetaData(metadata);
         m_config->setHideNotPresentOnHw(hideNotPresent);
+        m_config->setOnlyUpdateExpanded(onlyExpanded);
     }
 }
 
@@ -50,7 +50,7 @@ public:
     QWidget *widget() { return m_widget; }
     void loadConfiguration(IUAVGadgetConfiguration* config);
 private slots:
-    void viewOptionsChangedSlot(bool categorized, bool scientific, bool metadata, bool showNotPresent);
+    void viewOptionsChangedSlot(bool categorized, bool scientific, bool metadata, bool showNotPresent, bool onlyExpanded);
 private:
     UAVObjectBrowserWidget *m_widget;
     UAVObjectBrowserConfiguration *m_config;
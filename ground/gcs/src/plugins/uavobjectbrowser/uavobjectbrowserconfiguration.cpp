@@ -38,7 +38,8 @@ UAVObjectBrowserConfiguration::UAVObjectBrowserConfiguration(QString classId, QS
     m_useCategorizedView(false),
     m_useScientificView(false),
     m_showMetaData(false),
-    m_hideNotPresentOnHw(false)
+    m_hideNotPresentOnHw(false),
+    m_onlyUpdateExpanded(false)
 {
     //if a saved configuration exists load it
     if(qSettings != 0) {
@@ -52,6 +53,7 @@ UAVObjectBrowserConfiguration::UAVObjectBrowserConfiguration(QString classId, QS
         m_useScientificView = qSettings->value("ScientificView").toBool();
         m_showMetaData = qSettings->value("showMetaData").toBool();
         m_hideNotPresentOnHw = qSettings->value("hideNotPresentOnHw",false).toBool();
+        m_onlyUpdateExpanded = qSettings->value("onlyUpdateExpanded",false).toBool();
         m_recentlyUpdatedColor = recent;
         m_manuallyChangedColor = manual;
         m_notPresentOnHwColor = present;
@@ -72,6 +74,7 @@ IUAVGadgetConfiguration *UAVObjectBrowserConfiguration::clone()
     m->m_useScientificView = m_useScientificView;
     m->m_showMetaData = m_showMetaData;
     m->m_hideNotPresentOnHw = m_hideNotPresentOnHw;
+    m->m_onlyUpdateExpanded = m_onlyUpdateExpanded;
     return m;
 }
 
@@ -89,4 +92,5 @@ void UAVObjectBrowserConfiguration::saveConfig(QSettings* qSettings) const {
     qSettings->setValue("ScientificView", m_useScientificView);
     qSettings->setValue("showMetaData", m_showMetaData);
     qSettings->setValue("hideNotPresentOnHw", m_hideNotPresentOnHw);
+    qSettings->setValue("onlyUpdateExpanded", m_onlyUpdateExpanded);
 }
@@ -46,6 +46,7 @@ Q_PROPERTY(bool m_useCategorizedView READ categorizedView WRITE setCategorizedVi
 Q_PROPERTY(bool m_useScientificView READ scientificView WRITE setScientificView)
 Q_PROPERTY(bool m_showMetaData READ showMetaData WRITE setShowMetaData)
 Q_PROPERTY(bool m_hideNotPresentOnHw READ hideNotPresentOnHw WRITE setHideNotPresentOnHw)
+Q_PROPERTY(bool m_onlyUpdateExpanded READ onlyUpdateExpanded WRITE setOnlyUpdateExpanded)
 
 public:
     explicit UAVObjectBrowserConfiguration(QString classId, QSettings* qSettings = 0, QObject *parent = 0);
@@ -62,6 +63,7 @@ public:
     bool scientificView() const { return m_useScientificView; }
     bool showMetaData() const { return m_showMetaData; }
     bool hideNotPresentOnHw() const { return m_hideNotPresentOnHw; }
+    bool onlyUpdateExpanded() const { return m_onlyUpdateExpanded; }
 
 signals:
 
@@ -75,6 +77,7 @@ public slots:
     void setScientificView(bool value) { m_useScientificView = value; }
     void setShowMetaData(bool value) { m_showMetaData = value; }
     void setHideNotPresentOnHw(bool value) { m_hideNotPresentOnHw = value; }
+    void setOnlyUpdateExpanded(bool value) { m_onlyUpdateExpanded = value; }
 private:
     QColor m_recentlyUpdatedColor;
     QColor m_manuallyChangedColor;
@@ -85,6 +88,7 @@ private:
     bool m_useScientificView;
     bool m_showMetaData;
     bool m_hideNotPresentOnHw;
+    bool m_onlyUpdateExpanded;
 };
 
 #endif // UAVOBJECTBROWSERCONFIGURATION_H
@@ -83,6 +83,7 @@ UAVObjectBrowserWidget::UAVObjectBrowserWidget(QWidget *parent) : QWidget(parent
 void UAVObjectBrowserWidget::onTreeItemExpanded(QModelIndex currentProxyIndex)
 {
     QModelIndex currentIndex = proxyModel->mapToSource(currentProxyIndex);
+    m_model->setExpanded(currentIndex, true);
     TreeItem *item = static_cast<TreeItem*>(currentIndex.internalPointer());
     TopTreeItem *top = dynamic_cast<TopTreeItem*>(item->parent());
 
@@ -143,6 +144,7 @@ void UAVObjectBrowserWidget::onTreeItemExpanded(QModelIndex currentProxyIndex)
 void UAVObjectBrowserWidget::onTreeItemCollapsed(QModelIndex currentProxyIndex)
 {
     QModelIndex currentIndex = proxyModel->mapToSource(currentProxyIndex);
+    m_model->setExpanded(currentIndex, false);
     TreeItem *item = static_cast<TreeItem*>(currentIndex.internalPointer());
     TopTreeItem *top = dynamic_cast<TopTreeItem*>(item->parent());
 
@@ -249,13 +251,17 @@ UAVObjectBrowserWidget::~UAVObjectBrowserWidget()
  * @param categorized true turns on categorized view
  * @param scientific true turns on scientific notation view
  * @param metadata true turns on metadata view
+ * @param hideNotPresent true hides the objects not present on the hardware
+ * @param onlyExpanded true only updates the objects that are expanded
  */
-void UAVObjectBrowserWidget::setViewOptions(bool categorized, bool scientific, bool metadata, bool hideNotPresent)
+void UAVObjectBrowserWidget::setViewOptions(bool categorized, bool scientific, bool metadata, bool hideNotPresent, bool onlyExpanded)
 {
     m_viewoptions->cbCategorized->setChecked(categorized);
     m_viewoptions->cbMetaData->setChecked(metadata);
     m_viewoptions->cbScientific->setChecked(scientific);
     m_viewoptions->cbHideNotPresent->setChecked(hideNotPresent);
+    m_viewoptions->cbOnlyExpanded->setChecked(onlyExpanded);
+    m_model->setOnlyUpdateExpanded(onlyExpanded);
 }
 
 /**
@@ -288,6 +294,7 @@ void UAVObjectBrowserWidget::initialize()
     connect(m_viewoptions->cbCategorized, SIGNAL(toggled(bool)), this, SLOT(viewOptionsChangedSlot()));
     connect(m_viewoptions->cbHideNotPresent,SIGNAL(toggled(bool)),this,SLOT(showNotPresent(bool)));
     connect(m_viewoptions->cbMetaData, SIGNAL(toggled(bool)), this, SLOT(showMetaData(bool)));
+    connect(m_viewoptions->cbOnlyExpanded, SIGNAL(toggled(bool)), this, SLOT(updateOnlyExpanded(bool)));
     connect(m_model,SIGNAL(presentOnHardwareChanged()),this, SLOT(doRefreshHiddenObjects()), (Qt::ConnectionType) (Qt::UniqueConnection | Qt::QueuedConnection));
 }
 
@@ -329,7 +336,7 @@ void UAVObjectBrowserWidget::showMetaData(bool show)
  */
 void UAVObjectBrowserWidget::refreshViewOptions()
 {
-    emit viewOptionsChanged(m_viewoptions->cbCategorized->isChecked(),m_viewoptions->cbScientific->isChecked(),m_viewoptions->cbMetaData->isChecked(),m_viewoptions->cbHideNotPresent->isChecked());
+    emit viewOptionsChanged(m_viewoptions->cbCategorized->isChecked(),m_viewoptions->cbScientific->isChecked(),m_viewoptions->cbMetaData->isChecked(),m_viewoptions->cbHideNotPresent->isChecked(),m_viewoptions->cbOnlyExpanded->isChecked());
 }
 
 /**
@@ -343,6 +350,16 @@ void UAVObjectBrowserWidget::showNotPresent(bool show)
     refreshHiddenObjects();
 }
 
+/**
+ * @brief UAVObjectBrowserWidget::updateOnlyExpanded Only updates the objects that are expanded
+ * @param onlyExpanded true stops updating the collapsed objects until they are expanded
+ */
+void UAVObjectBrowserWidget::updateOnlyExpanded(bool onlyExpanded)
+{
+    m_model->setOnlyUpdateExpanded(onlyExpanded);
+    refreshViewOptions();
+}
+
 void UAVObjectBrowserWidget::doRefreshHiddenObjects()
 {
     refreshHiddenObjects();
@@ -571,7 +588,7 @@ void UAVObjectBrowserWidget::viewSlot()
  */
 void UAVObjectBrowserWidget::viewOptionsChangedSlot()
 {
-    emit viewOptionsChanged(m_viewoptions->cbCategorized->isChecked(),m_viewoptions->cbScientific->isChecked(),m_viewoptions->cbMetaData->isChecked(),m_viewoptions->cbHideNotPresent);
+    refreshViewOptions();
     m_model->initializeModel(m_viewoptions->cbCategorized->isChecked(), m_viewoptions->cbScientific->isChecked());
 
     // Reset proxy model
@@ -95,12 +95,13 @@ public:
     void setNotPresentOnHwColor(QColor color) { m_notPresentOnHwColor = color; m_model->setNotPresentOnHwColor(color); }
     void setRecentlyUpdatedTimeout(int timeout) { m_recentlyUpdatedTimeout = timeout; m_model->setRecentlyUpdatedTimeout(timeout); }
     void setOnlyHighlightChangedValues(bool highlight) { m_onlyHighlightChangedValues = highlight; m_model->setOnlyHighlightChangedValues(highlight); }
-    void setViewOptions(bool categorized, bool scientific, bool metadata, bool hideNotPresent);
+    void setViewOptions(bool categorized, bool scientific, bool metadata, bool hideNotPresent, bool onlyExpanded);
     void initialize();
     void refreshHiddenObjects();
 public slots:
     void showMetaData(bool show);
     void showNotPresent(bool show);
+    void updateOnlyExpanded(bool onlyExpanded);
     void doRefreshHiddenObjects();
 private slots:
     void sendUpdate();
@@ -119,7 +120,7 @@ private slots:
     void searchTextCleared();
 
 signals:
-    void viewOptionsChanged(bool categorized,bool scientific,bool metadata,bool hideNotPresent);
+    void viewOptionsChanged(bool categorized,bool scientific,bool metadata,bool hideNotPresent,bool onlyExpanded);
 private:
     QPushButton *m_requestUpdate;
     QPushButton *m_sendUpdate;
@@ -41,6 +41,7 @@
 #include <math.h>
 
 #include <QApplication>
+#include <QScreen>
 
 UAVObjectTreeModel::UAVObjectTreeModel(QObject *parent, bool useScientificNotation) :
     QAbstractItemModel(parent),
@@ -51,6 +52,8 @@ UAVObjectTreeModel::UAVObjectTreeModel(QObject *parent, bool useScientificNotati
     m_updatedOnlyColor(QColor(174,207,250,255)),
     m_isPresentOnHwColor(QApplication::palette().text().color()),
     m_notPresentOnHwColor(QColor(174,207,250,255)),
+    m_onlyHighlightChangedValues(false),
+    m_onlyUpdateExpanded(false),
     m_useScientificFloatNotation(useScientificNotation),
     m_hideNotPresent(false),
     m_categorize(true),
@@ -66,6 +69,14 @@ UAVObjectTreeModel::UAVObjectTreeModel(QObject *parent, bool useScientificNotati
     m_currentTimeTimer.start(lrint(fmax(m_recentlyUpdatedTimeout / 10.0f, 10))); // Update the timer 10 times faster than the time
                                                                                  // out. In any case, never go faster than 10ms.
     TreeItem::setHighlightTime(m_recentlyUpdatedTimeout);
+
+    // Object updates are applied at most once per frame of the display
+    qreal refreshRate = 60;
+    if (QGuiApplication::primaryScreen() && QGuiApplication::primaryScreen()->refreshRate() > 0)
+        refreshRate = QGuiApplication::primaryScreen()->refreshRate();
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(lrint(1000 / refreshRate));
+    connect(&m_flushTimer, SIGNAL(timeout()), this, SLOT(flushUpdates()));
 }
 
 UAVObjectTreeModel::~UAVObjectTreeModel()
@@ -92,6 +103,8 @@ void UAVObjectTreeModel::setupModelData(UAVObjectManager *objManager, bool categ
         disconnect(objManager, SIGNAL(newInstance(UAVObject*)), this, SLOT(newObject(UAVObject*)));
         disconnect(objManager, SIGNAL(instanceRemoved(UAVObject*)), this, SLOT(instanceRemove(UAVObject*)));
         delete m_highlightManager;
+        m_dirtyObjects.clear();
+        m_changedItems.clear();
         int count = m_rootItem->childCount();
         beginRemoveRows(index(m_rootItem), 0, count);
         delete m_rootItem;
@@ -153,6 +166,7 @@ void UAVObjectTreeModel::instanceRemove(UAVObject *obj)
             InstanceTreeItem *inst = dynamic_cast<InstanceTreeItem*>(item);
             if(inst && inst->object() == obj)
             {
+                forgetItems(inst);
                 inst->parent()->removeChild(inst);
                 inst->deleteLater();
             }
@@ -288,9 +302,7 @@ void UAVObjectTreeModel::addSingleField(int index, UAVObjectField *field, TreeIt
     switch (type) {
     case UAVObjectField::BITFIELD:
     case UAVObjectField::ENUM: {
-        QStringList options = field->getOptions();
-        QVariant value = field->getValue();
-        data.append( options.indexOf(value.toString()) );
+        data.append(UAVObjectFieldRef(field, index).toOptionIndex());
         data.append(field->getUnits());
         item = new EnumFieldTreeItem(field, index, data);
         break;
@@ -512,20 +524,120 @@ QVariant UAVObjectTreeModel::headerData(int section, Qt::Orientation orientation
     return QVariant();
 }
 
+/**
+ * @brief UAVObjectTreeModel::highlightUpdatedObject Marks an object as updated. Objects
+ * can update much faster than the display, so the tree items are only refreshed by
+ * the next flushUpdates.
+ */
 void UAVObjectTreeModel::highlightUpdatedObject(UAVObject *obj)
 {
     Q_ASSERT(obj);
-    ObjectTreeItem *item = findObjectTreeItem(obj);
-    Q_ASSERT(item);
-    if(!m_onlyHighlightChangedValues){
-        item->setHighlight(true);
+    m_dirtyObjects.insert(obj);
+    if (!m_flushTimer.isActive())
+        m_flushTimer.start();
+}
+
+/**
+ * @brief UAVObjectTreeModel::flushUpdates Refreshes the items of the updated objects and
+ * emits dataChanged for the changed rows that can be seen, once per parent item.
+ */
+void UAVObjectTreeModel::flushUpdates()
+{
+    QMutableSetIterator<UAVObject*> iter(m_dirtyObjects);
+    while (iter.hasNext()) {
+        UAVObject *obj = iter.next();
+        ObjectTreeItem *item = findObjectTreeItem(obj);
+        Q_ASSERT(item);
+
+        // Collapsed objects stay dirty until they are expanded
+        if (m_onlyUpdateExpanded && !isExpanded(item))
+            continue;
+        iter.remove();
+
+        if (!m_onlyHighlightChangedValues)
+            item->setHighlight(true);
+        item->update();
     }
-    item->update();
-    if(!m_onlyHighlightChangedValues){
-        QModelIndex itemIndex = index(item);
-        Q_ASSERT(itemIndex != QModelIndex());
-        emit dataChanged(itemIndex, itemIndex);
+
+    // Rows under a collapsed item are read again by the view when it is expanded
+    QHash<TreeItem*, QPair<int, int> > changedRows;
+    foreach (TreeItem *item, m_changedItems) {
+        TreeItem *parentItem = item->parent();
+        if (parentItem == NULL || !isExpanded(parentItem))
+            continue;
+        int row = item->row();
+        if (row < 0)
+            continue;
+
+        QHash<TreeItem*, QPair<int, int> >::iterator it = changedRows.find(parentItem);
+        if (it == changedRows.end()) {
+            changedRows.insert(parentItem, qMakePair(row, row));
+        } else {
+            it->first = qMin(it->first, row);
+            it->second = qMax(it->second, row);
+        }
     }
+    m_changedItems.clear();
+
+    // Refreshing the items queued their rows again, they were handled above
+    m_flushTimer.stop();
+
+    for (QHash<TreeItem*, QPair<int, int> >::const_iterator it = changedRows.constBegin(); it != changedRows.constEnd(); ++it) {
+        TreeItem *parentItem = it.key();
+        emit dataChanged(createIndex(it->first, 0, parentItem->getChild(it->first)),
+                         createIndex(it->second, TreeItem::dataColumn, parentItem->getChild(it->second)));
+    }
+}
+
+/**
+ * @brief UAVObjectTreeModel::setOnlyUpdateExpanded Only refreshes the objects that are
+ * expanded in the view, the others are refreshed when they are expanded
+ */
+void UAVObjectTreeModel::setOnlyUpdateExpanded(bool onlyExpanded)
+{
+    m_onlyUpdateExpanded = onlyExpanded;
+    if (!m_onlyUpdateExpanded && !m_dirtyObjects.isEmpty() && !m_flushTimer.isActive())
+        m_flushTimer.start();
+}
+
+/**
+ * @brief UAVObjectTreeModel::setExpanded Tells the model which items the view shows
+ * @param index Index of this model
+ * @param expanded True if the item was expanded, false if it was collapsed
+ */
+void UAVObjectTreeModel::setExpanded(const QModelIndex &index, bool expanded)
+{
+    if (!index.isValid())
+        return;
+
+    TreeItem *item = static_cast<TreeItem*>(index.internalPointer());
+    item->setExpanded(expanded);
+
+    // Bring the objects that were just expanded up to date
+    if (expanded && m_onlyUpdateExpanded && !m_dirtyObjects.isEmpty() && !m_flushTimer.isActive())
+        m_flushTimer.start();
+}
+
+/**
+ * @brief UAVObjectTreeModel::isExpanded Returns true if the children of an item can be seen
+ */
+bool UAVObjectTreeModel::isExpanded(TreeItem *item)
+{
+    for (; item != m_rootItem; item = item->parent()) {
+        if (item == NULL || !item->expanded())
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief UAVObjectTreeModel::forgetItems Drops the pending updates of an item that is removed
+ */
+void UAVObjectTreeModel::forgetItems(TreeItem *item)
+{
+    m_changedItems.remove(item);
+    foreach (TreeItem *child, item->treeChildren())
+        forgetItems(child);
 }
 
 ObjectTreeItem* UAVObjectTreeModel::findObjectTreeItem(UAVObject *object)
@@ -560,9 +672,9 @@ MetaObjectTreeItem* UAVObjectTreeModel::findMetaObjectTreeItem(UAVMetaObject *ob
 
 void UAVObjectTreeModel::updateHighlight(TreeItem *item)
 {
-    QModelIndex itemIndex = index(item);
-    Q_ASSERT(itemIndex != QModelIndex());
-    emit dataChanged(itemIndex, itemIndex.sibling(itemIndex.row(), TreeItem::dataColumn));
+    m_changedItems.insert(item);
+    if (!m_flushTimer.isActive())
+        m_flushTimer.start();
 }
 
 
@@ -33,6 +33,7 @@
 #include <QAbstractItemModel>
 #include <QtCore/QMap>
 #include <QtCore/QList>
+#include <QtCore/QSet>
 #include <QColor>
 
 class TopTreeItem;
@@ -75,6 +76,8 @@ public:
         TreeItem::setHighlightTime(timeout);
     }
     void setOnlyHighlightChangedValues(bool highlight) {m_onlyHighlightChangedValues = highlight; }
+    void setOnlyUpdateExpanded(bool onlyExpanded);
+    void setExpanded(const QModelIndex &index, bool expanded);
 
     QList<QModelIndex> getMetaDataIndexes();
     QList<QModelIndex> getDataObjectIndexes();
@@ -91,11 +94,14 @@ private slots:
     void highlightUpdatedObject(UAVObject *obj);
     void updateHighlight(TreeItem*);
     void updateCurrentTime();
+    void flushUpdates();
     void presentOnHardwareChangedCB(UAVDataObject*);
 
 private:
     void setupModelData(UAVObjectManager *objManager, bool categorize = true, bool useScientificFloatNotation = true);
     QModelIndex index(TreeItem *item);
+    bool isExpanded(TreeItem *item);
+    void forgetItems(TreeItem *item);
     void addDataObject(UAVDataObject *obj, bool categorize = true);
     MetaObjectTreeItem *addMetaObject(UAVMetaObject *obj, TreeItem *parent);
     void addArrayField(UAVObjectField *field, TreeItem *parent);
@@ -119,11 +125,16 @@ private:
     QColor m_isPresentOnHwColor;
     QColor m_notPresentOnHwColor;
     bool m_onlyHighlightChangedValues;
+    bool m_onlyUpdateExpanded;
     bool m_useScientificFloatNotation;
     bool m_hideNotPresent;
     bool m_categorize;
     QTimer m_currentTimeTimer;
     QTime m_currentTime;
+    // Updates are collected here and applied once per frame by m_flushTimer
+    QSet<UAVObject*> m_dirtyObjects;
+    QSet<TreeItem*> m_changedItems;
+    QTimer m_flushTimer;
     UAVObjectManager *objManager;
     // Highlight manager to handle highlighting of tree items.
     HighLightManager *m_highlightManager;
@@ -36,10 +36,12 @@
 #include <QMap>
 
 class UAVObject;
+class UAVObjectFieldRef;
 
 class UAVOBJECTS_EXPORT UAVObjectField: public QObject
 {
     Q_OBJECT
+    friend class UAVObjectFieldRef;
 
 public:
     typedef enum { INT8 = 0, INT16, INT32, UINT8, UINT16, UINT32, FLOAT32, ENUM, BITFIELD, STRING } FieldType;
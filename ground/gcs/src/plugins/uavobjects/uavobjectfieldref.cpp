@@ -0,0 +1,102 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjectfieldref.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      A resolved reference to one element of a UAVObject field
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "uavobjectfieldref.h"
+#include "uavobjectmanager.h"
+
+UAVObjectFieldRef::UAVObjectFieldRef() :
+    obj(NULL), field(NULL), value(NULL), objId(0), index(0),
+    type(UAVObjectField::STRING), bit(0)
+{
+}
+
+/**
+ * Resolve an element of a field. The reference is invalid if the field isn't
+ * initialized, the index is out of range or the field is a string.
+ */
+UAVObjectFieldRef::UAVObjectFieldRef(UAVObjectField *field, quint32 index) :
+    obj(NULL), field(NULL), value(NULL), objId(0), index(0),
+    type(UAVObjectField::STRING), bit(0)
+{
+    if (field == NULL || field->data == NULL || field->obj == NULL)
+        return;
+    if (index >= field->numElements || field->type == UAVObjectField::STRING)
+        return;
+
+    this->obj = field->obj;
+    this->field = field;
+    this->objId = field->obj->getObjID();
+    this->index = index;
+    this->type = field->type;
+
+    // Bitfields pack eight elements in a byte
+    quint32 element = index;
+    if (type == UAVObjectField::BITFIELD) {
+        element = index / 8;
+        bit = index % 8;
+    }
+    value = &field->data[field->offset + field->numBytesPerElement * element];
+
+    if (type == UAVObjectField::ENUM) {
+        optionIndex.fill(-1, 256);
+        for (int i = 0; i < field->indices.length(); i++) {
+            int raw = field->indices.at(i);
+            if (raw >= 0 && raw < optionIndex.size() && optionIndex.at(raw) < 0)
+                optionIndex[raw] = i;
+        }
+    }
+}
+
+/**
+ * Resolve an element of a field by name
+ * @param[in] elementName the element, or empty for the first one
+ * @return the reference, invalid if any of the names is unknown
+ */
+UAVObjectFieldRef UAVObjectFieldRef::resolve(UAVObjectManager *objManager, const QString &objName,
+                                             const QString &fieldName, const QString &elementName,
+                                             quint32 instId)
+{
+    if (objManager == NULL)
+        return UAVObjectFieldRef();
+
+    UAVObject *obj = objManager->getObject(objName, instId);
+    if (obj == NULL)
+        return UAVObjectFieldRef();
+
+    UAVObjectField *field = obj->getField(fieldName);
+    if (field == NULL)
+        return UAVObjectFieldRef();
+
+    int index = 0;
+    if (!elementName.isEmpty()) {
+        index = field->getElementNames().indexOf(elementName);
+        if (index < 0)
+            return UAVObjectFieldRef();
+    }
+
+    return UAVObjectFieldRef(field, index);
+}
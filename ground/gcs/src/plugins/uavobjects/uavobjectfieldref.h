@@ -0,0 +1,128 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjectfieldref.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      A resolved reference to one element of a UAVObject field
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef UAVOBJECTFIELDREF_H
+#define UAVOBJECTFIELDREF_H
+
+#include "uavobjects_global.h"
+#include "uavobjectfield.h"
+#include <QVector>
+#include <string.h>
+
+class UAVObjectManager;
+
+/**
+ * Reference to one element of a field, with the object, the address of the
+ * element and its type resolved once. Reading it is a typed load from the
+ * object data, without a name lookup, the object lock or a QVariant.
+ *
+ * The reads don't lock the object, so they are meant for the GUI thread
+ * that also unpacks the telemetry. Use UAVObjectField::getValue from other
+ * threads. String fields can't be referenced.
+ */
+class UAVOBJECTS_EXPORT UAVObjectFieldRef
+{
+public:
+    UAVObjectFieldRef();
+    UAVObjectFieldRef(UAVObjectField *field, quint32 index = 0);
+
+    static UAVObjectFieldRef resolve(UAVObjectManager *objManager, const QString &objName,
+                                     const QString &fieldName, const QString &elementName = QString(),
+                                     quint32 instId = 0);
+
+    bool isValid() const { return value != NULL; }
+    UAVObject *getObject() const { return obj; }
+    UAVObjectField *getField() const { return field; }
+    quint32 getObjID() const { return objId; }
+    quint32 getIndex() const { return index; }
+
+    //! True if updates of this object change the referenced value
+    bool refersTo(const UAVObject *other) const { return other != NULL && other == obj; }
+
+    /**
+     * Read the element as a double. Enums read as the index of their option
+     * in UAVObjectField::getOptions, bitfields as 0 or 1.
+     */
+    double toDouble() const
+    {
+        switch (type) {
+        case UAVObjectField::INT8:
+            return load<qint8>();
+        case UAVObjectField::INT16:
+            return load<qint16>();
+        case UAVObjectField::INT32:
+            return load<qint32>();
+        case UAVObjectField::UINT8:
+            return load<quint8>();
+        case UAVObjectField::UINT16:
+            return load<quint16>();
+        case UAVObjectField::UINT32:
+            return load<quint32>();
+        case UAVObjectField::FLOAT32:
+            return load<float>();
+        case UAVObjectField::ENUM:
+        case UAVObjectField::BITFIELD:
+            return toOptionIndex();
+        default:
+            return 0;
+        }
+    }
+
+    /**
+     * Index of the option an enum or bitfield element is set to
+     * @return the index, or -1 if the value has no option or the field has no options
+     */
+    int toOptionIndex() const
+    {
+        if (type == UAVObjectField::BITFIELD)
+            return (load<quint8>() >> bit) & 1;
+        if (type != UAVObjectField::ENUM)
+            return -1;
+        return optionIndex.at(load<quint8>());
+    }
+
+private:
+    template <typename T> T load() const
+    {
+        // The object data is packed, the element may be unaligned
+        T tmp;
+        memcpy(&tmp, value, sizeof(tmp));
+        return tmp;
+    }
+
+    UAVObject *obj;
+    UAVObjectField *field;
+    const quint8 *value;
+    quint32 objId;
+    quint32 index;
+    UAVObjectField::FieldType type;
+    quint8 bit;
+    //! Option index of each raw enum value, -1 if it has none
+    QVector<qint16> optionIndex;
+};
+
+#endif // UAVOBJECTFIELDREF_H
@@ -52,43 +52,46 @@ bool UAVObjectManager::registerObject(UAVDataObject* obj)
     QMutexLocker locker(mutex);
     // Check if this object type is already in the list
     quint32 objID = obj->getObjID();
-    if (objects.contains(objID))//Known object ID
+    QHash<quint32, int>::const_iterator index = objectIndex.constFind(objID);
+    if (index != objectIndex.constEnd())//Known object ID
     {
-        if (objects.value(objID).contains(obj->getInstID()))//Instance already present
+        // Instances are stored by their ID, without gaps
+        int dataIndex = dataObjectIndex.value(objID);
+        quint32 numInstances = objects.at(*index).size();
+        if (obj->getInstID() < numInstances)//Instance already present
             return false;
         if (obj->isSingleInstance())
             return false;
         if (obj->getInstID() >= MAX_INSTANCES)
             return false;
-        UAVDataObject* refObj = dynamic_cast<UAVDataObject*>(objects.value(objID).first());
-        if (refObj == NULL)
+        UAVMetaObject* mobj = dynamic_cast<UAVMetaObject*>(getObject(objID + 1));
+        if (mobj == NULL)
         {
             return false;
         }
-        UAVMetaObject* mobj = refObj->getMetaObject();
-        if (objects.value(objID).last()->getInstID() < obj->getInstID())//Space between last existent instance and new one, lets fill the gaps
+        //Space between last existent instance and new one, lets fill the gaps
+        QVector<UAVDataObject*> newInstances;
+        for (quint32 instidx = numInstances; instidx < obj->getInstID(); ++instidx)
         {
-            for (quint32 instidx = objects.value(objID).last()->getInstID() + 1 ; instidx < obj->getInstID(); ++instidx)
-            {
-                UAVDataObject* cobj = obj->clone(instidx);
-                cobj->initialize(instidx,mobj);
-                QMap<quint32,UAVObject*> ppp;
-                ppp.insert(instidx,cobj);
-                objects[objID].insert(instidx,cobj);
-                getObject(cobj->getObjID())->emitNewInstance(cobj);//TODO??
-                emit newInstance(cobj);
-            }
+            UAVDataObject* cobj = obj->clone(instidx);
+            cobj->initialize(instidx,mobj);
+            newInstances.append(cobj);
         }
-        else if (obj->getInstID() == 0)
-            obj->initialize(objects.value(objID).last()->getObjID() + 1, mobj);
-        else
+        // Add the actual object instance in the list
+        newInstances.append(obj);
+
+        // The table is only changed here, slots may copy it while the signals are emitted
+        foreach (UAVDataObject* inst, newInstances)
         {
-            return false;
+            objects[*index].append(inst);
+            dataObjects[dataIndex].append(inst);
+        }
+        UAVObject* firstInstance = objects.at(*index).first();
+        foreach (UAVDataObject* inst, newInstances)
+        {
+            firstInstance->emitNewInstance(inst);
+            emit newInstance(inst);
         }
-        // Add the actual object instance in the list
-        objects[objID].insert(obj->getInstID(),obj);
-        getObject(objID)->emitNewInstance(obj);
-        emit newInstance(obj);
         return true;
     }
     else
@@ -102,7 +105,10 @@ bool UAVObjectManager::registerObject(UAVDataObject* obj)
         // Initialize object
         obj->initialize(0, mobj);
         // Add to list
+        dataObjectIndex.insert(objID, dataObjects.size());
+        dataObjects.append(QVector<UAVDataObject*>() << obj);
         addObject(obj);
+        metaObjects.append(QVector<UAVMetaObject*>() << mobj);
         addObject(mobj);
         return true;
     }
@@ -120,94 +126,65 @@ bool UAVObjectManager::unRegisterObject(UAVDataObject* obj)
     quint32 objID = obj->getObjID();
     if(obj->isSingleInstance())
         return false;
-    quint32 instances = (quint32)objects.value(obj->getObjID()).count();
-    for(quint32 x = obj->getInstID(); x < instances; ++x)
+    if(!objectIndex.contains(objID))
+        return true;
+    int index = objectIndex.value(objID);
+    int dataIndex = dataObjectIndex.value(objID);
+    if(obj->getInstID() >= (quint32)objects.at(index).size())
+        return true;
+
+    // Remove the instances first, slots may copy the table while the signals are emitted
+    UAVObject* firstInstance = objects.at(index).first();
+    QVector<UAVObject*> removed = objects.at(index).mid(obj->getInstID());
+    objects[index].resize(obj->getInstID());
+    dataObjects[dataIndex].resize(obj->getInstID());
+    foreach(UAVObject* inst, removed)
     {
-        getObject(objects.value(objID).value(x)->getObjID())->emitInstanceRemoved(objects.value(objID).value(x));
-        emit instanceRemoved(objects.value(objID).value(x));
-        objects[objID].remove(x);
+        firstInstance->emitInstanceRemoved(inst);
+        emit instanceRemoved(inst);
     }
     return true;
 }
 
+/**
+ * Adds a new object type to the table, with the object as its first instance
+ */
 void UAVObjectManager::addObject(UAVObject* obj)
 {
     // Add to list
-    QMap<quint32,UAVObject*> list;
-    list.insert(obj->getInstID(),obj);
-    objects.insert(obj->getObjID(),list);
+    objectIndex.insert(obj->getObjID(), objects.size());
+    nameIndex.insert(obj->getName(), objects.size());
+    objects.append(QVector<UAVObject*>() << obj);
     emit newObject(obj);
 }
 
 /**
  * Get all objects. A two dimentional QVector is returned. Objects are grouped by
- * instances of the same object type.
+ * instances of the same object type. The vectors are implicitly shared with the
+ * manager, so this doesn't copy them.
  */
 QVector< QVector<UAVObject*> > UAVObjectManager::getObjectsVector()
 {
     QMutexLocker locker(mutex);
-    QVector< QVector<UAVObject*> > vector;
-    foreach(ObjectMap map,objects.values())
-    {
-        QVector<UAVObject*> vec = map.values().toVector();
-        vector.append(vec);
-    }
-    return vector;
-}
-
-QHash<quint32, QMap<quint32, UAVObject *> > UAVObjectManager::getObjects()
-{
     return objects;
 }
 
 /**
- * Same as getObjects() but will only return DataObjects.
+ * Same as getObjectsVector() but will only return DataObjects.
  */
 QVector< QVector<UAVDataObject*> > UAVObjectManager::getDataObjectsVector()
 {
     QMutexLocker locker(mutex);
-    QVector< QVector<UAVDataObject*> > vector;
-    foreach(ObjectMap map,objects.values())
-    {
-        UAVDataObject* obj = dynamic_cast<UAVDataObject*>(map.first());
-        if(obj!=NULL)
-        {
-            QVector<UAVDataObject*> vec;
-            foreach(UAVObject* o,map)
-            {
-                UAVDataObject* dobj = dynamic_cast<UAVDataObject*>(o);
-                if(dobj)
-                    vec.append(dobj);
-            }
-            vector.append(vec);
-        }
-     }
-    return vector;
+    return dataObjects;
 }
 
 /**
- * Same as getObjects() but will only return MetaObjects.
+ * Same as getObjectsVector() but will only return MetaObjects.
  */
 QVector <QVector<UAVMetaObject*> > UAVObjectManager::getMetaObjectsVector()
 {
     QMutexLocker locker(mutex);
-    QVector< QVector<UAVMetaObject*> > vector;
-    foreach(ObjectMap map,objects.values())
-    {
-        UAVMetaObject* obj = dynamic_cast<UAVMetaObject*>(map.first());
-        if(obj!=NULL)
-        {
-            QVector<UAVMetaObject*> vec;
-            foreach(UAVObject* o,map)
-            {
-                UAVMetaObject* mobj = dynamic_cast<UAVMetaObject*>(o);
-                if(mobj)
-                    vec.append(mobj);
-            }
-            vector.append(vec);
-        }
-     }
-    return vector;
+    return metaObjects;
 }
 
 /**
@@ -216,7 +193,11 @@ QVector <QVector<UAVMetaObject*> > UAVObjectManager::getMetaObjectsVector()
  */
 UAVObject* UAVObjectManager::getObject(const QString& name, quint32 instId)
 {
-    return getObject(&name, 0, instId);
+    QMutexLocker locker(mutex);
+    QHash<QString, int>::const_iterator index = nameIndex.constFind(name);
+    if (index == nameIndex.constEnd())
+        return NULL;
+    return objects.at(*index).value(instId, NULL);
 }
 
 /**
@@ -224,27 +205,12 @@ UAVObject* UAVObjectManager::getObject(const QString& name, quint32 instId)
  * @returns The object is found or NULL if not
  */
 UAVObject* UAVObjectManager::getObject(quint32 objId, quint32 instId)
-{
-    return getObject(NULL, objId, instId);
-}
-
-/**
- * Helper function for the public getObject() functions.
- */
-UAVObject* UAVObjectManager::getObject(const QString* name, quint32 objId, quint32 instId)
 {
     QMutexLocker locker(mutex);
-    if(name != NULL)
-    {
-        foreach(ObjectMap map,objects)
-        {
-            if(map.first()->getName().compare(name) == 0)
-                return map.value(instId,NULL);
-        }
-    }
-    else if(objects.contains(objId))
-        return objects.value(objId).value(instId);
-    return NULL;
+    QHash<quint32, int>::const_iterator index = objectIndex.constFind(objId);
+    if (index == objectIndex.constEnd())
+        return NULL;
+    return objects.at(*index).value(instId, NULL);
 }
 
 /**
@@ -252,34 +218,23 @@ UAVObject* UAVObjectManager::getObject(const QString* name, quint32 objId, quint
  */
 QVector<UAVObject*> UAVObjectManager::getObjectInstancesVector(const QString& name)
 {
-    return getObjectInstancesVector(&name, 0);
+    QMutexLocker locker(mutex);
+    QHash<QString, int>::const_iterator index = nameIndex.constFind(name);
+    if (index == nameIndex.constEnd())
+        return QVector<UAVObject*>();
+    return objects.at(*index);
 }
 
 /**
  * Get all the instances of the object specified by its ID
  */
 QVector<UAVObject*> UAVObjectManager::getObjectInstancesVector(quint32 objId)
-{
-    return getObjectInstancesVector(NULL, objId);
-}
-
-/**
- * Helper function for the public getObjectInstances()
- */
-QVector<UAVObject*> UAVObjectManager::getObjectInstancesVector(const QString* name, quint32 objId)
 {
     QMutexLocker locker(mutex);
-    if(name != NULL)
-    {
-        foreach(ObjectMap map,objects)
-        {
-            if(map.first()->getName().compare(name) == 0)
-                return map.values().toVector();
-        }
-    }
-    else if(objects.contains(objId))
-        return objects.value(objId).values().toVector();
-    return  QVector<UAVObject*>();
+    QHash<quint32, int>::const_iterator index = objectIndex.constFind(objId);
+    if (index == objectIndex.constEnd())
+        return QVector<UAVObject*>();
+    return objects.at(*index);
 }
 
 /**
@@ -287,32 +242,21 @@ QVector<UAVObject*> UAVObjectManager::getObjectInstancesVector(const QString* na
  */
 qint32 UAVObjectManager::getNumInstances(const QString& name)
 {
-    return getNumInstances(&name, 0);
+    QMutexLocker locker(mutex);
+    QHash<QString, int>::const_iterator index = nameIndex.constFind(name);
+    if (index == nameIndex.constEnd())
+        return -1;
+    return objects.at(*index).size();
 }
 
 /**
  * Get the number of instances for an object given its ID
  */
 qint32 UAVObjectManager::getNumInstances(quint32 objId)
-{
-    return getNumInstances(NULL, objId);
-}
-
-/**
- * Helper function for public getNumInstances
- */
-qint32 UAVObjectManager::getNumInstances(const QString* name, quint32 objId)
 {
     QMutexLocker locker(mutex);
-    if(name != NULL)
-    {
-        foreach(ObjectMap map,objects)
-        {
-            if(map.first()->getName().compare(name) == 0)
-                return map.count();
-        }
-    }
-    else if(objects.contains(objId))
-        return objects.value(objId).count();
-    return -1;
+    QHash<quint32, int>::const_iterator index = objectIndex.constFind(objId);
+    if (index == objectIndex.constEnd())
+        return -1;
+    return objects.at(*index).size();
 }
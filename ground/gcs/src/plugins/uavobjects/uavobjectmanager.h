@@ -45,10 +45,8 @@ class UAVOBJECTS_EXPORT UAVObjectManager: public QObject
 public:
     UAVObjectManager();
     ~UAVObjectManager();
-    typedef QMap<quint32,UAVObject*> ObjectMap;
     bool registerObject(UAVDataObject* obj);
     QVector< QVector<UAVObject*> > getObjectsVector();
-    QHash<quint32, QMap<quint32,UAVObject*> > getObjects();
     QVector< QVector<UAVDataObject*> > getDataObjectsVector();
     QVector< QVector<UAVMetaObject*> > getMetaObjectsVector();
     UAVObject* getObject(const QString& name, quint32 instId = 0);
@@ -64,13 +62,19 @@ signals:
     void instanceRemoved(UAVObject* obj);
 private:
     static const quint32 MAX_INSTANCES = 1000;
-    QHash<quint32, QMap<quint32,UAVObject*> > objects;
+    // The instances of each object type, indexed by instance ID. Types are never
+    // removed, so the index of a type in these tables doesn't change.
+    QVector< QVector<UAVObject*> > objects;
+    QVector< QVector<UAVDataObject*> > dataObjects;
+    QVector< QVector<UAVMetaObject*> > metaObjects;
+    // Index of each type in objects, by object ID and by name
+    QHash<quint32, int> objectIndex;
+    QHash<QString, int> nameIndex;
+    // Index of each data object type in dataObjects
+    QHash<quint32, int> dataObjectIndex;
     QMutex* mutex;
 
     void addObject(UAVObject* obj);
-    UAVObject* getObject(const QString* name, quint32 objId, quint32 instId);
-    QVector<UAVObject*> getObjectInstancesVector(const QString* name, quint32 objId);
-    qint32 getNumInstances(const QString* name, quint32 objId);
 };
 
 
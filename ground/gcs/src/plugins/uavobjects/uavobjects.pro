@@ -10,6 +10,7 @@ HEADERS += uavobjects_global.h \
     uavobjectmanager.h \
     uavdataobject.h \
     uavobjectfield.h \
+    uavobjectfieldref.h \
     uavobjectsinit.h \
     uavobjectsplugin.h
 
@@ -18,6 +19,7 @@ SOURCES += uavobject.cpp \
     uavobjectmanager.cpp \
     uavdataobject.cpp \
     uavobjectfield.cpp \
+    uavobjectfieldref.cpp \
     uavobjectsplugin.cpp
 
 OTHER_FILES += UAVObjects.pluginspec \
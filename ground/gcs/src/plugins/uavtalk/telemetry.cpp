@@ -33,6 +33,7 @@
 #include <QTime>
 #include <QtGlobal>
 #include <stdlib.h>
+#include <string.h>
 #include <QDebug>
 
 #ifdef TELEMETRY_DEBUG
@@ -42,7 +43,7 @@
 #endif	// TELEMETRY_DEBUG
 
 /**
- * @brief The TransactionKey class A key for the QMap to track transactions
+ * @brief The TransactionKey class A key for the QHash to track transactions
  */
 class TransactionKey {
 public:
@@ -63,16 +64,16 @@ public:
         return (rhs.objId == objId && rhs.instId == instId && rhs.req == req);
     }
 
-    bool operator<(const TransactionKey & rhs) const {
-        return objId < rhs.objId || (objId == rhs.objId && instId < rhs.instId) ||
-                (objId == rhs.objId && instId == rhs.instId && req != rhs.req);
-    }
-
     quint32 objId;
     quint32 instId;
     bool req;
 };
 
+inline uint qHash(const TransactionKey &key)
+{
+    return key.objId ^ (key.instId << 1) ^ (key.req ? 1 : 0);
+}
+
 /**
  * Constructor
  */
@@ -81,6 +82,14 @@ Telemetry::Telemetry(UAVTalk* utalk, UAVObjectManager* objMngr)
     this->utalk = utalk;
     this->objMngr = objMngr;
     mutex = new QMutex(QMutex::Recursive);
+    // Setup the timeout wheel, it only runs while transactions are pending
+    maxConcurrentTransactions = DEFAULT_MAX_CONCURRENT_TRANSACTIONS;
+    processingQueue = false;
+    timeoutWheel.resize(TIMEOUT_WHEEL_SLOTS);
+    timeoutWheelSlot = 0;
+    timeoutTimer = new QTimer(this);
+    connect(timeoutTimer, SIGNAL(timeout()), this, SLOT(processTimeouts()));
+    clock.start();
     // Process all objects in the list
     QVector< QVector<UAVObject*> > objs = objMngr->getObjectsVector();
     const int objSize = objs.size();
@@ -104,13 +113,23 @@ Telemetry::Telemetry(UAVTalk* utalk, UAVObjectManager* objMngr)
     // Setup and start the stats timer
     txErrors = 0;
     txRetries = 0;
+    memset(queueDepthHistogram, 0, sizeof(queueDepthHistogram));
+    memset(latencyHistogram, 0, sizeof(latencyHistogram));
 }
 
 Telemetry::~Telemetry()
 {
-    for (QMap<TransactionKey, ObjectTransactionInfo*>::iterator itr = transMap.begin(); itr != transMap.end(); ++itr) {
-        delete itr.value();
-    }
+}
+
+/**
+ * Set how many transactions can wait for an answer at the same time. Links with
+ * a long round trip are much faster with several transactions in flight.
+ */
+void Telemetry::setMaxConcurrentTransactions(int max)
+{
+    QMutexLocker locker(mutex);
+    maxConcurrentTransactions = qMax(max, 1);
+    processObjectQueue();
 }
 
 /**
@@ -276,7 +295,7 @@ void Telemetry::updateObject(UAVObject* obj, quint32 eventType)
  */
 void Telemetry::transactionSuccess(UAVObject* obj)
 {
-    if (updateTransactionMap(obj,false)) {
+    if (updateTransactionMap(obj, false, true)) {
         TELEMETRY_QXTLOG_DEBUG(QString("[telemetry.cpp] Transaction succeeded:%0 Instance:%1").arg(obj->getName() + QString(QString(" 0x") + QString::number(obj->getObjID(), 16).toUpper())).arg(obj->getInstID()));
         obj->emitTransactionCompleted(true);
         obj->emitTransactionCompleted(true,false);
@@ -302,7 +321,7 @@ void Telemetry::transactionFailure(UAVObject* obj)
         nacked = true;
     // Here we need to check for true or false as a NAK can occur for OBJ_REQ or an
     // object set
-    if (updateTransactionMap(obj, true) || updateTransactionMap(obj, false)) {
+    if (updateTransactionMap(obj, true, nacked) || updateTransactionMap(obj, false, nacked)) {
         TELEMETRY_QXTLOG_DEBUG(QString("[telemetry.cpp] Transaction failed:%0 Instance:%1").arg(obj->getName() + QString(QString(" 0x") + QString::number(obj->getObjID(), 16).toUpper())).arg(obj->getInstID()));
         obj->emitTransactionCompleted(false);
         obj->emitTransactionCompleted(false,nacked);
@@ -320,7 +339,7 @@ void Telemetry::transactionFailure(UAVObject* obj)
  */
 void Telemetry::transactionRequestCompleted(UAVObject* obj)
 {
-    if (updateTransactionMap(obj,true)) {
+    if (updateTransactionMap(obj, true, true)) {
         TELEMETRY_QXTLOG_DEBUG(QString("[telemetry.cpp] Transaction succeeded:%0 Instance:%1").arg(obj->getName() + QString(QString(" 0x") + QString::number(obj->getObjID(), 16).toUpper())).arg(obj->getInstID()));
         obj->emitTransactionCompleted(true);
         obj->emitTransactionCompleted(true,false);
@@ -338,73 +357,136 @@ void Telemetry::transactionRequestCompleted(UAVObject* obj)
  * @param obj pointer to the UAV Object
  * @param request : true if the entry in the transaction map should be an object request,
  *                  false if the entry in the transaction map should be an object sent
+ * @param answered : true if the remote end answered, the latency is then recorded
  *
  */
-bool Telemetry::updateTransactionMap(UAVObject* obj, bool request)
+bool Telemetry::updateTransactionMap(UAVObject* obj, bool request, bool answered)
 {
-    TransactionKey key(obj, request);
-    QMap<TransactionKey, ObjectTransactionInfo*>::iterator itr = transMap.find(key);
+    QHash<TransactionKey, int>::iterator itr = transMap.find(TransactionKey(obj, request));
     if ( itr != transMap.end() )
     {
-        ObjectTransactionInfo *transInfo = itr.value();
-        // Remove this transaction as it is complete.
-        transInfo->timer->stop();
-        transMap.remove(key);
-        delete transInfo;
+        int transaction = itr.value();
+        // Remove this transaction as it is complete, its timeout entry is now stale
+        transMap.erase(itr);
+        transPool[transaction].inUse = false;
+        freeTransactions.append(transaction);
+        if (answered)
+            ++latencyHistogram[histogramBin((quint32) ((clock.elapsed() - transPool.at(transaction).startMs) / 8))];
         return true;
     }
     return false;
 }
 
+/**
+ * Get a free transaction from the pool
+ */
+int Telemetry::allocateTransaction()
+{
+    int transaction;
+    if (!freeTransactions.isEmpty())
+    {
+        transaction = freeTransactions.last();
+        freeTransactions.removeLast();
+    }
+    else
+    {
+        transaction = transPool.size();
+        ObjectTransactionInfo transInfo;
+        transInfo.generation = 0;
+        transPool.append(transInfo);
+    }
+    transPool[transaction].inUse = true;
+    transPool[transaction].startMs = clock.elapsed();
+    return transaction;
+}
+
+/**
+ * Put a transaction in the slot of the timeout wheel REQ_TIMEOUT_MS ahead
+ */
+void Telemetry::scheduleTimeout(int transaction)
+{
+    TimeoutInfo timeoutInfo;
+    timeoutInfo.transaction = transaction;
+    timeoutInfo.generation = ++transPool[transaction].generation;
+
+    int ticks = (REQ_TIMEOUT_MS + TIMEOUT_WHEEL_TICK_MS - 1) / TIMEOUT_WHEEL_TICK_MS;
+    timeoutWheel[(timeoutWheelSlot + ticks) % TIMEOUT_WHEEL_SLOTS].append(timeoutInfo);
+
+    if (!timeoutTimer->isActive())
+        timeoutTimer->start(TIMEOUT_WHEEL_TICK_MS);
+}
+
+/**
+ * @brief Telemetry::processTimeouts Advances the timeout wheel by one slot and times out
+ * the transactions of that slot that are still pending
+ */
+void Telemetry::processTimeouts()
+{
+    QMutexLocker locker(mutex);
+
+    timeoutWheelSlot = (timeoutWheelSlot + 1) % TIMEOUT_WHEEL_SLOTS;
+    QVector<TimeoutInfo> expired;
+    expired.swap(timeoutWheel[timeoutWheelSlot]);
+
+    foreach (const TimeoutInfo &timeoutInfo, expired)
+    {
+        const ObjectTransactionInfo &transInfo = transPool.at(timeoutInfo.transaction);
+        if (transInfo.inUse && transInfo.generation == timeoutInfo.generation)
+            transactionTimeout(timeoutInfo.transaction);
+    }
+
+    if (transMap.isEmpty())
+        timeoutTimer->stop();
+}
 
 /**
  * Called when a transaction is not completed within the timeout period (timer event)
  */
-void Telemetry::transactionTimeout(ObjectTransactionInfo *transInfo)
+void Telemetry::transactionTimeout(int transaction)
 {
-    transInfo->timer->stop();
+    UAVObject* obj = transPool.at(transaction).obj;
     // Check if more retries are pending
-    if (transInfo->retriesRemaining > 0)
+    if (transPool.at(transaction).retriesRemaining > 0)
     {
-        TELEMETRY_QXTLOG_DEBUG(QString("[telemetry.cpp] Transaction timeout:%0 Instance:%1 Retrying").arg(transInfo->obj->getName() + QString(QString(" 0x") + QString::number(transInfo->obj->getObjID(), 16).toUpper())).arg(transInfo->obj->getInstID()));
-        --transInfo->retriesRemaining;
-        processObjectTransaction(transInfo);
+        TELEMETRY_QXTLOG_DEBUG(QString("[telemetry.cpp] Transaction timeout:%0 Instance:%1 Retrying").arg(obj->getName() + QString(QString(" 0x") + QString::number(obj->getObjID(), 16).toUpper())).arg(obj->getInstID()));
+        --transPool[transaction].retriesRemaining;
+        processObjectTransaction(transaction);
         ++txRetries;
     }
     else
     {
-        TELEMETRY_QXTLOG_DEBUG(QString("[telemetry.cpp] Transaction timeout:%0 Instance:%1 no more retries. FAILED TRANSACT").arg(transInfo->obj->getName() + QString(QString(" 0x") + QString::number(transInfo->obj->getObjID(), 16).toUpper())).arg(transInfo->obj->getInstID()));
-        transInfo->timer->stop();
-        transactionFailure(transInfo->obj);
+        TELEMETRY_QXTLOG_DEBUG(QString("[telemetry.cpp] Transaction timeout:%0 Instance:%1 no more retries. FAILED TRANSACT").arg(obj->getName() + QString(QString(" 0x") + QString::number(obj->getObjID(), 16).toUpper())).arg(obj->getInstID()));
+        transactionFailure(obj);
         ++txErrors;
     }
 }
 
 /**
- * Start an object transaction with UAVTalk, all information is stored in transInfo.
+ * Start an object transaction with UAVTalk, all information is stored in the pool.
  */
-void Telemetry::processObjectTransaction(ObjectTransactionInfo *transInfo)
+void Telemetry::processObjectTransaction(int transaction)
 {
+    // Copied, sending may add transactions to the pool
+    ObjectTransactionInfo transInfo = transPool.at(transaction);
 
     // Initiate transaction
-    if (transInfo->objRequest)
+    if (transInfo.objRequest)
     {  // We are requesting an object from the remote end
-         utalk->sendObjectRequest(transInfo->obj, transInfo->allInstances);
+         utalk->sendObjectRequest(transInfo.obj, transInfo.allInstances);
     }
     else
     {   // We are sending an object to the remote end
-        utalk->sendObject(transInfo->obj, transInfo->acked, transInfo->allInstances);
+        utalk->sendObject(transInfo.obj, transInfo.acked, transInfo.allInstances);
     }
     // Start timer if a response is expected
-    if ( transInfo->objRequest || transInfo->acked )
+    if ( transInfo.objRequest || transInfo.acked )
     {
-        transInfo->timer->start(REQ_TIMEOUT_MS);
+        scheduleTimeout(transaction);
     }
     else
     {
         // Stop tracking this transaction, since we're not expecting a response:
-        transMap.remove(TransactionKey(transInfo->obj, transInfo->objRequest));
-        delete transInfo;
+        updateTransactionMap(transInfo.obj, transInfo.objRequest, false);
     }
 }
 
@@ -419,6 +501,7 @@ void Telemetry::processObjectUpdates(UAVObject* obj, EventMask event, bool allIn
     objInfo.obj = obj;
     objInfo.event = event;
     objInfo.allInstances = allInstances;
+    ++queueDepthHistogram[histogramBin(objPriorityQueue.length() + objQueue.length())];
     if (priority)
     {
         if ( objPriorityQueue.length() < MAX_QUEUE_SIZE )
@@ -451,29 +534,75 @@ void Telemetry::processObjectUpdates(UAVObject* obj, EventMask event, bool allIn
 }
 
 /**
- * Process events from the object queue.
+ * Process events from the object queue, until it is empty or the remaining
+ * events wait for a free transaction.
  */
 void Telemetry::processObjectQueue()
 {
+    // Completions emitted while processing an event call back in here,
+    // the loop below picks up what they queued
+    if (processingQueue)
+        return;
+    processingQueue = true;
+
     if (objQueue.length() > 1)
     {
         TELEMETRY_QXTLOG_DEBUG("[telemetry.cpp] **************** Object Queue above 1 in backlog ****************");
     }
-    // Get object information from queue (first the priority and then the regular queue)
     ObjectQueueInfo objInfo;
-    if ( !objPriorityQueue.isEmpty() )
-    {
-        objInfo = objPriorityQueue.dequeue();
-    }
-    else if ( !objQueue.isEmpty() )
+    while (takeNextEvent(&objInfo))
     {
-        objInfo = objQueue.dequeue();
+        processObjectEvent(objInfo);
     }
-    else
+
+    processingQueue = false;
+}
+
+/**
+ * Get the next event from the queues (first the priority and then the regular queue).
+ * When maxConcurrentTransactions are pending, the events that would start another
+ * transaction are left in the queues and the others are taken.
+ */
+bool Telemetry::takeNextEvent(ObjectQueueInfo *objInfo)
+{
+    bool full = transMap.size() >= maxConcurrentTransactions;
+    QQueue<ObjectQueueInfo> *queues[] = { &objPriorityQueue, &objQueue };
+    for (int q = 0; q < 2; ++q)
     {
-        return;
+        QQueue<ObjectQueueInfo> &queue = *queues[q];
+        for (int i = 0; i < queue.length(); ++i)
+        {
+            if (full && needsTransaction(queue.at(i)))
+                continue;
+            *objInfo = queue.takeAt(i);
+            return true;
+        }
     }
+    return false;
+}
 
+/**
+ * Returns true if an event starts a transaction that waits for an answer
+ */
+bool Telemetry::needsTransaction(const ObjectQueueInfo &objInfo)
+{
+    if ( objInfo.event == EV_UNPACKED )
+        return false;
+    UAVObject::Metadata metadata = objInfo.obj->getMetadata();
+    if ( objInfo.event == EV_UPDATED_PERIODIC && UAVObject::GetGcsTelemetryUpdateMode(metadata) == UAVObject::UPDATEMODE_THROTTLED )
+        return false;
+    bool request = ( objInfo.event == EV_UPDATE_REQ );
+    if ( !request && !UAVObject::GetGcsTelemetryAcked(metadata) )
+        return false;
+    // A transaction that is already pending is not started again
+    return !transMap.contains(TransactionKey(objInfo.obj, request));
+}
+
+/**
+ * Process an event taken from the object queue.
+ */
+void Telemetry::processObjectEvent(const ObjectQueueInfo &objInfo)
+{
     // Check if a connection has been established, only process GCSTelemetryStats updates
     // (used to establish the connection)
     GCSTelemetryStats::DataFields gcsStats = gcsStatsObj->getData();
@@ -506,24 +635,16 @@ void Telemetry::processObjectQueue()
         } else
         {
             UAVObject::Metadata metadata = objInfo.obj->getMetadata();
-            ObjectTransactionInfo *transInfo = new ObjectTransactionInfo(this);
-            transInfo->obj = objInfo.obj;
-            transInfo->allInstances = objInfo.allInstances;
-            transInfo->retriesRemaining = MAX_RETRIES;
-            transInfo->acked = UAVObject::GetGcsTelemetryAcked(metadata);
-            if ( objInfo.event == EV_UPDATED || objInfo.event == EV_UPDATED_MANUAL || objInfo.event == EV_UPDATED_PERIODIC )
-            {
-                transInfo->objRequest = false;
-            }
-            else if ( objInfo.event == EV_UPDATE_REQ )
-            {
-                transInfo->objRequest = true;
-            }
-            transInfo->telem = this;
+            int transaction = allocateTransaction();
+            ObjectTransactionInfo &transInfo = transPool[transaction];
+            transInfo.obj = objInfo.obj;
+            transInfo.allInstances = objInfo.allInstances;
+            transInfo.retriesRemaining = MAX_RETRIES;
+            transInfo.acked = UAVObject::GetGcsTelemetryAcked(metadata);
+            transInfo.objRequest = ( objInfo.event == EV_UPDATE_REQ );
             // Insert the transaction into the transaction map.
-            TransactionKey key(objInfo.obj, transInfo->objRequest);
-            transMap.insert(key, transInfo);
-            processObjectTransaction(transInfo);
+            transMap.insert(TransactionKey(objInfo.obj, transInfo.objRequest), transaction);
+            processObjectTransaction(transaction);
         }
     }
 
@@ -546,13 +667,24 @@ void Telemetry::processObjectQueue()
         if (transMap.contains(TransactionKey(objInfo.obj, true))) {
             TELEMETRY_QXTLOG_DEBUG(QString("[telemetry.cpp] EV_UNPACKED %0 Instance:%1").arg(objInfo.obj->getName() + QString(QString("0x") + QString::number(objInfo.obj->getObjID(), 16).toUpper())).arg(objInfo.obj->getInstID()));
             transactionRequestCompleted(objInfo.obj);
-        } else
-        {
-            processObjectQueue();
         }
     }
 }
 
+/**
+ * Returns the histogram bin of a value, the bins are powers of two: 0, 1, 2-3, 4-7, ...
+ */
+int Telemetry::histogramBin(quint32 value)
+{
+    int bin = 0;
+    while (value > 0 && bin < HISTOGRAM_BINS - 1)
+    {
+        value >>= 1;
+        ++bin;
+    }
+    return bin;
+}
+
 
 /**
  * @brief Telemetry::processPeriodicUpdates Check if any objects are pending for periodic updates
@@ -632,6 +764,8 @@ Telemetry::TelemetryStats Telemetry::getStats()
     stats.txErrors = utalkStats.txErrors + txErrors;
     stats.rxErrors = utalkStats.rxErrors;
     stats.txRetries = txRetries;
+    memcpy(stats.queueDepthHistogram, queueDepthHistogram, sizeof(queueDepthHistogram));
+    memcpy(stats.latencyHistogram, latencyHistogram, sizeof(latencyHistogram));
 
     // Done
     return stats;
@@ -643,6 +777,8 @@ void Telemetry::resetStats()
     utalk->resetStats();
     txErrors = 0;
     txRetries = 0;
+    memset(queueDepthHistogram, 0, sizeof(queueDepthHistogram));
+    memset(latencyHistogram, 0, sizeof(latencyHistogram));
 }
 
 void Telemetry::objectUpdatedAuto(UAVObject* obj)
@@ -692,30 +828,3 @@ void Telemetry::newInstance(UAVObject* obj)
     QMutexLocker locker(mutex);
     registerObject(obj);
 }
-
-ObjectTransactionInfo::ObjectTransactionInfo(QObject* parent):QObject(parent)
-{
-    obj = 0;
-    allInstances = false;
-    objRequest = false;
-    retriesRemaining = 0;
-    acked = false;
-    telem = 0;
-    // Setup transaction timer
-    timer = new QTimer(this);
-    timer->stop();
-    connect(timer, SIGNAL(timeout()), this, SLOT(timeout()));
-}
-
-ObjectTransactionInfo::~ObjectTransactionInfo()
-{
-    telem = 0;
-    timer->stop();
-    delete timer;
-}
-
-void ObjectTransactionInfo::timeout()
-{
-    if (!telem.isNull())
-        telem->transactionTimeout(this);
-}
@@ -37,32 +37,19 @@
 #include <QMutexLocker>
 #include <QTimer>
 #include <QQueue>
-#include <QMap>
+#include <QHash>
+#include <QVector>
+#include <QElapsedTimer>
 
 class TransactionKey;
 
-class ObjectTransactionInfo: public QObject {
-    Q_OBJECT
-
-public:
-    ObjectTransactionInfo(QObject * parent);
-    ~ObjectTransactionInfo();
-    UAVObject* obj;
-    bool allInstances;
-    bool objRequest;
-    qint32 retriesRemaining;
-    bool acked;
-    QPointer<class Telemetry>telem;
-    QTimer* timer;
-private slots:
-    void timeout();
-};
-
 class Telemetry: public QObject
 {
     Q_OBJECT
 
 public:
+    static const int HISTOGRAM_BINS = 8;
+
     typedef struct {
         quint32 txBytes;
         quint32 rxBytes;
@@ -73,13 +60,16 @@ public:
         quint32 txErrors;
         quint32 rxErrors;
         quint32 txRetries;
+        quint32 queueDepthHistogram[HISTOGRAM_BINS];    /** Events already queued when an event is queued: 0, 1, 2-3, 4-7, ... 64 or more */
+        quint32 latencyHistogram[HISTOGRAM_BINS];       /** Time until a transaction is answered: under 8 ms, 8-15 ms, ... 512 ms or more */
     } TelemetryStats;
 
     Telemetry(UAVTalk* utalk, UAVObjectManager* objMngr);
     ~Telemetry();
     TelemetryStats getStats();
     void resetStats();
-    void transactionTimeout(ObjectTransactionInfo *info);
+    void setMaxConcurrentTransactions(int max);
+    int getMaxConcurrentTransactions() { return maxConcurrentTransactions; }
 
 signals:
 
@@ -90,6 +80,9 @@ private:
     static const int MAX_UPDATE_PERIOD_MS = 1000;
     static const int MIN_UPDATE_PERIOD_MS = 1;
     static const int MAX_QUEUE_SIZE = 20;
+    static const int DEFAULT_MAX_CONCURRENT_TRANSACTIONS = 4;
+    static const int TIMEOUT_WHEEL_TICK_MS = 25;
+    static const int TIMEOUT_WHEEL_SLOTS = 16;      /** Must cover REQ_TIMEOUT_MS */
 
     // Types
     /**
@@ -116,6 +109,26 @@ private:
         bool allInstances;
     } ObjectQueueInfo;
 
+    /**
+     * A transaction waiting for an ack or for the requested object. They are
+     * kept in a pool and reused.
+     */
+    typedef struct {
+        UAVObject* obj;
+        bool allInstances;
+        bool objRequest;
+        bool acked;
+        bool inUse;
+        qint32 retriesRemaining;
+        quint32 generation;         /** Changed each time the timeout is scheduled, older wheel entries are stale */
+        qint64 startMs;             /** Time of the first attempt */
+    } ObjectTransactionInfo;
+
+    typedef struct {
+        int transaction;            /** Index in transPool */
+        quint32 generation;
+    } TimeoutInfo;
+
     // Variables
     UAVObjectManager* objMngr;
     UAVTalk* utalk;
@@ -123,13 +136,23 @@ private:
     QVector<ObjectTimeInfo> objList;
     QQueue<ObjectQueueInfo> objQueue;
     QQueue<ObjectQueueInfo> objPriorityQueue;
-    QMap<TransactionKey, ObjectTransactionInfo*>transMap;
+    QVector<ObjectTransactionInfo> transPool;
+    QVector<int> freeTransactions;
+    QHash<TransactionKey, int> transMap;            /** Index in transPool of each pending transaction */
+    QVector< QVector<TimeoutInfo> > timeoutWheel;
+    int timeoutWheelSlot;
+    QTimer* timeoutTimer;
+    int maxConcurrentTransactions;
+    bool processingQueue;
+    QElapsedTimer clock;
     QMutex* mutex;
     QTimer* updateTimer;
     QTimer* statsTimer;
     qint32 timeToNextUpdateMs;
     quint32 txErrors;
     quint32 txRetries;
+    quint32 queueDepthHistogram[HISTOGRAM_BINS];
+    quint32 latencyHistogram[HISTOGRAM_BINS];
 
     // Methods
     void registerObject(UAVObject* obj);
@@ -138,9 +161,16 @@ private:
     void connectToObjectInstances(UAVObject* obj, quint32 eventMask);
     void updateObject(UAVObject* obj, quint32 eventMask);
     void processObjectUpdates(UAVObject* obj, EventMask event, bool allInstances, bool priority);
-    void processObjectTransaction(ObjectTransactionInfo *transInfo);
+    void processObjectTransaction(int transaction);
     void processObjectQueue();
-    bool updateTransactionMap(UAVObject* obj, bool request);
+    void processObjectEvent(const ObjectQueueInfo &objInfo);
+    bool takeNextEvent(ObjectQueueInfo *objInfo);
+    bool needsTransaction(const ObjectQueueInfo &objInfo);
+    int allocateTransaction();
+    void scheduleTimeout(int transaction);
+    void transactionTimeout(int transaction);
+    bool updateTransactionMap(UAVObject* obj, bool request, bool answered);
+    static int histogramBin(quint32 value);
 
 
 private slots:
@@ -153,6 +183,7 @@ private slots:
     void newObject(UAVObject* obj);
     void newInstance(UAVObject* obj);
     void processPeriodicUpdates();
+    void processTimeouts();
     void transactionSuccess(UAVObject* obj);
     void transactionFailure(UAVObject* obj);
     void transactionRequestCompleted(UAVObject* obj);
@@ -103,9 +103,9 @@ void TelemetryManager::onGeneralSettingsChanged()
 {
     if (!settings->useSessionManaging())
     {
-        foreach(UAVObjectManager::ObjectMap map, objMngr->getObjects())
+        foreach(QVector<UAVObject*> instances, objMngr->getObjectsVector())
         {
-            foreach(UAVObject* obj, map.values())
+            foreach(UAVObject* obj, instances)
             {
                 UAVDataObject* dobj = dynamic_cast<UAVDataObject*>(obj);
                 if(dobj)
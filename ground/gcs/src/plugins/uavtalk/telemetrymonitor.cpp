@@ -44,6 +44,11 @@
 #define OBJECT_RETRIEVE_TIMEOUT             5000
 //IAP object is very important, retry if not able to get it the first time
 #define IAP_OBJECT_RETRIES                  3
+//Timeout for receiving the whole session manifest, the system goes to the per object session negotiation after it
+#define SESSION_MANIFEST_TIMEOUT            5000
+//Values of the object of interest index with a special meaning for the hardware
+#define SESSION_RESUME_UPDATES              0xFF
+#define SESSION_SEND_MANIFEST               0xFD
 
 #ifdef TELEMETRYMONITOR_DEBUG
   #define TELEMETRYMONITOR_QXTLOG_DEBUG(...) qDebug()<<__VA_ARGS__
@@ -51,6 +56,20 @@
   #define TELEMETRYMONITOR_QXTLOG_DEBUG(...)
 #endif	// TELEMETRYMONITOR_DEBUG
 
+/**
+ * CRC32 as computed by the hardware (PIOS_CRC32_updateCRC), used for the object hashes
+ */
+static quint32 updateCRC32(quint32 crc, const quint8 *data, int length)
+{
+    for (int i = 0; i < length; ++i)
+    {
+        crc ^= (quint32)data[i] << 24;
+        for (int bit = 0; bit < 8; ++bit)
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : (crc << 1);
+    }
+    return crc;
+}
+
 /**
  * Constructor
  */
@@ -61,7 +80,8 @@ TelemetryMonitor::TelemetryMonitor(UAVObjectManager* objMngr, Telemetry* tel, QH
     numberOfObjects(0),
     retries(0),
     isManaged(true),
-    sessions(sessions)
+    sessions(sessions),
+    manifestSize(0)
 {
     sessionID = QDateTime::currentDateTime().toTime_t();
     this->connectionTimer = new QTime();
@@ -85,10 +105,13 @@ TelemetryMonitor::TelemetryMonitor(UAVObjectManager* objMngr, Telemetry* tel, QH
     objectRetrieveTimeout->setSingleShot(true);
     sessionInitialRetrieveTimeout = new QTimer(this);
     sessionInitialRetrieveTimeout->setSingleShot(true);
+    sessionManifestTimeout = new QTimer(this);
+    sessionManifestTimeout->setSingleShot(true);
     connect(statsTimer, SIGNAL(timeout()), this, SLOT(processStatsUpdates()));
     connect(sessionRetrieveTimeout,SIGNAL(timeout()),this,SLOT(sessionRetrieveTimeoutCB()));
     connect(sessionInitialRetrieveTimeout,SIGNAL(timeout()),this,SLOT(sessionInitialRetrieveTimeoutCB()));
     connect(objectRetrieveTimeout,SIGNAL(timeout()),this,SLOT(objectRetrieveTimeoutCB()));
+    connect(sessionManifestTimeout,SIGNAL(timeout()),this,SLOT(sessionManifestTimeoutCB()));
     statsTimer->start(STATS_CONNECT_PERIOD_MS);
 
     Core::ConnectionManager *cm = Core::ICore::instance()->connectionManager();
@@ -108,9 +131,9 @@ TelemetryMonitor::~TelemetryMonitor() {
     gcsStats.Status = GCSTelemetryStats::STATUS_DISCONNECTED;
     if (settings->useSessionManaging())
     {
-        foreach(UAVObjectManager::ObjectMap map, objMngr->getObjects())
+        foreach(QVector<UAVObject*> instances, objMngr->getObjectsVector())
         {
-            foreach(UAVObject* obj, map.values())
+            foreach(UAVObject* obj, instances)
             {
                 UAVDataObject* dobj = dynamic_cast<UAVDataObject*>(obj);
                 if(dobj)
@@ -130,12 +153,14 @@ void TelemetryMonitor::startRetrievingObjects()
     TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 connectionStatus changed to CON_RETRIEVING_OBJECT").arg(Q_FUNC_INFO));
     connectionStatus = CON_RETRIEVING_OBJECTS;
     // Get all objects, add metaobjects, settings and data objects with OnChange update mode to the queue
-    queue.empty();
+    stopRetrievingObjects();
     retries = 0;
     objectRetrieveTimeout->start(OBJECT_RETRIEVE_TIMEOUT);
-    foreach(UAVObjectManager::ObjectMap map, objMngr->getObjects().values())
+    foreach(QVector<UAVObject*> instances, objMngr->getObjectsVector())
     {
-        UAVObject* obj = map.first();
+        if(instances.isEmpty())
+            continue;
+        UAVObject* obj = instances.first();
         if(obj->getObjID() == SessionManaging::OBJID)
         {
             continue;
@@ -149,6 +174,11 @@ void TelemetryMonitor::startRetrievingObjects()
                 TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 %1 not present on hardware, skipping").arg(Q_FUNC_INFO).arg(obj->getName()));
                 continue;
             }
+            if(manifestHashes.contains(obj->getObjID()) && manifestHashes.value(obj->getObjID()) == objectHash(dobj))
+            {
+                TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 %1 unchanged on hardware, skipping").arg(Q_FUNC_INFO).arg(obj->getName()));
+                continue;
+            }
             queue.enqueue(dobj->getMetaObject());
             if ( dobj->isSettings() )
             {
@@ -195,8 +225,8 @@ void TelemetryMonitor::changeObjectInstances(quint32 objID, quint32 instID, bool
         if(currentInstances != instID)
         {
             TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 Object %1 has %2 instances on hw and %3 on the GCS")
-                                          .arg(Q_FUNC_INFO).arg(dobj->getName()).arg(sessionObj->getObjectInstances()).arg(currentInstances));
-            if(currentInstances < sessionObj->getObjectInstances())
+                                          .arg(Q_FUNC_INFO).arg(dobj->getName()).arg(instID).arg(currentInstances));
+            if(currentInstances < instID)
             {
                 TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 cloned and registered object %1 INSTID=%2")
                                               .arg(Q_FUNC_INFO).arg(dobj->getName()).arg(instID - 1));
@@ -230,12 +260,28 @@ void TelemetryMonitor::changeObjectInstances(quint32 objID, quint32 instID, bool
 }
 
 /**
- * Retrieve the next object in the queue
+ * Retrieve the next objects in the queue. Several requests are kept in flight,
+ * as many as telemetry handles at the same time, so that the round trip of a
+ * radio link isn't paid for each object.
  */
 void TelemetryMonitor::retrieveNextObject()
 {
-    // If queue is empty return
-    if ( queue.isEmpty() )
+    while ( !queue.isEmpty() && retrieving.size() < tel->getMaxConcurrentTransactions() )
+    {
+        UAVObject* obj = queue.dequeue();
+        if ( retrieving.contains(obj) )
+            continue;
+        retrieving.insert(obj);
+        // Connect to object
+        TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 requestiong %1 from board INSTID:%2").arg(Q_FUNC_INFO).arg(obj->getName()).arg(obj->getInstID()));
+        connect(obj, SIGNAL(transactionCompleted(UAVObject*,bool)), this, SLOT(transactionCompleted(UAVObject*,bool)));
+        // Request update
+        obj->requestUpdateAllInstances();
+    }
+
+    // If all objects were retrieved, the connection is established. A completion
+    // handled by a nested call may have got here first.
+    if ( queue.isEmpty() && retrieving.isEmpty() && connectionStatus == CON_RETRIEVING_OBJECTS )
     {
         TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 Object retrieval completed").arg(Q_FUNC_INFO));
         if(isManaged)
@@ -249,7 +295,7 @@ void TelemetryMonitor::retrieveNextObject()
             connectionStatus = CON_CONNECTED_UNMANAGED;
         }
         //restart periodic updates on the FC
-        sessionObj->setObjectOfInterestIndex(0xFF);
+        sessionObj->setObjectOfInterestIndex(SESSION_RESUME_UPDATES);
         sessionObj->updated();
         foreach (UAVDataObject * uavo, delayedUpdate) {
             uavo->setIsPresentOnHardware(true);
@@ -259,15 +305,19 @@ void TelemetryMonitor::retrieveNextObject()
         sessionRetrieveTimeout->stop();
         sessionInitialRetrieveTimeout->stop();
         objectRetrieveTimeout->stop();
-        return;
     }
-    // Get next object from the queue
-    UAVObject* obj = queue.dequeue();
-    // Connect to object
-    TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 requestiong %1 from board INSTID:%2").arg(Q_FUNC_INFO).arg(obj->getName()).arg(obj->getInstID()));
-    connect(obj, SIGNAL(transactionCompleted(UAVObject*,bool)), this, SLOT(transactionCompleted(UAVObject*,bool)));
-    // Request update
-    obj->requestUpdateAllInstances();
+}
+
+/**
+ * Drop the objects waiting to be retrieved and stop listening to the ones
+ * requested, so that late completions are not taken for a new retrieval.
+ */
+void TelemetryMonitor::stopRetrievingObjects()
+{
+    queue.clear();
+    foreach (UAVObject* obj, retrieving)
+        obj->disconnect(this, SLOT(transactionCompleted(UAVObject*,bool)));
+    retrieving.clear();
 }
 
 /**
@@ -288,6 +338,8 @@ void TelemetryMonitor::transactionCompleted(UAVObject* obj, bool success)
     }
     // Disconnect from sending object
     obj->disconnect(this);
+    if ( !retrieving.remove(obj) )
+        return;
     // Process next object if telemetry is still available
     GCSTelemetryStats::DataFields gcsStats = gcsStatsObj->getData();
     if ( gcsStats.Status == GCSTelemetryStats::STATUS_CONNECTED )
@@ -298,7 +350,7 @@ void TelemetryMonitor::transactionCompleted(UAVObject* obj, bool success)
     else
     {
         TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 connection lost while retrieving objects, stopped object retrievel").arg(Q_FUNC_INFO));
-        queue.empty();
+        stopRetrievingObjects();
         objectRetrieveTimeout->stop();
         sessionRetrieveTimeout->stop();
         sessionInitialRetrieveTimeout->stop();
@@ -331,10 +383,11 @@ void TelemetryMonitor::checkSessionObjNacked(UAVObject *obj, bool success, bool
     disconnect(sessionObj,SIGNAL(transactionCompleted(UAVObject*,bool,bool)),this, SLOT(checkSessionObjNacked(UAVObject*, bool, bool)));
     if(!nacked)
         return;
-    if(connectionStatus == CON_INITIALIZING)
+    if((connectionStatus == CON_INITIALIZING) || (connectionStatus == CON_SESSION_MANIFEST))
     {
         TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 received a sessionmanagement object nack, going to fallback").arg(Q_FUNC_INFO));
         sessionInitialRetrieveTimeout->stop();
+        sessionManifestTimeout->stop();
         sessionFallback();
     }
     else
@@ -349,35 +402,11 @@ void TelemetryMonitor::sessionObjUnpackedCB(UAVObject *obj)
     switch(connectionStatus)
     {
     case CON_INITIALIZING:
-        if(sessions.contains(sessionObj->getSessionID()) && (sessions.value(sessionObj->getSessionID()).count() == sessionObj->getNumberOfObjects()))
-        {
-            sessionObj->setObjectOfInterestIndex(0xFE);
-            sessionObj->updated();
-            sessionID = sessionObj->getSessionID();
-            numberOfObjects = sessionObj->getNumberOfObjects();
-            TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 status:%1 session already known startRetrievingObjects").arg(Q_FUNC_INFO).arg(connectionStatus));
-            foreach(objStruc objs, sessions.value(sessionObj->getSessionID()))
-            {
-                UAVDataObject * dobj = dynamic_cast<UAVDataObject*>(objMngr->getObject(objs.objID));
-                if(dobj)
-                {
-                    if(dobj->isSingleInstance())
-                    {
-                        dobj->setIsPresentOnHardware(true);
-                    }
-                    else
-                    {
-                        changeObjectInstances(objs.objID,objs.instID, true);
-                    }
-                }
-            }
-            startRetrievingObjects();
-        }
-        else
-        {
-            TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 new session startSessionRetrieving HWsessionID=%1 GCSsessionID=%2 HWnumberofobjs=%3 GCSnumberofobjs=%4").arg(Q_FUNC_INFO).arg(sessionObj->getSessionID()).arg(sessionID).arg(sessionObj->getNumberOfObjects()).arg(sessions.value(sessionObj->getSessionID()).count()));
-            startSessionRetrieving(NULL);
-        }
+        TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 startManifestRetrieving HWsessionID=%1 GCSsessionID=%2 HWnumberofobjs=%3 GCSnumberofobjs=%4").arg(Q_FUNC_INFO).arg(sessionObj->getSessionID()).arg(sessionID).arg(sessionObj->getNumberOfObjects()).arg(sessions.value(sessionObj->getSessionID()).count()));
+        startManifestRetrieving();
+        break;
+    case CON_SESSION_MANIFEST:
+        manifestEntryReceived();
         break;
     case CON_CONNECTED_MANAGED:
         qDebug()<<QString("HW=%0 GCS=%1 GCS_ADJ=%2").arg(sessionObj->getSessionID()).arg(sessionID).arg(sessionID + 1);
@@ -411,7 +440,7 @@ void TelemetryMonitor::sessionObjUnpackedCB(UAVObject *obj)
 
 void TelemetryMonitor::objectRetrieveTimeoutCB()
 {
-    queue.empty();
+    stopRetrievingObjects();
 }
 
 void TelemetryMonitor::sessionInitialRetrieveTimeoutCB()
@@ -428,6 +457,16 @@ void TelemetryMonitor::sessionInitialRetrieveTimeoutCB()
     }
 }
 
+void TelemetryMonitor::sessionManifestTimeoutCB()
+{
+    if(connectionStatus == CON_SESSION_MANIFEST)
+    {
+        TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 session manifest incomplete (%1 of %2 entries), going to the per object negotiation")
+                                      .arg(Q_FUNC_INFO).arg(manifestIndexes.size()).arg(manifestSize));
+        startSessionRetrieving(NULL);
+    }
+}
+
 void TelemetryMonitor::sessionRetrieveTimeoutCB()
 {
     if(connectionStatus == CON_SESSION_INITIALIZING)
@@ -442,9 +481,9 @@ void TelemetryMonitor::saveSession()
     if(isManaged)
     {
         QList<objStruc> list;
-        foreach(UAVObjectManager::ObjectMap map, objMngr->getObjects().values())
+        foreach(QVector<UAVObject*> instances, objMngr->getObjectsVector())
         {
-            foreach (UAVObject* obj, map) {
+            foreach (UAVObject* obj, instances) {
                 UAVDataObject* dobj = dynamic_cast<UAVDataObject*>(obj);
                 if(dobj)
                 {
@@ -480,9 +519,9 @@ void TelemetryMonitor::startSessionRetrieving(UAVObject *session)
     {
         sessionRetrieveTimeout->start(SESSION_RETRIEVE_TIMEOUT);
         TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 NULL new session start").arg(Q_FUNC_INFO));
-        foreach(UAVObjectManager::ObjectMap map, objMngr->getObjects())
+        foreach(QVector<UAVObject*> instances, objMngr->getObjectsVector())
         {
-            foreach(UAVObject* obj, map.values())
+            foreach(UAVObject* obj, instances)
             {
                 UAVDataObject* dobj = dynamic_cast<UAVDataObject*>(obj);
                 if(dobj)
@@ -492,6 +531,7 @@ void TelemetryMonitor::startSessionRetrieving(UAVObject *session)
         currentIndex = 0;
         objectCount = 0;
         sessionObjRetries = 0;
+        manifestHashes.clear();
         connectionStatus = CON_SESSION_INITIALIZING;
         sessionObj->setSessionID(0);
         sessionObj->updated();
@@ -563,10 +603,11 @@ void TelemetryMonitor::startSessionRetrieving(UAVObject *session)
 void TelemetryMonitor::sessionFallback()
 {
     isManaged = false;
+    manifestHashes.clear();
     TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 SESSION FALLBACK").arg(Q_FUNC_INFO));
-    foreach(UAVObjectManager::ObjectMap map, objMngr->getObjects().values())
+    foreach(QVector<UAVObject*> instances, objMngr->getObjectsVector())
     {
-        foreach (UAVObject* obj, map) {
+        foreach (UAVObject* obj, instances) {
             UAVDataObject* dobj = dynamic_cast<UAVDataObject*>(obj);
             if(dobj)
                 dobj->setIsPresentOnHardware(true);
@@ -575,6 +616,107 @@ void TelemetryMonitor::sessionFallback()
     startRetrievingObjects();
 }
 
+/**
+ * Ask the hardware for the session manifest. It streams one session object entry
+ * per object in a single burst, with the number of instances and the hash of the
+ * object, so that only the objects which changed are retrieved afterwards.
+ */
+void TelemetryMonitor::startManifestRetrieving()
+{
+    TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 connectionStatus changed to CON_SESSION_MANIFEST").arg(Q_FUNC_INFO));
+    connectionStatus = CON_SESSION_MANIFEST;
+    sessionInitialRetrieveTimeout->stop();
+    // Keep the ID of a known session, its objects list is refreshed from the manifest
+    if(!sessions.contains(sessionObj->getSessionID()))
+        sessionID = QDateTime::currentDateTime().toTime_t();
+    else
+        sessionID = sessionObj->getSessionID();
+    manifestSize = 0;
+    manifestIndexes.clear();
+    manifestObjects.clear();
+    manifestHashes.clear();
+    connect(sessionObj,SIGNAL(transactionCompleted(UAVObject*,bool,bool)),this, SLOT(checkSessionObjNacked(UAVObject*, bool, bool)),Qt::UniqueConnection);
+    sessionObj->setSessionID(sessionID);
+    sessionObj->setObjectOfInterestIndex(SESSION_SEND_MANIFEST);
+    sessionObj->updated();
+    sessionManifestTimeout->start(SESSION_MANIFEST_TIMEOUT);
+}
+
+/**
+ * Store a manifest entry, the manifest is applied once all the entries are received.
+ */
+void TelemetryMonitor::manifestEntryReceived()
+{
+    quint8 index = sessionObj->getObjectOfInterestIndex();
+    if((sessionObj->getSessionID() != sessionID) || (index >= sessionObj->getNumberOfObjects()))
+        return;
+    manifestSize = sessionObj->getNumberOfObjects();
+    if(!manifestIndexes.contains(index))
+    {
+        TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 RECEIVED MANIFEST INDEX:%1 OBJID:%2 instances:%3 hash:%4").arg(Q_FUNC_INFO).arg(index)
+                                      .arg(sessionObj->getObjectID()).arg(sessionObj->getObjectInstances()).arg(sessionObj->getObjectHash()));
+        manifestIndexes.insert(index);
+        objStruc objs;
+        objs.objID = sessionObj->getObjectID();
+        objs.instID = sessionObj->getObjectInstances();
+        manifestObjects.append(objs);
+        manifestHashes.insert(objs.objID, sessionObj->getObjectHash());
+    }
+    if(manifestIndexes.size() == manifestSize)
+        applyManifest();
+}
+
+/**
+ * Mark the objects of the manifest as present on the hardware, save the session
+ * and retrieve the objects whose hash differs from the local copy.
+ */
+void TelemetryMonitor::applyManifest()
+{
+    TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 manifest complete with %1 objects").arg(Q_FUNC_INFO).arg(manifestSize));
+    sessionManifestTimeout->stop();
+    numberOfObjects = manifestSize;
+    foreach(QVector<UAVObject*> instances, objMngr->getObjectsVector())
+    {
+        foreach(UAVObject* obj, instances)
+        {
+            UAVDataObject* dobj = dynamic_cast<UAVDataObject*>(obj);
+            if(dobj)
+                dobj->setIsPresentOnHardware(false);
+        }
+    }
+    foreach(objStruc objs, manifestObjects)
+    {
+        UAVDataObject * dobj = dynamic_cast<UAVDataObject*>(objMngr->getObject(objs.objID));
+        if(dobj)
+        {
+            dobj->setIsPresentOnHardware(true);
+            if(!dobj->isSingleInstance())
+                changeObjectInstances(objs.objID, objs.instID, true);
+        }
+    }
+    saveSession();
+    startRetrievingObjects();
+}
+
+/**
+ * Hash of the metadata and the data of all the instances of an object, the same
+ * way as the hardware computes it for the manifest.
+ */
+quint32 TelemetryMonitor::objectHash(UAVDataObject *dobj)
+{
+    UAVMetaObject* mobj = dobj->getMetaObject();
+    QByteArray data(mobj->getNumBytes(), 0);
+    mobj->pack((quint8*)data.data());
+    quint32 hash = updateCRC32(0, (const quint8*)data.constData(), data.size());
+    foreach(UAVObject* obj, objMngr->getObjectInstancesVector(dobj->getObjID()))
+    {
+        data.resize(obj->getNumBytes());
+        obj->pack((quint8*)data.data());
+        hash = updateCRC32(hash, (const quint8*)data.constData(), data.size());
+    }
+    return hash;
+}
+
 /**
  * Called periodically to update the statistics and connection status.
  */
@@ -588,6 +730,16 @@ void TelemetryMonitor::processStatsUpdates()
     Telemetry::TelemetryStats telStats = tel->getStats();
     tel->resetStats();
 
+#ifdef TELEMETRYMONITOR_DEBUG
+    QStringList queueDepths, latencies;
+    for (int i = 0; i < Telemetry::HISTOGRAM_BINS; ++i)
+    {
+        queueDepths << QString::number(telStats.queueDepthHistogram[i]);
+        latencies << QString::number(telStats.latencyHistogram[i]);
+    }
+    TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 queue depth histogram: %1 latency histogram: %2").arg(Q_FUNC_INFO).arg(queueDepths.join(" ")).arg(latencies.join(" ")));
+#endif
+
     // Update stats object 
     gcsStats.RxDataRate = (float)telStats.rxBytes / ((float)statsTimer->interval()/1000.0);
     gcsStats.TxDataRate = (float)telStats.txBytes / ((float)statsTimer->interval()/1000.0);
@@ -674,9 +826,9 @@ void TelemetryMonitor::processStatsUpdates()
         Core::Internal::GeneralSettings * settings=pm->getObject<Core::Internal::GeneralSettings>();
         if (settings->useSessionManaging())
         {
-            foreach(UAVObjectManager::ObjectMap map, objMngr->getObjects())
+            foreach(QVector<UAVObject*> instances, objMngr->getObjectsVector())
             {
-                foreach(UAVObject* obj, map.values())
+                foreach(UAVObject* obj, instances)
                 {
                     UAVDataObject* dobj = dynamic_cast<UAVDataObject*>(obj);
                     if(dobj)
@@ -35,6 +35,7 @@
 #include <QTime>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QSet>
 #include "uavobjectmanager.h"
 #include "gcstelemetrystats.h"
 #include "flighttelemetrystats.h"
@@ -73,11 +74,12 @@ private slots:
     void objectRetrieveTimeoutCB();
     void sessionRetrieveTimeoutCB();
     void sessionInitialRetrieveTimeoutCB();
+    void sessionManifestTimeoutCB();
     void saveSession();
     void newInstanceSlot(UAVObject*);
 private:
     QList<UAVDataObject *> delayedUpdate;
-    enum connectionStatusEnum {CON_DISCONNECTED, CON_INITIALIZING, CON_SESSION_INITIALIZING, CON_RETRIEVING_OBJECTS, CON_CONNECTED_UNMANAGED,CON_CONNECTED_MANAGED};
+    enum connectionStatusEnum {CON_DISCONNECTED, CON_INITIALIZING, CON_SESSION_INITIALIZING, CON_SESSION_MANIFEST, CON_RETRIEVING_OBJECTS, CON_CONNECTED_UNMANAGED,CON_CONNECTED_MANAGED};
     static const int STATS_UPDATE_PERIOD_MS = 4000;
     static const int STATS_CONNECT_PERIOD_MS = 2000;
     static const int CONNECTION_TIMEOUT_MS = 8000;
@@ -85,6 +87,7 @@ private:
     UAVObjectManager* objMngr;
     Telemetry* tel;
     QQueue<UAVObject*> queue;
+    QSet<UAVObject*> retrieving;    // Requested objects that didn't complete yet
     GCSTelemetryStats* gcsStatsObj;
     FlightTelemetryStats* flightStatsObj;
     QTimer* statsTimer;
@@ -93,18 +96,28 @@ private:
     SessionManaging* sessionObj;
     void startRetrievingObjects();
     void retrieveNextObject();
+    void stopRetrievingObjects();
     quint16 sessionID;
     quint8 numberOfObjects;
     QTimer* objectRetrieveTimeout;
     QTimer* sessionRetrieveTimeout;
     QTimer* sessionInitialRetrieveTimeout;
+    QTimer* sessionManifestTimeout;
     int retries;
     void changeObjectInstances(quint32 objID, quint32 instID, bool delayed);
     void startSessionRetrieving(UAVObject *session);
     void sessionFallback();
+    void startManifestRetrieving();
+    void manifestEntryReceived();
+    void applyManifest();
+    quint32 objectHash(UAVDataObject *dobj);
     bool isManaged;
     QHash<quint16, QList<objStruc> > sessions;
     int sessionObjRetries;
+    quint8 manifestSize;
+    QSet<quint8> manifestIndexes;       // Indexes of the manifest entries received so far
+    QList<objStruc> manifestObjects;
+    QHash<quint32, quint32> manifestHashes; // Hash of each object on the hardware, by object ID
     Core::Internal::GeneralSettings *settings;
 };
 
@@ -28,8 +28,10 @@
 #include "uavtalk.h"
 #include <QtEndian>
 #include <QDebug>
+#ifndef UAVTALK_STANDALONE
 #include <extensionsystem/pluginmanager.h>
 #include <coreplugin/generalsettings.h>
+#endif
 
 //#define UAVTALK_DEBUG
 #ifdef UAVTALK_DEBUG
@@ -77,9 +79,15 @@ UAVTalk::UAVTalk(QIODevice* iodev, UAVObjectManager* objMngr)
     memset(&stats, 0, sizeof(ComStats));
 
     connect(io, SIGNAL(readyRead()), this, SLOT(processInputStream()));
+#ifndef UAVTALK_STANDALONE
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     Core::Internal::GeneralSettings * settings=pm->getObject<Core::Internal::GeneralSettings>();
     useUDPMirror=settings->useUDPMirror();
+#else
+    // Built into a tool without the GCS plugins and their settings
+    useUDPMirror=false;
+#endif
+
     UAVTALK_QXTLOG_DEBUG(QString("[uavtalk.cpp  ] Use UDP:%0").arg(useUDPMirror));
     if(useUDPMirror)
     {
@@ -30,7 +30,8 @@ TEMPLATE  = subdirs
 SUBDIRS = \
         sub_gcs \
         sub_uavobjects \
-        sub_uavobjgenerator
+        sub_uavobjgenerator \
+        sub_logdecoder
 
 # uavobjgenerator
 sub_uavobjgenerator.subdir = uavobjgenerator
@@ -42,3 +43,7 @@ sub_uavobjects.depends = sub_uavobjgenerator
 # src
 sub_gcs.subdir  = gcs
 sub_gcs.depends = sub_uavobjects
+
+# logdecoder
+sub_logdecoder.subdir  = logdecoder
+sub_logdecoder.depends = sub_uavobjects
@@ -0,0 +1,198 @@
+/**
+ ******************************************************************************
+ *
+ * @file       logdecoder.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @brief      Decodes the UAVTalk stream of a GCS log file
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "logdecoder.h"
+#include <QDir>
+#include <QFileInfo>
+#include <limits>
+
+/**
+ * @brief LogDecoder::LogDecoder
+ * @param device Any device, UAVTalk doesn't read it since the log is fed to the parser
+ * @param objMngr The objects of this decoder, with the first instance of each registered
+ * @param options What to decode
+ */
+LogDecoder::LogDecoder(QIODevice *device, UAVObjectManager *objMngr, const DecoderOptions &options) :
+    UAVTalk(device, objMngr),
+    options(options),
+    currentTimestamp(0),
+    updates(0),
+    objectCount(0),
+    writeError(false)
+{
+}
+
+LogDecoder::~LogDecoder()
+{
+    closeWriters();
+}
+
+/**
+ * @brief LogDecoder::decode Decodes a log into a directory named after it
+ * @param logFile The log
+ * @param error Set to the reason if decoding fails
+ * @return true if the log was decoded and all files were written
+ */
+bool LogDecoder::decode(const QString &logFile, QString *error)
+{
+    LogReader reader;
+    if (!reader.open(logFile)) {
+        *error = "Unable to open the log";
+        return false;
+    }
+
+    QFileInfo info(logFile);
+    QDir outputParent(options.outputPath.isEmpty() ? info.absolutePath() : options.outputPath);
+    outputDir = outputParent.filePath(info.completeBaseName());
+    if (!QDir().mkpath(outputDir)) {
+        *error = "Unable to create " + outputDir;
+        return false;
+    }
+
+    int count = reader.getPacketCount();
+    if (count == 0)
+        return true;
+
+    // Find the start of the time range. Logs with corrupted timestamps are scanned.
+    quint32 firstTimestamp = reader.getTimestamp(0);
+    int first = 0;
+    if (reader.isSequential() && options.from > 0) {
+        // Past the last timestamp there is nothing to find, don't let the sum wrap
+        qint64 fromTimestamp = firstTimestamp + (qint64) qMin(options.from * 1000, 4e9);
+        first = reader.findPacket((quint32) qMin(fromTimestamp, (qint64) std::numeric_limits<quint32>::max()));
+    }
+
+    for (int i = first; i < count; i++) {
+        double time = ((qint64) reader.getTimestamp(i) - firstTimestamp) / 1000.0;
+        if (time < options.from)
+            continue;
+        if (options.to >= 0 && time > options.to) {
+            if (reader.isSequential())
+                break;
+            continue;
+        }
+
+        currentTimestamp = reader.getTimestamp(i);
+        QByteArray packet = reader.getPacket(i);
+        const quint8 *bytes = (const quint8 *) packet.constData();
+        for (int j = 0; j < packet.size(); j++)
+            processInputByte(bytes[j]);
+    }
+
+    if (!closeWriters() || writeError) {
+        *error = "Unable to write to " + outputDir;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief LogDecoder::receiveObject Called by the parser for each packet
+ */
+bool LogDecoder::receiveObject(quint8 type, quint32 objId, quint16 instId, quint8 *data, qint32 length)
+{
+    Q_UNUSED(length);
+
+    // Only updates carry object data, requests and acks in the log are skipped
+    if ((type != TYPE_OBJ && type != TYPE_OBJ_ACK) || instId == ALL_INSTANCES)
+        return true;
+    if (skipped.contains(objId))
+        return true;
+
+    // Check the filters before the first update of an object is unpacked
+    if (!writers.contains(objId)) {
+        UAVObject *tobj = objMngr->getObject(objId);
+        if (tobj == NULL)
+            return false;
+        if (!isSelected(tobj->getName())) {
+            skipped.insert(objId);
+            return true;
+        }
+    }
+
+    UAVObject *obj = updateObject(objId, instId, data);
+    if (obj == NULL)
+        return false;
+
+    foreach (ObjectWriter *writer, getWriters(obj))
+        writer->write(currentTimestamp, obj);
+    updates++;
+
+    return true;
+}
+
+bool LogDecoder::isSelected(const QString &objName) const
+{
+    if (options.objects.isEmpty() && options.fields.isEmpty())
+        return true;
+    return options.objects.contains(objName) || options.fields.contains(objName);
+}
+
+/**
+ * @brief LogDecoder::getWriters Returns the writers of an object, opened with its first update
+ */
+const QList<ObjectWriter *> &LogDecoder::getWriters(UAVObject *obj)
+{
+    QHash<quint32, QList<ObjectWriter *> >::iterator it = writers.find(obj->getObjID());
+    if (it != writers.end())
+        return *it;
+
+    QString baseName = QDir(outputDir).filePath(obj->getName());
+    QStringList fields = options.fields.value(obj->getName());
+
+    QList<ObjectWriter *> objWriters;
+    if (options.csv) {
+        ObjectWriter *writer = new CsvObjectWriter(obj, fields);
+        writeError |= !writer->open(baseName + ".csv");
+        objWriters.append(writer);
+    }
+    if (options.columnar) {
+        ObjectWriter *writer = new ColumnarObjectWriter(obj, fields);
+        writeError |= !writer->open(baseName + ".col");
+        objWriters.append(writer);
+    }
+
+    objectCount++;
+    return writers[obj->getObjID()] = objWriters;
+}
+
+/**
+ * @brief LogDecoder::closeWriters Writes what is left and closes the files
+ * @return false if a file couldn't be written
+ */
+bool LogDecoder::closeWriters()
+{
+    bool ok = true;
+    foreach (const QList<ObjectWriter *> &objWriters, writers) {
+        foreach (ObjectWriter *writer, objWriters) {
+            ok &= writer->close();
+            delete writer;
+        }
+    }
+    writers.clear();
+    return ok;
+}
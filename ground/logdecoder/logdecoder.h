@@ -0,0 +1,88 @@
+/**
+ ******************************************************************************
+ *
+ * @file       logdecoder.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @brief      Decodes the UAVTalk stream of a GCS log file
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LOGDECODER_H
+#define LOGDECODER_H
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+#include "uavtalk.h"
+#include "logreader.h"
+#include "objectwriter.h"
+
+/**
+ * @brief The DecoderOptions struct What to decode and how to write it
+ */
+struct DecoderOptions {
+    DecoderOptions() : csv(false), columnar(false), from(0), to(-1) {}
+
+    bool csv;
+    bool columnar;
+    QString outputPath;     //Empty to write next to each log
+    QSet<QString> objects;  //Objects to write, all of them if empty and there are no fields
+    QHash<QString, QStringList> fields; //Fields to write of some objects
+    double from;            //Start of the time range, in s since the start of the log
+    double to;              //End of the time range, negative for the end of the log
+};
+
+/**
+ * @brief The LogDecoder class Runs the packets of a log through the UAVTalk
+ * parser and writes the object updates. Each decoder has its own objects, so
+ * several logs can be decoded at the same time on different threads.
+ */
+class LogDecoder : public UAVTalk
+{
+public:
+    LogDecoder(QIODevice *device, UAVObjectManager *objMngr, const DecoderOptions &options);
+    ~LogDecoder();
+
+    bool decode(const QString &logFile, QString *error);
+    quint32 getUpdates() const { return updates; }
+    quint32 getObjectCount() const { return objectCount; }
+
+protected:
+    bool receiveObject(quint8 type, quint32 objId, quint16 instId, quint8 *data, qint32 length);
+
+private:
+    bool isSelected(const QString &objName) const;
+    const QList<ObjectWriter *> &getWriters(UAVObject *obj);
+    bool closeWriters();
+
+    const DecoderOptions &options;
+    QString outputDir;
+    quint32 currentTimestamp;
+    quint32 updates;
+    quint32 objectCount;    //Objects that were written
+    bool writeError;
+
+    QSet<quint32> skipped;  //Objects that aren't selected
+    QHash<quint32, QList<ObjectWriter *> > writers;
+};
+
+#endif // LOGDECODER_H
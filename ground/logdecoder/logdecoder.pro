@@ -0,0 +1,54 @@
+# -------------------------------------------------
+# Decodes GCS log files without the GCS, linking the
+# UAVObjects and the UAVTalk parser of the plugins
+# -------------------------------------------------
+QT += network
+QT -= gui
+
+macx {
+    QMAKE_MACOSX_DEPLOYMENT_TARGET=10.9
+}
+
+TARGET = logdecoder
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+
+# Built into the tool rather than the plugin libraries
+DEFINES += UAVOBJECTS_LIBRARY UAVTALK_LIBRARY UAVTALK_STANDALONE
+
+GCS_PLUGINS = $$PWD/../gcs/src/plugins
+
+# The auto-generated uavobject source files, see uavobjects_dependencies.pri
+UAVOBJECT_SYNTHETICS = $$OUT_PWD/../../uavobject-synthetics/gcs
+
+INCLUDEPATH += $$GCS_PLUGINS/uavobjects \
+    $$GCS_PLUGINS/uavtalk \
+    $$GCS_PLUGINS/logging \
+    $$UAVOBJECT_SYNTHETICS
+
+SOURCES += main.cpp \
+    logdecoder.cpp \
+    objectwriter.cpp \
+    $$GCS_PLUGINS/uavobjects/uavobject.cpp \
+    $$GCS_PLUGINS/uavobjects/uavmetaobject.cpp \
+    $$GCS_PLUGINS/uavobjects/uavobjectmanager.cpp \
+    $$GCS_PLUGINS/uavobjects/uavdataobject.cpp \
+    $$GCS_PLUGINS/uavobjects/uavobjectfield.cpp \
+    $$GCS_PLUGINS/uavobjects/uavobjectfieldref.cpp \
+    $$GCS_PLUGINS/uavtalk/uavtalk.cpp \
+    $$GCS_PLUGINS/logging/logreader.cpp
+
+HEADERS += logdecoder.h \
+    objectwriter.h \
+    $$GCS_PLUGINS/uavobjects/uavobject.h \
+    $$GCS_PLUGINS/uavobjects/uavmetaobject.h \
+    $$GCS_PLUGINS/uavobjects/uavobjectmanager.h \
+    $$GCS_PLUGINS/uavobjects/uavdataobject.h \
+    $$GCS_PLUGINS/uavobjects/uavobjectfield.h \
+    $$GCS_PLUGINS/uavobjects/uavobjectfieldref.h \
+    $$GCS_PLUGINS/uavtalk/uavtalk.h \
+    $$GCS_PLUGINS/logging/logreader.h
+
+HEADERS += $$files($$UAVOBJECT_SYNTHETICS/*.h)
+SOURCES += $$files($$UAVOBJECT_SYNTHETICS/*.cpp)
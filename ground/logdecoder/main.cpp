@@ -0,0 +1,196 @@
+/**
+ ******************************************************************************
+ *
+ * @file       main.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @brief      Decodes GCS log files into a file per UAVObject
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include <QtCore/QCoreApplication>
+#include <QAtomicInt>
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QRunnable>
+#include <QStringList>
+#include <QThread>
+#include <QThreadPool>
+#include <iostream>
+
+#include "logdecoder.h"
+#include "uavobjectmanager.h"
+#include "uavobjectsinit.h"
+
+#define RETURN_ERR_USAGE 1
+#define RETURN_ERR_DECODE 2
+#define RETURN_OK 0
+
+using namespace std;
+
+static QMutex outputMutex;
+static QAtomicInt failures;
+
+/**
+ * print usage info
+ */
+void usage() {
+    cout << "Usage: logdecoder [-csv] [-columnar] [-o output_path] [-objects Obj1,Obj2] [-fields Obj.Field,...]" << endl;
+    cout << "                  [-from seconds] [-to seconds] [-j jobs] [-h] log1.tll [log2.tll] ..." << endl;
+    cout << "Formats: " << endl;
+    cout << "\t-csv           write a .csv file per UAVObject (default)" << endl;
+    cout << "\t-columnar      write a binary columnar .col file per UAVObject" << endl;
+    cout << "Filters: " << endl;
+    cout << "\t-objects       only decode these UAVObjects" << endl;
+    cout << "\t-fields        only write these fields, their objects are decoded too" << endl;
+    cout << "\t-from, -to     only decode this time range, in seconds since the start of the log" << endl;
+    cout << "Misc: " << endl;
+    cout << "\t-o             directory the output directories are created in, instead of next to each log" << endl;
+    cout << "\t-j             logs decoded at the same time, the number of cores by default" << endl;
+    cout << "\t-h             this help" << endl;
+    cout << "\tThe files of each log are written to a directory named after the log." << endl;
+    cout << "\tString fields are not written." << endl;
+}
+
+/**
+ * inform user of invalid usage
+ */
+int usage_err() {
+    cout << "Invalid usage!" << endl;
+    usage();
+    return RETURN_ERR_USAGE;
+}
+
+/**
+ * Decodes one log on a thread of the pool, with its own objects
+ */
+class DecodeTask : public QRunnable
+{
+public:
+    DecodeTask(const QString &logFile, const DecoderOptions &options) :
+        logFile(logFile), options(options) {}
+
+    void run()
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        QBuffer device;
+        UAVObjectManager objMngr;
+        UAVObjectsInitialize(&objMngr);
+
+        QString error;
+        bool ok;
+        quint32 updates;
+        quint32 objects;
+        {
+            LogDecoder decoder(&device, &objMngr, options);
+            ok = decoder.decode(logFile, &error);
+            updates = decoder.getUpdates();
+            objects = decoder.getObjectCount();
+        }
+
+        foreach (const QVector<UAVObject *> &instances, objMngr.getObjectsVector())
+            qDeleteAll(instances);
+
+        QMutexLocker locker(&outputMutex);
+        if (ok) {
+            cout << qPrintable(logFile) << ": " << updates << " updates of " << objects << " objects in "
+                 << timer.elapsed() << " ms" << endl;
+        } else {
+            cerr << qPrintable(logFile) << ": " << qPrintable(error) << endl;
+            failures.ref();
+        }
+    }
+
+private:
+    QString logFile;
+    const DecoderOptions &options;
+};
+
+/**
+ * entrance
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    DecoderOptions options;
+    QStringList logFiles;
+    int jobs = QThread::idealThreadCount();
+
+    // process arguments
+    QStringList arguments_stringlist;
+    for (int argi=1;argi<argc;argi++)
+        arguments_stringlist << argv[argi];
+
+    for (int argi=0;argi<arguments_stringlist.length();argi++) {
+        QString arg = arguments_stringlist.at(argi);
+        bool hasValue = argi + 1 < arguments_stringlist.length();
+        bool ok = true;
+
+        if (arg == "-h") {
+            usage();
+            return RETURN_OK;
+        } else if (arg == "-csv") {
+            options.csv = true;
+        } else if (arg == "-columnar") {
+            options.columnar = true;
+        } else if (arg == "-o" && hasValue) {
+            options.outputPath = arguments_stringlist.at(++argi);
+        } else if (arg == "-objects" && hasValue) {
+            foreach (const QString &name, arguments_stringlist.at(++argi).split(",", QString::SkipEmptyParts))
+                options.objects.insert(name);
+        } else if (arg == "-fields" && hasValue) {
+            foreach (const QString &name, arguments_stringlist.at(++argi).split(",", QString::SkipEmptyParts)) {
+                int dot = name.indexOf('.');
+                if (dot <= 0)
+                    return usage_err();
+                options.fields[name.left(dot)].append(name.mid(dot + 1));
+            }
+        } else if (arg == "-from" && hasValue) {
+            options.from = arguments_stringlist.at(++argi).toDouble(&ok);
+        } else if (arg == "-to" && hasValue) {
+            options.to = arguments_stringlist.at(++argi).toDouble(&ok);
+        } else if (arg == "-j" && hasValue) {
+            jobs = arguments_stringlist.at(++argi).toInt(&ok);
+            ok &= jobs > 0;
+        } else if (arg.startsWith("-")) {
+            return usage_err();
+        } else {
+            logFiles << arg;
+        }
+
+        if (!ok)
+            return usage_err();
+    }
+
+    if (logFiles.isEmpty())
+        return usage_err();
+    if (!options.csv && !options.columnar)
+        options.csv = true;
+
+    // Each log is decoded by its own task, the logs are independent
+    QThreadPool::globalInstance()->setMaxThreadCount(jobs);
+    foreach (const QString &logFile, logFiles)
+        QThreadPool::globalInstance()->start(new DecodeTask(logFile, options));
+    QThreadPool::globalInstance()->waitForDone();
+
+    return failures.load() == 0 ? RETURN_OK : RETURN_ERR_DECODE;
+}
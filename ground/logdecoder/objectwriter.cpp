@@ -0,0 +1,268 @@
+/**
+ ******************************************************************************
+ *
+ * @file       objectwriter.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @brief      Writes the decoded updates of one UAVObject to a file
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "objectwriter.h"
+#include <QtEndian>
+#include <string.h>
+
+//! Size the CSV rows are collected to before they are written
+#define CSV_BUFFER_SIZE (64 * 1024)
+
+#define COLUMNAR_MAGIC "TLCOLS01"
+
+/**
+ * @brief ObjectWriter::ObjectWriter Lays out the columns of an object
+ * @param obj Any instance of the object
+ * @param fields The fields to write, all of them if empty
+ */
+ObjectWriter::ObjectWriter(UAVObject *obj, const QStringList &fields) :
+    rows(0)
+{
+    QList<UAVObjectField *> objFields = obj->getFields();
+    for (int i = 0; i < objFields.size(); i++) {
+        UAVObjectField *field = objFields.at(i);
+        if (field->getType() == UAVObjectField::STRING)
+            continue;
+        if (!fields.isEmpty() && !fields.contains(field->getName()))
+            continue;
+
+        QStringList elementNames = field->getElementNames();
+        QList<QByteArray> options;
+        if (field->getType() == UAVObjectField::ENUM) {
+            foreach (const QString &option, field->getOptions())
+                options.append(option.toUtf8());
+        }
+
+        for (quint32 element = 0; element < field->getNumElements(); element++) {
+            Column column;
+            column.name = field->getName();
+            if (field->getNumElements() > 1)
+                column.name += "." + elementNames.at(element);
+            column.field = i;
+            column.element = element;
+            column.type = field->getType();
+            column.options = options;
+            columns.append(column);
+        }
+    }
+}
+
+/**
+ * @brief ObjectWriter::getRefs Returns the references to the columns of an instance
+ */
+const QVector<UAVObjectFieldRef> &ObjectWriter::getRefs(UAVObject *obj)
+{
+    QHash<quint32, QVector<UAVObjectFieldRef> >::iterator it = refs.find(obj->getInstID());
+    if (it != refs.end() && (it->isEmpty() || it->first().getObject() == obj))
+        return *it;
+
+    QList<UAVObjectField *> objFields = obj->getFields();
+    QVector<UAVObjectFieldRef> instanceRefs;
+    instanceRefs.reserve(columns.size());
+    foreach (const Column &column, columns)
+        instanceRefs.append(UAVObjectFieldRef(objFields.at(column.field), column.element));
+
+    return refs[obj->getInstID()] = instanceRefs;
+}
+
+
+CsvObjectWriter::CsvObjectWriter(UAVObject *obj, const QStringList &fields) :
+    ObjectWriter(obj, fields)
+{
+}
+
+/**
+ * @brief CsvObjectWriter::open Creates the file and writes the header row
+ */
+bool CsvObjectWriter::open(const QString &fileName)
+{
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    buffer.reserve(CSV_BUFFER_SIZE + 1024);
+    buffer += "timestamp,instance";
+    foreach (const Column &column, columns)
+        buffer += "," + column.name.toUtf8();
+    buffer += '\n';
+    return true;
+}
+
+void CsvObjectWriter::write(quint32 timestamp, UAVObject *obj)
+{
+    const QVector<UAVObjectFieldRef> &instanceRefs = getRefs(obj);
+
+    buffer += QByteArray::number(timestamp);
+    buffer += ',';
+    buffer += QByteArray::number(obj->getInstID());
+
+    for (int i = 0; i < columns.size(); i++) {
+        const Column &column = columns.at(i);
+        const UAVObjectFieldRef &ref = instanceRefs.at(i);
+
+        buffer += ',';
+        switch (column.type) {
+        case UAVObjectField::FLOAT32:
+            // Enough digits to read back the same float
+            buffer += QByteArray::number(ref.toDouble(), 'g', 9);
+            break;
+        case UAVObjectField::ENUM:
+        {
+            int option = ref.toOptionIndex();
+            if (option >= 0)
+                buffer += column.options.at(option);
+            break;
+        }
+        default:
+            buffer += QByteArray::number((qint64) ref.toDouble());
+            break;
+        }
+    }
+    buffer += '\n';
+    rows++;
+
+    if (buffer.size() >= CSV_BUFFER_SIZE) {
+        file.write(buffer);
+        buffer.clear();
+    }
+}
+
+bool CsvObjectWriter::close()
+{
+    bool ok = file.write(buffer) == buffer.size();
+    buffer.clear();
+    file.close();
+    return ok && file.error() == QFile::NoError;
+}
+
+
+template <typename T> static void appendValue(QByteArray &out, T value)
+{
+    T tmp = qToLittleEndian(value);
+    out.append((const char *) &tmp, sizeof(tmp));
+}
+
+static void appendString(QByteArray &out, const QByteArray &string)
+{
+    appendValue<quint16>(out, string.size());
+    out.append(string);
+}
+
+ColumnarObjectWriter::ColumnarObjectWriter(UAVObject *obj, const QStringList &fields) :
+    ObjectWriter(obj, fields),
+    data(columns.size() + 2)
+{
+}
+
+bool ColumnarObjectWriter::open(const QString &fileName)
+{
+    file.setFileName(fileName);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+}
+
+void ColumnarObjectWriter::write(quint32 timestamp, UAVObject *obj)
+{
+    const QVector<UAVObjectFieldRef> &instanceRefs = getRefs(obj);
+
+    appendValue<quint32>(data[0], timestamp);
+    appendValue<quint16>(data[1], obj->getInstID());
+
+    for (int i = 0; i < columns.size(); i++) {
+        const UAVObjectFieldRef &ref = instanceRefs.at(i);
+        QByteArray &out = data[i + 2];
+
+        // The reference reads every integer type exactly through a double
+        switch (columns.at(i).type) {
+        case UAVObjectField::INT8:
+            out.append((char) (qint8) ref.toDouble());
+            break;
+        case UAVObjectField::INT16:
+            appendValue<qint16>(out, ref.toDouble());
+            break;
+        case UAVObjectField::INT32:
+            appendValue<qint32>(out, ref.toDouble());
+            break;
+        case UAVObjectField::UINT8:
+            out.append((char) (quint8) ref.toDouble());
+            break;
+        case UAVObjectField::UINT16:
+            appendValue<quint16>(out, ref.toDouble());
+            break;
+        case UAVObjectField::UINT32:
+            appendValue<quint32>(out, ref.toDouble());
+            break;
+        case UAVObjectField::FLOAT32:
+        {
+            float value = ref.toDouble();
+            quint32 bits;
+            memcpy(&bits, &value, sizeof(bits));
+            appendValue<quint32>(out, bits);
+            break;
+        }
+        case UAVObjectField::ENUM:
+        case UAVObjectField::BITFIELD:
+            out.append((char) (quint8) ref.toOptionIndex());
+            break;
+        default:
+            break;
+        }
+    }
+    rows++;
+}
+
+/**
+ * @brief ColumnarObjectWriter::close Writes the header and the columns
+ */
+bool ColumnarObjectWriter::close()
+{
+    QByteArray header(COLUMNAR_MAGIC);
+    appendValue<quint32>(header, columns.size() + 2);
+    appendValue<quint32>(header, rows);
+
+    header.append((char) UAVObjectField::UINT32);
+    appendString(header, "timestamp");
+    appendValue<quint16>(header, 0);
+    header.append((char) UAVObjectField::UINT16);
+    appendString(header, "instance");
+    appendValue<quint16>(header, 0);
+
+    foreach (const Column &column, columns) {
+        header.append((char) column.type);
+        appendString(header, column.name.toUtf8());
+        appendValue<quint16>(header, column.options.size());
+        foreach (const QByteArray &option, column.options)
+            appendString(header, option);
+    }
+
+    bool ok = file.write(header) == header.size();
+    for (int i = 0; i < data.size() && ok; i++) {
+        ok = file.write(data.at(i)) == data.at(i).size();
+        data[i].clear();
+    }
+
+    file.close();
+    return ok && file.error() == QFile::NoError;
+}
@@ -0,0 +1,123 @@
+/**
+ ******************************************************************************
+ *
+ * @file       objectwriter.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2015
+ * @brief      Writes the decoded updates of one UAVObject to a file
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef OBJECTWRITER_H
+#define OBJECTWRITER_H
+
+#include <QFile>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+#include <QByteArray>
+
+#include "uavobject.h"
+#include "uavobjectfieldref.h"
+
+/**
+ * @brief The ObjectWriter class Base of the writers of one UAVObject. There
+ * is a column for the timestamp, one for the instance and one for each
+ * element of the selected fields. String fields are left out.
+ */
+class ObjectWriter
+{
+public:
+    ObjectWriter(UAVObject *obj, const QStringList &fields);
+    virtual ~ObjectWriter() {}
+
+    virtual bool open(const QString &fileName) = 0;
+    virtual void write(quint32 timestamp, UAVObject *obj) = 0;
+    virtual bool close() = 0;
+
+    quint32 getRows() const { return rows; }
+
+protected:
+    struct Column {
+        QString name;
+        int field;                  //Index in UAVObject::getFields
+        quint32 element;
+        UAVObjectField::FieldType type;
+        QList<QByteArray> options;  //UTF-8 names of the options of an enum
+    };
+
+    const QVector<UAVObjectFieldRef> &getRefs(UAVObject *obj);
+
+    QVector<Column> columns;
+    quint32 rows;
+
+private:
+    //! References to the columns of each instance
+    QHash<quint32, QVector<UAVObjectFieldRef> > refs;
+};
+
+
+/**
+ * @brief The CsvObjectWriter class Writes one row of comma separated values
+ * per update. Enums are written as the name of their option.
+ */
+class CsvObjectWriter : public ObjectWriter
+{
+public:
+    CsvObjectWriter(UAVObject *obj, const QStringList &fields);
+
+    bool open(const QString &fileName);
+    void write(quint32 timestamp, UAVObject *obj);
+    bool close();
+
+private:
+    QFile file;
+    QByteArray buffer;
+};
+
+
+/**
+ * @brief The ColumnarObjectWriter class Collects the values of each column and
+ * writes them one column after the other when it is closed. All values are
+ * little endian:
+ *
+ *   "TLCOLS01", quint32 number of columns, quint32 number of rows
+ *   for each column: quint8 UAVObjectField::FieldType, name, quint16 number
+ *                    of options, options
+ *   for each column: the value of each row
+ *
+ * Names and options are a quint16 length followed by UTF-8. The timestamp in
+ * ms is a UINT32 column, the instance a UINT16 column. Enums are the UINT8
+ * index of their option and bitfields are 0 or 1.
+ */
+class ColumnarObjectWriter : public ObjectWriter
+{
+public:
+    ColumnarObjectWriter(UAVObject *obj, const QStringList &fields);
+
+    bool open(const QString &fileName);
+    void write(quint32 timestamp, UAVObject *obj);
+    bool close();
+
+private:
+    QFile file;
+    QVector<QByteArray> data;   //Values of each column, the timestamp and instance first
+};
+
+#endif // OBJECTWRITER_H
@@ -44,6 +44,7 @@ UAVOBJSRCFILENAMES += gyros
 UAVOBJSRCFILENAMES += homelocation
 UAVOBJSRCFILENAMES += manualcontrolcommand
 UAVOBJSRCFILENAMES += manualcontrolsettings
+UAVOBJSRCFILENAMES += mavlinkbridgestats
 UAVOBJSRCFILENAMES += mixersettings
 UAVOBJSRCFILENAMES += mixerstatus
 UAVOBJSRCFILENAMES += mwratesettings
@@ -68,6 +69,7 @@ UAVOBJSRCFILENAMES += airspeedsettings
 UAVOBJSRCFILENAMES += altitudeholddesired
 UAVOBJSRCFILENAMES += altitudeholdsettings
 UAVOBJSRCFILENAMES += baroairspeed
+UAVOBJSRCFILENAMES += dynamicnotchstatus
 UAVOBJSRCFILENAMES += fixedwingpathfollowersettings
 UAVOBJSRCFILENAMES += flightplancontrol
 UAVOBJSRCFILENAMES += flightplansettings
@@ -83,11 +85,13 @@ UAVOBJSRCFILENAMES += magnetometer
 UAVOBJSRCFILENAMES += nedaccel
 UAVOBJSRCFILENAMES += nedposition
 UAVOBJSRCFILENAMES += pathplannersettings
+UAVOBJSRCFILENAMES += profilerprobes
 UAVOBJSRCFILENAMES += sonaraltitude
 UAVOBJSRCFILENAMES += stateestimation
+UAVOBJSRCFILENAMES += taskprofile
 UAVOBJSRCFILENAMES += velocitydesired
-UAVOBJSRCFILENAMES += vibrationanalysisoutput
 UAVOBJSRCFILENAMES += vibrationanalysissettings
+UAVOBJSRCFILENAMES += vibrationanalysisspectrum
 UAVOBJSRCFILENAMES += vtolpathfollowersettings
 UAVOBJSRCFILENAMES += vtolpathfollowerstatus
 UAVOBJSRCFILENAMES += waypoint